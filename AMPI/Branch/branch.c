@@ -111,6 +111,7 @@ FUNCTIONS CALLED:
          bail_out()
          fill_vec()
          func*()
+         prk_harness_*()
 
 HISTORY: Written by Rob Van der Wijngaart, May 2006.
   
@@ -118,6 +119,7 @@ HISTORY: Written by Rob Van der Wijngaart, May 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 /* the following values are only used as labels                                  */
 #define VECTOR_STOP       66
@@ -140,6 +142,7 @@ int main(int argc, char ** argv)
   int        rank;            /* matrix rank used in INS_HEAVY option            */
   double     branch_time,     /* timing parameters                               */
              no_branch_time;
+  prk_harness_t harness;      /* timing of the run with branches                 */
   double     ops;             /* number of integer operations in code            */
   int        iterations;      /* number of times the branching loop is executed  */
   int        i, iter, aux;    /* dummies                                         */
@@ -230,8 +233,12 @@ int main(int argc, char ** argv)
     index[i]   = i;
   }
 
+  prk_harness_init(&harness, "Branch", "AMPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "length", "%d", vector_length);
+  prk_harness_param(&harness, "branch_type", "%s", my_ID == root ? branch_type : "");
   MPI_Barrier(MPI_COMM_WORLD);   
-  branch_time = wtime();
+  prk_harness_tick(&harness);
 
   /* do actual branching */
 
@@ -292,7 +299,10 @@ int main(int argc, char ** argv)
       fill_vec(vector, vector_length, iterations, WITH_BRANCHES, &nfunc, &rank);
   }
 
-  branch_time = wtime() - branch_time;
+  /* the loops run two iterations per pass, so all iterations are recorded
+     with equal length                                                      */
+  prk_harness_ticks(&harness, iterations);
+  branch_time = prk_harness_elapsed(&harness);
 
   if (btype == INS_HEAVY && my_ID==root) {
     printf("Number of matrix functions = %d\n", nfunc);
@@ -352,10 +362,11 @@ int main(int argc, char ** argv)
   /* compute verification values                                             */
   total_ref = ((vector_length%8)*(vector_length%8-8) + vector_length)/2*Num_procs;
 
+  ops = (double)vector_length * (double)iterations * (double)Num_procs;
+  if (btype == INS_HEAVY) ops *= rank*(rank*19 + 6);
+  else                    ops *= 4;
+
   if (my_ID == root) {
-    ops = (double)vector_length * (double)iterations * (double)Num_procs;
-    if (btype == INS_HEAVY) ops *= rank*(rank*19 + 6);
-    else                    ops *= 4;
     if (total_sum == total_ref) {
       printf("Solution validates\n");
       printf("Rate (Mops/s) with branches:    %lf time (s): %lf\n", 
@@ -371,6 +382,9 @@ int main(int argc, char ** argv)
     }
   }
 
+  prk_harness_report(&harness, "Mops/s", ops/iterations*1.e-6);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 }
@@ -92,6 +92,7 @@ FUNCTIONS CALLED:
            wtime()
            bail_out()
            checkTRIADresults()
+           prk_harness_*()
  
 NOTES:     Bandwidth is determined as the number of words read, plus the 
            number of words written, times the size of the words, divided 
@@ -118,6 +119,7 @@ REVISION:  Modified by Rob Van der Wijngaart, November 2014, replaced
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
  
 #define SCALAR  3.0
  
@@ -143,6 +145,7 @@ int main(int argc, char **argv)
   double * RESTRICT a;    /* main vector                                 */
   double * RESTRICT b;    /* main vector                                 */
   double * RESTRICT c;    /* main vector                                 */
+  prk_harness_t harness;  /* per-iteration timing                        */
  
 /**********************************************************************************
 * process and test input parameters    
@@ -215,6 +218,11 @@ int main(int argc, char **argv)
     printf("Number of iterations = %d\n", iterations);
   }
 
+  prk_harness_init(&harness, "Nstream", "AMPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "length", "%ld", total_length);
+  prk_harness_param(&harness, "offset", "%ld", offset);
+
   #pragma vector always
   for (j=0; j<length; j++) {
     a[j] = 0.0;
@@ -229,10 +237,8 @@ int main(int argc, char **argv)
   for (iter=0; iter<=iterations; iter++) {
  
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_nstream_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     #pragma vector always
     for (j=0; j<length; j++) a[j] += b[j]+scalar*c[j];
@@ -243,7 +249,8 @@ int main(int argc, char **argv)
   ** Analyze and output results.
   *********************************************************************/
 
-  local_nstream_time = wtime() - local_nstream_time;
+  prk_harness_tick(&harness);
+  local_nstream_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_nstream_time, &nstream_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
@@ -256,6 +263,9 @@ int main(int argc, char **argv)
     else error = 1;
   }
   bail_out(error);
+  prk_harness_model(&harness, 2.0*length*Num_procs, bytes);
+  prk_harness_report(&harness, "MB/s", 1.0E-06 * bytes);
+  prk_harness_finalize(&harness);
   MPI_Finalize();
 }
  
@@ -55,6 +55,7 @@ FUNCTIONS CALLED:
 
          wtime();
          bail_out();
+         prk_harness_*();
 
 HISTORY: Written by Rob Van der Wijngaart, March 2006.
          Modified by Rob Van der Wijngaart, November 2014
@@ -66,6 +67,7 @@ HISTORY: Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 int main(int argc, char ** argv)
 {
@@ -80,6 +82,7 @@ int main(int argc, char ** argv)
   double local_reduce_time, /* timing parameters                             */
          reduce_time,
          avgtime;
+  prk_harness_t harness; /* per-iteration timing                              */
   double epsilon=1.e-8; /* error tolerance                                   */
   double element_value; /* verification value                                */
   int    error = 0;     /* error flag                                        */
@@ -148,13 +151,15 @@ int main(int argc, char ** argv)
     ones[i]    = (double)1;
   }
 
+  prk_harness_init(&harness, "Reduce", "AMPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "vector_length", "%ld", vector_length);
+
   for (iter=0; iter<=iterations; iter++) { 
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_reduce_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* first do the "local" part                                                */
     for (i=0; i<vector_length; i++) {
@@ -171,7 +176,8 @@ int main(int argc, char ** argv)
 
   } /* end of iterations */
 
-  local_reduce_time = wtime() - local_reduce_time;
+  prk_harness_tick(&harness);
+  local_reduce_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_reduce_time, &reduce_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
@@ -206,6 +212,9 @@ int main(int argc, char ** argv)
            1.0E-06 * (2.0*Num_procs-1.0)*vector_length/ avgtime, avgtime);
   }
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0*Num_procs-1.0)*vector_length);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 
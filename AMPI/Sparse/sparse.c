@@ -54,6 +54,7 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
          reverse()
          qsort()
          compare
@@ -69,6 +70,7 @@ HISTORY: Written by Rob Van der Wijngaart, October 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 /* linearize the grid index                                                       */
 #define LIN(i,j) (i+((j)<<lsize))
@@ -117,6 +119,7 @@ int main(int argc, char **argv){
   double            local_sparse_time,/* timing parameters                        */
                     sparse_time, 
                     avgtime;
+  prk_harness_t     harness;    /* per-iteration timing                           */
   double * RESTRICT matrix;     /* sparse matrix entries                          */
   double * RESTRICT vector;     /* vector multiplying the sparse matrix           */
   double * RESTRICT vector_local;/* part of vector filled by calling rank         */
@@ -321,13 +324,16 @@ int main(int argc, char **argv){
   /* initialize the input and result vectors                                      */
   for (row=0; row<nrows; row++) result[row] = vector_local[row] = 0.0;
 
+  prk_harness_init(&harness, "Sparse", "AMPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "log2_grid_size", "%d", lsize);
+  prk_harness_param(&harness, "radius", "%d", radius);
+
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_sparse_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* fill vector                                                                */
     row_offset = nrows*my_ID;
@@ -350,7 +356,8 @@ int main(int argc, char **argv){
     }
   } /* end of iterations                                                          */
 
-  local_sparse_time = wtime() - local_sparse_time;
+  prk_harness_tick(&harness);
+  local_sparse_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_sparse_time, &sparse_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
@@ -394,6 +401,9 @@ int main(int argc, char **argv){
 
   bail_out(error);
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0*nent*Num_procs));
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 }
@@ -43,6 +43,13 @@ USAGE:   The program takes as input the linear dimension of the grid,
  
                <progname> <# iterations> <grid size>
   
+         The number of virtual ranks and of processing elements (PEs) are
+         set at launch, e.g. charmrun +p4 ./stencil +vp64 ... With
+         PRK_MIGRATE=<k> in the environment the ranks call AMPI_Migrate
+         every k iterations, so that the load balancer chosen with
+         +balancer can move them between PEs (see prk_ampi.h); the number
+         of ranks moved and the time spent in AMPI_Migrate are reported.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
  
@@ -53,6 +60,8 @@ FUNCTIONS CALLED:
  
          wtime()
          bail_out()
+         prk_harness_*()
+         prk_ampi_migrate()
  
 HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, August 2013: Removed unrolling pragmas for clarity;
@@ -70,6 +79,8 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+#include <prk_ampi.h>
  
 #if DOUBLE
   #define DTYPE     double
@@ -125,6 +136,7 @@ int main(int argc, char ** argv) {
   DTYPE  f_active_points; /* interior of grid with respect to stencil            */
   DTYPE  flops;           /* floating point ops per iteration                    */
   int    iterations;      /* number of times to run the algorithm                */
+  prk_harness_t harness;  /* per-iteration timing                                */
   double local_stencil_time,/* timing parameters                                 */
          stencil_time,
          avgtime; 
@@ -137,6 +149,11 @@ int main(int argc, char ** argv) {
   DTYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
   MPI_Request request[8];
   MPI_Status  status[8];
+  int    migrate_period;  /* iterations between load balancing steps, 0 if none */
+  int    moved=0,         /* number of times the calling rank changed PE        */
+         total_moved;     /* total number of rank moves                         */
+  double migrate_time=0.0,/* time spent in load balancing steps                 */
+         max_migrate_time;
  
   /*******************************************************************************
   ** Initialize the MPI environment
@@ -193,6 +210,13 @@ int main(int argc, char ** argv) {
       goto ENDOFTESTS;  
     }
  
+    migrate_period = prk_ampi_migrate_period();
+    if (migrate_period < 0) {
+      printf("ERROR: PRK_MIGRATE must be a non-negative number of iterations\n");
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+ 
     ENDOFTESTS:;  
   }
   bail_out(error);
@@ -216,6 +240,11 @@ int main(int argc, char ** argv) {
  
   if (my_ID == root) {
     printf("Number of ranks        = %d\n", Num_procs);
+    printf("Number of PEs          = %d\n", prk_ampi_num_pes());
+    if (migrate_period)
+    printf("Load balancing every   = %d iterations\n", migrate_period);
+    else
+    printf("Load balancing         = none\n");
     printf("Grid size              = %d\n", n);
     printf("Radius of stencil      = %d\n", RADIUS);
     printf("Tiles in x/y-direction = %d/%d\n", Num_procsx, Num_procsy);
@@ -235,6 +264,7 @@ int main(int argc, char ** argv) {
  
   MPI_Bcast(&n,          1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&migrate_period, 1, MPI_INT, root, MPI_COMM_WORLD);
  
   /* compute amount of space required for input and solution arrays             */
   
@@ -334,13 +364,17 @@ int main(int argc, char ** argv) {
     left_buf_in    = right_buf_out + 3*RADIUS*height;
   }
 
+  prk_harness_init(&harness, "Stencil", "AMPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%d", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "migrate", "%d", migrate_period);
+
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_stencil_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
  
     /* need to fetch ghost point data from neighbors in y-direction                 */
     if (my_IDy < Num_procsy-1) {
@@ -426,11 +460,19 @@ int main(int argc, char ** argv) {
     /* add constant to solution to force refresh of neighbor data, if any */
     for (j=jstart; j<=jend; j++) for (i=istart; i<=iend; i++) IN(i,j)+= 1.0;
  
+    /* let the load balancer move ranks between PEs                        */
+    if (migrate_period && iter<iterations && (iter+1)%migrate_period == 0)
+      prk_ampi_migrate(&moved, &migrate_time);
+
   } /* end of iterations                                                   */
 
-  local_stencil_time = wtime() - local_stencil_time;
+  prk_harness_tick(&harness);
+  local_stencil_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_stencil_time, &stencil_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
+  MPI_Reduce(&moved, &total_moved, 1, MPI_INT, MPI_SUM, root, MPI_COMM_WORLD);
+  MPI_Reduce(&migrate_time, &max_migrate_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
   
   /* compute L1 norm in parallel                                                */
   local_norm = (DTYPE) 0.0;
@@ -470,14 +512,20 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
   if (my_ID == root) {
-    /* flops/stencil: 2 flops (fma) for each point in the stencil, 
-       plus one flop for the update of the input of the array        */
-    flops = (DTYPE) (2*stencil_size+1) * f_active_points;
     avgtime = stencil_time/iterations;
     printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
            1.0E-06 * flops/avgtime, avgtime);
+    if (migrate_period)
+      printf("Ranks moved: %d  Load balancing time (s): %lf\n",
+             total_moved, max_migrate_time);
   }
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
  
   MPI_Finalize();
   exit(EXIT_SUCCESS);
@@ -55,6 +55,7 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
          chartoi()
 
 HISTORY: Written by Rob Van der Wijngaart, December 2005.
@@ -63,6 +64,7 @@ HISTORY: Written by Rob Van der Wijngaart, December 2005.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 #define EOS '\0'
 
@@ -90,6 +92,7 @@ int main(int argc, char ** argv)
   int    basesum;     /* checksum of base string                                 */
   MPI_Datatype mpi_word; /* chunk of scramble string to be communicated          */
   double stopngo_time;/* timing parameter                                        */
+  prk_harness_t harness; /* per-iteration timing                                 */
   int    Num_procs;   /* Number of ranks                                         */
   int    error = 0;   /* error flag                                              */
 
@@ -191,8 +194,13 @@ int main(int argc, char ** argv)
   MPI_Type_contiguous(proc_length,MPI_CHAR, &mpi_word);
   MPI_Type_commit(&mpi_word);
 
+  prk_harness_init(&harness, "Synch_global", "AMPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "length", "%ld", length);
+
+  /* there is no warmup iteration, so every iteration is timed           */
   MPI_Barrier(MPI_COMM_WORLD);
-  stopngo_time = wtime();
+  prk_harness_tick(&harness);
 
   for (iter=0; iter<iterations; iter++) { 
 
@@ -210,9 +218,10 @@ int main(int argc, char ** argv)
              iter, catstring, checksum);
     }
 #endif
+    prk_harness_tick(&harness);
   }
 
-  stopngo_time = wtime() - stopngo_time;
+  stopngo_time = prk_harness_elapsed(&harness);
 
   /* compute checksum on obtained result, adding all digits in the string */
   if (my_ID==0) {
@@ -230,6 +239,9 @@ int main(int argc, char ** argv)
            (iterations/stopngo_time), stopngo_time);
   }
 
+  prk_harness_report(&harness, "synch/s", 1.0);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
 
 
@@ -0,0 +1,245 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/*-----------------------------------------------------------------------*/
+/* Copyright 1991-2013: John D. McCalpin                                 */
+/*-----------------------------------------------------------------------*/
+/* License:                                                              */
+/*  1. You are free to use this program and/or to redistribute           */
+/*     this program.                                                     */
+/*  2. You are free to modify this program for your own use,             */
+/*     including commercial use, subject to the publication              */
+/*     restrictions in item 3.                                           */
+/*  3. You are free to publish results obtained from running this        */
+/*     program, or from works that you derive from this program,         */
+/*     with the following limitations:                                   */
+/*     3a. In order to be referred to as "STREAM benchmark results",     */
+/*         published results must be in conformance to the STREAM        */
+/*         Run Rules, (briefly reviewed below) published at              */
+/*         http://www.cs.virginia.edu/stream/ref.html                    */
+/*         and incorporated herein by reference.                         */
+/*         As the copyright holder, John McCalpin retains the            */
+/*         right to determine conformity with the Run Rules.             */
+/*     3b. Results based on modified source code or on runs not in       */
+/*         accordance with the STREAM Run Rules must be clearly          */
+/*         labelled whenever they are published.  Examples of            */
+/*         proper labelling include:                                     */
+/*           "tuned STREAM benchmark results"                            */
+/*           "based on a variant of the STREAM benchmark code"           */
+/*         Other comparable, clear, and reasonable labelling is          */
+/*         acceptable.                                                   */
+/*     3c. Submission of results to the STREAM benchmark web site        */
+/*         is encouraged, but not required.                              */
+/*  4. Use of this program or creation of derived works based on this    */
+/*     program constitutes acceptance of these licensing restrictions.   */
+/*  5. Absolutely no warranty is expressed or implied.                   */
+/*-----------------------------------------------------------------------*/
+
+/**********************************************************************
+ 
+NAME:      nstream
+ 
+PURPOSE:   To compute memory bandwidth when adding a vector of a given
+           number of double precision values to the scalar multiple of
+           another vector of the same length, and storing the result in
+           a third vector, with the C++17 parallel algorithms.
+ 
+USAGE:     The program takes as input the number of threads, the number
+           of iterations to loop over the triad vectors, the length of
+           the vectors, and the offset between vectors
+ 
+           <progname> <# threads> <# iterations> <vector length> <offset>
+ 
+           The output consists of diagnostics to make sure the 
+           algorithm worked, and of timing statistics.
+
+           The arguments and the verification are those of OPENMP/Nstream,
+           so that the rates can be compared directly. Every iteration is
+           one std::for_each with the par_unseq policy over the vector
+           indices. The number of threads caps the TBB backend and is
+           advisory with others (see prk_pstl.h).
+ 
+FUNCTIONS CALLED:
+ 
+           Other than standard C and C++ functions, the following 
+           external functions are used in this program:
+ 
+           wtime()
+ 
+NOTES:     Bandwidth is determined as the number of words read, plus the 
+           number of words written, times the size of the words, divided 
+           by the execution time. For a vector length of N, the total 
+           number of words read and written is 4*N*sizeof(double).
+ 
+HISTORY:   Derived from OPENMP/Nstream, October 2026, which is loosely
+           based on the Stream benchmark by John McCalpin, but does not
+           follow all the Stream rules. Hence, reported results should
+           not be associated with Stream in external publications
+**********************************************************************/
+ 
+#include <par-res-kern_general.h>
+#include <prk_pstl.h>
+ 
+#define SCALAR  3.0
+#define A0      1.0
+#define B0      2.0
+#define C0      2.0
+ 
+int main(int argc, char **argv) 
+{
+  int      nthread_input; /* thread parameters                           */
+  int      iterations;    /* number of times vector loop gets repeated   */
+  long int length,        /* total vector length                         */
+           offset;        /* offset between vectors a and b, and b and c */
+  long int iter;          /* dummy                                       */
+  double   bytes;         /* memory IO size                              */
+  size_t   space;         /* memory used for the vectors                 */
+  double   nstream_time,  /* timing parameters                           */
+           avgtime;
+  double   scalar;        /* constant used in Triad operation            */
+  double   aj, bj, cj, asum; /* verification values                      */
+  double   epsilon = 1.e-8;
+  double   * a, * b, * c; /* the vectors                                 */
+ 
+/**********************************************************************************
+* process and test input parameters    
+***********************************************************************************/
+ 
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("C++17 parallel algorithms stream triad: A = B + scalar*C\n");
+
+  if (argc != 5){
+     printf("Usage:  %s <# threads> <# iterations> <vector length> <offset>\n", *argv);
+     exit(EXIT_FAILURE);
+  }
+ 
+  nthread_input = atoi(*++argv);
+  iterations    = atoi(*++argv);
+  length        = atol(*++argv);
+  offset        = atol(*++argv);
+
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  if ((iterations < 1)) {
+    printf("ERROR: Invalid number of iterations: %d\n", iterations);
+    exit(EXIT_FAILURE);
+  }
+ 
+  if (length < 0) {
+    printf("ERROR: Invalid vector length: %ld\n", length);
+    exit(EXIT_FAILURE);
+  }
+
+  if (offset < 0) {
+    printf("ERROR: Invalid array offset: %ld\n", offset);
+    exit(EXIT_FAILURE);
+  }
+
+  prk_pstl_threads threads(nthread_input);
+
+  space = (3*length + 2*offset)*sizeof(double);
+  a = (double *) prk_malloc(space);
+  if (!a) {
+    printf("ERROR: Could not allocate %ld words for vectors\n", 
+           3*length+2*offset);
+    exit(EXIT_FAILURE);
+  }
+  b = a + length + offset;
+  c = b + length + offset;
+
+  printf("Number of threads    = %d (%s)\n", nthread_input,
+         threads.honored() ? PRK_PSTL_BACKEND : "advisory");
+  printf("Vector length        = %ld\n", length);
+  printf("Offset               = %ld\n", offset);
+  printf("Number of iterations = %d\n", iterations);
+
+  prk_range indices(0, length);
+
+  /* initialize in parallel, so that the pages are placed where they are used */
+  std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
+                [=](long j) {
+    a[j] = A0;
+    b[j] = B0;
+    c[j] = C0;
+  });
+    
+  /* --- MAIN LOOP --- repeat Triad iterations times --- */
+ 
+  scalar = SCALAR;
+ 
+  for (iter=0; iter<=iterations; iter++) {
+ 
+    /* start timer after a warmup iteration */
+    if (iter==1) nstream_time = wtime();
+ 
+    std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
+                  [=](long j) { a[j] += b[j]+scalar*c[j]; });
+ 
+  } /* end of iterations                                              */
+
+  nstream_time = wtime() - nstream_time;
+ 
+  /*********************************************************************
+  ** Analyze and output results.
+  *********************************************************************/
+ 
+  /* reproduce initialization and timing loop */
+  aj = A0;
+  bj = B0;
+  cj = C0;
+  for (iter=0; iter<=iterations; iter++) aj += bj+scalar*cj;
+  aj = aj * (double) (length);
+ 
+  asum = std::reduce(std::execution::par_unseq, a, a+length, 0.0);
+ 
+#if VERBOSE
+  printf ("Results Comparison: \n");
+  printf ("        Expected checksum: %f\n",aj);
+  printf ("        Observed checksum: %f\n",asum);
+#endif
+ 
+  if (ABS(aj-asum)/asum > epsilon) {
+    printf ("Failed Validation on output array\n");
+    exit(EXIT_FAILURE);
+  }
+  printf ("Solution validates\n");
+
+  bytes   = 4.0 * sizeof(double) * length;
+  avgtime = nstream_time/iterations;
+  printf("Rate (MB/s): %lf Avg time (s): %lf\n",
+         1.0E-06 * bytes/avgtime, avgtime);
+ 
+  return 0;
+}
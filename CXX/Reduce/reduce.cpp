@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    reduce
+
+PURPOSE: This program tests the efficiency with which a collection of 
+         vectors can be added in elementwise fashion with the C++17
+         parallel algorithms. There are two vectors per thread, so that
+         a reduction will take place even if the code runs on just a
+         single thread.
+  
+USAGE:   The program takes as input the number of threads, the number of
+         times the reduction is repeated, and the length of the vectors.
+
+         <progname>  <# threads> <# iterations> <vector length>
+  
+         The vectors and the verification are those of OPENMP/Reduce,
+         but there is no choice of algorithm: every iteration is one
+         std::for_each with the par_unseq policy over the vector
+         elements, each of which sums its column of all vectors into
+         the first one. This is the access pattern of the OpenMP
+         rabenseifner algorithm, with the partitioning left to the
+         library. The number of threads caps the TBB backend and is
+         advisory with others (see prk_pstl.h).
+
+         The output consists of diagnostics to make sure the 
+         algorithm worked, and of timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than standard C and C++ functions, the following 
+         functions are used in this program:
+
+         wtime()
+
+HISTORY: Derived from OPENMP/Reduce, October 2026.
+  
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_pstl.h>
+
+#define VEC0(id,i)        vector[(id        )*(vector_length)+i]
+#define VEC1(id,i)        vector[(id+nthread)*(vector_length)+i]
+
+int main(int argc, char ** argv)
+{
+  long   vector_length;   /* length of vectors to be aggregated              */
+  long   total_length;    /* bytes needed to store reduction vectors         */
+  double reduce_time,     /* timing parameters                               */
+         avgtime;
+  double epsilon=1.e-8;   /* error tolerance                                 */
+  long   i;               /* dummy                                           */
+  int    iter;            /* dummy                                           */
+  double element_value;   /* reference element value for final vector        */
+  int    iterations;      /* number of times the reduction is carried out    */
+  int    nthread;         /* number of threads                               */
+  double *vector;         /* vectors to be reduced                           */
+
+/*****************************************************************************
+** process and test input parameters    
+******************************************************************************/
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("C++17 parallel algorithms Vector Reduction\n");
+
+  if (argc != 4){
+    printf("Usage:     %s <# threads> <# iterations> <vector length>\n", *argv);
+    return(EXIT_FAILURE);
+  }
+
+  nthread = atoi(*++argv); 
+  if ((nthread < 1) || (nthread > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread);
+    exit(EXIT_FAILURE);
+  }
+
+  iterations = atoi(*++argv);
+  if (iterations < 1){
+    printf("ERROR: Iterations must be positive : %d \n", iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  vector_length  = atol(*++argv);
+  if (vector_length < 1){
+    printf("ERROR: vector length must be >= 1 : %ld \n",vector_length);
+    exit(EXIT_FAILURE);
+  }
+
+  prk_pstl_threads threads(nthread);
+
+  total_length = vector_length*2*nthread*sizeof(double);
+  vector = (double *) prk_malloc(total_length);
+  if (!vector) {
+    printf("ERROR: Could not allocate space for vectors: %ld\n", total_length);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("Number of threads              = %d (%s)\n", nthread,
+         threads.honored() ? PRK_PSTL_BACKEND : "advisory");
+  printf("Vector length                  = %ld\n", vector_length);
+  printf("Number of iterations           = %d\n", iterations);
+
+  prk_range elements(0, vector_length);
+
+  reduce_time = 0.0; /* silence compiler warning */
+
+  for (iter=0; iter<=iterations; iter++) {
+
+    /* start timer after a warmup iteration                                  */
+    if (iter == 1) reduce_time = wtime();
+
+    /* initialize the arrays; as in OPENMP/Reduce this is part of the timing */
+    std::for_each(std::execution::par_unseq, elements.begin(), elements.end(),
+                  [=](long i) {
+      for (int id=0; id<nthread; id++) {
+        VEC0(id,i) = (double)(id+1);
+        VEC1(id,i) = (double)(id+1+nthread);
+      }
+    });
+
+    /* do actual reduction                                                   */
+    std::for_each(std::execution::par_unseq, elements.begin(), elements.end(),
+                  [=](long i) {
+      double sum = VEC1(0,i);
+      for (int id=1; id<nthread; id++) sum += VEC0(id,i) + VEC1(id,i);
+      VEC0(0,i) += sum;
+    });
+  }
+
+  reduce_time = wtime() - reduce_time;
+
+  /* verify correctness */
+  element_value = (double)nthread*(2.0*(double)nthread+1.0);
+
+  for (i=0; i<vector_length; i++) {
+    if (ABS(VEC0(0,i) - element_value) >= epsilon) {
+       printf("First error at i=%ld; value: %lf; reference value: %lf\n",
+              i, VEC0(0,i), element_value);
+       exit(EXIT_FAILURE);
+    }
+  }
+
+  printf("Solution validates\n");
+#if VERBOSE
+  printf("Element verification value: %lf\n", element_value);
+#endif
+  avgtime = reduce_time/iterations;
+  printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
+         1.0E-06 * (2.0*nthread-1.0)*vector_length/avgtime, avgtime);
+
+  exit(EXIT_SUCCESS);
+}
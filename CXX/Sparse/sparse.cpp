@@ -0,0 +1,297 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*********************************************************************************
+
+NAME:    sparse
+
+PURPOSE: This program tests the efficiency with which a sparse matrix
+         vector multiplication is carried out with the C++17 parallel
+         algorithms.
+  
+USAGE:   The program takes as input the number of threads, the number of
+         times the matrix-vector multiplication is carried out, the 2log
+         of the linear size of the 2D grid (equalling the 2log of the
+         square root of the order of the sparse matrix), and the radius
+         of the difference stencil.
+
+         <progname> <# threads> <# iterations> <2log root-of-matrix-order> <radius> 
+  
+         The arguments and the verification are those of OPENMP/Sparse,
+         so that the rates can be compared directly. The matrix is in
+         compressed row storage; the update of the vector and the
+         multiplication are each one std::for_each with the par_unseq
+         policy over the rows. The number of threads caps the TBB
+         backend and is advisory with others (see prk_pstl.h).
+
+         The output consists of diagnostics to make sure the 
+         algorithm worked, and of timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than standard C and C++ functions, the following 
+         functions are used in this program:
+
+         wtime()
+         reverse()
+
+HISTORY: Derived from OPENMP/Sparse, October 2026.
+  
+***********************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_pstl.h>
+
+/* linearize the grid index                                                       */
+#define LIN(i,j) (i+((j)<<lsize))
+
+/* if the scramble flag is set, convert all (linearized) grid indices by 
+   reversing their bits; if not, leave the grid indices alone                     */
+#if SCRAMBLE
+  #define REVERSE(a,b)  reverse((a),(b))
+#else
+  #define REVERSE(a,b) (a)
+#endif
+
+#define BITS_IN_BYTE 8
+
+static u64Int reverse(u64Int, int);
+
+int main(int argc, char **argv){
+
+  int               iter;       /* dummy                                          */
+  s64Int            lsize;      /* logarithmic linear size of grid                */
+  s64Int            lsize2;     /* logarithmic size of grid                       */
+  s64Int            size;       /* linear size of grid                            */
+  s64Int            size2;      /* matrix order (=total # points in grid)         */
+  s64Int            radius,     /* stencil parameters                             */
+                    stencil_size; 
+  int               nthread_input; /* thread parameters                           */
+  int               iterations; /* number of times the multiplication is done     */
+  s64Int            nent;       /* number of nonzero entries                      */
+  double            sparsity;   /* fraction of non-zeroes in matrix               */
+  double            sparse_time,/* timing parameters                              */
+                    avgtime; 
+  double *          matrix;     /* sparse matrix entries                          */
+  double *          vector;     /* vector multiplying the sparse matrix           */
+  double *          result;     /* computed matrix-vector product                 */
+  double            vector_sum; /* checksum of result                             */
+  double            reference_sum; /* checksum of "rhs"                           */
+  double            epsilon = 1.e-8; /* error tolerance                           */
+  s64Int *          colIndex;   /* column indices of sparse matrix entries        */
+  size_t            vector_space, /* variables used to hold prk_malloc sizes      */
+                    matrix_space,
+                    index_space;
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("C++17 parallel algorithms Sparse matrix-vector multiplication\n");
+
+  if (argc != 5) {
+    printf("Usage: %s <# threads> <# iterations> <2log grid size> <stencil radius>\n",*argv);
+    exit(EXIT_FAILURE);
+  }
+
+  nthread_input = atoi(*++argv); 
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  iterations = atoi(*++argv);
+  if (iterations < 1){
+    printf("ERROR: Iterations must be positive : %d \n", iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  lsize = atol(*++argv);
+  lsize2 = 2*lsize;
+  size = 1L<<lsize;
+  if (lsize <0) {
+    printf("ERROR: Log of grid size must be greater than or equal to zero: %d\n", 
+           (int) lsize);
+    exit(EXIT_FAILURE);
+  }
+  /* compute number of points in the grid                                         */
+  size2 = size*size;
+
+  radius = atoi(*++argv);
+  if (radius <0) {
+    printf("ERROR: Stencil radius must be non-negative: %d\n", (int) size);
+    exit(EXIT_FAILURE);
+  }
+
+  /* emit error if (periodic) stencil overlaps with itself                        */
+  if (size <2*radius+1) {
+    printf("ERROR: Grid extent %lld smaller than stencil diameter 2*%lld+1= %lld\n",
+           size, radius, radius*2+1);
+    exit(EXIT_FAILURE);
+  }
+
+  prk_pstl_threads threads(nthread_input);
+ 
+  /* compute total size of star stencil in 2D                                     */
+  stencil_size = 4*radius+1;
+  /* sparsity follows from number of non-zeroes per row                           */
+  sparsity = (double)(4*radius+1)/(double)size2;
+
+  /* compute total number of non-zeroes                                           */
+  nent = size2*stencil_size;
+
+  matrix_space = nent*sizeof(double);
+  matrix = (double *) prk_malloc(matrix_space);
+  if (!matrix) {
+    printf("ERROR: Could not allocate space for sparse matrix: %lld\n", nent);
+    exit(EXIT_FAILURE);
+  } 
+
+  vector_space = 2*size2*sizeof(double);
+  if (vector_space/sizeof(double) != (size_t)2*size2) {
+    printf("ERROR: Cannot represent space for vectors: %lu\n", vector_space);
+    exit(EXIT_FAILURE);
+  } 
+
+  vector = (double *) prk_malloc(vector_space);
+  if (!vector) {
+    printf("ERROR: Could not allocate space for vectors: %d\n", (int)(2*size2));
+    exit(EXIT_FAILURE);
+  }
+  result = vector + size2;
+
+  index_space = nent*sizeof(s64Int);
+  if (index_space/sizeof(s64Int) != (size_t)nent) {
+    printf("ERROR: Cannot represent space for column indices: %lu\n", index_space);
+    exit(EXIT_FAILURE);
+  } 
+  colIndex = (s64Int *) prk_malloc(index_space);
+  if (!colIndex) {
+    printf("ERROR: Could not allocate space for column indices: " FSTR64U "\n",
+           nent*sizeof(s64Int));
+    exit(EXIT_FAILURE);
+  } 
+
+  printf("Number of threads     = %16d (%s)\n", nthread_input,
+         threads.honored() ? PRK_PSTL_BACKEND : "advisory");
+  printf("Matrix order          = " FSTR64U "\n", size2);
+  printf("Stencil diameter      = %16lld\n", 2*radius+1);
+  printf("Sparsity              = %16.10lf\n", sparsity);
+  printf("Number of iterations  = %16d\n", iterations);
+#if SCRAMBLE
+  printf("Using scrambled indexing\n");
+#else
+  printf("Using canonical indexing\n");
+#endif
+
+  prk_range rows(0, size2);
+
+  /* initialize the input and result vectors, and fill matrix with nonzeroes
+     corresponding to difference stencil. We use the scrambling for reordering
+     the points in the grid.                                                      */
+
+  std::for_each(std::execution::par_unseq, rows.begin(), rows.end(), [=](s64Int row) {
+    s64Int i = row%size, j = row/size, elm = row*stencil_size;
+
+    result[row] = vector[row] = 0.0;
+    colIndex[elm] = REVERSE(LIN(i,j),lsize2);
+    for (s64Int r=1; r<=radius; r++, elm+=4) {
+      colIndex[elm+1] = REVERSE(LIN((i+r)%size,j),lsize2);
+      colIndex[elm+2] = REVERSE(LIN((i-r+size)%size,j),lsize2);
+      colIndex[elm+3] = REVERSE(LIN(i,(j+r)%size),lsize2);
+      colIndex[elm+4] = REVERSE(LIN(i,(j-r+size)%size),lsize2);
+    }
+    /* sort colIndex to make sure the compressed row accesses
+       vector elements in increasing order                                        */
+    std::sort(&colIndex[row*stencil_size], &colIndex[(row+1)*stencil_size]);
+    for (elm=row*stencil_size; elm<(row+1)*stencil_size; elm++)
+      matrix[elm] = 1.0/(double)(colIndex[elm]+1);
+  });
+
+  sparse_time = 0.0; /* silence compiler warning */
+
+  for (iter=0; iter<=iterations; iter++) {
+
+    if (iter==1) sparse_time = wtime();
+
+    /* fill vector                                                                */
+    std::for_each(std::execution::par_unseq, rows.begin(), rows.end(),
+                  [=](s64Int row) { vector[row] += (double) (row+1); });
+
+    /* do the actual matrix-vector multiplication                                 */
+    std::for_each(std::execution::par_unseq, rows.begin(), rows.end(), [=](s64Int row) {
+      double temp = 0.0;
+      for (s64Int col=stencil_size*row; col<stencil_size*(row+1); col++)
+        temp += matrix[col]*vector[colIndex[col]];
+      result[row] += temp;
+    });
+  } /* end of iterations                                                          */
+
+  sparse_time = wtime()-sparse_time;
+
+  /* verification test                                                            */
+  reference_sum = 0.5 * (double) nent * (double) (iterations+1) * 
+                        (double) (iterations +2);
+
+  vector_sum = std::reduce(std::execution::par_unseq, result, result+size2, 0.0);
+  if (ABS(vector_sum-reference_sum) > epsilon) {
+    printf("ERROR: Vector sum = %lf, Reference vector sum = %lf\n",
+           vector_sum, reference_sum);
+    exit(EXIT_FAILURE);
+  }
+  else {
+    printf("Solution validates\n");
+#if VERBOSE
+    printf("Reference sum = %lf, vector sum = %lf\n", 
+           reference_sum, vector_sum);
+#endif
+  }
+
+  avgtime = sparse_time/iterations;
+  printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
+         1.0E-06 * (2.0*nent)/avgtime, avgtime);
+
+  exit(EXIT_SUCCESS);
+}
+
+/* Code below reverses bits in unsigned integer stored in a 64-bit word.
+   Bit reversal is with respect to the largest integer that is going to be
+   processed for the particular run of the code, to make sure the reversal
+   constitutes a true permutation. Hence, the final result needs to be shifted 
+   to the right.                                                                  */
+u64Int reverse(u64Int x, int shift_in_bits){ 
+  x = ((x >> 1)  & 0x5555555555555555) | ((x << 1)  & 0xaaaaaaaaaaaaaaaa);
+  x = ((x >> 2)  & 0x3333333333333333) | ((x << 2)  & 0xcccccccccccccccc);
+  x = ((x >> 4)  & 0x0f0f0f0f0f0f0f0f) | ((x << 4)  & 0xf0f0f0f0f0f0f0f0);
+  x = ((x >> 8)  & 0x00ff00ff00ff00ff) | ((x << 8)  & 0xff00ff00ff00ff00);
+  x = ((x >> 16) & 0x0000ffff0000ffff) | ((x << 16) & 0xffff0000ffff0000);
+  x = ((x >> 32) & 0x00000000ffffffff) | ((x << 32) & 0xffffffff00000000);
+  return (x>>((sizeof(u64Int)*BITS_IN_BYTE-shift_in_bits)));
+}
@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    Stencil
+
+PURPOSE: This program tests the efficiency with which a space-invariant,
+         linear, symmetric filter (stencil) can be applied to a square
+         grid or image with the C++17 parallel algorithms.
+  
+USAGE:   The program takes as input the number of threads, the linear
+         dimension of the grid, and the number of iterations on the grid,
+         optionally followed by the radius and shape of the stencil
+
+               <progname> <# threads> <iterations> <grid size> [<radius> [star|compact]]
+
+         The arguments and the verification are those of OPENMP/Stencil,
+         so that the rates can be compared directly. The stencil and the
+         update of the input grid are each one std::for_each with the
+         par_unseq policy over the rows of the grid; rows are done by
+         the same vectorized row kernels as in OpenMP, if the CPU has
+         them (see prk_stencil_simd.h). The number of threads caps the
+         TBB backend and is advisory with others (see prk_pstl.h).
+  
+         The output consists of diagnostics to make sure the 
+         algorithm worked, and of timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than standard C and C++ functions, the following 
+         functions are used in this program:
+
+         wtime()
+         prk_stencil_simd*() vectorized row kernels
+         star_row()
+         compact_row()
+
+HISTORY: Derived from OPENMP/Stencil, October 2026.
+  
+**********************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_pstl.h>
+#include <prk_stencil_simd.h>
+
+#if DOUBLE
+  #define DTYPE   double
+  #define EPSILON 1.e-8
+  #define COEFX   1.0
+  #define COEFY   1.0
+  #define FSTR    "%lf"
+  #define prk_stencil_simd_dtype prk_stencil_simd_double
+#else
+  #define DTYPE   float
+  #define EPSILON 0.0001f
+  #define COEFX   1.0f
+  #define COEFY   1.0f
+  #define FSTR    "%f"
+  #define prk_stencil_simd_dtype prk_stencil_simd_float
+#endif
+
+/* define shorthand for indexing a multi-dimensional array                       */
+#define IN(i,j)       in[i+(j)*(n)]
+#define OUT(i,j)      out[i+(j)*(n)]
+#define WEIGHT(ii,jj) weight[(ii+radius)*(2*radius+1)+jj+radius]
+
+/* a row kernel applies the stencil to the interior points of row j           */
+typedef void (*stencil_row_t)(long, long, int, const DTYPE *, const DTYPE *, DTYPE *);
+
+static void star_row(long n, long j, int radius, const DTYPE * weight,
+                     const DTYPE * in, DTYPE * out) {
+  for (long i=radius; i<n-radius; i++) {
+    DTYPE sum = OUT(i,j);
+    for (int jj=-radius; jj<=radius; jj++) sum += WEIGHT(0,jj)*IN(i,j+jj);
+    for (int ii=-radius; ii<0; ii++)       sum += WEIGHT(ii,0)*IN(i+ii,j);
+    for (int ii=1; ii<=radius; ii++)       sum += WEIGHT(ii,0)*IN(i+ii,j);
+    OUT(i,j) = sum;
+  }
+}
+
+static void compact_row(long n, long j, int radius, const DTYPE * weight,
+                        const DTYPE * in, DTYPE * out) {
+  for (long i=radius; i<n-radius; i++) {
+    DTYPE sum = OUT(i,j);
+    for (int jj=-radius; jj<=radius; jj++)
+    for (int ii=-radius; ii<=radius; ii++) sum += WEIGHT(ii,jj)*IN(i+ii,j+jj);
+    OUT(i,j) = sum;
+  }
+}
+
+int main(int argc, char ** argv) {
+
+  long   n;               /* linear grid dimension                               */
+  int    radius;          /* radius of the stencil                               */
+  int    star;            /* boolean: star or compact stencil                    */
+  int    ii, jj, iter;    /* dummies                                             */
+  DTYPE  norm,            /* L1 norm of solution                                 */
+         reference_norm;
+  DTYPE  f_active_points; /* interior of grid with respect to stencil            */
+  DTYPE  flops;           /* floating point ops per iteration                    */
+  int    nthread_input;   /* thread parameters                                   */
+  int    iterations;      /* number of times to run the algorithm                */
+  double stencil_time,    /* timing parameters                                   */
+         avgtime;
+  int    stencil_size;    /* number of points in stencil                         */
+  DTYPE  * in;            /* input grid values                                   */
+  DTYPE  * out;           /* output grid values                                  */
+  long   total_length;    /* total required length to store grid values          */
+  DTYPE  * weight;        /* weights of points in the stencil                    */
+  stencil_row_t row;      /* row kernel                                          */
+  const char * simd;      /* instruction set of the row kernel                   */
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("C++17 parallel algorithms stencil execution on 2D grid\n");
+
+  /*******************************************************************************
+  ** process and test input parameters    
+  ********************************************************************************/
+
+  if (argc < 4 || argc > 6){
+    printf("Usage: %s <# threads> <# iterations> <array dimension> "
+           "[<radius> [star|compact]]\n", *argv);
+    return(EXIT_FAILURE);
+  }
+
+  nthread_input = atoi(*++argv); 
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  iterations  = atoi(*++argv); 
+  if (iterations < 1){
+    printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  n  = atol(*++argv);
+  if (n < 1){
+    printf("ERROR: grid dimension must be positive: %ld\n", n);
+    exit(EXIT_FAILURE);
+  }
+
+  radius = (argc > 4) ? atoi(*++argv) : RADIUS;
+  star   = STAR;
+  if (argc > 5) {
+    ++argv;
+    if      (!strcmp(*argv,"star"))    star = 1;
+    else if (!strcmp(*argv,"compact")) star = 0;
+    else {
+      printf("ERROR: Stencil shape %s should be star or compact\n", *argv);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (radius < 1) {
+    printf("ERROR: Stencil radius %d should be positive\n", radius);
+    exit(EXIT_FAILURE);
+  }
+
+  if (2*radius +1 > n) {
+    printf("ERROR: Stencil radius %d exceeds grid size %ld\n", radius, n);
+    exit(EXIT_FAILURE);
+  }
+
+  prk_pstl_threads threads(nthread_input);
+
+  /* prefer a vectorized row kernel                                             */
+  row  = prk_stencil_simd_dtype(star);
+  simd = prk_stencil_simd_isa();
+  if (!row) {
+    row  = star ? star_row : compact_row;
+    simd = "scalar";
+  }
+
+  total_length = n*n*sizeof(DTYPE);
+  in     = (DTYPE *) prk_malloc(total_length);
+  out    = (DTYPE *) prk_malloc(total_length);
+  weight = (DTYPE *) prk_malloc((2*radius+1)*(2*radius+1)*sizeof(DTYPE));
+  if (!in || !out || !weight) {
+    printf("ERROR: could not allocate space for input or output array: %ld\n",
+           total_length);
+    exit(EXIT_FAILURE);
+  }
+
+  /* fill the stencil weights to reflect a discrete divergence operator         */
+  for (jj=-radius; jj<=radius; jj++) for (ii=-radius; ii<=radius; ii++)
+    WEIGHT(ii,jj) = (DTYPE) 0.0;
+  if (star) {
+    stencil_size = 4*radius+1;
+    for (ii=1; ii<=radius; ii++) {
+      WEIGHT(0, ii) = WEIGHT( ii,0) =  (DTYPE) (1.0/(2.0*ii*radius));
+      WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(DTYPE) (1.0/(2.0*ii*radius));
+    }
+  }
+  else {
+    stencil_size = (2*radius+1)*(2*radius+1);
+    for (jj=1; jj<=radius; jj++) {
+      for (ii=-jj+1; ii<jj; ii++) {
+        WEIGHT(ii,jj)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(ii,-jj) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(jj,ii)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(-jj,ii) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+      }
+      WEIGHT(jj,jj)    =  (DTYPE) (1.0/(4.0*jj*radius));
+      WEIGHT(-jj,-jj)  = -(DTYPE) (1.0/(4.0*jj*radius));
+    }
+  }
+
+  f_active_points = (DTYPE) (n-2*radius)*(DTYPE) (n-2*radius);
+
+  printf("Number of threads     = %d (%s)\n", nthread_input,
+         threads.honored() ? PRK_PSTL_BACKEND : "advisory");
+  printf("Grid size             = %ld\n", n);
+  printf("Radius of stencil     = %d\n", radius);
+  printf("Type of stencil       = %s\n", star ? "star" : "compact");
+#if DOUBLE
+  printf("Data type             = double precision\n");
+#else
+  printf("Data type             = single precision\n");
+#endif
+  printf("SIMD micro-kernel     = %s\n", simd);
+  printf("Number of iterations  = %d\n", iterations);
+
+  prk_range rows(0, n), interior(radius, n-radius);
+
+  /* intialize the input and output arrays                                     */
+  std::for_each(std::execution::par_unseq, rows.begin(), rows.end(), [=](long j) {
+    for (long i=0; i<n; i++) {
+      IN(i,j)  = COEFX*i+COEFY*j;
+      OUT(i,j) = (DTYPE)0.0;
+    }
+  });
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* start timer after a warmup iteration                                    */
+    if (iter == 1) stencil_time = wtime();
+
+    /* Apply the stencil operator                                              */
+    std::for_each(std::execution::par_unseq, interior.begin(), interior.end(),
+                  [=](long j) { row(n, j, radius, weight, in, out); });
+
+    /* add constant to solution to force refresh of neighbor data, if any       */
+    std::for_each(std::execution::par_unseq, rows.begin(), rows.end(), [=](long j) {
+      for (long i=0; i<n; i++) IN(i,j) += 1.0;
+    });
+
+  } /* end of iterations                                                        */
+
+  stencil_time = wtime() - stencil_time;
+
+  /* compute L1 norm                                                            */
+  norm = std::transform_reduce(std::execution::par_unseq,
+                               interior.begin(), interior.end(), (DTYPE) 0.0,
+                               std::plus<DTYPE>(), [=](long j) {
+    DTYPE sum = (DTYPE) 0.0;
+    for (long i=radius; i<n-radius; i++) sum += (DTYPE)ABS(OUT(i,j));
+    return sum;
+  });
+
+  norm /= f_active_points;
+
+  /*******************************************************************************
+  ** Analyze and output results.
+  ********************************************************************************/
+
+/* verify correctness                                                            */
+  reference_norm = (DTYPE) (iterations+1) * (COEFX + COEFY);
+  if (ABS(norm-reference_norm) > EPSILON) {
+    printf("ERROR: L1 norm = " FSTR ", Reference L1 norm = " FSTR "\n",
+           norm, reference_norm);
+    exit(EXIT_FAILURE);
+  }
+  else {
+    printf("Solution validates\n");
+#if VERBOSE
+    printf("Reference L1 norm = " FSTR ", L1 norm = " FSTR "\n", 
+           reference_norm, norm);
+#endif
+  }
+
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
+  avgtime = stencil_time/iterations;
+  printf("Rate (MFlops/s): " FSTR "  Avg time (s): %lf\n",
+         1.0E-06 * flops/avgtime, avgtime);
+
+  exit(EXIT_SUCCESS);
+}
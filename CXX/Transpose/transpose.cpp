@@ -0,0 +1,232 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    transpose
+
+PURPOSE: This program measures the time for the transpose of a 
+         column-major stored matrix into a row-major stored matrix
+         with the C++17 parallel algorithms.
+  
+USAGE:   Program input is the number of threads, the number of times to
+         repeat the operation, the matrix order and, optionally, the tile
+         size used to divide the matrix for improved cache and TLB
+         performance:
+
+         transpose <# threads> <# iterations> <matrix order> [tile size]
+
+         The arguments and the verification are those of
+         OPENMP/Transpose, so that the rates can be compared directly.
+         Every iteration is one std::for_each with the par_unseq policy
+         over the tiles (the rows, if the matrix is not tiled); tiles
+         are transposed by the same vectorized kernels as in OpenMP, if
+         the CPU has them (see prk_transpose_simd.h). The
+         number of threads caps the TBB backend and is advisory with
+         others (see prk_pstl.h).
+  
+         The output consists of diagnostics to make sure the 
+         transpose worked and timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than standard C and C++ functions, the following 
+         functions are used in this program:
+
+         wtime()          portable wall-timer interface.
+         prk_transpose_simd*() vectorized tile kernels
+
+HISTORY: Derived from OPENMP/Transpose, October 2026.
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_pstl.h>
+#include <prk_transpose_simd.h>
+
+#define A(i,j)    A[i+order*(j)]
+#define B(i,j)    B[i+order*(j)]
+
+int main(int argc, char ** argv) {
+
+  long    order;           /* order of a the matrix                           */
+  int     Tile_order=32;   /* default tile size for tiling of local transpose */
+  long    ntile;           /* number of tiles in each dimension               */
+  int     tiling;          /* boolean: true if tiling is used                 */
+  int     nthread_input;   /* thread parameters                               */
+  int     iterations;      /* number of times to do the transpose             */
+  int     iter;            /* dummy                                           */
+  double  bytes;           /* combined size of matrices                       */
+  double  * A;             /* buffer to hold original matrix                  */
+  double  * B;             /* buffer to hold transposed matrix                */
+  double  abserr;          /* absolute error                                  */
+  double  epsilon=1.e-8;   /* error tolerance                                 */
+  double  trans_time,      /* timing parameters                               */
+          avgtime;
+  double  addit;           /* offset of entries of B after the iterations     */
+  prk_transpose_tile_t kernel; /* vectorized tile kernel, or NULL             */
+
+  /*********************************************************************
+  ** read and test input parameters
+  *********************************************************************/
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("C++17 parallel algorithms Matrix transpose: B = A^T\n");
+
+  if (argc != 4 && argc != 5){
+    printf("Usage: %s <# threads> <# iterations> <matrix order> [tile size]\n",
+           *argv);
+    exit(EXIT_FAILURE);
+  }
+
+  nthread_input = atoi(*++argv); 
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  iterations  = atoi(*++argv); 
+  if (iterations < 1){
+    printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  order = atol(*++argv); 
+  if (order <= 0){
+    printf("ERROR: Matrix Order must be greater than 0 : %ld \n", order);
+    exit(EXIT_FAILURE);
+  }
+
+  if (argc == 5) Tile_order = atoi(*++argv);
+  /* a non-positive tile size means no tiling of the local transpose */
+  tiling = (Tile_order > 0) && (Tile_order < order);
+  if (!tiling) Tile_order = order;
+  ntile = (order+Tile_order-1)/Tile_order;
+
+  prk_pstl_threads threads(nthread_input);
+  kernel = prk_transpose_simd(prk_transpose_streaming(2.0*sizeof(double)*order*order));
+
+  /*********************************************************************
+  ** Allocate space for the input and transpose matrix
+  *********************************************************************/
+
+  bytes = 2.0 * sizeof(double) * order * order;
+  A   = (double *)prk_malloc(order*order*sizeof(double));
+  B   = (double *)prk_malloc(order*order*sizeof(double));
+  if (!A || !B) {
+    printf("ERROR: could not allocate space for the matrices\n");
+    exit(EXIT_FAILURE);
+  }
+
+  printf("Number of threads     = %d (%s)\n", nthread_input,
+         threads.honored() ? PRK_PSTL_BACKEND : "advisory");
+  printf("Matrix order          = %ld\n", order);
+  printf("Number of iterations  = %d\n", iterations);
+  if (tiling)
+  printf("Tile size             = %d\n", Tile_order);
+  else
+  printf("Untiled\n");
+  printf("SIMD micro-kernel     = %s\n", kernel ? prk_transpose_simd_isa() : "scalar");
+
+  prk_range columns(0, order), tiles(0, ntile*ntile);
+
+  /* Fill the original matrix, set transpose to known garbage value. */
+  std::for_each(std::execution::par_unseq, columns.begin(), columns.end(),
+                [=](long j) {
+    for (long i=0; i<order; i++) {
+      A(i,j) = (double) (order*j + i);
+      B(i,j) = 0.0;
+    }
+  });
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* start timer after a warmup iteration */
+    if (iter == 1) trans_time = wtime();
+
+    if (!tiling)
+      std::for_each(std::execution::par_unseq, columns.begin(), columns.end(),
+                    [=](long j) {
+        for (long i=0; i<order; i++) {
+          B(i,j) += A(j,i);
+          A(j,i) += 1.0;
+        }
+      });
+    else
+      std::for_each(std::execution::par_unseq, tiles.begin(), tiles.end(),
+                    [=](long tile) {
+        long i0 = (tile%ntile)*Tile_order, i1 = MIN(order,i0+Tile_order);
+        long j0 = (tile/ntile)*Tile_order, j1 = MIN(order,j0+Tile_order);
+        if (kernel) kernel(order, j0, j1, i0, i1, A, B);
+        else for (long j=j0; j<j1; j++)
+          for (long i=i0; i<i1; i++) {
+            B(i,j) += A(j,i);
+            A(j,i) += 1.0;
+          }
+      });
+
+  }  /* end of iterations                                                     */
+
+  trans_time = wtime() - trans_time;
+
+  /*********************************************************************
+  ** Analyze and output results.
+  *********************************************************************/
+
+  addit = ((double)(iterations+1) * (double) (iterations))/2.0;
+  abserr = std::transform_reduce(std::execution::par_unseq,
+                                 columns.begin(), columns.end(), 0.0,
+                                 std::plus<double>(), [=](long j) {
+    double err = 0.0;
+    for (long i=0; i<order; i++)
+      err += ABS(B(i,j) - ((double)(order*i + j)*(iterations+1)+addit));
+    return err;
+  });
+
+#if VERBOSE
+  printf("Sum of absolute differences: %f\n",abserr);
+#endif
+
+  if (abserr < epsilon) {
+    printf("Solution validates\n");
+    avgtime = trans_time/iterations;
+    printf("Rate (MB/s): %lf Avg time (s): %lf\n",
+           1.0E-06 * bytes/avgtime, avgtime);
+    exit(EXIT_SUCCESS);
+  }
+  else {
+    printf("ERROR: Aggregate squared error %e exceeds threshold %e\n",
+           abserr, epsilon);
+    exit(EXIT_FAILURE);
+  }
+
+}  /* end of main */
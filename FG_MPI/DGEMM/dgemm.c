@@ -54,6 +54,7 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
 
 NOTES:   Derived frmo SUMMA implementation provided by Robert Van de Geijn,
          U. Texas at Austion.
@@ -65,6 +66,7 @@ HISTORY: Written by Rob Van der Wijngaart, December 2007
 
 #include "par-res-kern_general.h"
 #include "par-res-kern_fg-mpi.h"
+#include "prk_harness.h"
 
 #define A(i,j) (a[(j)*lda+i])
 #define B(i,j) (b[(j)*ldb+i])
@@ -120,6 +122,7 @@ int main(int argc, char *argv[])
   MPI_Comm comm_row,    /* communicators for row and column ranks  */
       comm_col;         /* of rank grid                            */
   int shortcut;         /* true if only doing initialization       */
+  prk_harness_t harness;/* per-iteration timing                    */
   int procsize;         /* number or ranks per process             */
 
   /* initialize                                                    */
@@ -297,13 +300,16 @@ int main(int argc, char *argv[])
     exit(EXIT_SUCCESS);
   }
 
+  prk_harness_init(&harness, "DGEMM", "FG_MPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "order", "%d", order);
+  prk_harness_param(&harness, "block", "%ld", nb);
+
   for (iter=0; iter<=iterations; iter++) {
 
-    /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_dgemm_time = wtime();
-    }
+    /* time every iteration after a warmup iteration */
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* actual matrix-vector multiply                               */
     dgemm(order, nb, inner_block_flag, a, lda, b, lda, c, lda, 
@@ -311,7 +317,8 @@ int main(int argc, char *argv[])
 
   } /* end of iterations                                           */
 
-  local_dgemm_time = wtime() - local_dgemm_time;
+  prk_harness_tick(&harness);
+  local_dgemm_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_dgemm_time, &dgemm_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
@@ -350,6 +357,9 @@ int main(int argc, char *argv[])
       printf("Rate (MFlops/s): %lf Avg time (s): %lf\n",
              1.0E-06 * nflops/avgtime, avgtime);
   }
+  prk_harness_model(&harness, nflops, 4.0*sizeof(double)*forder*forder);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * nflops);
+  prk_harness_finalize(&harness);
 
   MPI_Finalize();
 }
@@ -69,6 +69,7 @@ FUNCTIONS CALLED:
          contain()
          wtime()
          random_draw()
+         prk_harness_*()
 
 HISTORY: - Written by Evangelos Georganas, August 2015.
          - RvdW: Refactored to make the code PRK conforming, March 2016
@@ -77,6 +78,7 @@ HISTORY: - Written by Evangelos Georganas, August 2015.
 #include <par-res-kern_general.h>
 #include <par-res-kern_fg-mpi.h>
 #include <random_draw.h>
+#include <prk_harness.h>
 
 /* M_PI is not defined in strict C99 */
 #ifdef M_PI
@@ -636,6 +638,7 @@ int main(int argc, char ** argv) {
   uint64_t        ptr_my;            //
   uint64_t        owner;             // owner (rank) of a particular particle
   double          pic_time, local_pic_time, avg_time;
+  prk_harness_t   harness;           // per-time-step timing
   uint64_t        my_checksum = 0, tot_checksum = 0, correctness_checksum = 0;
   uint64_t        width, height;     // minimum dimensions of grid tile owned by my rank
   int             particle_mode;     // type of initialization
@@ -949,14 +952,19 @@ int main(int argc, char ** argv) {
   if (error) printf("Rank %d could not allocate communication buffers\n", my_ID);
   bail_out(error);
     
+  prk_harness_init(&harness, "PIC-static", "FG_MPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%llu", (unsigned long long) L);
+  prk_harness_param(&harness, "particles", "%llu", (unsigned long long) n);
+  /* init_mode is only parsed on the root, which is the rank that reports  */
+  prk_harness_param(&harness, "init_mode", "%s", my_ID == root ? init_mode : "");
+
   /* Run the simulation */
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_pic_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     ptr_my = 0;
     for (i=0; i<8; i++) to_send[i]=0;
@@ -1035,7 +1043,8 @@ int main(int argc, char ** argv) {
     particles_count = ptr_my;
   }
    
-  local_pic_time = MPI_Wtime() - local_pic_time;
+  prk_harness_tick(&harness);
+  local_pic_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_pic_time, &pic_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
    
@@ -1074,6 +1083,10 @@ int main(int argc, char ** argv) {
   }
 #endif
 
+  /* total_particles is only known on the root, which is the rank that reports */
+  prk_harness_report(&harness, "Mparticles_moved/s", 1.0e-6*total_particles);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
    
   return 0;
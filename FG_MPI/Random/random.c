@@ -87,6 +87,7 @@ FUNCTIONS CALLED:
 
          wtime
          bail_out()
+         prk_harness_*()
          PRK_starts
          poweroftwo
 
@@ -139,6 +140,7 @@ HISTORY: Written by Rob Van der Wijngaart, December 2007.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_fg-mpi.h>
+#include <prk_harness.h>
 
 /* Define 64-bit types and corresponding format strings for printf() and constants */
 /* PERIOD = (2^63-1)/7 = 7*73*127*337*92737*649657                                 */
@@ -177,7 +179,9 @@ int main(int argc, char **argv) {
   int               *recvdispls; /* successive dispalcemetns in receive buffer     */
   u64Int * RESTRICT Table;       /* (pseudo-)randomly accessed array               */
   double            random_time, /* timing parameters                              */
+                    local_random_time,
                     avgtime = 0.0;
+  prk_harness_t     harness;     /* timing and counters of the update phase        */
   int               Num_procs,   /* rank parameters                                */
                     my_ID,       /* rank of calling rank                           */
                     root=0;      /* ID of master rank                              */
@@ -382,10 +386,14 @@ int main(int argc, char **argv) {
   /* initialize the table */
   for(i=0;i<loctablesize;i++) Table[i] = (u64Int) (i+ loctablesize*my_ID);
 
+  prk_harness_init(&harness, "Random", "FG_MPI", 1);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "tablesize", "%lld", (long long) tablesize);
+  prk_harness_param(&harness, "update_ratio", "%d", update_ratio);
+  prk_harness_param(&harness, "vector_length", "%d", nstarts);
+
   MPI_Barrier(MPI_COMM_WORLD);
-  if (my_ID == root) {
-    random_time = wtime();
-  }
+  prk_harness_tick(&harness);
 
   /* do two identical rounds of Random Access to ensure we recover initial table   */
   for (round=0; round <2; round++) {
@@ -438,7 +446,10 @@ int main(int argc, char **argv) {
     }
   }
 
-  if (my_ID == root) random_time = wtime() - random_time;
+  prk_harness_tick(&harness);
+  local_random_time = prk_harness_elapsed(&harness);
+  MPI_Reduce(&local_random_time, &random_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
 
   /* verification test */
   for(i=0;i<loctablesize;i++) {
@@ -467,6 +478,10 @@ int main(int argc, char **argv) {
     }
   }
 
+  prk_harness_model(&harness, 0.0, 2.0*64*nupdate*Num_procs);
+  prk_harness_report(&harness, "GUPS/s", 1.e-9*(nupdate*Num_procs));
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
 }
 
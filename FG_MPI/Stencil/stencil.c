@@ -43,6 +43,18 @@ USAGE:   The program takes as input the linear dimension of the grid,
  
                <progname> <# iterations> <grid size>
   
+         PRK_EXCHANGE=pointer replaces the halo messages between ranks
+         that share an OS process by direct reads: the ranks trade the
+         addresses of their tiles once, and in every iteration a rank
+         copies its ghost points straight out of the tile of each
+         co-located neighbor. Two empty messages per neighbor and
+         iteration order the accesses; one says that the tile of the
+         sender is up to date, the other that the sender is done reading
+         the tile of the receiver, which may then update it. This is
+         the ceiling of what co-location can gain over the default,
+         PRK_EXCHANGE=messages, which packs, sends and unpacks every
+         halo; neighbors in other OS processes still get messages.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
  
@@ -53,6 +65,9 @@ FUNCTIONS CALLED:
  
          wtime()
          bail_out()
+         prk_harness_*()
+         MPIX_Get_collocated_size()
+         MPIX_Get_collocated_startrank()
  
 HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, August 2013: Removed unrolling pragmas for clarity;
@@ -70,6 +85,7 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_fg-mpi.h>
+#include <prk_harness.h>
  
 #if DOUBLE
   #define DTYPE     double
@@ -94,6 +110,27 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
 #define INDEXOUT(i,j) (i+(j)*(width))
 #define OUT(i,j)      out[INDEXOUT(i-istart,j-jstart)]
 #define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+
+/* directions of the neighbors of a tile                                          */
+#define TOP    0
+#define BOTTOM 1
+#define RIGHT  2
+#define LEFT   3
+
+/* tags of the empty messages that order the direct halo reads                    */
+#define TAG_READY 300
+#define TAG_DONE  301
+
+/* what a co-located neighbor needs to read the halo straight from a tile         */
+typedef struct {
+  DTYPE *in;              /* input grid values of the tile                       */
+  int    istart, jstart;  /* global indices of the first interior point          */
+  int    width;           /* number of interior points in the x-direction        */
+} tile_t;
+
+/* input value at global point (i,j) in the tile of the neighbor in direction d   */
+#define NBR_IN(d,i,j) nbr_tile[d].in[(i)-nbr_tile[d].istart+RADIUS+                \
+                      ((j)-nbr_tile[d].jstart+RADIUS)*(nbr_tile[d].width+2*RADIUS)]
  
 int main(int argc, char ** argv) {
  
@@ -125,6 +162,7 @@ int main(int argc, char ** argv) {
   DTYPE  f_active_points; /* interior of grid with respect to stencil            */
   DTYPE  flops;           /* floating point ops per iteration                    */
   int    iterations;      /* number of times to run the algorithm                */
+  prk_harness_t harness;  /* per-iteration timing                                */
   double local_stencil_time,/* timing parameters                                 */
          stencil_time,
          avgtime; 
@@ -138,6 +176,18 @@ int main(int argc, char ** argv) {
   MPI_Request request[8];
   MPI_Status  status[8];
   int     procsize;       /* number of ranks per OS process                      */
+  int     procstart;      /* first rank in the OS process of the calling rank    */
+  int     pointer;        /* boolean: read halos of co-located ranks directly    */
+  char   *env;            /* value of PRK_EXCHANGE                               */
+  int     nbr[4];         /* neighbor in each direction                          */
+  int     has_nbr[4];     /* boolean: there is a neighbor in this direction      */
+  int     direct[4];      /* boolean: neighbor is read directly                  */
+  int     d;              /* direction                                           */
+  tile_t  my_tile;        /* description of the tile of the calling rank         */
+  tile_t  nbr_tile[4];    /* descriptions of the tiles of the neighbors          */
+  MPI_Request ready_req[4], done_req[4]; /* receipt of ordering messages         */
+  MPI_Request token_req[8];/* sending of ordering messages                       */
+  int     ntoken;         /* number of ordering messages sent in an iteration    */
  
   /*******************************************************************************
   ** Initialize the MPI environment
@@ -194,6 +244,17 @@ int main(int argc, char ** argv) {
       goto ENDOFTESTS;  
     }
  
+    pointer = 0;
+    env = getenv("PRK_EXCHANGE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"pointer")) pointer = 1;
+      else if (strcmp(env,"messages")) {
+        printf("ERROR: PRK_EXCHANGE must be messages or pointer: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+ 
     ENDOFTESTS:;  
   }
   bail_out(error);
@@ -234,10 +295,12 @@ int main(int argc, char ** argv) {
     printf("Compact representation of stencil loop body\n");
 #endif
     printf("Number of iterations     = %d\n", iterations);
+    printf("Halo exchange            = %s\n", pointer ? "pointer" : "messages");
   }
  
   MPI_Bcast(&n,          1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&pointer,    1, MPI_INT, root, MPI_COMM_WORLD);
  
   /* compute amount of space required for input and solution arrays             */
   
@@ -337,16 +400,50 @@ int main(int argc, char ** argv) {
     left_buf_in    = right_buf_out + 3*RADIUS*height;
   }
 
+  /* find the neighbors that share the OS process, and trade tile descriptions
+     with them; ranks of an OS process are consecutive                         */
+  nbr[TOP]    = top_nbr;    has_nbr[TOP]    = my_IDy < Num_procsy-1;
+  nbr[BOTTOM] = bottom_nbr; has_nbr[BOTTOM] = my_IDy > 0;
+  nbr[RIGHT]  = right_nbr;  has_nbr[RIGHT]  = my_IDx < Num_procsx-1;
+  nbr[LEFT]   = left_nbr;   has_nbr[LEFT]   = my_IDx > 0;
+  MPIX_Get_collocated_size(&procsize);
+  MPIX_Get_collocated_startrank(&procstart);
+  for (d=0; d<4; d++)
+    direct[d] = pointer && has_nbr[d] && 
+                nbr[d] >= procstart && nbr[d] < procstart+procsize;
+
+  my_tile.in     = in;
+  my_tile.istart = istart;
+  my_tile.jstart = jstart;
+  my_tile.width  = width;
+  for (ntoken=0, d=0; d<4; d++) if (direct[d]) {
+    MPI_Irecv(&nbr_tile[d], sizeof(tile_t), MPI_BYTE, nbr[d], TAG_READY,
+              MPI_COMM_WORLD, &token_req[ntoken++]);
+    MPI_Isend(&my_tile, sizeof(tile_t), MPI_BYTE, nbr[d], TAG_READY,
+              MPI_COMM_WORLD, &token_req[ntoken++]);
+  }
+  MPI_Waitall(ntoken, token_req, MPI_STATUSES_IGNORE);
+
+  prk_harness_init(&harness, "Stencil", "FG_MPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%d", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "exchange", "%s", pointer ? "pointer" : "messages");
+
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_stencil_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
  
+    /* tell the co-located neighbors that my tile is up to date                     */
+    for (ntoken=0, d=0; d<4; d++) if (direct[d]) {
+      MPI_Irecv(NULL, 0, MPI_BYTE, nbr[d], TAG_READY, MPI_COMM_WORLD, &ready_req[d]);
+      MPI_Isend(NULL, 0, MPI_BYTE, nbr[d], TAG_READY, MPI_COMM_WORLD, &token_req[ntoken++]);
+    }
+
     /* need to fetch ghost point data from neighbors in y-direction                 */
-    if (my_IDy < Num_procsy-1) {
+    if (my_IDy < Num_procsy-1 && !direct[TOP]) {
       MPI_Irecv(top_buf_in, RADIUS*width, MPI_DTYPE, top_nbr, 101,
                 MPI_COMM_WORLD, &(request[1]));
       for (kk=0,j=jend-RADIUS+1; j<=jend; j++) for (i=istart; i<=iend; i++) {
@@ -355,7 +452,7 @@ int main(int argc, char ** argv) {
       MPI_Isend(top_buf_out, RADIUS*width,MPI_DTYPE, top_nbr, 99, 
                 MPI_COMM_WORLD, &(request[0]));
     }
-    if (my_IDy > 0) {
+    if (my_IDy > 0 && !direct[BOTTOM]) {
       MPI_Irecv(bottom_buf_in,RADIUS*width, MPI_DTYPE, bottom_nbr, 99, 
                 MPI_COMM_WORLD, &(request[3]));
       for (kk=0,j=jstart; j<=jstart+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
@@ -364,14 +461,14 @@ int main(int argc, char ** argv) {
       MPI_Isend(bottom_buf_out, RADIUS*width,MPI_DTYPE, bottom_nbr, 101,
                 MPI_COMM_WORLD, &(request[2]));
     }
-    if (my_IDy < Num_procsy-1) {
+    if (my_IDy < Num_procsy-1 && !direct[TOP]) {
       MPI_Wait(&(request[0]), &(status[0]));
       MPI_Wait(&(request[1]), &(status[1]));
       for (kk=0,j=jend+1; j<=jend+RADIUS; j++) for (i=istart; i<=iend; i++) {
           IN(i,j) = top_buf_in[kk++];
       }      
     }
-    if (my_IDy > 0) {
+    if (my_IDy > 0 && !direct[BOTTOM]) {
       MPI_Wait(&(request[2]), &(status[2]));
       MPI_Wait(&(request[3]), &(status[3]));
       for (kk=0,j=jstart-RADIUS; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
@@ -380,7 +477,7 @@ int main(int argc, char ** argv) {
     }
 
     /* need to fetch ghost point data from neighbors in x-direction                 */
-    if (my_IDx < Num_procsx-1) {
+    if (my_IDx < Num_procsx-1 && !direct[RIGHT]) {
       MPI_Irecv(right_buf_in, RADIUS*height, MPI_DTYPE, right_nbr, 1010,
                 MPI_COMM_WORLD, &(request[1+4]));
       for (kk=0,j=jstart; j<=jend; j++) for (i=iend-RADIUS+1; i<=iend; i++) {
@@ -389,7 +486,7 @@ int main(int argc, char ** argv) {
       MPI_Isend(right_buf_out, RADIUS*height, MPI_DTYPE, right_nbr, 990, 
               MPI_COMM_WORLD, &(request[0+4]));
     }
-    if (my_IDx > 0) {
+    if (my_IDx > 0 && !direct[LEFT]) {
       MPI_Irecv(left_buf_in, RADIUS*height, MPI_DTYPE, left_nbr, 990, 
                 MPI_COMM_WORLD, &(request[3+4]));
       for (kk=0,j=jstart; j<=jend; j++) for (i=istart; i<=istart+RADIUS-1; i++) {
@@ -398,14 +495,14 @@ int main(int argc, char ** argv) {
       MPI_Isend(left_buf_out, RADIUS*height, MPI_DTYPE, left_nbr, 1010,
                 MPI_COMM_WORLD, &(request[2+4]));
     }
-    if (my_IDx < Num_procsx-1) {
+    if (my_IDx < Num_procsx-1 && !direct[RIGHT]) {
       MPI_Wait(&(request[0+4]), &(status[0+4]));
       MPI_Wait(&(request[1+4]), &(status[1+4]));
       for (kk=0,j=jstart; j<=jend; j++) for (i=iend+1; i<=iend+RADIUS; i++) {
           IN(i,j) = right_buf_in[kk++];
       }      
     }
-    if (my_IDx > 0) {
+    if (my_IDx > 0 && !direct[LEFT]) {
       MPI_Wait(&(request[2+4]), &(status[2+4]));
       MPI_Wait(&(request[3+4]), &(status[3+4]));
       for (kk=0,j=jstart; j<=jend; j++) for (i=istart-RADIUS; i<=istart-1; i++) {
@@ -413,6 +510,32 @@ int main(int argc, char ** argv) {
       }      
     }
 
+    /* copy ghost points straight out of the tiles of co-located neighbors, once
+       they are up to date, and tell the neighbors when done                        */
+    for (d=0; d<4; d++) if (direct[d]) {
+      MPI_Wait(&ready_req[d], MPI_STATUS_IGNORE);
+      switch (d) {
+      case TOP:
+        for (j=jend+1; j<=jend+RADIUS; j++) for (i=istart; i<=iend; i++)
+          IN(i,j) = NBR_IN(TOP,i,j);
+        break;
+      case BOTTOM:
+        for (j=jstart-RADIUS; j<=jstart-1; j++) for (i=istart; i<=iend; i++)
+          IN(i,j) = NBR_IN(BOTTOM,i,j);
+        break;
+      case RIGHT:
+        for (j=jstart; j<=jend; j++) for (i=iend+1; i<=iend+RADIUS; i++)
+          IN(i,j) = NBR_IN(RIGHT,i,j);
+        break;
+      case LEFT:
+        for (j=jstart; j<=jend; j++) for (i=istart-RADIUS; i<=istart-1; i++)
+          IN(i,j) = NBR_IN(LEFT,i,j);
+        break;
+      }
+      MPI_Irecv(NULL, 0, MPI_BYTE, nbr[d], TAG_DONE, MPI_COMM_WORLD, &done_req[d]);
+      MPI_Isend(NULL, 0, MPI_BYTE, nbr[d], TAG_DONE, MPI_COMM_WORLD, &token_req[ntoken++]);
+    }
+
     /* Apply the stencil operator */
     for (j=MAX(jstart,RADIUS); j<=MIN(n-RADIUS-1,jend); j++) {
       for (i=MAX(istart,RADIUS); i<=MIN(n-RADIUS-1,iend); i++) {
@@ -426,12 +549,17 @@ int main(int argc, char ** argv) {
       }
     }
  
+    /* my tile may only change once the co-located neighbors have read it          */
+    for (d=0; d<4; d++) if (direct[d]) MPI_Wait(&done_req[d], MPI_STATUS_IGNORE);
+    MPI_Waitall(ntoken, token_req, MPI_STATUSES_IGNORE);
+
     /* add constant to solution to force refresh of neighbor data, if any */
     for (j=jstart; j<=jend; j++) for (i=istart; i<=iend; i++) IN(i,j)+= 1.0;
  
   } /* end of iterations                                                   */
 
-  local_stencil_time = wtime() - local_stencil_time;
+  prk_harness_tick(&harness);
+  local_stencil_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_stencil_time, &stencil_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
@@ -473,14 +601,17 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
   if (my_ID == root) {
-    /* flops/stencil: 2 flops (fma) for each point in the stencil, 
-       plus one flop for the update of the input of the array        */
-    flops = (DTYPE) (2*stencil_size+1) * f_active_points;
     avgtime = stencil_time/iterations;
     printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
            1.0E-06 * flops/avgtime, avgtime);
   }
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
  
   MPI_Finalize();
   exit(EXIT_SUCCESS);
@@ -54,6 +54,7 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, March 2006.
          - modified by Rob Van der Wijngaart, August 2006:
@@ -66,6 +67,7 @@ HISTORY: - Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_fg-mpi.h>
+#include <prk_harness.h>
 
 #define ARRAY(i,j) vector[i+1+(j)*(segment_size+1)]
 
@@ -91,6 +93,7 @@ int main(int argc, char ** argv)
   double *inbuf, *outbuf; /* communication buffers used when aggregating         */
   long   total_length;    /* total required length to store grid values          */
   MPI_Status status;      /* completion status of message                        */
+  prk_harness_t harness;  /* per-iteration timing                                */
   int     procsize;       /* number of ranks per OS process                      */
 
 /*********************************************************************************
@@ -217,13 +220,17 @@ int main(int argc, char ** argv)
   else          start = 0;
   end = segment_size-1;
 
+  prk_harness_init(&harness, "Synch_p2p", "FG_MPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
+  prk_harness_param(&harness, "group", "%d", grp);
+
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_pipeline_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* execute pipeline algorithm for grid lines 1 through n-1 (skip bottom line) */
     if (grp==1) for (j=1; j<n; j++) { /* special case for no grouping             */
@@ -284,7 +291,8 @@ int main(int argc, char ** argv)
 
   }
 
-  local_pipeline_time = wtime() - local_pipeline_time;
+  prk_harness_tick(&harness);
+  local_pipeline_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_pipeline_time, &pipeline_time, 1, MPI_DOUBLE, MPI_MAX, final,
              MPI_COMM_WORLD);
 
@@ -317,6 +325,9 @@ int main(int argc, char ** argv)
     printf("Rate (MFlops/s): %lf Avg time (s): %lf\n",
            1.0E-06 * 2 * ((double)((m-1)*(n-1)))/avgtime, avgtime);
   }
+
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * ((double)((m-1)*(n-1))));
+  prk_harness_finalize(&harness);
  
   MPI_Finalize();
   exit(EXIT_SUCCESS);
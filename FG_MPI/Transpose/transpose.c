@@ -56,6 +56,7 @@ FUNCTIONS CALLED:
 
           wtime()           Portable wall-timer interface.
           bail_out()        Determine global error and exit if nonzero.
+          prk_harness_*()   Per-iteration timing and results record.
 
 HISTORY: Written by Tim Mattson, April 1999.  
          Updated by Rob Van der Wijngaart, December 2005.
@@ -121,6 +122,7 @@ o The original and transposed matrices are called A and B
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_fg-mpi.h>
+#include <prk_harness.h>
 
 #define A(i,j)        A_p[(i+istart)+order*(j)]
 #define B(i,j)        B_p[(i+istart)+order*(j)]
@@ -145,6 +147,7 @@ int main(int argc, char ** argv)
   int my_ID;               /* rank                                  */
   int root=0;              /* rank of root                          */
   int iterations;          /* number of times to do the transpose   */
+  prk_harness_t harness;   /* per-iteration timing                  */
   int i, j, it, jt, istart;/* dummies                               */
   int iter;                /* index of iteration                    */
   int phase;               /* phase inside staged communication     */
@@ -278,13 +281,16 @@ int main(int argc, char ** argv)
       B(i,j) = 0.0;
   }
 
+  prk_harness_init(&harness, "Transpose", "FG_MPI", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "order", "%ld", order);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? Tile_order : 0);
+
   for (iter = 0; iter<=iterations; iter++){
 
-    /* start timer after a warmup iteration                                        */
-    if (iter == 1) {
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_trans_time = wtime();
-    }
+    /* time every iteration after a warmup iteration                               */
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* do the local transpose                                                     */
     istart = colstart;
@@ -352,7 +358,8 @@ int main(int argc, char ** argv)
     }  /* end of phase loop  */
   } /* end of iterations */
 
-  local_trans_time = wtime() - local_trans_time;
+  prk_harness_tick(&harness);
+  local_trans_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_trans_time, &trans_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
@@ -382,6 +389,10 @@ int main(int argc, char ** argv)
 
   bail_out(error);
 
+  prk_harness_model(&harness, 2.0*order*order, 2.0*bytes);
+  prk_harness_report(&harness, "MB/s", 1.0E-06*bytes);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 
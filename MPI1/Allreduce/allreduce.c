@@ -0,0 +1,440 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    Allreduce
+
+PURPOSE: This program tests the efficiency with which vectors that are
+         distributed among the ranks can be summed elementwise, with the
+         result delivered to every rank, for a range of vector sizes.
+         Next to the MPI library's MPI_Allreduce it measures three
+         user-level algorithms, so that poorly tuned library collectives
+         can be detected:
+           ring          reduce-scatter around a ring of ranks, followed
+                         by an allgather around the same ring; 2(p-1)
+                         steps, bandwidth-optimal for long vectors
+           doubling      recursive doubling; log2(p) steps that each
+                         exchange the whole vector, latency-optimal
+           rabenseifner  reduce-scatter by recursive halving, followed by
+                         an allgather by recursive doubling
+         Recursive doubling and Rabenseifner's algorithm work on a power
+         of two of ranks; the remaining ranks first hand their vectors to
+         a neighbor, and get the result from it at the end.
+  
+USAGE:   The program takes as input the number of times each reduction
+         is repeated, and the smallest and largest vector size in bytes.
+         The size is doubled from the smallest to the largest.
+
+               <progname> <# iterations> <min bytes> <max bytes>
+
+         PRK_ALLREDUCE=library, ring, doubling, or rabenseifner measures
+         only that algorithm; by default (all) every algorithm is measured,
+         and the time of the library is also given relative to the fastest
+         user-level algorithm (a ratio above 1 indicates poor tuning).
+  
+         The output consists of diagnostics to make sure the 
+         algorithms worked, and of timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following external 
+         functions are used in this program:
+
+         wtime();
+         bail_out();
+         prk_harness_*();
+         ring_allreduce();
+         doubling_allreduce();
+         rabenseifner_allreduce();
+
+HISTORY: Derived from MPI1/Reduce, October 2026; user-level algorithms
+         added for comparison with the library.
+  
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+
+#define LIBRARY      0
+#define RING         1
+#define DOUBLING     2
+#define RABENSEIFNER 3
+#define ALGORITHMS   4
+
+static const char *algorithm_name[ALGORITHMS] = {"library", "ring", "doubling",
+                                                 "rabenseifner"};
+
+static void add(double * RESTRICT out, const double * RESTRICT in, long count) {
+  long i;
+  for (i=0; i<count; i++) out[i] += in[i];
+}
+
+/* bounds of chunk k out of p chunks of a vector of count elements           */
+static long chunk_start(long count, int p, int k) {
+  return (count/p)*k + MIN(k, count%p);
+}
+
+static void ring_allreduce(const double *in, double *out, double *tmp, long count,
+                           int my_ID, int Num_procs, MPI_Comm comm) {
+  int  right = (my_ID+1)%Num_procs, left = (my_ID-1+Num_procs)%Num_procs, s, send, recv;
+
+  memcpy(out, in, count*sizeof(double));
+  /* reduce-scatter: after step s, chunk my_ID-s-1 holds s+2 contributions  */
+  for (s=0; s<Num_procs-1; s++) {
+    send = (my_ID-s+Num_procs)%Num_procs;
+    recv = (my_ID-s-1+Num_procs)%Num_procs;
+    MPI_Sendrecv(out+chunk_start(count,Num_procs,send),
+                 chunk_start(count,Num_procs,send+1)-chunk_start(count,Num_procs,send),
+                 MPI_DOUBLE, right, 1,
+                 tmp, chunk_start(count,Num_procs,recv+1)-chunk_start(count,Num_procs,recv),
+                 MPI_DOUBLE, left, 1, comm, MPI_STATUS_IGNORE);
+    add(out+chunk_start(count,Num_procs,recv), tmp,
+        chunk_start(count,Num_procs,recv+1)-chunk_start(count,Num_procs,recv));
+  }
+  /* allgather: pass the complete chunks on around the ring                  */
+  for (s=0; s<Num_procs-1; s++) {
+    send = (my_ID+1-s+Num_procs)%Num_procs;
+    recv = (my_ID-s+Num_procs)%Num_procs;
+    MPI_Sendrecv(out+chunk_start(count,Num_procs,send),
+                 chunk_start(count,Num_procs,send+1)-chunk_start(count,Num_procs,send),
+                 MPI_DOUBLE, right, 2,
+                 out+chunk_start(count,Num_procs,recv),
+                 chunk_start(count,Num_procs,recv+1)-chunk_start(count,Num_procs,recv),
+                 MPI_DOUBLE, left, 2, comm, MPI_STATUS_IGNORE);
+  }
+}
+
+/* Fold the ranks beyond the largest power of two pof2 into their neighbors:
+   of the first 2*(Num_procs-pof2) ranks, the even ones send their vectors
+   to the odd ones and sit out. Returns the rank among the pof2 remaining
+   ranks, or -1 for a rank that sits out.                                    */
+static int fold_in(double *out, double *tmp, long count, int my_ID, int Num_procs,
+                   int pof2, MPI_Comm comm) {
+  int rem = Num_procs-pof2;
+
+  if (my_ID < 2*rem) {
+    if (my_ID%2 == 0) {
+      MPI_Send(out, count, MPI_DOUBLE, my_ID+1, 3, comm);
+      return -1;
+    }
+    MPI_Recv(tmp, count, MPI_DOUBLE, my_ID-1, 3, comm, MPI_STATUS_IGNORE);
+    add(out, tmp, count);
+    return my_ID/2;
+  }
+  return my_ID-rem;
+}
+
+/* rank of the remaining rank with the given number                          */
+static int unfolded(int newrank, int rem) {
+  return newrank < rem ? 2*newrank+1 : newrank+rem;
+}
+
+/* return the result to the ranks that sat out                               */
+static void fold_out(double *out, long count, int my_ID, int Num_procs, int pof2,
+                     MPI_Comm comm) {
+  int rem = Num_procs-pof2;
+
+  if (my_ID < 2*rem) {
+    if (my_ID%2 == 0) MPI_Recv(out, count, MPI_DOUBLE, my_ID+1, 4, comm, MPI_STATUS_IGNORE);
+    else              MPI_Send(out, count, MPI_DOUBLE, my_ID-1, 4, comm);
+  }
+}
+
+static void doubling_allreduce(const double *in, double *out, double *tmp, long count,
+                               int my_ID, int Num_procs, MPI_Comm comm) {
+  int pof2, newrank, mask, partner;
+
+  for (pof2=1; 2*pof2<=Num_procs; pof2*=2);
+  memcpy(out, in, count*sizeof(double));
+  newrank = fold_in(out, tmp, count, my_ID, Num_procs, pof2, comm);
+  if (newrank >= 0) {
+    for (mask=1; mask<pof2; mask*=2) {
+      partner = unfolded(newrank^mask, Num_procs-pof2);
+      MPI_Sendrecv(out, count, MPI_DOUBLE, partner, 5,
+                   tmp, count, MPI_DOUBLE, partner, 5, comm, MPI_STATUS_IGNORE);
+      add(out, tmp, count);
+    }
+  }
+  fold_out(out, count, my_ID, Num_procs, pof2, comm);
+}
+
+static void rabenseifner_allreduce(const double *in, double *out, double *tmp, long count,
+                                   int my_ID, int Num_procs, MPI_Comm comm) {
+  int  pof2, newrank, mask, partner, step, nstep;
+  long lo[32], hi[32], mid;   /* range owned before each halving step        */
+
+  for (pof2=1, nstep=0; 2*pof2<=Num_procs; pof2*=2, nstep++);
+  memcpy(out, in, count*sizeof(double));
+  newrank = fold_in(out, tmp, count, my_ID, Num_procs, pof2, comm);
+  if (newrank >= 0) {
+    /* reduce-scatter by recursive halving: keep the half on my side of the
+       partner, send the other half, and add the partner's copy of mine      */
+    lo[0] = 0; hi[0] = count;
+    for (step=0, mask=pof2/2; mask>0; step++, mask/=2) {
+      partner = unfolded(newrank^mask, Num_procs-pof2);
+      mid     = lo[step] + (hi[step]-lo[step])/2;
+      if (newrank & mask) {
+        MPI_Sendrecv(out+lo[step], mid-lo[step], MPI_DOUBLE, partner, 6,
+                     tmp, hi[step]-mid, MPI_DOUBLE, partner, 6, comm, MPI_STATUS_IGNORE);
+        add(out+mid, tmp, hi[step]-mid);
+        lo[step+1] = mid; hi[step+1] = hi[step];
+      }
+      else {
+        MPI_Sendrecv(out+mid, hi[step]-mid, MPI_DOUBLE, partner, 6,
+                     tmp, mid-lo[step], MPI_DOUBLE, partner, 6, comm, MPI_STATUS_IGNORE);
+        add(out+lo[step], tmp, mid-lo[step]);
+        lo[step+1] = lo[step]; hi[step+1] = mid;
+      }
+    }
+    /* allgather by recursive doubling, undoing the halving steps            */
+    for (step=nstep-1, mask=1; mask<pof2; step--, mask*=2) {
+      partner = unfolded(newrank^mask, Num_procs-pof2);
+      mid     = lo[step] + (hi[step]-lo[step])/2;
+      if (newrank & mask)
+        MPI_Sendrecv(out+mid, hi[step]-mid, MPI_DOUBLE, partner, 7,
+                     out+lo[step], mid-lo[step], MPI_DOUBLE, partner, 7, comm,
+                     MPI_STATUS_IGNORE);
+      else
+        MPI_Sendrecv(out+lo[step], mid-lo[step], MPI_DOUBLE, partner, 7,
+                     out+mid, hi[step]-mid, MPI_DOUBLE, partner, 7, comm,
+                     MPI_STATUS_IGNORE);
+    }
+  }
+  fold_out(out, count, my_ID, Num_procs, pof2, comm);
+}
+
+int main(int argc, char ** argv)
+{
+  int Num_procs;        /* Number of ranks                                   */
+  int my_ID;            /* Rank                                              */
+  int root=0;
+  int iterations;       /* number of times each reduction is carried out     */
+  long i, iter;         /* dummies                                           */
+  long min_bytes,       /* range of vector sizes in bytes                    */
+       max_bytes,
+       bytes;
+  long count;           /* number of elements of the current vector          */
+  double * RESTRICT in; /* vector to be reduced                              */
+  double * RESTRICT out;/* result vector                                     */
+  double * RESTRICT tmp;/* receive buffer of the user-level algorithms       */
+  double local_time,    /* timing parameters                                 */
+         avgtime[ALGORITHMS],
+         best;
+  double element_value; /* verification value                                */
+  int    algorithm,     /* algorithm being measured                          */
+         selected=-1;   /* algorithm selected by PRK_ALLREDUCE, -1 for all   */
+  char   *env;          /* value of PRK_ALLREDUCE                            */
+  int    error = 0;     /* error flag                                        */
+  prk_harness_t harness[ALGORITHMS]; /* per-iteration timing, per algorithm  */
+
+  /***************************************************************************
+  ** Initialize the MPI environment
+  ****************************************************************************/
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+
+  /***************************************************************************
+  ** process, test and broadcast input parameters
+  ****************************************************************************/
+
+  if (my_ID == root){
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPI vector allreduce\n");
+
+    if (argc != 4){
+      printf("Usage: %s <# iterations> <min bytes> <max bytes>\n", *argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    iterations    = atoi(*++argv);
+    if (iterations < 1) {
+      printf("ERROR: Iterations must be positive: %d\n", iterations);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    min_bytes = atol(*++argv);
+    max_bytes = atol(*++argv);
+    if (min_bytes < (long)sizeof(double) || max_bytes < min_bytes) {
+      printf("ERROR: Vector sizes must satisfy %d <= min <= max: %ld, %ld\n",
+             (int)sizeof(double), min_bytes, max_bytes);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_ALLREDUCE");
+    if (env != NULL && *env != '\0' && strcmp(env,"all")) {
+      for (selected=0; selected<ALGORITHMS; selected++)
+        if (!strcmp(env,algorithm_name[selected])) break;
+      if (selected == ALGORITHMS) {
+        printf("ERROR: PRK_ALLREDUCE must be all, library, ring, doubling, ");
+        printf("or rabenseifner: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  if (my_ID == root) {
+    printf("Number of ranks      = %d\n", Num_procs);
+    printf("Vector sizes (bytes) = %ld to %ld\n", min_bytes, max_bytes);
+    printf("Number of iterations = %d\n", iterations);
+    printf("Algorithm            = %s\n", selected < 0 ? "all" : algorithm_name[selected]);
+  }
+
+  /* Broadcast benchmark data to all ranks */
+  MPI_Bcast(&iterations, 1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&min_bytes,  1, MPI_LONG, root, MPI_COMM_WORLD);
+  MPI_Bcast(&max_bytes,  1, MPI_LONG, root, MPI_COMM_WORLD);
+  MPI_Bcast(&selected,   1, MPI_INT,  root, MPI_COMM_WORLD);
+
+  count = max_bytes/sizeof(double);
+  in    = (double *) prk_malloc(3*count*sizeof(double)); 
+  if (in==NULL) {
+    printf("ERROR: Could not allocate space %ld for vectors in rank %d\n", 
+           3*count*sizeof(double),my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  out = in  + count;
+  tmp = out + count;
+
+  /* element i of the sum is (i%7+1) times the sum of the rank numbers + 1    */
+  for (i=0; i<count; i++) in[i] = (double)((my_ID+1)*(i%7+1));
+
+  if (my_ID == root) {
+    printf("%14s", "Bytes");
+    for (algorithm=0; algorithm<ALGORITHMS; algorithm++)
+      if (selected < 0 || selected == algorithm)
+        printf("  %12s", algorithm_name[algorithm]);
+    if (selected < 0) printf("  %13s", "library/best");
+    printf("\n%14s", "");
+    for (algorithm=0; algorithm<ALGORITHMS; algorithm++)
+      if (selected < 0 || selected == algorithm) printf("  %12s", "time (s)");
+    printf("\n");
+  }
+
+  for (bytes=min_bytes; bytes<=max_bytes; bytes*=2) {
+    count = bytes/sizeof(double);
+
+    for (algorithm=0; algorithm<ALGORITHMS; algorithm++) {
+      if (selected >= 0 && selected != algorithm) continue;
+
+      prk_harness_init(&harness[algorithm], "Allreduce", "MPI1", iterations);
+      prk_harness_param(&harness[algorithm], "ranks", "%d", Num_procs);
+      prk_harness_param(&harness[algorithm], "bytes", "%ld", bytes);
+      prk_harness_param(&harness[algorithm], "algorithm", "%s", algorithm_name[algorithm]);
+
+      for (i=0; i<count; i++) out[i] = 0.0;
+      for (iter=0; iter<=iterations; iter++) { 
+
+        /* start timer after a warmup iteration */
+        if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+        if (iter >= 1) prk_harness_tick(&harness[algorithm]);
+
+        switch (algorithm) {
+        case LIBRARY:
+          MPI_Allreduce(in, out, count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+          break;
+        case RING:
+          ring_allreduce(in, out, tmp, count, my_ID, Num_procs, MPI_COMM_WORLD);
+          break;
+        case DOUBLING:
+          doubling_allreduce(in, out, tmp, count, my_ID, Num_procs, MPI_COMM_WORLD);
+          break;
+        case RABENSEIFNER:
+          rabenseifner_allreduce(in, out, tmp, count, my_ID, Num_procs, MPI_COMM_WORLD);
+          break;
+        }
+      }
+
+      prk_harness_tick(&harness[algorithm]);
+      local_time = prk_harness_elapsed(&harness[algorithm]);
+      MPI_Reduce(&local_time, &avgtime[algorithm], 1, MPI_DOUBLE, MPI_MAX, root,
+                 MPI_COMM_WORLD);
+      avgtime[algorithm] /= iterations;
+
+      /* verify correctness on every rank                                    */
+      for (i=0; i<count; i++) {
+        element_value = (double)(i%7+1)*Num_procs*(Num_procs+1)/2;
+        if (out[i] != element_value) {
+          printf("ERROR: %s, %ld bytes, rank %d, i=%ld; value: %lf; reference value: %lf\n",
+                 algorithm_name[algorithm], bytes, my_ID, i, out[i], element_value);
+          error = 1;
+          break;
+        }
+      }
+      bail_out(error);
+
+      /* only the timings of the largest vectors are reported, see below     */
+      if (2*bytes <= max_bytes) prk_harness_finalize(&harness[algorithm]);
+    }
+
+    if (my_ID == root) {
+      printf("%14ld", bytes);
+      for (best=0.0, algorithm=0; algorithm<ALGORITHMS; algorithm++) {
+        if (selected >= 0 && selected != algorithm) continue;
+        printf("  %12.6e", avgtime[algorithm]);
+        if (algorithm != LIBRARY && (best == 0.0 || avgtime[algorithm] < best))
+          best = avgtime[algorithm];
+      }
+      if (selected < 0) printf("  %13.2lf", avgtime[LIBRARY]/best);
+      printf("\n");
+    }
+  }
+
+  if (my_ID == root) {
+    printf("Solution validates\n");
+    if (selected >= 0)
+      printf("Rate (MB/s): %lf  Avg time (s): %lf\n",
+             1.0E-06 * count*sizeof(double)/avgtime[selected], avgtime[selected]);
+  }
+
+  /* the report covers the largest vectors, reduced with the selected
+     algorithm or, if all were measured, with the library                   */
+  algorithm = selected >= 0 ? selected : LIBRARY;
+  prk_harness_report(&harness[algorithm], "MB/s", 1.0E-06 * count*sizeof(double));
+  for (algorithm=0; algorithm<ALGORITHMS; algorithm++)
+    if (selected < 0 || selected == algorithm) prk_harness_finalize(&harness[algorithm]);
+
+  MPI_Finalize();
+  exit(EXIT_SUCCESS);
+
+}  /* end of main */
@@ -0,0 +1,508 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    bfs
+
+PURPOSE: This program tests the efficiency with which a breadth-first
+         search of a large, irregular, distributed graph is carried out.
+         Unlike the other kernels, the communication is data dependent:
+         which ranks exchange how much data in a level of the search
+         follows from the graph.
+
+USAGE:   The program takes as input the number of searches, the 2log
+         of the number of vertices of the graph (the scale), and the
+         average number of edges per vertex (the edge factor).
+
+         <progname> <# searches> <scale> <edge factor>
+
+         The undirected graph is a Kronecker (R-MAT) graph with the
+         Graph 500 parameters A=0.57, B=0.19, C=0.19, generated from the
+         LCG of random_draw.c exactly as in the OpenMP kernel: edge e
+         uses draws e*scale through (e+1)*scale-1 of the stream, so every
+         rank generates a contiguous range of edges after a jump.  Vertex
+         v is owned by rank v%#ranks, which stores its adjacency list;
+         the generated edges are sent to the owners of their end points.
+         The generation is not timed.
+
+         Every search starts from a different root vertex with at least
+         one edge, and builds a BFS tree (parent of every vertex reached)
+         level by level, top down.  Each rank scans the adjacency lists of
+         its frontier vertices; neighbors it owns are claimed at once, the
+         others are sorted into one bucket per owner, as the updates in
+         the Random kernel, and the buckets are exchanged with a single
+         MPI_Alltoallv (preceded by an MPI_Alltoall of the bucket sizes).
+         A level ends with a global sum of the frontier sizes.
+
+         The output consists of diagnostics to make sure the algorithm
+         worked, and of timing statistics.  The rate is given in traversed
+         edges per second (TEPS): the number of input edges in the
+         component that was searched, divided by the search time.  The
+         tree of the last search is verified as in the OpenMP kernel; the
+         levels of the neighbors of every vertex are fetched from their
+         owners with the same bucket exchange.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following
+         functions are used in this program:
+
+          wtime()           Portable wall-timer interface.
+          bail_out()        Determine global error and exit if nonzero.
+          LCG_init(), LCG_next(), LCG_jump()
+          rmat_edge()       Next edge of the LCG stream.
+          scramble()        Pseudo-random relabeling of the vertices.
+          exchange_sizes()  All-to-all exchange of the bucket sizes.
+          exchange()        Timed all-to-all exchange of the buckets.
+          search()          Breadth-first search from a root.
+          prk_harness_*()   Per-iteration timing and results record.
+
+HISTORY: Written in October 2026, with the bucket exchange of the MPI1
+         Random kernel.
+
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+#include <random_draw.h>
+
+/* R-MAT quadrant probabilities; the fourth quadrant gets the remainder   */
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+
+#define OWNER(v)     ((int)((v)%Num_procs))
+#define LOCAL(v)     ((v)/Num_procs)
+#define GLOBAL(v)    ((v)*Num_procs+my_ID)
+#define DEGREE(v)    (first[(v)+1]-first[(v)])
+
+static int     Num_procs, my_ID;
+static int     scale;         /* 2log of the number of vertices           */
+static s64Int  nloc;          /* number of vertices owned by the rank     */
+static s64Int *first;         /* adjacency of local vertex v is
+                                 adj[first[v]..first[v+1]-1]              */
+static s64Int *adj;           /* neighbors (global labels)                */
+static s64Int *parent;        /* BFS tree, -1 for vertices not reached    */
+static s64Int *level;         /* distance of reached vertices from root   */
+static s64Int *queue,         /* local frontier vertices                  */
+              *next_queue;
+static s64Int *sendBucket,    /* buckets of (vertex, parent) pairs        */
+              *recvBucket;
+static int    *sizeSendBucket, *sizeRecvBucket, *senddispls, *recvdispls,
+              *fill;          /* fill pointers of the send buckets        */
+static prk_phase_t exchange_phase, count_phase;
+
+/* map a vertex label to a pseudo-random one; both multiplications by odd
+   numbers and the shift-xor are bijections on [0,2^scale)                */
+static s64Int scramble(s64Int v) {
+  u64Int x = (u64Int) v, mask = (((u64Int) 1)<<scale)-1;
+  x = (x*0x9E3779B97F4A7C15ULL) & mask;
+  x ^= x>>((scale+1)/2);
+  x = (x*0xBF58476D1CE4E5B9ULL) & mask;
+  return (s64Int) x;
+}
+
+/* next edge of the LCG stream: one quadrant per level of the adjacency
+   matrix, chosen with the high bits of the draw                          */
+static void rmat_edge(s64Int *u, s64Int *v) {
+  int    bit;
+  double r;
+  *u = *v = 0;
+  for (bit=0; bit<scale; bit++) {
+    r = (double)(LCG_next(UINT64_MAX)>>11) * 0x1.0p-53;
+    *u <<= 1; *v <<= 1;
+    if      (r >= RMAT_A+RMAT_B+RMAT_C) { *u |= 1; *v |= 1; }
+    else if (r >= RMAT_A+RMAT_B)          *u |= 1;
+    else if (r >= RMAT_A)                 *v |= 1;
+  }
+  *u = scramble(*u); *v = scramble(*v);
+}
+
+/* compute the bucket offsets from sizeSendBucket and reset the fill
+   pointers to them                                                       */
+static void bucket_offsets(void) {
+  int proc;
+  for (senddispls[0]=0, proc=1; proc<Num_procs; proc++)
+    senddispls[proc] = senddispls[proc-1]+sizeSendBucket[proc-1];
+  for (proc=0; proc<Num_procs; proc++) fill[proc] = senddispls[proc];
+}
+
+/* let all other ranks know how many elements to expect, and compute the
+   receive offsets; returns the number of elements to be received         */
+static s64Int exchange_sizes(void) {
+  int proc;
+  MPI_Alltoall(sizeSendBucket, 1, MPI_INT, sizeRecvBucket, 1, MPI_INT, MPI_COMM_WORLD);
+  for (recvdispls[0]=0, proc=1; proc<Num_procs; proc++)
+    recvdispls[proc] = recvdispls[proc-1]+sizeRecvBucket[proc-1];
+  return (s64Int) recvdispls[Num_procs-1]+sizeRecvBucket[Num_procs-1];
+}
+
+/* send the buckets of send to their ranks, and receive the buckets of all
+   ranks contiguously in recv; returns the number of received elements    */
+static s64Int exchange(s64Int *send, s64Int *recv) {
+  s64Int nrecv;
+  prk_phase_begin(&exchange_phase);
+  nrecv = exchange_sizes();
+  MPI_Alltoallv(send, sizeSendBucket, senddispls, MPI_LONG_LONG_INT,
+                recv, sizeRecvBucket, recvdispls, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+  prk_phase_end(&exchange_phase);
+  return nrecv;
+}
+
+/* breadth-first search from root; returns the number of adjacency
+   entries of the vertices reached, summed over all ranks                 */
+static s64Int search(s64Int root) {
+
+  s64Int qlen = 0, next_len, nf = 1, traversed = 0, i, e, u, w, v, nrecv, *tmp;
+  s64Int depth = 0;
+  int    proc;
+
+  for (v=0; v<nloc; v++) parent[v] = -1;
+  if (OWNER(root) == my_ID) {
+    v = LOCAL(root);
+    parent[v] = root; level[v] = 0;
+    queue[qlen++] = v;
+    traversed = DEGREE(v);
+  }
+
+  while (nf > 0) {
+    /* claim the local neighbors of the frontier, and size the buckets of
+       (neighbor, parent) pairs for the others                            */
+    next_len = 0;
+    for (proc=0; proc<Num_procs; proc++) sizeSendBucket[proc] = 0;
+    for (i=0; i<qlen; i++) {
+      u = queue[i];
+      for (e=first[u]; e<first[u+1]; e++) {
+        w = adj[e]; proc = OWNER(w);
+        if (proc != my_ID) sizeSendBucket[proc] += 2;
+        else if (parent[LOCAL(w)] < 0) {
+          v = LOCAL(w);
+          parent[v] = GLOBAL(u); level[v] = depth+1;
+          next_queue[next_len++] = v;
+          traversed += DEGREE(v);
+        }
+      }
+    }
+    bucket_offsets();
+    for (i=0; i<qlen; i++) {
+      u = queue[i];
+      for (e=first[u]; e<first[u+1]; e++) {
+        w = adj[e]; proc = OWNER(w);
+        if (proc == my_ID) continue;
+        sendBucket[fill[proc]++] = w;
+        sendBucket[fill[proc]++] = GLOBAL(u);
+      }
+    }
+
+    nrecv = exchange(sendBucket, recvBucket);
+
+    for (i=0; i<nrecv; i+=2) {
+      v = LOCAL(recvBucket[i]);
+      if (parent[v] >= 0) continue;
+      parent[v] = recvBucket[i+1]; level[v] = depth+1;
+      next_queue[next_len++] = v;
+      traversed += DEGREE(v);
+    }
+
+    tmp = queue; queue = next_queue; next_queue = tmp;
+    qlen = next_len;
+    depth++;
+    PRK_PHASE(&count_phase)
+      MPI_Allreduce(&qlen, &nf, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &traversed, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+  return traversed;
+}
+
+int main(int argc, char ** argv) {
+
+  int    iterations;          /* number of searches                       */
+  int    iter, proc;          /* dummies                                  */
+  int    edgefactor;          /* edges per vertex                         */
+  s64Int n;                   /* number of vertices                       */
+  s64Int m;                   /* number of generated edges                */
+  s64Int nadj;                /* number of local adjacency entries        */
+  s64Int nadj_total;          /* same, summed over all ranks              */
+  uint64_t start, end;        /* range of edges generated by the rank     */
+  s64Int mloc;                /* number of edges generated by the rank    */
+  s64Int e, i, u, v, w;       /* dummies                                  */
+  s64Int nrecv;               /* number of received bucket elements       */
+  s64Int *edges;              /* generated edges                          */
+  s64Int *root;               /* roots of the searches                    */
+  s64Int deg;                 /* degree of a candidate root               */
+  s64Int traversed;           /* adjacency entries reached by all searches */
+  s64Int errors;              /* violations of the BFS tree rules         */
+  s64Int lv, lw;              /* levels of a vertex and its neighbor      */
+  int    found;               /* nonzero if parent is a neighbor          */
+  s64Int *answer;             /* levels of the neighbors, in bucket order */
+  int    error = 0;           /* error flag                               */
+  double bfs_time, avgtime;   /* timing parameters                        */
+  prk_harness_t harness;      /* per-iteration timing                     */
+
+/*********************************************************************
+** Initialize the MPI environment
+*********************************************************************/
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+
+/*********************************************************************
+** process, test and broadcast input parameters
+*********************************************************************/
+  if (my_ID == 0) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPI breadth-first search\n");
+
+    if (argc != 4){
+      printf("Usage: %s <# searches> <scale> <edge factor>\n", *argv);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    iterations = atoi(*++argv);
+    if (iterations < 1){
+      printf("ERROR: Number of searches must be positive : %d \n",iterations);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    scale = atoi(*++argv);
+    if (scale < 1 || scale > 40) {
+      printf("ERROR: Scale must be between 1 and 40: %d\n", scale);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    edgefactor = atoi(*++argv);
+    if (edgefactor < 1) {
+      printf("ERROR: Edge factor must be positive: %d\n", edgefactor);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    printf("Number of ranks       = %16d\n", Num_procs);
+    printf("Number of vertices    = "FSTR64U"\n", ((s64Int) 1)<<scale);
+    printf("Number of edges       = "FSTR64U"\n", (((s64Int) 1)<<scale)*edgefactor);
+    printf("Number of searches    = %16d\n", iterations);
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  MPI_Bcast(&iterations, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  MPI_Bcast(&scale,      1, MPI_INT, 0, MPI_COMM_WORLD);
+  MPI_Bcast(&edgefactor, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  n    = ((s64Int) 1)<<scale;
+  m    = n*edgefactor;
+  nloc = (n-my_ID+Num_procs-1)/Num_procs;
+
+  sizeSendBucket = (int *) prk_malloc(5*Num_procs*sizeof(int));
+  root           = (s64Int *) prk_malloc(iterations*sizeof(s64Int));
+  if (!sizeSendBucket || !root) {
+    printf("ERROR: rank %d could not allocate bucket sizes\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  sizeRecvBucket = sizeSendBucket + Num_procs;
+  senddispls     = sizeRecvBucket + Num_procs;
+  recvdispls     = senddispls     + Num_procs;
+  fill           = recvdispls     + Num_procs;
+
+  prk_phase_init(&exchange_phase, "bucket exchange");
+  prk_phase_init(&count_phase,    "frontier count");
+
+  /* generate this rank's range of edges; self loops are dropped          */
+  LCG_get_chunk(&start, &end, my_ID, Num_procs, (uint64_t) m);
+  mloc  = (s64Int)(end+1-start);
+  edges = (s64Int *) prk_malloc((2*mloc+1)*sizeof(s64Int));
+  if (!edges) {
+    printf("ERROR: rank %d could not allocate space for edges\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  LCG_init();
+  LCG_jump(start*scale, UINT64_MAX);
+  for (e=0; e<mloc; e++) rmat_edge(&edges[2*e], &edges[2*e+1]);
+
+  /* send both directions of every edge to the owner of its first end    */
+  for (proc=0; proc<Num_procs; proc++) sizeSendBucket[proc] = 0;
+  for (e=0; e<mloc; e++) if (edges[2*e] != edges[2*e+1]) {
+    sizeSendBucket[OWNER(edges[2*e])]   += 2;
+    sizeSendBucket[OWNER(edges[2*e+1])] += 2;
+  }
+  bucket_offsets();
+  sendBucket = (s64Int *) prk_malloc((4*mloc+1)*sizeof(s64Int));
+  if (!sendBucket) {
+    printf("ERROR: rank %d could not allocate send buckets\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  for (e=0; e<mloc; e++) if (edges[2*e] != edges[2*e+1]) {
+    u = edges[2*e]; v = edges[2*e+1];
+    proc = OWNER(u); sendBucket[fill[proc]++] = u; sendBucket[fill[proc]++] = v;
+    proc = OWNER(v); sendBucket[fill[proc]++] = v; sendBucket[fill[proc]++] = u;
+  }
+  prk_free(edges);
+  nrecv = exchange_sizes();
+  recvBucket = (s64Int *) prk_malloc((nrecv+1)*sizeof(s64Int));
+  if (!recvBucket) {
+    printf("ERROR: rank %d could not allocate receive buckets\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  MPI_Alltoallv(sendBucket, sizeSendBucket, senddispls, MPI_LONG_LONG_INT,
+                recvBucket, sizeRecvBucket, recvdispls, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+  prk_free(sendBucket);
+
+  /* compressed adjacency lists of the local vertices                     */
+  nadj  = nrecv/2;
+  first = (s64Int *) prk_malloc((nloc+1 + nadj + 4*nloc + 1)*sizeof(s64Int));
+  if (!first) {
+    printf("ERROR: rank %d could not allocate space for graph\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  adj        = first + nloc+1;
+  parent     = adj + nadj;
+  level      = parent + nloc;
+  queue      = level + nloc;
+  next_queue = queue + nloc;
+  for (v=0; v<=nloc; v++) first[v] = 0;
+  for (i=0; i<nrecv; i+=2) first[LOCAL(recvBucket[i])+1]++;
+  for (v=0; v<nloc; v++) first[v+1] += first[v];
+  /* level holds the fill pointer of every list while the lists are built */
+  for (v=0; v<nloc; v++) level[v] = first[v];
+  for (i=0; i<nrecv; i+=2) adj[level[LOCAL(recvBucket[i])]++] = recvBucket[i+1];
+  prk_free(recvBucket);
+
+  /* a vertex receives at most one pair per adjacency entry of its own, as
+     the graph is undirected, so buckets of 2*nadj elements suffice       */
+  sendBucket = (s64Int *) prk_malloc((4*nadj+1)*sizeof(s64Int));
+  if (!sendBucket) {
+    printf("ERROR: rank %d could not allocate search buckets\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  recvBucket = sendBucket + 2*nadj;
+
+  /* roots are drawn from the stream following the edges, skipping
+     isolated vertices                                                    */
+  MPI_Allreduce(&nadj, &nadj_total, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+  LCG_init();
+  LCG_jump(m*scale, UINT64_MAX);
+  for (iter=0; iter<iterations; iter++) {
+    do {
+      v   = scramble((s64Int) LCG_next(n));
+      deg = OWNER(v) == my_ID ? DEGREE(LOCAL(v)) : 0;
+      MPI_Allreduce(MPI_IN_PLACE, &deg, 1, MPI_LONG_LONG_INT, MPI_MAX, MPI_COMM_WORLD);
+    } while (nadj_total > 0 && deg == 0);
+    root[iter] = v;
+  }
+
+  prk_harness_init(&harness, "BFS", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "scale", "%d", scale);
+  prk_harness_param(&harness, "edge_factor", "%d", edgefactor);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  for (traversed=0, iter=0; iter<iterations; iter++) {
+    prk_harness_tick(&harness);
+    traversed += search(root[iter]);
+  }
+  prk_harness_tick(&harness);
+  bfs_time = prk_harness_elapsed(&harness);
+  MPI_Allreduce(MPI_IN_PLACE, &bfs_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  /* verification test: rules of a BFS tree, for the last search; the
+     owners of all neighbors return their levels, in the order of the
+     requests                                                             */
+  for (proc=0; proc<Num_procs; proc++) sizeSendBucket[proc] = 0;
+  for (e=0; e<nadj; e++) sizeSendBucket[OWNER(adj[e])]++;
+  bucket_offsets();
+  for (e=0; e<nadj; e++) sendBucket[fill[OWNER(adj[e])]++] = adj[e];
+  nrecv = exchange_sizes();
+  MPI_Alltoallv(sendBucket, sizeSendBucket, senddispls, MPI_LONG_LONG_INT,
+                recvBucket, sizeRecvBucket, recvdispls, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+  for (i=0; i<nrecv; i++) {
+    v = LOCAL(recvBucket[i]);
+    recvBucket[i] = parent[v] < 0 ? -1 : level[v];
+  }
+  answer = sendBucket + nadj;
+  MPI_Alltoallv(recvBucket, sizeRecvBucket, recvdispls, MPI_LONG_LONG_INT,
+                answer,     sizeSendBucket, senddispls, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+
+  bucket_offsets();
+  for (errors=0, v=0; v<nloc; v++) {
+    lv = parent[v] < 0 ? -1 : level[v];
+    for (found=0, e=first[v]; e<first[v+1]; e++) {
+      w  = adj[e];
+      lw = answer[fill[OWNER(w)]++];
+      if (lv < 0) { if (lw >= 0) errors++; continue; }
+      if (lw < 0 || ABS(lw-lv) > 1) errors++;
+      if (w == parent[v] && lw == lv-1) found = 1;
+    }
+    if (lv < 0) continue;
+    if (GLOBAL(v) == root[iterations-1]) {
+      if (parent[v] != GLOBAL(v) || lv != 0) errors++;
+    }
+    else if (!found) errors++;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (my_ID == 0) {
+    if (errors) {
+      printf("ERROR: "FSTR64U" violations of the BFS tree rules\n", errors);
+      error = 1;
+    }
+    else {
+      printf("Solution validates\n");
+#if VERBOSE
+      printf("Edges traversed per search = %lf\n", 0.5*traversed/iterations);
+#endif
+    }
+    /* every undirected edge of the searched component appears twice in
+       the adjacency lists                                                */
+    avgtime = bfs_time/iterations;
+    printf("Rate (MTEPS): %lf  Avg time (s): %lf\n",
+           1.0E-06 * 0.5*traversed/bfs_time, avgtime);
+  }
+  prk_harness_report(&harness, "MTEPS", 1.0E-06 * 0.5*traversed/iterations);
+  prk_phase_report(&exchange_phase);
+  prk_phase_report(&count_phase);
+  prk_harness_finalize(&harness);
+
+  bail_out(error);
+
+  MPI_Finalize();
+  exit(EXIT_SUCCESS);
+}
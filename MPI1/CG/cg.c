@@ -0,0 +1,691 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*********************************************************************************
+
+NAME:    cg
+
+PURPOSE: This program tests the efficiency with which a sparse linear system
+         is solved by the conjugate gradient method.  Unlike the Sparse kernel,
+         every matrix-vector multiplication is followed by dot products whose
+         global sums the next step depends on, so the latency of the global
+         reduction is part of every iteration, as in the solvers of real
+         applications.
+  
+USAGE:   The program takes as input the number of conjugate gradient
+         iterations, the 2log of the linear size of the 2D grid (equalling the
+         2log of the square root of the order of the sparse matrix), and the
+         radius of the difference stencil.
+
+         <progname> <# iterations> <2log root-of-matrix-order> <radius>
+
+         The matrix has the sparsity pattern of the Sparse kernel, a periodic
+         star stencil on a (scrambled) grid, with the value 4*radius+1 on the
+         diagonal and -1 elsewhere.  The rows are scrambled like the columns,
+         so the matrix is symmetric positive definite, with eigenvalues
+         between 1 and 8*radius+1.  The right hand side is the product of the
+         matrix with a known solution, and the iterations start from zero.
+
+         The vector multiplied by the matrix is exchanged with the halo
+         exchange of the Sparse kernel (PRK_EXCHANGE=halo there).  The
+         variant of the method is selected at run time:
+           PRK_CG=classic    textbook CG; the matrix-vector product is fused
+                             with the dot product that follows it, the
+                             updates of the solution and the residual with
+                             the residual norm, and each of the two sums is
+                             a blocking MPI_Allreduce (default)
+           PRK_CG=pipelined  pipelined CG (Ghysels and Vanroose), with one
+                             MPI_Iallreduce of both dot products per
+                             iteration, overlapped with the halo exchange
+                             and the matrix-vector product; all vector
+                             updates and both dot products are one fused
+                             loop.  It requires MPI-3.
+         The time spent waiting for the global sums and in the halo
+         exchange is reported separately.  PRK_PROGRESS starts a progress
+         thread (see prk_progress.h), which lets the nonblocking sum advance
+         during the matrix-vector product.
+
+         The output consists of diagnostics to make sure the algorithm
+         worked, and of timing statistics.  The solution is correct if its
+         error in the norm defined by the matrix is within the classical
+         bound 2*((sqrt(k)-1)/(sqrt(k)+1))^iterations on the reduction of the
+         error by CG, with k the condition number of the matrix.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following 
+         functions are used in this program:
+
+         wtime()
+         bail_out()
+         reverse()
+         qsort()
+         compare
+         build_halo(), exchange_halo()
+         multiply(), multiply_dot()
+         prk_progress_*()
+         prk_harness_*()
+
+HISTORY: Written in October 2026, from the matrix generator and the
+         halo exchange of the MPI1 Sparse kernel.
+  
+***********************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+#include <prk_progress.h>
+
+/* linearize the grid index                                                       */
+#define LIN(i,j) (i+((j)<<lsize))
+
+/* if the scramble flag is set, convert all (linearized) grid indices by 
+   reversing their bits; if not, leave the grid indices alone                     */
+#if SCRAMBLE
+  #define REVERSE(a,b)  reverse((a),(b))
+#else
+  #define REVERSE(a,b) (a)
+#endif
+
+#define BITS_IN_BYTE 8
+
+/* known solution of the linear system                                            */
+#define SOLUTION(row) (1.0+(double)((row)%7))
+
+enum { CG_CLASSIC, CG_PIPELINED };
+static const char * cg_names[] = {"classic", "pipelined"};
+
+static u64Int reverse(register u64Int, int);
+static int compare(const void *el1, const void *el2);
+
+/* send and receive lists of the halo exchange                                    */
+typedef struct {
+  s64Int   nrows;        /* number of owned vector entries                        */
+  s64Int   nhalo;        /* number of vector entries received from other ranks    */
+  int      *recv_count,  /* entries received from each rank, stored after the     */
+           *recv_displ;  /* owned ones in the order of their global indices       */
+  int      *send_count,  /* entries sent to each rank, ...                        */
+           *send_displ;
+  s64Int   *send_index;  /* ... and their local indices                           */
+  double   *send_buffer;
+  MPI_Request *requests;
+} halo_t;
+
+static int    build_halo(s64Int, s64Int, s64Int, int, s64Int *, halo_t *);
+static void   exchange_halo(halo_t *, double *, int);
+static void   multiply(s64Int, int, double *, s64Int *, double *, double *);
+static double multiply_dot(s64Int, int, double *, s64Int *, double *, double *);
+
+int main(int argc, char **argv){
+
+  int               Num_procs;  /* Number of ranks                                */
+  int               my_ID;      /* MPI rank                                       */
+  int               root=0;
+  int               iter, r;    /* dummies                                        */
+  int               lsize;      /* logarithmic linear size of grid                */
+  int               lsize2;     /* logarithmic size of grid                       */
+  int               size;       /* linear size of grid                            */
+  s64Int            size2;      /* matrix order (=total # points in grid)         */
+  int               radius,     /* stencil parameters                             */
+                    stencil_size; 
+  s64Int            row, point; /* dummies                                        */
+  u64Int            i, j;       /* dummies                                        */
+  int               iterations; /* number of CG iterations                        */
+
+  s64Int            elm;        /* sequence number of matrix nonzero              */
+  s64Int            elm_start;  /* auxiliary variable                             */
+  s64Int            nrows,      /* number of rows owned by this rank ...          */
+                    row_offset; /* ... and the first of them                      */
+  s64Int            nent;       /* number of nonzero entries                      */
+  double            sparsity;   /* fraction of non-zeroes in matrix               */
+  double            cg_time,    /* timing parameters                              */
+                    avgtime;
+  double * RESTRICT matrix;     /* sparse matrix entries                          */
+  s64Int * RESTRICT colIndex;   /* column indices of sparse matrix entries        */
+  double * RESTRICT vectors;    /* space of all vectors below                     */
+  double * RESTRICT x;          /* approximate solution                           */
+  double * RESTRICT res;        /* residual b-A*x                                 */
+  double * RESTRICT p;          /* search direction                               */
+  double * RESTRICT q;          /* product of the matrix and p (classic) or w     */
+  double * RESTRICT w;          /* product of the matrix and res (pipelined)      */
+  double * RESTRICT z;          /* recurrences for the products of the matrix     */
+  double * RESTRICT s;          /* with s and p (pipelined)                       */
+  double            alpha, beta, /* CG coefficients                               */
+                    gamma, gamma_old, delta;
+  double            local[2],   /* local and global dot products                  */
+                    global[2];
+  double            norm0,      /* norm of the initial error in the matrix norm   */
+                    norm,       /* same for the final error                       */
+                    kappa,      /* bound on the condition number of the matrix    */
+                    rho,        /* bound on the error reduction per iteration     */
+                    bound;      /* bound on the error reduction                   */
+  double            epsilon = 1.e-8; /* error tolerance                           */
+  int               error=0;    /* error flag                                     */
+  size_t            vector_space, /* variables used to hold prk_malloc sizes      */
+                    matrix_space,
+                    index_space;
+  int               variant = CG_CLASSIC; /* CG variant                           */
+  halo_t            halo;       /* send and receive lists of the halo exchange    */
+  s64Int            nhalo_sum;  /* total number of halo entries of all ranks      */
+  char              *env;       /* value of PRK_CG                                */
+  double            flops,      /* modeled work of one iteration                  */
+                    bytes;
+#if MPI_VERSION >= 3
+  MPI_Request       request;    /* nonblocking global sum                         */
+#endif
+  prk_harness_t     harness;    /* per-iteration timing                           */
+  prk_phase_t       reduce,     /* time spent waiting for the global sums ...     */
+                    exchange;   /* ... and in the halo exchange                   */
+
+/*********************************************************************
+** Initialize the MPI environment
+*********************************************************************/
+  prk_progress_init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+
+/*********************************************************************
+** process, test and broadcast input parameters
+*********************************************************************/
+
+  if (my_ID == root){
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPI conjugate gradient solver\n");
+
+    if (argc != 4){
+      printf("Usage: %s <# iterations> <2log grid size> <stencil radius>\n",*argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    iterations = atoi(*++argv);
+    if (iterations < 1){
+      printf("ERROR: Iterations must be positive : %d \n", iterations);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    lsize = atoi(*++argv);
+    if (lsize <0) {
+      printf("ERROR: Log of grid size must be non-negative: %d\n", 
+           (int) lsize);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+    lsize2 = 2*lsize;
+    size = 1<<lsize;
+    if (size < Num_procs) {
+      printf("ERROR: Grid size %d must be at least equal to # procs %d\n",
+             (int) size, Num_procs);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    if ((int)(size%Num_procs)) {
+      printf("ERROR: Grid size %d must be multiple of # procs %d\n", 
+             (int) size, Num_procs);
+      error = 1;
+      goto ENDOFTESTS;
+    } 
+
+    /* compute number of points in the grid                                         */
+    size2 = size*size;
+
+    radius = atoi(*++argv);
+    if (radius <1) {
+      printf("ERROR: Stencil radius must be positive: %d\n", radius);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* emit error if (periodic) stencil overlaps with itself                        */
+    if (size <2*radius+1) {
+      printf("ERROR: Grid extent %d smaller than stencil diameter 2*%d+1= %d\n",
+             size, radius, radius*2+1);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+ 
+    env = getenv("PRK_CG");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"pipelined")) variant = CG_PIPELINED;
+      else if (strcmp(env,"classic")) {
+        printf("ERROR: PRK_CG must be classic or pipelined: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+#if MPI_VERSION < 3
+    if (variant == CG_PIPELINED) {
+      printf("ERROR: PRK_CG=pipelined requires MPI-3\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
+
+    /* sparsity follows from number of non-zeroes per row                           */
+    sparsity = (double)(4*radius+1)/(double)size2;
+
+    printf("Number of ranks       = %16d\n",Num_procs);
+    printf("Matrix order          = "FSTR64U"\n", size2);
+    printf("Stencil diameter      = %16d\n", 2*radius+1);
+    printf("Sparsity              = %16.10lf\n", sparsity);
+    printf("Number of iterations  = %16d\n", iterations);
+#if SCRAMBLE
+    printf("Indexing              = scrambled\n");
+#else
+    printf("Indexing              = canonical\n");
+#endif
+    printf("CG variant            = %s\n", cg_names[variant]);
+    printf("Progress thread       = %s\n", prk_progress_mode());
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  /* Broadcast benchmark data to all ranks */
+  MPI_Bcast(&lsize,      1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&lsize2,     1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&size,       1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&size2,      1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&radius,     1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&iterations, 1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&variant,    1, MPI_INT,           root, MPI_COMM_WORLD);
+
+  /* compute total size of star stencil in 2D                                     */
+  stencil_size = 4*radius+1;
+  /* compute number of rows owned by each rank                                    */
+  nrows = size2/Num_procs;
+  row_offset = nrows*my_ID;
+
+  /* compute total number of non-zeroes for this rank                             */
+  nent = nrows*stencil_size;
+
+  matrix_space = nent*sizeof(double);
+  matrix = (double *) prk_malloc(matrix_space);
+  if (!matrix) {
+    printf("ERROR: rank %d could not allocate space for sparse matrix: "FSTR64U"\n", 
+           my_ID, matrix_space);
+    error = 1;
+  } 
+  bail_out(error);
+
+  index_space = nent*sizeof(s64Int);
+  colIndex = (s64Int *) prk_malloc(index_space);
+  if (!colIndex) {
+    printf("ERROR: rank %d Could not allocate space for column indices: "FSTR64U"\n",
+           my_ID, nent*sizeof(s64Int));
+    error = 1;
+  } 
+  bail_out(error);
+
+  /* fill matrix with nonzeroes corresponding to difference stencil. Row "row" 
+     belongs to the grid point that the scrambling maps to it, so that rows and 
+     columns are reordered alike and the matrix stays symmetric                   */
+  for (row=row_offset; row<row_offset+nrows; row++) {
+    point = REVERSE(row,lsize2);
+    i = point%size; j = point>>lsize;
+    elm_start = (row-row_offset)*stencil_size;
+    elm = elm_start;
+    colIndex[elm] = REVERSE(LIN(i,j),lsize2);
+    for (r=1; r<=radius; r++, elm+=4) {
+      colIndex[elm+1] = REVERSE(LIN((i+r)%size,j),lsize2);
+      colIndex[elm+2] = REVERSE(LIN((i-r+size)%size,j),lsize2);
+      colIndex[elm+3] = REVERSE(LIN(i,(j+r)%size),lsize2);
+      colIndex[elm+4] = REVERSE(LIN(i,(j-r+size)%size),lsize2);
+    }
+    /* sort colIndex to make sure the compressed row accesses
+       vector elements in increasing order                                        */
+    qsort(&(colIndex[elm_start]), stencil_size, sizeof(s64Int), compare);
+    for (elm=elm_start; elm<elm_start+stencil_size; elm++) 
+      matrix[elm] = colIndex[elm] == row ? (double) stencil_size : -1.0;
+  }
+
+  /* the vectors multiplied by the matrix hold the owned entries and the halo,
+     and the column indices refer to them                                         */
+  error = build_halo(nrows, nent, row_offset, Num_procs, colIndex, &halo);
+  if (error) printf("ERROR: rank %d could not allocate space for halo lists\n", my_ID);
+  bail_out(error);
+  MPI_Reduce(&halo.nhalo, &nhalo_sum, 1, MPI_LONG_LONG_INT, MPI_SUM, root, 
+             MPI_COMM_WORLD);
+
+  vector_space = (2*(nrows+halo.nhalo) + 5*nrows)*sizeof(double);
+  vectors = (double *) prk_malloc(vector_space);
+  if (!vectors) {
+    printf("ERROR: rank %d could not allocate space for vectors: "FSTR64U"\n", 
+           my_ID, vector_space);
+    error = 1;
+  }
+  bail_out(error);
+  p = vectors;
+  w = p + nrows + halo.nhalo;
+  x = w + nrows + halo.nhalo;
+  res = x + nrows;
+  q = res + nrows;
+  z = q + nrows;
+  s = z + nrows;
+
+  /* right hand side b=A*x* in res; x*^T*A*x* is the initial error in the matrix
+     norm, since the iterations start from x=0                                    */
+  for (row=0; row<nrows; row++) p[row] = SOLUTION(row+row_offset);
+  exchange_halo(&halo, p, Num_procs);
+  local[0] = multiply_dot(nrows, stencil_size, matrix, colIndex, p, res);
+  MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  norm0 = sqrt(global[0]);
+
+  /* x=0, so the residual is b; p=res in classic CG, w=A*res in pipelined CG      */
+  for (row=0; row<nrows; row++) {
+    x[row] = z[row] = s[row] = 0.0;
+    p[row] = res[row];
+  }
+  if (variant == CG_PIPELINED) {
+    exchange_halo(&halo, p, Num_procs);
+    multiply(nrows, stencil_size, matrix, colIndex, p, w);
+    for (local[0]=local[1]=0.0, row=0; row<nrows; row++) {
+      p[row] = 0.0;
+      local[0] += res[row]*res[row];
+      local[1] += w[row]*res[row];
+    }
+  }
+  else {
+    for (local[0]=0.0, row=0; row<nrows; row++) local[0] += res[row]*res[row];
+    MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    gamma = global[0];
+  }
+  gamma_old = alpha = 1.0;
+
+  prk_harness_init(&harness, "CG", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%d", size);
+  prk_harness_param(&harness, "radius", "%d", radius);
+  prk_harness_param(&harness, "variant", "%s", cg_names[variant]);
+  prk_harness_param(&harness, "progress", "%s", prk_progress_mode());
+  prk_phase_init(&reduce,   "global sum");
+  prk_phase_init(&exchange, "halo exchange");
+
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  for (iter=0; iter<iterations; iter++) {
+
+    prk_harness_tick(&harness);
+
+    if (variant == CG_CLASSIC) {
+      PRK_PHASE(&exchange) exchange_halo(&halo, p, Num_procs);
+      local[0] = multiply_dot(nrows, stencil_size, matrix, colIndex, p, q);
+      PRK_PHASE(&reduce) 
+        MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      alpha = gamma > 0.0 ? gamma/global[0] : 0.0;
+
+      for (local[0]=0.0, row=0; row<nrows; row++) {
+        x[row]   += alpha*p[row];
+        res[row] -= alpha*q[row];
+        local[0] += res[row]*res[row];
+      }
+      PRK_PHASE(&reduce) 
+        MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      beta = gamma > 0.0 ? global[0]/gamma : 0.0;
+      gamma = global[0];
+
+      for (row=0; row<nrows; row++) p[row] = res[row] + beta*p[row];
+    }
+#if MPI_VERSION >= 3
+    else {
+      /* the global sums of res^T*res and w^T*res travel while q=A*w is computed  */
+      MPI_Iallreduce(local, global, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &request);
+      PRK_PHASE(&exchange) exchange_halo(&halo, w, Num_procs);
+      multiply(nrows, stencil_size, matrix, colIndex, w, q);
+      PRK_PHASE(&reduce) MPI_Wait(&request, MPI_STATUS_IGNORE);
+      gamma = global[0]; delta = global[1];
+      if (gamma == 0.0)   alpha = beta = 0.0;
+      else if (iter == 0) { beta = 0.0; alpha = gamma/delta; }
+      else {
+        beta  = gamma/gamma_old;
+        alpha = gamma/(delta - beta*gamma/alpha);
+      }
+      gamma_old = gamma;
+
+      for (local[0]=local[1]=0.0, row=0; row<nrows; row++) {
+        z[row]    = q[row]   + beta*z[row];
+        s[row]    = w[row]   + beta*s[row];
+        p[row]    = res[row] + beta*p[row];
+        x[row]   += alpha*p[row];
+        res[row] -= alpha*s[row];
+        w[row]   -= alpha*z[row];
+        local[0] += res[row]*res[row];
+        local[1] += w[row]*res[row];
+      }
+    }
+#endif
+  } /* end of iterations                                                          */
+
+  prk_harness_tick(&harness);
+  cg_time = prk_harness_elapsed(&harness);
+  MPI_Allreduce(MPI_IN_PLACE, &cg_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  /* verification test: error x-x* in the matrix norm, against the CG bound       */
+  for (row=0; row<nrows; row++) p[row] = x[row] - SOLUTION(row+row_offset);
+  exchange_halo(&halo, p, Num_procs);
+  local[0] = multiply_dot(nrows, stencil_size, matrix, colIndex, p, q);
+  MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  norm = sqrt(ABS(global[0]));
+
+  kappa = (double)(2*stencil_size-1);
+  rho   = (sqrt(kappa)-1.0)/(sqrt(kappa)+1.0);
+  bound = 2.0*pow(rho, iterations);
+
+  if (my_ID == root) {
+    if (!(norm <= (bound+epsilon)*norm0)) {
+      printf("ERROR: Relative error = %e, bound = %e\n", norm/norm0, bound);
+      error = 1;
+    }
+    else {
+      printf("Solution validates\n");
+#if VERBOSE
+      printf("Relative error = %e, bound = %e\n", norm/norm0, bound);
+#endif
+    }
+    avgtime = cg_time/iterations;
+  }
+
+  /* multiplication with a multiply-add per nonzero; classic CG adds two dot
+     products and three vector updates per row, pipelined CG two dot products
+     and six vector updates; every nonzero reads a value and an index, and
+     every row of the fused loops reads and writes the vectors once         */
+  if (variant == CG_CLASSIC) {
+    flops = 2.0*nent*Num_procs + 10.0*size2;
+    bytes = (sizeof(double)+sizeof(s64Int))*(double)nent*Num_procs +
+            sizeof(double)*13.0*size2;
+  }
+  else {
+    flops = 2.0*nent*Num_procs + 16.0*size2;
+    bytes = (sizeof(double)+sizeof(s64Int))*(double)nent*Num_procs +
+            sizeof(double)*15.0*size2;
+  }
+  if (my_ID == root) {
+    printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
+           1.0E-06 * flops/avgtime, avgtime);
+    printf("Halo entries per rank = %16.1lf\n", (double) nhalo_sum/Num_procs);
+  }
+  prk_harness_model(&harness, flops, bytes);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_phase_report(&reduce);
+  prk_phase_report(&exchange);
+  prk_harness_finalize(&harness);
+
+  bail_out(error);
+
+  prk_progress_finalize();
+  exit(EXIT_SUCCESS);
+}
+
+/* Code below reverses bits in unsigned integer stored in a 64-bit word.
+   Bit reversal is with respect to the largest integer that is going to be
+   ranked for the particular run of the code, to make sure the reversal
+   constitutes a true permutation. Hence, the final result needs to be shifted 
+   to the right (see the Sparse kernel for an example)                            */
+u64Int reverse(register u64Int x, int shift_in_bits){ 
+  x = ((x >> 1)  & 0x5555555555555555) | ((x << 1)  & 0xaaaaaaaaaaaaaaaa);
+  x = ((x >> 2)  & 0x3333333333333333) | ((x << 2)  & 0xcccccccccccccccc);
+  x = ((x >> 4)  & 0x0f0f0f0f0f0f0f0f) | ((x << 4)  & 0xf0f0f0f0f0f0f0f0);
+  x = ((x >> 8)  & 0x00ff00ff00ff00ff) | ((x << 8)  & 0xff00ff00ff00ff00);
+  x = ((x >> 16) & 0x0000ffff0000ffff) | ((x << 16) & 0xffff0000ffff0000);
+  x = ((x >> 32) & 0x00000000ffffffff) | ((x << 32) & 0xffffffff00000000);
+  return (x>>((sizeof(u64Int)*BITS_IN_BYTE-shift_in_bits)));
+}
+
+int compare(const void *el1, const void *el2) {
+  s64Int v1 = *(s64Int *)el1;  
+  s64Int v2 = *(s64Int *)el2;
+  return (v1<v2) ? -1 : (v1>v2) ? 1 : 0;
+}
+
+/* result=A*vector for the nrows local rows                                       */
+void multiply(s64Int nrows, int stencil_size, double *matrix, s64Int *colIndex,
+              double *vector, double *result) {
+  s64Int row, col, first, last;
+  double temp;
+
+  for (row=0; row<nrows; row++) {
+    first = stencil_size*row; last = first+stencil_size-1;
+    #pragma simd reduction(+:temp) 
+    for (temp=0.0,col=first; col<=last; col++) {
+      temp += matrix[col]*vector[colIndex[col]];
+    }
+    result[row] = temp;
+  }
+}
+
+/* result=A*vector, fused with the local part of vector^T*result                  */
+double multiply_dot(s64Int nrows, int stencil_size, double *matrix, s64Int *colIndex,
+                    double *vector, double *result) {
+  s64Int row, col, first, last;
+  double temp, dot = 0.0;
+
+  for (row=0; row<nrows; row++) {
+    first = stencil_size*row; last = first+stencil_size-1;
+    #pragma simd reduction(+:temp) 
+    for (temp=0.0,col=first; col<=last; col++) {
+      temp += matrix[col]*vector[colIndex[col]];
+    }
+    result[row] = temp;
+    dot += vector[row]*temp;
+  }
+  return dot;
+}
+/* Inspector of the halo exchange.  Find the distinct column indices of the
+   nent local nonzeroes outside the owned rows [row_offset,row_offset+nrows)
+   (rank p owns rows p*nrows to (p+1)*nrows-1), tell their owners which
+   entries to send, and renumber colIndex into a local vector that holds
+   the owned entries followed by the halo entries in increasing global
+   order.  It is collective; returns nonzero if space ran out            */
+int build_halo(s64Int nrows, s64Int nent, s64Int row_offset, int Num_procs,
+               s64Int *colIndex, halo_t *halo) {
+
+  s64Int *needed, *found, elm, n, nsend;
+  int    p, error;
+
+  halo->nrows      = nrows;
+  halo->recv_count = (int *) prk_malloc(4*Num_procs*sizeof(int));
+  halo->requests   = (MPI_Request *) prk_malloc(2*Num_procs*sizeof(MPI_Request));
+  needed           = (s64Int *) prk_malloc((nent+1)*sizeof(s64Int));
+  error = !halo->recv_count || !halo->requests || !needed;
+  MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if (error) return 1;
+  halo->recv_displ = halo->recv_count +   Num_procs;
+  halo->send_count = halo->recv_count + 2*Num_procs;
+  halo->send_displ = halo->recv_count + 3*Num_procs;
+
+  /* distinct column indices outside the owned rows, sorted                      */
+  for (n=0, elm=0; elm<nent; elm++) 
+    if (colIndex[elm] < row_offset || colIndex[elm] >= row_offset+nrows) 
+      needed[n++] = colIndex[elm];
+  qsort(needed, n, sizeof(s64Int), compare);
+  for (halo->nhalo=0, elm=0; elm<n; elm++)
+    if (!halo->nhalo || needed[elm] != needed[halo->nhalo-1])
+      needed[halo->nhalo++] = needed[elm];
+
+  /* entries are sorted, hence grouped by owner                                  */
+  for (p=0; p<Num_procs; p++) halo->recv_count[p] = 0;
+  for (elm=0; elm<halo->nhalo; elm++) halo->recv_count[needed[elm]/nrows]++;
+  MPI_Alltoall(halo->recv_count, 1, MPI_INT, halo->send_count, 1, MPI_INT,
+               MPI_COMM_WORLD);
+  for (nsend=0, p=0; p<Num_procs; p++) {
+    halo->recv_displ[p] = p ? halo->recv_displ[p-1]+halo->recv_count[p-1] : 0;
+    halo->send_displ[p] = nsend;
+    nsend += halo->send_count[p];
+  }
+
+  halo->send_index  = (s64Int *) prk_malloc((nsend+1)*sizeof(s64Int));
+  halo->send_buffer = (double *) prk_malloc((nsend+1)*sizeof(double));
+  error = !halo->send_index || !halo->send_buffer;
+  MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if (error) return 1;
+
+  MPI_Alltoallv(needed, halo->recv_count, halo->recv_displ, MPI_LONG_LONG_INT,
+                halo->send_index, halo->send_count, halo->send_displ, 
+                MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+  for (elm=0; elm<nsend; elm++) halo->send_index[elm] -= row_offset;
+
+  for (elm=0; elm<nent; elm++) {
+    if (colIndex[elm] >= row_offset && colIndex[elm] < row_offset+nrows) 
+      colIndex[elm] -= row_offset;
+    else {
+      found = (s64Int *) bsearch(&colIndex[elm], needed, halo->nhalo, 
+                                 sizeof(s64Int), compare);
+      colIndex[elm] = nrows + (found-needed);
+    }
+  }
+
+  prk_free(needed);
+  return 0;
+}
+
+/* Executor of the halo exchange: send the owned entries of vector that other
+   ranks need and receive the halo entries behind the owned ones         */
+void exchange_halo(halo_t *halo, double *vector, int Num_procs) {
+
+  s64Int elm, nsend = 0;
+  int    p, nreq = 0;
+
+  for (p=0; p<Num_procs; p++) if (halo->recv_count[p])
+    MPI_Irecv(vector+halo->nrows+halo->recv_displ[p], halo->recv_count[p], 
+              MPI_DOUBLE, p, 0, MPI_COMM_WORLD, &halo->requests[nreq++]);
+
+  for (p=0; p<Num_procs; p++) nsend += halo->send_count[p];
+  for (elm=0; elm<nsend; elm++) halo->send_buffer[elm] = vector[halo->send_index[elm]];
+
+  for (p=0; p<Num_procs; p++) if (halo->send_count[p])
+    MPI_Isend(halo->send_buffer+halo->send_displ[p], halo->send_count[p], 
+              MPI_DOUBLE, p, 0, MPI_COMM_WORLD, &halo->requests[nreq++]);
+
+  MPI_Waitall(nreq, halo->requests, MPI_STATUSES_IGNORE);
+}
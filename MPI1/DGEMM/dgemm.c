@@ -43,17 +43,65 @@ USAGE:   The program takes as input the matrix order, the number of times
          for the local dgemm.
 
          <progname> <# iterations> <matrix order> <block size> [<tile flag>]
+
+         The matrix order may also be given as a shape MxNxK, for the
+         product of an M x K matrix A and a K x N matrix B.  The rows of
+         A and C are divided over the rows of the rank grid, the columns
+         of B and C over its columns, and the inner dimension K over
+         both, so M must be at least the number of rows of the grid, N
+         the number of columns, and K both.
   
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         When built with CBLAS=1, the program afterwards repeats the
+         same iterations with the local block multiplications done by
+         cblas_dgemm of a vendor BLAS (OpenBLAS, BLIS, ...) instead of
+         dgemm_local's loops, validates that result against the same
+         checksum and reports its rate and the ratio of the two rates.
+         The communication is unchanged, so the ratio isolates the local
+         multiply.  PRK_BLAS=off skips the comparison at run time.
+
+         By default the panels of A and B are broadcast with a ring
+         along the rows and columns of the rank grid, after which the
+         local block is updated.  With PRK_SUMMA=lookahead the panels
+         alternate between two pairs of work arrays, and the nonblocking
+         broadcasts (MPI_Ibcast) of the next panel proceed while the
+         current one is multiplied.
+
+         PRK_SUMMA_LAYERS=c selects the 2.5D algorithm: the ranks form c
+         layers, each a rank grid of its own holding a full copy of A
+         and B.  Every layer does the updates for 1/c of the inner
+         dimension into a partial C, and the partial products are summed
+         into the C of layer 0 after each multiplication.  A layer's
+         broadcasts are c times shorter than with one grid of all ranks,
+         at the cost of c copies of the matrices and the reduction.  The
+         number of ranks must be a multiple of c.
+
+         PRK_DGEMM=tallskinny is meant for a tall and skinny A and C (K
+         and N small, M large): the rank grid is one column of all ranks
+         (of a layer), so that A and C are divided by strips of rows, B
+         is the only matrix that is broadcast, and the local blocks are
+         multiplied strip by strip with B in cache.
+
+         PRK_BATCH=b makes every rank multiply a batch of b independent
+         matrices of the given shape per iteration, with the local
+         multiplication and no communication (the "many small GEMMs"
+         case).  The rates are summed over all ranks.  It cannot be
+         combined with PRK_DGEMM=tallskinny or PRK_SUMMA_LAYERS.
+
 FUNCTIONS CALLED:
 
          Other than OpenMP or standard C functions, the following 
          functions are used in this program:
 
          wtime()
+         prk_topology_bind()
          bail_out()
+         prk_harness_*()
+         dgemm()          SUMMA multiplication of the distributed matrices
+         dgemm_local()    multiplication of local blocks
+         dgemm_batch()    batch of local multiplications
 
 NOTES:   Derived frmo SUMMA implementation provided by Robert Van de Geijn,
          U. Texas at Austion.
@@ -65,6 +113,12 @@ HISTORY: Written by Rob Van der Wijngaart, December 2007
 
 #include "par-res-kern_general.h"
 #include "par-res-kern_mpi.h"
+#include "prk_harness.h"
+#include "prk_topology.h"
+
+#if CBLAS
+  #include <cblas.h>
+#endif
 
 #define A(i,j) (a[(j)*lda+i])
 #define B(i,j) (b[(j)*ldb+i])
@@ -75,12 +129,20 @@ HISTORY: Written by Rob Van der Wijngaart, December 2007
 
 #define epsilon  0.00001
 
+/* rows in a strip of the tall and skinny local multiplication     */
+#ifndef TALL_ROWS
+  #define TALL_ROWS 256
+#endif
+
 void RING_Bcast(double *, int, MPI_Datatype, int, MPI_Comm);
 void dlacpy(int, int, double *, int, double *, int);
 void dgemm_local(int, int, int, double *, int, double *, int, 
-                 double *, int, int, int);
+                 double *, int, int, int, int, int);
 void dgemm(int, int, int, double *, int, double *, int, double *, int,
-                int *, int *, MPI_Comm, MPI_Comm, double *, double *);
+                int *, int *, int *, int *, MPI_Comm, MPI_Comm, double *,
+                double *, int, int, int, MPI_Comm, double *);
+void dgemm_batch(int, int, int, int, double *, long, double *, long,
+                 double *, long, int, int, int);
 
 
 int main(int argc, char *argv[])
@@ -89,13 +151,16 @@ int main(int argc, char *argv[])
       root=0,           /* ID of root rank                         */
       Num_procs,        /* number of ranks                         */
       nprow, npcol,     /* row, column dimensions of rank grid     */
-      order,            /* matrix order                            */
+      M, N, K,          /* C is M x N, A is M x K and B is K x N   */
+      square,           /* true if M, N and K are all equal        */
       mynrows, myfrow,  /* my number of rows and index of first row*/
-      mylrow,           /* and last row                            */
     /*myncols,*/ myfcol,/* my number of cols and index of first row*/
-      mylcol,           /* and last row                            */
       *mm,              /* arrays that hold m_i's and n_j's        */
       *nn,
+      *kr, *kc,         /* and the k's of the rows of B and of the 
+                           columns of A                            */
+      mykrows, mykcols, /* my numbers of rows of B and cols of A   */
+      myfkrow, myfkcol, /* and their first indices                 */
     /*nb,*/             /* block factor for SUMMA                  */
       inner_block_flag, /* flag to select local DGEMM blocking     */
       error=0,          /* error flag                              */
@@ -104,14 +169,15 @@ int main(int argc, char *argv[])
       i, j, ii, jj,     /* dummy variables                         */
       iter, iterations;
   long lda, ldb, ldc,
-       nb, myncols;     /* make long to avoid integer overflow     */
+       nb, myncols,     /* make long to avoid integer overflow     */
+       batch = 1;       /* number of local multiplications (batch) */
   double RESTRICT *a, *b, *c,    /* arrays that hold local a, b, c */
       *work1, *work2,   /* work arrays to pass to dpmmmult         */
       local_dgemm_time, /* timing parameters                       */
       dgemm_time,
       avgtime; 
   double
-      forder, nflops,   /* float matrix order + total flops        */
+      nflops,           /* total flops                             */
       checksum,         /* array checksum for verification test    */
       checksum_local=0.0,
       ref_checksum;     /* reference checkcum for verification     */
@@ -120,6 +186,17 @@ int main(int argc, char *argv[])
   MPI_Comm comm_row,    /* communicators for row and column ranks  */
       comm_col;         /* of rank grid                            */
   int shortcut;         /* true if only doing initialization       */
+  int use_blas = 0;     /* true if comparing with vendor BLAS      */
+  int tall = 0;         /* true if using the tall and skinny grid  */
+  int lookahead = 0,    /* true if overlapping panel broadcasts    */
+      layers = 1,       /* number of layers of 2.5D algorithm      */
+      layer_size,       /* number of ranks per layer               */
+      my_layer,         /* my layer and my rank within the layer   */
+      layer_ID;
+  MPI_Comm comm_layer;  /* same position in the different layers   */
+  double *cpart = NULL; /* partial C of a layer (2.5D)             */
+  char *env;            /* value of a PRK_* variable                */
+  prk_harness_t harness;/* per-iteration timing                    */
 
   /* initialize                                                    */
   MPI_Init(&argc,&argv);
@@ -135,7 +212,7 @@ int main(int argc, char *argv[])
     printf("MPI Dense matrix-matrix multiplication: C = A x B\n");
 
     if (argc != 5) {
-      printf("Usage: %s <# iterations> <matrix order> <outer block size> ",
+      printf("Usage: %s <# iterations> <matrix order or MxNxK> <outer block size> ",
                                                                *argv);
       printf("<local block flag (non-zero=yes, zero=no)>\n");
       error = 1;
@@ -149,13 +226,63 @@ int main(int argc, char *argv[])
       goto ENDOFTESTS;
     }
 
-    order = atoi(*++argv);
-    if (order < 0) {
-      shortcut = 1;
-      order    = -order;
-    } else shortcut = 0;
-    if (order < Num_procs) {
-      printf("ERROR: matrix order too small: %d\n", order);
+    env = getenv("PRK_SUMMA");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"lookahead")) lookahead = 1;
+      else if (strcmp(env,"ring")) {
+        printf("ERROR: PRK_SUMMA must be ring or lookahead: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    env = getenv("PRK_SUMMA_LAYERS");
+    if (env != NULL) layers = atoi(env);
+    if (layers < 1 || Num_procs%layers) {
+      printf("ERROR: PRK_SUMMA_LAYERS must divide the number of ranks: %s\n",
+             env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_DGEMM");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"tallskinny")) tall = 1;
+      else if (strcmp(env,"summa")) {
+        printf("ERROR: PRK_DGEMM must be summa or tallskinny: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    env = getenv("PRK_BATCH");
+    if (env != NULL && *env != '\0') {
+      batch = atol(env);
+      if (batch < 1) {
+        printf("ERROR: PRK_BATCH must be positive: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+      if (batch > 1 && (tall || layers > 1)) {
+        printf("ERROR: PRK_BATCH cannot be combined with PRK_DGEMM=tallskinny ");
+        printf("or PRK_SUMMA_LAYERS\n");
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    ++argv;
+    shortcut = 0;
+    if (sscanf(*argv, "%dx%dx%d", &M, &N, &K) != 3) {
+      M = atoi(*argv);
+      if (M < 0) {
+        shortcut = 1;
+        M        = -M;
+      }
+      N = K = M;
+    }
+    if (M < 1 || N < 1 || K < layers) {
+      printf("ERROR: matrix dimensions too small: %s\n", *argv);
       error = 1;
       goto ENDOFTESTS;
     }
@@ -164,42 +291,81 @@ int main(int argc, char *argv[])
     /* a non-positive tile size means no outer level tiling        */
 
     inner_block_flag = atoi(*++argv);
+
+#if CBLAS
+    env = getenv("PRK_BLAS");
+    use_blas = (env == NULL || strcmp(env,"off"));
+#endif
     
     ENDOFTESTS:;
   }
   bail_out(error);
 
-  MPI_Bcast(&order,            1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&M,                1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&N,                1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&K,                1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&batch,            1, MPI_LONG, root, MPI_COMM_WORLD);
+  MPI_Bcast(&tall,             1, MPI_INT,  root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations,       1, MPI_INT,  root, MPI_COMM_WORLD);
   MPI_Bcast(&nb,               1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&shortcut,         1, MPI_INT,  root, MPI_COMM_WORLD);
   MPI_Bcast(&inner_block_flag, 1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&use_blas,         1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&lookahead,        1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&layers,           1, MPI_INT,  root, MPI_COMM_WORLD);
+  prk_topology_bind();
+  square = (M == N && N == K);
 
   /* compute rank grid to most closely match a square; to do so,
      compute largest divisor of Num_procs, using hare-brained method. 
      The small term epsilon is used to guard against roundoff errors 
-     in case Num_procs is a perfect square                         */
-  nprow = (int) (sqrt((double) Num_procs + epsilon));
-  while (Num_procs%nprow) nprow--;
-  npcol = Num_procs/nprow;
+     in case Num_procs is a perfect square; with 2.5D, each layer 
+     has a grid of its own; the tall and skinny grid is a single
+     column                                                        */
+  layer_size = Num_procs/layers;
+  my_layer   = my_ID/layer_size;
+  layer_ID   = my_ID%layer_size;
+  nprow = (int) (sqrt((double) layer_size + epsilon));
+  while (layer_size%nprow) nprow--;
+  if (tall) nprow = layer_size;
+  npcol = layer_size/nprow;
+
+  if (batch == 1 && (M < nprow || N < npcol || K < MAX(nprow,npcol))) {
+    if (my_ID == root)
+      printf("ERROR: matrix dimensions %dx%dx%d too small for a %d x %d rank grid\n",
+             M, N, K, nprow, npcol);
+    error = 1;
+  }
+  bail_out(error);
 
   if (my_ID == root) {
     printf("Number of ranks      = %d\n", Num_procs);
-    printf("Rank grid            = %d rows x %d columns\n", nprow, npcol); 
-    printf("Matrix order         = %d\n", order);
+    if (batch > 1)
+      printf("Batch size           = %ld per rank, no communication\n", batch);
+    else {
+      printf("Rank grid            = %d rows x %d columns%s\n", nprow, npcol,
+             tall ? " (tall and skinny)" : ""); 
+      if (layers > 1)
+        printf("Layers (2.5D)        = %d\n", layers);
+      printf("Panel broadcast      = %s\n", lookahead ? "nonblocking, lookahead" : "ring");
+    }
+    if (square) printf("Matrix order         = %d\n", M);
+    else        printf("Matrix shape         = %dx%dx%d\n", M, N, K);
     printf("Outer block size     = %ld\n", nb);
     printf("Number of iterations = %d\n", iterations);
     if (inner_block_flag)
       printf("Using local dgemm blocking\n");
     else
       printf("No local dgemm blocking\n");
+    if (use_blas)
+      printf("Comparing with vendor BLAS (cblas_dgemm)\n");
     if (shortcut) 
       printf("Only doing initialization\n"); 
   }
 
   /* set up row and column communicators                           */
 
-  ranks = (int *) prk_malloc (3*Num_procs*sizeof(int));
+  ranks = (int *) prk_malloc (5*Num_procs*sizeof(int));
   if (!ranks) {
     printf("ERROR: Proc %d could not allocate rank work arrays\n",
            my_ID);
@@ -208,12 +374,14 @@ int main(int argc, char *argv[])
   bail_out(error);
   mm = ranks + Num_procs;
   nn = mm + Num_procs;
+  kr = nn + Num_procs;
+  kc = kr + Num_procs;
 
   /* 1. extract group of ranks that make up WORLD                  */
   MPI_Comm_group( MPI_COMM_WORLD, &world_group );
 
   /* 2. create list of all ranks in same row of rank grid          */
-  ranks[0] = my_ID/npcol * npcol;
+  ranks[0] = my_layer*layer_size + layer_ID/npcol * npcol;
   for (i=1; i<npcol; i++) ranks[i] = ranks[i-1] + 1;
 
   /* create row group and communicator                             */
@@ -221,44 +389,71 @@ int main(int argc, char *argv[])
   MPI_Comm_create( MPI_COMM_WORLD, temp_group, &comm_row );
 
   /* 3. create list of all ranks in same column of rank grid       */
-  ranks[0] = my_ID%npcol;
+  ranks[0] = my_layer*layer_size + layer_ID%npcol;
   for (i=1; i<nprow; i++) ranks[i] = ranks[i-1] + npcol;
 
   /* create column group and communicator                          */
   MPI_Group_incl( world_group, nprow, ranks, &temp_group );
   MPI_Comm_create( MPI_COMM_WORLD, temp_group, &comm_col );
 
+  /* 4. ranks at the same position of all layers                   */
+  MPI_Comm_split( MPI_COMM_WORLD, layer_ID, my_layer, &comm_layer );
+
   /* extract this node's row and column index                      */
   MPI_Comm_rank( comm_row, &mycol );
   MPI_Comm_rank( comm_col, &myrow );
 
   /* mynrows = number of rows assigned to me; distribute excess
-     rows evenly if nprow does not divide matrix order evenly      */
-  if (myrow < order%nprow) mynrows = (order/nprow)+1;
-  else                     mynrows = (order/nprow);
+     rows evenly if nprow does not divide M evenly; the same for
+     the rows of B (mykrows) over K                                */
+  if (myrow < M%nprow) mynrows = (M/nprow)+1;
+  else                 mynrows = (M/nprow);
+  if (myrow < K%nprow) mykrows = (K/nprow)+1;
+  else                 mykrows = (K/nprow);
 
-  /* make sure lda is a multiple of the block size nb              */
+  /* myncols = number of colums assigned to me; distribute excess
+     columns evenly if npcol does not divide N evenly; the same for
+     the columns of A (mykcols) over K                             */
+  if (mycol < N%npcol) myncols = (N/npcol)+1;
+  else                 myncols = (N/npcol);
+  if (mycol < K%npcol) mykcols = (K/npcol)+1;
+  else                 mykcols = (K/npcol);
+
+  /* with a batch, every rank holds whole matrices                 */
+  if (batch > 1) {
+    mynrows = M;  myncols = N;
+    mykrows = mykcols = K;
+  }
+
+  /* make sure lda and ldb are multiples of the block size nb      */
   if (mynrows%nb==0 || mynrows<nb) lda = mynrows;
   else                             lda = (mynrows/nb+1)*nb;
-
-  /* myncols = number of colums assigned to me; distribute excess
-     columns evenly if npcol does not divide order evenly          */
-  if (mycol < order%npcol) myncols = (order/npcol)+1;
-  else                     myncols = (order/npcol);
+  if (mykrows%nb==0 || mykrows<nb) ldb = mykrows;
+  else                             ldb = (mykrows/nb+1)*nb;
+  ldc = lda;
 
   /* get space for local blocks of A, B, C                         */
-  a = (double *) prk_malloc( lda*myncols*sizeof(double) );
-  b = (double *) prk_malloc( lda*myncols*sizeof(double) );
-  c = (double *) prk_malloc( lda*myncols*sizeof(double) );
+  a = (double *) prk_malloc( lda*mykcols*batch*sizeof(double) );
+  b = (double *) prk_malloc( ldb*myncols*batch*sizeof(double) );
+  c = (double *) prk_malloc( ldc*myncols*batch*sizeof(double) );
   if ( a == NULL || b == NULL || c == NULL ) {
     error = 1;
     printf("ERROR: Proc %d could not allocate a, b, and/or c\n",my_ID);
   }
   bail_out(error);
 
-  /* get space for two work arrays for dgemm                       */
-  work1 = (double *) prk_malloc( nb*lda*sizeof(double) );
-  work2 = (double *) prk_malloc( nb*myncols*sizeof(double) );
+  if (layers > 1) {
+    cpart = (double *) prk_malloc( ldc*myncols*sizeof(double) );
+    if (!cpart) {
+      error = 1;
+      printf("ERROR: Proc %d could not allocate partial c\n",my_ID);
+    }
+  }
+  bail_out(error);
+
+  /* get space for two work arrays for dgemm, double with lookahead */
+  work1 = (double *) prk_malloc( (lookahead+1)*nb*lda*sizeof(double) );
+  work2 = (double *) prk_malloc( (lookahead+1)*nb*myncols*sizeof(double) );
   if ( !work1 || !work2 ) {
     printf("ERROR: Proc %d could not allocate work buffers\n", my_ID);
     error = 1;
@@ -271,22 +466,28 @@ int main(int argc, char *argv[])
 
   /* myfrow = first row on my node                                 */
   for (myfrow=1,i=0; i<myrow; i++) myfrow += mm[i];
-  mylrow = myfrow+mynrows-1;
 
   /* collect array that holds myncols from all nodes in my column 
      of the rank grid (array of all n_j)                           */
   MPI_Allgather( &myncols, 1, MPI_INT, nn, 1, MPI_INT, comm_row );
   /* myfcol = first col on my node                                 */
   for (myfcol=1,i=0; i<mycol; i++) myfcol += nn[i];
-  mylcol = myfcol+myncols-1;
-
-  /* initialize matrices A, B, and C                               */
-  ldc = ldb = lda;
-  for (jj=0, j=myfcol; j<=mylcol; j++,jj++ ) 
-  for (ii=0, i=myfrow; i<=mylrow; i++, ii++ ) {
-    A(ii,jj) = (double) (j-1); 
-    B(ii,jj) = (double) (j-1); 
-    C(ii,jj) = 0.0;
+
+  /* the same for the rows of B and the columns of A               */
+  MPI_Allgather( &mykrows, 1, MPI_INT, kr, 1, MPI_INT, comm_col );
+  for (myfkrow=1,i=0; i<myrow; i++) myfkrow += kr[i];
+  MPI_Allgather( &mykcols, 1, MPI_INT, kc, 1, MPI_INT, comm_row );
+  for (myfkcol=1,i=0; i<mycol; i++) myfkcol += kc[i];
+  if (batch > 1) myfrow = myfcol = myfkrow = myfkcol = 1;
+
+  /* initialize matrices A, B, and C: column j of A and B is j, so
+     that the sum of C is M * K(K+1)/2 * N(N+1)/2; a batch is stored
+     as matrices with batch times as many columns                  */
+  for (jj=0; jj<mykcols*batch; jj++)
+  for (ii=0; ii<mynrows; ii++) A(ii,jj) = (double) (myfkcol + jj%mykcols);
+  for (jj=0; jj<myncols*batch; jj++) {
+    for (ii=0; ii<mykrows; ii++) B(ii,jj) = (double) (myfcol + jj%myncols);
+    for (ii=0; ii<mynrows; ii++) C(ii,jj) = 0.0;
   }
 
   if (shortcut) {
@@ -294,35 +495,56 @@ int main(int argc, char *argv[])
     exit(EXIT_SUCCESS);
   }
 
+  prk_harness_init(&harness, "DGEMM", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  if (square) prk_harness_param(&harness, "order", "%d", M);
+  else {
+    prk_harness_param(&harness, "m", "%d", M);
+    prk_harness_param(&harness, "n", "%d", N);
+    prk_harness_param(&harness, "k", "%d", K);
+  }
+  if (batch > 1) prk_harness_param(&harness, "batch", "%ld", batch);
+  prk_harness_param(&harness, "algorithm", "%s", batch > 1 ? "batch" :
+                    tall ? "tallskinny" : "summa");
+  prk_harness_param(&harness, "block", "%ld", nb);
+  prk_harness_param(&harness, "summa", "%s", lookahead ? "lookahead" : "ring");
+  prk_harness_param(&harness, "layers", "%d", layers);
+
   for (iter=0; iter<=iterations; iter++) {
 
-    /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_dgemm_time = wtime();
-    }
+    /* time every iteration after a warmup iteration */
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* actual matrix-vector multiply                               */
-    dgemm(order, nb, inner_block_flag, a, lda, b, lda, c, lda, 
-          mm, nn, comm_row, comm_col, work1, work2 );  
+    if (batch > 1)
+      dgemm_batch(batch, M, N, K, a, lda, b, ldb, c, ldc, nb,
+                  inner_block_flag, 0);
+    else
+      dgemm(K, nb, inner_block_flag, a, lda, b, ldb, c, ldc, 
+            mm, nn, kr, kc, comm_row, comm_col, work1, work2, 0, lookahead,
+            tall, comm_layer, cpart );  
 
   } /* end of iterations                                           */
 
-  local_dgemm_time = wtime() - local_dgemm_time;
+  prk_harness_tick(&harness);
+  local_dgemm_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_dgemm_time, &dgemm_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
-  /* verification test                                             */
-  for (jj=0, j=myfcol; j<=mylcol; j++, jj++) 
-  for (ii=0, i=myfrow; i<=mylrow; i++, ii++)
+  /* verification test; with 2.5D, C is complete on layer 0 only */
+  if (my_layer == 0)
+  for (jj=0; jj<myncols*batch; jj++) 
+  for (ii=0; ii<mynrows; ii++)
     checksum_local += C(ii,jj);
 
   MPI_Reduce(&checksum_local, &checksum, 1, MPI_DOUBLE, MPI_SUM, 
              root, MPI_COMM_WORLD);
  
-  forder = (double) order;
-  ref_checksum = (0.25*forder*forder*forder*(forder-1.0)*(forder-1.0));
+  ref_checksum = 0.25*M*(K*(K+1.0))*(N*(N+1.0));
   ref_checksum *= (iterations+1);
+  /* with a batch, every rank does batch whole multiplications     */
+  if (batch > 1) ref_checksum *= (double) batch*Num_procs;
 
   if (my_ID == root) { 
     if (ABS((checksum - ref_checksum)/ref_checksum) > epsilon) {
@@ -341,28 +563,92 @@ int main(int argc, char *argv[])
   bail_out(error);
 
   /* report elapsed time                                           */
-  nflops = 2.0*forder*forder*forder;
+  nflops = 2.0*M*N*(double) K;
+  if (batch > 1) nflops *= (double) batch*Num_procs;
   if ( my_ID == root ) {
       avgtime = dgemm_time/iterations;
       printf("Rate (MFlops/s): %lf Avg time (s): %lf\n",
              1.0E-06 * nflops/avgtime, avgtime);
   }
 
+  if (use_blas) {
+    double blas_time;
+
+    /* same iterations again, with the local multiply done by the library */
+    for (jj=0; jj<myncols*batch; jj++) for (ii=0; ii<mynrows; ii++) C(ii,jj) = 0.0;
+    for (iter=0; iter<=iterations; iter++) {
+      if (iter == 1) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        local_dgemm_time = wtime();
+      }
+      if (batch > 1)
+        dgemm_batch(batch, M, N, K, a, lda, b, ldb, c, ldc, nb,
+                    inner_block_flag, 1);
+      else
+        dgemm(K, nb, inner_block_flag, a, lda, b, ldb, c, ldc, 
+              mm, nn, kr, kc, comm_row, comm_col, work1, work2, 1, lookahead,
+              tall, comm_layer, cpart );  
+    }
+    local_dgemm_time = wtime() - local_dgemm_time;
+    MPI_Reduce(&local_dgemm_time, &blas_time, 1, MPI_DOUBLE, MPI_MAX, root,
+               MPI_COMM_WORLD);
+
+    checksum_local = 0.0;
+    if (my_layer == 0)
+    for (jj=0; jj<myncols*batch; jj++) for (ii=0; ii<mynrows; ii++)
+      checksum_local += C(ii,jj);
+    MPI_Reduce(&checksum_local, &checksum, 1, MPI_DOUBLE, MPI_SUM, 
+               root, MPI_COMM_WORLD);
+
+    if (my_ID == root) {
+      if (ABS((checksum - ref_checksum)/ref_checksum) > epsilon) {
+        printf("ERROR: vendor BLAS checksum = %lf, Reference checksum = %lf\n",
+               checksum, ref_checksum);
+        error = 1;
+      }
+      else {
+        blas_time /= iterations;
+        printf("Vendor BLAS solution validates\n");
+        printf("Vendor BLAS rate (MFlops/s): %lf Avg time (s): %lf\n",
+               1.0E-06 * nflops/blas_time, blas_time);
+        printf("Rate relative to vendor BLAS = %lf\n", blas_time/avgtime);
+        prk_harness_param(&harness, "blas_mflops", "%lf", 1.0E-06 * nflops/blas_time);
+        prk_harness_param(&harness, "blas_fraction", "%lf", blas_time/avgtime);
+      }
+    }
+    bail_out(error);
+  }
+
+  /* compulsory traffic: A and B read, C read and written once */
+  prk_harness_model(&harness, nflops, sizeof(double)*((double) M*K+(double) K*N+
+                    2.0*M*N)*(batch > 1 ? (double) batch*Num_procs : 1.0));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * nflops);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
 }
 
-void dgemm(k, nb, inner_block_flag, a, lda, b, ldb, c, ldc, mm, nn, 
-           comm_row, comm_col, work1, work2 )
-int    k,               /* global matrix dimensions                */
+void dgemm(k, nb, inner_block_flag, a, lda, b, ldb, c, ldc, mm, nn, kr, kc,
+           comm_row, comm_col, work1, work2, use_blas, lookahead, tall,
+           comm_layer, cpart )
+int    k,               /* global inner matrix dimension           */
        nb,              /* panel width                             */
        inner_block_flag,/* determines local dgemm blocking         */
+       use_blas,        /* local dgemm by vendor BLAS (CBLAS=1)    */
+       lookahead,       /* broadcast next panel during multiply    */
+       tall,            /* tall and skinny local multiply          */
        mm[], nn[],      /* dimensions of blocks of A, B, C         */
+       kr[], kc[],      /* rows of blocks of B, columns of A       */
        lda, ldb, ldc;   /* leading dimension of local arrays that 
                            hold local portions of matrices A, B, C */
 double RESTRICT *a, *b, *c,/* arrays holding local parts of A, B, C \*/
-       *work1, *work2;  /* work arrays                             */
+       *work1, *work2,  /* work arrays (two panels each with
+                           lookahead)                              */
+       *cpart;          /* partial C of this layer (2.5D), or NULL */
 MPI_Comm comm_row,      /* Communicator for this row of nodes      */
-       comm_col;        /* Communicator for this column of nodes   */
+       comm_col,        /* Communicator for this column of nodes   */
+       comm_layer;      /* Communicator for ranks holding the same
+                           blocks in the different layers (2.5D)   */
 {
   int myrow, mycol,     /* my  row and column index                */
       nprow, npcol,     /* number of node rows and columns         */
@@ -372,11 +658,31 @@ MPI_Comm comm_row,      /* Communicator for this row of nodes      */
       ii, jj;           /* local index (on currow and curcol, resp.)
                            of row and column for rank-updt update  */
   int my_ID;
+  int my_layer, layers, /* my layer and number of layers (2.5D)    */
+      klo, khi,         /* range of k of my layer's updates        */
+      slot, pupdt;      /* panel buffer and width being multiplied */
+  double *w1[2], *w2[2];/* panel buffers for lookahead             */
+  double *cc;           /* block of C that is updated             */
+  MPI_Request req[4];   /* broadcasts of both panel buffers        */
 
   /* get row, column, and global MPI rank                          */
   MPI_Comm_rank(comm_row, &mycol);  
   MPI_Comm_rank(comm_col, &myrow);
   MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_rank(comm_layer, &my_layer);
+  MPI_Comm_size(comm_layer, &layers);
+
+  /* with 2.5D, each layer does the updates for one slice of k
+     into a zeroed partial C, and the slices are summed into the C
+     of layer 0                                                    */
+  klo = (int) (((long) k*my_layer)/layers);
+  khi = (int) (((long) k*(my_layer+1))/layers);
+  if (cpart) {
+    for (j=0; j<nn[mycol]; j++) for (i=0; i<mm[myrow]; i++) 
+      cpart[j*(long)ldc+i] = 0.0;
+    cc = cpart;
+  }
+  else cc = c;
 
   /* This routine does a rank "updt" update of the matrix block
      owned by the calling rank. This requires updt whole columns
@@ -391,44 +697,132 @@ MPI_Comm comm_row,      /* Communicator for this row of nodes      */
      has been exhausted, we move to the next row or column (increment
      currow or curcol) and reset ii or jj to zero                  */
 
-  currow = curcol = ii = jj = 0;
+  /* start at the rank grid row and column that hold index klo     */
+  for (curcol=0, kk=0; kk+kc[curcol]<=klo; kk+=kc[curcol], curcol++);
+  jj = klo-kk;
+  for (currow=0, kk=0; kk+kr[currow]<=klo; kk+=kr[currow], currow++);
+  ii = klo-kk;
   updt = nb;
 
-  for ( kk=0; kk<k; kk+=updt) {
-    updt = MIN(updt,mm[currow]-ii);
-    updt = MIN(updt,nn[curcol]-jj);
+  if (!lookahead) {
+    for ( kk=klo; kk<khi; kk+=updt) {
+      updt = MIN(updt,kr[currow]-ii);
+      updt = MIN(updt,kc[curcol]-jj);
+      updt = MIN(updt,khi-kk);
+
+      /* pack current "updt" columns of A into work1               */
+      if ( mycol == curcol ) 
+         dlacpy(mm[myrow], updt, &A(0,jj), lda, work1, mm[myrow]);
 
-    /* pack current "updt" columns of A into work1                 */
-    if ( mycol == curcol ) 
-       dlacpy(mm[myrow], updt, &A(0,jj), lda, work1, mm[myrow]);
+      /* pack current "updt" rows of B into work2                  */
+      if ( myrow == currow ) 
+         dlacpy(updt, nn[mycol], &B(ii,0), ldb, work2, updt );
 
-    /* pack current "updt" rows of B into work2                    */
-    if ( myrow == currow ) 
-       dlacpy(updt, nn[mycol], &B(ii,0), ldb, work2, updt );
+      /* broadcast work1 and work2                                 */
+      RING_Bcast(work1, mm[myrow]*updt, MPI_DOUBLE, curcol, comm_row); 
+      RING_Bcast(work2, nn[mycol]*updt, MPI_DOUBLE, currow, comm_col); 
 
-    /* broadcast work1 and work2                                   */
-    RING_Bcast(work1, mm[myrow]*updt, MPI_DOUBLE, curcol, comm_row); 
-    RING_Bcast(work2, nn[mycol]*updt, MPI_DOUBLE, currow, comm_col); 
+      /* update local block                                        */
+      dgemm_local(mm[myrow], nn[mycol], updt, work1, mm[myrow], 
+            work2, updt, cc, ldc, nb, inner_block_flag, use_blas, tall);
 
-    /* update local block                                          */
-    dgemm_local(mm[myrow], nn[mycol], updt, work1, mm[myrow], 
-          work2, updt, c, ldc, nb, inner_block_flag);
+      /* update curcol, currow, ii, jj                             */
+      ii += updt;           jj += updt;
+      if (jj>=kc[curcol]) {curcol++; jj = 0;};
+      if (ii>=kr[currow]) {currow++; ii = 0;};
+    }
+  }
+  else {
+    /* the panels alternate between two pairs of buffers: while one
+       pair is multiplied, the nonblocking broadcasts of the next
+       panel proceed in the other                                  */
+    w1[0] = work1; w1[1] = work1 + (long)mm[myrow]*nb;
+    w2[0] = work2; w2[1] = work2 + (long)nn[mycol]*nb;
+    slot  = 0;
+    kk    = klo;
+    if (kk < khi) {
+      updt = MIN(updt,kr[currow]-ii);
+      updt = MIN(updt,kc[curcol]-jj);
+      updt = MIN(updt,khi-kk);
+      if ( mycol == curcol ) 
+         dlacpy(mm[myrow], updt, &A(0,jj), lda, w1[0], mm[myrow]);
+      if ( myrow == currow ) 
+         dlacpy(updt, nn[mycol], &B(ii,0), ldb, w2[0], updt );
+      MPI_Ibcast(w1[0], mm[myrow]*updt, MPI_DOUBLE, curcol, comm_row, &req[0]);
+      MPI_Ibcast(w2[0], nn[mycol]*updt, MPI_DOUBLE, currow, comm_col, &req[1]);
+    }
+    while (kk < khi) {
+      pupdt = updt;
+
+      /* advance to the next panel and start its broadcasts        */
+      kk += updt;
+      ii += updt;           jj += updt;
+      if (jj>=kc[curcol]) {curcol++; jj = 0;};
+      if (ii>=kr[currow]) {currow++; ii = 0;};
+      if (kk < khi) {
+        updt = MIN(updt,kr[currow]-ii);
+        updt = MIN(updt,kc[curcol]-jj);
+        updt = MIN(updt,khi-kk);
+        if ( mycol == curcol ) 
+           dlacpy(mm[myrow], updt, &A(0,jj), lda, w1[1-slot], mm[myrow]);
+        if ( myrow == currow ) 
+           dlacpy(updt, nn[mycol], &B(ii,0), ldb, w2[1-slot], updt );
+        MPI_Ibcast(w1[1-slot], mm[myrow]*updt, MPI_DOUBLE, curcol, comm_row,
+                   &req[2*(1-slot)]);
+        MPI_Ibcast(w2[1-slot], nn[mycol]*updt, MPI_DOUBLE, currow, comm_col,
+                   &req[2*(1-slot)+1]);
+      }
 
-    /* update curcol, currow, ii, jj                             */
-    ii += updt;           jj += updt;
-    if (jj>=nn[curcol]) {curcol++; jj = 0;};
-    if (ii>=mm[currow]) {currow++; ii = 0;};
+      /* finish the current panel and update local block           */
+      MPI_Waitall(2, &req[2*slot], MPI_STATUSES_IGNORE);
+      dgemm_local(mm[myrow], nn[mycol], pupdt, w1[slot], mm[myrow], 
+            w2[slot], pupdt, cc, ldc, nb, inner_block_flag, use_blas, tall);
+      slot = 1-slot;
+    }
+  }
+
+  if (cpart) {
+    /* sum the partial products of all layers into layer 0         */
+    if (my_layer == 0) {
+      MPI_Reduce(MPI_IN_PLACE, cpart, (int) (ldc*(long)nn[mycol]), MPI_DOUBLE,
+                 MPI_SUM, 0, comm_layer);
+      for (j=0; j<nn[mycol]; j++) for (i=0; i<mm[myrow]; i++) 
+        C(i,j) += cpart[j*(long)ldc+i];
+    }
+    else 
+      MPI_Reduce(cpart, NULL, (int) (ldc*(long)nn[mycol]), MPI_DOUBLE,
+                 MPI_SUM, 0, comm_layer);
   }
 }
 
 void dgemm_local(int M, int N, int K, double *a, int lda, double *b,
-           int ldb, double *c, int ldc, int nb, int inner_block_flag) {
+           int ldb, double *c, int ldc, int nb, int inner_block_flag,
+           int use_blas, int tall) {
 
   int m, n, k, mg, ng, kg, mm, nn, kk;
   long ldaa, ldbb, ldcc;
-  double *aa, *bb, *cc;
+  double *aa, *bb, *cc, bkn;
 
-  if (nb >= MAX(M,MAX(N,K)) || !inner_block_flag) {
+#if CBLAS
+  if (use_blas) {
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, M, N, K,
+                1.0, a, lda, b, ldb, 1.0, c, ldc);
+    return;
+  }
+#endif
+
+  if (tall) {
+    /* strips of rows of A and C, multiplied by all of B, which
+       stays in cache, with the rows innermost                     */
+    for (mm=0; mm<M; mm+=TALL_ROWS)
+    for (n=0; n<N; n++)
+    for (k=0; k<K; k++) {
+      bkn = B(k,n);
+      for (m=mm; m<MIN(mm+TALL_ROWS,M); m++)
+        C(m,n) += A(m,k)*bkn;
+    }
+  }
+  else if (nb >= MAX(M,MAX(N,K)) || !inner_block_flag) {
     for (m=0; m<M; m++) 
     for (n=0; n<N; n++)
     for (k=0; k<K; k++)
@@ -480,6 +874,19 @@ void dgemm_local(int M, int N, int K, double *a, int lda, double *b,
   return;
 }
 
+/* batch independent multiplications of local matrices, stored one
+   after the other in a, b and c                                   */
+void dgemm_batch(int batch, int M, int N, int K, double *a, long lda,
+                 double *b, long ldb, double *c, long ldc, int nb,
+                 int inner_block_flag, int use_blas) {
+
+  int i;
+
+  for (i=0; i<batch; i++)
+    dgemm_local(M, N, K, a+i*lda*K, (int) lda, b+i*ldb*N, (int) ldb,
+                c+i*ldc*N, (int) ldc, nb, inner_block_flag, use_blas, 0);
+}
+
 void dlacpy(int m, int n, double *a, int lda, double *b, int ldb ) {
 
   int i, j;
@@ -0,0 +1,439 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    fft
+
+PURPOSE: This program tests the efficiency with which the discrete
+         Fourier transform of a complex vector that is distributed
+         among the ranks can be computed.  It combines the block
+         exchange of the Transpose kernel with local FFTs into a
+         communication-bound spectral computation.
+
+USAGE:   Program inputs are the number of times the transform is
+         computed and the 2log of the length N of the vector, which
+         must be even
+
+         fft <# iterations> <2log vector length>
+
+         The vector is viewed as a square matrix of order M=sqrt(N),
+         stored by columns, and transformed with the six-step algorithm:
+         the matrix is transposed, its columns are transformed (M FFTs
+         of length M), multiplied by the twiddle factors, transposed,
+         transformed again, and transposed back, which leaves the result
+         in the natural order and distribution.  Every rank owns M/#ranks
+         columns, as in the Transpose kernel, so M must be a multiple of
+         the number of ranks.
+
+         Each of the three transposes sends one block to every other
+         rank, packed so that it is stored with unit stride on arrival.
+         With PRK_FFT_BATCHES=b (b > 1) the local columns are transformed
+         in b batches, and the blocks of a batch are sent as soon as they
+         are transformed, so that the exchange of one batch overlaps the
+         FFTs of the next; received blocks are stored in the order of
+         arrival.  The default, b=1, transforms all columns before any
+         block is sent.
+
+         The local FFTs are an iterative radix-4 (radix-2^2) kernel, with
+         a radix-2 stage for odd 2log M; built with FFTWTOP set in
+         make.defs, they are batched FFTW transforms instead.
+
+         With PRK_PROGRESS=1|spare|cpu:<k> a helper thread polls the MPI
+         library while the rank computes, so that messages progress
+         asynchronously (see prk_progress.h).
+
+         The output consists of diagnostics to make sure the transform
+         worked and of timing statistics.  The input is a sum of four
+         complex exponentials, whose transform is known exactly.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following
+         functions are used in this program:
+
+          wtime()           Portable wall-timer interface.
+          prk_progress_*()  Optional asynchronous progress thread.
+          bail_out()        Determine global error and exit if nonzero.
+          prk_harness_*()   Per-iteration timing and results record.
+          fft_columns()     FFTs of a batch of local columns.
+          transpose()       Distributed transpose, optionally preceded
+                            by the FFTs of the columns.
+
+HISTORY: Written in October 2026, with the column-block layout and the
+         block exchange of the MPI1 Transpose kernel.
+
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+#include <prk_progress.h>
+#include <complex.h>
+#ifdef PRK_FFTW
+  #include <fftw3.h>
+#endif
+
+typedef double complex cplx;
+
+/* M_PI is not defined in strict C99 */
+#ifdef M_PI
+#define PRK_M_PI M_PI
+#else
+#define PRK_M_PI 3.14159265358979323846264338327950288419716939937510
+#endif
+
+/* frequencies of the input, as fractions of N, and their amplitudes         */
+#define NMODES 4
+
+static int    Num_procs, my_ID;
+static int    M, logM;            /* order of the matrix and its 2log          */
+static int    width;              /* columns owned by a rank                    */
+static int    batches;            /* batches of columns per transpose          */
+static int    *rev;               /* bit reversal permutation of 0..M-1        */
+static cplx   *w;                 /* W_M^j = exp(-2 pi i j/M), j < M/2         */
+static cplx   *tw;                /* six-step twiddle factors of the local rows */
+static cplx   *send_buf, *recv_buf;
+static MPI_Request *send_req, *recv_req;
+static prk_phase_t fft_phase, pack_phase, wait_phase;
+#ifdef PRK_FFTW
+static fftw_plan plan;            /* FFTs of a batch of columns                 */
+#endif
+
+/* in-place forward FFT of length M of the contiguous vector x               */
+static void fft_column(cplx *x) {
+
+  int  i, j, g, h, s1, s2;
+  cplx t, a, b, c, d, w1, w2, w3;
+
+  for (i=0; i<M; i++) {
+    j = rev[i];
+    if (i < j) { t = x[i]; x[i] = x[j]; x[j] = t; }
+  }
+  h = 1;
+  if (logM%2) {
+    for (g=0; g<M; g+=2) {
+      t = x[g+1]; x[g+1] = x[g]-t; x[g] += t;
+    }
+    h = 2;
+  }
+  /* two radix-2 stages, of span h and 2h, in one pass over the vector       */
+  for (; h<M; h*=4) {
+    s1 = M/(2*h); s2 = M/(4*h);
+    for (g=0; g<M; g+=4*h) for (j=0; j<h; j++) {
+      w1 = w[j*s1]; w2 = w[j*s2]; w3 = -I*w2;
+      a = x[g+j];     b = w1*x[g+j+h];
+      c = x[g+j+2*h]; d = w1*x[g+j+3*h];
+      x[g+j]     = (a+b) + w2*(c+d);
+      x[g+j+2*h] = (a+b) - w2*(c+d);
+      x[g+j+h]   = (a-b) + w3*(c-d);
+      x[g+j+3*h] = (a-b) - w3*(c-d);
+    }
+  }
+}
+
+/* FFTs of the local columns [first,first+count) of a, followed by the
+   multiplication with the twiddle factors if twiddle is set                 */
+static void fft_columns(cplx *a, int first, int count, int twiddle) {
+
+  int  col;
+  long k;
+
+  prk_phase_begin(&fft_phase);
+#ifdef PRK_FFTW
+  fftw_execute_dft(plan, (fftw_complex *) (a+(long)first*M),
+                         (fftw_complex *) (a+(long)first*M));
+#else
+  for (col=first; col<first+count; col++) fft_column(a+(long)col*M);
+#endif
+  if (twiddle)
+    for (k=(long)first*M; k<(long)(first+count)*M; k++) a[k] *= tw[k];
+  prk_phase_end(&fft_phase);
+}
+
+/* Distributed transpose of the M x M matrix whose local columns are in src
+   into dst.  The local columns are processed in batches; with fft set the
+   columns of a batch are transformed first (see fft_columns), and the blocks
+   of a batch are sent before the next batch is transformed.  The block for
+   rank q holds the rows of q's columns of dst, stored so that each row of the
+   batch is a contiguous run of dst on arrival                                */
+static void transpose(cplx *src, cplx *dst, int fft, int twiddle) {
+
+  int  b, q, p, col, row, cb = width/batches, len = width*cb, idx, nrecv = 0;
+  cplx *buf, *blk;
+  MPI_Status status;
+
+  for (p=0; p<Num_procs; p++) if (p != my_ID) for (b=0; b<batches; b++) {
+    MPI_Irecv(recv_buf+(long)(p*batches+b)*len, 2*len, MPI_DOUBLE, p, b,
+              MPI_COMM_WORLD, &recv_req[nrecv++]);
+  }
+
+  for (b=0; b<batches; b++) {
+    if (fft) fft_columns(src, b*cb, cb, twiddle);
+    prk_phase_begin(&pack_phase);
+    for (q=0; q<Num_procs; q++) {
+      buf = send_buf + (long)(q*batches+b)*len;
+      for (col=0; col<cb; col++) {
+        cplx *s = src + (long)(b*cb+col)*M + q*width;
+        for (row=0; row<width; row++) buf[row*cb+col] = s[row];
+      }
+      if (q == my_ID) {
+        for (row=0; row<width; row++)
+          memcpy(dst+(long)row*M+my_ID*width+b*cb, buf+row*cb, cb*sizeof(cplx));
+        send_req[q*batches+b] = MPI_REQUEST_NULL;
+      }
+      else MPI_Isend(buf, 2*len, MPI_DOUBLE, q, b, MPI_COMM_WORLD,
+                     &send_req[q*batches+b]);
+    }
+    prk_phase_end(&pack_phase);
+  }
+
+  /* store the blocks in the order in which they arrive                       */
+  for (; nrecv>0; nrecv--) {
+    prk_phase_begin(&wait_phase);
+    MPI_Waitany((Num_procs-1)*batches, recv_req, &idx, &status);
+    prk_phase_end(&wait_phase);
+    p = status.MPI_SOURCE; b = status.MPI_TAG;
+    blk = recv_buf + (long)(p*batches+b)*len;
+    for (row=0; row<width; row++)
+      memcpy(dst+(long)row*M+p*width+b*cb, blk+row*cb, cb*sizeof(cplx));
+  }
+  prk_phase_begin(&wait_phase);
+  MPI_Waitall(Num_procs*batches, send_req, MPI_STATUSES_IGNORE);
+  prk_phase_end(&wait_phase);
+}
+
+int main(int argc, char ** argv) {
+
+  long   N;                   /* length of the vector                         */
+  long   local;               /* entries of the vector owned by a rank        */
+  int    logN;                /* 2log of N                                    */
+  int    iterations;          /* number of transforms                         */
+  int    iter, i, j, m;       /* dummies                                      */
+  long   k, kg, r, c;         /* dummies                                      */
+  int    root = 0;
+  int    error = 0;           /* error flag                                   */
+  char   *env;                /* value of PRK_FFT_BATCHES                     */
+  cplx   *x, *a, *b, *out;    /* input, work arrays and result                */
+  cplx   expected;            /* exact transform                              */
+  double err, max_err;        /* largest deviation from it                    */
+  double epsilon = 1.e-9;     /* error tolerance, relative to N               */
+  double fft_time, avgtime;   /* timing parameters                            */
+  double flops;               /* operations of one transform                  */
+  size_t bytes;               /* space of the vectors                         */
+  long   freq[NMODES];        /* frequencies of the input ...                 */
+  cplx   amp[NMODES] = {0.75, 1.0, 0.5-0.25*I, 2.0*I}; /* ... and amplitudes  */
+  prk_harness_t harness;      /* per-iteration timing                         */
+
+/*********************************************************************
+** Initialize the MPI environment
+*********************************************************************/
+  prk_progress_init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+
+/*********************************************************************
+** process, test and broadcast input parameters
+*********************************************************************/
+  if (my_ID == root) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPI distributed FFT (six-step)\n");
+
+    if (argc != 3){
+      printf("Usage: %s <# iterations> <2log vector length>\n", *argv);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    iterations = atoi(*++argv);
+    if (iterations < 1){
+      printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    logN = atoi(*++argv);
+    if (logN < 2 || logN%2 || logN > 30) {
+      printf("ERROR: 2log of vector length must be even and between 2 and 30: %d\n",
+             logN);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    M = 1<<(logN/2);
+    if (M%Num_procs) {
+      printf("ERROR: matrix order %d should be divisible by # ranks %d\n",
+             M, Num_procs);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_FFT_BATCHES");
+    batches = env ? atoi(env) : 1;
+    if (batches < 1 || (M/Num_procs)%batches) {
+      printf("ERROR: PRK_FFT_BATCHES must divide the %d columns per rank: %s\n",
+             M/Num_procs, env);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    printf("Number of ranks      = %d\n", Num_procs);
+    printf("Vector length        = %ld\n", 1L<<logN);
+    printf("Matrix order         = %d\n", M);
+    printf("Number of iterations = %d\n", iterations);
+    printf("Column batches       = %d\n", batches);
+#ifdef PRK_FFTW
+    printf("Local FFTs           = FFTW\n");
+#else
+    printf("Local FFTs           = radix-4\n");
+#endif
+    printf("Progress thread      = %s\n", prk_progress_mode());
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  MPI_Bcast(&logN,       1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&batches,    1, MPI_INT, root, MPI_COMM_WORLD);
+
+  N     = 1L<<logN;
+  logM  = logN/2;
+  M     = 1<<logM;
+  width = M/Num_procs;
+  local = (long) M*width;
+
+  /* input, two work arrays, result, twiddle factors, send and receive
+     buffers; the block a rank sends itself is stored at once, so its slot
+     in the receive buffer stays unused                                     */
+  bytes    = 7*local*sizeof(cplx);
+  x        = (cplx *) prk_malloc(bytes);
+  rev      = (int *)  prk_malloc(M*sizeof(int));
+  w        = (cplx *) prk_malloc((M/2+1)*sizeof(cplx));
+  send_req = (MPI_Request *) prk_malloc(2*Num_procs*batches*sizeof(MPI_Request));
+  if (!x || !rev || !w || !send_req) {
+    printf("ERROR: rank %d could not allocate space for the vectors\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  a        = x + local;   b        = a + local;        out      = b + local;
+  tw       = out + local; send_buf = tw + local;       recv_buf = send_buf + local;
+  recv_req = send_req + Num_procs*batches;
+
+  /* bit reversal permutation and twiddle factors of the length-M FFTs        */
+  for (i=0; i<M; i++) {
+    for (j=0, m=0; m<logM; m++) j |= ((i>>m)&1) << (logM-1-m);
+    rev[i] = j;
+  }
+  for (i=0; i<M/2; i++) w[i] = cexp(-2.0*PRK_M_PI*I*(double)i/(double)M);
+  /* after the first transpose the local column r (global row pw+r) is
+     multiplied by W_N^((pw+r)*k2), k2 the position in the column            */
+  for (c=0; c<width; c++) for (r=0; r<M; r++) {
+    kg = (((long)(my_ID*width+c)*r) % N);
+    tw[r+c*M] = cexp(-2.0*PRK_M_PI*I*(double)kg/(double)N);
+  }
+
+#ifdef PRK_FFTW
+  plan = fftw_plan_many_dft(1, &M, width/batches, (fftw_complex *) a, NULL, 1, M,
+                            (fftw_complex *) a, NULL, 1, M, FFTW_FORWARD,
+                            FFTW_ESTIMATE | FFTW_UNALIGNED);
+#endif
+
+  /* input: a constant plus three complex exponentials                        */
+  freq[0] = 0; freq[1] = 1; freq[2] = N/3; freq[3] = N-5;
+  for (k=0; k<local; k++) {
+    kg = (long) my_ID*local + k;
+    for (x[k]=0.0, m=0; m<NMODES; m++)
+      x[k] += amp[m]*cexp(2.0*PRK_M_PI*I*(double)((freq[m]*kg)%N)/(double)N);
+  }
+
+  prk_harness_init(&harness, "FFT", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "log2_length", "%d", logN);
+  prk_harness_param(&harness, "batches", "%d", batches);
+#ifdef PRK_FFTW
+  prk_harness_param(&harness, "local_fft", "%s", "fftw");
+#else
+  prk_harness_param(&harness, "local_fft", "%s", "radix-4");
+#endif
+  prk_harness_param(&harness, "progress", "%s", prk_progress_mode());
+  prk_phase_init(&fft_phase,  "local FFT");
+  prk_phase_init(&pack_phase, "pack");
+  prk_phase_init(&wait_phase, "exchange wait");
+
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  for (iter=0; iter<iterations; iter++) {
+    prk_harness_tick(&harness);
+    transpose(x, a,   0, 0);
+    transpose(a, b,   1, 1);
+    transpose(b, out, 1, 0);
+  }
+
+  prk_harness_tick(&harness);
+  fft_time = prk_harness_elapsed(&harness);
+  MPI_Allreduce(MPI_IN_PLACE, &fft_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  /* verification test: the transform is N times the amplitude at the
+     frequencies of the input, and zero elsewhere                             */
+  for (err=0.0, k=0; k<local; k++) {
+    kg = (long) my_ID*local + k;
+    for (expected=0.0, m=0; m<NMODES; m++) if (kg == freq[m]) expected += N*amp[m];
+    err = MAX(err, cabs(out[k]-expected));
+  }
+  MPI_Reduce(&err, &max_err, 1, MPI_DOUBLE, MPI_MAX, root, MPI_COMM_WORLD);
+
+  flops = 5.0*N*logN;
+  if (my_ID == root) {
+    if (max_err/N > epsilon) {
+      printf("ERROR: largest error %e exceeds threshold %e\n", max_err/N, epsilon);
+      error = 1;
+    }
+    else {
+      printf("Solution validates\n");
+#if VERBOSE
+      printf("Largest error relative to N = %e\n", max_err/N);
+#endif
+    }
+    avgtime = fft_time/iterations;
+    printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
+           1.0E-06 * flops/avgtime, avgtime);
+  }
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_phase_report(&fft_phase);
+  prk_phase_report(&pack_phase);
+  prk_phase_report(&wait_phase);
+  prk_harness_finalize(&harness);
+
+  bail_out(error);
+
+#ifdef PRK_FFTW
+  fftw_destroy_plan(plan);
+#endif
+  prk_progress_finalize();
+  exit(EXIT_SUCCESS);
+}
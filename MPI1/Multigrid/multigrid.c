@@ -0,0 +1,711 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    Multigrid
+
+PURPOSE: This program tests the efficiency with which a linear system
+         defined by a star stencil on a square grid is solved with
+         geometric multigrid V-cycles.  Unlike the single-level Stencil
+         kernel, it visits a hierarchy of ever coarser grids, on which
+         the work per rank shrinks while the number of messages does not,
+         so that the cost of the coarse levels can be studied.
+
+USAGE:   The program takes as input the number of V-cycles and the
+         linear dimension of the finest grid
+
+               <progname> <# iterations> <grid size>
+
+         The operator has the star shape and radius RADIUS of the Stencil
+         kernel, and its off-center weights have the magnitudes of the
+         Stencil weights, 1/(2*k*RADIUS) at distance k, but they are all
+         negative and the center weight is their negated sum, so that the
+         operator is symmetric (for RADIUS=1 it is the 5-point Laplacian).
+         Points outside the grid mirror those inside with opposite sign,
+         for a zero value on the boundary of the grid, and the operator
+         is positive definite.
+         Each level halves the grid in both directions; the operator of a
+         level is that of the finer level divided by four, as for a
+         discretization on a grid with twice the spacing.
+
+         A V-cycle smooths with SWEEPS weighted Jacobi sweeps on the way
+         down and up, restricts the residual by averaging 2x2 cells, and
+         prolongs the correction bilinearly.  The coarsest grid, of at most
+         4 points in a direction (or the odd grid below which the grid
+         cannot be halved, of at most 16 points), is held by rank 0 and
+         solved directly with a Cholesky factorization computed once.
+
+         Every level is distributed in blocks over a grid of ranks.  The
+         finest level uses all ranks; a coarser level is agglomerated onto
+         a subset of the ranks of the finer level, which each gather the
+         blocks of a group of neighbors, when its blocks would be smaller
+         than PRK_MG_AGGLOMERATE points in a direction (default 8; 0
+         agglomerates only where the halving requires it).  Ranks without
+         a block on a level wait while the others work on it.
+
+         The time of every level, excluding the coarser levels but
+         including the transfers to and from the next one, is reported
+         per level with the part spent in communication, as the maximum
+         over the ranks.
+
+         The output consists of diagnostics to make sure the
+         algorithm worked, and of timing statistics.  The solution is
+         correct if every V-cycle reduces the norm of the residual by at
+         least the factor MG_RATE, on average.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following
+         functions are used in this program:
+
+         wtime()
+         bail_out()
+         exchange_halo()
+         smooth(), residual_restrict(), prolong()
+         restrict_transfer(), prolong_transfer()
+         coarse_factor(), coarse_solve()
+         vcycle()
+         prk_harness_*()
+
+HISTORY: Written in October 2026, with the star stencil and the 2D
+         domain decomposition of the MPI1 Stencil kernel.
+
+*********************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+
+/* number of weighted Jacobi sweeps before and after the coarse correction */
+#ifndef SWEEPS
+  #define SWEEPS 2
+#endif
+/* Jacobi weight and required average residual reduction per V-cycle        */
+#define OMEGA       0.8
+#define MG_RATE     0.5
+/* largest coarsest grid that is halved, and largest one solved directly    */
+#define MG_COARSEST 4
+#define MG_MAX_COARSE 16
+#define MAX_LEVELS  32
+/* a grid is halved if it is even, larger than MG_COARSEST, and the halved grid
+   still holds the points mirrored into the ghost zone                       */
+#define HALVE(m)    ((m)%2==0 && (m)>MG_COARSEST && (m)/2>=RADIUS)
+
+#define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+/* point (i,j) of a block of a level, with its ghost zone of RADIUS points */
+#define U(i,j)   u[(i)+RADIUS+((j)+RADIUS)*(L->bx+2*RADIUS)]
+#define F(i,j)   L->f[(i)+(j)*L->bx]
+
+typedef struct {
+  int    n;              /* number of grid points in each direction            */
+  int    px, py;         /* grid of ranks holding the level                    */
+  int    sx, sy;         /* distance of these ranks in the grid of all ranks   */
+  int    gx, gy;         /* ranks of this level gathered by one of the next    */
+  int    active;         /* nonzero if this rank holds a block of the level    */
+  int    cx, cy;         /* coordinates of the rank in the grid of the level   */
+  int    bx, by;         /* size of the block                                  */
+  int    left, right,    /* neighbors in the grid of the level, or             */
+         bottom, top;    /* MPI_PROC_NULL at the boundary                      */
+  double scale;          /* factor of the operator of the level                */
+  double *u, *tmp;       /* solution or correction, and Jacobi iterate, both   */
+                         /* with ghost zones                                   */
+  double *f;             /* right hand side                                    */
+  double *rc;            /* restricted residual, in the layout of the level    */
+  double *ec;            /* coarse correction with a ring of one point, ditto  */
+  double *xfer;          /* blocks gathered from or scattered to the finer     */
+                         /* level                                              */
+  double *buf;           /* halo buffers                                       */
+  MPI_Request *reqs;     /* requests of the transfers to the next level        */
+  double time, comm;     /* time spent on the level and in its communication   */
+} level_t;
+
+static double weight[2*RADIUS+1][2*RADIUS+1];
+static int    Num_procsx, Num_procsy, my_IDx, my_IDy;
+static int    nlevels;
+static level_t level[MAX_LEVELS];
+static double *chol;     /* Cholesky factor of the coarsest operator           */
+
+/* rank of point (cx,cy) of the grid of ranks of level L                      */
+static int rank_of(level_t *L, int cx, int cy) {
+  if (cx < 0 || cx >= L->px || cy < 0 || cy >= L->py) return MPI_PROC_NULL;
+  return cx*L->sx + cy*L->sy*Num_procsx;
+}
+
+/* Fill the ghost zone of u from the neighbors: first the columns to the left
+   and right, then the rows below and above, including the ghost columns, so
+   that the corners are filled as well (the bilinear prolongation reads them).
+   At the boundary of the grid the ghost points mirror the points inside with
+   opposite sign, which puts the zero boundary value on the boundary faces of
+   the cells on every level; returns the time spent                          */
+static double exchange_halo(level_t *L, double *u) {
+
+  int         i, j, k, len;
+  double      *lout = L->buf, *rout, *lin, *rin;
+  MPI_Request req[4];
+  double      t0 = wtime();
+
+  len  = RADIUS*L->by;
+  rout = lout + len; lin = rout + len; rin = lin + len;
+  MPI_Irecv(lin, len, MPI_DOUBLE, L->left,  0, MPI_COMM_WORLD, &req[0]);
+  MPI_Irecv(rin, len, MPI_DOUBLE, L->right, 1, MPI_COMM_WORLD, &req[1]);
+  if (L->left != MPI_PROC_NULL)
+    for (k=0, j=0; j<L->by; j++) for (i=0; i<RADIUS; i++) lout[k++] = U(i,j);
+  if (L->right != MPI_PROC_NULL)
+    for (k=0, j=0; j<L->by; j++) for (i=L->bx-RADIUS; i<L->bx; i++) rout[k++] = U(i,j);
+  MPI_Isend(lout, len, MPI_DOUBLE, L->left,  1, MPI_COMM_WORLD, &req[2]);
+  MPI_Isend(rout, len, MPI_DOUBLE, L->right, 0, MPI_COMM_WORLD, &req[3]);
+  MPI_Waitall(4, req, MPI_STATUSES_IGNORE);
+  if (L->left != MPI_PROC_NULL)
+    for (k=0, j=0; j<L->by; j++) for (i=-RADIUS; i<0; i++) U(i,j) = lin[k++];
+  if (L->right != MPI_PROC_NULL)
+    for (k=0, j=0; j<L->by; j++) for (i=L->bx; i<L->bx+RADIUS; i++) U(i,j) = rin[k++];
+  if (L->left == MPI_PROC_NULL)
+    for (j=0; j<L->by; j++) for (k=1; k<=RADIUS; k++) U(-k,j) = -U(k-1,j);
+  if (L->right == MPI_PROC_NULL)
+    for (j=0; j<L->by; j++) for (k=1; k<=RADIUS; k++) U(L->bx-1+k,j) = -U(L->bx-k,j);
+
+  len  = RADIUS*(L->bx+2*RADIUS);
+  rout = lout + len; lin = rout + len; rin = lin + len;
+  MPI_Irecv(lin, len, MPI_DOUBLE, L->bottom, 2, MPI_COMM_WORLD, &req[0]);
+  MPI_Irecv(rin, len, MPI_DOUBLE, L->top,    3, MPI_COMM_WORLD, &req[1]);
+  if (L->bottom != MPI_PROC_NULL)
+    for (k=0, j=0; j<RADIUS; j++) for (i=-RADIUS; i<L->bx+RADIUS; i++) lout[k++] = U(i,j);
+  if (L->top != MPI_PROC_NULL)
+    for (k=0, j=L->by-RADIUS; j<L->by; j++) for (i=-RADIUS; i<L->bx+RADIUS; i++)
+      rout[k++] = U(i,j);
+  MPI_Isend(lout, len, MPI_DOUBLE, L->bottom, 3, MPI_COMM_WORLD, &req[2]);
+  MPI_Isend(rout, len, MPI_DOUBLE, L->top,    2, MPI_COMM_WORLD, &req[3]);
+  MPI_Waitall(4, req, MPI_STATUSES_IGNORE);
+  if (L->bottom != MPI_PROC_NULL)
+    for (k=0, j=-RADIUS; j<0; j++) for (i=-RADIUS; i<L->bx+RADIUS; i++) U(i,j) = lin[k++];
+  if (L->top != MPI_PROC_NULL)
+    for (k=0, j=L->by; j<L->by+RADIUS; j++) for (i=-RADIUS; i<L->bx+RADIUS; i++)
+      U(i,j) = rin[k++];
+  if (L->bottom == MPI_PROC_NULL)
+    for (k=1; k<=RADIUS; k++) for (i=-RADIUS; i<L->bx+RADIUS; i++) U(i,-k) = -U(i,k-1);
+  if (L->top == MPI_PROC_NULL)
+    for (k=1; k<=RADIUS; k++) for (i=-RADIUS; i<L->bx+RADIUS; i++)
+      U(i,L->by-1+k) = -U(i,L->by-k);
+
+  return wtime() - t0;
+}
+
+/* star stencil of the operator at point (i,j), without the level's factor    */
+static inline double apply(level_t *L, double *u, int i, int j) {
+  double sum = WEIGHT(0,0)*U(i,j);
+  int    ii;
+  for (ii=1; ii<=RADIUS; ii++)
+    sum += WEIGHT(0,ii)*(U(i,j+ii)+U(i,j-ii)) + WEIGHT(ii,0)*(U(i+ii,j)+U(i-ii,j));
+  return sum;
+}
+
+/* weighted Jacobi sweeps on u; the iterate alternates between u and tmp      */
+static void smooth(level_t *L, int sweeps) {
+
+  double *u, *t, factor = OMEGA/(L->scale*WEIGHT(0,0));
+  int    i, j, s;
+
+  for (s=0; s<sweeps; s++) {
+    u = L->u;
+    L->comm += exchange_halo(L, u);
+    t = L->tmp;
+    for (j=0; j<L->by; j++) for (i=0; i<L->bx; i++)
+      t[i+RADIUS+(j+RADIUS)*(L->bx+2*RADIUS)] =
+        U(i,j) + factor*(F(i,j) - L->scale*apply(L, u, i, j));
+    L->tmp = L->u; L->u = t;
+  }
+}
+
+/* residual f-A*u, averaged over 2x2 cells into rc, in one pass over the block */
+static void residual_restrict(level_t *L) {
+
+  double *u = L->u;
+  int    i, j, cbx = L->bx/2;
+
+  L->comm += exchange_halo(L, u);
+  for (j=0; j<L->by/2; j++) for (i=0; i<cbx; i++) L->rc[i+j*cbx] = 0.0;
+  for (j=0; j<L->by; j++) for (i=0; i<L->bx; i++)
+    L->rc[i/2+(j/2)*cbx] += 0.25*(F(i,j) - L->scale*apply(L, u, i, j));
+}
+
+/* add the bilinear interpolation of the coarse correction ec to u            */
+static void prolong(level_t *L) {
+
+  double *u = L->u, *e;
+  int    i, j, di, dj, w = L->bx/2+2;
+
+  for (j=0; j<L->by; j++) for (i=0; i<L->bx; i++) {
+    /* coarse cell of the point, shifted by the ring, and its nearest neighbors */
+    e  = L->ec + (i/2+1) + (j/2+1)*w;
+    di = i%2 ? 1 : -1;
+    dj = j%2 ? w : -w;
+    U(i,j) += 0.5625*e[0] + 0.1875*(e[di]+e[dj]) + 0.0625*e[di+dj];
+  }
+}
+
+/* send the restricted residuals of the ranks of level l to the ranks of level
+   l+1 that gather them, which store them as their right hand side           */
+static void restrict_transfer(int l) {
+
+  level_t     *L = &level[l], *C = &level[l+1];
+  int         cbx = L->bx/2, cby = L->by/2, len = cbx*cby;
+  int         gi, gj, i, j, nreq = 0;
+  MPI_Request *reqs = L->reqs;
+  double      t0 = wtime();
+
+  if (C->active) {
+    for (gj=0; gj<L->gy; gj++) for (gi=0; gi<L->gx; gi++)
+      MPI_Irecv(C->xfer+(gi+gj*L->gx)*len, len, MPI_DOUBLE,
+                rank_of(L, C->cx*L->gx+gi, C->cy*L->gy+gj), 4, MPI_COMM_WORLD,
+                &reqs[nreq++]);
+  }
+  MPI_Isend(L->rc, len, MPI_DOUBLE, rank_of(C, L->cx/L->gx, L->cy/L->gy), 4,
+            MPI_COMM_WORLD, &reqs[nreq++]);
+  MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE);
+
+  if (C->active) {
+    for (gj=0; gj<L->gy; gj++) for (gi=0; gi<L->gx; gi++)
+      for (j=0; j<cby; j++) for (i=0; i<cbx; i++)
+        C->f[gi*cbx+i+(gj*cby+j)*C->bx] = C->xfer[(gi+gj*L->gx)*len+i+j*cbx];
+  }
+  L->comm += wtime() - t0;
+}
+
+/* send every rank of level l the part of the correction of level l+1 that
+   covers its block, with a ring of one point                                */
+static void prolong_transfer(int l) {
+
+  level_t     *L = &level[l], *C = &level[l+1];
+  int         cbx = L->bx/2, cby = L->by/2, len = (cbx+2)*(cby+2);
+  int         gi, gj, i, j, k, nreq = 0;
+  MPI_Request *reqs = L->reqs;
+  double      *u = C->u;
+  double      t0 = wtime();
+
+  if (C->active) {
+    /* the ring of the blocks at the edges of C's block comes from its halo    */
+    exchange_halo(C, u);
+    for (gj=0; gj<L->gy; gj++) for (gi=0; gi<L->gx; gi++) {
+      double *box = C->xfer + (gi+gj*L->gx)*len;
+      for (k=0, j=gj*cby-1; j<=(gj+1)*cby; j++) for (i=gi*cbx-1; i<=(gi+1)*cbx; i++)
+        box[k++] = u[i+RADIUS+(j+RADIUS)*(C->bx+2*RADIUS)];
+      MPI_Isend(box, len, MPI_DOUBLE, rank_of(L, C->cx*L->gx+gi, C->cy*L->gy+gj), 5,
+                MPI_COMM_WORLD, &reqs[nreq++]);
+    }
+  }
+  MPI_Irecv(L->ec, len, MPI_DOUBLE, rank_of(C, L->cx/L->gx, L->cy/L->gy), 5,
+            MPI_COMM_WORLD, &reqs[nreq++]);
+  MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE);
+  L->comm += wtime() - t0;
+}
+
+/* index of the point at offset d from point i of a grid of n points, and the
+   sign of its value, for the mirrored ghost points of exchange_halo()        */
+static int mirror(int i, int d, int n, double *sign) {
+  i += d;
+  *sign = 1.0;
+  if (i < 0)  { *sign = -1.0; return -i-1; }
+  if (i >= n) { *sign = -1.0; return 2*n-1-i; }
+  return i;
+}
+
+/* Cholesky factorization of the operator of the coarsest level L, in place   */
+static int coarse_factor(level_t *L) {
+
+  int    m = L->n*L->n, n = L->n, row, col, k, i, j, ii, d;
+  double sum, sign;
+
+  chol = (double *) prk_malloc((size_t) m*m*sizeof(double));
+  if (!chol) return 1;
+  for (k=0; k<m*m; k++) chol[k] = 0.0;
+  for (j=0; j<n; j++) for (i=0; i<n; i++) {
+    row = i+j*n;
+    chol[row+row*m] += L->scale*WEIGHT(0,0);
+    for (ii=1; ii<=RADIUS; ii++) for (d=-ii; d<=ii; d+=2*ii) {
+      col = mirror(i, d, n, &sign) + j*n;
+      chol[row+col*m] += sign*L->scale*WEIGHT(d,0);
+      col = i + mirror(j, d, n, &sign)*n;
+      chol[row+col*m] += sign*L->scale*WEIGHT(0,d);
+    }
+  }
+  /* lower triangle: chol[row+col*m], row >= col                              */
+  for (col=0; col<m; col++) {
+    for (sum=chol[col+col*m], k=0; k<col; k++) sum -= chol[col+k*m]*chol[col+k*m];
+    if (sum <= 0.0) return 1;
+    chol[col+col*m] = sqrt(sum);
+    for (row=col+1; row<m; row++) {
+      for (sum=chol[row+col*m], k=0; k<col; k++) sum -= chol[row+k*m]*chol[col+k*m];
+      chol[row+col*m] = sum/chol[col+col*m];
+    }
+  }
+  return 0;
+}
+
+/* solve the coarsest level exactly with the Cholesky factor                  */
+static void coarse_solve(level_t *L) {
+
+  double *u = L->u, *y = L->tmp;
+  int    m = L->n*L->n, row, k;
+
+  for (row=0; row<m; row++) {
+    for (y[row]=L->f[row], k=0; k<row; k++) y[row] -= chol[row+k*m]*y[k];
+    y[row] /= chol[row+row*m];
+  }
+  for (row=m-1; row>=0; row--) {
+    for (k=row+1; k<m; k++) y[row] -= chol[k+row*m]*y[k];
+    y[row] /= chol[row+row*m];
+  }
+  for (row=0; row<m; row++) U(row%L->n, row/L->n) = y[row];
+}
+
+/* one V-cycle from level l down; level 0 keeps its iterate, the coarser
+   levels start from a zero correction                                       */
+static void vcycle(int l) {
+
+  level_t *L = &level[l];
+  double  t0;
+  int     k;
+
+  if (!L->active) return;
+  t0 = wtime();
+  if (l > 0)
+    for (k=0; k<(L->bx+2*RADIUS)*(L->by+2*RADIUS); k++) L->u[k] = 0.0;
+
+  if (l == nlevels-1) {
+    coarse_solve(L);
+    L->time += wtime() - t0;
+    return;
+  }
+
+  smooth(L, SWEEPS);
+  residual_restrict(L);
+  restrict_transfer(l);
+  L->time += wtime() - t0;
+
+  vcycle(l+1);
+
+  t0 = wtime();
+  prolong_transfer(l);
+  prolong(L);
+  smooth(L, SWEEPS);
+  L->time += wtime() - t0;
+}
+
+int main(int argc, char ** argv) {
+
+  int    Num_procs;       /* number of ranks                                     */
+  int    my_ID;           /* MPI rank                                            */
+  int    root = 0;
+  int    n;               /* linear grid dimension                               */
+  int    iterations;      /* number of V-cycles                                  */
+  int    iter, l, i, j, ii; /* dummies                                           */
+  int    error = 0;       /* error flag                                          */
+  int    min_block = 8;   /* smallest block before a level is agglomerated       */
+  int    m, cbx, cby;     /* auxiliary sizes                                     */
+  char   *env;            /* value of PRK_MG_AGGLOMERATE                         */
+  level_t *L, *C;
+  double *u;
+  double norm, norm0,     /* norms of the final and initial residual            */
+         local_norm;
+  double mg_time, avgtime; /* timing parameters                                  */
+  double times[2*MAX_LEVELS], /* time of every level and of its communication   */
+         max_times[2*MAX_LEVELS];
+  double flops, bytes;    /* modeled work of one V-cycle                         */
+  double points;          /* points of a level                                   */
+  double epsilon = 1.e-10; /* floor of the relative residual                     */
+  prk_harness_t harness;  /* per-iteration timing                                */
+
+/*******************************************************************************
+** Initialize the MPI environment
+********************************************************************************/
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+
+/*******************************************************************************
+** process, test, and broadcast input parameters
+********************************************************************************/
+
+  /* determine best way to create a 2D grid of ranks (closest to square), as
+     in the Stencil kernel                                                    */
+  for (Num_procsx=(int) (sqrt(Num_procs+1)); Num_procsx>0; Num_procsx--) {
+    if (!(Num_procs%Num_procsx)) {
+      Num_procsy = Num_procs/Num_procsx;
+      break;
+    }
+  }
+  my_IDx = my_ID%Num_procsx;
+  my_IDy = my_ID/Num_procsx;
+
+  if (my_ID == root) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPI geometric multigrid solver\n");
+    if (argc != 3) {
+      printf("Usage: %s <# iterations> <grid size>\n", *argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    iterations  = atoi(*++argv);
+    if (iterations < 1){
+      printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    n = atoi(*++argv);
+    if (RADIUS < 1) {
+      printf("ERROR: Stencil radius %d should be positive\n", RADIUS);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    if (!HALVE(n)) {
+      printf("ERROR: grid size %d must be even, larger than %d and at least 2*%d\n",
+             n, MG_COARSEST, RADIUS);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    if (n%(2*Num_procsx) || n%(2*Num_procsy)) {
+      printf("ERROR: grid size %d must be a multiple of twice the ranks in x/y %d/%d\n",
+             n, Num_procsx, Num_procsy);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    if ((Num_procsx > 1 && n/Num_procsx < RADIUS) ||
+        (Num_procsy > 1 && n/Num_procsy < RADIUS)) {
+      printf("ERROR: blocks of %dx%d points are smaller than the stencil radius %d\n",
+             n/Num_procsx, n/Num_procsy, RADIUS);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* the grid at which the halving stops is solved directly                 */
+    for (m=n; HALVE(m); m/=2);
+    if (m > MG_MAX_COARSE) {
+      printf("ERROR: coarsest grid %d of grid size %d exceeds %d points\n",
+             m, n, MG_MAX_COARSE);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_MG_AGGLOMERATE");
+    if (env != NULL) min_block = atoi(env);
+    if (min_block < 0) {
+      printf("ERROR: PRK_MG_AGGLOMERATE must be non-negative: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  MPI_Bcast(&n,          1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&min_block,  1, MPI_INT, root, MPI_COMM_WORLD);
+
+  /* weights of the symmetric star operator                                  */
+  for (j=-RADIUS; j<=RADIUS; j++) for (i=-RADIUS; i<=RADIUS; i++)
+    WEIGHT(i,j) = 0.0;
+  for (ii=1; ii<=RADIUS; ii++) {
+    WEIGHT(0, ii) = WEIGHT( ii,0) = -1.0/(2.0*ii*RADIUS);
+    WEIGHT(0,-ii) = WEIGHT(-ii,0) = -1.0/(2.0*ii*RADIUS);
+    WEIGHT(0,0) += 4.0/(2.0*ii*RADIUS);
+  }
+
+  /* build the hierarchy of levels and their distribution over the ranks      */
+  level[0].n  = n;
+  level[0].px = Num_procsx; level[0].py = Num_procsy;
+  level[0].sx = level[0].sy = 1;
+  level[0].scale = 1.0;
+  for (nlevels=1; HALVE(level[nlevels-1].n); nlevels++) {
+    L = &level[nlevels-1]; C = &level[nlevels];
+    C->n = L->n/2;
+    C->scale = 0.25*L->scale;
+    if (!HALVE(C->n)) C->px = C->py = 1;
+    else {
+      /* the largest subgrid of L's ranks whose blocks are even and, unless a
+         single rank is left, hold at least min_block and RADIUS points       */
+      for (C->px=L->px; C->px>1; C->px--)
+        if (L->px%C->px == 0 && C->n%(2*C->px) == 0 &&
+            C->n/C->px >= MAX(min_block,RADIUS)) break;
+      for (C->py=L->py; C->py>1; C->py--)
+        if (L->py%C->py == 0 && C->n%(2*C->py) == 0 &&
+            C->n/C->py >= MAX(min_block,RADIUS)) break;
+    }
+    L->gx = L->px/C->px; L->gy = L->py/C->py;
+    C->sx = L->sx*L->gx; C->sy = L->sy*L->gy;
+  }
+
+  for (l=0; l<nlevels; l++) {
+    L = &level[l];
+    L->active = my_IDx%L->sx == 0 && my_IDy%L->sy == 0;
+    L->cx = my_IDx/L->sx; L->cy = my_IDy/L->sy;
+    L->bx = L->n/L->px;   L->by = L->n/L->py;
+    L->time = L->comm = 0.0;
+    if (!L->active) continue;
+    L->left   = rank_of(L, L->cx-1, L->cy);
+    L->right  = rank_of(L, L->cx+1, L->cy);
+    L->bottom = rank_of(L, L->cx, L->cy-1);
+    L->top    = rank_of(L, L->cx, L->cy+1);
+    m   = (L->bx+2*RADIUS)*(L->by+2*RADIUS);
+    cbx = L->bx/2; cby = L->by/2;
+    L->u    = (double *) prk_malloc(2*m*sizeof(double));
+    L->f    = (double *) prk_malloc(L->bx*L->by*sizeof(double));
+    L->rc   = (double *) prk_malloc((cbx*cby+(cbx+2)*(cby+2))*sizeof(double));
+    L->buf  = (double *) prk_malloc(4*RADIUS*(MAX(L->bx,L->by)+2*RADIUS)*sizeof(double));
+    L->reqs = (MPI_Request *) prk_malloc((L->gx*L->gy+1)*sizeof(MPI_Request));
+    L->xfer = l == 0 ? NULL :
+              (double *) prk_malloc(level[l-1].gx*level[l-1].gy*
+                                    (level[l-1].bx/2+2)*(level[l-1].by/2+2)*sizeof(double));
+    if (!L->u || !L->f || !L->rc || !L->buf || !L->reqs || (l > 0 && !L->xfer)) {
+      printf("ERROR: rank %d could not allocate space for level %d\n", my_ID, l);
+      error = 1;
+      break;
+    }
+    L->tmp = L->u + m;
+    L->ec  = L->rc + cbx*cby;
+    /* the ghost zones at the boundary of the grid stay zero                  */
+    for (i=0; i<2*m; i++) L->u[i] = 0.0;
+  }
+  bail_out(error);
+
+  if (level[nlevels-1].active) {
+    error = coarse_factor(&level[nlevels-1]);
+    if (error) printf("ERROR: could not factor the operator of the coarsest level\n");
+  }
+  bail_out(error);
+
+  /* right hand side with components of all frequencies                       */
+  L = &level[0];
+  for (j=0; j<L->by; j++) for (i=0; i<L->bx; i++)
+    F(i,j) = (double) ((7*(L->cx*L->bx+i) + 13*(L->cy*L->by+j))%17) - 8.0;
+  for (local_norm=0.0, j=0; j<L->by; j++) for (i=0; i<L->bx; i++)
+    local_norm += F(i,j)*F(i,j);
+  MPI_Allreduce(&local_norm, &norm0, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  norm0 = sqrt(norm0);
+
+  if (my_ID == root) {
+    printf("Number of ranks        = %d\n", Num_procs);
+    printf("Grid size              = %d\n", n);
+    printf("Radius of stencil      = %d\n", RADIUS);
+    printf("Tiles in x/y-direction = %d/%d\n", Num_procsx, Num_procsy);
+    printf("Number of levels       = %d\n", nlevels);
+    printf("Smoothing sweeps       = %d pre, %d post\n", SWEEPS, SWEEPS);
+    printf("Agglomeration below    = %d points\n", min_block);
+    printf("Number of V-cycles     = %d\n", iterations);
+  }
+
+  prk_harness_init(&harness, "Multigrid", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%d", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "levels", "%d", nlevels);
+  prk_harness_param(&harness, "agglomerate", "%d", min_block);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  for (iter=0; iter<iterations; iter++) {
+    prk_harness_tick(&harness);
+    vcycle(0);
+  }
+
+  prk_harness_tick(&harness);
+  mg_time = prk_harness_elapsed(&harness);
+  MPI_Allreduce(MPI_IN_PLACE, &mg_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  /* verification test: norm of the final residual                            */
+  L = &level[0];
+  u = L->u;
+  exchange_halo(L, u);
+  for (local_norm=0.0, j=0; j<L->by; j++) for (i=0; i<L->bx; i++)
+    local_norm += (F(i,j) - apply(L, u, i, j))*(F(i,j) - apply(L, u, i, j));
+  MPI_Allreduce(&local_norm, &norm, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  norm = sqrt(norm);
+
+  for (l=0; l<nlevels; l++) {
+    times[2*l]   = level[l].time;
+    times[2*l+1] = level[l].comm;
+  }
+  MPI_Reduce(times, max_times, 2*nlevels, MPI_DOUBLE, MPI_MAX, root, MPI_COMM_WORLD);
+
+  /* per point of a level: SWEEPS Jacobi sweeps down and up, the residual with
+     its restriction, and the prolongation; each sweep reads u and f and writes
+     the iterate, the residual reads u and f, the prolongation updates u      */
+  flops = bytes = 0.0;
+  for (l=0; l<nlevels; l++) {
+    points = (double) level[l].n*(double) level[l].n;
+    if (l == nlevels-1) {
+      flops += 2.0*points*points;
+      bytes += sizeof(double)*points*points;
+    }
+    else {
+      flops += points*(2*SWEEPS*(2.0*(4*RADIUS+1)+3.0) + 2.0*(4*RADIUS+1)+2.0 + 9.0);
+      bytes += sizeof(double)*points*(2*SWEEPS*3.0 + 2.0 + 2.0);
+    }
+  }
+
+  if (my_ID == root) {
+    if (!(norm <= (pow(MG_RATE, iterations) + epsilon)*norm0)) {
+      printf("ERROR: residual reduction %e exceeds %e\n",
+             norm/norm0, pow(MG_RATE, iterations));
+      error = 1;
+    }
+    else {
+      printf("Solution validates\n");
+#if VERBOSE
+      printf("Residual reduction = %e, average per V-cycle = %lf\n",
+             norm/norm0, pow(norm/norm0, 1.0/iterations));
+#endif
+    }
+    avgtime = mg_time/iterations;
+    printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
+           1.0E-06 * flops/avgtime, avgtime);
+    printf("Level    grid   ranks     block   time (s)   comm (s)\n");
+    for (l=0; l<nlevels; l++)
+      printf("%5d %7d %7d %4dx%-4d %10.6lf %10.6lf\n", l, level[l].n,
+             level[l].px*level[l].py, level[l].bx, level[l].by,
+             max_times[2*l], max_times[2*l+1]);
+  }
+  prk_harness_model(&harness, flops, bytes);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
+
+  bail_out(error);
+
+  MPI_Finalize();
+  exit(EXIT_SUCCESS);
+}
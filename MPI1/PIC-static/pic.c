@@ -47,6 +47,36 @@ USAGE:   <progname> <#simulation steps> <grid size> <#particles> \
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         Particles start out ordered by cell, but lose that order as they
+         move and migrate between ranks, so that the grid lookups become
+         increasingly scattered. Setting PRK_SORT=<f> makes every rank sort
+         its particles by cell again every f time steps, with a counting
+         sort; the time spent sorting is included in the rate and reported
+         separately. Setting PRK_GRID=cell additionally stores the four
+         charges at the corners of each cell next to each other (cell-tiled
+         storage), so that every particle reads its charges from one or two
+         cache lines.
+
+         By default particles leaving the tile are exchanged with the eight
+         neighbors in two rounds of point-to-point messages, counts first.
+         Setting PRK_EXCHANGE=neighbor (requires MPI-3) does both rounds as
+         neighborhood collectives on a distributed graph communicator,
+         sending straight from the per-neighbor buffers and receiving
+         straight into the particle array. All these buffers only grow, with
+         headroom, so that steady-state time steps do not allocate.
+
+         By default the particle count stays fixed. Setting
+         PRK_INJECT=<f>:<n>:<xleft>,<xright>,<ybottom>,<ytop> injects n
+         particles into every cell of the given patch every f time steps,
+         each rank into the cells it owns, and
+         PRK_REMOVE=<f>:<xleft>,<xright>,<ybottom>,<ytop> removes all
+         particles in the cells of the patch every f time steps. Injected
+         particles are appended to the particle array; removed ones are
+         dropped when the array is rewritten in place during the exchange,
+         which compacts it in every time step. The time spent allocating
+         particle buffers during the time steps and the peak memory they
+         hold are reported.
+
 FUNCTIONS CALLED:
 
          Other than standard C functions, the following functions are used in 
@@ -56,19 +86,26 @@ FUNCTIONS CALLED:
          initializeSinusoidal()
          initializeLinear()
          initializePatch()
+         finishParticle()
          finishParticlesInitialization()
+         injectParticles()
+         alloc_particles()
          find_owner()
          computeCoulomb()
          computeTotalForce()
+         initializeCellGrid()
+         sortByCell()
          verifyParticle()
          add_particle_to_buffer()
          attach_particles()
          attach_received_particles()
          resize_buffer()
+         reserve_particles()
          bad_patch()
          contain()
          wtime()
          random_draw()
+         prk_harness_*()
 
 HISTORY: - Written by Evangelos Georganas, August 2015.
          - RvdW: Refactored to make the code PRK conforming, March 2016
@@ -77,6 +114,7 @@ HISTORY: - Written by Evangelos Georganas, August 2015.
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
 #include <random_draw.h>
+#include <prk_harness.h>
 
 /* M_PI is not defined in strict C99 */
 #ifdef M_PI
@@ -127,8 +165,23 @@ typedef struct particle_t {
   double   k;
   double   m;
   double   ID;   // ID of particle; use double to create homogeneous type
+  double   t0;   // time step at which the particle was placed
 } particle_t;
 
+/* time spent allocating particle buffers, and number of allocations */
+static double   alloc_time = 0.0;
+static uint64_t allocs     = 0;
+
+/* Allocates a buffer for n particles, accounting for the time taken */
+particle_t *alloc_particles(uint64_t n) {
+  double     start = wtime();
+  particle_t *buffer = (particle_t*) prk_malloc(n * sizeof(particle_t));
+
+  alloc_time += wtime() - start;
+  allocs++;
+  return buffer;
+}
+
 int bad_patch(bbox_t *patch, bbox_t *patch_contain) {
   if (patch->left>=patch->right || patch->bottom>=patch->top) return(1);
   if (patch_contain) {
@@ -169,34 +222,72 @@ double *initializeGrid(bbox_t tile) {
   return grid;
 }
 
+/* Copies the grid of charges of a tile into cell-tiled storage: the charges
+   at the four corners of local cell (x,y) are stored contiguously at
+   4*(y+x*n_rows), in the order in which computeTotalForce uses them        */
+double *initializeCellGrid(bbox_t tile, double *grid) {
+  double   *cellgrid;
+  uint64_t x, y, n_columns, n_rows;
+  int      error=0, my_ID;
+
+  n_columns = tile.right-tile.left+1;
+  n_rows = tile.top-tile.bottom+1;
+
+  cellgrid = (double*) prk_malloc(4*n_columns*n_rows*sizeof(double));
+  if (cellgrid == NULL) {
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+    printf("ERROR: Process %d could not allocate space for cell-tiled grid\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+
+  for (x=0; x<n_columns-1; x++) {
+    for (y=0; y<n_rows-1; y++) {
+      cellgrid[4*(y+x*n_rows)  ] = grid[y+x*n_rows];
+      cellgrid[4*(y+x*n_rows)+1] = grid[(y+1)+x*n_rows];
+      cellgrid[4*(y+x*n_rows)+2] = grid[y+(x+1)*n_rows];
+      cellgrid[4*(y+x*n_rows)+3] = grid[(y+1)+(x+1)*n_rows];
+    }
+  }
+  return cellgrid;
+}
+
+/* Sets velocity, charge and initial position of a particle placed at
+   (x,y) in time step t0                                                   */
+void finishParticle(particle_t *p, double t0) {
+  double x_coord, y_coord, rel_x, rel_y, cos_theta, cos_phi, r1_sq, r2_sq, base_charge;
+  uint64_t x;
+
+  x_coord = p->x;
+  y_coord = p->y;
+  rel_x = fmod(x_coord,1.0);
+  rel_y = fmod(y_coord,1.0);
+  x = (uint64_t) x_coord;
+  r1_sq = rel_y * rel_y + rel_x * rel_x;
+  r2_sq = rel_y * rel_y + (1.0-rel_x) * (1.0-rel_x);
+  cos_theta = rel_x/sqrt(r1_sq);
+  cos_phi = (1.0-rel_x)/sqrt(r2_sq);
+  base_charge = 1.0 / ((DT*DT) * Q * (cos_theta/r1_sq + cos_phi/r2_sq));
+       
+  p->v_x = 0.0;
+  p->v_y = ((double) p->m) / DT;
+  /* this particle charge assures movement in positive x-direction */
+  p->q = (x%2 == 0) ? (2*p->k+1)*base_charge : -1.0 * (2*p->k+1)*base_charge ;
+  p->x0 = x_coord;
+  p->y0 = y_coord;
+  p->t0 = t0;
+}
+
 /* Completes particle distribution */
 void finishParticlesInitialization(uint64_t n, particle_t *p) {
-  double x_coord, y_coord, rel_x, rel_y, cos_theta, cos_phi, r1_sq, r2_sq, base_charge, ID;
-  uint64_t x, pi, cumulative_count;
+  double ID;
+  uint64_t pi, cumulative_count;
 
   MPI_Scan(&n, &cumulative_count, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
   ID = (double) (cumulative_count - n + 1);
-  int my_ID;
-  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
 
   for (pi=0; pi<n; pi++) {
-    x_coord = p[pi].x;
-    y_coord = p[pi].y;
-    rel_x = fmod(x_coord,1.0);
-    rel_y = fmod(y_coord,1.0);
-    x = (uint64_t) x_coord;
-    r1_sq = rel_y * rel_y + rel_x * rel_x;
-    r2_sq = rel_y * rel_y + (1.0-rel_x) * (1.0-rel_x);
-    cos_theta = rel_x/sqrt(r1_sq);
-    cos_phi = (1.0-rel_x)/sqrt(r2_sq);
-    base_charge = 1.0 / ((DT*DT) * Q * (cos_theta/r1_sq + cos_phi/r2_sq));
-         
-    p[pi].v_x = 0.0;
-    p[pi].v_y = ((double) p[pi].m) / DT;
-    /* this particle charge assures movement in positive x-direction */
-    p[pi].q = (x%2 == 0) ? (2*p[pi].k+1)*base_charge : -1.0 * (2*p[pi].k+1)*base_charge ;
-    p[pi].x0 = x_coord;
-    p[pi].y0 = y_coord;
+    finishParticle(&p[pi], 0.0);
     p[pi].ID = ID;
     ID += 1.0;
   }
@@ -444,11 +535,14 @@ int computeCoulomb(double x_dist, double y_dist, double q1, double q2, double *f
   return 0;
 }
 
-/* Computes the total Coulomb force on a particle exerted from the charges of the corresponding cell */
-void computeTotalForce(particle_t p, bbox_t tile, double *grid, double *fx, double *fy)
+/* Computes the total Coulomb force on a particle exerted from the charges of the corresponding cell;
+   uses the cell-tiled copy of the grid if cellgrid is not NULL */
+void computeTotalForce(particle_t p, bbox_t tile, double *grid, double *cellgrid,
+                       double *fx, double *fy)
 {
   uint64_t  x, y, n_rows;
   double   tmp_fx, tmp_fy, rel_y, rel_x, tmp_res_x, tmp_res_y;
+  double   q[4];
 
   n_rows = tile.top-tile.bottom+1;
    
@@ -461,24 +555,33 @@ void computeTotalForce(particle_t p, bbox_t tile, double *grid, double *fx, doub
    
   x = x - tile.left;
   y = y - tile.bottom;
+
+  if (cellgrid) {
+    q[0] = cellgrid[4*(y+x*n_rows)];   q[1] = cellgrid[4*(y+x*n_rows)+1];
+    q[2] = cellgrid[4*(y+x*n_rows)+2]; q[3] = cellgrid[4*(y+x*n_rows)+3];
+  }
+  else {
+    q[0] = grid[y+x*n_rows];           q[1] = grid[(y+1)+x*n_rows];
+    q[2] = grid[y+(x+1)*n_rows];       q[3] = grid[(y+1)+(x+1)*n_rows];
+  }
    
-  computeCoulomb(rel_x, rel_y, p.q, grid[y+x*n_rows], &tmp_fx, &tmp_fy);
+  computeCoulomb(rel_x, rel_y, p.q, q[0], &tmp_fx, &tmp_fy);
    
   tmp_res_x = tmp_fx;
   tmp_res_y = tmp_fy;
    
   /* Coulomb force from bottom-left charge */
-  computeCoulomb(rel_x, 1.0-rel_y, p.q, grid[(y+1)+x*n_rows], &tmp_fx, &tmp_fy);
+  computeCoulomb(rel_x, 1.0-rel_y, p.q, q[1], &tmp_fx, &tmp_fy);
   tmp_res_x += tmp_fx;
   tmp_res_y -= tmp_fy;
    
   /* Coulomb force from top-right charge */
-  computeCoulomb(1.0-rel_x, rel_y, p.q, grid[y+(x+1)*n_rows], &tmp_fx, &tmp_fy);
+  computeCoulomb(1.0-rel_x, rel_y, p.q, q[2], &tmp_fx, &tmp_fy);
   tmp_res_x -= tmp_fx;
   tmp_res_y += tmp_fy;
    
   /* Coulomb force from bottom-right charge */
-  computeCoulomb(1.0-rel_x, 1.0-rel_y, p.q, grid[(y+1)+(x+1)*n_rows], &tmp_fx, &tmp_fy);
+  computeCoulomb(1.0-rel_x, 1.0-rel_y, p.q, q[3], &tmp_fx, &tmp_fy);
   tmp_res_x -= tmp_fx;
   tmp_res_y -= tmp_fy;
    
@@ -486,13 +589,14 @@ void computeTotalForce(particle_t p, bbox_t tile, double *grid, double *fx, doub
   (*fy) = tmp_res_y;
 }
 
-/* Verifies the final position of a particle */
+/* Verifies the final position of a particle, which has moved in all time
+   steps from the one in which it was placed                               */
 int verifyParticle(particle_t p, double L, uint64_t iterations)
 {
    double   x_final, y_final, x_periodic, y_periodic;
    
-   x_final = p.x0 + (double) (iterations+1) * (2.0*p.k+1);
-   y_final = p.y0 + (double) (iterations+1) * p.m;
+   x_final = p.x0 + ((double) (iterations+1) - p.t0) * (2.0*p.k+1);
+   y_final = p.y0 + ((double) (iterations+1) - p.t0) * p.m;
 
    x_periodic = (x_final >= 0.0) ? fmod(x_final, L) : L + fmod(x_final, L);
    y_periodic = (y_final >= 0.0) ? fmod(y_final, L) : L + fmod(y_final, L);
@@ -513,7 +617,7 @@ void add_particle_to_buffer(particle_t p, particle_t **buffer, uint64_t *positio
 
    if (cur_pos == cur_buf_size) {
       /* Have to resize buffer */
-      temp_buf = (particle_t*) prk_malloc(2 * cur_buf_size * sizeof(particle_t));
+      temp_buf = alloc_particles(2 * cur_buf_size);
       if (!temp_buf) {
         printf("Could not increase particle buffer size\n");
         /* do not attempt graceful exit; just allow code to abort */
@@ -540,7 +644,7 @@ void attach_particles(particle_t **dst_buffer, uint64_t *position, uint64_t *buf
    
    if ((cur_pos + n_src_particles) > cur_buf_size) {
       /* Have to resize buffer */
-      temp_buf = (particle_t*) prk_malloc(2 *(cur_buf_size + n_src_particles) * sizeof(particle_t));
+      temp_buf = alloc_particles(2 *(cur_buf_size + n_src_particles));
       if (!temp_buf) {
         printf("Could not increase particle buffer size\n");
         /* do not attempt graceful exit; just allow code to abort */
@@ -567,7 +671,7 @@ void attach_received_particles(particle_t **dst_buffer, uint64_t *position, uint
    
    if ((cur_pos + n_src_particles + n_src_particles2 ) > cur_buf_size) {
       /* Have to resize buffer */
-      temp_buf = (particle_t*) prk_malloc((cur_buf_size + 2*(n_src_particles + n_src_particles2)) * sizeof(particle_t));
+      temp_buf = alloc_particles(cur_buf_size + 2*(n_src_particles + n_src_particles2));
       if (!temp_buf) {
         printf("Could not increase particle buffer size\n");
         /* do not attempt graceful exit; just allow code to abort */
@@ -593,7 +697,7 @@ void resize_buffer(particle_t **buffer, uint64_t *size, uint64_t new_size)
    
    if (new_size > cur_size) {
       prk_free(*buffer);
-      (*buffer) = (particle_t*) prk_malloc(2*new_size*sizeof(particle_t));
+      (*buffer) = alloc_particles(2*new_size);
       if (!(*buffer)) {
         printf("Could not increase particle buffer size\n");
         /* do not attempt graceful exit; just allow code to abort */
@@ -604,6 +708,87 @@ void resize_buffer(particle_t **buffer, uint64_t *size, uint64_t new_size)
 
 }
 
+/* Makes room for n_new particles behind the first position ones in a buffer.
+   The buffer never shrinks, and it grows with 50% headroom, so that small
+   fluctuations of the particle count do not cause repeated reallocation */
+void reserve_particles(particle_t **buffer, uint64_t position, uint64_t *buffer_size,
+                       uint64_t n_new)
+{
+   uint64_t   new_size;
+   particle_t *temp_buf;
+
+   if (position + n_new > (*buffer_size)) {
+      new_size = position + n_new;
+      new_size += new_size/2;
+      temp_buf = alloc_particles(new_size);
+      if (!temp_buf) {
+        printf("Could not increase particle buffer size\n");
+        /* do not attempt graceful exit; just allow code to abort */
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+      }
+      memcpy(temp_buf, *buffer, position*sizeof(particle_t));
+      prk_free(*buffer);
+      (*buffer) = temp_buf;
+      (*buffer_size) = new_size;
+   }
+}
+
+/* Appends n particles to every cell of patch that the tile owns, placed and
+   charged like the initial ones, at time step iter. The particles of cell c
+   of the patch, counting column by column, get IDs first_ID+c*n+1 on, so
+   that IDs stay unique whatever the decomposition; returns the number of
+   particles appended                                                      */
+uint64_t injectParticles(particle_t **particles, uint64_t *count, uint64_t *size,
+                         bbox_t patch, bbox_t tile, uint64_t n, double k, double m,
+                         uint64_t iter, uint64_t first_ID)
+{
+   uint64_t   x, y, j, rows = patch.top-patch.bottom+1, total = 0;
+   particle_t *p;
+
+   for (x=MAX(patch.left,tile.left); x<=MIN(patch.right,tile.right-1); x++)
+     for (y=MAX(patch.bottom,tile.bottom); y<=MIN(patch.top,tile.top-1); y++) total += n;
+   reserve_particles(particles, *count, size, total);
+
+   p = *particles + *count;
+   for (x=MAX(patch.left,tile.left); x<=MIN(patch.right,tile.right-1); x++)
+     for (y=MAX(patch.bottom,tile.bottom); y<=MIN(patch.top,tile.top-1); y++)
+       for (j=0; j<n; j++, p++) {
+         p->x  = x + REL_X;
+         p->y  = y + REL_Y;
+         p->k  = k;
+         p->m  = m;
+         finishParticle(p, (double) iter);
+         p->ID = (double) (first_ID + ((x-patch.left)*rows + y-patch.bottom)*n + j + 1);
+       }
+   (*count) += total;
+   return total;
+}
+
+/* Sorts n particles by their cell in the tile, in the same column-major order
+   as the grid, into dst; count needs room for one entry per grid point     */
+void sortByCell(particle_t *src, particle_t *dst, uint64_t n, bbox_t tile, uint64_t *count)
+{
+   uint64_t i, c, pos, sum, n_rows, ncell;
+
+   n_rows = tile.top-tile.bottom+1;
+   ncell  = (tile.right-tile.left+1)*n_rows;
+
+   for (c=0; c<ncell; c++) count[c] = 0;
+   for (i=0; i<n; i++) {
+      c = ((uint64_t) floor(src[i].y) - tile.bottom) + ((uint64_t) floor(src[i].x) - tile.left)*n_rows;
+      count[c]++;
+   }
+   for (sum=0, c=0; c<ncell; c++) {
+      pos = count[c];
+      count[c] = sum;
+      sum += pos;
+   }
+   for (i=0; i<n; i++) {
+      c = ((uint64_t) floor(src[i].y) - tile.bottom) + ((uint64_t) floor(src[i].x) - tile.left)*n_rows;
+      dst[count[c]++] = src[i];
+   }
+}
+
 int main(int argc, char ** argv) {
    
   int             Num_procs;         // number of ranks 
@@ -645,6 +830,41 @@ int main(int argc, char ** argv) {
   find_owner_type find_owner;
   int             ileftover, jleftover;// excess grid points divided among "fat" tiles
   uint64_t        to_send[8], to_recv[8];// 
+  uint64_t        sort_every=0;      // sort particles by cell every so many steps
+  int             cell_grid=0;       // use cell-tiled grid storage
+  double          *cellgrid = NULL;  // cell-tiled copy of grid
+  uint64_t        *cell_count;       // work space for sorting
+  particle_t      *sorted, *swap;    // buffer for sorted particles
+  uint64_t        sorted_size, swap_size;
+  double          sort_time=0.0,     // time spent sorting particles
+                  max_sort_time;
+  uint64_t        sorts=0;           // number of sorts
+  int             neighbor_exchange=0;// exchange particles with neighborhood collectives
+  char            *env;              // value of PRK_SORT, PRK_GRID, PRK_EXCHANGE, etc.
+  bbox_t          cell_patch,        // all cells of the grid
+                  inject_patch,      // cells that particles are injected into
+                  remove_patch;      // cells whose particles are removed
+  uint64_t        inject_every=0,    // inject particles every so many steps
+                  remove_every=0,    // remove particles every so many steps
+                  particles_per_cell;// number of particles injected per cell
+  int             remove_now;        // particles are removed in this time step
+  uint64_t        next_ID;           // highest particle ID handed out so far
+  uint64_t        injected=0, removed=0, removed_IDs=0,// local injection and removal counts
+                  tot_injected, tot_removed, tot_removed_IDs;
+  uint64_t        moves=0, tot_moves=0;// particle moves in the timed time steps
+  uint64_t        buffer_size,       // particles that all buffers of my rank can hold
+                  peak_buffer=0, max_peak_buffer;
+  uint64_t        step_allocs, tot_allocs;// buffer allocations in the time steps
+  double          step_alloc_time=0.0, max_alloc_time;
+  prk_harness_t   harness;           // per-time-step timing
+#if MPI_VERSION >= 3
+  MPI_Comm        nbr_comm;          // distributed graph communicator of the neighbors
+  int             send_counts[8], recv_counts[8];
+  MPI_Aint        send_displs[8], recv_displs[8];
+  MPI_Datatype    types[8];
+  int             weights[8];        // unit edge weights of the graph
+  uint64_t        total_recv;        // number of particles received in a time step
+#endif
    
   MPI_Status  status[16];
   MPI_Request requests[16];
@@ -706,6 +926,70 @@ int main(int argc, char ** argv) {
     m = atoi(*++argv);   args_used++; 
     init_mode = *++argv; args_used++;  
 
+    env = getenv("PRK_SORT");
+    if (env != NULL && *env != '\0') {
+      if (atol(env) < 0) {
+        printf("ERROR: PRK_SORT must be non-negative: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+      sort_every = atol(env);
+    }
+
+    env = getenv("PRK_GRID");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"cell")) cell_grid = 1;
+      else if (strcmp(env,"column")) {
+        printf("ERROR: PRK_GRID must be column or cell: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    env = getenv("PRK_EXCHANGE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"neighbor")) neighbor_exchange = 1;
+      else if (strcmp(env,"p2p")) {
+        printf("ERROR: PRK_EXCHANGE must be p2p or neighbor: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+    cell_patch = (bbox_t){0, L, 0, L};
+    env = getenv("PRK_INJECT");
+    if (env != NULL && *env != '\0') {
+      if (sscanf(env, "%" SCNu64 ":%" SCNu64 ":%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%" SCNu64,
+                 &inject_every, &particles_per_cell, &inject_patch.left, &inject_patch.right,
+                 &inject_patch.bottom, &inject_patch.top) != 6 ||
+          inject_every < 1 || particles_per_cell < 1 || bad_patch(&inject_patch, &cell_patch)) {
+        printf("ERROR: PRK_INJECT must be <f>:<n>:<xleft>,<xright>,<ybottom>,<ytop>, f,n>0, ");
+        printf("within the grid cells: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    env = getenv("PRK_REMOVE");
+    if (env != NULL && *env != '\0') {
+      if (sscanf(env, "%" SCNu64 ":%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%" SCNu64,
+                 &remove_every, &remove_patch.left, &remove_patch.right,
+                 &remove_patch.bottom, &remove_patch.top) != 5 ||
+          remove_every < 1 || bad_patch(&remove_patch, &cell_patch)) {
+        printf("ERROR: PRK_REMOVE must be <f>:<xleft>,<xright>,<ybottom>,<ytop>, f>0, ");
+        printf("within the grid cells: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+#if MPI_VERSION < 3
+    if (neighbor_exchange) {
+      printf("ERROR: PRK_EXCHANGE=neighbor requires MPI-3\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
+
     ENDOFTESTS:;  
 
   } // done with standard initialization parameters
@@ -716,6 +1000,18 @@ int main(int argc, char ** argv) {
   MPI_Bcast(&n,          1, MPI_UINT64_T, root, MPI_COMM_WORLD);
   MPI_Bcast(&k,          1, MPI_UINT64_T, root, MPI_COMM_WORLD);
   MPI_Bcast(&m,          1, MPI_UINT64_T, root, MPI_COMM_WORLD);
+  MPI_Bcast(&sort_every, 1, MPI_UINT64_T, root, MPI_COMM_WORLD);
+  MPI_Bcast(&cell_grid,  1, MPI_INT,      root, MPI_COMM_WORLD);
+  MPI_Bcast(&neighbor_exchange, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&inject_every, 1, MPI_UINT64_T, root, MPI_COMM_WORLD);
+  MPI_Bcast(&remove_every, 1, MPI_UINT64_T, root, MPI_COMM_WORLD);
+  /* the patches are four uint64_t each                                      */
+  if (inject_every) {
+    MPI_Bcast(&particles_per_cell, 1, MPI_UINT64_T, root, MPI_COMM_WORLD);
+    MPI_Bcast(&inject_patch,       4, MPI_UINT64_T, root, MPI_COMM_WORLD);
+  }
+  if (remove_every)
+    MPI_Bcast(&remove_patch,       4, MPI_UINT64_T, root, MPI_COMM_WORLD);
 
   grid_patch = (bbox_t){0, L+1, 0, L+1};
    
@@ -827,6 +1123,21 @@ int main(int argc, char ** argv) {
     }
     printf("Particle charge semi-increment (k) = %llu\n", k);
     printf("Vertical velocity              (m) = %llu\n", m);
+    if (sort_every)
+      printf("Particle sort by cell              = every %llu steps\n", sort_every);
+    else
+      printf("Particle sort by cell              = none\n");
+    printf("Grid storage                       = %s\n", cell_grid ? "cell-tiled" : "column major");
+    printf("Particle exchange                  = %s\n", neighbor_exchange ?
+           "neighborhood collectives" : "point-to-point");
+    if (inject_every)
+      printf("Particle injection                 = %llu per cell every %llu steps into %llu, %llu, %llu, %llu\n",
+             particles_per_cell, inject_every, inject_patch.left, inject_patch.right,
+             inject_patch.bottom, inject_patch.top);
+    if (remove_every)
+      printf("Particle removal                   = every %llu steps from %llu, %llu, %llu, %llu\n",
+             remove_every, remove_patch.left, remove_patch.right,
+             remove_patch.bottom, remove_patch.top);
   }
   bail_out(error);
 
@@ -891,7 +1202,23 @@ int main(int argc, char ** argv) {
   nbr[6] = (my_IDy == 0           ) ? nbr[0] - Num_procsx + Num_procs : nbr[0] - Num_procsx;
   nbr[7] = (my_IDy == 0           ) ? nbr[1] - Num_procsx + Num_procs : nbr[1] - Num_procsx;
 
+#if MPI_VERSION >= 3
+  /* The same eight ranks are sources and destinations, in the same order. With
+     fewer than three ranks in a direction some of them coincide; the graph then
+     has multiple edges between the same pair of ranks, which MPI matches in the
+     order of the lists. Ranks are not reordered, so nbr stays valid. Edges
+     have explicit unit weights rather than MPI_UNWEIGHTED, a sentinel that
+     compilers take for an empty array                                       */
+  if (neighbor_exchange) {
+    for (i=0; i<8; i++) weights[i] = 1;
+    MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD, 8, nbr, weights,
+                                   8, nbr, weights, MPI_INFO_NULL, 0, &nbr_comm);
+    for (i=0; i<8; i++) types[i] = PARTICLE;
+  }
+#endif
+
   grid = initializeGrid(my_tile);
+  if (cell_grid) cellgrid = initializeCellGrid(my_tile, grid);
 
   switch(particle_mode){
   case GEOMETRIC: 
@@ -923,13 +1250,9 @@ int main(int argc, char ** argv) {
     if (i == my_ID)  printf("Rank %d has %llu particles\n", my_ID, particles_count);
   }
 #endif
-  if (my_ID==root) {
-    MPI_Reduce(&particles_count, &total_particles, 1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
-    printf("Number of particles placed         = %llu\n", total_particles);
-  }
-  else {
-    MPI_Reduce(&particles_count, &total_particles, 1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
-  }
+  MPI_Allreduce(&particles_count, &total_particles, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+  if (my_ID==root) printf("Number of particles placed         = %llu\n", total_particles);
+  next_ID = total_particles;
 
   /* Allocate space for communication buffers. Adjust appropriately as the simulation proceeds */
   
@@ -945,14 +1268,59 @@ int main(int argc, char ** argv) {
   }
   if (error) printf("Rank %d could not allocate communication buffers\n", my_ID);
   bail_out(error);
+
+  if (sort_every) {
+    cell_count  = (uint64_t *)   prk_malloc((iend-istart+1)*(jend-jstart+1)*sizeof(uint64_t));
+    sorted_size = particles_size;
+    sorted      = (particle_t *) prk_malloc(sorted_size*sizeof(particle_t));
+    if (!cell_count || !sorted) {
+      printf("Rank %d could not allocate space for sorting particles\n", my_ID);
+      error = 1;
+    }
+    bail_out(error);
+  }
     
+  prk_harness_init(&harness, "PIC-static", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%llu", (unsigned long long) L);
+  prk_harness_param(&harness, "particles", "%llu", (unsigned long long) n);
+  /* init_mode is only parsed on the root, which is the rank that reports  */
+  prk_harness_param(&harness, "init_mode", "%s", my_ID == root ? init_mode : "");
+  prk_harness_param(&harness, "sort_every", "%llu", (unsigned long long) sort_every);
+  prk_harness_param(&harness, "grid", "%s", cell_grid ? "cell" : "column");
+  prk_harness_param(&harness, "exchange", "%s", neighbor_exchange ? "neighbor" : "p2p");
+
   /* Run the simulation */
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
     if (iter == 1) { 
       MPI_Barrier(MPI_COMM_WORLD);
-      local_pic_time = wtime();
+      step_allocs     = allocs;
+      step_alloc_time = alloc_time;
+    }
+    if (iter >= 1) prk_harness_tick(&harness);
+
+    /* injected particles are appended; removed ones are dropped below, when
+       the particle array is rewritten in place, which leaves no holes       */
+    if (inject_every && iter>0 && iter%inject_every==0) {
+      injected += injectParticles(&particles, &particles_count, &particles_size,
+                                  inject_patch, my_tile, particles_per_cell, k, m, iter, next_ID);
+      next_ID  += (inject_patch.right-inject_patch.left+1)*
+                  (inject_patch.top-inject_patch.bottom+1)*particles_per_cell;
+    }
+    remove_now = remove_every && iter>0 && iter%remove_every==0;
+
+    /* restore the cell order of the particles, including received ones      */
+    if (sort_every && iter>0 && iter%sort_every==0) {
+      double sort_start = wtime();
+      resize_buffer(&sorted, &sorted_size, particles_count);
+      sortByCell(particles, sorted, particles_count, my_tile, cell_count);
+      swap      = particles;   swap_size      = particles_size;
+      particles = sorted;      particles_size = sorted_size;
+      sorted    = swap;        sorted_size    = swap_size;
+      sort_time += wtime() - sort_start;
+      sorts++;
     }
 
     ptr_my = 0;
@@ -961,10 +1329,17 @@ int main(int argc, char ** argv) {
     /* Process own particles */
     p = particles;
 
+    if (iter>0) moves += particles_count;
     for (i=0; i < particles_count; i++) {
+      if (remove_now && contain((uint64_t) p[i].x, (uint64_t) p[i].y, remove_patch)) {
+        removed++;
+        removed_IDs += (uint64_t) p[i].ID;
+        if (iter>0) moves--;
+        continue;
+      }
       fx = 0.0;
       fy = 0.0;
-      computeTotalForce(p[i], my_tile, grid, &fx, &fy);
+      computeTotalForce(p[i], my_tile, grid, cellgrid, &fx, &fy);
 
       ax = fx * MASS_INV;
       ay = fy * MASS_INV;
@@ -1005,36 +1380,78 @@ int main(int argc, char ** argv) {
       }
     }
 
-    /* Communicate the number of particles to be sent/received */
-    for (i=0; i<8; i++) {
-      MPI_Isend(&to_send[i], 1, MPI_UINT64_T, nbr[i], 0, MPI_COMM_WORLD, &requests[i]);
-      MPI_Irecv(&to_recv[i], 1, MPI_UINT64_T, nbr[i], 0, MPI_COMM_WORLD, &requests[8+i]);
+#if MPI_VERSION >= 3
+    if (neighbor_exchange) {
+      MPI_Neighbor_alltoall(to_send, 1, MPI_UINT64_T, to_recv, 1, MPI_UINT64_T, nbr_comm);
+
+      /* receive behind the particles that stayed; send from the per-neighbor
+         buffers in place, addressed relative to MPI_BOTTOM                   */
+      for (total_recv=0, i=0; i<8; i++) total_recv += to_recv[i];
+      reserve_particles(&particles, ptr_my, &particles_size, total_recv);
+      for (total_recv=0, i=0; i<8; i++) {
+        send_counts[i] = (int) to_send[i];
+        MPI_Get_address(sendbuf[i], &send_displs[i]);
+        recv_counts[i] = (int) to_recv[i];
+        MPI_Get_address(&particles[ptr_my+total_recv], &recv_displs[i]);
+        total_recv += to_recv[i];
+      }
+      MPI_Neighbor_alltoallw(MPI_BOTTOM, send_counts, send_displs, types,
+                             MPI_BOTTOM, recv_counts, recv_displs, types, nbr_comm);
+      particles_count = ptr_my + total_recv;
     }
-    MPI_Waitall(16, requests, status);
+    else
+#endif
+    {
+      /* Communicate the number of particles to be sent/received */
+      for (i=0; i<8; i++) {
+        MPI_Isend(&to_send[i], 1, MPI_UINT64_T, nbr[i], 0, MPI_COMM_WORLD, &requests[i]);
+        MPI_Irecv(&to_recv[i], 1, MPI_UINT64_T, nbr[i], 0, MPI_COMM_WORLD, &requests[8+i]);
+      }
+      MPI_Waitall(16, requests, status);
       
-    /* Resize receive buffers if need be */
-    for (i=0; i<8; i++) {
-      resize_buffer(&recvbuf[i], &recvbuf_size[i], to_recv[i]);
-    }
+      /* Resize receive buffers if need be */
+      for (i=0; i<8; i++) {
+        resize_buffer(&recvbuf[i], &recvbuf_size[i], to_recv[i]);
+      }
       
-    /* Communicate the particles */
-    for (i=0; i<8; i++) {
-      MPI_Isend(sendbuf[i], to_send[i], PARTICLE, nbr[i], 0, MPI_COMM_WORLD, &requests[i]);
-      MPI_Irecv(recvbuf[i], to_recv[i], PARTICLE, nbr[i], 0, MPI_COMM_WORLD, &requests[8+i]);
-    }
-    MPI_Waitall(16, requests, status);
+      /* Communicate the particles */
+      for (i=0; i<8; i++) {
+        MPI_Isend(sendbuf[i], to_send[i], PARTICLE, nbr[i], 0, MPI_COMM_WORLD, &requests[i]);
+        MPI_Irecv(recvbuf[i], to_recv[i], PARTICLE, nbr[i], 0, MPI_COMM_WORLD, &requests[8+i]);
+      }
+      MPI_Waitall(16, requests, status);
      
-    /* Attach received particles to particles buffer */
-    for (i=0; i<4; i++) {
-      attach_received_particles(&particles, &ptr_my, &particles_size, recvbuf[2*i], to_recv[2*i], 
-                                recvbuf[2*i+1], to_recv[2*i+1]);
-    }    
-    particles_count = ptr_my;
+      /* Attach received particles to particles buffer */
+      for (i=0; i<4; i++) {
+        attach_received_particles(&particles, &ptr_my, &particles_size, recvbuf[2*i], to_recv[2*i], 
+                                  recvbuf[2*i+1], to_recv[2*i+1]);
+      }    
+      particles_count = ptr_my;
+    }
+
+    buffer_size = particles_size + (sort_every ? sorted_size : 0);
+    for (i=0; i<8; i++) buffer_size += sendbuf_size[i] + recvbuf_size[i];
+    peak_buffer = MAX(peak_buffer, buffer_size);
   }
    
-  local_pic_time = MPI_Wtime() - local_pic_time;
+  prk_harness_tick(&harness);
+  local_pic_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_pic_time, &pic_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
+  MPI_Reduce(&sort_time, &max_sort_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
+  MPI_Reduce(&moves, &tot_moves, 1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
+  if (inject_every || remove_every) {
+    step_allocs     = allocs - step_allocs;
+    step_alloc_time = alloc_time - step_alloc_time;
+    MPI_Reduce(&injected,        &tot_injected,    1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
+    MPI_Reduce(&removed,         &tot_removed,     1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
+    MPI_Reduce(&removed_IDs,     &tot_removed_IDs, 1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
+    MPI_Reduce(&step_allocs,     &tot_allocs,      1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
+    MPI_Reduce(&step_alloc_time, &max_alloc_time,  1, MPI_DOUBLE,   MPI_MAX, root, MPI_COMM_WORLD);
+    MPI_Reduce(&peak_buffer,     &max_peak_buffer, 1, MPI_UINT64_T, MPI_MAX, root, MPI_COMM_WORLD);
+  }
+  else tot_injected = tot_removed = tot_removed_IDs = 0;
    
   /* Run the verification test */
   /* First verify own particles */
@@ -1048,18 +1465,32 @@ int main(int argc, char ** argv) {
   /* Gather total checksum of correctness flags */
   MPI_Reduce(&correctness, &correctness_checksum, 1, MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
 
+  /* the live particles are the placed and injected ones minus the removed
+     ones, and so are their IDs                                              */
   if ( my_ID == root) {
+    total_particles += tot_injected - tot_removed;
     if (correctness_checksum != total_particles ) {
       printf("ERROR: there are %llu miscalculated locations\n", total_particles-correctness_checksum);
     }
     else {
-      if (tot_checksum != (total_particles*(total_particles+1))/2) {
+      if (tot_checksum != (next_ID*(next_ID+1))/2 - tot_removed_IDs) {
         printf("ERROR: Particle checksum incorrect\n");
       }
       else {
-        avg_time = total_particles*iterations/pic_time;
+        avg_time = tot_moves/pic_time;
         printf("Solution validates\n");
         printf("Rate (Mparticles_moved/s): %lf\n", 1.0e-6*avg_time);
+        if (sort_every)
+          printf("Sort time (s): %lf in %llu sorts, %.1lf%% of time steps (max over ranks)\n",
+                 max_sort_time, sorts, 100.0*max_sort_time/pic_time);
+        if (inject_every || remove_every) {
+          printf("Particles injected/removed: %llu/%llu, %llu live at the end\n",
+                 tot_injected, tot_removed, total_particles);
+          printf("Allocation time (s): %lf in %llu buffer allocations during the time steps (max over ranks)\n",
+                 max_alloc_time, tot_allocs);
+          printf("Particle buffer memory (MB): %.3lf peak (max over ranks), %.3lf live at the end\n",
+                 1.0e-6*max_peak_buffer*sizeof(particle_t), 1.0e-6*total_particles*sizeof(particle_t));
+        }
       }
     }
   }
@@ -1071,6 +1502,14 @@ int main(int argc, char ** argv) {
   }
 #endif
 
+  /* tot_moves is only known on the root, which is the rank that reports    */
+  prk_harness_report(&harness, "Mparticles_moved/s", 1.0e-6*tot_moves/iterations);
+  prk_harness_finalize(&harness);
+
+#if MPI_VERSION >= 3
+  if (neighbor_exchange) MPI_Comm_free(&nbr_comm);
+#endif
+
   MPI_Finalize();
    
   return 0;
@@ -80,13 +80,38 @@ USAGE:   The program takes as input the 2log of the size of the table that
 
          <progname> <log2 tablesize> <#update ratio> 
 
+         By default each step generates LOOKAHEAD random numbers, sorts them
+         into send buckets, and exchanges and applies them with blocking
+         collectives, so generation, communication and table update are
+         strictly sequential.  With PRK_EXCHANGE=pipelined (requires MPI-3)
+         two sets of buckets are used: while the nonblocking MPI_Ialltoallv
+         of step i+1 is in flight, the updates received in step i are
+         applied to the table, and the exchange of step i overlaps with the
+         generation of step i+1.  PRK_EXCHANGE=blocking selects the default.
+
+         With PRK_PROGRESS=1|spare|cpu:<k> a helper thread polls the MPI
+         library while the rank computes, so that messages progress
+         asynchronously (see prk_progress.h).
+
+         PRK_TABLESIZE=n replaces the table size 2^<log2 tablesize> with
+         any n up to 2^32 that is a multiple of the number of ranks, and
+         PRK_DISTRIBUTION=uniform|hotset:<f>,<p>|zipf:<theta> draws the
+         table indices from a skewed distribution instead of a uniform
+         one (see prk_random_index.h).  The hot entries are the lowest
+         indices, so they live on the first rank(s).  The indices are
+         computed from the same random numbers, so the verification
+         stays exact.
+
 FUNCTIONS CALLED:
 
          Other than MPI or standard C functions, the following 
          functions are used in this program:
 
          wtime
+         prk_progress_*()
          bail_out()
+         prk_harness_*()
+         prk_index()
          PRK_starts
          poweroftwo
 
@@ -139,6 +164,8 @@ HISTORY: Written by Rob Van der Wijngaart, December 2007.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_random_index.h>
+#include <prk_harness.h>
 
 /* Define 64-bit types and corresponding format strings for printf() and constants */
 /* PERIOD = (2^63-1)/7 = 7*73*127*337*92737*649657                                 */
@@ -177,7 +204,9 @@ int main(int argc, char **argv) {
   int               *recvdispls; /* successive dispalcemetns in receive buffer     */
   u64Int * RESTRICT Table;       /* (pseudo-)randomly accessed array               */
   double            random_time, /* timing parameters                              */
+                    local_random_time,
                     avgtime = 0.0;
+  prk_harness_t     harness;     /* timing and counters of the update phase        */
   int               Num_procs,   /* rank parameters                                */
                     my_ID,       /* rank of calling rank                           */
                     root=0;      /* ID of master rank                              */
@@ -187,6 +216,23 @@ int main(int argc, char **argv) {
   int               log2nstarts; /* log2 of vector length                          */
   int               log2tablesize; /* log2 of aggregate table size                 */
   int               log2update_ratio; /* log2 of update ratio                      */
+  int               pipelined=0; /* overlap exchange with generation and update    */
+  char              *env;        /* value of PRK_EXCHANGE                          */
+  prk_index_t       ix;          /* mapping of random numbers to table indices     */
+  const char        *msg;        /* error message of prk_index_init                */
+  char              dist[96];    /* description of the index distribution          */
+  int               log2loc;     /* log2 of local table size (power of two)        */
+#if MPI_VERSION >= 3
+  s64Int            nsteps;      /* number of exchange steps per round             */
+  int               b;           /* bucket set used in current step                */
+  u64Int            *sendBuf[2], /* send and receive buffers of both bucket sets   */
+                    *recvBuf[2];
+  int               *sizeSend[2],/* bucket sizes and offsets of both bucket sets   */
+                    *sizeRecv[2],
+                    *rdispls[2],
+                    sizeTotal[2];
+  MPI_Request       request[2];  /* outstanding exchanges of both bucket sets      */
+#endif
 
 #if LONG_IS_64BITS
   if (sizeof(long) != 8) {
@@ -200,7 +246,7 @@ int main(int argc, char **argv) {
 ** rank and test input parameters    
 ************************************************************************************/
 
-  MPI_Init(&argc,&argv);
+  prk_progress_init(&argc,&argv);
   MPI_Comm_size(MPI_COMM_WORLD,&Num_procs);
   MPI_Comm_rank(MPI_COMM_WORLD,&my_ID);
 
@@ -272,9 +318,21 @@ int main(int argc, char **argv) {
       goto ENDOFTESTS;
     }
 
-    if ((log2tablesize + log2update_ratio) < (log2nproc+log2nstarts)) {
+    env = getenv("PRK_TABLESIZE");
+    if (env != NULL && *env != '\0') {
+      tablesize = atoll(env);
+      if (tablesize < Num_procs || tablesize%Num_procs) {
+        printf("ERROR: PRK_TABLESIZE must be a positive multiple of the number of ranks: %s\n",
+               env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+      loctablesize = tablesize/Num_procs;
+    }
+
+    if ((double) tablesize*update_ratio < (double) Num_procs*nstarts) {
       printf("ERROR: Table size ("FSTR64U") times update ratio (%d) must be at ",
-             ((s64Int)1<<log2tablesize), update_ratio);
+             tablesize, update_ratio);
       printf("least equal to number of ranks (%d) times vector length (%d)\n", 
              Num_procs, nstarts);
       error = 1;
@@ -299,12 +357,47 @@ int main(int argc, char **argv) {
       error = 1;
       goto ENDOFTESTS;
     }
+    /* every stream does the same number of updates in each of two rounds          */
+    nupdate = nupdate/(2*nstarts)*(2*nstarts);
+    if (nupdate == 0) {
+      printf("ERROR: local table size times update ratio must be at least twice ");
+      printf("the vector length (%d)\n", nstarts);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    msg = prk_index_init(&ix, tablesize);
+    if (msg) {
+      printf("ERROR: %s\n", msg);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_EXCHANGE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"pipelined")) pipelined = 1;
+      else if (strcmp(env,"blocking")) {
+        printf("ERROR: PRK_EXCHANGE must be blocking or pipelined: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+#if MPI_VERSION < 3
+    if (pipelined) {
+      printf("ERROR: PRK_EXCHANGE=pipelined requires MPI-3\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
 
     printf("Number of ranks               = "FSTR64U"\n", (u64Int) Num_procs);
     printf("Table size (aggregate)        = "FSTR64U"\n", tablesize);
     printf("Update ratio                  = "FSTR64U"\n", (u64Int) update_ratio);
     printf("Number of updates (aggregate) = "FSTR64U"\n", nupdate*Num_procs);
     printf("Vector (LOOKAHEAD) length     = "FSTR64U"\n", (u64Int) nstarts);
+    printf("Index distribution            = %s\n", prk_index_describe(&ix, dist, sizeof(dist)));
+    printf("Bucket exchange               = %s\n", pipelined ? "pipelined" : "blocking");
+    printf("Progress thread               = %s\n", prk_progress_mode());
 
     ENDOFTESTS:;
   }
@@ -321,6 +414,12 @@ int main(int argc, char **argv) {
   MPI_Bcast(&loctablesize,     1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&tablespace,       1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&nupdate,          1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&pipelined,        1, MPI_INT,           root, MPI_COMM_WORLD);
+
+  /* every rank sets up the same mapping from PRK_DISTRIBUTION, which the root
+     has checked                                                                   */
+  if (my_ID != root) prk_index_init(&ix, tablesize);
+  for (log2loc=0; ((s64Int) 1<<log2loc) < loctablesize; log2loc++);
 
   ran = (u64Int *) prk_malloc(nstarts*sizeof(u64Int));
   if (!ran) {
@@ -347,7 +446,8 @@ int main(int argc, char **argv) {
   bail_out(error);
   ranRecvBucket = ranSendBucket + Num_procs;
 
-  ranSendBucket[0] = (u64Int *) prk_malloc(2*Num_procs*nstarts*sizeof(u64Int));
+  /* the pipelined exchange needs a second set of send and receive buckets        */
+  ranSendBucket[0] = (u64Int *) prk_malloc((pipelined?4:2)*Num_procs*nstarts*sizeof(u64Int));
   if (!ranSendBucket[0]) {
     printf("ERROR: rank %d Could not allocate bucket space\n", my_ID);
     error = 1;
@@ -360,7 +460,7 @@ int main(int argc, char **argv) {
   ranRecvBucket[0] = ranSendBucket[0] + Num_procs*nstarts;
 
   /* allocate send and receive bucket sizes plus buffer offsets                    */
-  sizeSendBucket = (int *) prk_malloc(4*Num_procs*sizeof(int));
+  sizeSendBucket = (int *) prk_malloc((pipelined?7:4)*Num_procs*sizeof(int));
   if (!sizeSendBucket) {
     printf("ERROR: rank %d Could not allocate bucket sizes\n", my_ID);
     error = 1;
@@ -376,13 +476,37 @@ int main(int argc, char **argv) {
   /* only the first receive displacement is always the same                        */
   recvdispls[0] = 0;
 
+#if MPI_VERSION >= 3
+  if (pipelined) {
+    /* bucket set 0 is the regular one, set 1 lives behind it                      */
+    sendBuf[0]  = ranSendBucket[0];
+    recvBuf[0]  = ranRecvBucket[0];
+    sendBuf[1]  = ranSendBucket[0] + 2*Num_procs*nstarts;
+    recvBuf[1]  = sendBuf[1]       +   Num_procs*nstarts;
+    sizeSend[0] = sizeSendBucket;
+    sizeRecv[0] = sizeRecvBucket;
+    rdispls[0]  = recvdispls;
+    sizeSend[1] = recvdispls       + Num_procs;
+    sizeRecv[1] = sizeSend[1]      + Num_procs;
+    rdispls[1]  = sizeRecv[1]      + Num_procs;
+    rdispls[1][0] = 0;
+  }
+#endif
+
   /* initialize the table */
   for(i=0;i<loctablesize;i++) Table[i] = (u64Int) (i+ loctablesize*my_ID);
 
+  prk_harness_init(&harness, "Random", "MPI1", 1);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "tablesize", "%lld", (long long) tablesize);
+  prk_harness_param(&harness, "update_ratio", "%d", update_ratio);
+  prk_harness_param(&harness, "vector_length", "%d", nstarts);
+  prk_harness_param(&harness, "distribution", "%s", prk_index_describe(&ix, dist, sizeof(dist)));
+  prk_harness_param(&harness, "exchange", "%s", pipelined ? "pipelined" : "blocking");
+  prk_harness_param(&harness, "progress", "%s", prk_progress_mode());
+
   MPI_Barrier(MPI_COMM_WORLD);
-  if (my_ID == root) {
-    random_time = wtime();
-  }
+  prk_harness_tick(&harness);
 
   /* do two identical rounds of Random Access to ensure we recover initial table   */
   for (round=0; round <2; round++) {
@@ -391,6 +515,49 @@ int main(int argc, char **argv) {
       ran[j] = PRK_starts(SEQSEED+(nupdate/nstarts)*j+loctablesize*my_ID);
     }
 
+#if MPI_VERSION >= 3
+    if (pipelined) {
+      /* software pipeline: step i uses bucket set i%2; the exchange of step i is
+         completed and its updates are applied only after step i+1 has been
+         generated and its own exchange has been started                           */
+      nsteps = nupdate/(nstarts*2);
+      for (i=0; i<=nsteps; i++) {
+        b = i%2;
+        if (i<nsteps) {
+          for (proc=0; proc<Num_procs; proc++) sizeSend[b][proc] = 0;
+
+          for (j=0; j<nstarts; j++) {
+            ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
+            global_index = prk_index(&ix, ran[j]);
+            dest = ix.mask ? global_index>>log2loc : global_index/loctablesize;
+            sendBuf[b][senddispls[dest]+sizeSend[b][dest]++] = ran[j];
+          }
+
+          /* the sizes are needed to post the data exchange, so this is blocking   */
+          MPI_Alltoall(sizeSend[b], 1, MPI_INT, sizeRecv[b], 1, MPI_INT, MPI_COMM_WORLD);
+          for (proc=1; proc<Num_procs; proc++)
+            rdispls[b][proc] = rdispls[b][proc-1]+sizeRecv[b][proc-1];
+          sizeTotal[b] = rdispls[b][Num_procs-1]+sizeRecv[b][Num_procs-1];
+
+          MPI_Ialltoallv(sendBuf[b], sizeSend[b], senddispls,  MPI_LONG_LONG_INT,
+                         recvBuf[b], sizeRecv[b], rdispls[b], MPI_LONG_LONG_INT,
+                         MPI_COMM_WORLD, &request[b]);
+        }
+
+        /* apply the updates of the previous step while this step is in flight     */
+        if (i>0) {
+          MPI_Wait(&request[1-b], MPI_STATUS_IGNORE);
+          for (j=0; j<sizeTotal[1-b]; j++) {
+            index = ix.mask ? recvBuf[1-b][j] & (loctablesize-1) :
+                    prk_index(&ix, recvBuf[1-b][j]) - loctablesize*my_ID;
+            Table[index] ^= recvBuf[1-b][j];
+          }
+        }
+      }
+      continue;
+    }
+#endif
+
     /* because we do two rounds, we divide nupdate in two                          */
     for (i=0; i<nupdate/(nstarts*2); i++) {
 
@@ -400,9 +567,10 @@ int main(int argc, char **argv) {
       for (j=0; j<nstarts; j++) {
         /* compute new random number                                               */
         ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
-        global_index = (ran[j] & (tablesize-1));
-        /* determine destination rank (high order bits of global table index)      */
-        dest = global_index>>(log2tablesize-log2nproc);
+        global_index = prk_index(&ix, ran[j]);
+        /* determine destination rank (high order bits of global table index, 
+           or the quotient by the local table size if that is no power of two)     */
+        dest = ix.mask ? global_index>>log2loc : global_index/loctablesize;
         /* place new random number in first available element of the appropriate 
            send bucket and increment that bucket size                              */
         ranSendBucket[dest][sizeSendBucket[dest]++] = ran[j];
@@ -429,13 +597,17 @@ int main(int argc, char **argv) {
       /*  #pragma ivdep */
       /*  #pragma vector always */
       for (j=0; j<sizeRecvTotal; j++) {
-        index = ranRecvBucket[0][j] & (loctablesize-1);
+        index = ix.mask ? ranRecvBucket[0][j] & (loctablesize-1) :
+                prk_index(&ix, ranRecvBucket[0][j]) - loctablesize*my_ID;
         Table[index] ^= ranRecvBucket[0][j];
       }
     }
   }
 
-  if (my_ID == root) random_time = wtime() - random_time;
+  prk_harness_tick(&harness);
+  local_random_time = prk_harness_elapsed(&harness);
+  MPI_Reduce(&local_random_time, &random_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
 
   /* verification test */
   for(i=0;i<loctablesize;i++) {
@@ -464,7 +636,11 @@ int main(int argc, char **argv) {
     }
   }
 
-  MPI_Finalize();
+  prk_harness_model(&harness, 0.0, 2.0*64*nupdate*Num_procs);
+  prk_harness_report(&harness, "GUPS/s", 1.e-9*(nupdate*Num_procs));
+  prk_harness_finalize(&harness);
+
+  prk_progress_finalize();
 }
 
 /* Utility routine to start random number generator at nth step                    */
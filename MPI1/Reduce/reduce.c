@@ -48,6 +48,18 @@ USAGE:   The program takes as input the length of the vectors, plus the
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         PRK_COLLECTIVE selects how the reduction is issued:
+           blocking     MPI_Reduce (default)
+           nonblocking  MPI_Ireduce (MPI-3), overlapped with local work
+           persistent   a persistent reduction started every iteration
+                        (MPI-4 MPI_Reduce_init, or the Open MPI extension)
+         In the last two modes each rank does synthetic local work of about
+         the duration of a blocking reduction (measured at startup) before
+         it waits for the reduction to complete. The overlap fraction is the
+         part of the shorter of the two that was hidden behind the other;
+         it is 0 if the library only progresses the reduction inside
+         MPI_Wait. The reported time then includes the local work.
+
 FUNCTIONS CALLED:
 
          Other than MPI or standard C functions, the following external 
@@ -55,6 +67,10 @@ FUNCTIONS CALLED:
 
          wtime();
          bail_out();
+         prk_harness_*();
+         prk_overlap_work();
+         prk_overlap_reps();
+         prk_overlap_fraction();
 
 HISTORY: Written by Rob Van der Wijngaart, March 2006.
          Modified by Rob Van der Wijngaart, November 2014
@@ -66,6 +82,15 @@ HISTORY: Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+
+#define BLOCKING    0
+#define NONBLOCKING 1
+#define PERSISTENT  2
+
+/* size of the local work array (doubles) and number of calibration runs     */
+#define WORKLEN     4096
+#define CALIBRATE   5
 
 int main(int argc, char ** argv)
 {
@@ -83,6 +108,19 @@ int main(int argc, char ** argv)
   double epsilon=1.e-8; /* error tolerance                                   */
   double element_value; /* verification value                                */
   int    error = 0;     /* error flag                                        */
+  int    collective = BLOCKING; /* how the reduction is issued               */
+  char   *env;          /* value of PRK_COLLECTIVE                           */
+  double * RESTRICT scratch; /* vector reduced to time blocking reductions   */
+  double *work;         /* local work array                                  */
+  long   reps;          /* passes over the work array per iteration          */
+  double coll_time,     /* time of a blocking reduction                      */
+         local_work_time=0.0, /* time spent in local work                     */
+         work_time,
+         t0;
+  prk_harness_t harness; /* per-iteration timing                              */
+#if MPI_VERSION >= 3
+  MPI_Request request;  /* request of nonblocking or persistent reduction    */
+#endif
 
   /***************************************************************************
   ** Initialize the MPI environment
@@ -119,6 +157,32 @@ int main(int argc, char ** argv)
       goto ENDOFTESTS;
     }
 
+    env = getenv("PRK_COLLECTIVE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"nonblocking")) collective = NONBLOCKING;
+      else if (!strcmp(env,"persistent"))  collective = PERSISTENT;
+      else if (strcmp(env,"blocking")) {
+        printf("ERROR: PRK_COLLECTIVE must be blocking, nonblocking, or persistent: %s\n",
+               env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+#if MPI_VERSION < 3
+    if (collective == NONBLOCKING) {
+      printf("ERROR: PRK_COLLECTIVE=nonblocking requires MPI-3\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
+#ifndef PRK_HAVE_PERSISTENT_COLLECTIVES
+    if (collective == PERSISTENT) {
+      printf("ERROR: PRK_COLLECTIVE=persistent requires MPI-4 persistent collectives\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
+
     ENDOFTESTS:;
   }
   bail_out(error);
@@ -128,12 +192,17 @@ int main(int argc, char ** argv)
     printf("Number of ranks      = %d\n", Num_procs);
     printf("Vector length        = %ld\n", vector_length);
     printf("Number of iterations = %d\n", iterations);     
+    printf("Collective           = %s\n", collective==BLOCKING    ? "blocking" :
+                                           collective==NONBLOCKING ? "nonblocking" :
+                                                                     "persistent");
   }
 
   /* Broadcast benchmark data to all ranks */
   MPI_Bcast(&iterations,    1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&vector_length, 1, MPI_LONG, root, MPI_COMM_WORLD);
-  vector= (double *) prk_malloc(2*vector_length*sizeof(double)); 
+  MPI_Bcast(&collective,    1, MPI_INT, root, MPI_COMM_WORLD);
+  /* the overlap modes need a third vector to time blocking reductions       */
+  vector= (double *) prk_malloc((collective==BLOCKING ? 2 : 3)*vector_length*sizeof(double)); 
   if (vector==NULL) {
     printf("ERROR: Could not allocate space %ld for vector in rank %d\n", 
            2*vector_length*sizeof(double),my_ID);
@@ -141,6 +210,7 @@ int main(int argc, char ** argv)
   }
   bail_out(error);
   ones = vector + vector_length;
+  scratch = ones + vector_length;
 
   /* initialize the arrays                                                    */
   for (i=0; i<vector_length; i++) {
@@ -148,13 +218,53 @@ int main(int argc, char ** argv)
     ones[i]    = (double)1;
   }
 
+  if (collective != BLOCKING) {
+    work = (double *) prk_malloc(WORKLEN*sizeof(double));
+    if (work==NULL) {
+      printf("ERROR: Could not allocate space for local work in rank %d\n", my_ID);
+      error = 1;
+    }
+    bail_out(error);
+    for (i=0; i<WORKLEN; i++) work[i] = 0.0;
+    for (i=0; i<vector_length; i++) scratch[i] = 0.0;
+
+    /* size the local work to match a blocking reduction, after a warmup     */
+    for (iter=0; iter<=CALIBRATE; iter++) {
+      if (iter == 1) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        coll_time = wtime();
+      }
+      MPI_Reduce(my_ID == root ? MPI_IN_PLACE : scratch, my_ID == root ? scratch : NULL,
+                 vector_length, MPI_DOUBLE, MPI_SUM, root, MPI_COMM_WORLD);
+    }
+    coll_time = (wtime() - coll_time)/CALIBRATE;
+    MPI_Allreduce(MPI_IN_PLACE, &coll_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    reps = prk_overlap_reps(work, WORKLEN, coll_time);
+  }
+
+#ifdef PRK_HAVE_PERSISTENT_COLLECTIVES
+  if (collective == PERSISTENT) {
+    if (my_ID == root)
+      PRK_Reduce_init(MPI_IN_PLACE, vector, vector_length, MPI_DOUBLE, MPI_SUM, 
+                      root, MPI_COMM_WORLD, MPI_INFO_NULL, &request);
+    else
+      PRK_Reduce_init(vector, NULL, vector_length, MPI_DOUBLE, MPI_SUM, 
+                      root, MPI_COMM_WORLD, MPI_INFO_NULL, &request);
+  }
+#endif
+
+  prk_harness_init(&harness, "Reduce", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "vector_length", "%ld", vector_length);
+  prk_harness_param(&harness, "collective", "%s", collective == BLOCKING    ? "blocking"    :
+                                                  collective == NONBLOCKING ? "nonblocking" :
+                                                                              "persistent");
+
   for (iter=0; iter<=iterations; iter++) { 
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_reduce_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* first do the "local" part                                                */
     for (i=0; i<vector_length; i++) {
@@ -162,18 +272,46 @@ int main(int argc, char ** argv)
     }
 
     /* now do the "non-local" part                                              */
-    if (my_ID == root)
-      MPI_Reduce(MPI_IN_PLACE, vector, vector_length, MPI_DOUBLE, MPI_SUM, 
-                 root, MPI_COMM_WORLD);
-    else
-      MPI_Reduce(vector, NULL, vector_length, MPI_DOUBLE, MPI_SUM, 
-                 root, MPI_COMM_WORLD);
+    if (collective == BLOCKING) {
+      if (my_ID == root)
+        MPI_Reduce(MPI_IN_PLACE, vector, vector_length, MPI_DOUBLE, MPI_SUM, 
+                   root, MPI_COMM_WORLD);
+      else
+        MPI_Reduce(vector, NULL, vector_length, MPI_DOUBLE, MPI_SUM, 
+                   root, MPI_COMM_WORLD);
+    }
+#if MPI_VERSION >= 3
+    else {
+      if (collective == NONBLOCKING) {
+        if (my_ID == root)
+          MPI_Ireduce(MPI_IN_PLACE, vector, vector_length, MPI_DOUBLE, MPI_SUM, 
+                      root, MPI_COMM_WORLD, &request);
+        else
+          MPI_Ireduce(vector, NULL, vector_length, MPI_DOUBLE, MPI_SUM, 
+                      root, MPI_COMM_WORLD, &request);
+      }
+      else MPI_Start(&request);
+
+      /* local work that does not touch the vector overlaps the reduction     */
+      t0 = wtime();
+      prk_overlap_work(work, WORKLEN, reps);
+      if (iter > 0) local_work_time += wtime() - t0;
+
+      MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }
+#endif
 
   } /* end of iterations */
 
-  local_reduce_time = wtime() - local_reduce_time;
+  prk_harness_tick(&harness);
+  local_reduce_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_reduce_time, &reduce_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
+  MPI_Reduce(&local_work_time, &work_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
+#ifdef PRK_HAVE_PERSISTENT_COLLECTIVES
+  if (collective == PERSISTENT) MPI_Request_free(&request);
+#endif
   
 
   /* verify correctness */
@@ -204,8 +342,16 @@ int main(int argc, char ** argv)
     avgtime = reduce_time/(double)iterations;
     printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
            1.0E-06 * (2.0*Num_procs-1.0)*vector_length/ avgtime, avgtime);
+    if (collective != BLOCKING) {
+      work_time /= (double)iterations;
+      printf("Blocking reduction (s): %lf  Local work (s): %lf  Overlap fraction: %lf\n",
+             coll_time, work_time, prk_overlap_fraction(coll_time, work_time, avgtime));
+    }
   }
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0*Num_procs-1.0)*vector_length);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 
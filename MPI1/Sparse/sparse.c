@@ -44,6 +44,15 @@ USAGE:   The program takes as input the 2log of the linear size of the 2D grid
 
          <progname> <# iterations> <2log root-of-matrix-order> <radius>
   
+         By default every rank gathers the whole vector with MPI_Allgather
+         in every iteration.  With PRK_EXCHANGE=halo an inspector finds,
+         once before the iterations, which vector entries of other ranks
+         the local rows refer to, agrees on send and receive lists with
+         their owners, and renumbers the column indices into a local
+         vector of the owned entries followed by these halo entries.
+         Every iteration then exchanges only the halo entries, with
+         point-to-point messages between ranks that share any.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
@@ -54,9 +63,11 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
          reverse()
          qsort()
          compare
+         build_halo(), exchange_halo()
 
 NOTES:   
 
@@ -69,6 +80,7 @@ HISTORY: Written by Rob Van der Wijngaart, October 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 /* linearize the grid index                                                       */
 #define LIN(i,j) (i+((j)<<lsize))
@@ -90,6 +102,22 @@ HISTORY: Written by Rob Van der Wijngaart, October 2006.
 static u64Int reverse(register u64Int, int);
 static int compare(const void *el1, const void *el2);
 
+/* send and receive lists of the halo exchange                                    */
+typedef struct {
+  s64Int   nrows;        /* number of owned vector entries                        */
+  s64Int   nhalo;        /* number of vector entries received from other ranks    */
+  int      *recv_count,  /* entries received from each rank, stored after the     */
+           *recv_displ;  /* owned ones in the order of their global indices       */
+  int      *send_count,  /* entries sent to each rank, ...                        */
+           *send_displ;
+  s64Int   *send_index;  /* ... and their local indices                           */
+  double   *send_buffer;
+  MPI_Request *requests;
+} halo_t;
+
+static int  build_halo(s64Int, s64Int, s64Int, int, s64Int *, halo_t *);
+static void exchange_halo(halo_t *, double *, int);
+
 int main(int argc, char **argv){
 
   int               Num_procs;  /* Number of ranks                                */
@@ -134,6 +162,13 @@ int main(int argc, char **argv){
   size_t            vector_space, /* variables used to hold prk_malloc sizes          */
                     matrix_space,
                     index_space;
+  int               halo_exchange = 0; /* exchange only the halo of the vector    */
+  halo_t            halo;       /* send and receive lists of the halo exchange    */
+  s64Int            nhalo_sum;  /* total number of halo entries of all ranks      */
+  double            inspect_time; /* time to build the halo exchange              */
+  double * RESTRICT own_vector; /* entries of vector owned by this rank           */
+  char              *env;       /* value of PRK_EXCHANGE                          */
+  prk_harness_t     harness;    /* per-iteration timing                           */
 
 /*********************************************************************
 ** Initialize the MPI environment
@@ -204,6 +239,16 @@ int main(int argc, char **argv){
       goto ENDOFTESTS;
     }
  
+    env = getenv("PRK_EXCHANGE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"halo")) halo_exchange = 1;
+      else if (strcmp(env,"allgather")) {
+        printf("ERROR: PRK_EXCHANGE must be allgather or halo: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
     /* sparsity follows from number of non-zeroes per row                           */
     sparsity = (double)(4*radius+1)/(double)size2;
 
@@ -222,6 +267,7 @@ int main(int argc, char **argv){
 #else
     printf("Matrix storage format = Compressed Sparse Row\n");
 #endif
+    printf("Vector exchange       = %s\n", halo_exchange ? "halo" : "allgather");
 
     ENDOFTESTS:;
   }
@@ -234,6 +280,7 @@ int main(int argc, char **argv){
   MPI_Bcast(&size2,      1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&radius,     1, MPI_INT,           root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&halo_exchange, 1, MPI_INT,        root, MPI_COMM_WORLD);
 
   /* compute total size of star stencil in 2D                                     */
   stencil_size = 4*radius+1;
@@ -253,14 +300,6 @@ int main(int argc, char **argv){
   bail_out(error);
 
   vector_space = (size2 + nrows)*sizeof(double);
-  vector = (double *) prk_malloc(vector_space);
-  if (!vector) {
-    printf("ERROR: rank %d could not allocate space for vectors: %d\n", 
-           my_ID, (int)(2*nrows));
-    error = 1;
-  }
-  bail_out(error);
-  result = vector + size2;
 
   index_space = nent*sizeof(s64Int);
   colIndex = (s64Int *) prk_malloc(index_space);
@@ -316,24 +355,59 @@ int main(int argc, char **argv){
   }
 #endif
 
+  /* with the halo exchange the vector holds the owned entries and the halo,
+     and the column indices refer to them                                         */
+  row_offset = nrows*my_ID;
+  if (halo_exchange) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    inspect_time = wtime();
+    error = build_halo(nrows, nent, row_offset, Num_procs, colIndex, &halo);
+    if (error) printf("ERROR: rank %d could not allocate space for halo lists\n", my_ID);
+    bail_out(error);
+    inspect_time = wtime() - inspect_time;
+    MPI_Reduce(&halo.nhalo, &nhalo_sum, 1, MPI_LONG_LONG_INT, MPI_SUM, root, 
+               MPI_COMM_WORLD);
+    vector_space = (2*nrows + halo.nhalo)*sizeof(double);
+  }
+
+  vector = (double *) prk_malloc(vector_space);
+  if (!vector) {
+    printf("ERROR: rank %d could not allocate space for vectors: %d\n", 
+           my_ID, (int)(2*nrows));
+    error = 1;
+  }
+  bail_out(error);
+  if (halo_exchange) {
+    own_vector = vector;
+    result     = vector + nrows + halo.nhalo;
+  }
+  else {
+    own_vector = vector + row_offset;
+    result     = vector + size2;
+  }
+
   /* initialize the input and result vectors                                      */
-  for (row=0; row<nrows; row++) result[row] = vector[row] = 0.0;
+  for (row=0; row<nrows; row++) result[row] = own_vector[row] = 0.0;
+
+  prk_harness_init(&harness, "Sparse", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "log2_grid_size", "%d", lsize);
+  prk_harness_param(&harness, "radius", "%d", radius);
+  prk_harness_param(&harness, "exchange", "%s", halo_exchange ? "halo" : "allgather");
 
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_sparse_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* fill vector                                                                */
-    row_offset = nrows*my_ID;
-    for (row=row_offset; row<nrows+row_offset; row++) vector[row] += (double) (row+1);
+    for (row=0; row<nrows; row++) own_vector[row] += (double) (row+row_offset+1);
 
-    /* replicate vector on all ranks                                              */
-    MPI_Allgather(MPI_IN_PLACE, nrows, MPI_DOUBLE, vector, nrows, MPI_DOUBLE,
-                  MPI_COMM_WORLD);
+    /* replicate the vector, or the entries of it that are needed, on all ranks   */
+    if (halo_exchange) exchange_halo(&halo, vector, Num_procs);
+    else MPI_Allgather(MPI_IN_PLACE, nrows, MPI_DOUBLE, vector, nrows, MPI_DOUBLE,
+                       MPI_COMM_WORLD);
 
     /* do the actual matrix multiplication                                        */
     for (row=0; row<nrows; row++) {
@@ -346,7 +420,8 @@ int main(int argc, char **argv){
     }
   } /* end of iterations                                                          */
 
-  local_sparse_time = wtime() - local_sparse_time;
+  prk_harness_tick(&harness);
+  local_sparse_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_sparse_time, &sparse_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
@@ -386,10 +461,17 @@ int main(int argc, char **argv){
     avgtime = sparse_time/iterations;
     printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
            1.0E-06 * (2.0*nent*Num_procs)/avgtime, avgtime);
+    if (halo_exchange) {
+      printf("Halo entries per rank = %16.1lf\n", (double) nhalo_sum/Num_procs);
+      printf("Halo inspection time (s): %lf\n", inspect_time);
+    }
   }
 
   bail_out(error);
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0*nent*Num_procs));
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 }
@@ -421,3 +503,92 @@ int compare(const void *el1, const void *el2) {
   return (v1<v2) ? -1 : (v1>v2) ? 1 : 0;
 }
 
+
+/* Inspector of the halo exchange.  Find the distinct column indices of the
+   nent local nonzeroes outside the owned rows [row_offset,row_offset+nrows)
+   (rank p owns rows p*nrows to (p+1)*nrows-1), tell their owners which
+   entries to send, and renumber colIndex into a local vector that holds
+   the owned entries followed by the halo entries in increasing global
+   order.  It is collective; returns nonzero if space ran out            */
+int build_halo(s64Int nrows, s64Int nent, s64Int row_offset, int Num_procs,
+               s64Int *colIndex, halo_t *halo) {
+
+  s64Int *needed, *found, elm, n, nsend;
+  int    p, error;
+
+  halo->nrows      = nrows;
+  halo->recv_count = (int *) prk_malloc(4*Num_procs*sizeof(int));
+  halo->requests   = (MPI_Request *) prk_malloc(2*Num_procs*sizeof(MPI_Request));
+  needed           = (s64Int *) prk_malloc((nent+1)*sizeof(s64Int));
+  error = !halo->recv_count || !halo->requests || !needed;
+  MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if (error) return 1;
+  halo->recv_displ = halo->recv_count +   Num_procs;
+  halo->send_count = halo->recv_count + 2*Num_procs;
+  halo->send_displ = halo->recv_count + 3*Num_procs;
+
+  /* distinct column indices outside the owned rows, sorted                      */
+  for (n=0, elm=0; elm<nent; elm++) 
+    if (colIndex[elm] < row_offset || colIndex[elm] >= row_offset+nrows) 
+      needed[n++] = colIndex[elm];
+  qsort(needed, n, sizeof(s64Int), compare);
+  for (halo->nhalo=0, elm=0; elm<n; elm++)
+    if (!halo->nhalo || needed[elm] != needed[halo->nhalo-1])
+      needed[halo->nhalo++] = needed[elm];
+
+  /* entries are sorted, hence grouped by owner                                  */
+  for (p=0; p<Num_procs; p++) halo->recv_count[p] = 0;
+  for (elm=0; elm<halo->nhalo; elm++) halo->recv_count[needed[elm]/nrows]++;
+  MPI_Alltoall(halo->recv_count, 1, MPI_INT, halo->send_count, 1, MPI_INT,
+               MPI_COMM_WORLD);
+  for (nsend=0, p=0; p<Num_procs; p++) {
+    halo->recv_displ[p] = p ? halo->recv_displ[p-1]+halo->recv_count[p-1] : 0;
+    halo->send_displ[p] = nsend;
+    nsend += halo->send_count[p];
+  }
+
+  halo->send_index  = (s64Int *) prk_malloc((nsend+1)*sizeof(s64Int));
+  halo->send_buffer = (double *) prk_malloc((nsend+1)*sizeof(double));
+  error = !halo->send_index || !halo->send_buffer;
+  MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if (error) return 1;
+
+  MPI_Alltoallv(needed, halo->recv_count, halo->recv_displ, MPI_LONG_LONG_INT,
+                halo->send_index, halo->send_count, halo->send_displ, 
+                MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+  for (elm=0; elm<nsend; elm++) halo->send_index[elm] -= row_offset;
+
+  for (elm=0; elm<nent; elm++) {
+    if (colIndex[elm] >= row_offset && colIndex[elm] < row_offset+nrows) 
+      colIndex[elm] -= row_offset;
+    else {
+      found = (s64Int *) bsearch(&colIndex[elm], needed, halo->nhalo, 
+                                 sizeof(s64Int), compare);
+      colIndex[elm] = nrows + (found-needed);
+    }
+  }
+
+  prk_free(needed);
+  return 0;
+}
+
+/* Executor of the halo exchange: send the owned entries of vector that other
+   ranks need and receive the halo entries behind the owned ones         */
+void exchange_halo(halo_t *halo, double *vector, int Num_procs) {
+
+  s64Int elm, nsend = 0;
+  int    p, nreq = 0;
+
+  for (p=0; p<Num_procs; p++) if (halo->recv_count[p])
+    MPI_Irecv(vector+halo->nrows+halo->recv_displ[p], halo->recv_count[p], 
+              MPI_DOUBLE, p, 0, MPI_COMM_WORLD, &halo->requests[nreq++]);
+
+  for (p=0; p<Num_procs; p++) nsend += halo->send_count[p];
+  for (elm=0; elm<nsend; elm++) halo->send_buffer[elm] = vector[halo->send_index[elm]];
+
+  for (p=0; p<Num_procs; p++) if (halo->send_count[p])
+    MPI_Isend(halo->send_buffer+halo->send_displ[p], halo->send_count[p], 
+              MPI_DOUBLE, p, 0, MPI_COMM_WORLD, &halo->requests[nreq++]);
+
+  MPI_Waitall(nreq, halo->requests, MPI_STATUSES_IGNORE);
+}
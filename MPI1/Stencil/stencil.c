@@ -43,6 +43,40 @@ USAGE:   The program takes as input the linear dimension of the grid,
  
                <progname> <# iterations> <grid size>
   
+         With PRK_OVERLAP=1 in the environment the interior of each tile,
+         which does not depend on ghost points, is updated while the halo
+         messages are in flight, and the boundary strips after they have
+         arrived; by default all halos are received before any update.
+         The halo posting, halo waiting, interior and boundary phases are
+         timed separately in both modes.
+
+         With PRK_HALO=datatype the halos are sent from and received into
+         the grid directly, described by MPI_Type_vector datatypes, through
+         persistent requests created once and started every iteration;
+         the default (PRK_HALO=pack) copies them through buffers.
+
+         With PRK_HALO_DEPTH=k the ghost zone is k*RADIUS points deep and is
+         exchanged only every k iterations; in between, the ghost points that
+         are still read before the next exchange are updated redundantly,
+         trading the extra work and larger messages for fewer of them.
+
+         With PRK_INCREMENT=offset the constant that every iteration adds
+         to IN is kept as an implicit offset of the grid instead of being
+         added by a pass over the tile and its ghost zone.  The weights
+         sum to zero, so the stencil of IN plus a constant equals that of
+         IN and the norm is unchanged; the halos are still exchanged as
+         usual.  PRK_INCREMENT=sweep (the default) adds it explicitly.
+
+         Built with MIXED=1 (single) or MIXED=2 (half precision, where the
+         compiler provides _Float16) the grid and the halo messages are
+         stored in the reduced precision, which halves (quarters) the bytes
+         moved through memory and the network, while the weights and the
+         stencil sums are kept in double precision.
+
+         With PRK_PROGRESS=1|spare|cpu:<k> a helper thread polls the MPI
+         library while the rank computes, so that messages progress
+         asynchronously (see prk_progress.h).
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
  
@@ -52,7 +86,10 @@ FUNCTIONS CALLED:
          functions are used in this program:
  
          wtime()
+         prk_topology_bind()
+         prk_progress_*()
          bail_out()
+         prk_harness_*()
  
 HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, August 2013: Removed unrolling pragmas for clarity;
@@ -65,22 +102,56 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, October 2014: removed barrier at start of each iteration
          - RvdW, October 2014: replaced single rank/single iteration timing
            with global timing of all iterations across all ranks
+         - Added overlap of the halo exchange with the interior update,
+           with separate timing of the exchange, interior and boundary
+         - Added halo exchange with derived datatypes and persistent
+           requests
+         - Added deep (communication-avoiding) halos
+         - Added mixed precision storage
   
 *********************************************************************************/
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
- 
-#if DOUBLE
+#include <prk_harness.h>
+#include <prk_topology.h>
+ 
+/* DTYPE is the type in which the grid and halos are stored, ATYPE the type
+   in which the stencil is accumulated; they only differ in the mixed
+   precision modes                                                           */
+#if MIXED
+  #if MIXED == 2
+    #ifndef __FLT16_MAX__
+      #error "MIXED=2 requires a compiler that supports _Float16"
+    #endif
+    #define DTYPE     _Float16
+    /* MPI has no half precision type; the halos travel as 16-bit words      */
+    #define MPI_DTYPE MPI_UINT16_T
+    #define EPSILON   1.e-3
+  #else
+    #define DTYPE     float
+    #define MPI_DTYPE MPI_FLOAT
+    #define EPSILON   1.e-6
+  #endif
+  #define ATYPE     double
+  #define MPI_ATYPE MPI_DOUBLE
+  #define COEFX     1.0
+  #define COEFY     1.0
+  #define FSTR      "%lf"
+#elif DOUBLE
   #define DTYPE     double
+  #define ATYPE     double
   #define MPI_DTYPE MPI_DOUBLE
+  #define MPI_ATYPE MPI_DOUBLE
   #define EPSILON   1.e-8
   #define COEFX     1.0
   #define COEFY     1.0
   #define FSTR      "%lf"
 #else
   #define DTYPE     float
+  #define ATYPE     float
   #define MPI_DTYPE MPI_FLOAT
+  #define MPI_ATYPE MPI_FLOAT
   #define EPSILON   0.0001f
   #define COEFX     1.0f
   #define COEFY     1.0f
@@ -88,12 +159,33 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
 #endif
  
 /* define shorthand for indexing multi-dimensional arrays with offsets           */
-#define INDEXIN(i,j)  (i+RADIUS+(j+RADIUS)*(width+2*RADIUS))
-/* need to add offset of RADIUS to j to account for ghost points                 */
+#define INDEXIN(i,j)  (i+ghost+(j+ghost)*(width+2*ghost))
+/* need to add offset of ghost to j to account for ghost points                  */
 #define IN(i,j)       in[INDEXIN(i-istart,j-jstart)]
 #define INDEXOUT(i,j) (i+(j)*(width))
 #define OUT(i,j)      out[INDEXOUT(i-istart,j-jstart)]
 #define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+
+/* apply the stencil to the points ilo..ihi x jlo..jhi of the tile            */
+static void apply_stencil(DTYPE * RESTRICT in, DTYPE * RESTRICT out, 
+                          ATYPE weight[2*RADIUS+1][2*RADIUS+1], int istart, 
+                          int jstart, int width, int ghost, int ilo, int ihi,
+                          int jlo, int jhi) {
+  int i, j, ii, jj;
+  for (j=jlo; j<=jhi; j++) {
+    for (i=ilo; i<=ihi; i++) {
+      #if LOOPGEN
+        #include "loop_body_star.incl"
+      #else
+        ATYPE sum = OUT(i,j);
+        for (jj=-RADIUS; jj<=RADIUS; jj++) sum += WEIGHT(0,jj)*IN(i,j+jj);
+        for (ii=-RADIUS; ii<0; ii++)       sum += WEIGHT(ii,0)*IN(i+ii,j);
+        for (ii=1; ii<=RADIUS; ii++)       sum += WEIGHT(ii,0)*IN(i+ii,j);
+        OUT(i,j) = sum;
+      #endif
+    }
+  }
+}
  
 int main(int argc, char ** argv) {
  
@@ -119,12 +211,31 @@ int main(int argc, char ** argv) {
   int    i, j, ii, jj, kk, it, jt, iter, leftover;  /* dummies                   */
   int    istart, iend;    /* bounds of grid tile assigned to calling rank        */
   int    jstart, jend;    /* bounds of grid tile assigned to calling rank        */
-  DTYPE  norm,            /* L1 norm of solution                                 */
+  ATYPE  norm,            /* L1 norm of solution                                 */
          local_norm,      /* contribution of calling rank to L1 norm             */
          reference_norm;
-  DTYPE  f_active_points; /* interior of grid with respect to stencil            */
-  DTYPE  flops;           /* floating point ops per iteration                    */
+  ATYPE  f_active_points; /* interior of grid with respect to stencil            */
+  ATYPE  flops;           /* floating point ops per iteration                    */
   int    iterations;      /* number of times to run the algorithm                */
+  prk_harness_t harness;  /* per-iteration timing                                */
+  prk_phase_t   post,     /* timing of packing and posting the halo messages     */
+                wait,     /* timing of completing and unpacking them             */
+                interior, /* timing of the update of the tile interior           */
+                boundary; /* timing of the update of the tile boundary strips    */
+  int    overlap;         /* nonzero if interior work hides the halo exchange    */
+  int    datatypes;       /* nonzero if halos travel as derived datatypes        */
+  int    depth;           /* halo depth in multiples of RADIUS                   */
+  int    ghost;           /* depth of the ghost zone: depth*RADIUS               */
+  int    ext;             /* depth of ghost zone still read before next exchange */
+  int    exchange;        /* nonzero if halos are exchanged in this iteration    */
+  int    offset;          /* nonzero if the increment of IN is implicit          */
+  ATYPE  wsum;            /* sum of the stencil weights                          */
+  MPI_Datatype row_halo;  /* ghost rows of the tile, without ghost points        */
+  MPI_Datatype col_halo;  /* ghost columns of the tile, without ghost points     */
+  MPI_Request  persist[8];/* persistent requests of the datatype exchange        */
+  int    npersist = 0;    /* number of persistent requests                       */
+  int    ilo, ihi, jlo, jhi; /* bounds of updated points of the tile             */
+  int    ilo_int, ihi_int, jlo_int, jhi_int; /* bounds of the tile interior      */
   double local_stencil_time,/* timing parameters                                 */
          stencil_time,
          avgtime; 
@@ -134,14 +245,15 @@ int main(int argc, char ** argv) {
   long   total_length_in; /* total required length to store input array          */
   long   total_length_out;/* total required length to store output array         */
   int    error=0;         /* error flag                                          */
-  DTYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
+  ATYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
   MPI_Request request[8];
   MPI_Status  status[8];
+  char   *env;            /* value of a PRK_* environment variable               */
  
   /*******************************************************************************
   ** Initialize the MPI environment
   ********************************************************************************/
-  MPI_Init(&argc,&argv);
+  prk_progress_init(&argc,&argv);
   MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
   MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
 
@@ -193,6 +305,32 @@ int main(int argc, char ** argv) {
       goto ENDOFTESTS;  
     }
  
+    env     = getenv("PRK_OVERLAP");
+    overlap = env && atoi(env) > 0;
+    env     = getenv("PRK_HALO");
+    datatypes = env && !strcmp(env, "datatype");
+    if (env && !datatypes && strcmp(env, "pack")) {
+      printf("ERROR: PRK_HALO must be pack or datatype: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env   = getenv("PRK_HALO_DEPTH");
+    depth = env ? atoi(env) : 1;
+    if (depth < 1) {
+      printf("ERROR: PRK_HALO_DEPTH must be positive: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env    = getenv("PRK_INCREMENT");
+    offset = env && !strcmp(env, "offset");
+    if (env && !offset && strcmp(env, "sweep")) {
+      printf("ERROR: PRK_INCREMENT must be sweep or offset: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
     ENDOFTESTS:;  
   }
   bail_out(error);
@@ -220,7 +358,10 @@ int main(int argc, char ** argv) {
     printf("Radius of stencil      = %d\n", RADIUS);
     printf("Tiles in x/y-direction = %d/%d\n", Num_procsx, Num_procsy);
     printf("Type of stencil        = star\n");
-#if DOUBLE
+#if MIXED
+    printf("Data type              = %s precision storage, double precision "
+           "arithmetic\n", MIXED == 2 ? "half" : "single");
+#elif DOUBLE
     printf("Data type              = double precision\n");
 #else
     printf("Data type              = single precision\n");
@@ -231,10 +372,24 @@ int main(int argc, char ** argv) {
     printf("Compact representation of stencil loop body\n");
 #endif
     printf("Number of iterations   = %d\n", iterations);
+    printf("Halo exchange          = %s\n", 
+           overlap ? "overlapped with interior update" : "blocking");
+    printf("Halo transfer          = %s\n", datatypes ? 
+           "derived datatypes, persistent requests" : "packed buffers");
+    printf("Halo depth             = %d x radius, exchanged every %d iteration%s\n",
+           depth, depth, depth > 1 ? "s" : "");
+    printf("Increment of input     = %s\n", offset ? "implicit offset" : "sweep");
+    printf("Progress thread        = %s\n", prk_progress_mode());
   }
  
   MPI_Bcast(&n,          1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&overlap,    1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&datatypes,  1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&depth,      1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&offset,     1, MPI_INT, root, MPI_COMM_WORLD);
+  ghost = depth*RADIUS;
+  prk_topology_bind();
  
   /* compute amount of space required for input and solution arrays             */
   
@@ -274,14 +429,14 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
 
-  if (width < RADIUS || height < RADIUS) {
-    printf("ERROR: rank %d has work tile smaller then stencil radius\n",
+  if (width < ghost || height < ghost) {
+    printf("ERROR: rank %d has work tile smaller then halo depth\n",
            my_ID);
     error = 1;
   }
   bail_out(error);
  
-  total_length_in  = (long) (width+2*RADIUS)*(long) (height+2*RADIUS)*sizeof(DTYPE);
+  total_length_in  = (long) (width+2*ghost)*(long) (height+2*ghost)*sizeof(DTYPE);
   total_length_out = (long) width* (long) height*sizeof(DTYPE);
  
   in  = (DTYPE *) prk_malloc(total_length_in);
@@ -295,152 +450,256 @@ int main(int argc, char ** argv) {
  
   /* fill the stencil weights to reflect a discrete divergence operator         */
   for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
-    WEIGHT(ii,jj) = (DTYPE) 0.0;
+    WEIGHT(ii,jj) = (ATYPE) 0.0;
 
   stencil_size = 4*RADIUS+1;
   for (ii=1; ii<=RADIUS; ii++) {
-    WEIGHT(0, ii) = WEIGHT( ii,0) =  (DTYPE) (1.0/(2.0*ii*RADIUS));
-    WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(DTYPE) (1.0/(2.0*ii*RADIUS));
+    WEIGHT(0, ii) = WEIGHT( ii,0) =  (ATYPE) (1.0/(2.0*ii*RADIUS));
+    WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(ATYPE) (1.0/(2.0*ii*RADIUS));
+  }
+
+  /* IN+c feeds the stencil c*wsum more than IN does, so with weights that
+     sum to zero the increment can be left to an implicit offset            */
+  if (offset) {
+    wsum = (ATYPE) 0.0;
+    for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
+      wsum += WEIGHT(ii,jj);
+    if (ABS(wsum) > EPSILON) {
+      if (my_ID == root)
+        printf("ERROR: PRK_INCREMENT=offset needs weights that sum to zero, not "
+               FSTR"\n", wsum);
+      error = 1;
+    }
   }
+  bail_out(error);
  
-  norm = (DTYPE) 0.0;
-  f_active_points = (DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS);
+  norm = (ATYPE) 0.0;
+  f_active_points = (ATYPE) (n-2*RADIUS)*(ATYPE) (n-2*RADIUS);
   /* intialize the input and output arrays                                     */
   for (j=jstart; j<=jend; j++) for (i=istart; i<=iend; i++) {
     IN(i,j)  = COEFX*i+COEFY*j;
     OUT(i,j) = (DTYPE)0.0;
   }
 
-  if (Num_procs > 1) { 
+  if (Num_procs > 1 && datatypes) {
+    /* describe the halos in place and set up the transfers once; the tags
+       match those of the packed exchange below                                */
+    MPI_Type_vector(ghost, width, width+2*ghost, MPI_DTYPE, &row_halo);
+    MPI_Type_vector(height, ghost, width+2*ghost, MPI_DTYPE, &col_halo);
+    MPI_Type_commit(&row_halo);
+    MPI_Type_commit(&col_halo);
+    if (my_IDy < Num_procsy-1) {
+      MPI_Recv_init(&IN(istart,jend+1), 1, row_halo, top_nbr, 101,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+      MPI_Send_init(&IN(istart,jend-ghost+1), 1, row_halo, top_nbr, 99,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+    }
+    if (my_IDy > 0) {
+      MPI_Recv_init(&IN(istart,jstart-ghost), 1, row_halo, bottom_nbr, 99,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+      MPI_Send_init(&IN(istart,jstart), 1, row_halo, bottom_nbr, 101,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+    }
+    if (my_IDx < Num_procsx-1) {
+      MPI_Recv_init(&IN(iend+1,jstart), 1, col_halo, right_nbr, 1010,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+      MPI_Send_init(&IN(iend-ghost+1,jstart), 1, col_halo, right_nbr, 990,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+    }
+    if (my_IDx > 0) {
+      MPI_Recv_init(&IN(istart-ghost,jstart), 1, col_halo, left_nbr, 990,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+      MPI_Send_init(&IN(istart,jstart), 1, col_halo, left_nbr, 1010,
+                    MPI_COMM_WORLD, &(persist[npersist++]));
+    }
+  }
+  else if (Num_procs > 1) { 
     /* allocate communication buffers for halo values                          */
-    top_buf_out = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*RADIUS*width);
+    top_buf_out = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*ghost*width);
     if (!top_buf_out) {
       printf("ERROR: Rank %d could not allocated comm buffers for y-direction\n", my_ID);
       error = 1;
     }
     bail_out(error);
-    top_buf_in     = top_buf_out +   RADIUS*width;
-    bottom_buf_out = top_buf_out + 2*RADIUS*width;
-    bottom_buf_in  = top_buf_out + 3*RADIUS*width;
+    top_buf_in     = top_buf_out +   ghost*width;
+    bottom_buf_out = top_buf_out + 2*ghost*width;
+    bottom_buf_in  = top_buf_out + 3*ghost*width;
  
-    right_buf_out  = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*RADIUS*height);
+    right_buf_out  = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*ghost*height);
     if (!right_buf_out) {
       printf("ERROR: Rank %d could not allocated comm buffers for x-direction\n", my_ID);
       error = 1;
     }
     bail_out(error);
-    right_buf_in   = right_buf_out +   RADIUS*height;
-    left_buf_out   = right_buf_out + 2*RADIUS*height;
-    left_buf_in    = right_buf_out + 3*RADIUS*height;
+    right_buf_in   = right_buf_out +   ghost*height;
+    left_buf_out   = right_buf_out + 2*ghost*height;
+    left_buf_in    = right_buf_out + 3*ghost*height;
   }
 
+  prk_harness_init(&harness, "Stencil", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%ld", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "overlap", "%d", overlap);
+  prk_harness_param(&harness, "halo", "%s", datatypes ? "datatype" : "pack");
+  prk_harness_param(&harness, "halo_depth", "%d", depth);
+  prk_harness_param(&harness, "increment", "%s", offset ? "offset" : "sweep");
+  prk_harness_param(&harness, "progress", "%s", prk_progress_mode());
+
+  /* points that do not read ghost points form the interior of the tile; the
+     bounds are clamped so that the boundary strips never overlap it, even
+     for tiles narrower than two stencil radii                                 */
+  ilo = MAX(istart,RADIUS); ihi = MIN(n-RADIUS-1,iend);
+  jlo = MAX(jstart,RADIUS); jhi = MIN(n-RADIUS-1,jend);
+  ilo_int = MIN(istart+RADIUS,ihi+1); ihi_int = MAX(iend-RADIUS,ilo_int-1);
+  jlo_int = MIN(jstart+RADIUS,jhi+1); jhi_int = MAX(jend-RADIUS,jlo_int-1);
+
+  prk_phase_init(&post,     "halo post");
+  prk_phase_init(&wait,     "halo wait");
+  prk_phase_init(&interior, "interior");
+  prk_phase_init(&boundary, "boundary");
+
   for (iter = 0; iter<=iterations; iter++){
 
-    /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_stencil_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
+    if (iter == 1) {
+      prk_phase_reset(&post);
+      prk_phase_reset(&wait);
+      prk_phase_reset(&interior);
+      prk_phase_reset(&boundary);
     }
  
-    /* need to fetch ghost point data from neighbors in y-direction                 */
-    if (my_IDy < Num_procsy-1) {
-      MPI_Irecv(top_buf_in, RADIUS*width, MPI_DTYPE, top_nbr, 101,
-                MPI_COMM_WORLD, &(request[1]));
-      for (kk=0,j=jend-RADIUS+1; j<=jend; j++) for (i=istart; i<=iend; i++) {
-          top_buf_out[kk++]= IN(i,j);
-      }
-      MPI_Isend(top_buf_out, RADIUS*width,MPI_DTYPE, top_nbr, 99, 
-                MPI_COMM_WORLD, &(request[0]));
-    }
-    if (my_IDy > 0) {
-      MPI_Irecv(bottom_buf_in,RADIUS*width, MPI_DTYPE, bottom_nbr, 99, 
-                MPI_COMM_WORLD, &(request[3]));
-      for (kk=0,j=jstart; j<=jstart+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
-          bottom_buf_out[kk++]= IN(i,j);
+    /* the ghost zone is refreshed every depth iterations; it is depth*RADIUS
+       points deep, so it still holds the RADIUS points read by the stencil
+       after the redundant updates of the iterations in between              */
+    exchange = !(iter%depth);
+
+    if (exchange) PRK_PHASE(&post) {
+      /* post the exchange of ghost point data with neighbors in x and y; the 
+         star stencil needs no corner values, so both directions go at once   */
+      if (datatypes) MPI_Startall(npersist, persist);
+      else {
+        for (kk=0; kk<8; kk++) request[kk] = MPI_REQUEST_NULL;
+        if (my_IDy < Num_procsy-1) {
+          MPI_Irecv(top_buf_in, ghost*width, MPI_DTYPE, top_nbr, 101,
+                    MPI_COMM_WORLD, &(request[1]));
+          for (kk=0,j=jend-ghost+1; j<=jend; j++) for (i=istart; i<=iend; i++) {
+              top_buf_out[kk++]= IN(i,j);
+          }
+          MPI_Isend(top_buf_out, ghost*width,MPI_DTYPE, top_nbr, 99, 
+                    MPI_COMM_WORLD, &(request[0]));
+        }
+        if (my_IDy > 0) {
+          MPI_Irecv(bottom_buf_in,ghost*width, MPI_DTYPE, bottom_nbr, 99, 
+                    MPI_COMM_WORLD, &(request[3]));
+          for (kk=0,j=jstart; j<=jstart+ghost-1; j++) for (i=istart; i<=iend; i++) {
+              bottom_buf_out[kk++]= IN(i,j);
+          }
+          MPI_Isend(bottom_buf_out, ghost*width,MPI_DTYPE, bottom_nbr, 101,
+                    MPI_COMM_WORLD, &(request[2]));
+        }
+        if (my_IDx < Num_procsx-1) {
+          MPI_Irecv(right_buf_in, ghost*height, MPI_DTYPE, right_nbr, 1010,
+                    MPI_COMM_WORLD, &(request[1+4]));
+          for (kk=0,j=jstart; j<=jend; j++) for (i=iend-ghost+1; i<=iend; i++) {
+              right_buf_out[kk++]= IN(i,j);
+          }
+          MPI_Isend(right_buf_out, ghost*height, MPI_DTYPE, right_nbr, 990, 
+                  MPI_COMM_WORLD, &(request[0+4]));
+        }
+        if (my_IDx > 0) {
+          MPI_Irecv(left_buf_in, ghost*height, MPI_DTYPE, left_nbr, 990, 
+                    MPI_COMM_WORLD, &(request[3+4]));
+          for (kk=0,j=jstart; j<=jend; j++) for (i=istart; i<=istart+ghost-1; i++) {
+              left_buf_out[kk++]= IN(i,j);
+          }
+          MPI_Isend(left_buf_out, ghost*height, MPI_DTYPE, left_nbr, 1010,
+                    MPI_COMM_WORLD, &(request[2+4]));
+        }
       }
-      MPI_Isend(bottom_buf_out, RADIUS*width,MPI_DTYPE, bottom_nbr, 101,
-                MPI_COMM_WORLD, &(request[2]));
-    }
-    if (my_IDy < Num_procsy-1) {
-      MPI_Wait(&(request[0]), &(status[0]));
-      MPI_Wait(&(request[1]), &(status[1]));
-      for (kk=0,j=jend+1; j<=jend+RADIUS; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = top_buf_in[kk++];
-      }      
-    }
-    if (my_IDy > 0) {
-      MPI_Wait(&(request[2]), &(status[2]));
-      MPI_Wait(&(request[3]), &(status[3]));
-      for (kk=0,j=jstart-RADIUS; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = bottom_buf_in[kk++];
-      }      
     }
 
-    /* need to fetch ghost point data from neighbors in x-direction                 */
-    if (my_IDx < Num_procsx-1) {
-      MPI_Irecv(right_buf_in, RADIUS*height, MPI_DTYPE, right_nbr, 1010,
-                MPI_COMM_WORLD, &(request[1+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=iend-RADIUS+1; i<=iend; i++) {
-          right_buf_out[kk++]= IN(i,j);
-      }
-      MPI_Isend(right_buf_out, RADIUS*height, MPI_DTYPE, right_nbr, 990, 
-              MPI_COMM_WORLD, &(request[0+4]));
+    /* in overlap mode the interior is updated while the messages are in 
+       flight; otherwise it is updated after they have arrived                */
+    if (overlap) PRK_PHASE(&interior) {
+      apply_stencil(in, out, weight, istart, jstart, width, ghost,
+                    ilo_int, ihi_int, jlo_int, jhi_int);
     }
-    if (my_IDx > 0) {
-      MPI_Irecv(left_buf_in, RADIUS*height, MPI_DTYPE, left_nbr, 990, 
-                MPI_COMM_WORLD, &(request[3+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=istart; i<=istart+RADIUS-1; i++) {
-          left_buf_out[kk++]= IN(i,j);
+
+    if (exchange) PRK_PHASE(&wait) {
+      if (datatypes) MPI_Waitall(npersist, persist, status);
+      else {
+        MPI_Waitall(8, request, status);
+        if (my_IDy < Num_procsy-1) {
+          for (kk=0,j=jend+1; j<=jend+ghost; j++) for (i=istart; i<=iend; i++) {
+              IN(i,j) = top_buf_in[kk++];
+          }      
+        }
+        if (my_IDy > 0) {
+          for (kk=0,j=jstart-ghost; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
+              IN(i,j) = bottom_buf_in[kk++];
+          }      
+        }
+        if (my_IDx < Num_procsx-1) {
+          for (kk=0,j=jstart; j<=jend; j++) for (i=iend+1; i<=iend+ghost; i++) {
+              IN(i,j) = right_buf_in[kk++];
+          }      
+        }
+        if (my_IDx > 0) {
+          for (kk=0,j=jstart; j<=jend; j++) for (i=istart-ghost; i<=istart-1; i++) {
+              IN(i,j) = left_buf_in[kk++];
+          }      
+        }
       }
-      MPI_Isend(left_buf_out, RADIUS*height, MPI_DTYPE, left_nbr, 1010,
-                MPI_COMM_WORLD, &(request[2+4]));
     }
-    if (my_IDx < Num_procsx-1) {
-      MPI_Wait(&(request[0+4]), &(status[0+4]));
-      MPI_Wait(&(request[1+4]), &(status[1+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=iend+1; i<=iend+RADIUS; i++) {
-          IN(i,j) = right_buf_in[kk++];
-      }      
-    }
-    if (my_IDx > 0) {
-      MPI_Wait(&(request[2+4]), &(status[2+4]));
-      MPI_Wait(&(request[3+4]), &(status[3+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=istart-RADIUS; i<=istart-1; i++) {
-          IN(i,j) = left_buf_in[kk++];
-      }      
+
+    if (!overlap) PRK_PHASE(&interior) {
+      apply_stencil(in, out, weight, istart, jstart, width, ghost,
+                    ilo_int, ihi_int, jlo_int, jhi_int);
     }
 
-    /* Apply the stencil operator */
-    for (j=MAX(jstart,RADIUS); j<=MIN(n-RADIUS-1,jend); j++) {
-      for (i=MAX(istart,RADIUS); i<=MIN(n-RADIUS-1,iend); i++) {
-        #if LOOPGEN
-          #include "loop_body_star.incl"
-        #else
-          for (jj=-RADIUS; jj<=RADIUS; jj++) OUT(i,j) += WEIGHT(0,jj)*IN(i,j+jj);
-          for (ii=-RADIUS; ii<0; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
-          for (ii=1; ii<=RADIUS; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
-        #endif
-      }
+    /* Apply the stencil operator to the strips that read ghost points */
+    prk_phase_begin(&boundary);
+    apply_stencil(in, out, weight, istart, jstart, width, ghost,
+                  ilo, ihi, jlo, jlo_int-1);
+    apply_stencil(in, out, weight, istart, jstart, width, ghost,
+                  ilo, ihi, jhi_int+1, jhi);
+    apply_stencil(in, out, weight, istart, jstart, width, ghost,
+                  ilo, ilo_int-1, jlo_int, jhi_int);
+    apply_stencil(in, out, weight, istart, jstart, width, ghost,
+                  ihi_int+1, ihi, jlo_int, jhi_int);
+    prk_phase_end(&boundary);
+ 
+    /* add constant to solution to force refresh of neighbor data, if any; 
+       the ghost points that are read again before the next exchange receive
+       the same update redundantly                                            */
+    if (offset) continue;
+    ext = (depth-1-iter%depth)*RADIUS;
+    for (j=jstart-(my_IDy>0 ? ext : 0); j<=jend+(my_IDy<Num_procsy-1 ? ext : 0); j++) 
+      for (i=istart; i<=iend; i++) IN(i,j)+= 1.0;
+    if (ext > 0) for (j=jstart; j<=jend; j++) {
+      if (my_IDx > 0)            for (i=istart-ext; i<istart; i++) IN(i,j)+= 1.0;
+      if (my_IDx < Num_procsx-1) for (i=iend+1; i<=iend+ext; i++)  IN(i,j)+= 1.0;
     }
  
-    /* add constant to solution to force refresh of neighbor data, if any */
-    for (j=jstart; j<=jend; j++) for (i=istart; i<=iend; i++) IN(i,j)+= 1.0;
- 
   } /* end of iterations                                                   */
 
-  local_stencil_time = wtime() - local_stencil_time;
+  prk_harness_tick(&harness);
+  local_stencil_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_stencil_time, &stencil_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
   /* compute L1 norm in parallel                                                */
-  local_norm = (DTYPE) 0.0;
+  local_norm = (ATYPE) 0.0;
   for (j=MAX(jstart,RADIUS); j<=MIN(n-RADIUS-1,jend); j++) {
     for (i=MAX(istart,RADIUS); i<=MIN(n-RADIUS-1,iend); i++) {
-      local_norm += (DTYPE)ABS(OUT(i,j));
+      local_norm += (ATYPE)ABS(OUT(i,j));
     }
   }
  
-  MPI_Reduce(&local_norm, &norm, 1, MPI_DTYPE, MPI_SUM, root, MPI_COMM_WORLD);
+  MPI_Reduce(&local_norm, &norm, 1, MPI_ATYPE, MPI_SUM, root, MPI_COMM_WORLD);
  
   /*******************************************************************************
   ** Analyze and output results.
@@ -450,10 +709,10 @@ int main(int argc, char ** argv) {
   if (my_ID == root) {
     norm /= f_active_points;
     if (RADIUS > 0) {
-      reference_norm = (DTYPE) (iterations+1) * (COEFX + COEFY);
+      reference_norm = (ATYPE) (iterations+1) * (COEFX + COEFY);
     }
     else {
-      reference_norm = (DTYPE) 0.0;
+      reference_norm = (ATYPE) 0.0;
     }
     if (ABS(norm-reference_norm) > EPSILON) {
       printf("ERROR: L1 norm = "FSTR", Reference L1 norm = "FSTR"\n",
@@ -470,15 +729,29 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (ATYPE) (2*stencil_size+1) * f_active_points;
   if (my_ID == root) {
-    /* flops/stencil: 2 flops (fma) for each point in the stencil, 
-       plus one flop for the update of the input of the array        */
-    flops = (DTYPE) (2*stencil_size+1) * f_active_points;
     avgtime = stencil_time/iterations;
     printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
            1.0E-06 * flops/avgtime, avgtime);
   }
+  /* reads of IN and read-modify-writes of OUT and of all of IN */
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_phase_report(&post);
+  prk_phase_report(&wait);
+  prk_phase_report(&interior);
+  prk_phase_report(&boundary);
+  prk_harness_finalize(&harness);
+
+  if (Num_procs > 1 && datatypes) {
+    for (kk=0; kk<npersist; kk++) MPI_Request_free(&(persist[kk]));
+    MPI_Type_free(&row_halo);
+    MPI_Type_free(&col_halo);
+  }
  
-  MPI_Finalize();
+  prk_progress_finalize();
   exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,489 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    Stencil3D
+
+PURPOSE: This program tests the efficiency with which a space-invariant,
+         linear, symmetric filter (stencil) can be applied to a cubic
+         grid, the three-dimensional counterpart of Stencil.
+  
+USAGE:   The program takes as input the number of iterations on the grid
+         and the linear dimension of the grid
+
+               <progname> <iterations> <grid size> 
+  
+         The grid is decomposed over a three-dimensional grid of ranks,
+         chosen to be as close to a cube as the number of ranks allows.
+         Ghost layers of width RADIUS are exchanged one direction at a
+         time, each exchange including the ghost points received in the
+         previous directions, so that the edge and corner values needed
+         by the compact stencil arrive without diagonal messages.
+
+         The output consists of diagnostics to make sure the 
+         algorithm worked, and of timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following 
+         functions are used in this program:
+
+         wtime()
+         bail_out()
+         prk_topology_bind()
+         prk_harness_*()
+         prk_phase_*()
+
+HISTORY: - Written in October 2026, following MPI1/Stencil.
+  
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
+
+#if DOUBLE
+  #define DTYPE     double
+  #define MPI_DTYPE MPI_DOUBLE
+  #define EPSILON   1.e-8
+  #define COEFX     1.0
+  #define COEFY     1.0
+  #define COEFZ     1.0
+  #define FSTR      "%lf"
+#else
+  #define DTYPE     float
+  #define MPI_DTYPE MPI_FLOAT
+  #define EPSILON   0.0001f
+  #define COEFX     1.0f
+  #define COEFY     1.0f
+  #define COEFZ     1.0f
+  #define FSTR      "%f"
+#endif
+
+/* define shorthand for indexing multi-dimensional arrays with offsets; the
+   input array carries RADIUS ghost points on either side in every direction   */
+#define INDEXIN(i,j,k)  (i+RADIUS+(width+2*RADIUS)*((long)(j+RADIUS)+    \
+                         (long)(height+2*RADIUS)*(k+RADIUS)))
+#define IN(i,j,k)       in[INDEXIN(i-start[0],j-start[1],k-start[2])]
+#define INDEXOUT(i,j,k) (i+width*((long)(j)+(long)height*(k)))
+#define OUT(i,j,k)      out[INDEXOUT(i-start[0],j-start[1],k-start[2])]
+#define WEIGHT(ii,jj,kk) weight[ii+RADIUS][jj+RADIUS][kk+RADIUS]
+
+/* copy the box lo..hi (inclusive, global coordinates) of the input array to
+   buf, or back from buf if unpack is set; returns the number of values       */
+static int copy_box(DTYPE *in, DTYPE *buf, int *lo, int *hi, int *start,
+                    int width, int height, int unpack) {
+  int i, j, k, kk = 0;
+  for (k=lo[2]; k<=hi[2]; k++) for (j=lo[1]; j<=hi[1]; j++)
+  for (i=lo[0]; i<=hi[0]; i++) {
+    if (unpack) IN(i,j,k) = buf[kk++];
+    else        buf[kk++] = IN(i,j,k);
+  }
+  return kk;
+}
+
+/* split n points as evenly as possible over nparts parts and return the
+   bounds of part id as in MPI1/Stencil                                       */
+static void split(int n, int nparts, int id, int *first, int *last) {
+  int size = n/nparts, leftover = n%nparts;
+  if (id<leftover) {
+    *first = (size+1) * id; 
+    *last  = *first + size;
+  }
+  else {
+    *first = (size+1) * leftover + size * (id-leftover);
+    *last  = *first + size - 1;
+  }
+}
+
+int main(int argc, char ** argv) {
+ 
+  int    Num_procs;       /* number of ranks                                     */
+  int    Num_procsd[3];   /* number of ranks in each coord direction             */
+  int    my_ID;           /* MPI rank                                            */
+  int    my_IDd[3];       /* coordinates of rank in rank grid                    */
+  int    stride[3];       /* rank distance of neighbors in each direction        */
+  int    px, py, pz;      /* candidate rank grid                                 */
+  DTYPE *buf_out_hi;      /* communication buffers                               */
+  DTYPE *buf_in_hi;       /*       "         "                                   */
+  DTYPE *buf_out_lo;      /*       "         "                                   */
+  DTYPE *buf_in_lo;       /*       "         "                                   */
+  long   buf_length;      /* length of largest ghost layer                       */
+  int    root = 0;
+  int    n, width, height, depth; /* linear global and local grid dimensions     */
+  long   ncube;           /* total number of grid points                         */
+  int    i, j, k, ii, jj, kk, d, iter; /* dummies                                */
+  long   idx;         /* index into the input array                              */
+  int    start[3], end[3];/* bounds of grid block assigned to calling rank       */
+  int    lo[3], hi[3];    /* bounds of a ghost layer                             */
+  int    count;           /* number of values in a ghost layer                   */
+  DTYPE  norm,            /* L1 norm of solution                                 */
+         local_norm,      /* contribution of calling rank to L1 norm             */
+         reference_norm;
+  DTYPE  f_active_points; /* interior of grid with respect to stencil            */
+  DTYPE  flops;           /* floating point ops per iteration                    */
+  int    iterations;      /* number of times to run the algorithm                */
+  prk_harness_t harness;  /* per-iteration timing                                */
+  prk_phase_t   halo;     /* timing of the ghost point exchange                  */
+  double local_stencil_time,/* timing parameters                                 */
+         stencil_time,
+         avgtime; 
+  int    stencil_size;    /* number of points in stencil                         */
+  DTYPE  * RESTRICT in;   /* input grid values                                   */
+  DTYPE  * RESTRICT out;  /* output grid values                                  */
+  long   total_length_in; /* total required length to store input array          */
+  long   total_length_out;/* total required length to store output array         */
+  int    error=0;         /* error flag                                          */
+  DTYPE  weight[2*RADIUS+1][2*RADIUS+1][2*RADIUS+1]; /* stencil weights          */
+  double shell;           /* sum of squared offsets in a shell of the stencil    */
+  int    s;               /* shell of the compact stencil                        */
+  MPI_Request request[4];
+  MPI_Status  status[4];
+ 
+  /*******************************************************************************
+  ** Initialize the MPI environment
+  ********************************************************************************/
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+
+  /*******************************************************************************
+  ** process, test, and broadcast input parameters    
+  ********************************************************************************/
+ 
+  if (my_ID == root) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPI stencil execution on 3D grid\n");
+    
+    if (argc != 3){
+      printf("Usage: %s <# iterations> <array dimension> \n", 
+             *argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+ 
+    iterations  = atoi(*++argv); 
+    if (iterations < 1){
+      printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+ 
+    n     = atoi(*++argv); 
+    ncube = (long) n * (long) n * (long) n;
+    if (ncube < Num_procs){ 
+      printf("ERROR: grid size %ld must be at least # ranks: %d\n",
+	     ncube, Num_procs);
+      error = 1; 
+      goto ENDOFTESTS; 
+    }
+ 
+    if (RADIUS < 1) {
+      printf("ERROR: Stencil radius %d should be positive\n", RADIUS);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+ 
+    if (2*RADIUS +1 > n) {
+      printf("ERROR: Stencil radius %d exceeds grid size %d\n", RADIUS, n);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+ 
+    ENDOFTESTS:;  
+  }
+  bail_out(error);
+ 
+  /* determine best way to create a 3D grid of ranks (closest to a cube, for 
+     best surface/volume ratio); as in the 2D case we do this brute force,
+     keeping the smallest number of ranks in x so that rows stay long
+  */
+  Num_procsd[0] = Num_procsd[1] = 1; Num_procsd[2] = Num_procs;
+  for (px=1; px*px*px<=Num_procs; px++) {
+    if (Num_procs%px) continue;
+    for (py=px; px*py*py<=Num_procs; py++) {
+      if ((Num_procs/px)%py) continue;
+      pz = Num_procs/(px*py);
+      if (px+py+pz < Num_procsd[0]+Num_procsd[1]+Num_procsd[2]) {
+        Num_procsd[0] = px; Num_procsd[1] = py; Num_procsd[2] = pz;
+      }
+    }
+  }
+  my_IDd[0] = my_ID%Num_procsd[0];
+  my_IDd[1] = (my_ID/Num_procsd[0])%Num_procsd[1];
+  my_IDd[2] = my_ID/(Num_procsd[0]*Num_procsd[1]);
+  /* compute neighbors; don't worry about dropping off the edges of the grid */
+  stride[0] = 1;
+  stride[1] = Num_procsd[0];
+  stride[2] = Num_procsd[0]*Num_procsd[1];
+ 
+  if (my_ID == root) {
+    printf("Number of ranks          = %d\n", Num_procs);
+    printf("Grid size                = %d\n", n);
+    printf("Radius of stencil        = %d\n", RADIUS);
+    printf("Tiles in x/y/z-direction = %d/%d/%d\n", 
+           Num_procsd[0], Num_procsd[1], Num_procsd[2]);
+#if STAR
+    printf("Type of stencil          = star\n");
+#else
+    printf("Type of stencil          = compact\n");
+#endif
+#if DOUBLE
+    printf("Data type                = double precision\n");
+#else
+    printf("Data type                = single precision\n");
+#endif
+    printf("Number of iterations     = %d\n", iterations);
+  }
+ 
+  MPI_Bcast(&n,          1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  prk_topology_bind();
+ 
+  /* compute amount of space required for input and solution arrays             */
+  for (d=0; d<3; d++) {
+    split(n, Num_procsd[d], my_IDd[d], &start[d], &end[d]);
+    if (end[d]-start[d]+1 < RADIUS) {
+      printf("ERROR: rank %d has work tile smaller then stencil radius\n",
+             my_ID);
+      error = 1;
+    }
+  }
+  bail_out(error);
+  width  = end[0]-start[0]+1;
+  height = end[1]-start[1]+1;
+  depth  = end[2]-start[2]+1;
+ 
+  total_length_in  = (long) (width+2*RADIUS)*(long) (height+2*RADIUS)*
+                     (long) (depth+2*RADIUS)*sizeof(DTYPE);
+  total_length_out = (long) width*(long) height*(long) depth*sizeof(DTYPE);
+ 
+  in  = (DTYPE *) prk_malloc(total_length_in);
+  out = (DTYPE *) prk_malloc(total_length_out);
+  if (!in || !out) {
+    printf("ERROR: rank %d could not allocate space for input/output array\n",
+            my_ID);
+    error = 1;
+  }
+  bail_out(error);
+ 
+  /* fill the stencil weights to reflect a discrete divergence operator; in the
+     compact stencil the weight of a point in the cubic shell s is proportional
+     to the sum of its offsets, scaled so that every shell contributes 1/RADIUS
+     of the divergence                                                           */
+  for (kk=-RADIUS; kk<=RADIUS; kk++) for (jj=-RADIUS; jj<=RADIUS; jj++)
+  for (ii=-RADIUS; ii<=RADIUS; ii++) WEIGHT(ii,jj,kk) = (DTYPE) 0.0;
+#if STAR
+  stencil_size = 6*RADIUS+1;
+  for (ii=1; ii<=RADIUS; ii++) {
+    WEIGHT(ii,0,0) = WEIGHT(0,ii,0) = WEIGHT(0,0,ii) =  (DTYPE) (1.0/(2.0*ii*RADIUS));
+    WEIGHT(-ii,0,0)= WEIGHT(0,-ii,0)= WEIGHT(0,0,-ii)= -(DTYPE) (1.0/(2.0*ii*RADIUS));
+  }
+#else
+  stencil_size = (2*RADIUS+1)*(2*RADIUS+1)*(2*RADIUS+1);
+  for (s=1; s<=RADIUS; s++) {
+    shell = 0.0;
+    for (kk=-s; kk<=s; kk++) for (jj=-s; jj<=s; jj++) for (ii=-s; ii<=s; ii++)
+      if (MAX(ABS(ii),MAX(ABS(jj),ABS(kk))) == s) shell += ii*ii;
+    for (kk=-s; kk<=s; kk++) for (jj=-s; jj<=s; jj++) for (ii=-s; ii<=s; ii++)
+      if (MAX(ABS(ii),MAX(ABS(jj),ABS(kk))) == s)
+        WEIGHT(ii,jj,kk) = (DTYPE) ((ii+jj+kk)/(shell*RADIUS));
+  }
+#endif
+ 
+  norm = (DTYPE) 0.0;
+  f_active_points = (DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS);
+  /* intialize the input and output arrays; ghost points on the boundary of
+     the global grid are never exchanged and stay zero                         */
+  for (idx=0; idx<total_length_in/(long)sizeof(DTYPE); idx++) in[idx] = (DTYPE)0.0;
+  for (k=start[2]; k<=end[2]; k++) for (j=start[1]; j<=end[1]; j++) 
+  for (i=start[0]; i<=end[0]; i++) {
+    IN(i,j,k)  = COEFX*i+COEFY*j+COEFZ*k;
+    OUT(i,j,k) = (DTYPE)0.0;
+  }
+
+  if (Num_procs > 1) { 
+    /* allocate communication buffers for the largest ghost layer, which 
+       includes the ghost points of the directions exchanged before it         */
+    buf_length = MAX((long) RADIUS*height*depth,
+                 MAX((long) RADIUS*(width+2*RADIUS)*depth,
+                     (long) RADIUS*(width+2*RADIUS)*(height+2*RADIUS)));
+    buf_out_hi = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*buf_length);
+    if (!buf_out_hi) {
+      printf("ERROR: Rank %d could not allocated comm buffers\n", my_ID);
+      error = 1;
+    }
+    bail_out(error);
+    buf_in_hi  = buf_out_hi +   buf_length;
+    buf_out_lo = buf_out_hi + 2*buf_length;
+    buf_in_lo  = buf_out_hi + 3*buf_length;
+  }
+
+  prk_harness_init(&harness, "Stencil3D", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%ld", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "shape", "%s", STAR ? "star" : "compact");
+
+  prk_phase_init(&halo, "halo exchange");
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* time every iteration after a warmup iteration */
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
+    if (iter == 1) prk_phase_reset(&halo);
+ 
+    prk_phase_begin(&halo);
+
+    /* fetch ghost point data from neighbors in x, y and z in turn; the layers
+       of later directions span the ghost points of earlier ones               */
+    for (d=0; d<3; d++) {
+      if (Num_procsd[d] == 1) continue;
+      for (ii=0; ii<3; ii++) {
+        lo[ii] = start[ii] - (ii<d ? RADIUS : 0);
+        hi[ii] = end[ii]   + (ii<d ? RADIUS : 0);
+      }
+      if (my_IDd[d] < Num_procsd[d]-1) {
+        lo[d] = end[d]-RADIUS+1; hi[d] = end[d];
+        count = copy_box(in, buf_out_hi, lo, hi, start, width, height, 0);
+        MPI_Irecv(buf_in_hi, count, MPI_DTYPE, my_ID+stride[d], 100+2*d,
+                  MPI_COMM_WORLD, &(request[1]));
+        MPI_Isend(buf_out_hi, count, MPI_DTYPE, my_ID+stride[d], 101+2*d,
+                  MPI_COMM_WORLD, &(request[0]));
+      }
+      if (my_IDd[d] > 0) {
+        lo[d] = start[d]; hi[d] = start[d]+RADIUS-1;
+        count = copy_box(in, buf_out_lo, lo, hi, start, width, height, 0);
+        MPI_Irecv(buf_in_lo, count, MPI_DTYPE, my_ID-stride[d], 101+2*d,
+                  MPI_COMM_WORLD, &(request[3]));
+        MPI_Isend(buf_out_lo, count, MPI_DTYPE, my_ID-stride[d], 100+2*d,
+                  MPI_COMM_WORLD, &(request[2]));
+      }
+      if (my_IDd[d] < Num_procsd[d]-1) {
+        MPI_Waitall(2, &(request[0]), &(status[0]));
+        lo[d] = end[d]+1; hi[d] = end[d]+RADIUS;
+        copy_box(in, buf_in_hi, lo, hi, start, width, height, 1);
+      }
+      if (my_IDd[d] > 0) {
+        MPI_Waitall(2, &(request[2]), &(status[2]));
+        lo[d] = start[d]-RADIUS; hi[d] = start[d]-1;
+        copy_box(in, buf_in_lo, lo, hi, start, width, height, 1);
+      }
+    }
+
+    prk_phase_end(&halo);
+
+    /* Apply the stencil operator */
+    for (k=MAX(start[2],RADIUS); k<=MIN(n-RADIUS-1,end[2]); k++) {
+      for (j=MAX(start[1],RADIUS); j<=MIN(n-RADIUS-1,end[1]); j++) {
+        for (i=MAX(start[0],RADIUS); i<=MIN(n-RADIUS-1,end[0]); i++) {
+#if STAR
+          for (kk=-RADIUS; kk<=RADIUS; kk++) OUT(i,j,k) += WEIGHT(0,0,kk)*IN(i,j,k+kk);
+          for (jj=-RADIUS; jj<0; jj++)       OUT(i,j,k) += WEIGHT(0,jj,0)*IN(i,j+jj,k);
+          for (jj=1; jj<=RADIUS; jj++)       OUT(i,j,k) += WEIGHT(0,jj,0)*IN(i,j+jj,k);
+          for (ii=-RADIUS; ii<0; ii++)       OUT(i,j,k) += WEIGHT(ii,0,0)*IN(i+ii,j,k);
+          for (ii=1; ii<=RADIUS; ii++)       OUT(i,j,k) += WEIGHT(ii,0,0)*IN(i+ii,j,k);
+#else
+          for (kk=-RADIUS; kk<=RADIUS; kk++)
+          for (jj=-RADIUS; jj<=RADIUS; jj++)
+          for (ii=-RADIUS; ii<=RADIUS; ii++) 
+            OUT(i,j,k) += WEIGHT(ii,jj,kk)*IN(i+ii,j+jj,k+kk);
+#endif
+        }
+      }
+    }
+ 
+    /* add constant to solution to force refresh of neighbor data, if any */
+    for (k=start[2]; k<=end[2]; k++) for (j=start[1]; j<=end[1]; j++) 
+    for (i=start[0]; i<=end[0]; i++) IN(i,j,k)+= 1.0;
+ 
+  } /* end of iterations                                                   */
+
+  prk_harness_tick(&harness);
+  local_stencil_time = prk_harness_elapsed(&harness);
+  MPI_Reduce(&local_stencil_time, &stencil_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
+  
+  /* compute L1 norm in parallel                                                */
+  local_norm = (DTYPE) 0.0;
+  for (k=MAX(start[2],RADIUS); k<=MIN(n-RADIUS-1,end[2]); k++) {
+    for (j=MAX(start[1],RADIUS); j<=MIN(n-RADIUS-1,end[1]); j++) {
+      for (i=MAX(start[0],RADIUS); i<=MIN(n-RADIUS-1,end[0]); i++) {
+        local_norm += (DTYPE)ABS(OUT(i,j,k));
+      }
+    }
+  }
+ 
+  MPI_Reduce(&local_norm, &norm, 1, MPI_DTYPE, MPI_SUM, root, MPI_COMM_WORLD);
+ 
+  /*******************************************************************************
+  ** Analyze and output results.
+  ********************************************************************************/
+ 
+/* verify correctness                                                            */
+  if (my_ID == root) {
+    norm /= f_active_points;
+    reference_norm = (DTYPE) (iterations+1) * (COEFX + COEFY + COEFZ);
+    if (ABS(norm-reference_norm) > EPSILON) {
+      printf("ERROR: L1 norm = "FSTR", Reference L1 norm = "FSTR"\n",
+             norm, reference_norm);
+      error = 1;
+    }
+    else {
+      printf("Solution validates\n");
+#if VERBOSE
+      printf("Reference L1 norm = "FSTR", L1 norm = "FSTR"\n", 
+             reference_norm, norm);
+#endif
+    }
+  }
+  bail_out(error);
+ 
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
+  if (my_ID == root) {
+    avgtime = stencil_time/iterations;
+    printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
+           1.0E-06 * flops/avgtime, avgtime);
+  }
+  /* reads of IN and read-modify-writes of OUT and of all of IN */
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_phase_report(&halo);
+  prk_harness_finalize(&harness);
+ 
+  MPI_Finalize();
+  exit(EXIT_SUCCESS);
+}
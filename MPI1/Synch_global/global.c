@@ -46,6 +46,16 @@ USAGE:   The program takes as input the number of times the test of
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         PRK_COLLECTIVE selects how the strings are gathered:
+           blocking     MPI_Allgather (default)
+           nonblocking  MPI_Iallgather (MPI-3), overlapped with local work
+           persistent   a persistent allgather started every iteration
+                        (MPI-4 MPI_Allgather_init, or the Open MPI extension)
+         In the last two modes each rank does synthetic local work of about
+         the duration of a blocking allgather (measured at startup) before
+         it waits for the allgather, and the overlap fraction achieved is
+         reported; see MPI1/Reduce. The reported time includes the work.
+
          Compile with VERBOSE defined if you want lots of output.
 
 FUNCTIONS CALLED:
@@ -55,7 +65,11 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
          chartoi()
+         prk_overlap_work()
+         prk_overlap_reps()
+         prk_overlap_fraction()
 
 HISTORY: Written by Rob Van der Wijngaart, December 2005.
   
@@ -63,9 +77,18 @@ HISTORY: Written by Rob Van der Wijngaart, December 2005.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 #define EOS '\0'
 
+#define BLOCKING    0
+#define NONBLOCKING 1
+#define PERSISTENT  2
+
+/* size of the local work array (doubles) and number of calibration runs     */
+#define WORKLEN     4096
+#define CALIBRATE   5
+
 int chartoi(char c) {
   /* define short string; need two characters, second contains string terminator */
   char letter[2]="0";
@@ -92,6 +115,18 @@ int main(int argc, char ** argv)
   double stopngo_time;/* timing parameter                                        */
   int    Num_procs;   /* Number of ranks                                         */
   int    error = 0;   /* error flag                                              */
+  int    collective = BLOCKING; /* how the strings are gathered                  */
+  char   *env;        /* value of PRK_COLLECTIVE                                 */
+  char   *scratch;    /* strings gathered to time blocking allgathers            */
+  double *work;       /* local work array                                        */
+  long   reps;        /* passes over the work array per iteration                */
+  double coll_time,   /* time of a blocking allgather                            */
+         work_time=0.0, /* time spent in local work                              */
+         t0;
+  prk_harness_t harness; /* per-iteration timing                                 */
+#if MPI_VERSION >= 3
+  MPI_Request request;/* request of nonblocking or persistent allgather          */
+#endif
 
 /*********************************************************************************
 ** Initialize the MPI environment
@@ -129,6 +164,32 @@ int main(int argc, char ** argv)
       goto ENDOFTESTS;
      }
 
+    env = getenv("PRK_COLLECTIVE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"nonblocking")) collective = NONBLOCKING;
+      else if (!strcmp(env,"persistent"))  collective = PERSISTENT;
+      else if (strcmp(env,"blocking")) {
+        printf("ERROR: PRK_COLLECTIVE must be blocking, nonblocking, or persistent: %s\n",
+               env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+#if MPI_VERSION < 3
+    if (collective == NONBLOCKING) {
+      printf("ERROR: PRK_COLLECTIVE=nonblocking requires MPI-3\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
+#ifndef PRK_HAVE_PERSISTENT_COLLECTIVES
+    if (collective == PERSISTENT) {
+      printf("ERROR: PRK_COLLECTIVE=persistent requires MPI-4 persistent collectives\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
+
      ENDOFTESTS:;
   }
   bail_out(error);
@@ -137,11 +198,15 @@ int main(int argc, char ** argv)
     printf("Number of ranks        = %d\n", Num_procs);
     printf("Scramble string length = %ld\n", length);
     printf("Number of iterations   = %d\n", iterations);
+    printf("Collective             = %s\n", collective==BLOCKING    ? "blocking" :
+                                             collective==NONBLOCKING ? "nonblocking" :
+                                                                       "persistent");
   }
 
   /* Broadcast benchmark data to all ranks */
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&length,     1, MPI_LONG, root, MPI_COMM_WORLD);
+  MPI_Bcast(&collective, 1, MPI_INT, root, MPI_COMM_WORLD);
   proc_length = length/Num_procs;
 
   basestring = prk_malloc((proc_length+1)*sizeof(char));
@@ -191,13 +256,67 @@ int main(int argc, char ** argv)
   MPI_Type_contiguous(proc_length,MPI_CHAR, &mpi_word);
   MPI_Type_commit(&mpi_word);
 
+  if (collective != BLOCKING) {
+    work    = (double *) prk_malloc(WORKLEN*sizeof(double));
+    scratch = (char *) prk_malloc((length+proc_length)*sizeof(char));
+    if (work==NULL || scratch==NULL) {
+      printf("ERROR: Could not allocate space for local work in rank %d\n", my_ID);
+      error = 1;
+    }
+    bail_out(error);
+    for (i=0; i<WORKLEN; i++) work[i] = 0.0;
+    for (i=0; i<length+proc_length; i++) scratch[i] = '9';
+
+    /* size the local work to match a blocking allgather, after a warmup     */
+    for (iter=0; iter<=CALIBRATE; iter++) {
+      if (iter == 1) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        coll_time = wtime();
+      }
+      MPI_Allgather(scratch+length,1,mpi_word, scratch,1,mpi_word, MPI_COMM_WORLD);
+    }
+    coll_time = (wtime() - coll_time)/CALIBRATE;
+    MPI_Allreduce(MPI_IN_PLACE, &coll_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    reps = prk_overlap_reps(work, WORKLEN, coll_time);
+  }
+
+#ifdef PRK_HAVE_PERSISTENT_COLLECTIVES
+  if (collective == PERSISTENT)
+    PRK_Allgather_init(iterstring,1,mpi_word, catstring,1,mpi_word, MPI_COMM_WORLD,
+                       MPI_INFO_NULL, &request);
+#endif
+
+  prk_harness_init(&harness, "Synch_global", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "length", "%ld", length);
+  prk_harness_param(&harness, "collective", "%s", collective == BLOCKING    ? "blocking"    :
+                                                  collective == NONBLOCKING ? "nonblocking" :
+                                                                              "persistent");
+
+  /* there is no warmup iteration, so every iteration is timed           */
   MPI_Barrier(MPI_COMM_WORLD);
-  stopngo_time = wtime();
+  prk_harness_tick(&harness);
 
   for (iter=0; iter<iterations; iter++) { 
 
     /* Everybody sends own string to everybody else and concatenates */
-    MPI_Allgather(iterstring,1,mpi_word, catstring,1,mpi_word, MPI_COMM_WORLD);
+    if (collective == BLOCKING)
+      MPI_Allgather(iterstring,1,mpi_word, catstring,1,mpi_word, MPI_COMM_WORLD);
+#if MPI_VERSION >= 3
+    else {
+      if (collective == NONBLOCKING)
+        MPI_Iallgather(iterstring,1,mpi_word, catstring,1,mpi_word, MPI_COMM_WORLD,
+                       &request);
+      else MPI_Start(&request);
+
+      /* local work that does not touch the strings overlaps the allgather  */
+      t0 = wtime();
+      prk_overlap_work(work, WORKLEN, reps);
+      work_time += wtime() - t0;
+
+      MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }
+#endif
 
     /* now everybody selects a different substring */
     for (i=0; i<proc_length; i++) iterstring[i]=catstring[my_ID+i*Num_procs];
@@ -210,9 +329,15 @@ int main(int argc, char ** argv)
              iter, catstring, checksum);
     }
 #endif
+    prk_harness_tick(&harness);
   }
 
-  stopngo_time = wtime() - stopngo_time;
+  stopngo_time = prk_harness_elapsed(&harness);
+  MPI_Allreduce(MPI_IN_PLACE, &stopngo_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &work_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#ifdef PRK_HAVE_PERSISTENT_COLLECTIVES
+  if (collective == PERSISTENT) MPI_Request_free(&request);
+#endif
 
   /* compute checksum on obtained result, adding all digits in the string */
   if (my_ID==0) {
@@ -228,8 +353,15 @@ int main(int argc, char ** argv)
     }
     printf("Rate (synch/s): %lf, time (s): %lf\n", 
            (iterations/stopngo_time), stopngo_time);
+    if (collective != BLOCKING)
+      printf("Blocking allgather (s): %lf  Local work (s): %lf  Overlap fraction: %lf\n",
+             coll_time, work_time/iterations,
+             prk_overlap_fraction(coll_time, work_time/iterations, stopngo_time/iterations));
   }
 
+  prk_harness_report(&harness, "synch/s", 1.0);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
 
 
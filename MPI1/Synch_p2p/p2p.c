@@ -42,11 +42,21 @@ PURPOSE: This program tests the efficiency with which point-to-point
 USAGE:   The program takes as input the dimensions of the grid, and the
          number of times we loop over the grid
 
-               <progname> <# iterations> <m> <n>
+               <progname> <# iterations> <m> <n> [group factor]
   
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         By default every rank sweeps its strip line by line, which carries
+         a dependence from each point to the next and cannot be vectorized.
+         With PRK_P2P_SWEEP=diagonal the strip is stored skewed, so that each
+         anti-diagonal (points with the same i+j) is contiguous, and swept
+         one anti-diagonal at a time; the points of an anti-diagonal are
+         independent, so the inner loop vectorizes. Messages still carry
+         the same lines (or line groups) as in the line sweep, but a line
+         can only be sent once the anti-diagonal through its last point is
+         done, which lengthens the pipeline fill by the strip width.
+
 FUNCTIONS CALLED:
 
          Other than MPI or standard C functions, the following 
@@ -54,6 +64,7 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, March 2006.
          - modified by Rob Van der Wijngaart, August 2006:
@@ -66,8 +77,12 @@ HISTORY: - Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 #define ARRAY(i,j) vector[i+1+(j)*(segment_size+1)]
+/* skewed storage: point (i,j) of the strip, i counted from the ghost column,
+   is stored on anti-diagonal i+j, and every anti-diagonal has width points    */
+#define SKEW(i,j)  skewed[(i)+((j)+(i))*width]
 
 int main(int argc, char ** argv)
 {
@@ -91,6 +106,14 @@ int main(int argc, char ** argv)
   double *inbuf, *outbuf; /* communication buffers used when aggregating         */
   long   total_length;    /* total required length to store grid values          */
   MPI_Status status;      /* completion status of message                        */
+  int    diagonal=0;      /* sweep strips by anti-diagonals                      */
+  char   *env;            /* value of PRK_P2P_SWEEP                              */
+  long   width;           /* width of strip including ghost column               */
+  long   d, li, ilo, ihi; /* anti-diagonal and point indices in skewed storage   */
+  long   jr, js;          /* next line (group) to receive and to send            */
+  double RESTRICT *skewed;/* strip in skewed storage                             */
+  double RESTRICT *cur, *prev, *prev2; /* current and previous anti-diagonals    */
+  prk_harness_t harness;  /* per-iteration timing                                */
 
 /*********************************************************************************
 ** Initialize the MPI environment
@@ -146,6 +169,16 @@ int main(int argc, char ** argv)
     }
     else grp = 1;
 
+    env = getenv("PRK_P2P_SWEEP");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"diagonal")) diagonal = 1;
+      else if (strcmp(env,"line")) {
+        printf("ERROR: PRK_P2P_SWEEP must be line or diagonal: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
     ENDOFTESTS:;
   }
   bail_out(error); 
@@ -156,6 +189,7 @@ int main(int argc, char ** argv)
     printf("Number of iterations           = %d\n", iterations);
     if (grp > 1)
     printf("Group factor                   = %d (cheating!)\n", grp);
+    printf("Local sweep                    = %s\n", diagonal ? "anti-diagonal" : "line");
   }
   
   /* Broadcast benchmark data to all rankes */
@@ -163,6 +197,7 @@ int main(int argc, char ** argv)
   MPI_Bcast(&n,          1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&grp,        1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&diagonal,   1, MPI_INT, root, MPI_COMM_WORLD);
 
   int leftover;
   segment_size = m/Num_procs;
@@ -179,9 +214,13 @@ int main(int argc, char ** argv)
   /* now set segment_size to the value needed by the calling rank               */
   segment_size = end - start + 1;
 
-  /* total_length takes into account one ghost cell on left side of segment     */
-  total_length = ((end-start+1)+1)*n;
+  /* total_length takes into account one ghost cell on left side of segment;
+     skewed storage holds n+width-1 anti-diagonals                               */
+  width = segment_size+1;
+  if (diagonal) total_length = (n+width-1)*width;
+  else          total_length = width*n;
   vector = (double *) prk_malloc(total_length*sizeof(double));
+  skewed = vector;
   if (vector == NULL) {
     printf("Could not allocate space for grid slice of %ld by %ld points",
            segment_size, n);
@@ -201,6 +240,14 @@ int main(int argc, char ** argv)
   bail_out(error);
   outbuf = inbuf + grp;
    
+  if (diagonal) {
+    /* clear the array, including the unused corners of the skewed storage      */
+    for (li=0; li<total_length; li++) skewed[li] = 0.0;
+    /* set boundary values (bottom and left side of grid */
+    if (my_ID==0) for (j=0; j<n; j++) SKEW(1,j) = (double) j;
+    for (i=start-1; i<=end; i++)      SKEW(i-start+1,0) = (double) i;
+  }
+  else {
   /* clear the array                                                             */
   for (j=0; j<n; j++) for (i=start-1; i<=end; i++) {
     ARRAY(i-start,j) = 0.0;
@@ -208,18 +255,70 @@ int main(int argc, char ** argv)
   /* set boundary values (bottom and left side of grid */
   if (my_ID==0) for (j=0; j<n; j++) ARRAY(0,j) = (double) j;
   for (i=start-1; i<=end; i++)      ARRAY(i-start,0) = (double) i;
+  }
 
   /* redefine start and end for calling rank to reflect local indices            */
   if (my_ID==0) start = 1; 
   else          start = 0;
   end = segment_size-1;
 
+  prk_harness_init(&harness, "Synch_p2p", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
+  prk_harness_param(&harness, "group", "%d", grp);
+  prk_harness_param(&harness, "sweep", "%s", diagonal ? "diagonal" : "line");
+
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_pipeline_time = wtime();
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
+
+    if (diagonal) {
+
+      /* sweep the anti-diagonals through grid lines 1 through n-1; a line group
+         is received just before the first anti-diagonal that needs its ghost
+         values, and sent right after the one that completes its last column    */
+      for (jr=1, js=1, d=2; d<n+width-1; d++) {
+
+        if (my_ID > 0 && jr < n && d-1 == jr) {
+          jjsize = MIN(grp, n-jr);
+          MPI_Recv(inbuf, jjsize, MPI_DOUBLE, my_ID-1, jr, MPI_COMM_WORLD, &status);
+          for (jj=0; jj<jjsize; jj++) SKEW(0,jr+jj) = inbuf[jj];
+          jr += jjsize;
+        }
+
+        ilo   = MAX(start+1, d-(n-1));
+        ihi   = MIN(width-1, d-1);
+        cur   = &skewed[d*width];
+        prev  = cur  - width;
+        prev2 = prev - width;
+        for (li=ilo; li<=ihi; li++) {
+          cur[li] = prev[li-1] + prev[li] - prev2[li-1];
+        }
+
+        if (my_ID < Num_procs-1 && js < n && d-(width-1) == js+MIN(grp, n-js)-1) {
+          jjsize = MIN(grp, n-js);
+          for (jj=0; jj<jjsize; jj++) outbuf[jj] = SKEW(width-1,js+jj);
+          MPI_Send(outbuf, jjsize, MPI_DOUBLE, my_ID+1, js, MPI_COMM_WORLD);
+          js += jjsize;
+        }
+      }
+
+      /* copy top right corner value to bottom left corner to create dependency   */
+      if (Num_procs >1) {
+        if (my_ID==final) {
+          corner_val = -SKEW(width-1,n-1);
+          MPI_Send(&corner_val,1,MPI_DOUBLE,root,888,MPI_COMM_WORLD);
+        }
+        if (my_ID==root) {
+          MPI_Recv(&(SKEW(1,0)),1,MPI_DOUBLE,final,888,MPI_COMM_WORLD,&status);
+        }
+      }
+      else SKEW(1,0)= -SKEW(width-1,n-1);
+
+      continue;
     }
 
     /* execute pipeline algorithm for grid lines 1 through n-1 (skip bottom line) */
@@ -281,7 +380,8 @@ int main(int argc, char ** argv)
 
   }
 
-  local_pipeline_time = wtime() - local_pipeline_time;
+  prk_harness_tick(&harness);
+  local_pipeline_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_pipeline_time, &pipeline_time, 1, MPI_DOUBLE, MPI_MAX, final,
              MPI_COMM_WORLD);
 
@@ -291,7 +391,14 @@ int main(int argc, char ** argv)
  
   /* verify correctness, using top right value                                     */
   corner_val = (double) ((iterations+1)*(m+n-2));
-  if (my_ID == final) {
+  if (my_ID == final && diagonal) {
+    if (abs(SKEW(width-1,n-1)-corner_val)/corner_val >= epsilon) {
+      printf("ERROR: checksum %lf does not match verification value %lf\n",
+             SKEW(width-1,n-1), corner_val);
+      error = 1;
+    }
+  }
+  else if (my_ID == final) {
     if (abs(ARRAY(end,n-1)-corner_val)/corner_val >= epsilon) {
       printf("ERROR: checksum %lf does not match verification value %lf\n",
              ARRAY(end,n-1), corner_val);
@@ -314,6 +421,9 @@ int main(int argc, char ** argv)
     printf("Rate (MFlops/s): %lf Avg time (s): %lf\n",
            1.0E-06 * 2 * ((double)((m-1)*(n-1)))/avgtime, avgtime);
   }
+
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * ((double)((m-1)*(n-1))));
+  prk_harness_finalize(&harness);
  
   MPI_Finalize();
   exit(EXIT_SUCCESS);
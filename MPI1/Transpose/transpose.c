@@ -45,6 +45,43 @@ USAGE:   Program inputs are the matrix order, the number of times to
 
          An optional parameter specifies the tile size used to divide the 
          individual matrix blocks for improved cache and TLB performance. 
+
+         With PRK_TRANSPOSE=inplace no transposed matrix is allocated:
+         every iteration replaces A by A^T + 1.  In phase p each rank
+         exchanges block (p - rank) mod #ranks with the rank that owns
+         its mirror image, through the Work_in and Work_out buffers, and
+         overwrites it with the block received; the one block that is its
+         own mirror image is transposed locally by swapping tile pairs.
+         Matrices of an order sqrt(2) larger fit in the same memory.  The
+         default is PRK_TRANSPOSE=tiled.
+
+         PRK_EXCHANGE selects how the blocks of the (not in-place)
+         transpose are exchanged:
+           phased     one message pair outstanding in each of #ranks-1
+                      phases (default)
+           alltoall   all blocks are packed, exchanged with a single
+                      MPI_Alltoallv, and scattered
+           pipelined  PRK_PIPELINE_DEPTH (default 4) phases are in flight
+                      while blocks already received are scattered;
+                      always uses non-blocking messages
+
+         With PRK_DISTRIBUTION=2d the matrices are instead distributed
+         by square blocks over a square grid of ranks, so that each rank
+         exchanges its block with just the rank owning the mirror image
+         block (see the layout nomenclature below).  The number of ranks
+         must be a perfect square.  The default is PRK_DISTRIBUTION=column.
+
+         With PRK_BATCH=n (n > 1) every iteration transposes a batch of n
+         matrices of the given order, as in FFT-style workloads: the
+         blocks of matrix k are packed and their messages posted before
+         the local transpose and scatter of matrix k-1, so that the
+         communication of one matrix overlaps the local work on the
+         previous one.  Batches always use non-blocking messages, and the
+         reported rate is that of the whole batch.
+
+         With PRK_PROGRESS=1|spare|cpu:<k> a helper thread polls the MPI
+         library while the rank computes, so that messages progress
+         asynchronously (see prk_progress.h).
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -55,7 +92,13 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
           wtime()           Portable wall-timer interface.
+          prk_topology_bind() Optional pinning of threads and ranks.
+          prk_progress_*()  Optional asynchronous progress thread.
           bail_out()        Determine global error and exit if nonzero.
+          prk_harness_*()   Per-iteration timing and results record.
+          pack_block()      Transpose a block of A into a send buffer.
+          scatter_block()   Add a received block to B.
+          transpose_local() Transpose the diagonal block of A into B.
 
 HISTORY: Written by Tim Mattson, April 1999.  
          Updated by Rob Van der Wijngaart, December 2005.
@@ -69,6 +112,10 @@ HISTORY: Written by Tim Mattson, April 1999.
            produce unit stride
          - changed initialization values, such that the input matrix
            elements are: A(i,j) = i+order*j
+         Added the in-place transpose.
+         Added the all-to-all and pipelined exchanges.
+         Added the 2D block distribution.
+         Added batches of matrices.
          
   
 *******************************************************************/
@@ -92,6 +139,11 @@ o Colblock is logically composed of #ranks Blocks, but a Block is
 o When tiling is applied to reduce TLB misses, each block gets 
   accessed by tiles. 
 o The original and transposed matrices are called A and B
+o With the 2D distribution a rank with grid coordinates (r,c) owns
+  only Block (r,c) of both matrices, stored contiguously; it sends
+  the transpose of its Block of A to rank (c,r) and adds the Block it
+  receives from there to its Block of B.  Ranks on the diagonal of the
+  grid transpose their Block locally
 
  -----------------------------------------------------------------
 |           |           |           |                             |
@@ -121,11 +173,86 @@ o The original and transposed matrices are called A and B
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
 
 #define A(i,j)        A_p[(i+istart)+order*(j)]
 #define B(i,j)        B_p[(i+istart)+order*(j)]
 #define Work_in(i,j)  Work_in_p[i+Block_order*(j)]
 #define Work_out(i,j) Work_out_p[i+Block_order*(j)]
+/* square blocks of the 2D distribution                                  */
+#define A2(i,j)       A_p[i+Block_order*(j)]
+#define B2(i,j)       B_p[i+Block_order*(j)]
+
+/* ways to exchange the blocks of the transpose                          */
+#define EXCHANGE_PHASED    0
+#define EXCHANGE_ALLTOALL  1
+#define EXCHANGE_PIPELINED 2
+
+/* function that transposes the block of A starting at row istart into
+   Work_out, and adds one to the block                                   */
+
+static void pack_block(long order, long Block_order, int istart, int Tile_order,
+                       int tiling, double *A_p, double *Work_out_p) {
+
+  int i, j, it, jt;
+
+  if (!tiling) {
+    for (i=0; i<Block_order; i++)
+      for (j=0; j<Block_order; j++){
+        Work_out(j,i) = A(i,j);
+        A(i,j) += 1.0;
+      }
+  }
+  else {
+    for (i=0; i<Block_order; i+=Tile_order)
+      for (j=0; j<Block_order; j+=Tile_order)
+        for (it=i; it<MIN(Block_order,i+Tile_order); it++)
+          for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
+            Work_out(jt,it) = A(it,jt);
+            A(it,jt) += 1.0;
+          }
+  }
+}
+
+/* function that transposes the block of A starting at row istart into
+   the same block of B, and adds one to it                               */
+
+static void transpose_local(long order, long Block_order, int istart, int Tile_order,
+                            int tiling, double *A_p, double *B_p) {
+
+  int i, j, it, jt;
+
+  if (!tiling) {
+    for (i=0; i<Block_order; i++)
+      for (j=0; j<Block_order; j++) {
+        B(j,i) += A(i,j);
+        A(i,j) += 1.0;
+      }
+  }
+  else {
+    for (i=0; i<Block_order; i+=Tile_order)
+      for (j=0; j<Block_order; j+=Tile_order)
+        for (it=i; it<MIN(Block_order,i+Tile_order); it++)
+          for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
+            B(jt,it) += A(it,jt);
+            A(it,jt) += 1.0;
+          }
+  }
+}
+
+/* function that adds the received block Work_in to the block of B
+   starting at row istart; no need to tile                               */
+
+static void scatter_block(long order, long Block_order, int istart,
+                          double *B_p, double *Work_in_p) {
+
+  int i, j;
+
+  for (j=0; j<Block_order; j++)
+    for (i=0; i<Block_order; i++)
+      B(i,j) += Work_in(i,j);
+}
 
 int main(int argc, char ** argv)
 {
@@ -134,9 +261,26 @@ int main(int argc, char ** argv)
   long Colblock_size;      /* size of column block                  */
   int Tile_order=32;       /* default Tile order                    */
   int tiling;              /* boolean: true if tiling is used       */
+  int inplace=0;           /* boolean: true if transposing A itself */
+  char *env;               /* value of PRK_TRANSPOSE                */
+  double t;                /* swap temporary                        */
   int Num_procs;           /* number of ranks                       */
   long order;              /* order of overall matrix               */
   int send_to, recv_from;  /* ranks with which to communicate       */
+  int partner;             /* rank owning the mirror image block    */
+  int exchange=EXCHANGE_PHASED; /* how blocks are exchanged         */
+  int pipeline_depth=4;    /* phases in flight, if pipelined        */
+  int nbuf;                /* number of blocks per work buffer      */
+  int slot;                /* work buffer block of a phase          */
+  int *counts, *displs;    /* MPI_Alltoallv message layout          */
+  MPI_Request *pipe_req;   /* receives and sends, if pipelined      */
+  int layout2d=0;          /* boolean: true if distributed 2D       */
+  int grid_order=1;        /* ranks per side of the 2D rank grid    */
+  int my_row, my_col;      /* grid coordinates of rank, if 2D       */
+  int rowstart=0;          /* starting row for owning rank          */
+  int nbatch=1;            /* number of matrices per iteration      */
+  int mat;                 /* index of matrix within batch          */
+  int nreq;                /* number of requests per matrix, batch  */
 #if !SYNCHRONOUS
   MPI_Request send_req;
   MPI_Request recv_req;
@@ -145,6 +289,7 @@ int main(int argc, char ** argv)
   int my_ID;               /* rank                                  */
   int root=0;              /* rank of root                          */
   int iterations;          /* number of times to do the transpose   */
+  prk_harness_t harness;   /* per-iteration timing                  */
   int i, j, it, jt, istart;/* dummies                               */
   int iter;                /* index of iteration                    */
   int phase;               /* phase inside staged communication     */
@@ -164,7 +309,7 @@ int main(int argc, char ** argv)
 /*********************************************************************
 ** Initialize the MPI environment
 *********************************************************************/
-  MPI_Init(&argc,&argv);
+  prk_progress_init(&argc,&argv);
   MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
   MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
 
@@ -188,13 +333,37 @@ int main(int argc, char ** argv)
       error = 1; goto ENDOFTESTS;
     }
 
+    env = getenv("PRK_DISTRIBUTION");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"2d")) layout2d = 1;
+      else if (strcmp(env,"column")) {
+        printf("ERROR: PRK_DISTRIBUTION must be column or 2d: %s\n", env);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+    if (layout2d) {
+      grid_order = (int) (sqrt((double) Num_procs)+0.5);
+      if (grid_order*grid_order != Num_procs) {
+        printf("ERROR: # procs %d should be a perfect square for the 2D distribution\n",
+               Num_procs);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+
     order = atol(*++argv);
-    if (order < Num_procs) {
+    if (order < Num_procs && !layout2d) {
       printf("ERROR: matrix order %ld should at least # procs %d\n",
              order, Num_procs);
       error = 1; goto ENDOFTESTS;
     }
-    if (order%Num_procs) {
+    if (layout2d) {
+      if (order%grid_order) {
+        printf("ERROR: matrix order %ld should be divisible by # procs per side %d\n",
+               order, grid_order);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+    else if (order%Num_procs) {
       printf("ERROR: matrix order %ld should be divisible by # procs %d\n",
              order, Num_procs);
       error = 1; goto ENDOFTESTS;
@@ -202,6 +371,53 @@ int main(int argc, char ** argv)
 
     if (argc == 4) Tile_order = atoi(*++argv);
 
+    env = getenv("PRK_TRANSPOSE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"inplace")) inplace = 1;
+      else if (strcmp(env,"tiled")) {
+        printf("ERROR: PRK_TRANSPOSE must be tiled or inplace: %s\n", env);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+
+    env = getenv("PRK_EXCHANGE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"alltoall"))  exchange = EXCHANGE_ALLTOALL;
+      else if (!strcmp(env,"pipelined")) exchange = EXCHANGE_PIPELINED;
+      else if (strcmp(env,"phased")) {
+        printf("ERROR: PRK_EXCHANGE must be phased, alltoall or pipelined: %s\n", env);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+    if (inplace && exchange != EXCHANGE_PHASED) {
+      printf("ERROR: the in-place transpose only supports the phased exchange\n");
+      error = 1; goto ENDOFTESTS;
+    }
+    if (layout2d && (inplace || exchange != EXCHANGE_PHASED)) {
+      printf("ERROR: the 2D distribution only supports the tiled transpose\n");
+      error = 1; goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_BATCH");
+    if (env != NULL) nbatch = atoi(env);
+    if (nbatch < 1) {
+      printf("ERROR: PRK_BATCH must be positive: %s\n", env);
+      error = 1; goto ENDOFTESTS;
+    }
+    if (nbatch > 1 && (inplace || layout2d || exchange != EXCHANGE_PHASED)) {
+      printf("ERROR: batches of matrices only support the tiled, phased transpose\n");
+      error = 1; goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_PIPELINE_DEPTH");
+    if (env != NULL) pipeline_depth = atoi(env);
+    if (pipeline_depth < 1) {
+      printf("ERROR: PRK_PIPELINE_DEPTH must be positive: %s\n", env);
+      error = 1; goto ENDOFTESTS;
+    }
+    /* there are only Num_procs-1 phases to keep in flight               */
+    pipeline_depth = MAX(1,MIN(pipeline_depth, Num_procs-1));
+
     ENDOFTESTS:;
   }
   bail_out(error);
@@ -213,20 +429,43 @@ int main(int argc, char ** argv)
     if ((Tile_order > 0) && (Tile_order < order))
           printf("Tile size            = %d\n", Tile_order);
     else  printf("Untiled\n");
+    if (inplace)
+          printf("In-place transpose   = on\n");
+    if (layout2d)
+          printf("Distribution         = 2D, %d x %d ranks\n", grid_order, grid_order);
+    if (nbatch > 1)
+          printf("Matrices per batch   = %d, pipelined\n", nbatch);
+    if (exchange == EXCHANGE_ALLTOALL)
+          printf("Exchange             = MPI_Alltoallv\n");
+    else if (exchange == EXCHANGE_PIPELINED)
+          printf("Exchange             = pipelined, %d phases in flight\n",
+                 pipeline_depth);
+    else if (nbatch > 1)
+          printf("Non-Blocking messages\n");
+    else {
 #if !SYNCHRONOUS
-    printf("Non-");
+      printf("Non-");
 #endif
-    printf("Blocking messages\n");
+      printf("Blocking messages\n");
+    }
+    printf("Progress thread      = %s\n", prk_progress_mode());
   }
 
   /*  Broadcast input data to all ranks */
   MPI_Bcast (&order,      1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast (&iterations, 1, MPI_INT,  root, MPI_COMM_WORLD);
   MPI_Bcast (&Tile_order, 1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast (&inplace,    1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast (&exchange,   1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast (&pipeline_depth, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast (&layout2d,   1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast (&grid_order, 1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast (&nbatch,     1, MPI_INT,  root, MPI_COMM_WORLD);
+  prk_topology_bind();
 
   /* a non-positive tile size means no tiling of the local transpose */
   tiling = (Tile_order > 0) && (Tile_order < order);
-  bytes = 2 * sizeof(double) * order * order;
+  bytes = 2 * sizeof(double) * order * order * nbatch;
 
 /*********************************************************************
 ** The matrix is broken up into column blocks that are mapped one to a
@@ -239,67 +478,319 @@ int main(int argc, char ** argv)
   Colblock_size  = order * Block_order;
   Block_size     = Block_order * Block_order;
 
+  /* with the 2D distribution a rank owns a single block, and its
+     partner owns the mirror image block                                 */
+  if (layout2d) {
+    my_row         = my_ID%grid_order;
+    my_col         = my_ID/grid_order;
+    Block_order    = order/grid_order;
+    rowstart       = Block_order * my_row;
+    colstart       = Block_order * my_col;
+    Block_size     = Block_order * Block_order;
+    Colblock_size  = Block_size;
+    partner        = my_col + grid_order*my_row;
+  }
+
 /*********************************************************************
 ** Create the column block of the test matrix, the row block of the
 ** transposed matrix, and workspace (workspace only if #procs>1)
 *********************************************************************/
-  A_p = (double *)prk_malloc(Colblock_size*sizeof(double));
+  /* the column blocks of a batch of matrices are stored one after the
+     other, as if they were additional columns                          */
+  A_p = (double *)prk_malloc(nbatch*Colblock_size*sizeof(double));
   if (A_p == NULL){
     printf(" Error allocating space for original matrix on node %d\n",my_ID);
     error = 1;
   }
   bail_out(error);
 
-  B_p = (double *)prk_malloc(Colblock_size*sizeof(double));
-  if (B_p == NULL){
+  /* the in-place transpose needs no transposed matrix                 */
+  B_p = inplace ? NULL : (double *)prk_malloc(nbatch*Colblock_size*sizeof(double));
+  if (B_p == NULL && !inplace){
     printf(" Error allocating space for transpose matrix on node %d\n",my_ID);
     error = 1;
   }
   bail_out(error);
 
+  /* the phased exchange needs one block per direction, the all-to-all
+     exchange all blocks, the pipelined one a block per phase in flight,
+     and a batch all blocks of the two matrices in flight               */
+  nbuf = exchange == EXCHANGE_ALLTOALL  ? Num_procs :
+         exchange == EXCHANGE_PIPELINED ? pipeline_depth : 
+         nbatch > 1                     ? 2*Num_procs : 1;
   if (Num_procs>1) {
-    Work_in_p   = (double *)prk_malloc(2*Block_size*sizeof(double));
+    Work_in_p   = (double *)prk_malloc(2*nbuf*Block_size*sizeof(double));
     if (Work_in_p == NULL){
       printf(" Error allocating space for work on node %d\n",my_ID);
       error = 1;
     }
     bail_out(error);
-    Work_out_p = Work_in_p + Block_size;
+    Work_out_p = Work_in_p + nbuf*Block_size;
+  }
+
+  if (exchange == EXCHANGE_ALLTOALL) {
+    /* uniform blocks, except that a rank sends nothing to itself        */
+    counts = (int *)prk_malloc(2*Num_procs*sizeof(int));
+    if (counts == NULL){
+      printf(" Error allocating space for message layout on node %d\n",my_ID);
+      error = 1;
+    }
+    bail_out(error);
+    displs = counts + Num_procs;
+    for (partner=0; partner<Num_procs; partner++) {
+      counts[partner] = partner == my_ID ? 0 : Block_size;
+      displs[partner] = partner*Block_size;
+    }
+  }
+  nreq = 2*(Num_procs-1);
+  if (exchange == EXCHANGE_PIPELINED || nbatch > 1) {
+    /* one spare request keeps the allocation nonempty on a single rank */
+    pipe_req = (MPI_Request *)prk_malloc((nbatch > 1 ? 2*nreq+1 : 2*pipeline_depth)*
+                                         sizeof(MPI_Request));
+    if (pipe_req == NULL){
+      printf(" Error allocating space for requests on node %d\n",my_ID);
+      error = 1;
+    }
+    bail_out(error);
   }
 
   /* Fill the original column matrix                                                */
   istart = 0;
-  for (j=0;j<Block_order;j++)
+  if (layout2d) for (j=0;j<Block_order;j++)
+    for (i=0;i<Block_order; i++)  {
+      A2(i,j) = (double) (order*(j+colstart) + i+rowstart);
+      B2(i,j) = 0.0;
+  }
+  else for (j=0;j<nbatch*Block_order;j++)
     for (i=0;i<order; i++)  {
-      A(i,j) = (double) (order*(j+colstart) + i);
-      B(i,j) = 0.0;
+      A(i,j) = (double) (order*(j%Block_order+colstart) + i);
+      if (!inplace) B(i,j) = 0.0;
   }
 
+  prk_harness_init(&harness, "Transpose", "MPI1", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "order", "%ld", order);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? Tile_order : 0);
+  prk_harness_param(&harness, "algorithm", "%s", inplace ? "inplace" : "tiled");
+  prk_harness_param(&harness, "distribution", "%s", layout2d ? "2d" : "column");
+  prk_harness_param(&harness, "batch", "%d", nbatch);
+  prk_harness_param(&harness, "exchange", "%s",
+                    exchange == EXCHANGE_ALLTOALL  ? "alltoall"  :
+                    exchange == EXCHANGE_PIPELINED ? "pipelined" : "phased");
+  if (exchange == EXCHANGE_PIPELINED)
+    prk_harness_param(&harness, "pipeline_depth", "%d", pipeline_depth);
+  prk_harness_param(&harness, "progress", "%s", prk_progress_mode());
+
   for (iter = 0; iter<=iterations; iter++){
 
-    /* start timer after a warmup iteration                                        */
-    if (iter == 1) {
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_trans_time = wtime();
+    /* time every iteration after a warmup iteration                               */
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
+
+    if (layout2d) {
+      if (partner == my_ID) {
+        /* the block on the diagonal of the rank grid is its own partner */
+        if (!tiling) {
+          for (i=0; i<Block_order; i++)
+            for (j=0; j<Block_order; j++) {
+              B2(j,i) += A2(i,j);
+              A2(i,j) += 1.0;
+            }
+        }
+        else {
+          for (i=0; i<Block_order; i+=Tile_order)
+            for (j=0; j<Block_order; j+=Tile_order)
+              for (it=i; it<MIN(Block_order,i+Tile_order); it++)
+                for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
+                  B2(jt,it) += A2(it,jt);
+                  A2(it,jt) += 1.0;
+                }
+        }
+        continue;
+      }
+
+#if !SYNCHRONOUS
+      MPI_Irecv(Work_in_p, Block_size, MPI_DOUBLE,
+                partner, iter, MPI_COMM_WORLD, &recv_req);
+#endif
+
+      /* a block is a column block of order Block_order                 */
+      pack_block(Block_order, Block_order, 0, Tile_order, tiling, A_p, Work_out_p);
+
+#if !SYNCHRONOUS
+      MPI_Isend(Work_out_p, Block_size, MPI_DOUBLE, partner,
+                iter, MPI_COMM_WORLD, &send_req);
+      MPI_Wait(&recv_req, MPI_STATUS_IGNORE);
+      MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+#else
+      MPI_Sendrecv(Work_out_p, Block_size, MPI_DOUBLE, partner, iter,
+                   Work_in_p, Block_size, MPI_DOUBLE,
+                   partner, iter, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+#endif
+
+      scatter_block(Block_order, Block_order, 0, B_p, Work_in_p);
+      continue;
+    }
+
+    if (inplace) {
+      /* every block is a partner of exactly one phase; a block is sent
+         before the one received from its partner overwrites it          */
+      for (phase=0; phase<Num_procs; phase++){
+        partner = (phase - my_ID + Num_procs)%Num_procs;
+        istart  = partner*Block_order;
+
+        if (partner == my_ID) {
+          /* swap tile pairs of the diagonal block; untiled, the block
+             is a single tile                                            */
+          int tile = tiling ? Tile_order : Block_order;
+          for (i=0; i<Block_order; i+=tile)
+            for (j=i; j<Block_order; j+=tile)
+              for (it=i; it<MIN(Block_order,i+tile); it++) {
+                jt = j;
+                if (i == j) {
+                  A(it,it) += 1.0;
+                  jt = it+1;
+                }
+                for (; jt<MIN(Block_order,j+tile); jt++) {
+                  t        = A(it,jt);
+                  A(it,jt) = A(jt,it) + 1.0;
+                  A(jt,it) = t + 1.0;
+                }
+              }
+          continue;
+        }
+
+#if !SYNCHRONOUS
+        MPI_Irecv(Work_in_p, Block_size, MPI_DOUBLE,
+                  partner, phase, MPI_COMM_WORLD, &recv_req);
+#endif
+
+        if (!tiling) {
+          for (i=0; i<Block_order; i++)
+            for (j=0; j<Block_order; j++)
+              Work_out(j,i) = A(i,j);
+        }
+        else {
+          for (i=0; i<Block_order; i+=Tile_order)
+            for (j=0; j<Block_order; j+=Tile_order)
+              for (it=i; it<MIN(Block_order,i+Tile_order); it++)
+                for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++)
+                  Work_out(jt,it) = A(it,jt);
+        }
+
+#if !SYNCHRONOUS
+        MPI_Isend(Work_out_p, Block_size, MPI_DOUBLE, partner,
+                  phase, MPI_COMM_WORLD, &send_req);
+        MPI_Wait(&recv_req, MPI_STATUS_IGNORE);
+        MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+#else
+        MPI_Sendrecv(Work_out_p, Block_size, MPI_DOUBLE, partner, phase,
+                     Work_in_p, Block_size, MPI_DOUBLE,
+                     partner, phase, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+#endif
+
+        /* overwrite the block that was just sent; no need to tile      */
+        for (j=0; j<Block_order; j++)
+          for (i=0; i<Block_order; i++)
+            A(i,j) = Work_in(i,j) + 1.0;
+      }
+      continue;
+    }
+
+    if (nbatch > 1) {
+      /* step mat posts the messages of matrix mat, then finishes matrix
+         mat-1, whose messages have been travelling meanwhile; the two
+         matrices in flight use alternate halves of the work buffers,
+         which hold a block per rank, and of the requests                */
+      for (mat=0; mat<=nbatch; mat++) {
+        if (mat < nbatch) {
+          slot = mat%2;
+          for (phase=1; phase<Num_procs; phase++){
+            recv_from = (my_ID + phase            )%Num_procs;
+            send_to   = (my_ID - phase + Num_procs)%Num_procs;
+            MPI_Irecv(Work_in_p+(slot*Num_procs+recv_from)*Block_size, Block_size,
+                      MPI_DOUBLE, recv_from, mat, MPI_COMM_WORLD,
+                      &pipe_req[slot*nreq+2*(phase-1)]);
+            pack_block(order, Block_order, send_to*Block_order, Tile_order, tiling,
+                       A_p+mat*Colblock_size,
+                       Work_out_p+(slot*Num_procs+send_to)*Block_size);
+            MPI_Isend(Work_out_p+(slot*Num_procs+send_to)*Block_size, Block_size,
+                      MPI_DOUBLE, send_to, mat, MPI_COMM_WORLD,
+                      &pipe_req[slot*nreq+2*(phase-1)+1]);
+          }
+        }
+        if (mat > 0) {
+          slot = (mat-1)%2;
+          transpose_local(order, Block_order, colstart, Tile_order, tiling,
+                          A_p+(mat-1)*Colblock_size, B_p+(mat-1)*Colblock_size);
+          MPI_Waitall(nreq, &pipe_req[slot*nreq], MPI_STATUSES_IGNORE);
+          for (phase=1; phase<Num_procs; phase++){
+            recv_from = (my_ID + phase)%Num_procs;
+            scatter_block(order, Block_order, recv_from*Block_order,
+                          B_p+(mat-1)*Colblock_size,
+                          Work_in_p+(slot*Num_procs+recv_from)*Block_size);
+          }
+        }
+      }
+      continue;
+    }
+
+    /* start the first phases of a pipelined exchange, so that their
+       messages travel during the local transpose                       */
+    if (exchange == EXCHANGE_PIPELINED) {
+      for (phase=1; phase<=pipeline_depth && phase<Num_procs; phase++) {
+        slot      = phase-1;
+        recv_from = (my_ID + phase            )%Num_procs;
+        send_to   = (my_ID - phase + Num_procs)%Num_procs;
+        MPI_Irecv(Work_in_p+slot*Block_size, Block_size, MPI_DOUBLE,
+                  recv_from, phase, MPI_COMM_WORLD, &pipe_req[2*slot]);
+        pack_block(order, Block_order, send_to*Block_order, Tile_order, tiling,
+                   A_p, Work_out_p+slot*Block_size);
+        MPI_Isend(Work_out_p+slot*Block_size, Block_size, MPI_DOUBLE,
+                  send_to, phase, MPI_COMM_WORLD, &pipe_req[2*slot+1]);
+      }
     }
 
     /* do the local transpose                                                     */
-    istart = colstart;
-    if (!tiling) {
-      for (i=0; i<Block_order; i++)
-        for (j=0; j<Block_order; j++) {
-          B(j,i) += A(i,j);
-          A(i,j) += 1.0;
-	}
+    transpose_local(order, Block_order, colstart, Tile_order, tiling, A_p, B_p);
+
+    if (exchange == EXCHANGE_ALLTOALL && Num_procs>1) {
+      /* block p of the send buffer goes to rank p, and block p of the
+         receive buffer comes from it                                    */
+      for (partner=0; partner<Num_procs; partner++) if (partner != my_ID)
+        pack_block(order, Block_order, partner*Block_order, Tile_order, tiling,
+                   A_p, Work_out_p+partner*Block_size);
+      MPI_Alltoallv(Work_out_p, counts, displs, MPI_DOUBLE,
+                    Work_in_p,  counts, displs, MPI_DOUBLE, MPI_COMM_WORLD);
+      for (partner=0; partner<Num_procs; partner++) if (partner != my_ID)
+        scatter_block(order, Block_order, partner*Block_order,
+                      B_p, Work_in_p+partner*Block_size);
+      continue;
     }
-    else {
-      for (i=0; i<Block_order; i+=Tile_order)
-        for (j=0; j<Block_order; j+=Tile_order)
-          for (it=i; it<MIN(Block_order,i+Tile_order); it++)
-            for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
-              B(jt,it) += A(it,jt);
-              A(it,jt) += 1.0;
-	    }
+
+    if (exchange == EXCHANGE_PIPELINED) {
+      /* retire phases in order; a slot is refilled with the phase
+         pipeline_depth further on as soon as both its messages are done */
+      for (phase=1; phase<Num_procs; phase++) {
+        slot      = (phase-1)%pipeline_depth;
+        recv_from = (my_ID + phase)%Num_procs;
+        MPI_Wait(&pipe_req[2*slot], MPI_STATUS_IGNORE);
+        scatter_block(order, Block_order, recv_from*Block_order,
+                      B_p, Work_in_p+slot*Block_size);
+        MPI_Wait(&pipe_req[2*slot+1], MPI_STATUS_IGNORE);
+
+        if (phase+pipeline_depth < Num_procs) {
+          recv_from = (my_ID + phase+pipeline_depth            )%Num_procs;
+          send_to   = (my_ID - phase-pipeline_depth + Num_procs)%Num_procs;
+          MPI_Irecv(Work_in_p+slot*Block_size, Block_size, MPI_DOUBLE,
+                    recv_from, phase+pipeline_depth, MPI_COMM_WORLD, &pipe_req[2*slot]);
+          pack_block(order, Block_order, send_to*Block_order, Tile_order, tiling,
+                     A_p, Work_out_p+slot*Block_size);
+          MPI_Isend(Work_out_p+slot*Block_size, Block_size, MPI_DOUBLE,
+                    send_to, phase+pipeline_depth, MPI_COMM_WORLD, &pipe_req[2*slot+1]);
+        }
+      }
+      continue;
     }
 
     for (phase=1; phase<Num_procs; phase++){
@@ -311,23 +802,8 @@ int main(int argc, char ** argv)
                 recv_from, phase, MPI_COMM_WORLD, &recv_req);
 #endif
 
-      istart = send_to*Block_order;
-      if (!tiling) {
-        for (i=0; i<Block_order; i++)
-          for (j=0; j<Block_order; j++){
-	    Work_out(j,i) = A(i,j);
-            A(i,j) += 1.0;
-	  }
-      }
-      else {
-        for (i=0; i<Block_order; i+=Tile_order)
-          for (j=0; j<Block_order; j+=Tile_order)
-            for (it=i; it<MIN(Block_order,i+Tile_order); it++)
-              for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
-                Work_out(jt,it) = A(it,jt);
-                A(it,jt) += 1.0;
-	      }
-      }
+      pack_block(order, Block_order, send_to*Block_order, Tile_order, tiling,
+                 A_p, Work_out_p);
 
 #if !SYNCHRONOUS
       MPI_Isend(Work_out_p, Block_size, MPI_DOUBLE, send_to,
@@ -340,24 +816,38 @@ int main(int argc, char ** argv)
 	           recv_from, phase, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 #endif
 
-      istart = recv_from*Block_order;
-      /* scatter received block to transposed matrix; no need to tile */
-      for (j=0; j<Block_order; j++)
-        for (i=0; i<Block_order; i++)
-          B(i,j) += Work_in(i,j);
+      /* scatter received block to transposed matrix */
+      scatter_block(order, Block_order, recv_from*Block_order, B_p, Work_in_p);
 
     }  /* end of phase loop  */
   } /* end of iterations */
 
-  local_trans_time = wtime() - local_trans_time;
+  prk_harness_tick(&harness);
+  local_trans_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_trans_time, &trans_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
   abserr = 0.0;
   istart = 0;
   double addit = ((double)(iterations+1) * (double) (iterations))/2.0;
-  for (j=0;j<Block_order;j++) for (i=0;i<order; i++) {
-      abserr += ABS(B(i,j) - (double)((order*i + j+colstart)*(iterations+1)+addit));
+  if (layout2d) {
+    for (j=0;j<Block_order;j++) for (i=0;i<Block_order; i++) {
+      abserr += ABS(B2(i,j) - (double)((order*(i+rowstart) + j+colstart)*(iterations+1)+addit));
+    }
+  }
+  else if (inplace) {
+    /* after an odd number of transposes A holds the transpose of its
+       initial value, after an even number the initial value itself,
+       plus one per transpose                                          */
+    long k = iterations+1L;
+    for (j=0;j<Block_order;j++) for (i=0;i<order; i++) {
+      double ref = (k%2) ? (double)(order*i + j+colstart)
+                         : (double)(order*(j+colstart) + i);
+      abserr += ABS(A(i,j) - (ref + k));
+    }
+  }
+  else for (j=0;j<nbatch*Block_order;j++) for (i=0;i<order; i++) {
+      abserr += ABS(B(i,j) - (double)((order*i + j%Block_order+colstart)*(iterations+1)+addit));
   }
 
   MPI_Reduce(&abserr, &abserr_tot, 1, MPI_DOUBLE, MPI_SUM, root, MPI_COMM_WORLD);
@@ -379,7 +869,14 @@ int main(int argc, char ** argv)
 
   bail_out(error);
 
-  MPI_Finalize();
+  /* B += A^T and A += 1: two reads and two writes per element;
+     A = A^T + 1: one read and one write per element            */
+  if (inplace) prk_harness_model(&harness, 1.0*order*order, bytes);
+  else         prk_harness_model(&harness, 2.0*order*order, 2.0*bytes);
+  prk_harness_report(&harness, "MB/s", 1.0E-06*bytes);
+  prk_harness_finalize(&harness);
+
+  prk_progress_finalize();
   exit(EXIT_SUCCESS);
 
 }  /* end of main */
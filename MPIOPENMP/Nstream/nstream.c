@@ -90,7 +90,9 @@ FUNCTIONS CALLED:
            external functions are used in this program:
  
            wtime()
+           prk_topology_bind()
            bail_out()
+           prk_harness_*()
            checkTRIADresults()
  
 NOTES:     Bandwidth is determined as the number of words read, plus the 
@@ -118,6 +120,8 @@ REVISION:  Modified by Rob Van der Wijngaart, November 2014, replaced
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpiomp.h>
+#include <prk_topology.h>
+#include <prk_harness.h>
  
 #define N   MAXLENGTH
  
@@ -154,6 +158,7 @@ int main(int argc, char **argv)
           my_ID,         /* rank of calling rank                        */
           root=0;        /* ID of master rank                           */
   int     error=0;       /* error flag for individual rank              */
+  prk_harness_t harness; /* per-iteration timing                        */
  
 /**********************************************************************************
 * process and test input parameters    
@@ -220,6 +225,7 @@ int main(int argc, char **argv)
   MPI_Bcast(&nthread_input, 1, MPI_INT,  root, MPI_COMM_WORLD);
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
 
 #if !STATIC_ALLOCATION
   space = (3*length + 2*offset)*sizeof(double);
@@ -254,14 +260,18 @@ int main(int argc, char **argv)
   /* --- MAIN LOOP --- repeat Triad iterations times --- */
  
   scalar = SCALAR;
+
+  prk_harness_init(&harness, "Nstream", "MPIOPENMP", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "threads", "%d", omp_get_max_threads());
+  prk_harness_param(&harness, "length", "%ld", total_length);
+  prk_harness_param(&harness, "offset", "%ld", offset);
  
   for (iter=0; iter<=iterations; iter++) {
  
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_nstream_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     #pragma omp parallel for
     #pragma vector always
@@ -273,7 +283,8 @@ int main(int argc, char **argv)
   ** Analyze and output results.
   *********************************************************************/
 
-  local_nstream_time = wtime() - local_nstream_time;
+  prk_harness_tick(&harness);
+  local_nstream_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_nstream_time, &nstream_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
@@ -286,6 +297,11 @@ int main(int argc, char **argv)
     else error = 1;
   }
   bail_out(error);
+
+  prk_harness_model(&harness, 2.0*length*Num_procs, bytes);
+  prk_harness_report(&harness, "MB/s", 1.0E-06 * bytes);
+  prk_harness_finalize(&harness);
+
   MPI_Finalize();
 }
  
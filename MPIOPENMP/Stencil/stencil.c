@@ -43,6 +43,24 @@ USAGE:   The program takes as input the linear dimension of the grid,
  
                <progname> <#threads><# iterations> <grid size>
   
+         Both the star and the compact stencil are supported; the ghost
+         points in x are exchanged after those in y and include the rows
+         received in y, which supplies the corner values of the compact
+         stencil.
+
+         The master thread performs the halo exchange (MPI_THREAD_FUNNELED).
+         By default the other threads wait for it; with PRK_COMM_THREAD=1
+         they update the points of the tile that do not depend on ghost
+         points in the meantime, and the master joins them when the
+         exchange is done.  All threads then update the boundary strips.
+
+         With PRK_INCREMENT=offset the constant that every iteration adds
+         to IN is kept as an implicit offset of the grid instead of being
+         added by a pass over the tile.  The weights sum to zero, so the
+         stencil of IN plus a constant equals that of IN and the norm is
+         unchanged; the halos are still exchanged as usual.
+         PRK_INCREMENT=sweep (the default) adds it explicitly.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
  
@@ -52,7 +70,9 @@ FUNCTIONS CALLED:
          functions are used in this program:
  
          wtime()
+         prk_topology_bind()
          bail_out()
+         prk_harness_*()
  
 HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, August 2013: Removed unrolling pragmas for clarity;
@@ -65,11 +85,15 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, October 2014: removed barrier at start of each iteration
          - RvdW, October 2014: replaced single rank/single iteration timing
            with global timing of all iterations across all ranks
+         - Added compact stencil and overlap of the halo exchange, driven
+           by the master thread, with the interior update
   
 *********************************************************************************/
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpiomp.h>
+#include <prk_topology.h>
+#include <prk_harness.h>
  
 #if DOUBLE
   #define DTYPE     double
@@ -94,6 +118,31 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
 #define INDEXOUT(i,j) (i+(j)*(width))
 #define OUT(i,j)      out[INDEXOUT(i-istart,j-jstart)]
 #define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+
+/* apply the stencil to the points ilo..ihi of row j of the tile              */
+static void apply_row(DTYPE * RESTRICT in, DTYPE * RESTRICT out, 
+                      DTYPE weight[2*RADIUS+1][2*RADIUS+1], int istart,
+                      int jstart, int width, int ilo, int ihi, int j) {
+  int i, ii, jj;
+  for (i=ilo; i<=ihi; i++) {
+    #if LOOPGEN
+      #if STAR
+        #include "loop_body_star.incl"
+      #else
+        #include "loop_body_compact.incl"
+      #endif
+    #else
+      #if STAR
+        for (jj=-RADIUS; jj<=RADIUS; jj++) OUT(i,j) += WEIGHT(0,jj)*IN(i,j+jj);
+        for (ii=-RADIUS; ii<0; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
+        for (ii=1; ii<=RADIUS; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
+      #else
+        for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
+          OUT(i,j) += WEIGHT(ii,jj)*IN(i+ii,j+jj);
+      #endif
+    #endif
+  }
+}
  
 int main(int argc, char ** argv) {
  
@@ -139,14 +188,31 @@ int main(int argc, char ** argv) {
   DTYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
   MPI_Request request[8];
   MPI_Status  status[8];
+  int    provided;        /* MPI level of thread support                         */
+  int    comm_thread;     /* nonzero if the master thread exchanges halos alone  */
+  char   *env;            /* value of PRK_COMM_THREAD or PRK_INCREMENT           */
+  int    offset;          /* nonzero if the increment of IN is implicit          */
+  prk_harness_t harness;  /* per-iteration timing                                */
+  DTYPE  wsum;            /* sum of the stencil weights                          */
+  int    jlo_x, jhi_x;    /* rows exchanged in x, including ghost rows in y      */
+  int    ilo, ihi, jlo, jhi; /* bounds of updated points of the tile             */
+  int    ilo_int, ihi_int, jlo_int, jhi_int; /* bounds of the tile interior      */
  
   /*******************************************************************************
   ** Initialize the MPI environment
   ********************************************************************************/
-  MPI_Init(&argc,&argv);
+  MPI_Init_thread(&argc,&argv, MPI_THREAD_FUNNELED, &provided);
   MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
   MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
 
+  if (provided < MPI_THREAD_FUNNELED) {
+    if (my_ID==0) printf("ERROR: requested=%s less than provided=%s\n",
+                         PRK_MPI_THREAD_STRING(MPI_THREAD_FUNNELED),
+                         PRK_MPI_THREAD_STRING(provided));
+    error = 1;
+  }
+  bail_out(error);
+
   /*******************************************************************************
   ** process, test, and broadcast input parameters    
   ********************************************************************************/
@@ -154,12 +220,6 @@ int main(int argc, char ** argv) {
   if (my_ID == root) {
     printf("Parallel Research Kernels version %s\n", PRKVERSION);
     printf("MPI+OPENMP stencil execution on 2D grid\n");
-
-#ifndef STAR
-      printf("ERROR: Compact stencil not supported\n");
-      error = 1;
-      goto ENDOFTESTS;
-#endif
     
     if (argc != 4){
       printf("Usage: %s <#threads><#iterations> <array dimension> \n", 
@@ -204,6 +264,17 @@ int main(int argc, char ** argv) {
       goto ENDOFTESTS;  
     }
  
+    env         = getenv("PRK_COMM_THREAD");
+    comm_thread = env && atoi(env) > 0;
+
+    env    = getenv("PRK_INCREMENT");
+    offset = env && !strcmp(env, "offset");
+    if (env && !offset && strcmp(env, "sweep")) {
+      printf("ERROR: PRK_INCREMENT must be sweep or offset: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
     ENDOFTESTS:;  
   }
   bail_out(error);
@@ -229,8 +300,11 @@ int main(int argc, char ** argv) {
   MPI_Bcast(&n,             1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations,    1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&nthread_input, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&comm_thread,   1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&offset,        1, MPI_INT, root, MPI_COMM_WORLD);
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
   
   if (my_ID == root) {
     printf("Number of ranks        = %d\n", Num_procs);
@@ -238,7 +312,11 @@ int main(int argc, char ** argv) {
     printf("Grid size              = %d\n", n);
     printf("Radius of stencil      = %d\n", RADIUS);
     printf("Tiles in x/y-direction = %d/%d\n", Num_procsx, Num_procsy);
+#if STAR
     printf("Type of stencil        = star\n");
+#else
+    printf("Type of stencil        = compact\n");
+#endif
 #if DOUBLE
     printf("Data type              = double precision\n");
 #else
@@ -250,6 +328,9 @@ int main(int argc, char ** argv) {
     printf("Compact representation of stencil loop body\n");
 #endif
     printf("Number of iterations   = %d\n", iterations);
+    printf("Halo exchange          = %s\n", comm_thread ? 
+           "master thread, overlapped with interior update" : "master thread, blocking");
+    printf("Increment of input     = %s\n", offset ? "implicit offset" : "sweep");
   }
 
   /* compute amount of space required for input and solution arrays             */
@@ -319,11 +400,40 @@ int main(int argc, char ** argv) {
   /* fill the stencil weights to reflect a discrete divergence operator         */
   for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
     WEIGHT(ii,jj) = (DTYPE) 0.0;
+#if STAR
   stencil_size = 4*RADIUS+1;
   for (ii=1; ii<=RADIUS; ii++) {
     WEIGHT(0, ii) = WEIGHT( ii,0) =  (DTYPE) (1.0/(2.0*ii*RADIUS));
     WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(DTYPE) (1.0/(2.0*ii*RADIUS));
   }
+#else
+  stencil_size = (2*RADIUS+1)*(2*RADIUS+1);
+  for (jj=1; jj<=RADIUS; jj++) {
+    for (ii=-jj+1; ii<jj; ii++) {
+      WEIGHT(ii,jj)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));
+      WEIGHT(ii,-jj) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));
+      WEIGHT(jj,ii)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));
+      WEIGHT(-jj,ii) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));
+    }
+    WEIGHT(jj,jj)    =  (DTYPE) (1.0/(4.0*jj*RADIUS));
+    WEIGHT(-jj,-jj)  = -(DTYPE) (1.0/(4.0*jj*RADIUS));
+  }
+#endif
+
+  /* IN+c feeds the stencil c*wsum more than IN does, so with weights that
+     sum to zero the increment can be left to an implicit offset            */
+  if (offset) {
+    wsum = (DTYPE) 0.0;
+    for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
+      wsum += WEIGHT(ii,jj);
+    if (ABS(wsum) > EPSILON) {
+      if (my_ID == root)
+        printf("ERROR: PRK_INCREMENT=offset needs weights that sum to zero, not "
+               FSTR"\n", wsum);
+      error = 1;
+    }
+  }
+  bail_out(error);
  
   norm = (DTYPE) 0.0;
   f_active_points = (DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS);
@@ -345,113 +455,154 @@ int main(int argc, char ** argv) {
   bottom_buf_out = top_buf_out + 2*RADIUS*width;
   bottom_buf_in  = top_buf_out + 3*RADIUS*width;
  
-  right_buf_out  = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*RADIUS*height);
+  /* halos in x span the ghost rows in y received from existing neighbors    */
+  jlo_x = my_IDy > 0            ? jstart-RADIUS : jstart;
+  jhi_x = my_IDy < Num_procsy-1 ? jend+RADIUS   : jend;
+  right_buf_out  = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*RADIUS*(jhi_x-jlo_x+1));
   if (!right_buf_out) {
     printf("ERROR: Rank %d could not allocated comm buffers for x-direction\n", my_ID);
     error = 1;
   }
   bail_out(error);
-  right_buf_in   = right_buf_out +   RADIUS*height;
-  left_buf_out   = right_buf_out + 2*RADIUS*height;
-  left_buf_in    = right_buf_out + 3*RADIUS*height;
+  right_buf_in   = right_buf_out +   RADIUS*(jhi_x-jlo_x+1);
+  left_buf_out   = right_buf_out + 2*RADIUS*(jhi_x-jlo_x+1);
+  left_buf_in    = right_buf_out + 3*RADIUS*(jhi_x-jlo_x+1);
+
+  /* points that do not read ghost points form the interior of the tile; the
+     bounds are clamped so that the boundary strips never overlap it, even
+     for tiles narrower than two stencil radii                                 */
+  ilo = MAX(istart,RADIUS); ihi = MIN(n-RADIUS-1,iend);
+  jlo = MAX(jstart,RADIUS); jhi = MIN(n-RADIUS-1,jend);
+  ilo_int = MIN(istart+RADIUS,ihi+1); ihi_int = MAX(iend-RADIUS,ilo_int-1);
+  jlo_int = MIN(jstart+RADIUS,jhi+1); jhi_int = MAX(jend-RADIUS,jlo_int-1);
+
+  /* with a communication thread the master takes whatever interior rows
+     are left when it is done, so those are handed out dynamically           */
+  omp_set_schedule(comm_thread ? omp_sched_dynamic : omp_sched_static, 0);
+
+  prk_harness_init(&harness, "Stencil", "MPIOPENMP", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "grid_size", "%d", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "comm_thread", "%d", comm_thread);
+  prk_harness_param(&harness, "increment", "%s", offset ? "offset" : "sweep");
 
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_stencil_time = wtime();
-    }
- 
-    /* need to fetch ghost point data from neighbors in y-direction                 */
-    if (my_IDy < Num_procsy-1) {
-      MPI_Irecv(top_buf_in, RADIUS*width, MPI_DTYPE, top_nbr, 101,
-                MPI_COMM_WORLD, &(request[1]));
-      for (kk=0,j=jend-RADIUS+1; j<=jend; j++) for (i=istart; i<=iend; i++) {
-          top_buf_out[kk++]= IN(i,j);
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
+ 
+    #pragma omp parallel private(i, j, kk)
+    {
+    #pragma omp master
+    {
+      /* need to fetch ghost point data from neighbors in y-direction                 */
+      if (my_IDy < Num_procsy-1) {
+        MPI_Irecv(top_buf_in, RADIUS*width, MPI_DTYPE, top_nbr, 101,
+                  MPI_COMM_WORLD, &(request[1]));
+        for (kk=0,j=jend-RADIUS+1; j<=jend; j++) for (i=istart; i<=iend; i++) {
+            top_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(top_buf_out, RADIUS*width,MPI_DTYPE, top_nbr, 99, 
+                  MPI_COMM_WORLD, &(request[0]));
       }
-      MPI_Isend(top_buf_out, RADIUS*width,MPI_DTYPE, top_nbr, 99, 
-                MPI_COMM_WORLD, &(request[0]));
-    }
-    if (my_IDy > 0) {
-      MPI_Irecv(bottom_buf_in,RADIUS*width, MPI_DTYPE, bottom_nbr, 99, 
-                MPI_COMM_WORLD, &(request[3]));
-      for (kk=0,j=jstart; j<=jstart+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
-          bottom_buf_out[kk++]= IN(i,j);
+      if (my_IDy > 0) {
+        MPI_Irecv(bottom_buf_in,RADIUS*width, MPI_DTYPE, bottom_nbr, 99, 
+                  MPI_COMM_WORLD, &(request[3]));
+        for (kk=0,j=jstart; j<=jstart+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
+            bottom_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(bottom_buf_out, RADIUS*width,MPI_DTYPE, bottom_nbr, 101,
+                  MPI_COMM_WORLD, &(request[2]));
+      }
+      if (my_IDy < Num_procsy-1) {
+        MPI_Wait(&(request[0]), &(status[0]));
+        MPI_Wait(&(request[1]), &(status[1]));
+        for (kk=0,j=jend+1; j<=jend+RADIUS; j++) for (i=istart; i<=iend; i++) {
+            IN(i,j) = top_buf_in[kk++];
+        }      
+      }
+      if (my_IDy > 0) {
+        MPI_Wait(&(request[2]), &(status[2]));
+        MPI_Wait(&(request[3]), &(status[3]));
+        for (kk=0,j=jstart-RADIUS; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
+            IN(i,j) = bottom_buf_in[kk++];
+        }      
       }
-      MPI_Isend(bottom_buf_out, RADIUS*width,MPI_DTYPE, bottom_nbr, 101,
-                MPI_COMM_WORLD, &(request[2]));
-    }
-    if (my_IDy < Num_procsy-1) {
-      MPI_Wait(&(request[0]), &(status[0]));
-      MPI_Wait(&(request[1]), &(status[1]));
-      for (kk=0,j=jend+1; j<=jend+RADIUS; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = top_buf_in[kk++];
-      }      
-    }
-    if (my_IDy > 0) {
-      MPI_Wait(&(request[2]), &(status[2]));
-      MPI_Wait(&(request[3]), &(status[3]));
-      for (kk=0,j=jstart-RADIUS; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = bottom_buf_in[kk++];
-      }      
-    }
 
-    /* need to fetch ghost point data from neighbors in x-direction                 */
-    if (my_IDx < Num_procsx-1) {
-      MPI_Irecv(right_buf_in, RADIUS*height, MPI_DTYPE, right_nbr, 1010,
-                MPI_COMM_WORLD, &(request[1+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=iend-RADIUS+1; i<=iend; i++) {
-          right_buf_out[kk++]= IN(i,j);
+      /* need to fetch ghost point data from neighbors in x-direction                 */
+      if (my_IDx < Num_procsx-1) {
+        MPI_Irecv(right_buf_in, RADIUS*(jhi_x-jlo_x+1), MPI_DTYPE, right_nbr, 1010,
+                  MPI_COMM_WORLD, &(request[1+4]));
+        for (kk=0,j=jlo_x; j<=jhi_x; j++) for (i=iend-RADIUS+1; i<=iend; i++) {
+            right_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(right_buf_out, RADIUS*(jhi_x-jlo_x+1), MPI_DTYPE, right_nbr, 990, 
+                MPI_COMM_WORLD, &(request[0+4]));
       }
-      MPI_Isend(right_buf_out, RADIUS*height, MPI_DTYPE, right_nbr, 990, 
-              MPI_COMM_WORLD, &(request[0+4]));
-    }
-    if (my_IDx > 0) {
-      MPI_Irecv(left_buf_in, RADIUS*height, MPI_DTYPE, left_nbr, 990, 
-                MPI_COMM_WORLD, &(request[3+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=istart; i<=istart+RADIUS-1; i++) {
-          left_buf_out[kk++]= IN(i,j);
+      if (my_IDx > 0) {
+        MPI_Irecv(left_buf_in, RADIUS*(jhi_x-jlo_x+1), MPI_DTYPE, left_nbr, 990, 
+                  MPI_COMM_WORLD, &(request[3+4]));
+        for (kk=0,j=jlo_x; j<=jhi_x; j++) for (i=istart; i<=istart+RADIUS-1; i++) {
+            left_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(left_buf_out, RADIUS*(jhi_x-jlo_x+1), MPI_DTYPE, left_nbr, 1010,
+                  MPI_COMM_WORLD, &(request[2+4]));
       }
-      MPI_Isend(left_buf_out, RADIUS*height, MPI_DTYPE, left_nbr, 1010,
-                MPI_COMM_WORLD, &(request[2+4]));
-    }
-    if (my_IDx < Num_procsx-1) {
-      MPI_Wait(&(request[0+4]), &(status[0+4]));
-      MPI_Wait(&(request[1+4]), &(status[1+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=iend+1; i<=iend+RADIUS; i++) {
-          IN(i,j) = right_buf_in[kk++];
-      }      
+      if (my_IDx < Num_procsx-1) {
+        MPI_Wait(&(request[0+4]), &(status[0+4]));
+        MPI_Wait(&(request[1+4]), &(status[1+4]));
+        for (kk=0,j=jlo_x; j<=jhi_x; j++) for (i=iend+1; i<=iend+RADIUS; i++) {
+            IN(i,j) = right_buf_in[kk++];
+        }      
+      }
+      if (my_IDx > 0) {
+        MPI_Wait(&(request[2+4]), &(status[2+4]));
+        MPI_Wait(&(request[3+4]), &(status[3+4]));
+        for (kk=0,j=jlo_x; j<=jhi_x; j++) for (i=istart-RADIUS; i<=istart-1; i++) {
+            IN(i,j) = left_buf_in[kk++];
+        }      
+      }
+    } /* end of master */
+
+    /* unless the master is a communication thread, wait for the halos      */
+    if (!comm_thread) {
+      #pragma omp barrier
     }
-    if (my_IDx > 0) {
-      MPI_Wait(&(request[2+4]), &(status[2+4]));
-      MPI_Wait(&(request[3+4]), &(status[3+4]));
-      for (kk=0,j=jstart; j<=jend; j++) for (i=istart-RADIUS; i<=istart-1; i++) {
-          IN(i,j) = left_buf_in[kk++];
-      }      
+
+    /* Apply the stencil operator to the interior while the master exchanges */
+    #pragma omp for schedule(runtime) nowait
+    for (j=jlo_int; j<=jhi_int; j++) {
+      apply_row(in, out, weight, istart, jstart, width, ilo_int, ihi_int, j);
     }
 
-    /* Apply the stencil operator */
-    #pragma omp parallel for  private (i, j, ii, jj) 
-    for (j=MAX(jstart,RADIUS); j<=MIN(n-RADIUS-1,jend); j++) {
-      for (i=MAX(istart,RADIUS); i<=MIN(n-RADIUS-1,iend); i++) {
-        #if LOOPGEN
-          #include "loop_body_star.incl"
-        #else
-          for (jj=-RADIUS; jj<=RADIUS; jj++) OUT(i,j) += WEIGHT(0,jj)*IN(i,j+jj);
-          for (ii=-RADIUS; ii<0; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
-          for (ii=1; ii<=RADIUS; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
-        #endif
+    #pragma omp barrier
+
+    /* Apply the stencil operator to the strips that read ghost points */
+    #pragma omp for
+    for (j=jlo; j<=jhi; j++) {
+      if (j<jlo_int || j>jhi_int) {
+        apply_row(in, out, weight, istart, jstart, width, ilo, ihi, j);
+      }
+      else {
+        apply_row(in, out, weight, istart, jstart, width, ilo, ilo_int-1, j);
+        apply_row(in, out, weight, istart, jstart, width, ihi_int+1, ihi, j);
       }
     }
  
-    #pragma omp parallel for private (i)
     /* add constant to solution to force refresh of neighbor data, if any */
-    for (j=jstart; j<=jend; j++) for (i=istart; i<=iend; i++) IN(i,j)+= 1.0;
+    if (!offset) {
+      #pragma omp for
+      for (j=jstart; j<=jend; j++) for (i=istart; i<=iend; i++) IN(i,j)+= 1.0;
+    }
+    } /* end of OPENMP parallel region */
  
   }
  
-  local_stencil_time = wtime() - local_stencil_time;
+  prk_harness_tick(&harness);
+  local_stencil_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_stencil_time, &stencil_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
@@ -494,14 +645,18 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
   if (my_ID == root) {
-    /* flops/stencil: 2 flops (fma) for each point in the stencil, 
-       plus one flop for the update of the input of the array        */
-    flops = (DTYPE) (2*stencil_size+1) * f_active_points;
     avgtime = stencil_time/iterations;
     printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
            1.0E-06 * flops/avgtime, avgtime);
   }
+
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
  
   MPI_Finalize();
   exit(EXIT_SUCCESS);
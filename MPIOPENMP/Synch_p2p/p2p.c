@@ -53,7 +53,9 @@ FUNCTIONS CALLED:
          functions are used in this program:
  
          wtime()
+         prk_topology_bind()
          bail_out()
+         prk_harness_*()
  
 HISTORY: - Written by Rob Van der Wijngaart, March 2006.
          - modified by Rob Van der Wijngaart, August 2006:
@@ -66,6 +68,8 @@ HISTORY: - Written by Rob Van der Wijngaart, March 2006.
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpiomp.h>
+#include <prk_topology.h>
+#include <prk_harness.h>
  
 /* define shorthand for flag with cache line padding                             */ 
 #define LINEWORDS  16 
@@ -99,6 +103,7 @@ int main(int argc, char ** argv)
   MPI_Status status;    /* completion status of message                          */
   int    provided;      /* MPI level of thread support                           */
   int    true, false;   /* toggled booleans used for synchronization             */
+  prk_harness_t harness;/* per-iteration timing, by thread 0                    */
  
 /*********************************************************************************
 ** Initialize the MPI environment
@@ -176,6 +181,7 @@ int main(int argc, char ** argv)
   MPI_Bcast(&nthread,    1, MPI_INT, root, MPI_COMM_WORLD);
  
   omp_set_num_threads(nthread);
+  prk_topology_bind();
  
   if (my_ID == root) {
     printf("Number of ranks                = %i\n",Num_procs);
@@ -238,6 +244,12 @@ int main(int argc, char ** argv)
     exit(EXIT_FAILURE);
   }  
  
+  prk_harness_init(&harness, "Synch_p2p", "MPIOPENMP", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "threads", "%d", nthread);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
+
 #pragma omp parallel private(i, j, iter, true, false)
   {
   int TID = omp_get_thread_num();
@@ -291,9 +303,9 @@ int main(int argc, char ** argv)
       if (TID==0) {
         /* No critical required here because only called from master thread */
         MPI_Barrier(MPI_COMM_WORLD);
-        local_pipeline_time = wtime();
       }
     }
+    if (iter >= 1 && TID==0) prk_harness_tick(&harness);
 
     if ((Num_procs==1) && (TID==0)) { /* first thread waits for corner value       */
       while (flag(0,0) == true) {
@@ -377,7 +389,8 @@ int main(int argc, char ** argv)
   } /* end of iterations */
   } /* end of parallel section */
  
-  local_pipeline_time = wtime() - local_pipeline_time;
+  prk_harness_tick(&harness);
+  local_pipeline_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_pipeline_time, &pipeline_time, 1, MPI_DOUBLE, MPI_MAX, final,
              MPI_COMM_WORLD);
  
@@ -408,6 +421,9 @@ int main(int argc, char ** argv)
     printf("Rate (MFlops/s): %lf Avg time (s): %lf\n",
            1.0E-06 * 2 * ((double)((m-1)*(n-1)))/avgtime, avgtime);
   }
+
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * ((double)((m-1)*(n-1))));
+  prk_harness_finalize(&harness);
  
   MPI_Finalize();
   exit(EXIT_SUCCESS);
@@ -45,6 +45,22 @@ USAGE:   Program inputs are the matrix order, the number of times to
 
          An optional parameter specifies the tile size used to divide the 
          individual matrix blocks for improved cache and TLB performance. 
+
+         PRK_EXCHANGE selects how the blocks are exchanged between ranks:
+           funneled  the default; the phases follow one another, the
+                     threads share the packing and unpacking of each
+                     block, and the master thread does the communication
+           multiple  MPI is initialized with MPI_THREAD_MULTIPLE and
+                     every thread packs, sends, receives and unpacks its
+                     own subset of the phases, concurrently with the
+                     other threads
+           comms     as multiple, but every thread communicates on its
+                     own duplicate of MPI_COMM_WORLD, which lets MPI
+                     libraries that map communicators to separate network
+                     contexts inject from the threads without sharing one
+         Comparing them shows whether the multithreaded injection rate
+         of the MPI library pays for the loss of parallelism in packing
+         when ranks have many threads.
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -55,7 +71,10 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
           wtime()           Portable wall-timer interface.
+          prk_topology_bind() Optional pinning of threads and ranks.
           bail_out()        Determine global error and exit if nonzero.
+          prk_harness_*()   Per-iteration timing and results record.
+          exchange_mode()   Parse PRK_EXCHANGE.
 
 HISTORY: Written by Tim Mattson, April 1999.  
          Updated by Rob Van der Wijngaart, December 2005.
@@ -121,12 +140,31 @@ o The original and transposed matrices are called A and B
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpiomp.h>
+#include <prk_topology.h>
+#include <prk_harness.h>
 
 #define A(i,j)        A_p[(i+istart)+order*(j)]
 #define B(i,j)        B_p[(i+istart)+order*(j)]
 #define Work_in(i,j)  Work_in_p[i+Block_order*(j)]
 #define Work_out(i,j) Work_out_p[i+Block_order*(j)]
 
+/* modes of exchange of the blocks between ranks                        */
+#define EXCHANGE_FUNNELED 0
+#define EXCHANGE_MULTIPLE 1
+#define EXCHANGE_COMMS    2
+#define EXCHANGE_UNKNOWN  3
+
+static const char *exchange_name[] = {"funneled", "multiple", "comms"};
+
+/* mode selected by PRK_EXCHANGE, EXCHANGE_UNKNOWN if it is not valid   */
+static int exchange_mode(void) {
+  char *env = getenv("PRK_EXCHANGE");
+  if (env == NULL || *env == '\0' || !strcmp(env,"funneled")) return EXCHANGE_FUNNELED;
+  if (!strcmp(env,"multiple")) return EXCHANGE_MULTIPLE;
+  if (!strcmp(env,"comms"))    return EXCHANGE_COMMS;
+  return EXCHANGE_UNKNOWN;
+}
+
 int main(int argc, char ** argv)
 {
   int Block_order;         /* number of columns owned by rank       */
@@ -158,17 +196,26 @@ int main(int argc, char ** argv)
   double *B_p;             /* transposed matrix column block        */
   double *Work_in_p;       /* workspace for the transpose function  */
   double *Work_out_p;      /* workspace for the transpose function  */
+  double *Work_p;          /* workspace of all threads (multiple)   */
+  int exchange;            /* mode of exchange between ranks        */
+  int requested, provided; /* MPI level of thread support           */
+  MPI_Comm *thread_comm;   /* communicator of each thread (comms)   */
   double abserr,           /* absolute error                        */
          abserr_tot;       /* aggregate absolute error              */
   double epsilon = 1.e-8;  /* error tolerance                       */
   double local_trans_time, /* timing parameters                     */
          trans_time,
          avgtime;
+  prk_harness_t harness;   /* per-iteration timing                  */
 
 /*********************************************************************
 ** Initialize the MPI environment
 *********************************************************************/
-  MPI_Init(&argc,&argv);
+  /* the mode of exchange decides the thread support to request, so every
+     rank reads it before initializing MPI                                */
+  exchange  = exchange_mode();
+  requested = (exchange == EXCHANGE_FUNNELED) ? MPI_THREAD_FUNNELED : MPI_THREAD_MULTIPLE;
+  MPI_Init_thread(&argc,&argv, requested, &provided);
   MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
   MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
 
@@ -214,6 +261,18 @@ int main(int argc, char ** argv)
 
     if (argc == 5) Tile_order = atoi(*++argv);
 
+    if (exchange == EXCHANGE_UNKNOWN) {
+      printf("ERROR: PRK_EXCHANGE must be funneled, multiple or comms: %s\n",
+             getenv("PRK_EXCHANGE"));
+      error = 1; goto ENDOFTESTS;
+    }
+
+    if (provided < requested) {
+      printf("ERROR: requested %s but MPI provides %s\n",
+             PRK_MPI_THREAD_STRING(requested), PRK_MPI_THREAD_STRING(provided));
+      error = 1; goto ENDOFTESTS;
+    }
+
     ENDOFTESTS:;
   }
   bail_out(error);
@@ -224,6 +283,8 @@ int main(int argc, char ** argv)
   MPI_Bcast(&nthread_input, 1, MPI_INT, root, MPI_COMM_WORLD);
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
+  nthread = omp_get_max_threads();
 
 /*********************************************************************
 ** The matrix is broken up into column blocks that are mapped one to a 
@@ -261,6 +322,7 @@ int main(int argc, char ** argv)
     printf("Non-");
 #endif
     printf("Blocking messages\n");
+    printf("Exchange             = %s\n", exchange_name[exchange]);
   }
 
   bytes = 2.0 * sizeof(double) * order * order;
@@ -283,15 +345,28 @@ int main(int argc, char ** argv)
   }
   bail_out(error);
 
+  /* in the multithreaded exchange every thread has its own workspace       */
   if (Num_procs>1) {
-    Work_in_p   = (double *)prk_malloc(2*Block_size*sizeof(double));
-    if (Work_in_p == NULL){
+    Work_p = (double *)prk_malloc(2*Block_size*sizeof(double)*
+                                  (exchange == EXCHANGE_FUNNELED ? 1 : nthread));
+    if (Work_p == NULL){
       printf(" Error allocating space for work on node %d\n",my_ID);
       error = 1;
     }
     bail_out(error);
+    Work_in_p  = Work_p;
     Work_out_p = Work_in_p + Block_size;
   }
+
+  if (exchange == EXCHANGE_COMMS) {
+    thread_comm = (MPI_Comm *)prk_malloc(nthread*sizeof(MPI_Comm));
+    if (thread_comm == NULL){
+      printf(" Error allocating space for communicators on node %d\n",my_ID);
+      error = 1;
+    }
+    bail_out(error);
+    for (i=0; i<nthread; i++) MPI_Comm_dup(MPI_COMM_WORLD, &thread_comm[i]);
+  }
   
   /* Fill the original column matrix                                                */
   istart = 0;  
@@ -319,13 +394,18 @@ int main(int argc, char ** argv)
     }
   }
 
+  prk_harness_init(&harness, "Transpose", "MPIOPENMP", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "order", "%d", order);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? Tile_order : 0);
+  prk_harness_param(&harness, "exchange", "%s", exchange_name[exchange]);
+
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration                                        */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_trans_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* do the local transpose                                                       */
     istart = colstart; 
@@ -352,6 +432,7 @@ int main(int argc, char ** argv)
 	    }
     }
 
+    if (exchange == EXCHANGE_FUNNELED)
     for (phase=1; phase<Num_procs; phase++){
       recv_from = (my_ID + phase            )%Num_procs;
       send_to   = (my_ID - phase + Num_procs)%Num_procs;
@@ -405,9 +486,72 @@ int main(int argc, char ** argv)
         }
 
     }  /* end of phase loop  */
+
+    else
+    /* thread t does phases t+1, t+1+nthread, ...; the partner rank assigns
+       each phase to the thread with the same number, so with per-thread
+       communicators both ends of a message use the same one             */
+    #pragma omp parallel private (i,j,it,jt,phase,istart,send_to,recv_from)
+    {
+      int my_thread = omp_get_thread_num();
+      double *Work_in_p  = Work_p + 2*(long)my_thread*Block_size;
+      double *Work_out_p = Work_in_p + Block_size;
+      MPI_Comm comm = (exchange == EXCHANGE_COMMS) ? thread_comm[my_thread]
+                                                   : MPI_COMM_WORLD;
+#if !SYNCHRONOUS
+      MPI_Request thread_req[2];
+#else
+      MPI_Status thread_status;
+#endif
+
+      for (phase=1+my_thread; phase<Num_procs; phase+=nthread){
+        recv_from = (my_ID + phase            )%Num_procs;
+        send_to   = (my_ID - phase + Num_procs)%Num_procs;
+
+#if !SYNCHRONOUS
+        MPI_Irecv(Work_in_p, Block_size, MPI_DOUBLE, 
+                  recv_from, phase, comm, &thread_req[0]);  
+#endif
+
+        istart = send_to*Block_order; 
+        if (!tiling) {
+          for (i=0; i<Block_order; i++) 
+            for (j=0; j<Block_order; j++){
+              Work_out(j,i) = A(i,j);
+              A(i,j) += 1.0;
+            }
+        }
+        else {
+          for (i=0; i<Block_order; i+=Tile_order) 
+            for (j=0; j<Block_order; j+=Tile_order) 
+              for (it=i; it<MIN(Block_order,i+Tile_order); it++)
+                for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
+                  Work_out(jt,it) = A(it,jt); 
+                  A(it,jt) += 1.0;
+                }
+        }
+
+#if !SYNCHRONOUS  
+        MPI_Isend(Work_out_p, Block_size, MPI_DOUBLE, send_to,
+                  phase, comm, &thread_req[1]);
+        MPI_Waitall(2, thread_req, MPI_STATUSES_IGNORE);
+#else
+        MPI_Sendrecv(Work_out_p, Block_size, MPI_DOUBLE, send_to, phase,
+                     Work_in_p, Block_size, MPI_DOUBLE, 
+                     recv_from, phase, comm, &thread_status);
+#endif
+
+        istart = recv_from*Block_order; 
+        for (j=0; j<Block_order; j++)
+          for (i=0; i<Block_order; i++) {
+            B(i,j) += Work_in(i,j);
+          }
+      }
+    }  /* end of multithreaded exchange */
   } /* end of iterations */
 
-  local_trans_time = wtime() - local_trans_time;
+  prk_harness_tick(&harness);
+  local_trans_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_trans_time, &trans_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
@@ -438,6 +582,13 @@ int main(int argc, char ** argv)
 
   bail_out(error);
 
+  prk_harness_model(&harness, 2.0*order*order, 2.0*bytes);
+  prk_harness_report(&harness, "MB/s", 1.0E-06*bytes);
+  prk_harness_finalize(&harness);
+
+  if (exchange == EXCHANGE_COMMS)
+    for (i=0; i<nthread; i++) MPI_Comm_free(&thread_comm[i]);
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 
@@ -0,0 +1,531 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/*************************************************************
+Copyright (c)  2013 The University of Tennessee. All rights reserved.
+Redistribution and use in source and binary forms, with or 
+without modification, are permitted provided that the following
+conditions are met:
+
+- Redistributions of source code must retain the 
+  above copyright notice, this list of conditions and 
+  the following disclaimer.
+
+- Redistributions in binary form must reproduce the 
+  above copyright notice, this list of conditions and 
+  the following disclaimer listed in this license in the 
+  documentation and/or other materials provided with the 
+  distribution.
+
+- Neither the name of the copyright holders nor the names 
+  of its contributors may be used to endorse or promote 
+  products derived from this software without specific 
+  prior written permission.
+
+This software is provided by the copyright holders and 
+contributors "as is" and any express or implied warranties, 
+including, but not limited to, the implied warranties of
+merchantability and fitness for a particular purpose are 
+disclaimed. in no event shall the copyright owner or 
+contributors be liable for any direct, indirect, incidental, 
+special, exemplary, or consequential damages (including, but 
+not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) 
+however caused and on any theory of liability, whether in 
+contract, strict liability, or tort (including negligence or 
+otherwise) arising in any way out of the use of this software, 
+even if advised of the possibility of such damage.
+
+*************************************************************/
+/*******************************************************************
+
+NAME:    RandomAccess
+
+PURPOSE: This program tests the efficiency of the memory subsystem and
+         network to update elements of a distributed array with irregular
+         stride, using one-sided atomic operations.
+
+USAGE:   The program takes as input the ratio of number of updates over
+         table size, and the 2log of the size of the table that gets
+         updated. The table is distributed evenly over all participating
+         ranks and exposed through an MPI-3 window.
+
+         <progname> <#update ratio> <log2 tablesize>
+
+         Each rank generates the same streams of random numbers as MPI1
+         Random and applies every update directly to the owning rank's
+         part of the table with MPI_Accumulate(MPI_BXOR), so no rank takes
+         part in the updates of another.  Updates to a rank's own part of
+         the table also go through MPI_Accumulate, because only
+         accumulates with the same operation are atomic with respect to
+         each other.  All ranks hold a single passive-target epoch
+         (MPI_Win_lock_all) and complete their updates with
+         MPI_Win_flush_all after every LOOKAHEAD updates.
+
+         With PRK_UPDATE=aggregated the updates of each batch are first
+         sorted into buckets by owner, updates of the same table element
+         within a bucket are combined, and each bucket is applied with a
+         single MPI_Accumulate whose target datatype lists the table
+         elements.  PRK_UPDATE=single (the default) issues one
+         MPI_Accumulate per update.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following
+         functions are used in this program:
+
+         wtime
+         bail_out()
+         prk_harness_*()
+         PRK_starts
+         poweroftwo
+         compare_offset
+
+NOTES:   This program is derived from MPI1 Random, which is in turn derived
+         from HPC Challenge Random Access; see there for the choice of
+         random number streams and the verification test.  Because the
+         streams are the same, the rates of both versions are comparable.
+
+HISTORY: Written by Rob Van der Wijngaart, December 2007.
+         One-sided version derived from the MPI1 version, October 2026.
+
+************************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_mpi.h>
+#include <prk_harness.h>
+
+/* Define 64-bit types and corresponding format strings for printf() and constants */
+/* PERIOD = (2^63-1)/7 = 7*73*127*337*92737*649657                                 */
+#if LONG_IS_64BITS
+  #define POLY               0x0000000000000007UL
+  #define PERIOD             1317624576693539401L
+  /* sequence number in series of random numbers to be used as initial value       */
+  #define SEQSEED            834568137686317453L
+#else
+  #define POLY               0x0000000000000007ULL
+  #define PERIOD             1317624576693539401LL
+  /* sequence number in series of random numbers to be used as initial value       */
+  #define SEQSEED            834568137686317453LL
+#endif
+
+static u64Int PRK_starts(s64Int);
+static int    poweroftwo(int);
+static int    compare_offset(const void *, const void *);
+
+/* mask that extracts the local table index from a random number                   */
+static u64Int offset_mask;
+
+int main(int argc, char **argv) {
+
+  int               update_ratio;/* multiplier of tablesize for # updates          */
+  int               nstarts;     /* vector length                                  */
+  s64Int            i, j, k, round, oldsize, global_index; /* dummies             */
+  int               proc, dest;  /* dummies                                        */
+  s64Int            tablesize;   /* aggregate table size (all ranks)               */
+  s64Int            loctablesize;/* local table size (each rank)                   */
+  s64Int            nupdate;     /* number of updates per rank                     */
+  s64Int            tablespace;  /* bytes per rank required for table              */
+  u64Int            *ran;        /* vector of random numbers                       */
+  u64Int            *ranBucket;  /* buckets of random numbers, one per rank        */
+  int               *sizeBucket; /* bucket sizes                                   */
+  MPI_Aint          *displs;     /* byte displacements of table elements in bucket */
+  MPI_Datatype      target_type; /* table elements updated by one bucket           */
+  u64Int            *Table;      /* (pseudo-)randomly accessed array               */
+  MPI_Win           win;         /* window exposing the table                      */
+  MPI_Info          info;        /* window creation hints                          */
+  double            random_time, /* timing parameters                              */
+                    local_random_time;
+  prk_harness_t     harness;     /* timing and counters of the update phase        */
+  int               Num_procs,   /* rank parameters                                */
+                    my_ID,       /* rank of calling rank                           */
+                    root=0;      /* ID of master rank                              */
+  s64Int            error=0;     /* error flag for individual rank                 */
+  s64Int            tot_error;   /* error flag for all ranks combined              */
+  int               log2nproc;   /* log2 of # ranks                                */
+  int               log2nstarts; /* log2 of vector length                          */
+  int               log2tablesize; /* log2 of aggregate table size                 */
+  int               log2update_ratio; /* log2 of update ratio                      */
+  int               aggregate=0; /* apply one accumulate per bucket of updates     */
+  char              *env;        /* value of PRK_UPDATE                            */
+
+#if LONG_IS_64BITS
+  if (sizeof(long) != 8) {
+    printf("ERROR: Makefile says \"long\" is 8 bytes, but it is %d bytes\n",
+           sizeof(long));
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+/***********************************************************************************
+** rank and test input parameters
+************************************************************************************/
+
+  MPI_Init(&argc,&argv);
+  MPI_Comm_size(MPI_COMM_WORLD,&Num_procs);
+  MPI_Comm_rank(MPI_COMM_WORLD,&my_ID);
+
+  if (my_ID == root) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPIRMA Random Access\n");
+
+    if (argc != 3){
+      printf("Usage: %s <#update ratio> <log2 tablesize>\n", *argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    update_ratio  = atoi(*++argv);
+    /* test whether update ratio is a power of two                                 */
+    log2update_ratio = poweroftwo(update_ratio);
+    if (log2update_ratio <0) {
+      printf("ERROR: Invalid update ratio: %d, must be a power of 2\n",
+             update_ratio);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* test whether number of ranks is a power of two                              */
+    log2nproc = poweroftwo(Num_procs);
+    if (log2nproc <0) {
+      printf("ERROR: Invalid number of ranks: %d, must be a power of 2\n",
+             Num_procs);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    log2tablesize  = atoi(*++argv);
+    if (log2tablesize < 1){
+      printf("ERROR: Log2 tablesize is %d; must be >= 1\n",log2tablesize);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* for simplicity we set the vector length equal to the LOOKAHEAD size         */
+    nstarts = LOOKAHEAD;
+
+    /* test whether vector length is a power of two                                */
+    log2nstarts = poweroftwo(nstarts);
+    if (log2nstarts <0) {
+      printf("ERROR: Invalid vector length: %d, must be a power of 2\n",
+             nstarts);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* compute (local) table size carefully to make sure it can be represented     */
+    loctablesize = 1;
+    for (i=0; i<log2tablesize-log2nproc; i++) {
+      oldsize =  loctablesize;
+      loctablesize <<=1;
+      if (loctablesize/2 != oldsize) {
+        printf("ERROR: Requested table size too large; reduce log2 tablesize = %d\n",
+                log2tablesize);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+    tablesize = loctablesize * Num_procs;
+    if (tablesize/Num_procs != loctablesize) {
+      printf("ERROR: Requested table size too large; reduce log2 tablesize = %d\n",
+              log2tablesize);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    if ((log2tablesize + log2update_ratio) < (log2nproc+log2nstarts)) {
+      printf("ERROR: Table size ("FSTR64U") times update ratio (%d) must be at ",
+             ((s64Int)1<<log2tablesize), update_ratio);
+      printf("least equal to number of ranks (%d) times vector length (%d)\n",
+             Num_procs, nstarts);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* even though the table size can be represented, computing the space
+       required for the table may lead to overflow                                 */
+    tablespace = (size_t) loctablesize*sizeof(u64Int);
+    if ((tablespace/sizeof(u64Int)) != loctablesize || tablespace <=0) {
+      printf("ERROR: Cannot represent space for table on this system; ");
+      printf("reduce log2 tablesize\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* compute number of updates carefully to make sure it can be represented      */
+    nupdate = update_ratio * loctablesize;
+    if (nupdate/loctablesize != update_ratio) {
+      printf("Requested number of updates too large; ");
+      printf("reduce log2 tablesize or update ratio\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_UPDATE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"aggregated")) aggregate = 1;
+      else if (strcmp(env,"single")) {
+        printf("ERROR: PRK_UPDATE must be single or aggregated: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    printf("Number of ranks               = "FSTR64U"\n", (u64Int) Num_procs);
+    printf("Table size (aggregate)        = "FSTR64U"\n", tablesize);
+    printf("Update ratio                  = "FSTR64U"\n", (u64Int) update_ratio);
+    printf("Number of updates (aggregate) = "FSTR64U"\n", nupdate*Num_procs);
+    printf("Vector (LOOKAHEAD) length     = "FSTR64U"\n", (u64Int) nstarts);
+    printf("Remote update                 = %s\n", aggregate ?
+           "aggregated MPI_Accumulate per rank" : "MPI_Accumulate per element");
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  /* broadcast initialization data                                                 */
+  MPI_Bcast(&log2nproc,        1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&log2tablesize,    1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&update_ratio,     1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&log2update_ratio, 1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&nstarts,          1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&log2nstarts,      1, MPI_INT,           root, MPI_COMM_WORLD);
+  MPI_Bcast(&tablesize,        1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&loctablesize,     1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&tablespace,       1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&nupdate,          1, MPI_LONG_LONG_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&aggregate,        1, MPI_INT,           root, MPI_COMM_WORLD);
+
+  offset_mask = (u64Int) (loctablesize-1);
+
+  ran = (u64Int *) prk_malloc(nstarts*sizeof(u64Int));
+  if (!ran) {
+    printf("ERROR: rank %d could not allocate %zu bytes for random numbers\n",
+           my_ID, nstarts*sizeof(u64Int));
+    error = 1;
+  }
+  bail_out(error);
+
+  /* all accumulates use the same operation and need not be ordered, which lets
+     the MPI library use network atomics                                           */
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "accumulate_ops", "same_op");
+  MPI_Info_set(info, "accumulate_ordering", "none");
+  PRK_Win_allocate(tablespace, sizeof(u64Int), info, MPI_COMM_WORLD, &Table, &win);
+  MPI_Info_free(&info);
+  if (!Table) {
+    printf("ERROR: rank %d could not allocate space of "FSTR64U"  bytes for table\n",
+           my_ID, (u64Int) tablespace);
+    error = 1;
+  }
+  bail_out(error);
+
+  if (aggregate) {
+    ranBucket  = (u64Int *)   prk_malloc(Num_procs*nstarts*sizeof(u64Int));
+    sizeBucket = (int *)      prk_malloc(Num_procs*sizeof(int));
+    displs     = (MPI_Aint *) prk_malloc(nstarts*sizeof(MPI_Aint));
+    if (!ranBucket || !sizeBucket || !displs) {
+      printf("ERROR: rank %d Could not allocate buckets\n", my_ID);
+      error = 1;
+    }
+    bail_out(error);
+  }
+
+  /* initialize the table */
+  for(i=0;i<loctablesize;i++) Table[i] = (u64Int) (i+ loctablesize*my_ID);
+
+  prk_harness_init(&harness, "Random", "MPIRMA", 1);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "tablesize", "%lld", (long long) tablesize);
+  prk_harness_param(&harness, "update_ratio", "%d", update_ratio);
+  prk_harness_param(&harness, "vector_length", "%d", nstarts);
+  prk_harness_param(&harness, "update", "%s", aggregate ? "aggregated" : "single");
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+  prk_harness_tick(&harness);
+
+  /* do two identical rounds of Random Access to ensure we recover initial table   */
+  for (round=0; round <2; round++) {
+    /* compute seeds for independent streams, using jump-ahead feature             */
+    for (j=0; j<nstarts; j++) {
+      ran[j] = PRK_starts(SEQSEED+(nupdate/nstarts)*j+loctablesize*my_ID);
+    }
+
+    /* because we do two rounds, we divide nupdate in two                          */
+    for (i=0; i<nupdate/(nstarts*2); i++) {
+
+      if (!aggregate) {
+        for (j=0; j<nstarts; j++) {
+          ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
+          global_index = (ran[j] & (tablesize-1));
+          /* determine destination rank (high order bits of global table index)    */
+          dest = global_index>>(log2tablesize-log2nproc);
+          MPI_Accumulate(&ran[j], 1, MPI_UINT64_T, dest,
+                         (MPI_Aint) (ran[j] & offset_mask), 1, MPI_UINT64_T,
+                         MPI_BXOR, win);
+        }
+      }
+      else {
+        for (proc=0; proc<Num_procs; proc++) sizeBucket[proc] = 0;
+
+        for (j=0; j<nstarts; j++) {
+          ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
+          global_index = (ran[j] & (tablesize-1));
+          dest = global_index>>(log2tablesize-log2nproc);
+          ranBucket[dest*nstarts+sizeBucket[dest]++] = ran[j];
+        }
+
+        for (proc=0; proc<Num_procs; proc++) {
+          u64Int *bucket = ranBucket + proc*nstarts;
+          if (!sizeBucket[proc]) continue;
+          /* an accumulate may not update the same target element twice; since
+             XOR is associative, updates of the same element can be combined       */
+          qsort(bucket, sizeBucket[proc], sizeof(u64Int), compare_offset);
+          for (k=0, j=0; j<sizeBucket[proc]; j++) {
+            if (k>0 && (bucket[k-1] & offset_mask) == (bucket[j] & offset_mask))
+              bucket[k-1] ^= bucket[j];
+            else {
+              displs[k]   = (MPI_Aint) ((bucket[j] & offset_mask)*sizeof(u64Int));
+              bucket[k++] = bucket[j];
+            }
+          }
+          /* combined values no longer carry their table index, so the target
+             elements are taken from the displacements computed above              */
+          MPI_Type_create_hindexed_block(k, 1, displs, MPI_UINT64_T, &target_type);
+          MPI_Type_commit(&target_type);
+          MPI_Accumulate(bucket, k, MPI_UINT64_T, proc, 0, 1, target_type,
+                         MPI_BXOR, win);
+          MPI_Type_free(&target_type);
+        }
+      }
+
+      /* complete this batch before the random numbers and buckets are reused      */
+      MPI_Win_flush_all(win);
+    }
+  }
+
+  MPI_Win_unlock_all(win);
+  MPI_Barrier(MPI_COMM_WORLD);
+  prk_harness_tick(&harness);
+  local_random_time = prk_harness_elapsed(&harness);
+  MPI_Reduce(&local_random_time, &random_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
+
+  /* verification test */
+  for(i=0;i<loctablesize;i++) {
+    if(Table[i] != (u64Int) (i + loctablesize*my_ID)) {
+#if VERBOSE
+      printf("ERROR: Table["FSTR64U"]="FSTR64U" on rank %d\n",i,Table[i],my_ID);
+#endif
+      error++;
+    }
+  }
+
+  if (error != 0) {
+    printf("ERROR: number of incorrect table elements on rank %d = "FSTR64U"\n",
+           my_ID, error);
+  }
+
+  MPI_Reduce(&error, &tot_error, 1, MPI_LONG_LONG_INT, MPI_SUM, root, MPI_COMM_WORLD);
+  if (my_ID==root) {
+    if (!tot_error) {
+      printf("Solution validates\n");
+      printf("Rate (GUPS/s): %lf, Time (s): %lf\n",
+             1.e-9*(nupdate*Num_procs)/random_time, random_time);
+    }
+    else {
+      printf("Total number of incorrect table elements: "FSTR64U"\n", tot_error);
+    }
+  }
+
+  prk_harness_model(&harness, 0.0, 2.0*64*nupdate*Num_procs);
+  prk_harness_report(&harness, "GUPS/s", 1.e-9*(nupdate*Num_procs));
+  prk_harness_finalize(&harness);
+
+  PRK_Win_free(&win);
+  MPI_Finalize();
+}
+
+/* Utility routine to start random number generator at nth step                    */
+u64Int PRK_starts(s64Int n)
+{
+  int i, j;
+  u64Int m2[64];
+  u64Int temp, ran;
+
+  while (n < 0) n += PERIOD;
+  while (n > PERIOD) n -= PERIOD;
+  if (n == 0) return 0x1;
+
+  temp = 0x1;
+  for (i=0; i<64; i++) {
+    m2[i] = temp;
+    temp = (temp << 1) ^ ((s64Int) temp < 0 ? POLY : 0);
+    temp = (temp << 1) ^ ((s64Int) temp < 0 ? POLY : 0);
+  }
+
+  for (i=62; i>=0; i--)
+    if ((n >> i) & 1)
+      break;
+
+  ran = 0x2;
+  while (i > 0) {
+    temp = 0;
+    for (j=0; j<64; j++)
+      if ((unsigned int)((ran >> j) & 1))
+        temp ^= m2[j];
+    ran = temp;
+    i -= 1;
+    if ((n >> i) & 1)
+      ran = (ran << 1) ^ ((s64Int) ran < 0 ? POLY : 0);
+  }
+
+  return ran;
+}
+
+/* utility routine that tests whether an integer is a power of two                 */
+int poweroftwo(int n) {
+  int log2n = 0;
+
+  while ((1<<log2n)<n) log2n++;
+  if (1<<log2n != n) return (-1);
+  else               return (log2n);
+}
+
+/* orders random numbers by the local table element they update                    */
+int compare_offset(const void *a, const void *b) {
+  u64Int oa = *(const u64Int *) a & offset_mask,
+         ob = *(const u64Int *) b & offset_mask;
+
+  return (oa > ob) - (oa < ob);
+}
@@ -0,0 +1,323 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    RefCount
+
+PURPOSE: This program tests the efficiency of remote atomic updates of
+         a pair of non-adjacent reference counters that all ranks
+         access at the same time (a hot spot)
+
+USAGE:   The program takes as input the number of times each rank
+         updates the reference counter pair
+
+               <progname> <# iterations>
+
+         The output consists of diagnostics to make sure the
+         algorithm worked, of timing statistics, and of a histogram of
+         the latencies of the individual atomic operations.
+
+         The counters live in a window from MPI_Win_allocate that all
+         ranks keep open with MPI_Win_lock_all; every atomic operation is
+         completed with MPI_Win_flush before it is timed. PRK_ATOMIC
+         selects how a counter is incremented:
+           fetch_and_op  MPI_Fetch_and_op with MPI_SUM (default)
+           cas           MPI_Compare_and_swap loop, starting from the last
+                         value the rank saw; failed attempts are counted
+         PRK_HOST selects where the counter pair lives:
+           single        on rank 0, so all ranks hit the same target (default)
+           spread        on every rank; update i of rank r goes to the
+                         pair on rank (r+i) mod #ranks
+         Timing every operation adds two wtime() calls to each of them;
+         use a low-overhead timer (PRK_TIMER) for short latencies.
+
+FUNCTIONS CALLED:
+
+         Other than MPI or standard C functions, the following
+         functions are used in this program:
+
+         wtime()
+         bail_out()
+         prk_harness_*()
+         cas_increment()
+         prk_histogram_add()
+         prk_histogram_print()
+
+HISTORY: Derived from OPENMP/Refcount, October 2026; the counter pair is
+         hosted in an RMA window and updated with remote atomics.
+
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <inttypes.h>
+#include <par-res-kern_mpi.h>
+#include <prk_histogram.h>
+#include <prk_harness.h>
+
+#define ATOMIC_FETCH_AND_OP 0
+#define ATOMIC_CAS          1
+
+/* displacements of the two counters in the window; they are kept on
+   different cache lines so they are not adjacent                        */
+#define COUNTER_STRIDE  16
+#define WINDOW_LENGTH   (2*COUNTER_STRIDE)
+
+#if MPI_VERSION >= 3
+/* Increments the counter at displacement disp on rank target with a
+   compare-and-swap loop. guess holds the last value seen of that counter
+   and is updated. Returns the number of failed attempts.                */
+static long cas_increment(int target, MPI_Aint disp, int64_t *guess, MPI_Win win)
+{
+  int64_t desired, result;
+  long    failures = 0;
+
+  for (;;) {
+    desired = *guess + 1;
+    MPI_Compare_and_swap(&desired, guess, &result, MPI_INT64_T, target, disp, win);
+    MPI_Win_flush(target, win);
+    if (result == *guess) break;
+    *guess = result;
+    failures++;
+  }
+  *guess = desired;
+  return failures;
+}
+#endif
+
+int main(int argc, char ** argv)
+{
+  int     my_ID;            /* rank                                              */
+  int     root=0;           /* ID of root rank                                   */
+  int     Num_procs;        /* number of ranks                                   */
+  long    iterations;       /* number of counter pair updates per rank           */
+  long    iter;             /* dummy                                             */
+  int     c;                /* counter index                                     */
+  int     atomic=ATOMIC_FETCH_AND_OP; /* type of atomic update                   */
+  int     spread=0;         /* counter pairs on all ranks instead of on root     */
+  int     target;           /* rank hosting the counter pair being updated       */
+  char    *env;             /* value of an environment variable                  */
+  int     error=0;          /* error flag                                        */
+  int64_t *window;          /* local part of the counter window                  */
+  int64_t *guess;           /* last counter values seen, per target rank         */
+  int64_t one=1, old;       /* operands of MPI_Fetch_and_op                      */
+  int64_t counts[2],        /* local counter values and their sums               */
+          total_counts[2],
+          refcount;         /* verification value of each counter                */
+  long    failures=0,       /* failed compare-and-swap attempts                  */
+          total_failures;
+  double  op_time;          /* start time of an atomic operation                 */
+  double  local_refcount_time, /* timing parameters                              */
+          refcount_time;
+  prk_histogram_t hist,     /* latencies of the atomic operations                */
+                  total_hist;
+  MPI_Win win;              /* RMA window holding the counter pair               */
+  prk_harness_t harness;    /* timing of all updates as a single iteration       */
+
+/*********************************************************************************
+** Initialize the MPI environment
+**********************************************************************************/
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+
+/*********************************************************************
+** process, test and broadcast input parameters
+*********************************************************************/
+
+  if (my_ID == root) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("MPIRMA reference counter update\n");
+
+    if (argc != 2) {
+      printf("Usage: %s <# iterations>\n", *argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    iterations = atol(*++argv);
+    if (iterations < 1) {
+      printf("ERROR: iterations must be >= 1 : %ld \n", iterations);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    env = getenv("PRK_ATOMIC");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"cas"))          atomic = ATOMIC_CAS;
+      else if (strcmp(env,"fetch_and_op")) {
+        printf("ERROR: PRK_ATOMIC must be fetch_and_op or cas: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+    env = getenv("PRK_HOST");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"spread")) spread = 1;
+      else if (strcmp(env,"single")) {
+        printf("ERROR: PRK_HOST must be single or spread: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
+#if MPI_VERSION < 3
+    printf("ERROR: this kernel requires MPI-3 atomics\n");
+    error = 1;
+    goto ENDOFTESTS;
+#endif
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  if (my_ID == root) {
+    printf("Number of ranks                = %d\n", Num_procs);
+    printf("Number of counter pair updates = %ld per rank\n", iterations);
+    printf("Atomic operation               = %s\n",
+           atomic==ATOMIC_CAS ? "MPI_Compare_and_swap" : "MPI_Fetch_and_op");
+    printf("Counter pair location          = %s\n",
+           spread ? "spread over all ranks" : "rank 0");
+  }
+
+  MPI_Bcast(&iterations, 1, MPI_LONG, root, MPI_COMM_WORLD);
+  MPI_Bcast(&atomic,     1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&spread,     1, MPI_INT,  root, MPI_COMM_WORLD);
+
+#if MPI_VERSION >= 3
+  MPI_Win_allocate(WINDOW_LENGTH*sizeof(int64_t), sizeof(int64_t), MPI_INFO_NULL,
+                   MPI_COMM_WORLD, &window, &win);
+  guess = (int64_t *) prk_malloc(2*Num_procs*sizeof(int64_t));
+  if (!guess) {
+    printf("ERROR: rank %d could not allocate space for counter values\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+
+  for (c=0; c<WINDOW_LENGTH; c++) window[c] = 0;
+  for (c=0; c<2*Num_procs; c++) guess[c] = 0;
+  prk_histogram_init(&hist);
+  prk_histogram_init(&total_hist);
+  prk_harness_init(&harness, "Refcount", "MPIRMA", 1);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "iterations", "%ld", iterations);
+  prk_harness_param(&harness, "atomic", "%s", atomic==ATOMIC_CAS ? "cas" : "fetch_and_op");
+  prk_harness_param(&harness, "host", "%s", spread ? "spread" : "single");
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+  for (iter=0; iter<=iterations; iter++) {
+
+    /* start timer after a warmup iteration                                      */
+    if (iter == 1) {
+      MPI_Barrier(MPI_COMM_WORLD);
+      prk_harness_tick(&harness);
+    }
+
+    target = spread ? (int) ((my_ID+iter)%Num_procs) : root;
+    for (c=0; c<2; c++) {
+      op_time = wtime();
+      if (atomic == ATOMIC_CAS) {
+        failures += cas_increment(target, c*COUNTER_STRIDE, &guess[2*target+c], win);
+      }
+      else {
+        MPI_Fetch_and_op(&one, &old, MPI_INT64_T, target, c*COUNTER_STRIDE, MPI_SUM, win);
+        MPI_Win_flush(target, win);
+      }
+      if (iter > 0) prk_histogram_add(&hist, wtime()-op_time);
+    }
+  }
+
+  prk_harness_tick(&harness);
+  local_refcount_time = prk_harness_elapsed(&harness);
+  MPI_Win_unlock_all(win);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  /*******************************************************************************
+  ** Analyze and output results.
+  ********************************************************************************/
+
+  /* make the updates of the other ranks visible in the local window copy        */
+  MPI_Win_lock(MPI_LOCK_SHARED, my_ID, 0, win);
+  MPI_Win_sync(win);
+  counts[0] = window[0];
+  counts[1] = window[COUNTER_STRIDE];
+  MPI_Win_unlock(my_ID, win);
+
+  MPI_Reduce(counts, total_counts, 2, MPI_INT64_T, MPI_SUM, root, MPI_COMM_WORLD);
+  MPI_Reduce(&local_refcount_time, &refcount_time, 1, MPI_DOUBLE, MPI_MAX, root,
+             MPI_COMM_WORLD);
+  MPI_Reduce(&failures, &total_failures, 1, MPI_LONG, MPI_SUM, root, MPI_COMM_WORLD);
+  MPI_Reduce(hist.count, total_hist.count, PRK_HISTOGRAM_BINS, MPI_LONG_LONG,
+             MPI_SUM, root, MPI_COMM_WORLD);
+
+  if (my_ID == root) {
+    refcount = (int64_t) Num_procs*(iterations+1);
+    if (total_counts[0] != refcount || total_counts[1] != refcount) {
+      printf("ERROR: Incorrect counter values %" PRId64 " %" PRId64 "; ",
+             total_counts[0], total_counts[1]);
+      printf("should be %" PRId64 ", %" PRId64 "\n", refcount, refcount);
+      error = 1;
+    }
+  }
+  bail_out(error);
+
+  if (my_ID == root) {
+#if VERBOSE
+    printf("Solution validates; Correct counter values %" PRId64 " %" PRId64 "\n",
+           total_counts[0], total_counts[1]);
+#else
+    printf("Solution validates\n");
+#endif
+    if (atomic == ATOMIC_CAS)
+      printf("Failed compare-and-swaps       = %ld (%lf per update)\n", total_failures,
+             (double) total_failures/(2.0*Num_procs*iterations));
+    prk_histogram_print(&total_hist,
+                        atomic==ATOMIC_CAS ? "MPI_Compare_and_swap" : "MPI_Fetch_and_op");
+    printf("Rate (MCPUPs/s): %lf time (s): %lf\n",
+           1.0E-06*Num_procs*iterations/refcount_time, refcount_time);
+  }
+
+  prk_harness_report(&harness, "MCPUPs/s", 1.0E-06*Num_procs*iterations);
+  prk_harness_finalize(&harness);
+
+  prk_free(guess);
+  MPI_Win_free(&win);
+#endif
+
+  MPI_Finalize();
+  exit(EXIT_SUCCESS);
+
+}  /* end of main */
@@ -43,6 +43,24 @@ USAGE:   The program takes as input the linear dimension of the grid,
  
                <progname> <# iterations> <grid size>
   
+         The halo exchange is synchronized as selected by PRK_RMA_SYNC:
+           fence   MPI_Win_fence around the puts of each direction (default)
+           pscw    post/start/complete/wait with the group of neighbors in
+                   each direction only
+           notify  a passive-target epoch for the whole run; each put is
+                   followed by MPI_Win_flush and an atomic increment of a
+                   counter at the target, which the target polls (MPI-3)
+         With pscw and notify only neighbors synchronize with each other,
+         so the cost does not grow with the number of ranks.  In notify
+         mode the halos alternate between two receive buffers, so that a
+         neighbor that is one iteration ahead cannot overwrite data that
+         has not been unpacked yet.
+
+         With PRK_HALO_DEPTH=k the ghost zone is k*RADIUS points deep and is
+         exchanged only every k iterations; in between, the ghost points that
+         are still read before the next exchange are updated redundantly,
+         trading the extra work and larger messages for fewer of them.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
  
@@ -53,6 +71,7 @@ FUNCTIONS CALLED:
  
          wtime()
          bail_out()
+         prk_harness_*()
  
 HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, August 2013: Removed unrolling pragmas for clarity;
@@ -65,11 +84,14 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, October 2014: removed barrier at start of each iteration
          - RvdW, October 2014: replaced single rank/single iteration timing
            with global timing of all iterations across all ranks
+         - Added PSCW and notified passive-target synchronization
+         - Added deep (communication-avoiding) halos
   
 *********************************************************************************/
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
  
 #if DOUBLE
   #define DTYPE     double
@@ -88,12 +110,74 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
 #endif
  
 /* define shorthand for indexing multi-dimensional arrays with offsets           */
-#define INDEXIN(i,j)  (i+RADIUS+(j+RADIUS)*(width+2*RADIUS))
-/* need to add offset of RADIUS to j to account for ghost points                 */
+#define INDEXIN(i,j)  (i+ghost+(j+ghost)*(width+2*ghost))
+/* need to add offset of ghost to j to account for ghost points                  */
 #define IN(i,j)       in[INDEXIN(i-istart,j-jstart)]
 #define INDEXOUT(i,j) (i+(j)*(width))
 #define OUT(i,j)      out[INDEXOUT(i-istart,j-jstart)]
 #define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+
+/* synchronization modes of the halo exchange (PRK_RMA_SYNC)                 */
+#define SYNC_FENCE  0
+#define SYNC_PSCW   1
+#define SYNC_NOTIFY 2
+
+/* open the exposure and access epochs of one direction                      */
+static void sync_begin(int mode, MPI_Group nbrs, MPI_Win win) {
+  switch (mode) {
+  case SYNC_FENCE: MPI_Win_fence(MPI_MODE_NOSTORE, win);
+                   break;
+  case SYNC_PSCW:  MPI_Win_post(nbrs, 0, win);
+                   MPI_Win_start(nbrs, 0, win);
+                   break;
+  }
+}
+
+#if MPI_VERSION >= 3
+/* poll counter slot of the calling rank until it has reached count         */
+static void wait_count(MPI_Win counters, int slot, int count) {
+  int my_ID, arrived;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  do {
+    MPI_Fetch_and_op(NULL, &arrived, MPI_INT, my_ID, slot, MPI_NO_OP, counters);
+    MPI_Win_flush(my_ID, counters);
+  } while (arrived < count);
+}
+#endif
+
+/* complete the puts of one direction to neighbors hi_nbr and lo_nbr (-1 if
+   absent) and wait until those of the neighbors have arrived; in notify mode
+   counters[slot] counts the halos received from the high neighbor, 
+   counters[slot+1] those received from the low neighbor                     */
+static void sync_end(int mode, MPI_Group nbrs, MPI_Win win, int hi_nbr, 
+                     int lo_nbr, MPI_Win counters, int slot, int count) {
+  int one = 1;
+  switch (mode) {
+  case SYNC_FENCE: MPI_Win_fence(MPI_MODE_NOSTORE, win);
+                   break;
+  case SYNC_PSCW:  MPI_Win_complete(win);
+                   MPI_Win_wait(win);
+                   break;
+#if MPI_VERSION >= 3
+  case SYNC_NOTIFY:
+    if (hi_nbr >= 0) {
+      MPI_Win_flush(hi_nbr, win);
+      MPI_Accumulate(&one, 1, MPI_INT, hi_nbr, slot+1, 1, MPI_INT, MPI_SUM, counters);
+      MPI_Win_flush(hi_nbr, counters);
+    }
+    if (lo_nbr >= 0) {
+      MPI_Win_flush(lo_nbr, win);
+      MPI_Accumulate(&one, 1, MPI_INT, lo_nbr, slot, 1, MPI_INT, MPI_SUM, counters);
+      MPI_Win_flush(lo_nbr, counters);
+    }
+    if (hi_nbr >= 0) wait_count(counters, slot,   count);
+    if (lo_nbr >= 0) wait_count(counters, slot+1, count);
+    /* make the data put by the neighbors visible to local loads            */
+    MPI_Win_sync(win);
+    break;
+#endif
+  }
+}
  
 int main(int argc, char ** argv) {
  
@@ -127,6 +211,7 @@ int main(int argc, char ** argv) {
   double local_stencil_time,/* timing parameters                                 */
          stencil_time,
          avgtime; 
+  prk_harness_t harness;  /* per-iteration timing                                */
   int    stencil_size;    /* number of points in stencil                         */
   DTYPE  * RESTRICT in;   /* input grid values                                   */
   DTYPE  * RESTRICT out;  /* output grid values                                  */
@@ -137,6 +222,21 @@ int main(int argc, char ** argv) {
   MPI_Win rma_winx;       /* RMA window object x-direction */
   MPI_Win rma_winy;       /* RMA window object y-direction */
   MPI_Info rma_winfo;     /* info for window */
+  MPI_Win rma_winc;       /* RMA window object for notification counters */
+  int    *counters;       /* halos received from top, bottom, right, left */
+  int    sync;            /* synchronization mode of the halo exchange    */
+  char   *env;            /* value of PRK_RMA_SYNC or PRK_HALO_DEPTH      */
+  int    depth;           /* halo depth in multiples of RADIUS            */
+  int    ghost;           /* depth of the ghost zone: depth*RADIUS        */
+  int    ext;             /* ghost zone depth read before next exchange   */
+  int    nblocks;         /* number of halo buffers per window            */
+  int    par;             /* receive buffer used in this iteration        */
+  DTYPE *top_in[2], *bottom_in[2], *right_in[2], *left_in[2]; /* receive buffers */
+  int    top_disp[2], bottom_disp[2], right_disp[2], left_disp[2];
+                          /* offsets of the receive buffers in the windows   */
+  MPI_Group world_group;  /* group of MPI_COMM_WORLD                      */
+  MPI_Group nbrs_x, nbrs_y; /* groups of neighbors in x and y             */
+  int    nbr_list[2], nnbr; /* ranks and number of neighbors in a group   */
 
   /*******************************************************************************
   ** Initialize the MPI environment
@@ -192,6 +292,31 @@ int main(int argc, char ** argv) {
       error = 1;
       goto ENDOFTESTS;  
     }
+
+    env = getenv("PRK_RMA_SYNC");
+    if      (!env || !strcmp(env, "fence")) sync = SYNC_FENCE;
+    else if (!strcmp(env, "pscw"))          sync = SYNC_PSCW;
+    else if (!strcmp(env, "notify"))        sync = SYNC_NOTIFY;
+    else {
+      printf("ERROR: PRK_RMA_SYNC must be fence, pscw or notify: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+#if MPI_VERSION < 3
+    if (sync == SYNC_NOTIFY) {
+      printf("ERROR: PRK_RMA_SYNC=notify requires MPI-3\n");
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+#endif
+
+    env   = getenv("PRK_HALO_DEPTH");
+    depth = env ? atoi(env) : 1;
+    if (depth < 1) {
+      printf("ERROR: PRK_HALO_DEPTH must be positive: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
  
     ENDOFTESTS:;  
   }
@@ -231,10 +356,18 @@ int main(int argc, char ** argv) {
     printf("Compact representation of stencil loop body\n");
 #endif
     printf("Number of iterations   = %d\n", iterations);
+    printf("RMA synchronization    = %s\n", sync == SYNC_FENCE ? "fence" :
+           sync == SYNC_PSCW ? "post/start/complete/wait" : 
+           "passive target with notification");
+    printf("Halo depth             = %d x radius, exchanged every %d iteration%s\n",
+           depth, depth, depth > 1 ? "s" : "");
   }
  
   MPI_Bcast(&n,          1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&sync,       1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&depth,      1, MPI_INT, root, MPI_COMM_WORLD);
+  ghost = depth*RADIUS;
  
   /* compute amount of space required for input and solution arrays             */
   
@@ -274,14 +407,14 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
-  if (width < RADIUS || height < RADIUS) {
-    printf("ERROR: rank %d has work tile smaller then stencil radius\n",
+  if (width < ghost || height < ghost) {
+    printf("ERROR: rank %d has work tile smaller then halo depth\n",
            my_ID);
     error = 1;
   }
   bail_out(error);
  
-  total_length_in  = (long) (width+2*RADIUS)* (long) (height+2*RADIUS)*sizeof(DTYPE);
+  total_length_in  = (long) (width+2*ghost)* (long) (height+2*ghost)*sizeof(DTYPE);
   total_length_out = (long) width* (long) height*sizeof(DTYPE);
  
   in  = (DTYPE *) prk_malloc(total_length_in);
@@ -314,91 +447,144 @@ int main(int argc, char ** argv) {
   MPI_Info_create(&rma_winfo);
   /* This key indicates that passive target RMA will not be used.
    * It is the one info key that MPICH actually uses for optimization. */
-  MPI_Info_set(rma_winfo, "no_locks", "true");
+  if (sync != SYNC_NOTIFY) MPI_Info_set(rma_winfo, "no_locks", "true");
 
-  /* allocate communication buffers for halo values                            */
-  PRK_Win_allocate(4*sizeof(DTYPE)*RADIUS*width, sizeof(DTYPE), rma_winfo, MPI_COMM_WORLD, (void *) &top_buf_out, &rma_winy);
+  /* allocate communication buffers for halo values; notification needs a 
+     second pair of receive buffers                                            */
+  nblocks = sync == SYNC_NOTIFY ? 6 : 4;
+  PRK_Win_allocate(nblocks*sizeof(DTYPE)*ghost*width, sizeof(DTYPE), rma_winfo, MPI_COMM_WORLD, (void *) &top_buf_out, &rma_winy);
   if (!top_buf_out) {
     printf("ERROR: Rank %d could not allocated comm buffers for y-direction\n", my_ID);
     error = 1;
   }
   bail_out(error);
-  top_buf_in     = top_buf_out +   RADIUS*width;
-  bottom_buf_out = top_buf_out + 2*RADIUS*width;
-  bottom_buf_in  = top_buf_out + 3*RADIUS*width;
+  top_buf_in     = top_buf_out +   ghost*width;
+  bottom_buf_out = top_buf_out + 2*ghost*width;
+  bottom_buf_in  = top_buf_out + 3*ghost*width;
  
-  PRK_Win_allocate(4*sizeof(DTYPE)*RADIUS*height, sizeof(DTYPE), rma_winfo, MPI_COMM_WORLD, (void *) &right_buf_out, &rma_winx);
+  PRK_Win_allocate(nblocks*sizeof(DTYPE)*ghost*height, sizeof(DTYPE), rma_winfo, MPI_COMM_WORLD, (void *) &right_buf_out, &rma_winx);
   if (!right_buf_out) {
     printf("ERROR: Rank %d could not allocated comm buffers for x-direction\n", my_ID);
     error = 1;
   }
   bail_out(error);
-  right_buf_in   = right_buf_out +   RADIUS*height;
-  left_buf_out   = right_buf_out + 2*RADIUS*height;
-  left_buf_in    = right_buf_out + 3*RADIUS*height;
+  right_buf_in   = right_buf_out +   ghost*height;
+  left_buf_out   = right_buf_out + 2*ghost*height;
+  left_buf_in    = right_buf_out + 3*ghost*height;
+
+  /* receive buffers and their window offsets for even and odd iterations     */
+  top_in[0]    = top_in[1]    = top_buf_in;    top_disp[0]    = top_disp[1]    =   ghost*width;
+  bottom_in[0] = bottom_in[1] = bottom_buf_in; bottom_disp[0] = bottom_disp[1] = 3*ghost*width;
+  right_in[0]  = right_in[1]  = right_buf_in;  right_disp[0]  = right_disp[1]  =   ghost*height;
+  left_in[0]   = left_in[1]   = left_buf_in;   left_disp[0]   = left_disp[1]   = 3*ghost*height;
+  if (sync == SYNC_NOTIFY) {
+    top_in[1]    = top_buf_out   + 4*ghost*width;  top_disp[1]    = 4*ghost*width;
+    bottom_in[1] = top_buf_out   + 5*ghost*width;  bottom_disp[1] = 5*ghost*width;
+    right_in[1]  = right_buf_out + 4*ghost*height; right_disp[1]  = 4*ghost*height;
+    left_in[1]   = right_buf_out + 5*ghost*height; left_disp[1]   = 5*ghost*height;
+  }
+
+  /* groups of the neighbors each rank exposes its windows to and accesses    */
+  MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+  nnbr = 0;
+  if (my_IDy < Num_procsy-1) nbr_list[nnbr++] = top_nbr;
+  if (my_IDy > 0)            nbr_list[nnbr++] = bottom_nbr;
+  MPI_Group_incl(world_group, nnbr, nbr_list, &nbrs_y);
+  nnbr = 0;
+  if (my_IDx < Num_procsx-1) nbr_list[nnbr++] = right_nbr;
+  if (my_IDx > 0)            nbr_list[nnbr++] = left_nbr;
+  MPI_Group_incl(world_group, nnbr, nbr_list, &nbrs_x);
+
+#if MPI_VERSION >= 3
+  if (sync == SYNC_NOTIFY) {
+    /* one counter per neighbor, a passive-target epoch for the whole run     */
+    PRK_Win_allocate(4*sizeof(int), sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD,
+                     (void *) &counters, &rma_winc);
+    for (kk=0; kk<4; kk++) counters[kk] = 0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, rma_winy);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, rma_winx);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, rma_winc);
+  }
+#endif
+
+  prk_harness_init(&harness, "Stencil", "MPIRMA", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%d", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "sync", "%s", sync == SYNC_FENCE ? "fence" :
+                    sync == SYNC_PSCW ? "pscw" : "notify");
+  prk_harness_param(&harness, "halo_depth", "%d", depth);
 
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_stencil_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
-    /* need to fetch ghost point data from neighbors in y-direction                 */
-    MPI_Win_fence(MPI_MODE_NOSTORE, rma_winy);
-    if (my_IDy < Num_procsy-1) {
-      for (kk=0,j=jend-RADIUS; j<=jend-1; j++) for (i=istart; i<=iend; i++) {
-          top_buf_out[kk++]= IN(i,j);
+    /* the ghost zone is refreshed every depth iterations; it is depth*RADIUS
+       points deep, so it still holds the RADIUS points read by the stencil
+       after the redundant updates of the iterations in between              */
+    if (!(iter%depth)) {
+      par = (iter/depth)%2;
+
+      /* need to fetch ghost point data from neighbors in y-direction               */
+      sync_begin(sync, nbrs_y, rma_winy);
+      if (my_IDy < Num_procsy-1) {
+        for (kk=0,j=jend-ghost; j<=jend-1; j++) for (i=istart; i<=iend; i++) {
+            top_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Put(top_buf_out, ghost*width, MPI_DTYPE, top_nbr,
+	        bottom_disp[par], ghost*width, MPI_DTYPE, rma_winy);
       }
-      MPI_Put(top_buf_out, RADIUS*width, MPI_DTYPE, top_nbr,
-	      3*RADIUS*width, RADIUS*width, MPI_DTYPE, rma_winy);
-    }
-    if (my_IDy > 0) {
-      for (kk=0,j=jstart; j<=jstart+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
-          bottom_buf_out[kk++]= IN(i,j);
+      if (my_IDy > 0) {
+        for (kk=0,j=jstart; j<=jstart+ghost-1; j++) for (i=istart; i<=iend; i++) {
+            bottom_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Put(bottom_buf_out, ghost*width, MPI_DTYPE, bottom_nbr,
+	        top_disp[par], ghost*width, MPI_DTYPE, rma_winy);
+      }
+      sync_end(sync, nbrs_y, rma_winy, my_IDy < Num_procsy-1 ? top_nbr : -1,
+               my_IDy > 0 ? bottom_nbr : -1, rma_winc, 0, iter/depth+1);
+      if (my_IDy < Num_procsy-1) {
+        for (kk=0,j=jend; j<=jend+ghost-1; j++) for (i=istart; i<=iend; i++) {
+            IN(i,j) = top_in[par][kk++];
+        }      
+      }
+      if (my_IDy > 0) {
+        for (kk=0,j=jstart-ghost; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
+            IN(i,j) = bottom_in[par][kk++];
+        }      
       }
-      MPI_Put(bottom_buf_out, RADIUS*width, MPI_DTYPE, bottom_nbr,
-	      RADIUS*width, RADIUS*width, MPI_DTYPE, rma_winy);
-    }
-    MPI_Win_fence(MPI_MODE_NOSTORE, rma_winy);
-    if (my_IDy < Num_procsy-1) {
-      for (kk=0,j=jend; j<=jend+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = top_buf_in[kk++];
-      }      
-    }
-    if (my_IDy > 0) {
-      for (kk=0,j=jstart-RADIUS; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = bottom_buf_in[kk++];
-      }      
-    }
 
-    /* need to fetch ghost point data from neighbors in x-direction                 */
-    MPI_Win_fence(MPI_MODE_NOSTORE, rma_winx);
-    if (my_IDx < Num_procsx-1) {
-      for (kk=0,j=jstart; j<=jend; j++) for (i=iend-RADIUS; i<=iend-1; i++) {
-          right_buf_out[kk++]= IN(i,j);
+      /* need to fetch ghost point data from neighbors in x-direction               */
+      sync_begin(sync, nbrs_x, rma_winx);
+      if (my_IDx < Num_procsx-1) {
+        for (kk=0,j=jstart; j<=jend; j++) for (i=iend-ghost; i<=iend-1; i++) {
+            right_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Put(right_buf_out, ghost*height, MPI_DTYPE, right_nbr,
+	        left_disp[par], ghost*height, MPI_DTYPE, rma_winx);
       }
-      MPI_Put(right_buf_out, RADIUS*height, MPI_DTYPE, right_nbr,
-	      3*RADIUS*height, RADIUS*height, MPI_DTYPE, rma_winx);
-    }
-    if (my_IDx > 0) {
-      for (kk=0,j=jstart; j<=jend; j++) for (i=istart; i<=istart+RADIUS-1; i++) {
-          left_buf_out[kk++]= IN(i,j);
+      if (my_IDx > 0) {
+        for (kk=0,j=jstart; j<=jend; j++) for (i=istart; i<=istart+ghost-1; i++) {
+            left_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Put(left_buf_out, ghost*height, MPI_DTYPE, left_nbr,
+	        right_disp[par], ghost*height, MPI_DTYPE, rma_winx);
+      }
+      sync_end(sync, nbrs_x, rma_winx, my_IDx < Num_procsx-1 ? right_nbr : -1,
+               my_IDx > 0 ? left_nbr : -1, rma_winc, 2, iter/depth+1);
+      if (my_IDx < Num_procsx-1) {
+        for (kk=0,j=jstart; j<=jend; j++) for (i=iend; i<=iend+ghost-1; i++) {
+            IN(i,j) = right_in[par][kk++];
+        }      
+      }
+      if (my_IDx > 0) {
+        for (kk=0,j=jstart; j<=jend; j++) for (i=istart-ghost; i<=istart-1; i++) {
+            IN(i,j) = left_in[par][kk++];
+        }      
       }
-      MPI_Put(left_buf_out, RADIUS*height, MPI_DTYPE, left_nbr,
-	      RADIUS*height, RADIUS*height, MPI_DTYPE, rma_winx);
-    }
-    MPI_Win_fence(MPI_MODE_NOSTORE, rma_winx);
-    if (my_IDx < Num_procsx-1) {
-      for (kk=0,j=jstart; j<=jend; j++) for (i=iend; i<=iend+RADIUS-1; i++) {
-          IN(i,j) = right_buf_in[kk++];
-      }      
-    }
-    if (my_IDx > 0) {
-      for (kk=0,j=jstart; j<=jend; j++) for (i=istart-RADIUS; i<=istart-1; i++) {
-          IN(i,j) = left_buf_in[kk++];
-      }      
     }
  
     /* Apply the stencil operator */
@@ -414,12 +600,21 @@ int main(int argc, char ** argv) {
       }
     }
  
-    /* add constant to solution to force refresh of neighbor data, if any */
-    for (j=jstart; j<jend; j++) for (i=istart; i<iend; i++) IN(i,j)+= 1.0;
+    /* add constant to solution to force refresh of neighbor data, if any; 
+       the ghost points that are read again before the next exchange receive
+       the same update redundantly                                            */
+    ext = (depth-1-iter%depth)*RADIUS;
+    for (j=jstart-(my_IDy>0 ? ext : 0); j<jend+(my_IDy<Num_procsy-1 ? ext : 0); j++) 
+      for (i=istart; i<iend; i++) IN(i,j)+= 1.0;
+    if (ext > 0) for (j=jstart; j<jend; j++) {
+      if (my_IDx > 0)            for (i=istart-ext; i<istart; i++) IN(i,j)+= 1.0;
+      if (my_IDx < Num_procsx-1) for (i=iend; i<iend+ext; i++)     IN(i,j)+= 1.0;
+    }
  
   }
  
-  local_stencil_time = wtime() - local_stencil_time;
+  prk_harness_tick(&harness);
+  local_stencil_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_stencil_time, &stencil_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
@@ -461,15 +656,30 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
   if (my_ID == root) {
-    /* flops/stencil: 2 flops (fma) for each point in the stencil, 
-       plus one flop for the update of the input of the array        */
-    flops = (DTYPE) (2*stencil_size+1) * f_active_points;
     avgtime = stencil_time/iterations;
     printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
            1.0E-06 * flops/avgtime, avgtime);
   }
- 
+  /* reads of IN and read-modify-writes of OUT and of all of IN */
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
+ 
+#if MPI_VERSION >= 3
+  if (sync == SYNC_NOTIFY) {
+    MPI_Win_unlock_all(rma_winc);
+    MPI_Win_unlock_all(rma_winx);
+    MPI_Win_unlock_all(rma_winy);
+    PRK_Win_free(&rma_winc);
+  }
+#endif
+  MPI_Group_free(&nbrs_x);
+  MPI_Group_free(&nbrs_y);
+  MPI_Group_free(&world_group);
   PRK_Win_free(&rma_winx);
   PRK_Win_free(&rma_winy);
 
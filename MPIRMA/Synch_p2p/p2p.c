@@ -42,11 +42,22 @@ PURPOSE: This program tests the efficiency with which point-to-point
 USAGE:   The program takes as input the dimensions of the grid, and the
          number of times we loop over the grid
 
-               <progname> <# iterations> <m> <n>
+               <progname> <# iterations> <m> <n> [group factor]
 
          The output consists of diagnostics to make sure the
          algorithm worked, and of timing statistics.
 
+         By default every transfer of boundary values is its own
+         post-start-complete-wait (PSCW) epoch. With PRK_SYNC=notify
+         (requires MPI-3) the grid lives in a window from MPI_Win_allocate
+         that all ranks keep open with MPI_Win_lock_all. Behind the grid each
+         rank has a notification counter. A rank puts its boundary values
+         into the ghost column of its right neighbor, flushes, and then
+         stores the number of line groups sent so far in the counter of the
+         neighbor with MPI_Accumulate; the neighbor polls its own counter
+         with MPI_Fetch_and_op. The group factor sends that many lines per
+         transfer, in either mode.
+
 FUNCTIONS CALLED:
 
          Other than MPI or standard C functions, the following
@@ -54,6 +65,8 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         wait_for_notification()
+         prk_harness_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, March 2006.
          - modified by Rob Van der Wijngaart, August 2006:
@@ -66,10 +79,26 @@ HISTORY: - Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
 
 #define ARRAY(i,j) vector[i+1+(j)*(segment_size+1)]
 #define NBR_INDEX(i,j) (i+(j)*(nbr_segment_size+1))
 
+#if MPI_VERSION >= 3
+/* Spins until the notification counter at displacement disp in the window of the
+   calling rank has reached value, then makes the data put before it visible     */
+static void wait_for_notification(int64_t value, int my_ID, MPI_Aint disp, MPI_Win win)
+{
+  int64_t count;
+
+  do {
+    MPI_Fetch_and_op(NULL, &count, MPI_INT64_T, my_ID, disp, MPI_NO_OP, win);
+    MPI_Win_flush(my_ID, win);
+  } while (count < value);
+  MPI_Win_sync(win);
+}
+#endif
+
 int main(int argc, char ** argv)
 {
   int    my_ID;           /* rank                                                */
@@ -78,9 +107,10 @@ int main(int argc, char ** argv)
   double local_pipeline_time, /* timing parameters                               */
          pipeline_time,
          avgtime;
+  prk_harness_t harness;  /* per-iteration timing                                */
   double epsilon = 1.e-8; /* error tolerance                                     */
   double corner_val;      /* verification value at top right corner of grid      */
-  int    i, j, iter, ID;  /* dummies                                             */
+  int    i, j, jj, iter, ID; /* dummies                                          */
   int    iterations;      /* number of times to run the pipeline algorithm       */
   int    *start, *end;    /* starts and ends of grid slices                      */
   long   segment_size;    /* size of x-dimension of grid owned by calling rank   */
@@ -94,6 +124,16 @@ int main(int argc, char ** argv)
   MPI_Group world_group, origin_group, target_group;
   int origin_ranks[1], target_ranks[1];
   int nbr_segment_size;
+  int    grp;             /* grid line aggregation factor                        */
+  int    jjsize;          /* actual line group size                              */
+  int    g;               /* line group index                                    */
+  int    notify=0;        /* use lock_all epochs and put-with-notification       */
+  char   *env;            /* value of PRK_SYNC                                   */
+  MPI_Datatype origin_type[2], /* boundary values of a full and of the last      */
+               target_type[2]; /* line group, at origin and at target            */
+  MPI_Aint counter_disp, nbr_counter_disp; /* displacements of counters          */
+  int64_t  ngroup,        /* number of line groups per iteration                 */
+           count;         /* notification value                                  */
 
 /*********************************************************************************
 ** Initialize the MPI environment
@@ -113,8 +153,8 @@ int main(int argc, char ** argv)
     printf("Parallel Research Kernels version %s\n", PRKVERSION);
     printf("MPIRMA pipeline execution on 2D grid\n");
 
-    if (argc != 4){
-      printf("Usage: %s  <#iterations> <1st array dimension> <2nd array dimension>\n",
+    if (argc != 4 && argc != 5){
+      printf("Usage: %s  <#iterations> <1st array dimension> <2nd array dimension> [group factor]\n",
              *argv);
       error = 1;
       goto ENDOFTESTS;
@@ -142,6 +182,30 @@ int main(int argc, char ** argv)
       goto ENDOFTESTS;
     }
 
+    if (argc==5) {
+      grp = atoi(*++argv);
+      if (grp < 1) grp = 1;
+      else if (grp >= n) grp = n-1;
+    }
+    else grp = 1;
+
+    env = getenv("PRK_SYNC");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"notify")) notify = 1;
+      else if (strcmp(env,"pscw")) {
+        printf("ERROR: PRK_SYNC must be pscw or notify: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+#if MPI_VERSION < 3
+    if (notify) {
+      printf("ERROR: PRK_SYNC=notify requires MPI-3\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+#endif
+
     ENDOFTESTS:;
   }
   bail_out(error);
@@ -150,6 +214,10 @@ int main(int argc, char ** argv)
     printf("Number of ranks                = %i\n",Num_procs);
     printf("Grid sizes                     = %ld, %ld\n", m, n);
     printf("Number of iterations           = %d\n", iterations);
+    if (grp > 1)
+    printf("Group factor                   = %d (cheating!)\n", grp);
+    printf("Synchronization                = %s\n", notify ?
+           "lock_all with put-with-notification" : "PSCW");
 #if VERBOSE
     printf("Synchronizations/iteration     = %d\n", (Num_procs-1)*(n-1));
 #endif
@@ -159,6 +227,8 @@ int main(int argc, char ** argv)
   MPI_Bcast(&m, 1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&n, 1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&grp,        1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&notify,     1, MPI_INT, root, MPI_COMM_WORLD);
 
   start = (int *) prk_malloc(2*Num_procs*sizeof(int));
   if (!start) {
@@ -186,11 +256,24 @@ int main(int argc, char ** argv)
   /* total_length takes into account one ghost cell on left side of segment     */
   total_length = ((end[my_ID]-start[my_ID]+1)+1)*n;
 
+#if MPI_VERSION >= 3
+  if (notify) {
+    /* one extra slot holds the notification counter; it is only ever accessed
+       with atomic operations                                                    */
+    MPI_Info_set(rma_winfo, "no_locks", "false");
+    MPI_Info_set(rma_winfo, "accumulate_ops", "same_op_no_op");
+    PRK_Win_allocate((total_length+1)*sizeof(double), sizeof(double), rma_winfo,
+                     MPI_COMM_WORLD, &vector, &rma_win);
+  }
+  else
+#endif
+  {
   vector = (double *) prk_malloc(total_length*sizeof(double));
   MPI_Win_create(vector, total_length*sizeof(double), sizeof(double), rma_winfo, MPI_COMM_WORLD, &rma_win);
 #warning Why are we not using MPI_Win_allocate here?
 #warning If this is a shared-memory bug, then we need to fix the bug.
   /* MPI_Win_allocate(total_length*sizeof(double), sizeof(double), rma_winfo, MPI_COMM_WORLD, (void *) &vector, &rma_win); */
+  }
   if (vector == NULL) {
     printf("Could not allocate space for grid slice of %ld by %ld points",
            segment_size, n);
@@ -234,58 +317,147 @@ int main(int argc, char ** argv)
   else
     nbr_segment_size = end[0] - start[0] + 1;
 
-  for (iter=0; iter<=iterations; iter++) {
-
-    /* start timer after a warmup iteration */
-    if (iter == 1) {
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_pipeline_time = wtime();
-    }
-
-    /* execute pipeline algorithm for grid lines 1 through n-1 (skip bottom line) */
-    for (j=1; j<n; j++) {
-
-      /* if I am not at the left boundary, I need to wait for my left neighbor to
-         send data                                                                */
-      if (my_ID > 0) {
-        /*  Exposure epoch at target*/
-        MPI_Win_post(origin_group, MPI_MODE_NOSTORE, rma_win);
-        MPI_Win_wait(rma_win);
+  /* a line group of boundary values is a strided column, at origin and target  */
+  for (i=0; i<2; i++) {
+    jjsize = i ? (n-1)%grp : grp;
+    if (!jjsize) jjsize = grp;
+    MPI_Type_vector(jjsize, 1, segment_size+1,     MPI_DOUBLE, &origin_type[i]);
+    MPI_Type_vector(jjsize, 1, nbr_segment_size+1, MPI_DOUBLE, &target_type[i]);
+    MPI_Type_commit(&origin_type[i]);
+    MPI_Type_commit(&target_type[i]);
+  }
+  ngroup = (n-1+grp-1)/grp;
+
+  prk_harness_init(&harness, "Synch_p2p", "MPIRMA", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
+  prk_harness_param(&harness, "group", "%d", grp);
+  prk_harness_param(&harness, "sync", "%s", notify ? "notify" : "pscw");
+
+#if MPI_VERSION >= 3
+  if (notify) {
+    counter_disp     = total_length;
+    nbr_counter_disp = (nbr_segment_size+1)*n;
+    *((int64_t *) &vector[counter_disp]) = 0;
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, rma_win);
+    MPI_Win_sync(rma_win);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    for (iter=0; iter<=iterations; iter++) {
+
+      /* start timer after a warmup iteration */
+      if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+      if (iter >= 1) prk_harness_tick(&harness);
+
+      /* the root waits for the corner value of the previous iteration           */
+      if (my_ID==root && Num_procs>1)
+        wait_for_notification(iter, my_ID, counter_disp, rma_win);
+
+      for (g=0, j=1; j<n; j+=grp, g++) {
+
+        jjsize = MIN(grp, n-j);
+        count  = iter*ngroup+g+1;
+
+        /* if I am not at the left boundary, wait for my left neighbor's data    */
+        if (my_ID > 0) wait_for_notification(count, my_ID, counter_disp, rma_win);
+
+        for (jj=j; jj<j+jjsize; jj++)
+        for (i=start[my_ID]; i<= end[my_ID]; i++) {
+          ARRAY(i,jj) = ARRAY(i-1,jj) + ARRAY(i,jj-1) - ARRAY(i-1,jj-1);
+        }
+
+        /* if I am not on the right boundary, send data to my right neighbor and
+           notify it once the data has arrived                                   */
+        if (my_ID != Num_procs-1) {
+          MPI_Put(&(ARRAY(end[my_ID],j)), 1, origin_type[jjsize!=grp], my_ID+1,
+                  NBR_INDEX(0,j), 1, target_type[jjsize!=grp], rma_win);
+          MPI_Win_flush(my_ID+1, rma_win);
+          MPI_Accumulate(&count, 1, MPI_INT64_T, my_ID+1, nbr_counter_disp,
+                         1, MPI_INT64_T, MPI_REPLACE, rma_win);
+          MPI_Win_flush(my_ID+1, rma_win);
+        }
       }
 
-      for (i=start[my_ID]; i<= end[my_ID]; i++) {
-        ARRAY(i,j) = ARRAY(i-1,j) + ARRAY(i,j-1) - ARRAY(i-1,j-1);
+      /* copy top right corner value to bottom left corner to create dependency  */
+      if (Num_procs >1) {
+        if (my_ID==final) {
+          corner_val = -ARRAY(end[my_ID],n-1);
+          count      = iter+1;
+          MPI_Put(&corner_val, 1, MPI_DOUBLE, root, NBR_INDEX(1,0), 1, MPI_DOUBLE, rma_win);
+          MPI_Win_flush(root, rma_win);
+          MPI_Accumulate(&count, 1, MPI_INT64_T, root, nbr_counter_disp,
+                         1, MPI_INT64_T, MPI_REPLACE, rma_win);
+          MPI_Win_flush(root, rma_win);
+        }
       }
+      else ARRAY(0,0)= -ARRAY(end[my_ID],n-1);
 
-      /* if I am not on the right boundary, send data to my right neighbor        */
-      if (my_ID != Num_procs-1) {
-        /* Access epoch at origin */
-        MPI_Win_start(target_group, 0, rma_win);
-        MPI_Put(&(ARRAY(end[my_ID],j)), 1, MPI_DOUBLE, my_ID+1,
-		NBR_INDEX(0,j), 1, MPI_DOUBLE, rma_win);
-        MPI_Win_complete(rma_win);
-      }
     }
 
-    /* copy top right corner value to bottom left corner to create dependency      */
-    if (Num_procs >1) {
-      if (my_ID==final) {
-        corner_val = -ARRAY(end[my_ID],n-1);
-        MPI_Win_start(target_group, 0, rma_win);
-        MPI_Put(&corner_val, 1, MPI_DOUBLE, root,
-	 	NBR_INDEX(1,0), 1, MPI_DOUBLE, rma_win);
-        MPI_Win_complete(rma_win);
+    prk_harness_tick(&harness);
+    local_pipeline_time = prk_harness_elapsed(&harness);
+    MPI_Win_unlock_all(rma_win);
+  }
+  else
+#endif
+  {
+    for (iter=0; iter<=iterations; iter++) {
+
+      /* start timer after a warmup iteration */
+      if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+      if (iter >= 1) prk_harness_tick(&harness);
+
+      /* execute pipeline algorithm for grid lines 1 through n-1 (skip bottom line) */
+      for (j=1; j<n; j+=grp) {
+
+        jjsize = MIN(grp, n-j);
+
+        /* if I am not at the left boundary, I need to wait for my left neighbor to
+           send data                                                                */
+        if (my_ID > 0) {
+          /*  Exposure epoch at target*/
+          MPI_Win_post(origin_group, MPI_MODE_NOSTORE, rma_win);
+          MPI_Win_wait(rma_win);
+        }
+
+        for (jj=j; jj<j+jjsize; jj++)
+        for (i=start[my_ID]; i<= end[my_ID]; i++) {
+          ARRAY(i,jj) = ARRAY(i-1,jj) + ARRAY(i,jj-1) - ARRAY(i-1,jj-1);
+        }
+
+        /* if I am not on the right boundary, send data to my right neighbor        */
+        if (my_ID != Num_procs-1) {
+          /* Access epoch at origin */
+          MPI_Win_start(target_group, 0, rma_win);
+          MPI_Put(&(ARRAY(end[my_ID],j)), 1, origin_type[jjsize!=grp], my_ID+1,
+  		NBR_INDEX(0,j), 1, target_type[jjsize!=grp], rma_win);
+          MPI_Win_complete(rma_win);
+        }
       }
-      if (my_ID==root) {
-        MPI_Win_post(origin_group, MPI_MODE_NOSTORE, rma_win);
-        MPI_Win_wait(rma_win);
+
+      /* copy top right corner value to bottom left corner to create dependency      */
+      if (Num_procs >1) {
+        if (my_ID==final) {
+          corner_val = -ARRAY(end[my_ID],n-1);
+          MPI_Win_start(target_group, 0, rma_win);
+          MPI_Put(&corner_val, 1, MPI_DOUBLE, root,
+  	 	NBR_INDEX(1,0), 1, MPI_DOUBLE, rma_win);
+          MPI_Win_complete(rma_win);
+        }
+        if (my_ID==root) {
+          MPI_Win_post(origin_group, MPI_MODE_NOSTORE, rma_win);
+          MPI_Win_wait(rma_win);
+        }
       }
+      else ARRAY(0,0)= -ARRAY(end[my_ID],n-1);
+
     }
-    else ARRAY(0,0)= -ARRAY(end[my_ID],n-1);
 
+    prk_harness_tick(&harness);
+    local_pipeline_time = prk_harness_elapsed(&harness);
   }
 
-  local_pipeline_time = wtime() - local_pipeline_time;
   MPI_Reduce(&local_pipeline_time, &pipeline_time, 1, MPI_DOUBLE, MPI_MAX, final,
              MPI_COMM_WORLD);
 
@@ -306,6 +478,8 @@ int main(int argc, char ** argv)
 
   if (my_ID == final) {
     avgtime = pipeline_time/iterations;
+    /* flip the sign of the execution time to indicate cheating                    */
+    if (grp>1) avgtime *= -1.0;
 #if VERBOSE
     printf("Solution validates; verification value = %lf\n", corner_val);
     printf("Point-to-point synchronizations/s: %lf\n",
@@ -317,6 +491,13 @@ int main(int argc, char ** argv)
            1.0E-06 * 2 * ((double)((m-1)*(n-1)))/avgtime, avgtime);
   }
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * ((double)((m-1)*(n-1))));
+  prk_harness_finalize(&harness);
+
+  for (i=0; i<2; i++) {
+    MPI_Type_free(&origin_type[i]);
+    MPI_Type_free(&target_type[i]);
+  }
   MPI_Win_free(&rma_win);
   MPI_Info_free(&rma_winfo);
 
@@ -45,6 +45,24 @@ USAGE:   Program inputs are the matrix order, the number of times to
  
          An optional parameter specifies the tile size used to divide the 
          individual matrix blocks for improved cache and TLB performance. 
+
+         The blocks are pushed with MPI_Put into a window that is created
+         once, synchronized by MPI_Win_fence or, with sync=1 (MPI-3), in
+         a single MPI_Win_lock_all epoch with flushes.  With MPI-3 the
+         one-sided operation is selected at run time:
+
+           PRK_RMA_OP=put   MPI_Put (default)
+           PRK_RMA_OP=rput  push with request-based MPI_Rput, completed
+                            with MPI_Waitall for every batch of <flush
+                            bundle> blocks and MPI_Win_flush_all at the
+                            end of the iteration
+           PRK_RMA_OP=rget  pull with MPI_Rget: every rank packs all its
+                            outgoing blocks into its own window, and the
+                            ranks fetch the blocks destined for them in
+                            batches of <flush bundle>, scattering each
+                            batch into B as soon as MPI_Waitall returns
+
+         Both request-based variants always use the lock_all epoch.
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -56,6 +74,7 @@ FUNCTIONS CALLED:
  
           wtime()           Portable wall-timer interface.
           bail_out()        Determine global error and exit if nonzero.
+          prk_harness_*()   Per-iteration timing and results record.
  
 HISTORY: Written by Tim Mattson, April 1999.  
          Updated by Rob Van der Wijngaart, December 2005.
@@ -121,12 +140,18 @@ o The original and transposed matrices are called A and B
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_harness.h>
  
 #define A(i,j)          A_p[(i+istart)+order*(j)]
 #define B(i,j)          B_p[(i+istart)+order*(j)]
 #define Work_in(p,i,j)  Work_in_p[(p)*Block_size+i+Block_order*(j)]
 #define Work_out(p,i,j) Work_out_p[(p)*Block_size+i+Block_order*(j)]
  
+/* one-sided operations that move the blocks                        */
+#define RMA_PUT  0
+#define RMA_RPUT 1
+#define RMA_RGET 2
+
 int main(int argc, char ** argv)
 {
   long Block_order;        /* number of columns owned by rank       */
@@ -158,13 +183,19 @@ int main(int argc, char ** argv)
   double local_trans_time, /* timing parameters                     */
          trans_time,
          avgtime;
+  prk_harness_t harness;   /* per-iteration timing                  */
   MPI_Win  rma_win = MPI_WIN_NULL;
   MPI_Info rma_winfo = MPI_INFO_NULL;
   int passive_target = 0;  /* use passive target RMA sync           */
 #if MPI_VERSION >= 3
   int  flush_local  = 1;   /* flush local (or remote) after put     */
   int  flush_bundle = 1;   /* flush every <bundle> put calls        */
+  MPI_Request *rma_req;    /* requests of a batch of Rput/Rget      */
+  int  nreq = 0;           /* number of requests in current batch   */
+  int  k;
 #endif
+  int  rma_op = RMA_PUT;   /* one-sided operation that moves blocks */
+  char *env;               /* value of PRK_RMA_OP                   */
  
 /*********************************************************************
 ** Initialize the MPI environment
@@ -211,6 +242,27 @@ int main(int argc, char ** argv)
     if (argc >= 6) flush_local    = atoi(*++argv);
     if (argc >= 7) flush_bundle   = atoi(*++argv);
 #endif
+
+    env = getenv("PRK_RMA_OP");
+    if (env != NULL && !strcmp(env, "rput"))      rma_op = RMA_RPUT;
+    else if (env != NULL && !strcmp(env, "rget")) rma_op = RMA_RGET;
+    else if (env != NULL && strcmp(env, "put")) {
+      printf("ERROR: PRK_RMA_OP must be put, rput or rget: %s\n", env);
+      error = 1; goto ENDOFTESTS;
+    }
+    if (rma_op != RMA_PUT) {
+#if MPI_VERSION < 3
+      printf("ERROR: PRK_RMA_OP=%s requires MPI-3\n", env);
+      error = 1; goto ENDOFTESTS;
+#else
+      /* request-based operations are only allowed in a passive target epoch */
+      passive_target = 1;
+      if (flush_bundle < 1) {
+        printf("ERROR: flush bundle must be positive: %d\n", flush_bundle);
+        error = 1; goto ENDOFTESTS;
+      }
+#endif
+    }
  
     ENDOFTESTS:;
   }
@@ -227,11 +279,17 @@ int main(int argc, char ** argv)
 #if MPI_VERSION < 3
         printf("Synchronization      = MPI_Win_(un)lock\n");
 #else
-        printf("Synchronization      = MPI_Win_flush%s (bundle=%d)\n", flush_local ? "_local" : "", flush_bundle);
+        if (rma_op != RMA_PUT)
+          printf("Synchronization      = MPI_Win_lock_all, MPI_Waitall (batch=%d)\n", flush_bundle);
+        else
+          printf("Synchronization      = MPI_Win_flush%s (bundle=%d)\n", flush_local ? "_local" : "", flush_bundle);
 #endif
     } else {
         printf("Synchronization      = MPI_Win_fence\n");
     }
+    printf("RMA operation        = %s\n", rma_op == RMA_RPUT ? "MPI_Rput (push)" :
+                                          rma_op == RMA_RGET ? "MPI_Rget (pull)" :
+                                                               "MPI_Put (push)");
   }
   
   /*  Broadcast input data to all ranks */
@@ -243,6 +301,7 @@ int main(int argc, char ** argv)
   MPI_Bcast (&flush_local,    1, MPI_INT,  root, MPI_COMM_WORLD);
   MPI_Bcast (&flush_bundle,   1, MPI_INT,  root, MPI_COMM_WORLD);
 #endif
+  MPI_Bcast (&rma_op,         1, MPI_INT,  root, MPI_COMM_WORLD);
  
   /* a non-positive tile size means no tiling of the local transpose */
   tiling = (Tile_order > 0) && (Tile_order < order);
@@ -270,8 +329,10 @@ int main(int argc, char ** argv)
   }
   bail_out(error);
  
+  /* the passive target modes lock the window, so only fences may promise
+     not to                                                                */
   MPI_Info_create (&rma_winfo);
-  MPI_Info_set (rma_winfo, "no locks", "true");
+  if (!passive_target) MPI_Info_set (rma_winfo, "no locks", "true");
   B_p = (double *)prk_malloc(Colblock_size*sizeof(double));
   if (B_p == NULL){
     printf(" Error allocating space for transpose matrix on node %d\n",my_ID);
@@ -279,7 +340,9 @@ int main(int argc, char ** argv)
   }
   bail_out(error);
   
-  if (Num_procs>1) {
+  /* the window exposes the receive buffers of the pushes, or the send
+     buffers from which the blocks are pulled                              */
+  if (Num_procs>1 && rma_op != RMA_RGET) {
     Work_out_p = (double *) prk_malloc (Block_size*(Num_procs-1)*sizeof(double));
     if (Work_out_p == NULL){
       printf(" Error allocating space for work_out on node %d\n",my_ID);
@@ -295,6 +358,31 @@ int main(int argc, char ** argv)
     }
     bail_out(error);
   }
+  else if (Num_procs>1) {
+    Work_in_p = (double *) prk_malloc (Block_size*(Num_procs-1)*sizeof(double));
+    if (Work_in_p == NULL){
+      printf(" Error allocating space for work_in on node %d\n",my_ID);
+      error = 1;
+    }
+    bail_out(error);
+ 
+    PRK_Win_allocate (Block_size*(Num_procs-1)*sizeof(double), sizeof(double), 
+                      rma_winfo, MPI_COMM_WORLD, &Work_out_p, &rma_win);
+    if (Work_out_p == NULL){
+      printf(" Error allocating space for work on node %d\n",my_ID);
+      error = 1;
+    }
+    bail_out(error);
+  }
+
+#if MPI_VERSION >= 3
+  rma_req = (MPI_Request *) prk_malloc(flush_bundle*sizeof(MPI_Request));
+  if (rma_req == NULL){
+    printf(" Error allocating space for requests on node %d\n",my_ID);
+    error = 1;
+  }
+  bail_out(error);
+#endif
 
 #if MPI_VERSION >= 3
   if (passive_target && Num_procs>1) {
@@ -312,13 +400,19 @@ int main(int argc, char ** argv)
  
   MPI_Barrier(MPI_COMM_WORLD);
  
+  prk_harness_init(&harness, "Transpose", "MPIRMA", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "order", "%ld", order);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? Tile_order : 0);
+  prk_harness_param(&harness, "sync", "%s", passive_target ? "passive" : "fence");
+  prk_harness_param(&harness, "rma_op", "%s", rma_op == RMA_RPUT ? "rput" :
+                    rma_op == RMA_RGET ? "rget" : "put");
+
   for (iter = 0; iter<=iterations; iter++){
  
     /* start timer after a warmup iteration                                        */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_trans_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
  
     /* do the local transpose                                                     */
     istart = colstart; 
@@ -364,7 +458,22 @@ int main(int argc, char ** argv)
               }
       }
 
-#if MPI_VERSION < 3
+#if MPI_VERSION >= 3
+      /* pulled blocks stay in the window until their target fetches them */
+      if (rma_op == RMA_RGET) continue;
+
+      /* local completion of a batch of pushes bounds the requests in flight;
+         remote completion follows with the flush at the end of the phases  */
+      if (rma_op == RMA_RPUT) {
+        MPI_Rput(Work_out_p+Block_size*(phase-1), Block_size, MPI_DOUBLE, send_to,
+                 Block_size*(phase-1), Block_size, MPI_DOUBLE, rma_win, &rma_req[nreq++]);
+        if (nreq == flush_bundle || phase == Num_procs-1) {
+          MPI_Waitall(nreq, rma_req, MPI_STATUSES_IGNORE);
+          nreq = 0;
+        }
+        continue;
+      }
+#else
       if (passive_target) {
           MPI_Win_lock(MPI_LOCK_SHARED, send_to, MPI_MODE_NOCHECK, rma_win);
       }
@@ -393,7 +502,32 @@ int main(int argc, char ** argv)
 #endif
       }
     }  /* end of phase loop for puts  */
-    if (Num_procs>1) {
+
+#if MPI_VERSION >= 3
+    /* once all blocks are packed, every rank fetches those destined for it;
+       each batch is scattered as soon as it has arrived                     */
+    if (rma_op == RMA_RGET && Num_procs>1) {
+      MPI_Barrier(MPI_COMM_WORLD);
+      for (phase=1; phase<Num_procs; phase+=nreq) {
+        nreq = MIN(flush_bundle, Num_procs-phase);
+        for (k=0; k<nreq; k++) {
+          recv_from = (my_ID + phase + k)%Num_procs;
+          MPI_Rget(Work_in_p+Block_size*(phase+k-1), Block_size, MPI_DOUBLE, recv_from,
+                   Block_size*(phase+k-1), Block_size, MPI_DOUBLE, rma_win, &rma_req[k]);
+        }
+        MPI_Waitall(nreq, rma_req, MPI_STATUSES_IGNORE);
+        for (k=0; k<nreq; k++) {
+          recv_from = (my_ID + phase + k)%Num_procs;
+          istart = recv_from*Block_order;
+          for (j=0; j<Block_order; j++)
+            for (i=0; i<Block_order; i++)
+              B(i,j) += Work_in(phase+k-1,i,j);
+        }
+      }
+      nreq = 0;
+    }
+#endif
+    if (Num_procs>1 && rma_op != RMA_RGET) {
       if (passive_target) {
 #if MPI_VERSION >= 3
           MPI_Win_flush_all(rma_win);
@@ -404,7 +538,7 @@ int main(int argc, char ** argv)
       }
     }
  
-    for (phase=1; phase<Num_procs; phase++) {
+    for (phase=1; phase<Num_procs && rma_op != RMA_RGET; phase++) {
       recv_from = (my_ID + phase            )%Num_procs;
       istart = recv_from*Block_order; 
       /* scatter received block to transposed matrix; no need to tile */
@@ -414,14 +548,16 @@ int main(int argc, char ** argv)
     } /* end of phase loop for scatters */
 
     /* for the flush case we need to make sure we have consumed Work_in 
-       before overwriting it in the next iteration                    */
+       before overwriting it in the next iteration; when pulling, that
+       the other ranks have fetched Work_out before it is repacked     */
     if (Num_procs>1 && passive_target) {
       MPI_Barrier(MPI_COMM_WORLD);
     }
  
   } /* end of iterations */
  
-  local_trans_time = wtime() - local_trans_time;
+  prk_harness_tick(&harness);
+  local_trans_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_trans_time, &trans_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
  
@@ -448,6 +584,11 @@ int main(int argc, char ** argv)
  
   bail_out(error);
 
+  /* B += A^T and A += 1: two reads and two writes per element */
+  prk_harness_model(&harness, 2.0*order*order, 2.0*bytes);
+  prk_harness_report(&harness, "MB/s", 1.0E-06*bytes);
+  prk_harness_finalize(&harness);
+
   if (rma_win!=MPI_WIN_NULL) {
 #if MPI_VERSION >=3
     if (passive_target) {
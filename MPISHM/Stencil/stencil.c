@@ -43,6 +43,23 @@ USAGE:   The program takes as input the linear dimension of the grid,
  
                <progname> <# iterations> <grid size>
   
+         With PRK_HALO_DEPTH=k the ghost zone of each shared memory block is
+         k*RADIUS points deep and is exchanged only every k iterations; in
+         between, the ghost points that are still read before the next 
+         exchange are updated redundantly, trading the extra work and larger
+         messages for fewer of them.
+
+         The ranks of a shared memory domain update their tiles of one
+         block stored in a shared window, so they read the ghost points
+         owned by on-node neighbors directly; only tiles on the boundary
+         of the block exchange messages, with other domains.  Before and
+         after the update of IN every rank synchronizes with its on-node
+         neighbors, by default with zero-byte messages (or a barrier when
+         built with LOCAL_BARRIER_SYNCH=1).  With PRK_SHM_SYNC=flags each
+         rank instead publishes a counter in a shared window and waits
+         until those of its neighbors have caught up, with MPI_Win_sync
+         ordering the loads and stores (see flag_sync()).
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
  
@@ -52,7 +69,10 @@ FUNCTIONS CALLED:
          functions are used in this program:
  
          wtime()
+         prk_topology_bind()
+         flag_sync()
          bail_out()
+         prk_harness_*()
  
 HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, August 2013: Removed unrolling pragmas for clarity;
@@ -65,11 +85,14 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW, October 2014: removed barrier at start of each iteration
          - RvdW, October 2014: replaced single rank/single iteration timing
            with global timing of all iterations across all ranks
+         - Added deep (communication-avoiding) halos
   
 *********************************************************************************/
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_topology.h>
+#include <prk_harness.h>
 
 /**********************************************************************************
  Strategy for hierarchical decomposition of grid.
@@ -148,12 +171,32 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
 #endif
  
 /* define shorthand for indexing multi-dimensional arrays with offsets           */
-#define INDEXIN(i,j)  (i+RADIUS+(j+RADIUS)*(width+2*RADIUS))
-/* need to add offset of RADIUS to j to account for ghost points                 */
+#define INDEXIN(i,j)  (i+ghost+(j+ghost)*(width+2*ghost))
+/* need to add offset of ghost to j to account for ghost points                  */
 #define IN(i,j)       in[INDEXIN(i-istart,j-jstart)]
 #define INDEXOUT(i,j) (i+(j)*(width))
 #define OUT(i,j)      out[INDEXOUT(i-istart,j-jstart)]
 #define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+
+/* Announces that the calling rank has reached synchronization point count
+   and waits until its on-node neighbors have reached it as well.  flags
+   holds one counter per rank of the shared memory domain; neighbors are
+   never more than one point apart, so a counter that has passed count is
+   as good as one that equals it.  The stores of the caller must have been
+   made visible with MPI_Win_sync on their window before the call, and the
+   caller's subsequent loads are ordered by the MPI_Win_sync calls in the
+   polling loop.                                                            */
+static void flag_sync(volatile int * flags, MPI_Win flag_win, int me,
+                      int * nbr, int num_nbrs, int count) {
+  int i;
+
+  flags[me] = count;
+  MPI_Win_sync(flag_win);
+  for (i=0; i<num_nbrs; i++) {
+    while (flags[nbr[i]] < count) MPI_Win_sync(flag_win);
+  }
+  MPI_Win_sync(flag_win);
+}
  
 int main(int argc, char ** argv) {
  
@@ -208,6 +251,7 @@ int main(int argc, char ** argv) {
   double local_stencil_time,/* timing parameters                                 */
          stencil_time,
          avgtime; 
+  prk_harness_t harness;  /* per-iteration timing                                */
   int    stencil_size;    /* number of points in stencil                         */
   DTYPE  * RESTRICT in;   /* input grid values                                   */
   DTYPE  * RESTRICT out;  /* output grid values                                  */
@@ -225,8 +269,17 @@ int main(int argc, char ** argv) {
   int shm_ID;             /* MPI rank in shared memory domain                    */
   MPI_Aint size_in;       /* size of the IN array in shared memory window        */
   MPI_Aint size_out;      /* size of the OUT array in shared memory window       */
+  MPI_Aint size_flags;    /* size of the flags in shared memory window           */
   int size_mul;           /* one for shm_comm root, zero for the other ranks     */
   int disp_unit;          /* ignored                                             */
+  int    depth;           /* halo depth in multiples of RADIUS                   */
+  int    ghost;           /* depth of the ghost zone: depth*RADIUS               */
+  int    ext;             /* depth of ghost zone still read before next exchange */
+  char   *env;            /* value of PRK_HALO_DEPTH or PRK_SHM_SYNC             */
+  int    use_flags;       /* nonzero if on-node neighbors synchronize by flags   */
+  MPI_Win flag_win;       /* shared memory window with the flags                 */
+  volatile int *flags;    /* synchronization counter of every rank of the domain */
+  int    sync_count = 0;  /* number of on-node synchronizations so far           */
  
   /*******************************************************************************
   ** Initialize the MPI environment
@@ -295,6 +348,22 @@ int main(int argc, char ** argv) {
       error = 1;
       goto ENDOFTESTS;  
     }
+
+    env   = getenv("PRK_HALO_DEPTH");
+    depth = env ? atoi(env) : 1;
+    if (depth < 1) {
+      printf("ERROR: PRK_HALO_DEPTH must be positive: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+
+    env       = getenv("PRK_SHM_SYNC");
+    use_flags = env && !strcmp(env, "flags");
+    if (env && !use_flags && strcmp(env, "messages")) {
+      printf("ERROR: PRK_SHM_SYNC must be messages or flags: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
  
     ENDOFTESTS:;  
   }
@@ -303,6 +372,10 @@ int main(int argc, char ** argv) {
   MPI_Bcast(&n,          1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&group_size, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&depth,      1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&use_flags,  1, MPI_INT, root, MPI_COMM_WORLD);
+  ghost = depth*RADIUS;
+  prk_topology_bind();
  
   /* determine best way to create a 2D grid of ranks (closest to square, for 
      best surface/volume ratio); we do this brute force for now. The 
@@ -331,10 +404,13 @@ int main(int argc, char ** argv) {
     printf("Tiles per shared memory domain  = %d\n", group_size);
     printf("Tiles in x/y-direction in group = %d/%d\n", group_sizex,  group_sizey);
     printf("Type of stencil                 = star\n");
+    if (use_flags)
+      printf("Local synchronization           = shared flags\n");
+    else
 #if LOCAL_BARRIER_SYNCH
-    printf("Local synchronization           = barrier\n");
+      printf("Local synchronization           = barrier\n");
 #else
-    printf("Local synchronization           = point to point\n");
+      printf("Local synchronization           = point to point\n");
 #endif
 #if DOUBLE
     printf("Data type                       = double precision\n");
@@ -347,6 +423,8 @@ int main(int argc, char ** argv) {
     printf("Compact representation of stencil loop body\n");
 #endif
     printf("Number of iterations            = %d\n", iterations);
+    printf("Halo depth                      = %d x radius, exchanged every %d iteration%s\n",
+           depth, depth, depth > 1 ? "s" : "");
   }
 
   /* Setup for Shared memory regions */
@@ -450,7 +528,7 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
-  total_length_in = (width+2*RADIUS)*(height+2*RADIUS)*sizeof(DTYPE);
+  total_length_in = (width+2*ghost)*(height+2*ghost)*sizeof(DTYPE);
   total_length_out = width*height*sizeof(DTYPE);
 
   /* only the root of each SHM domain specifies window of nonzero size */
@@ -477,6 +555,18 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
 
+  /* the flags are allocated by the root of the domain, like the arrays */
+  MPI_Win_allocate_shared(sizeof(int)*group_size*size_mul, sizeof(int), MPI_INFO_NULL,
+                          shm_comm, (void *) &flags, &flag_win);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, flag_win);
+  MPI_Win_shared_query(flag_win, MPI_PROC_NULL, &size_flags, &disp_unit, (void *)&flags);
+  if (flags == NULL){
+    printf("Error allocating space for flags by group %d\n", my_group);
+    error = 1;
+  }
+  bail_out(error);
+  flags[shm_ID] = 0;
+
   /* determine index set assigned to each rank                         */
 
   width_rank = width/group_sizex;
@@ -513,26 +603,33 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
 
+  if (width_rank < ghost || height_rank < ghost) {
+    printf("ERROR: rank %d has work tile smaller then halo depth; w=%d,h=%d\n",
+           my_ID, width_rank, height_rank);
+    error = 1;
+  }
+  bail_out(error);
+
   /* allocate communication buffers for halo values                            */
-  top_buf_out = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*RADIUS*width_rank);
+  top_buf_out = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*ghost*width_rank);
   if (!top_buf_out) {
     printf("ERROR: Rank %d could not allocated comm buffers for y-direction\n", my_ID);
     error = 1;
   }
   bail_out(error);
-  top_buf_in     = top_buf_out +   RADIUS*width_rank;
-  bottom_buf_out = top_buf_out + 2*RADIUS*width_rank;
-  bottom_buf_in  = top_buf_out + 3*RADIUS*width_rank;
+  top_buf_in     = top_buf_out +   ghost*width_rank;
+  bottom_buf_out = top_buf_out + 2*ghost*width_rank;
+  bottom_buf_in  = top_buf_out + 3*ghost*width_rank;
  
-  right_buf_out = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*RADIUS*height_rank);
+  right_buf_out = (DTYPE *) prk_malloc(4*sizeof(DTYPE)*ghost*height_rank);
   if (!right_buf_out) { 
     printf("ERROR: Rank %d could not allocated comm buffers for x-direction\n", my_ID);
     error = 1;
   }
   bail_out(error);
-  right_buf_in   = right_buf_out +   RADIUS*height_rank;
-  left_buf_out   = right_buf_out + 2*RADIUS*height_rank;
-  left_buf_in    = right_buf_out + 3*RADIUS*height_rank;
+  right_buf_in   = right_buf_out +   ghost*height_rank;
+  left_buf_out   = right_buf_out + 2*ghost*height_rank;
+  left_buf_in    = right_buf_out + 3*ghost*height_rank;
 
     /* fill the stencil weights to reflect a discrete divergence operator         */
   for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
@@ -554,103 +651,119 @@ int main(int argc, char ** argv) {
   /* LOAD/STORE FENCE */
   MPI_Win_sync(shm_win_in);
   MPI_Win_sync(shm_win_out);
+  MPI_Win_sync(flag_win);
   MPI_Barrier(shm_comm); 
 
+  prk_harness_init(&harness, "Stencil", "MPISHM", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "group_size", "%d", group_size);
+  prk_harness_param(&harness, "grid_size", "%ld", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "halo_depth", "%d", depth);
+#if LOCAL_BARRIER_SYNCH
+  prk_harness_param(&harness, "local_sync", "%s", use_flags ? "flags" : "barrier");
+#else
+  prk_harness_param(&harness, "local_sync", "%s", use_flags ? "flags" : "p2p");
+#endif
+
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_stencil_time = wtime();
-    }
-
-    /* need to fetch ghost point data from neighbors in y-direction                 */
-    if (top_nbr != -1) {
-      MPI_Irecv(top_buf_in, RADIUS*width_rank, MPI_DTYPE, top_nbr, 101,
-                MPI_COMM_WORLD, &(request[1]));
-      for (kk=0,j=jend_rank-RADIUS+1; j<=jend_rank; j++) 
-      for (i=istart_rank; i<=iend_rank; i++) {
-        top_buf_out[kk++]= IN(i,j);
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
+
+    /* the ghost zone is refreshed every depth iterations; it is depth*RADIUS
+       points deep, so it still holds the RADIUS points read by the stencil
+       after the redundant updates of the iterations in between              */
+    if (!(iter%depth)) {
+      /* need to fetch ghost point data from neighbors in y-direction               */
+      if (top_nbr != -1) {
+        MPI_Irecv(top_buf_in, ghost*width_rank, MPI_DTYPE, top_nbr, 101,
+                  MPI_COMM_WORLD, &(request[1]));
+        for (kk=0,j=jend_rank-ghost+1; j<=jend_rank; j++) 
+        for (i=istart_rank; i<=iend_rank; i++) {
+          top_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(top_buf_out, ghost*width_rank,MPI_DTYPE, top_nbr, 99, 
+                  MPI_COMM_WORLD, &(request[0]));
       }
-      MPI_Isend(top_buf_out, RADIUS*width_rank,MPI_DTYPE, top_nbr, 99, 
-                MPI_COMM_WORLD, &(request[0]));
-    }
 
-    if (bottom_nbr != -1) {
-      MPI_Irecv(bottom_buf_in,RADIUS*width_rank, MPI_DTYPE, bottom_nbr, 99, 
-                MPI_COMM_WORLD, &(request[3]));
-      for (kk=0,j=jstart_rank; j<=jstart_rank+RADIUS-1; j++) 
-      for (i=istart_rank; i<=iend_rank; i++) {
-        bottom_buf_out[kk++]= IN(i,j);
-      }
-      MPI_Isend(bottom_buf_out, RADIUS*width_rank,MPI_DTYPE, bottom_nbr, 101,
- 	  MPI_COMM_WORLD, &(request[2]));
-      }
+      if (bottom_nbr != -1) {
+        MPI_Irecv(bottom_buf_in,ghost*width_rank, MPI_DTYPE, bottom_nbr, 99, 
+                  MPI_COMM_WORLD, &(request[3]));
+        for (kk=0,j=jstart_rank; j<=jstart_rank+ghost-1; j++) 
+        for (i=istart_rank; i<=iend_rank; i++) {
+          bottom_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(bottom_buf_out, ghost*width_rank,MPI_DTYPE, bottom_nbr, 101,
+ 	    MPI_COMM_WORLD, &(request[2]));
+        }
 
-    if (top_nbr != -1) {
-      MPI_Wait(&(request[0]), &(status[0]));
-      MPI_Wait(&(request[1]), &(status[1]));
-      for (kk=0,j=jend_rank+1; j<=jend_rank+RADIUS; j++) 
-      for (i=istart_rank; i<=iend_rank; i++) {
-        IN(i,j) = top_buf_in[kk++];
+      if (top_nbr != -1) {
+        MPI_Wait(&(request[0]), &(status[0]));
+        MPI_Wait(&(request[1]), &(status[1]));
+        for (kk=0,j=jend_rank+1; j<=jend_rank+ghost; j++) 
+        for (i=istart_rank; i<=iend_rank; i++) {
+          IN(i,j) = top_buf_in[kk++];
+        }
       }
-    }
 
-    if (bottom_nbr != -1) {    
-      MPI_Wait(&(request[2]), &(status[2]));
-      MPI_Wait(&(request[3]), &(status[3]));
-      for (kk=0,j=jstart_rank-RADIUS; j<=jstart_rank-1; j++) 
-      for (i=istart_rank; i<=iend_rank; i++) {
-        IN(i,j) = bottom_buf_in[kk++];
+      if (bottom_nbr != -1) {    
+        MPI_Wait(&(request[2]), &(status[2]));
+        MPI_Wait(&(request[3]), &(status[3]));
+        for (kk=0,j=jstart_rank-ghost; j<=jstart_rank-1; j++) 
+        for (i=istart_rank; i<=iend_rank; i++) {
+          IN(i,j) = bottom_buf_in[kk++];
+        }
       }
-    }
 
-    /* LOAD/STORE FENCE */
-    MPI_Win_sync(shm_win_in);
+      /* LOAD/STORE FENCE */
+      MPI_Win_sync(shm_win_in);
 
-    /* need to fetch ghost point data from neighbors in x-direction                 */
-    if (right_nbr != -1) {
-      MPI_Irecv(right_buf_in, RADIUS*height_rank, MPI_DTYPE, right_nbr, 1010,
-                MPI_COMM_WORLD, &(request[1+4]));
-      for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
-      for (i=iend_rank-RADIUS+1; i<=iend_rank; i++) {
-        right_buf_out[kk++]= IN(i,j);
+      /* need to fetch ghost point data from neighbors in x-direction               */
+      if (right_nbr != -1) {
+        MPI_Irecv(right_buf_in, ghost*height_rank, MPI_DTYPE, right_nbr, 1010,
+                  MPI_COMM_WORLD, &(request[1+4]));
+        for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
+        for (i=iend_rank-ghost+1; i<=iend_rank; i++) {
+          right_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(right_buf_out, ghost*height_rank, MPI_DTYPE, right_nbr, 990, 
+                  MPI_COMM_WORLD, &(request[0+4]));
       }
-      MPI_Isend(right_buf_out, RADIUS*height_rank, MPI_DTYPE, right_nbr, 990, 
-                MPI_COMM_WORLD, &(request[0+4]));
-    }
 
-    if (left_nbr != -1) {
-      MPI_Irecv(left_buf_in, RADIUS*height_rank, MPI_DTYPE, left_nbr, 990, 
-                MPI_COMM_WORLD, &(request[3+4]));
-      for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
-      for (i=istart_rank; i<=istart_rank+RADIUS-1; i++) {
-        left_buf_out[kk++]= IN(i,j);
+      if (left_nbr != -1) {
+        MPI_Irecv(left_buf_in, ghost*height_rank, MPI_DTYPE, left_nbr, 990, 
+                  MPI_COMM_WORLD, &(request[3+4]));
+        for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
+        for (i=istart_rank; i<=istart_rank+ghost-1; i++) {
+          left_buf_out[kk++]= IN(i,j);
+        }
+        MPI_Isend(left_buf_out, ghost*height_rank, MPI_DTYPE, left_nbr, 1010,
+                  MPI_COMM_WORLD, &(request[2+4]));
       }
-      MPI_Isend(left_buf_out, RADIUS*height_rank, MPI_DTYPE, left_nbr, 1010,
-                MPI_COMM_WORLD, &(request[2+4]));
-    }
 
-    if (right_nbr != -1) {
-      MPI_Wait(&(request[0+4]), &(status[0+4]));
-      MPI_Wait(&(request[1+4]), &(status[1+4]));
-      for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
-      for (i=iend_rank+1; i<=iend_rank+RADIUS; i++) {
-        IN(i,j) = right_buf_in[kk++];
+      if (right_nbr != -1) {
+        MPI_Wait(&(request[0+4]), &(status[0+4]));
+        MPI_Wait(&(request[1+4]), &(status[1+4]));
+        for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
+        for (i=iend_rank+1; i<=iend_rank+ghost; i++) {
+          IN(i,j) = right_buf_in[kk++];
+        }
       }
-    }
 
-    if (left_nbr != -1) {
-      MPI_Wait(&(request[2+4]), &(status[2+4]));
-      MPI_Wait(&(request[3+4]), &(status[3+4]));
-      for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
-      for (i=istart_rank-RADIUS; i<=istart_rank-1; i++) {
-        IN(i,j) = left_buf_in[kk++];
+      if (left_nbr != -1) {
+        MPI_Wait(&(request[2+4]), &(status[2+4]));
+        MPI_Wait(&(request[3+4]), &(status[3+4]));
+        for (kk=0,j=jstart_rank; j<=jend_rank; j++) 
+        for (i=istart_rank-ghost; i<=istart_rank-1; i++) {
+          IN(i,j) = left_buf_in[kk++];
+        }
       }
-    }
 
-    /* LOAD/STORE FENCE */
-    MPI_Win_sync(shm_win_in);
+      /* LOAD/STORE FENCE */
+      MPI_Win_sync(shm_win_in);
+    }
 
     /* Apply the stencil operator */
     for (j=MAX(jstart_rank,RADIUS); j<=MIN(n-RADIUS-1,jend_rank); j++) {
@@ -668,36 +781,55 @@ int main(int argc, char ** argv) {
     /* LOAD/STORE FENCE */
     MPI_Win_sync(shm_win_out);
 
+    if (use_flags) 
+      flag_sync(flags, flag_win, shm_ID, local_nbr, num_local_nbrs, ++sync_count);
+    else {
 #if LOCAL_BARRIER_SYNCH
-    MPI_Barrier(shm_comm); // needed to avoid writing IN while other ranks are reading it
+      MPI_Barrier(shm_comm); // needed to avoid writing IN while other ranks are reading it
 #else
-    for (i=0; i<num_local_nbrs; i++) {
-      MPI_Irecv(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm, &(request[i]));
-      MPI_Send(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm);
-    }
-    MPI_Waitall(num_local_nbrs, request, status);
+      for (i=0; i<num_local_nbrs; i++) {
+        MPI_Irecv(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm, &(request[i]));
+        MPI_Send(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm);
+      }
+      MPI_Waitall(num_local_nbrs, request, status);
 #endif
+    }
 
-    /* add constant to solution to force refresh of neighbor data, if any */
-    for (j=jstart_rank; j<=jend_rank; j++) 
+    /* add constant to solution to force refresh of neighbor data, if any; 
+       the ghost points next to the tile that are read again before the next
+       exchange receive the same update redundantly                          */
+    ext = (depth-1-iter%depth)*RADIUS;
+    for (j=jstart_rank-(bottom_nbr != -1 ? ext : 0); 
+         j<=jend_rank+(top_nbr != -1 ? ext : 0); j++) 
     for (i=istart_rank; i<=iend_rank; i++) IN(i,j)+= 1.0;
+    if (ext > 0) for (j=jstart_rank; j<=jend_rank; j++) {
+      if (left_nbr != -1)  for (i=istart_rank-ext; i<istart_rank; i++) IN(i,j)+= 1.0;
+      if (right_nbr != -1) for (i=iend_rank+1; i<=iend_rank+ext; i++)  IN(i,j)+= 1.0;
+    }
 
     /* LOAD/STORE FENCE */
     MPI_Win_sync(shm_win_in);
 
+    if (use_flags) {
+      flag_sync(flags, flag_win, shm_ID, local_nbr, num_local_nbrs, ++sync_count);
+      MPI_Win_sync(shm_win_in);
+    }
+    else {
 #if LOCAL_BARRIER_SYNCH
-    MPI_Barrier(shm_comm); // needed to avoid reading IN while other ranks are writing it
+      MPI_Barrier(shm_comm); // needed to avoid reading IN while other ranks are writing it
 #else
-    for (i=0; i<num_local_nbrs; i++) {
-      MPI_Irecv(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm, &(request[i]));
-      MPI_Send(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm);
-    }
-    MPI_Waitall(num_local_nbrs, request, status);
+      for (i=0; i<num_local_nbrs; i++) {
+        MPI_Irecv(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm, &(request[i]));
+        MPI_Send(&dummy, 0, MPI_INT, local_nbr[i], 666, shm_comm);
+      }
+      MPI_Waitall(num_local_nbrs, request, status);
 #endif
+    }
  
   } /* end of iterations                                                   */
  
-  local_stencil_time = wtime() - local_stencil_time;
+  prk_harness_tick(&harness);
+  local_stencil_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_stencil_time, &stencil_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
   
@@ -741,17 +873,23 @@ int main(int argc, char ** argv) {
  
   MPI_Win_unlock_all(shm_win_in);
   MPI_Win_unlock_all(shm_win_out);
+  MPI_Win_unlock_all(flag_win);
   MPI_Win_free(&shm_win_in);
   MPI_Win_free(&shm_win_out);
+  MPI_Win_free(&flag_win);
 
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
   if (my_ID == root) {
-    /* flops/stencil: 2 flops (fma) for each point in the stencil, 
-       plus one flop for the update of the input of the array        */
-    flops = (DTYPE) (2*stencil_size+1) * f_active_points;
     avgtime = stencil_time/iterations;
     printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
            1.0E-06 * flops/avgtime, avgtime);
   }
+  /* reads of IN and read-modify-writes of OUT and of all of IN */
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
  
   MPI_Finalize();
   exit(EXIT_SUCCESS);
@@ -53,7 +53,9 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_topology_bind()
          bail_out()
+         prk_harness_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, March 2006.
          - modified by Rob Van der Wijngaart, August 2006:
@@ -66,6 +68,8 @@ HISTORY: - Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_topology.h>
+#include <prk_harness.h>
 
 #define ARRAY(i,j,start,offset,width)     vector[i-start+offset+(j)*(width)]
 #define NBR_ARRAY(i,j,start,offset,width) source_ptr[i-start+offset+(j)*(width)]
@@ -78,6 +82,7 @@ int main(int argc, char ** argv)
   double local_pipeline_time, /* timing parameters                               */
          pipeline_time,
          avgtime;
+  prk_harness_t harness;/* per-iteration timing                                  */
   double epsilon =1.e-8;/* error tolerance                                       */
   double corner_val;    /* verification value at top right corner of grid        */
   int    i, j, iter, ID;/* dummies                                               */
@@ -170,6 +175,7 @@ int main(int argc, char ** argv)
   MPI_Bcast(&m, 1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&n, 1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  prk_topology_bind();
 
   start = (int *) prk_malloc(2*Num_procs*sizeof(int));
   if (!start) {
@@ -234,13 +240,16 @@ int main(int argc, char ** argv)
   for (i=start[my_ID]-offset; i<=end[my_ID]; i++) 
     ARRAY(i,0,start[my_ID],offset,width) = (double) i;
 
+  prk_harness_init(&harness, "Synch_p2p", "MPISHM", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
+
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
-    if (iter == 1) {
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_pipeline_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* execute pipeline algorithm for grid lines 1 through n-1 (skip bottom line) */
     for (j=1; j<n; j++) {
@@ -297,7 +306,8 @@ int main(int argc, char ** argv)
 
   }
 
-  local_pipeline_time = wtime() - local_pipeline_time;
+  prk_harness_tick(&harness);
+  local_pipeline_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_pipeline_time, &pipeline_time, 1, MPI_DOUBLE, MPI_MAX, final,
              MPI_COMM_WORLD);
 
@@ -330,6 +340,9 @@ int main(int argc, char ** argv)
            1.0E-06 * 2 * (double)((m-1)*(double)(n-1))/avgtime, avgtime);
   }
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * (double)((m-1)*(double)(n-1)));
+  prk_harness_finalize(&harness);
+
   MPI_Win_free(&shm_win);
   MPI_Finalize();
   exit(EXIT_SUCCESS);
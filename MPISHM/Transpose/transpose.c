@@ -45,6 +45,16 @@ USAGE:   Program inputs are the matrix order, the number of times to
 
          An optional parameter specifies the tile size used to divide the 
          individual matrix into blocks for improved cache and TLB performance. 
+
+         Each coherence domain owns one column block of the matrices and
+         exchanges one block with every other domain, sent by its root
+         rank.  By default (PRK_EXCHANGE=phased) this takes #domains-1
+         phases, each delimited by barriers of the domain.  With
+         PRK_EXCHANGE=hierarchical all ranks of a domain first pack all
+         outgoing blocks into shared memory, the roots of all domains then
+         exchange them with a single MPI_Alltoallv, and all ranks scatter
+         the received blocks, so that a transpose takes two domain
+         barriers and one message per pair of domains.
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -55,7 +65,9 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
           wtime()           Portable wall-timer interface.
+          prk_topology_bind() Optional pinning of threads and ranks.
           bail_out()        Determine global error and exit if nonzero.
+          prk_harness_*()   Per-iteration timing and results record.
 
 HISTORY: Written by Tim Mattson, April 1999.  
          Updated by Rob Van der Wijngaart, December 2005.
@@ -69,11 +81,14 @@ HISTORY: Written by Tim Mattson, April 1999.
            produce unit stride
          - changed initialization values, such that the input matrix
            elements are: A(i,j) = i+order*j
+         Added the hierarchical exchange.
          
 **********************************************************************************/
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <prk_topology.h>
+#include <prk_harness.h>
 
 #define A(i,j)        A_p[(i+istart)+order*(j)]
 #define B(i,j)        B_p[(i+istart)+order*(j)]
@@ -108,6 +123,7 @@ int main(int argc, char ** argv)
   double local_trans_time, /* timing parameters                                  */
          trans_time,
          avgtime;
+  prk_harness_t harness; /* per-iteration timing                                 */
   MPI_Status status;   /* completion status of message                           */
   MPI_Win shm_win_A;   /* Shared Memory window object                            */
   MPI_Win shm_win_B;   /* Shared Memory window object                            */
@@ -124,6 +140,11 @@ int main(int argc, char ** argv)
   int size_mul;        /* size multiplier; 0 for non-root ranks in coherence dom.*/
   size_t istart;
   MPI_Request send_req, recv_req;
+  int hierarchical=0;  /* boolean: true if one all-to-all replaces the phases    */
+  char *env;           /* value of PRK_EXCHANGE                                  */
+  MPI_Comm leader_comm;/* root ranks of all coherence domains                    */
+  int *counts, *displs;/* MPI_Alltoallv message layout                           */
+  double *Work_in_all, *Work_out_all; /* all blocks of the workspaces            */
 
 /*********************************************************************************
 ** Initialize the MPI environment
@@ -184,6 +205,16 @@ int main(int argc, char ** argv)
 
     if (argc == 5) Tile_order = atoi(*++argv);
 
+    env = getenv("PRK_EXCHANGE");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"hierarchical")) hierarchical = 1;
+      else if (strcmp(env,"phased")) {
+        printf("ERROR: PRK_EXCHANGE must be phased or hierarchical: %s\n", env);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+
     ENDOFTESTS:;
   }
   bail_out(error); 
@@ -193,6 +224,8 @@ int main(int argc, char ** argv)
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&Tile_order, 1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&group_size, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&hierarchical, 1, MPI_INT, root, MPI_COMM_WORLD);
+  prk_topology_bind();
 
   if (my_ID == root) {
     printf("Number of ranks      = %d\n", Num_procs);
@@ -202,10 +235,14 @@ int main(int argc, char ** argv)
     if ((Tile_order > 0) && (Tile_order < order))
        printf("Tile size            = %d\n", Tile_order);
     else  printf("Untiled\n");
+    if (hierarchical)
+       printf("Exchange             = hierarchical, MPI_Alltoallv of domain roots\n");
+    else {
 #if !SYNCHRONOUS
-    printf("Non-");
+      printf("Non-");
 #endif
-    printf("Blocking messages\n");
+      printf("Blocking messages\n");
+    }
   }
 
   /* Setup for Shared memory regions */
@@ -279,7 +316,8 @@ int main(int argc, char ** argv)
 
   if (Num_groups>1) {
 
-    size = Block_size*sizeof(double)*size_mul;
+    /* the hierarchical exchange stages all blocks of a column block      */
+    size = Block_size*sizeof(double)*size_mul*(hierarchical ? Num_groups : 1);
     MPI_Win_allocate_shared(size, sizeof(double),rma_winfo, shm_comm, 
                            (void *) &Work_in_p, &shm_win_Work_in);
     MPI_Win_lock_all(MPI_MODE_NOCHECK,shm_win_Work_in);
@@ -292,7 +330,7 @@ int main(int argc, char ** argv)
     bail_out(error);
 
     /* recompute memory size (overwritten by prior query                 */
-    size = Block_size*sizeof(double)*size_mul;
+    size = Block_size*sizeof(double)*size_mul*(hierarchical ? Num_groups : 1);
     MPI_Win_allocate_shared(size, sizeof(double), rma_winfo, 
                             shm_comm, (void *) &Work_out_p, &shm_win_Work_out);
     MPI_Win_lock_all(MPI_MODE_NOCHECK,shm_win_Work_out);
@@ -303,6 +341,26 @@ int main(int argc, char ** argv)
       error = 1;
     }
     bail_out(error);
+    Work_in_all  = Work_in_p;
+    Work_out_all = Work_out_p;
+  }
+
+  if (hierarchical && Num_groups>1) {
+    /* a root's rank among the roots is the sequence number of its group */
+    MPI_Comm_split(MPI_COMM_WORLD, shm_ID==0 ? 0 : MPI_UNDEFINED, group_ID,
+                   &leader_comm);
+    counts = (int *)prk_malloc(2*Num_groups*sizeof(int));
+    if (counts == NULL){
+      printf(" Error allocating space for message layout on node %d\n",my_ID);
+      error = 1;
+    }
+    bail_out(error);
+    displs = counts + Num_groups;
+    /* block p of the workspaces goes to and comes from group p          */
+    for (ID=0; ID<Num_groups; ID++) {
+      counts[ID] = ID == group_ID ? 0 : (int) Block_size;
+      displs[ID] = ID*Block_size;
+    }
   }
 
   /* Fill the original column matrix                                             */
@@ -330,13 +388,18 @@ int main(int argc, char ** argv)
   MPI_Win_sync(shm_win_B);
   MPI_Barrier(shm_comm);
 
+  prk_harness_init(&harness, "Transpose", "MPISHM", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "group_size", "%d", group_size);
+  prk_harness_param(&harness, "order", "%ld", order);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? Tile_order : 0);
+  prk_harness_param(&harness, "exchange", "%s", hierarchical ? "hierarchical" : "phased");
+
   for (iter=0; iter<=iterations; iter++) {
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      MPI_Barrier(MPI_COMM_WORLD);
-      local_trans_time = wtime();
-    }
+    if (iter == 1) MPI_Barrier(MPI_COMM_WORLD);
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* do the local transpose                                                    */
     istart = colstart; 
@@ -365,6 +428,7 @@ int main(int argc, char ** argv)
       send_to   = ((group_ID - phase + Num_groups)%Num_groups);
 
       istart = send_to*Block_order; 
+      if (hierarchical) Work_out_p = Work_out_all + send_to*Block_size;
       if (!tiling) {
         for (i=shm_ID*chunk_size; i<(shm_ID+1)*chunk_size; i++) 
           for (j=0; j<Block_order; j++){
@@ -381,6 +445,8 @@ int main(int argc, char ** argv)
                 A(it,jt) += 1.0;
 	      }
       }
+      /* the hierarchical exchange sends all blocks after the phase loop          */
+      if (hierarchical) continue;
 
       /* NEED A LOAD/STORE FENCE HERE                                            */
       MPI_Win_sync(shm_win_Work_in);
@@ -415,9 +481,33 @@ int main(int argc, char ** argv)
 
     }  /* end of phase loop  */
 
+    if (hierarchical && Num_groups>1) {
+      /* NEED A LOAD/STORE FENCE HERE                                            */
+      MPI_Win_sync(shm_win_Work_in);
+      MPI_Win_sync(shm_win_Work_out);
+      MPI_Barrier(shm_comm);
+      if (shm_ID==0)
+        MPI_Alltoallv(Work_out_all, counts, displs, MPI_DOUBLE,
+                      Work_in_all,  counts, displs, MPI_DOUBLE, leader_comm);
+      /* NEED A LOAD FENCE HERE                                                  */ 
+      MPI_Win_sync(shm_win_Work_in);
+      MPI_Win_sync(shm_win_Work_out);
+      MPI_Barrier(shm_comm);
+
+      for (phase=1; phase<Num_groups; phase++){
+        recv_from  = ((group_ID + phase)%Num_groups);
+        istart     = recv_from*Block_order; 
+        Work_in_p  = Work_in_all + recv_from*Block_size;
+        for (j=shm_ID*chunk_size; j<(shm_ID+1)*chunk_size; j++)
+          for (i=0; i<Block_order; i++) 
+            B(i,j) += Work_in(i,j);
+      }
+    }
+
   } /* end of iterations */
 
-  local_trans_time = wtime() - local_trans_time;
+  prk_harness_tick(&harness);
+  local_trans_time = prk_harness_elapsed(&harness);
   MPI_Reduce(&local_trans_time, &trans_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
 
@@ -449,6 +539,11 @@ int main(int argc, char ** argv)
 
   bail_out(error);
 
+  /* B += A^T and A += 1: two reads and two writes per element */
+  prk_harness_model(&harness, 2.0*order*order, 2.0*bytes);
+  prk_harness_report(&harness, "MB/s", 1.0E-06*bytes);
+  prk_harness_finalize(&harness);
+
   MPI_Win_unlock_all(shm_win_A);
   MPI_Win_unlock_all(shm_win_B);
 
@@ -461,6 +556,7 @@ int main(int argc, char ** argv)
       MPI_Win_free(&shm_win_Work_out);
   }
 
+  if (hierarchical && Num_groups>1 && shm_ID==0) MPI_Comm_free(&leader_comm);
   MPI_Info_free(&rma_winfo);
 
   MPI_Finalize();
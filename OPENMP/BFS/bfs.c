@@ -0,0 +1,528 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*********************************************************************************
+
+NAME:    bfs
+
+PURPOSE: This program tests the efficiency with which a breadth-first search
+         of a large, irregular graph is carried out.  Unlike the other kernels,
+         the memory accesses are data dependent: which vertices are visited
+         next, and where they are stored, follows from the graph.
+
+USAGE:   The program takes as input the number of threads, the number of
+         searches, the 2log of the number of vertices of the graph (the scale),
+         and the average number of edges per vertex (the edge factor).
+
+         <progname> <# threads> <# searches> <scale> <edge factor>
+
+         The undirected graph is a Kronecker (R-MAT) graph with the Graph 500
+         parameters A=0.57, B=0.19, C=0.19: every edge is placed by recursively
+         choosing one quadrant of the adjacency matrix, with one draw from the
+         LCG of random_draw.c per level.  The vertex labels are scrambled, so
+         that the high-degree vertices are spread over the index range.  Edge
+         e uses draws e*scale through (e+1)*scale-1 of the stream, so the MPI1
+         kernel generates the same graph.  The generation is not timed.
+
+         Every search starts from a different root vertex with at least one
+         edge, and builds a BFS tree (parent of every vertex reached) level by
+         level.  The search is direction optimizing: a level is expanded top
+         down, from a queue of frontier vertices to their unvisited
+         neighbors, until the frontier touches more than 1/14 of the edges of
+         the unvisited vertices; then levels are expanded bottom up, with
+         every unvisited vertex looking for a neighbor in a bitmap of the
+         frontier, until the frontier holds less than 1/24 of the vertices
+         and shrinks.  PRK_BFS=topdown expands all levels top down.
+
+         The output consists of diagnostics to make sure the algorithm
+         worked, and of timing statistics.  The rate is given in traversed
+         edges per second (TEPS): the number of input edges in the component
+         that was searched, divided by the search time.  The tree of the
+         last search is verified: every reached vertex has a parent one level
+         closer to the root to which it is connected, and the levels of the
+         two ends of every edge differ by at most one, and are either both
+         defined or both undefined.
+
+FUNCTIONS CALLED:
+
+         Other than OpenMP or standard C functions, the following
+         functions are used in this program:
+
+         wtime()
+         bail_out()
+         LCG_init(), LCG_next(), LCG_jump()
+         rmat_edge()
+         scramble()
+         search()
+         prk_harness_*()
+
+HISTORY: Written in October 2026.
+
+***********************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
+#include <random_draw.h>
+
+/* R-MAT quadrant probabilities; the fourth quadrant gets the remainder           */
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+
+/* direction switching thresholds (Beamer, Asanovic and Patterson)                */
+#define ALPHA  14
+#define BETA   24
+
+/* frontier vertices a thread collects before appending them to the queue         */
+#define QBUF   256
+
+#define BIT(v)       (((u64Int) 1)<<((v)&63))
+#define TEST(bm,v)   ((bm)[(v)>>6] & BIT(v))
+#define DEGREE(v)    (first[(v)+1]-first[(v)])
+
+static int     scale;         /* 2log of the number of vertices                   */
+static s64Int  n;             /* number of vertices                               */
+static s64Int  nadj;          /* number of adjacency entries (twice the edges)    */
+static s64Int  words;         /* number of words of a frontier bitmap             */
+static s64Int *first;         /* adjacency of v is adj[first[v]..first[v+1]-1]    */
+static int    *adj;           /* neighbors of all vertices                        */
+static int    *parent;        /* BFS tree, -1 for vertices not reached            */
+static int    *level;         /* distance of the reached vertices from the root   */
+static int    *queue,         /* frontier, for top-down levels                    */
+              *next_queue;
+static u64Int *front,         /* frontier, for bottom-up levels                   */
+              *next_front;
+
+/* state of the search, shared by the threads                                     */
+static s64Int  qlen, next_len;          /* frontier queue lengths                 */
+static s64Int  nf, nf_prev, nf_new;     /* frontier sizes                         */
+static s64Int  mf, mf_new, mu;          /* edges of frontier and unvisited vertices */
+static int     depth, bottom_up, convert;
+static int     levels, bottom_up_levels; /* statistics of all searches            */
+
+/* map a vertex label to a pseudo-random one; both multiplications by odd
+   numbers and the shift-xor are bijections on [0,2^scale)                        */
+static s64Int scramble(s64Int v) {
+  u64Int x = (u64Int) v, mask = (((u64Int) 1)<<scale)-1;
+  x = (x*0x9E3779B97F4A7C15ULL) & mask;
+  x ^= x>>((scale+1)/2);
+  x = (x*0xBF58476D1CE4E5B9ULL) & mask;
+  return (s64Int) x;
+}
+
+/* next edge of the LCG stream: one quadrant per level of the adjacency matrix,
+   chosen with the high bits of the draw                                          */
+static void rmat_edge(s64Int *u, s64Int *v) {
+  int    bit;
+  double r;
+  *u = *v = 0;
+  for (bit=0; bit<scale; bit++) {
+    r = (double)(LCG_next(UINT64_MAX)>>11) * 0x1.0p-53;
+    *u <<= 1; *v <<= 1;
+    if      (r >= RMAT_A+RMAT_B+RMAT_C) { *u |= 1; *v |= 1; }
+    else if (r >= RMAT_A+RMAT_B)          *u |= 1;
+    else if (r >= RMAT_A)                 *v |= 1;
+  }
+  *u = scramble(*u); *v = scramble(*v);
+}
+
+/* append the vertices in buf to next_queue                                       */
+static void flush(int *buf, int *count) {
+  s64Int pos;
+  #pragma omp atomic capture
+  { pos = next_len; next_len += *count; }
+  memcpy(next_queue+pos, buf, (*count)*sizeof(int));
+  *count = 0;
+}
+
+/* breadth-first search from root; returns the number of adjacency entries of
+   the vertices reached                                                           */
+static s64Int search(int root, int hybrid) {
+
+  s64Int traversed;
+
+  nf = 1; levels++;
+  traversed = DEGREE(root);
+
+  #pragma omp parallel
+  {
+  int    buf[QBUF], count = 0, u, w, old;
+  s64Int i, v, e;
+  u64Int word;
+
+  #pragma omp for
+  for (v=0; v<n; v++) parent[v] = -1;
+  #pragma omp single
+  {
+    parent[root] = root; level[root] = 0;
+    queue[0]  = root;    qlen = nf_prev = 1;
+    mf = DEGREE(root);   mu = nadj-mf;
+    depth = bottom_up = 0;
+  }
+
+  while (1) {
+
+    #pragma omp single
+    {
+      convert = 0;
+      if (nf > 0 && hybrid) {
+        if (!bottom_up && mf > mu/ALPHA)                        convert = 1;
+        else if (bottom_up && nf < n/BETA && nf < nf_prev)      convert = 2;
+      }
+      if (convert) bottom_up = !bottom_up;
+      next_len = nf_new = mf_new = 0;
+    }
+    if (nf == 0) break;
+
+    if (convert == 1) {
+      /* frontier queue to bitmap                                                 */
+      #pragma omp for
+      for (i=0; i<words; i++) front[i] = 0;
+      #pragma omp for
+      for (i=0; i<qlen; i++) {
+        #pragma omp atomic
+        front[queue[i]>>6] |= BIT(queue[i]);
+      }
+    }
+    else if (convert == 2) {
+      /* frontier bitmap to queue                                                 */
+      #pragma omp for
+      for (i=0; i<words; i++) for (word=front[i], u=0; word; word>>=1, u++) {
+        if (word&1) {
+          buf[count++] = (int)(64*i+u);
+          if (count == QBUF) flush(buf, &count);
+        }
+      }
+      if (count) flush(buf, &count);
+      #pragma omp barrier
+      #pragma omp single
+      {
+        int *tmp = queue; queue = next_queue; next_queue = tmp;
+        qlen = next_len; next_len = 0;
+      }
+    }
+
+    if (bottom_up) {
+      /* every unvisited vertex looks for a parent in the frontier; chunks of 256
+         vertices cover whole words of the bitmap, so no two threads share one   */
+      #pragma omp for
+      for (i=0; i<words; i++) next_front[i] = 0;
+      #pragma omp for schedule(dynamic,256) reduction(+:nf_new,mf_new)
+      for (v=0; v<n; v++) {
+        if (parent[v] >= 0) continue;
+        for (e=first[v]; e<first[v+1]; e++) {
+          w = adj[e];
+          if (TEST(front,w)) {
+            parent[v] = w;
+            level[v]  = depth+1;
+            next_front[v>>6] |= BIT(v);
+            nf_new++;
+            mf_new += DEGREE(v);
+            break;
+          }
+        }
+      }
+      #pragma omp single
+      {
+        u64Int *tmp = front; front = next_front; next_front = tmp;
+        bottom_up_levels++;
+      }
+    }
+    else {
+      /* every frontier vertex claims its unvisited neighbors; a vertex claimed
+         by several threads at once gets one of them as parent, and is queued by
+         the first                                                               */
+      #pragma omp for schedule(dynamic,64) reduction(+:mf_new)
+      for (i=0; i<qlen; i++) {
+        u = queue[i];
+        for (e=first[u]; e<first[u+1]; e++) {
+          w = adj[e];
+          #pragma omp atomic read
+          old = parent[w];
+          if (old >= 0) continue;
+          #pragma omp atomic capture
+          { old = parent[w]; parent[w] = u; }
+          if (old < 0) {
+            level[w] = depth+1;
+            mf_new  += DEGREE(w);
+            buf[count++] = w;
+            if (count == QBUF) flush(buf, &count);
+          }
+        }
+      }
+      if (count) flush(buf, &count);
+      #pragma omp barrier
+      #pragma omp single
+      {
+        int *tmp = queue; queue = next_queue; next_queue = tmp;
+        qlen = nf_new = next_len;
+      }
+    }
+
+    #pragma omp single
+    {
+      nf_prev = nf; nf = nf_new;
+      mf = mf_new;  mu -= mf_new;
+      traversed += mf_new;
+      if (nf) { depth++; levels++; }
+    }
+  }
+  } /* end of parallel region                                                     */
+
+  return traversed;
+}
+
+int main(int argc, char **argv){
+
+  int               iterations; /* number of searches                             */
+  int               iter;       /* dummy                                          */
+  int               edgefactor; /* edges per vertex                               */
+  s64Int            m;          /* number of generated edges                      */
+  s64Int            e, v, w, u; /* dummies                                        */
+  s64Int            pos;        /* dummy                                          */
+  s64Int           *src, *dst;  /* edge list                                      */
+  int              *root;       /* roots of the searches                          */
+  int               hybrid;     /* nonzero for direction-optimizing searches      */
+  char             *env;        /* value of PRK_BFS                               */
+  s64Int            traversed;  /* adjacency entries reached by all searches      */
+  s64Int            reached;    /* vertices reached by the last search            */
+  s64Int            errors;     /* number of violations of the BFS tree rules     */
+  int               found;      /* nonzero if parent is a neighbor                */
+  double            bfs_time,   /* timing parameters                              */
+                    avgtime;
+  int               nthread_input,  /* thread parameters                          */
+                    nthread;
+  int               num_error=0; /* flag that signals that requested and
+                                    obtained numbers of threads are the same      */
+  size_t            graph_space; /* variables used to hold prk_malloc sizes       */
+  prk_harness_t     harness;    /* per-iteration timing                           */
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("OpenMP breadth-first search\n");
+
+  if (argc != 5) {
+    printf("Usage: %s <# threads> <# searches> <scale> <edge factor>\n",*argv);
+    exit(EXIT_FAILURE);
+  }
+
+  /* Take number of threads to request from command line                          */
+  nthread_input = atoi(*++argv);
+
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("BFS");
+
+  iterations = atoi(*++argv);
+  if (iterations < 1){
+    printf("ERROR: Number of searches must be positive : %d \n", iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  scale = atoi(*++argv);
+  if (scale < 1 || scale > 30) {
+    printf("ERROR: Scale must be between 1 and 30: %d\n", scale);
+    exit(EXIT_FAILURE);
+  }
+  n = ((s64Int) 1)<<scale;
+
+  edgefactor = atoi(*++argv);
+  if (edgefactor < 1) {
+    printf("ERROR: Edge factor must be positive: %d\n", edgefactor);
+    exit(EXIT_FAILURE);
+  }
+  m = n*edgefactor;
+
+  env = getenv("PRK_BFS");
+  hybrid = !(env && !strcmp(env, "topdown"));
+  if (env && hybrid && strcmp(env, "hybrid")) {
+    printf("ERROR: PRK_BFS must be hybrid or topdown: %s\n", env);
+    exit(EXIT_FAILURE);
+  }
+
+  /* generate the edge list; self loops are dropped                               */
+  src  = (s64Int *) prk_malloc(2*m*sizeof(s64Int));
+  root = (int *)    prk_malloc(iterations*sizeof(int));
+  if (!src || !root) {
+    printf("ERROR: Could not allocate space for edge list: "FSTR64U"\n", m);
+    exit(EXIT_FAILURE);
+  }
+  dst = src + m;
+  LCG_init();
+  for (e=0; e<m; e++) rmat_edge(&src[e], &dst[e]);
+
+  words = (n+63)/64;
+  graph_space = (n+1)*sizeof(s64Int) + 4*n*sizeof(int) + 2*words*sizeof(u64Int);
+  first = (s64Int *) prk_malloc(graph_space);
+  if (!first) {
+    printf("ERROR: Could not allocate space for graph: %lu\n", (unsigned long) graph_space);
+    exit(EXIT_FAILURE);
+  }
+  front      = (u64Int *) (first + n+1);
+  next_front = front + words;
+  parent     = (int *) (next_front + words);
+  level      = parent + n;
+  queue      = level + n;
+  next_queue = queue + n;
+
+  prk_harness_init(&harness, "BFS", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "scale", "%d", scale);
+  prk_harness_param(&harness, "edge_factor", "%d", edgefactor);
+  prk_harness_param(&harness, "mode", "%s", hybrid ? "hybrid" : "topdown");
+
+  #pragma omp parallel private (e, v, u, pos)
+  {
+
+  #pragma omp master
+  {
+  nthread = omp_get_num_threads();
+  if (nthread != nthread_input) {
+    num_error = 1;
+    printf("ERROR: number of requested threads %d does not equal ",
+           nthread_input);
+    printf("number of spawned threads %d\n", nthread);
+  }
+  else {
+    printf("Number of threads     = %16d\n",nthread_input);
+    printf("Number of vertices    = "FSTR64U"\n", n);
+    printf("Number of edges       = "FSTR64U"\n", m);
+    printf("Number of searches    = %16d\n", iterations);
+    printf("Search mode           = %16s\n", hybrid ? "hybrid" : "topdown");
+  }
+  }
+  bail_out(num_error);
+
+  /* compressed adjacency lists of the undirected graph                           */
+  #pragma omp for
+  for (v=0; v<=n; v++) first[v] = 0;
+  #pragma omp for
+  for (e=0; e<m; e++) if (src[e] != dst[e]) {
+    #pragma omp atomic
+    first[src[e]+1]++;
+    #pragma omp atomic
+    first[dst[e]+1]++;
+  }
+  #pragma omp single
+  {
+    for (v=0; v<n; v++) first[v+1] += first[v];
+    nadj = first[n];
+    adj = (int *) prk_malloc((nadj > 0 ? nadj : 1)*sizeof(int));
+    if (!adj) {
+      printf("ERROR: Could not allocate space for adjacency lists: "FSTR64U"\n", nadj);
+      num_error = 1;
+    }
+    /* level holds the fill pointer of every list while the lists are built      */
+    for (v=0; v<n; v++) level[v] = 0;
+  }
+  bail_out(num_error);
+  #pragma omp for
+  for (e=0; e<m; e++) if (src[e] != dst[e]) {
+    u = src[e];
+    #pragma omp atomic capture
+    pos = level[u]++;
+    adj[first[u]+pos] = (int) dst[e];
+    u = dst[e];
+    #pragma omp atomic capture
+    pos = level[u]++;
+    adj[first[u]+pos] = (int) src[e];
+  }
+
+  } /* end of parallel region                                                     */
+
+  prk_free(src);
+
+  /* roots are drawn from the stream following the edges, skipping isolated
+     vertices                                                                     */
+  LCG_jump(m*scale, UINT64_MAX);
+  for (iter=0; iter<iterations; iter++) {
+    do v = scramble((s64Int) LCG_next(n)); while (nadj > 0 && DEGREE(v) == 0);
+    root[iter] = (int) v;
+  }
+
+  for (traversed=0, iter=0; iter<iterations; iter++) {
+    prk_harness_tick(&harness);
+    traversed += search(root[iter], hybrid);
+  }
+  prk_harness_tick(&harness);
+  bfs_time = prk_harness_elapsed(&harness);
+
+  /* verification test: rules of a BFS tree, for the last search                  */
+  errors = reached = 0;
+  #pragma omp parallel for private(e, w, found) reduction(+:errors,reached)
+  for (v=0; v<n; v++) {
+    if (parent[v] < 0) {
+      for (e=first[v]; e<first[v+1]; e++) if (parent[adj[e]] >= 0) errors++;
+      continue;
+    }
+    reached++;
+    if (v == root[iterations-1]) {
+      if (parent[v] != v || level[v] != 0) errors++;
+      continue;
+    }
+    for (found=0, e=first[v]; e<first[v+1]; e++) {
+      w = adj[e];
+      if (parent[w] < 0 || ABS(level[w]-level[v]) > 1) errors++;
+      if (w == parent[v] && level[w] == level[v]-1) found = 1;
+    }
+    if (!found) errors++;
+  }
+
+  if (errors) {
+    printf("ERROR: "FSTR64U" violations of the BFS tree rules\n", errors);
+    exit(EXIT_FAILURE);
+  }
+  else {
+    printf("Solution validates\n");
+#if VERBOSE
+    printf("Vertices reached by last search = "FSTR64U"\n", reached);
+    printf("Levels per search               = %lf\n", (double) levels/iterations);
+    printf("Bottom-up levels per search     = %lf\n",
+           (double) bottom_up_levels/iterations);
+#endif
+  }
+
+  /* every undirected edge of the searched component appears twice in the
+     adjacency lists                                                              */
+  avgtime = bfs_time/iterations;
+  printf("Rate (MTEPS): %lf  Avg time (s): %lf\n",
+         1.0E-06 * 0.5*traversed/bfs_time, avgtime);
+  prk_harness_report(&harness, "MTEPS", 1.0E-06 * 0.5*traversed/iterations);
+  prk_harness_finalize(&harness);
+
+  exit(EXIT_SUCCESS);
+}
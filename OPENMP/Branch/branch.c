@@ -103,6 +103,20 @@ USAGE:   The program takes as input the number of threads, the length of the
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         PRK_PREDICATE=branch|select|blend selects how the light-weight
+         loops (vector_stop, vector_go, no_vector) express their branch:
+         as an if-else (branch, the default), as a conditional expression
+         that the compiler may turn into a conditional move or vector
+         blend (select), or as an explicit bit mask that is and-ed with
+         both outcomes (blend), which has no branch to predict at all.
+
+         PRK_DISPATCH=switch|table|static selects how ins_heavy reaches
+         its matrix functions: through a switch on the loop index (switch,
+         the default), through a table of function pointers indexed by it
+         (table), which is an indirect branch, or through a loop unrolled
+         by the number of functions so that every call site names its
+         function at compile time (static), which has no dispatch at all.
+
 FUNCTIONS CALLED:
 
          Other than OpenMP or standard C functions, the following 
@@ -112,13 +126,17 @@ FUNCTIONS CALLED:
          bail_out()
          fill_vec()
          func*()
+         prk_harness_*()
 
 HISTORY: Written by Rob Van der Wijngaart, May 2006.
+         Added branch-free forms and dispatch variants.
   
 **********************************************************************************/
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
 
 /* the following values are only used as labels                                  */
 #define VECTOR_STOP       66
@@ -127,6 +145,24 @@ HISTORY: Written by Rob Van der Wijngaart, May 2006.
 #define INS_HEAVY         99
 #define WITH_BRANCHES      1
 #define WITHOUT_BRANCHES   0
+/* dispatch to the ins_heavy matrix functions; switch is WITH_BRANCHES           */
+#define WITH_TABLE         2
+#define WITH_STATIC        3
+/* forms of the light-weight branch                                              */
+#define PREDICATE_BRANCH   0
+#define PREDICATE_SELECT   1
+#define PREDICATE_BLEND    2
+
+/* branch-free forms of (c ? t : f); BLEND masks both outcomes with -(c)         */
+#define SELECT(c,t,f)      ((c) ? (t) : (f))
+#define BLEND(c,t,f)       (((t) & -(int)(c)) | ((f) & ~-(int)(c)))
+
+/* one light-weight loop with its branch in form PICK                            */
+#define PRED_LOOP(PICK,SIGN,COND,TAKEN)                                          \
+        for (i=0; i<vector_length; i++) {                                      \
+          aux = SIGN(3 - (i&7));                                               \
+          vector[i] -= 2*PICK(COND, TAKEN, aux);                               \
+        }
 
 extern int fill_vec(int *vector, int vector_length, int iterations, int branch, 
                     int *nfunc, int *rank);
@@ -139,11 +175,16 @@ int main(int argc, char ** argv)
   int      rank;            /* matrix rank used in INS_HEAVY option              */
   double   branch_time,     /* timing parameters                                 */
            no_branch_time;
+  prk_harness_t harness;    /* timing of the run with branches                   */
   double   ops;             /* double precision representation of integer ops    */
   int      iterations;      /* number of times the branch loop is carried out    */
   int      i, iter, aux;    /* dummies                                           */
   char     *branch_type;    /* string defining branching type                    */
   int      btype;           /* integer encoding branching type                   */
+  char     *predicate_name; /* form of the light-weight branch                   */
+  int      predicate;
+  char     *dispatch_name;  /* dispatch to the ins_heavy matrix functions        */
+  int      dispatch;
   int      total=0, 
            total_ref;       /* computed and stored verification values           */
   int      nthread_input;   /* thread parameters                                 */
@@ -172,6 +213,7 @@ int main(int argc, char ** argv)
   }
 
   omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("Branch");
 
   iterations = atoi(*++argv);
   if (iterations < 1 || iterations%2==1){
@@ -196,6 +238,33 @@ int main(int argc, char ** argv)
     exit(EXIT_FAILURE);
   }
 
+  predicate_name = getenv("PRK_PREDICATE");
+  if (!predicate_name) predicate_name = "branch";
+  if      (!strcmp(predicate_name,"branch")) predicate = PREDICATE_BRANCH;
+  else if (!strcmp(predicate_name,"select")) predicate = PREDICATE_SELECT;
+  else if (!strcmp(predicate_name,"blend" )) predicate = PREDICATE_BLEND;
+  else {
+    printf("ERROR: PRK_PREDICATE must be branch, select or blend: %s\n", predicate_name);
+    exit(EXIT_FAILURE);
+  }
+
+  dispatch_name = getenv("PRK_DISPATCH");
+  if (!dispatch_name) dispatch_name = "switch";
+  if      (!strcmp(dispatch_name,"switch")) dispatch = WITH_BRANCHES;
+  else if (!strcmp(dispatch_name,"table" )) dispatch = WITH_TABLE;
+  else if (!strcmp(dispatch_name,"static")) dispatch = WITH_STATIC;
+  else {
+    printf("ERROR: PRK_DISPATCH must be switch, table or static: %s\n", dispatch_name);
+    exit(EXIT_FAILURE);
+  }
+
+  prk_harness_init(&harness, "Branch", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "length", "%d", vector_length);
+  prk_harness_param(&harness, "branch_type", "%s", branch_type);
+  if (btype == INS_HEAVY) prk_harness_param(&harness, "dispatch", "%s", dispatch_name);
+  else                    prk_harness_param(&harness, "branch_form", "%s", predicate_name);
+
   #pragma omp parallel private(i, my_ID, iter, aux, nfunc, rank) reduction(+:total)
   {
   int * RESTRICT vector; int * RESTRICT index;
@@ -215,6 +284,10 @@ int main(int argc, char ** argv)
     printf("Vector length              = %d\n", vector_length);
     printf("Number of iterations       = %d\n", iterations);
     printf("Branching type             = %s\n", branch_type);
+    if (btype == INS_HEAVY)
+    printf("Dispatch                   = %s\n", dispatch_name);
+    else
+    printf("Branch form                = %s\n", predicate_name);
 #if RESTRICT_KEYWORD
     printf("No aliasing                = on\n");
 #else
@@ -248,12 +321,53 @@ int main(int argc, char ** argv)
   #pragma omp barrier   
   #pragma omp master
   {   
-  branch_time = wtime();
+  prk_harness_tick(&harness);
   }
 
   /* do actual branching */
 
-  switch (btype) {
+  if (predicate != PREDICATE_BRANCH && btype != INS_HEAVY) switch (btype) {
+
+    case VECTOR_STOP:
+      for (iter=0; iter<iterations; iter+=2) {
+        if (predicate == PREDICATE_SELECT) {
+          PRED_LOOP(SELECT, -, vector[index[i]]>0, vector[i])
+          PRED_LOOP(SELECT,  , vector[index[i]]>0, vector[i])
+        }
+        else {
+          PRED_LOOP(BLEND,  -, vector[index[i]]>0, vector[i])
+          PRED_LOOP(BLEND,   , vector[index[i]]>0, vector[i])
+        }
+      }
+      break;
+
+    case VECTOR_GO:
+      for (iter=0; iter<iterations; iter+=2) {
+        if (predicate == PREDICATE_SELECT) {
+          PRED_LOOP(SELECT, -, aux>0, vector[i])
+          PRED_LOOP(SELECT,  , aux>0, vector[i])
+        }
+        else {
+          PRED_LOOP(BLEND,  -, aux>0, vector[i])
+          PRED_LOOP(BLEND,   , aux>0, vector[i])
+        }
+      }
+      break;
+
+    case NO_VECTOR:
+      for (iter=0; iter<iterations; iter+=2) {
+        if (predicate == PREDICATE_SELECT) {
+          PRED_LOOP(SELECT, -, aux>0, vector[index[i]])
+          PRED_LOOP(SELECT,  , aux>0, vector[index[i]])
+        }
+        else {
+          PRED_LOOP(BLEND,  -, aux>0, vector[index[i]])
+          PRED_LOOP(BLEND,   , aux>0, vector[index[i]])
+        }
+      }
+      break;
+  }
+  else switch (btype) {
 
     case VECTOR_STOP:
       /* condition vector[index[i]]>0 inhibits vectorization                     */
@@ -310,11 +424,14 @@ int main(int argc, char ** argv)
       break;
 
     case INS_HEAVY:
-      fill_vec(vector, vector_length, iterations, WITH_BRANCHES, &nfunc, &rank);
+      fill_vec(vector, vector_length, iterations, dispatch, &nfunc, &rank);
     }
+    /* the threads run their iterations without synchronizing, so the master
+       thread records them as iterations of equal length                     */
     #pragma omp master
     {
-    branch_time = wtime() - branch_time;
+    prk_harness_ticks(&harness, iterations);
+    branch_time = prk_harness_elapsed(&harness);
     if (btype == INS_HEAVY) {
       printf("Number of matrix functions = %d\n", nfunc);
       printf("Matrix order               = %d\n", rank);
@@ -387,6 +504,8 @@ int main(int argc, char ** argv)
            ops/(branch_time*1.e6), branch_time);
     printf("Rate (Mops/s) without branches: %lf time (s): %lf\n", 
            ops/(no_branch_time*1.e6), no_branch_time);
+    prk_harness_report(&harness, "Mops/s", ops/iterations*1.e-6);
+    prk_harness_finalize(&harness);
 #if VERBOSE
     printf("Array sum = %d, reference value = %d\n", total, total_ref);
 #endif     
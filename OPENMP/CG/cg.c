@@ -0,0 +1,432 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*********************************************************************************
+
+NAME:    cg
+
+PURPOSE: This program tests the efficiency with which a sparse linear system
+         is solved by the conjugate gradient method.  Unlike the Sparse kernel,
+         every matrix-vector multiplication is followed by dot products whose
+         sums the next step depends on, so every iteration contains reductions
+         over all threads, as in the solvers of real applications.
+  
+USAGE:   The program takes as input the number of threads, the number of
+         conjugate gradient iterations, the 2log of the linear size of the 2D
+         grid (equalling the 2log of the square root of the order of the
+         sparse matrix), and the radius of the difference stencil.
+
+         <progname> <# threads> <# iterations> <2log root-of-matrix-order> <radius>
+
+         The matrix has the sparsity pattern of the Sparse kernel, a periodic
+         star stencil on a (scrambled) grid, with the value 4*radius+1 on the
+         diagonal and -1 elsewhere.  The rows are scrambled like the columns,
+         so the matrix is symmetric positive definite, with eigenvalues
+         between 1 and 8*radius+1.  The right hand side is the product of the
+         matrix with a known solution, and the iterations start from zero.
+
+         The matrix-vector product is fused with the dot product that follows
+         it, and the updates of the solution and the residual with the
+         residual norm, so that every iteration makes three sweeps over the
+         rows, two of which end in a reduction.
+
+         The output consists of diagnostics to make sure the algorithm
+         worked, and of timing statistics.  The solution is correct if its
+         error in the norm defined by the matrix is within the classical
+         bound 2*((sqrt(k)-1)/(sqrt(k)+1))^iterations on the reduction of the
+         error by CG, with k the condition number of the matrix.
+
+FUNCTIONS CALLED:
+
+         Other than OpenMP or standard C functions, the following 
+         functions are used in this program:
+
+         wtime()
+         bail_out()
+         reverse()
+         sort_indices()
+         prk_harness_*()
+
+HISTORY: Written in October 2026, from the matrix generator of the
+         OpenMP Sparse kernel.
+  
+***********************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
+
+/* linearize the grid index                                                       */
+#define LIN(i,j) (i+((j)<<lsize))
+
+/* if the scramble flag is set, convert all (linearized) grid indices by 
+   reversing their bits; if not, leave the grid indices alone                     */
+#if SCRAMBLE
+  #define REVERSE(a,b)  reverse((a),(b))
+#else
+  #define REVERSE(a,b) (a)
+#endif
+
+#define BITS_IN_BYTE 8
+
+/* known solution of the linear system                                            */
+#define SOLUTION(row) (1.0+(double)((row)%7))
+
+static u64Int reverse(register u64Int, int);
+static void sort_indices(s64Int *, int);
+
+int main(int argc, char **argv){
+
+  int               iter, r;    /* dummies                                        */
+  int               lsize;      /* logarithmic linear size of grid                */
+  int               lsize2;     /* logarithmic size of grid                       */
+  int               size;       /* linear size of grid                            */
+  s64Int            size2;      /* matrix order (=total # points in grid)         */
+  int               radius,     /* stencil parameters                             */
+                    stencil_size; 
+  s64Int            row, col, first, last, point; /* dummies                      */
+  u64Int            i, j;       /* dummies                                        */
+  int               iterations; /* number of CG iterations                        */
+  s64Int            elm;        /* sequence number of matrix nonzero              */
+  s64Int            nent;       /* number of nonzero entries                      */
+  double            sparsity;   /* fraction of non-zeroes in matrix               */
+  double            cg_time,    /* timing parameters                              */
+                    avgtime;
+  double * RESTRICT matrix;     /* sparse matrix entries                          */
+  s64Int * RESTRICT colIndex;   /* column indices of sparse matrix entries        */
+  double * RESTRICT x;          /* approximate solution                           */
+  double * RESTRICT res;        /* residual b-A*x                                 */
+  double * RESTRICT p;          /* search direction                               */
+  double * RESTRICT q;          /* product of the matrix and p                    */
+  double            temp;       /* temporary scalar storing a row product         */
+  double            alpha, beta; /* CG coefficients                               */
+  double            gamma,      /* residual norm squared                          */
+                    pq,         /* p^T*A*p                                        */
+                    rr;         /* new residual norm squared                      */
+  double            norm0,      /* norm of the initial error in the matrix norm   */
+                    norm,       /* same for the final error                       */
+                    kappa,      /* bound on the condition number of the matrix    */
+                    rho,        /* bound on the error reduction per iteration     */
+                    bound;      /* bound on the error reduction                   */
+  double            epsilon = 1.e-8; /* error tolerance                           */
+  int               nthread_input,  /* thread parameters                          */
+                    nthread; 
+  int               num_error=0; /* flag that signals that requested and 
+                                    obtained numbers of threads are the same      */
+  size_t            vector_space, /* variables used to hold prk_malloc sizes      */
+                    matrix_space,
+                    index_space;
+  double            flops,      /* modeled work of one iteration                  */
+                    bytes;
+  prk_harness_t     harness;    /* per-iteration timing                           */
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("OpenMP conjugate gradient solver\n");
+
+  if (argc != 5) {
+    printf("Usage: %s <# threads> <# iterations> <2log grid size> <stencil radius>\n",*argv);
+    exit(EXIT_FAILURE);
+  }
+
+  /* Take number of threads to request from command line                          */
+  nthread_input = atoi(*++argv); 
+
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("CG");
+ 
+  iterations = atoi(*++argv);
+  if (iterations < 1){
+    printf("ERROR: Iterations must be positive : %d \n", iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  lsize = atoi(*++argv);
+  lsize2 = 2*lsize;
+  size = 1<<lsize;
+  if (lsize <0) {
+    printf("ERROR: Log of grid size must be greater than or equal to zero: %d\n", 
+           (int) lsize);
+    exit(EXIT_FAILURE);
+  }
+  /* compute number of points in the grid                                         */
+  size2 = size*size;
+
+  radius = atoi(*++argv);
+  if (radius <1) {
+    printf("ERROR: Stencil radius must be positive: %d\n", radius);
+    exit(EXIT_FAILURE);
+  }
+
+  /* emit error if (periodic) stencil overlaps with itself                        */
+  if (size <2*radius+1) {
+    printf("ERROR: Grid extent %d smaller than stencil diameter 2*%d+1= %d\n",
+           size, radius, radius*2+1);
+    exit(EXIT_FAILURE);
+  }
+ 
+  /* compute total size of star stencil in 2D                                     */
+  stencil_size = 4*radius+1;
+  /* sparsity follows from number of non-zeroes per row                           */
+  sparsity = (double)(4*radius+1)/(double)size2;
+
+  /* compute total number of non-zeroes                                           */
+  nent = size2*stencil_size;
+
+  matrix_space = nent*sizeof(double);
+  matrix = (double *) prk_malloc(matrix_space);
+  if (!matrix) {
+    printf("ERROR: Could not allocate space for sparse matrix: "FSTR64U"\n", nent);
+    exit(EXIT_FAILURE);
+  } 
+
+  vector_space = 4*size2*sizeof(double);
+  x = (double *) prk_malloc(vector_space);
+  if (!x) {
+    printf("ERROR: Could not allocate space for vectors: %d\n", (int)(4*size2));
+    exit(EXIT_FAILURE);
+  }
+  res = x   + size2;
+  p   = res + size2;
+  q   = p   + size2;
+
+  index_space = nent*sizeof(s64Int);
+  colIndex = (s64Int *) prk_malloc(index_space);
+  if (!colIndex) {
+    printf("ERROR: Could not allocate column index array: "FSTR64U"\n", nent);
+    exit(EXIT_FAILURE);
+  }
+
+  prk_harness_init(&harness, "CG", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "grid_size", "%d", size);
+  prk_harness_param(&harness, "radius", "%d", radius);
+
+  #pragma omp parallel private (row, col, elm, first, last, iter, i, j, r, point, \
+                                temp, alpha, beta)
+  {
+
+  #pragma omp master 
+  {
+  nthread = omp_get_num_threads();
+  if (nthread != nthread_input) {
+    num_error = 1;
+    printf("ERROR: number of requested threads %d does not equal ",
+           nthread_input);
+    printf("number of spawned threads %d\n", nthread);
+  } 
+  else {
+    printf("Number of threads     = %16d\n",nthread_input);
+    printf("Matrix order          = "FSTR64U"\n", size2);
+    printf("Stencil diameter      = %16d\n", 2*radius+1);
+    printf("Sparsity              = %16.10lf\n", sparsity);
+    printf("Number of iterations  = %16d\n", iterations);
+#if SCRAMBLE
+    printf("Using scrambled indexing\n");
+#else
+    printf("Using canonical indexing\n");
+#endif
+  }
+  }
+  bail_out(num_error);
+
+  /* fill matrix with nonzeroes corresponding to difference stencil. Row "row"
+     belongs to the grid point that the scrambling maps to it, so that rows and
+     columns are reordered alike and the matrix stays symmetric                   */
+  #pragma omp for
+  for (row=0; row<size2; row++) {
+    point = REVERSE(row,lsize2);
+    i = point%size; j = point>>lsize;
+    elm = row*stencil_size;
+    colIndex[elm] = REVERSE(LIN(i,j),lsize2);
+    for (r=1; r<=radius; r++, elm+=4) {
+      colIndex[elm+1] = REVERSE(LIN((i+r)%size,j),lsize2);
+      colIndex[elm+2] = REVERSE(LIN((i-r+size)%size,j),lsize2);
+      colIndex[elm+3] = REVERSE(LIN(i,(j+r)%size),lsize2);
+      colIndex[elm+4] = REVERSE(LIN(i,(j-r+size)%size),lsize2);
+    }
+    /* sort colIndex to make sure the compressed row accesses
+       vector elements in increasing order                                        */
+    sort_indices(&(colIndex[row*stencil_size]), stencil_size);
+    for (elm=row*stencil_size; elm<(row+1)*stencil_size; elm++)
+      matrix[elm] = colIndex[elm] == row ? (double) stencil_size : -1.0;
+  }
+
+  /* right hand side b=A*x* in res; x*^T*A*x* is the initial error in the matrix
+     norm, since the iterations start from x=0                                    */
+  #pragma omp for
+  for (row=0; row<size2; row++) q[row] = SOLUTION(row);
+  #pragma omp single
+  gamma = norm0 = 0.0;
+  #pragma omp for reduction(+:norm0)
+  for (row=0; row<size2; row++) {
+    first = stencil_size*row; last = first+stencil_size-1;
+    for (temp=0.0,col=first; col<=last; col++) {
+      temp += matrix[col]*q[colIndex[col]];
+    }
+    res[row] = temp;
+    norm0 += q[row]*temp;
+  }
+  /* x=0, so the residual is b, and so is the first search direction              */
+  #pragma omp for reduction(+:gamma)
+  for (row=0; row<size2; row++) {
+    x[row] = 0.0;
+    p[row] = res[row];
+    gamma += res[row]*res[row];
+  }
+
+  for (iter=0; iter<iterations; iter++) {
+
+    #pragma omp master
+    prk_harness_tick(&harness);
+
+    /* q=A*p, fused with p^T*q                                                    */
+    #pragma omp single
+    pq = 0.0;
+    #pragma omp for reduction(+:pq)
+    for (row=0; row<size2; row++) {
+      first = stencil_size*row; last = first+stencil_size-1;
+      #pragma simd reduction(+:temp) 
+      for (temp=0.0,col=first; col<=last; col++) {
+        temp += matrix[col]*p[colIndex[col]];
+      }
+      q[row] = temp;
+      pq += p[row]*temp;
+    }
+    alpha = gamma > 0.0 ? gamma/pq : 0.0;
+
+    /* updates of x and of the residual, fused with the residual norm             */
+    #pragma omp single
+    rr = 0.0;
+    #pragma omp for reduction(+:rr)
+    for (row=0; row<size2; row++) {
+      x[row]   += alpha*p[row];
+      res[row] -= alpha*q[row];
+      rr += res[row]*res[row];
+    }
+    beta = gamma > 0.0 ? rr/gamma : 0.0;
+
+    #pragma omp for
+    for (row=0; row<size2; row++) p[row] = res[row] + beta*p[row];
+
+    /* every thread has read gamma before the barrier ending the loop above       */
+    #pragma omp single
+    gamma = rr;
+  } /* end of iterations                                                          */
+
+  #pragma omp barrier
+  #pragma omp master
+  {
+    prk_harness_tick(&harness);
+    cg_time = prk_harness_elapsed(&harness);
+  }
+
+  /* verification test: error x-x* in the matrix norm, against the CG bound       */
+  #pragma omp for
+  for (row=0; row<size2; row++) p[row] = x[row] - SOLUTION(row);
+  #pragma omp single
+  norm = 0.0;
+  #pragma omp for reduction(+:norm)
+  for (row=0; row<size2; row++) {
+    first = stencil_size*row; last = first+stencil_size-1;
+    for (temp=0.0,col=first; col<=last; col++) {
+      temp += matrix[col]*p[colIndex[col]];
+    }
+    norm += p[row]*temp;
+  }
+
+  } /* end of parallel region                                                     */
+
+  norm0 = sqrt(norm0);
+  norm  = sqrt(ABS(norm));
+  kappa = (double)(2*stencil_size-1);
+  rho   = (sqrt(kappa)-1.0)/(sqrt(kappa)+1.0);
+  bound = 2.0*pow(rho, iterations);
+
+  if (!(norm <= (bound+epsilon)*norm0)) {
+    printf("ERROR: Relative error = %e, bound = %e\n", norm/norm0, bound);
+    exit(EXIT_FAILURE);
+  }
+  else {
+    printf("Solution validates\n");
+#if VERBOSE
+    printf("Relative error = %e, bound = %e\n", norm/norm0, bound);
+#endif
+  }
+
+  /* multiplication with a multiply-add per nonzero, two dot products and three
+     vector updates per row; every nonzero reads a value and an index, and
+     every sweep over the rows reads and writes the vectors once            */
+  flops = 2.0*nent + 10.0*size2;
+  bytes = (sizeof(double)+sizeof(s64Int))*(double)nent + sizeof(double)*13.0*size2;
+  avgtime = cg_time/iterations;
+  printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
+         1.0E-06 * flops/avgtime, avgtime);
+  prk_harness_model(&harness, flops, bytes);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
+
+  exit(EXIT_SUCCESS);
+}
+
+/* Code below reverses bits in unsigned integer stored in a 64-bit word.
+   Bit reversal is with respect to the largest integer that is going to be
+   ranked for the particular run of the code, to make sure the reversal
+   constitutes a true permutation. Hence, the final result needs to be shifted 
+   to the right (see the Sparse kernel for an example)                            */
+u64Int reverse(register u64Int x, int shift_in_bits){ 
+  x = ((x >> 1)  & 0x5555555555555555) | ((x << 1)  & 0xaaaaaaaaaaaaaaaa);
+  x = ((x >> 2)  & 0x3333333333333333) | ((x << 2)  & 0xcccccccccccccccc);
+  x = ((x >> 4)  & 0x0f0f0f0f0f0f0f0f) | ((x << 4)  & 0xf0f0f0f0f0f0f0f0);
+  x = ((x >> 8)  & 0x00ff00ff00ff00ff) | ((x << 8)  & 0xff00ff00ff00ff00);
+  x = ((x >> 16) & 0x0000ffff0000ffff) | ((x << 16) & 0xffff0000ffff0000);
+  x = ((x >> 32) & 0x00000000ffffffff) | ((x << 32) & 0xffffffff00000000);
+  return (x>>((sizeof(u64Int)*BITS_IN_BYTE-shift_in_bits)));
+}
+
+/* Sort the n column indices of one row in increasing order with an insertion
+   sort, which beats qsort on the 4*radius+1 entries of a row             */
+void sort_indices(s64Int *index, int n) {
+  int    i, j;
+  s64Int v;
+
+  for (i=1; i<n; i++) {
+    v = index[i];
+    for (j=i; j>0 && index[j-1]>v; j--) index[j] = index[j-1];
+    index[j] = v;
+  }
+}
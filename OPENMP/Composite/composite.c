@@ -0,0 +1,563 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    Composite
+
+PURPOSE: This program measures how kernels degrade each other when they
+         are interleaved, as in an application that alternates stencil
+         sweeps, transposes and sparse matrix-vector products on the
+         same caches and memory.  Every iteration runs a sequence of
+         stages, each one iteration of the Stencil, Transpose or Sparse
+         kernel, and the time of every stage is compared with the time
+         of the same stage run on its own.
+
+USAGE:   The program takes as input the number of threads, the number of
+         iterations, the base 2 log of the linear grid dimension and,
+         optionally, the sequence of stages
+
+               <progname> <# threads> <# iterations> <log2 grid size> [<sequence>]
+
+         The sequence is a comma separated list of stencil, transpose
+         and sparse, each at most once; the default is
+         stencil,transpose,sparse.  With n = 2^<log2 grid size>, the
+         stencil stage sweeps an n x n grid with a star stencil of radius
+         RADIUS, the transpose stage transposes an n x n matrix in tiles
+         of TILE x TILE, and the sparse stage multiplies the matrix of
+         order n^2 of the RADIUS difference stencil (periodic, natural
+         ordering) with a vector.
+
+         All buffers are carved out of one pool allocated before any
+         timing and first touched by the threads that use them.  Each
+         stage is first run alone for all iterations (standalone), then
+         all stages are run back to back in every iteration (composite);
+         each stage is validated after both runs.
+
+         The output consists of diagnostics to make sure the
+         algorithm worked, and of timing statistics: for every stage the
+         standalone and composite rates and the slowdown, the ratio of
+         the composite to the standalone time, and for the sequence the
+         ratio of the composite time to the sum of the standalone times.
+
+FUNCTIONS CALLED:
+
+         Other than OpenMP or standard C functions, the following
+         functions are used in this program:
+
+         wtime()
+         prk_topology_bind()
+         bail_out()
+         prk_harness_*()
+         prk_phase_*()
+
+HISTORY: - Written in October 2026, following OPENMP/Stencil, OPENMP/Transpose
+           and OPENMP/Sparse.
+
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
+#include <prk_sweep.h>
+
+#define COEFX   1.0
+#define COEFY   1.0
+#define EPSILON 1.e-8
+#define TILE    32
+
+/* define shorthand for indexing multi-dimensional arrays                        */
+#define IN(i,j)       in[i+(j)*n]
+#define OUT(i,j)      out[i+(j)*n]
+#define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+#define A(i,j)        A[i+(j)*n]
+#define B(i,j)        B[i+(j)*n]
+
+enum {STENCIL, TRANSPOSE, SPARSE, NSTAGES};
+static const char * stage_names[NSTAGES] = {"stencil", "transpose", "sparse"};
+
+/* problem size and the buffers of every stage, carved out of one pool           */
+static long     n;                    /* linear grid dimension                   */
+static long     size2;                /* n*n, matrix order of the sparse stage   */
+static int      stencil_size;         /* points in the stencil (and matrix row)  */
+static double   weight[2*RADIUS+1][2*RADIUS+1];
+static double * RESTRICT in;          /* stencil input and output grids          */
+static double * RESTRICT out;
+static double * RESTRICT A;           /* transpose source and destination        */
+static double * RESTRICT B;
+static double * RESTRICT matrix;      /* sparse matrix values ...                */
+static s64Int * RESTRICT colIndex;    /* ... and column indices                  */
+static double * RESTRICT vector;      /* sparse input and result vectors         */
+static double * RESTRICT result;
+
+static void   init_stage(int);
+static void   run_stage(int);
+static double check_stage(int, int);
+static double stage_work(int);
+static double stage_bytes(int);
+
+int main(int argc, char ** argv) {
+
+  int    nthread_input,   /* thread parameters                                   */
+         nthread;
+  int    iterations;      /* number of times to run the sequence                 */
+  int    lsize;           /* logarithmic linear size of grid                     */
+  int    iter, s, k;      /* dummies                                             */
+  int    sequence[NSTAGES], nstages; /* stages in the order they run             */
+  char   sequence_string[64];
+  char   *list, *name;    /* sequence argument and one stage name in it          */
+  int    num_error=0;     /* flag that signals that requested and obtained
+                             numbers of threads are the same                     */
+  size_t pool_length,     /* doubles (or indices) in the buffer pool             */
+         grid_length, index_length;
+  double *pool;           /* all buffers                                         */
+  prk_harness_t harness;  /* per-iteration timing of the composite sequence      */
+  prk_phase_t solo[NSTAGES], /* timing of every stage run alone ...              */
+         mixed[NSTAGES];  /* ... and interleaved with the others                 */
+  double standalone_sum,  /* sum of the standalone times of the stages           */
+         composite_time;  /* time of the composite run                           */
+  double error, flops, bytes;
+  int    errors = 0;
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("OpenMP composite workload\n");
+
+  /*******************************************************************************
+  ** process and test input parameters
+  ********************************************************************************/
+
+  if (argc != 4 && argc != 5){
+    printf("Usage: %s <# threads> <# iterations> <log2 grid size> [<sequence>]\n",
+           *argv);
+    return(EXIT_FAILURE);
+  }
+
+  /* Take number of threads to request from command line */
+  nthread_input = atoi(*++argv);
+
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("Composite");
+  prk_topology_bind();
+
+  iterations  = atoi(*++argv);
+  if (iterations < 1){
+    printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  lsize = atoi(*++argv);
+  if (lsize < 1 || lsize > 24) {
+    printf("ERROR: Log of grid size must be between 1 and 24: %d\n", lsize);
+    exit(EXIT_FAILURE);
+  }
+  n     = 1L<<lsize;
+  size2 = n*n;
+
+  if (RADIUS < 1) {
+    printf("ERROR: Stencil radius %d should be positive\n", RADIUS);
+    exit(EXIT_FAILURE);
+  }
+
+  if (2*RADIUS +1 > n) {
+    printf("ERROR: Stencil radius %d exceeds grid size %ld\n", RADIUS, n);
+    exit(EXIT_FAILURE);
+  }
+
+  list = (argc == 5) ? *++argv : "stencil,transpose,sparse";
+  if (strlen(list) >= sizeof(sequence_string)) {
+    printf("ERROR: sequence too long: %s\n", list);
+    exit(EXIT_FAILURE);
+  }
+  strcpy(sequence_string, list);
+  nstages = 0;
+  for (name=strtok(sequence_string, ","); name; name=strtok(NULL, ",")) {
+    for (s=0; s<NSTAGES; s++) if (!strcmp(name, stage_names[s])) break;
+    if (s == NSTAGES) {
+      printf("ERROR: unknown stage %s; use stencil, transpose or sparse\n", name);
+      exit(EXIT_FAILURE);
+    }
+    for (k=0; k<nstages; k++) if (sequence[k] == s) {
+      printf("ERROR: stage %s appears more than once\n", name);
+      exit(EXIT_FAILURE);
+    }
+    sequence[nstages++] = s;
+  }
+  if (nstages == 0) {
+    printf("ERROR: empty sequence\n");
+    exit(EXIT_FAILURE);
+  }
+  strcpy(sequence_string, list);
+
+  /* grids of the stencil and transpose stages, vectors and matrix of the
+     sparse stage; every buffer starts on a cache line                          */
+  stencil_size = 4*RADIUS+1;
+  grid_length  = (size2+7)/8*8;
+  index_length = (size2*stencil_size+7)/8*8;
+  pool_length  = 6*grid_length + 2*index_length;
+  if ((pool_length*sizeof(double))/sizeof(double) != pool_length) {
+    printf("ERROR: Space for grid of size %ld cannot be represented\n", n);
+    exit(EXIT_FAILURE);
+  }
+  pool = (double *) prk_malloc(pool_length*sizeof(double));
+  if (!pool) {
+    printf("ERROR: Could not allocate space for buffers: %zu bytes\n",
+           pool_length*sizeof(double));
+    exit(EXIT_FAILURE);
+  }
+  in       = pool;
+  out      = in     + grid_length;
+  A        = out    + grid_length;
+  B        = A      + grid_length;
+  vector   = B      + grid_length;
+  result   = vector + grid_length;
+  matrix   = result + grid_length;
+  colIndex = (s64Int *) (matrix + index_length);
+
+  /* fill the stencil weights to reflect a discrete divergence operator         */
+  for (s=-RADIUS; s<=RADIUS; s++) for (k=-RADIUS; k<=RADIUS; k++)
+    WEIGHT(s,k) = 0.0;
+  for (s=1; s<=RADIUS; s++) {
+    WEIGHT(0, s) = WEIGHT( s,0) =  (1.0/(2.0*s*RADIUS));
+    WEIGHT(0,-s) = WEIGHT(-s,0) = -(1.0/(2.0*s*RADIUS));
+  }
+
+  #pragma omp parallel
+  {
+  #pragma omp master
+  {
+  nthread = omp_get_num_threads();
+
+  if (nthread != nthread_input) {
+    num_error = 1;
+    printf("ERROR: number of requested threads %d does not equal ",
+           nthread_input);
+    printf("number of spawned threads %d\n", nthread);
+  }
+  else {
+    printf("Number of threads    = %d\n", nthread_input);
+    printf("Grid size            = %ld\n", n);
+    printf("Radius of stencil    = %d\n", RADIUS);
+    printf("Sequence             = %s\n", sequence_string);
+    printf("Number of iterations = %d\n", iterations);
+  }
+  }
+  bail_out(num_error);
+  }
+
+  prk_harness_init(&harness, "Composite", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "grid_size", "%ld", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "sequence", "%s", sequence_string);
+
+  for (s=0; s<NSTAGES; s++) {
+    prk_phase_init(&solo[s],  stage_names[s]);
+    prk_phase_init(&mixed[s], stage_names[s]);
+  }
+
+  /*******************************************************************************
+  ** standalone runs: every stage on its own, after a warmup iteration
+  ********************************************************************************/
+
+  for (k=0; k<nstages; k++) {
+    s = sequence[k];
+    #pragma omp parallel private(iter)
+    {
+    init_stage(s);
+    for (iter=0; iter<=iterations; iter++) {
+      #pragma omp barrier
+      #pragma omp master
+      if (iter > 0) prk_phase_begin(&solo[s]);
+      run_stage(s);
+      #pragma omp barrier
+      #pragma omp master
+      if (iter > 0) prk_phase_end(&solo[s]);
+    }
+    }
+    error = check_stage(s, iterations);
+    if (error > EPSILON) {
+      printf("ERROR: standalone %s failed validation: %e\n", stage_names[s], error);
+      errors++;
+    }
+  }
+
+  /*******************************************************************************
+  ** composite run: all stages back to back in every iteration
+  ********************************************************************************/
+
+  #pragma omp parallel private(iter, k)
+  {
+  for (k=0; k<nstages; k++) init_stage(sequence[k]);
+  for (iter=0; iter<=iterations; iter++) {
+
+    /* time every iteration after a warmup iteration                            */
+    if (iter >= 1) {
+      #pragma omp barrier
+      #pragma omp master
+      {
+        prk_harness_tick(&harness);
+      }
+    }
+
+    for (k=0; k<nstages; k++) {
+      #pragma omp master
+      if (iter > 0) prk_phase_begin(&mixed[sequence[k]]);
+      run_stage(sequence[k]);
+      #pragma omp barrier
+      #pragma omp master
+      if (iter > 0) prk_phase_end(&mixed[sequence[k]]);
+    }
+  }
+
+  #pragma omp barrier
+  #pragma omp master
+  {
+    prk_harness_tick(&harness);
+    composite_time = prk_harness_elapsed(&harness);
+  }
+  } /* end of OPENMP parallel region                                             */
+
+  for (k=0; k<nstages; k++) {
+    s = sequence[k];
+    error = check_stage(s, iterations);
+    if (error > EPSILON) {
+      printf("ERROR: composite %s failed validation: %e\n", stage_names[s], error);
+      errors++;
+    }
+  }
+
+  prk_free(pool);
+
+  /*******************************************************************************
+  ** Analyze and output results.
+  ********************************************************************************/
+
+  if (errors) exit(EXIT_FAILURE);
+  printf("Solution validates\n");
+
+  printf("Stage        Standalone rate   Composite rate    Units      Slowdown\n");
+  standalone_sum = 0.0;
+  flops = bytes = 0.0;
+  for (k=0; k<nstages; k++) {
+    s = sequence[k];
+    standalone_sum += solo[s].total;
+    flops += s == TRANSPOSE ? 0.0 : stage_work(s);
+    bytes += stage_bytes(s);
+    printf("%-12s %16lf %16lf   %-10s %8lf\n", stage_names[s],
+           1.0E-06 * stage_work(s)*iterations/solo[s].total,
+           1.0E-06 * stage_work(s)*iterations/mixed[s].total,
+           s == TRANSPOSE ? "MB/s" : "MFlops/s", mixed[s].total/solo[s].total);
+  }
+#if VERBOSE
+  for (k=0; k<nstages; k++) prk_phase_report(&mixed[sequence[k]]);
+#endif
+  printf("Composite time / sum of standalone times: %lf\n",
+         composite_time/standalone_sum);
+  printf("Avg time (s) per sequence: composite %lf  standalone %lf\n",
+         composite_time/iterations, standalone_sum/iterations);
+
+  prk_harness_model(&harness, flops, bytes);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
+
+  exit(EXIT_SUCCESS);
+}
+
+/* insertion sort of the column indices of one matrix row                         */
+
+static void sort_indices(s64Int *index, int length) {
+  int    i, j;
+  s64Int key;
+  for (i=1; i<length; i++) {
+    key = index[i];
+    for (j=i-1; j>=0 && index[j]>key; j--) index[j+1] = index[j];
+    index[j+1] = key;
+  }
+}
+
+/* function that sets up the buffers of a stage in the same order in which
+   the stage visits them; it must be called by all threads of a parallel
+   region                                                                   */
+
+static void init_stage(int stage) {
+
+  long i, j, it, jt, row, elm;
+  int  r;
+
+  switch (stage) {
+  case STENCIL:
+    #pragma omp for
+    for (j=0; j<n; j++) for (i=0; i<n; i++) {
+      IN(i,j)  = COEFX*i+COEFY*j;
+      OUT(i,j) = 0.0;
+    }
+    break;
+  case TRANSPOSE:
+    #pragma omp for
+    for (j=0; j<n; j+=TILE) for (i=0; i<n; i+=TILE)
+      for (jt=j; jt<MIN(n,j+TILE); jt++) for (it=i; it<MIN(n,i+TILE); it++) {
+        A(it,jt) = (double) (n*jt + it);
+        B(it,jt) = 0.0;
+      }
+    break;
+  case SPARSE:
+    #pragma omp for private(i, j, r, elm)
+    for (row=0; row<size2; row++) {
+      j = row/n; i = row%n;
+      elm = row*stencil_size;
+      colIndex[elm] = i+j*n;
+      for (r=1; r<=RADIUS; r++, elm+=4) {
+        colIndex[elm+1] = (i+r)%n       + j*n;
+        colIndex[elm+2] = (i-r+n)%n     + j*n;
+        colIndex[elm+3] = i + ((j+r)%n)*n;
+        colIndex[elm+4] = i + ((j-r+n)%n)*n;
+      }
+      sort_indices(&colIndex[row*stencil_size], stencil_size);
+      for (elm=row*stencil_size; elm<(row+1)*stencil_size; elm++)
+        matrix[elm] = 1.0/(double)(colIndex[elm]+1);
+      vector[row] = result[row] = 0.0;
+    }
+    break;
+  }
+}
+
+/* function that runs one iteration of a stage; it must be called by all
+   threads of a parallel region                                             */
+
+static void run_stage(int stage) {
+
+  long   i, j, it, jt, row, elm;
+  int    ii, jj;
+  double temp;
+
+  switch (stage) {
+  case STENCIL:
+    #pragma omp for
+    for (j=RADIUS; j<n-RADIUS; j++) {
+      for (i=RADIUS; i<n-RADIUS; i++) {
+        for (jj=-RADIUS; jj<=RADIUS; jj++) OUT(i,j) += WEIGHT(0,jj)*IN(i,j+jj);
+        for (ii=-RADIUS; ii<0; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
+        for (ii=1; ii<=RADIUS; ii++)       OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
+      }
+    }
+    /* add constant to solution to force refresh of neighbor data, if any       */
+    #pragma omp for
+    for (j=0; j<n; j++) for (i=0; i<n; i++) IN(i,j) += 1.0;
+    break;
+  case TRANSPOSE:
+    #pragma omp for
+    for (i=0; i<n; i+=TILE) for (j=0; j<n; j+=TILE)
+      for (it=i; it<MIN(n,i+TILE); it++) for (jt=j; jt<MIN(n,j+TILE); jt++) {
+        B(jt,it) += A(it,jt);
+        A(it,jt) += 1.0;
+      }
+    break;
+  case SPARSE:
+    /* fill vector                                                              */
+    #pragma omp for
+    for (row=0; row<size2; row++) vector[row] += (double) (row+1);
+    #pragma omp for private(elm, temp)
+    for (row=0; row<size2; row++) {
+      temp = 0.0;
+      for (elm=row*stencil_size; elm<(row+1)*stencil_size; elm++)
+        temp += matrix[elm]*vector[colIndex[elm]];
+      result[row] += temp;
+    }
+    break;
+  }
+}
+
+/* function that returns the error of a stage after iterations+1 iterations,
+   scaled so that it can be compared with EPSILON                           */
+
+static double check_stage(int stage, int iterations) {
+
+  long   i, j, row;
+  double norm = 0.0, reference, addit;
+
+  switch (stage) {
+  case STENCIL:
+    #pragma omp parallel for private(i) reduction(+:norm)
+    for (j=RADIUS; j<n-RADIUS; j++) for (i=RADIUS; i<n-RADIUS; i++)
+      norm += ABS(OUT(i,j));
+    norm /= (double) (n-2*RADIUS)*(double) (n-2*RADIUS);
+    reference = (double) (iterations+1) * (COEFX + COEFY);
+    return ABS(norm-reference);
+  case TRANSPOSE:
+    addit = ((double)(iterations+1) * (double) (iterations))/2.0;
+    #pragma omp parallel for private(i) reduction(+:norm)
+    for (j=0; j<n; j++) for (i=0; i<n; i++)
+      norm += ABS(B(i,j) - ((i*n + j)*(iterations+1.0)+addit));
+    return norm;
+  case SPARSE:
+    #pragma omp parallel for reduction(+:norm)
+    for (row=0; row<size2; row++) norm += result[row];
+    reference = 0.5 * (double) size2*stencil_size * (double) (iterations+1) *
+                      (double) (iterations+2);
+    return ABS(norm-reference);
+  }
+  return 0.0;
+}
+
+/* flops (bytes for the transpose) of one iteration of a stage, as reported
+   by the standalone kernel                                                 */
+
+static double stage_work(int stage) {
+  double active = (double) (n-2*RADIUS)*(double) (n-2*RADIUS);
+  switch (stage) {
+  case STENCIL:   return (2.0*stencil_size+1.0)*active;
+  case TRANSPOSE: return 2.0*sizeof(double)*size2;
+  case SPARSE:    return 2.0*size2*stencil_size;
+  }
+  return 0.0;
+}
+
+/* modeled bytes moved to and from memory in one iteration of a stage       */
+
+static double stage_bytes(int stage) {
+  double active = (double) (n-2*RADIUS)*(double) (n-2*RADIUS);
+  switch (stage) {
+  /* reads of IN and read-modify-writes of OUT and of all of IN              */
+  case STENCIL:   return sizeof(double)*(3.0*size2+2.0*active);
+  /* read-modify-writes of A and B                                           */
+  case TRANSPOSE: return 4.0*sizeof(double)*size2;
+  /* matrix and indices, and read-modify-writes of vector and result         */
+  case SPARSE:    return (sizeof(double)+sizeof(s64Int))*size2*stencil_size +
+                         4.0*sizeof(double)*size2;
+  }
+  return 0.0;
+}
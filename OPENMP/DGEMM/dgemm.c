@@ -43,7 +43,60 @@ USAGE:   The program takes as input the number of threads, the matrix
          blocking
 
          <progname> <# threads> <# iterations> <matrix order> [<tile size>]
+
+         The matrix order may also be given as a shape MxNxK, for the
+         product of an M x K matrix A and a K x N matrix B.
   
+         If the tile size is omitted and PRK_AUTOTUNE is set, tile size
+         and tile padding (BOFFSET) are chosen by timing trial
+         multiplications (see prk_autotune.h).
+
+         With PRK_DGEMM=packed the tiles are replaced by the packed,
+         register-blocked multiplication of prk_dgemm_simd.h: blocks of
+         A and B are copied into contiguous micro-panels that a
+         vectorized micro-kernel (AVX-512 or AVX2 with FMA, selected
+         from the CPU and PRK_SIMD) multiplies in registers.  Threads
+         share out panels of columns of C, no wider than the cache
+         blocking NC (PRK_DGEMM_BLOCKING=mc,kc,nc) and narrow enough
+         that every thread gets one.  The tile size is then ignored.
+         The default is PRK_DGEMM=tiled.
+
+         When built with CBLAS=1, the program afterwards repeats the
+         same iterations with cblas_dgemm of a vendor BLAS (OpenBLAS,
+         BLIS, ...), validates that result against the same checksum and
+         reports its rate and the ratio of the two rates.  PRK_BLAS=off
+         skips the comparison at run time.
+
+         PRK_PRECISION=single|half|complex selects another element type
+         for the tiled multiplication (the default is double): SGEMM in
+         float, half-precision inputs (_Float16, where the compiler
+         supports it) with float accumulation, and ZGEMM in double
+         complex.  All are instantiations of dgemm_kernel.incl.  The
+         verification uses the inputs as rounded to the element type,
+         and sums formed in float are checked to within
+         (K+iterations+1) float epsilons.  The packed multiplication,
+         autotuning and the vendor BLAS comparison are double only.
+
+         PRK_DGEMM=tallskinny is meant for a tall and skinny A and C
+         (K and N small, say up to a few dozen, and M large): threads
+         share out strips of TALL_ROWS rows of A and C, and each strip
+         is multiplied by all of B, which stays in cache, so that A is
+         streamed from memory once per multiplication instead of once
+         per tile column of C.
+
+         PRK_BATCH=b multiplies a batch of b independent matrices of the
+         given shape per iteration, each one by a single thread with
+         untiled loops (the "many small GEMMs" case); it is incompatible
+         with PRK_DGEMM=packed or tallskinny and with the vendor BLAS
+         comparison.
+
+         With PRK_SWEEP set, <# threads> is the largest thread count of an
+         in-process scaling sweep (see prk_sweep.h).  For weak scaling the
+         work grows with the number of threads: a batch gets more
+         matrices, square matrices grow in all three dimensions and other
+         shapes in M, the rows of A and C.  Sweeps skip autotuning and the
+         vendor BLAS comparison (see sweep_config()).
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
@@ -53,7 +106,19 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_topology_bind()
          bail_out()
+         prk_harness_*()
+         multiply()       tiled multiplication, per precision
+         multiply_tall()  tall and skinny multiplication, per precision
+         multiply_batch() batch of small multiplications, per precision
+         multiply_packed()
+         autotune_block()
+         prk_dgemm_*()    packed multiplication
+         blas_multiply()  vendor BLAS comparison (CBLAS=1)
+         sweep_shape()    problem size of a configuration of a sweep
+         sweep_config()   run one configuration of a sweep
+         prk_sweep_*()    in-process scaling sweeps
 
 HISTORY: Written by Rob Van der Wijngaart, September 2006.
          Made array dimensioning dynamic, October 2007
@@ -66,28 +131,145 @@ HISTORY: Written by Rob Van der Wijngaart, September 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
+#include <prk_autotune.h>
+#include <prk_sweep.h>
+#include <prk_dgemm_simd.h>
+#include <float.h>
+#include <complex.h>
 
 #if MKL
   #include <mkl_cblas.h>
+#elif CBLAS
+  #include <cblas.h>
+#endif
+
+#define AA_arr(i,j) AA[(i)+(block+boffset)*(j)]
+#define BB_arr(i,j) BB[(i)+(block+boffset)*(j)]
+#define CC_arr(i,j) CC[(i)+(block+boffset)*(j)]
+#define  A_arr(i,j)  A[(i)+(M)*(j)]
+#define  B_arr(i,j)  B[(i)+(K)*(j)]
+#define  C_arr(i,j)  C[(i)+(M)*(j)]
+
+/* rows in a strip of the tall and skinny multiplication                    */
+#ifndef TALL_ROWS
+  #define TALL_ROWS 256
 #endif
 
-#define AA_arr(i,j) AA[(i)+(block+BOFFSET)*(j)]
-#define BB_arr(i,j) BB[(i)+(block+BOFFSET)*(j)]
-#define CC_arr(i,j) CC[(i)+(block+BOFFSET)*(j)]
-#define  A_arr(i,j)  A[(i)+(order)*(j)]
-#define  B_arr(i,j)  B[(i)+(order)*(j)]
-#define  C_arr(i,j)  C[(i)+(order)*(j)]
+/* element types of the GEMM variants                                       */
+enum { PREC_DOUBLE, PREC_SINGLE, PREC_HALF, PREC_COMPLEX, PREC_NUM };
+static const char * prec_names[] = {"double", "single", "half", "complex"};
+#ifdef __FLT16_MAX__
+  #define PRK_HALF 1
+#else
+  #define PRK_HALF 0
+#endif
+/* sizes of the elements of A and B, and of C                               */
+static const size_t dtype_size[] = {sizeof(double), sizeof(float), 2,
+                                    sizeof(double complex)};
+static const size_t atype_size[] = {sizeof(double), sizeof(float), sizeof(float),
+                                    sizeof(double complex)};
+
+#define KERNEL_NAME(f)  f##_d
+#define DTYPE           double
+#define ATYPE           double
+#define INIT_A(j)       ((double) ((j)+1))
+#define INIT_B(j)       ((double) ((j)+1))
+#define REAL_PART(x)    (x)
+#define IMAG_PART(x)    0.0
+#include "dgemm_kernel.incl"
+#undef  KERNEL_NAME
+#undef  DTYPE
+#undef  ATYPE
+#undef  INIT_A
+#undef  INIT_B
+
+#define KERNEL_NAME(f)  f##_s
+#define DTYPE           float
+#define ATYPE           float
+#define INIT_A(j)       ((float) ((j)+1))
+#define INIT_B(j)       ((float) ((j)+1))
+#include "dgemm_kernel.incl"
+#undef  KERNEL_NAME
+#undef  DTYPE
+#undef  ATYPE
+#undef  INIT_A
+#undef  INIT_B
+
+#if PRK_HALF
+#define KERNEL_NAME(f)  f##_h
+#define DTYPE           _Float16
+#define ATYPE           float
+#define INIT_A(j)       ((_Float16) ((j)+1))
+#define INIT_B(j)       ((_Float16) ((j)+1))
+#include "dgemm_kernel.incl"
+#undef  KERNEL_NAME
+#undef  DTYPE
+#undef  ATYPE
+#undef  INIT_A
+#undef  INIT_B
+#endif
+#undef  REAL_PART
+#undef  IMAG_PART
+
+/* complex inputs whose product has nonzero real and imaginary parts       */
+#define KERNEL_NAME(f)  f##_z
+#define DTYPE           double complex
+#define ATYPE           double complex
+#define INIT_A(j)       ((double) ((j)+1)*(1.0+1.0*I))
+#define INIT_B(j)       ((double) ((j)+1)*(2.0-1.0*I))
+#define REAL_PART(x)    creal(x)
+#define IMAG_PART(x)    cimag(x)
+#include "dgemm_kernel.incl"
+#undef  KERNEL_NAME
+#undef  DTYPE
+#undef  ATYPE
+#undef  INIT_A
+#undef  INIT_B
+#undef  REAL_PART
+#undef  IMAG_PART
+
+#if PRK_HALF
+  #define HALF_CASE(call) case PREC_HALF: call; break;
+#else
+  #define HALF_CASE(call)
+#endif
+#define DISPATCH(precision, f, args)                                          \
+  switch (precision) {                                                         \
+    case PREC_DOUBLE:  f##_d args; break;                                      \
+    case PREC_SINGLE:  f##_s args; break;                                      \
+    HALF_CASE(f##_h args)                                                      \
+    case PREC_COMPLEX: f##_z args; break;                                      \
+  }
 
-#define forder (1.0*order)
+static void sweep_shape(const prk_sweep_t *, int, long, long, long, long, long *);
+#if !MKL
+static void packed_blocking(const prk_dgemm_kernel_t *, long, int, int *);
+static void multiply_packed(long, long, long, const prk_dgemm_kernel_t *, const int *,
+                            double *, double *, double *, double *);
+static double sweep_config(int, const long *, int, int, int, int, int,
+                           double *, double *, double *);
+static void autotune_block(long, long, long, int, double *, double *, double *,
+                           int *, int *);
+#endif
+#if CBLAS && !MKL
+static double blas_multiply(long, long, long, int, double *, double *, double *,
+                            double *);
+#endif
 
 int main(int argc, char **argv){
 
-  int     iter, i,ii,j,jj,k,kk,ig,jg,kg; /* dummies                               */
+  int     iter, i, j;           /* dummies                                        */
   int     iterations;           /* number of times the multiplication is done     */
+  prk_harness_t harness;        /* per-iteration timing                           */
   double  dgemm_time,           /* timing parameters                              */
           avgtime;
   double  checksum = 0.0,       /* checksum of result                             */
-          ref_checksum;
+          ref_checksum,
+          checksum_im,          /* imaginary parts of the checksums (complex)     */
+          ref_checksum_im;
+  int     precision = PREC_DOUBLE; /* element type of the matrices                */
   double  epsilon = 1.e-8;      /* error tolerance                                */
   int     nthread_input,        /* thread parameters                              */
           nthread;   
@@ -95,19 +277,34 @@ int main(int argc, char **argv){
                                    obtained numbers of threads are the same       */
   static  
   double  RESTRICT *A, *B, *C;  /* input (A,B) and output (C) matrices            */
-  long    order;                /* number of rows and columns of matrices         */
+  long    M, N, K;              /* C is M x N, A is M x K and B is K x N          */
+  long    batch = 1;            /* number of independent multiplications          */
+  int     square;               /* true if M, N and K are all equal               */
   int     block;                /* tile size of matrices                          */
+  int     boffset = BOFFSET;    /* padding of the leading dimension of tiles      */
+  int     autotuned = 0;        /* true if block and boffset were autotuned       */
   int     shortcut;             /* true if only doing initialization              */
+  int     packed = 0;           /* true if using the packed micro-kernel          */
+  int     tall = 0;             /* true if using the tall and skinny multiply     */
+  const prk_dgemm_kernel_t *kernel = NULL; /* packed micro-kernel                 */
+  int     blocking[3];          /* MC, KC and NC of the packed multiplication     */
+  char    *env;                 /* value of PRK_DGEMM                             */
+  double  nflops;               /* floating point operations per iteration        */
+  prk_sweep_t sweep;            /* thread counts and results of a sweep           */
+  int     sweeping;             /* true if doing a scaling sweep                  */
+  long    shape[4];             /* M, N, K and batch of a configuration           */
+  long    max_shape[4];         /* largest M, N, K and batch of a sweep           */
 
   printf("Parallel Research Kernels version %s\n", PRKVERSION);
   printf("OpenMP Dense matrix-matrix multiplication\n");
 
 #if !MKL  
   if (argc != 4 && argc != 5) {
-    printf("Usage: %s <# threads> <# iterations> <matrix order> [tile size]\n",*argv);
+    printf("Usage: %s <# threads> <# iterations> <matrix order or MxNxK> [tile size]\n",
+           *argv);
 #else
   if (argc != 4) {
-    printf("Usage: %s <# threads> <# iterations> <matrix order>\n",*argv);
+    printf("Usage: %s <# threads> <# iterations> <matrix order or MxNxK>\n",*argv);
 #endif
     exit(EXIT_FAILURE);
   }
@@ -121,6 +318,7 @@ int main(int argc, char **argv){
   }
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
 
   iterations = atoi(*++argv);
   if (iterations < 1){
@@ -128,51 +326,215 @@ int main(int argc, char **argv){
     exit(EXIT_FAILURE);
   }
 
-  order = atol(*++argv);
-  if (order < 0) {
-    shortcut = 1;
-    order    = -order;
-  } else shortcut = 0;
-  if (order < 1) {
-    printf("ERROR: Matrix order must be positive: %ld\n", order);
+  ++argv;
+  shortcut = 0;
+  if (sscanf(*argv, "%ldx%ldx%ld", &M, &N, &K) != 3) {
+    M = atol(*argv);
+    if (M < 0) {
+      shortcut = 1;
+      M        = -M;
+    }
+    N = K = M;
+  }
+  if (M < 1 || N < 1 || K < 1) {
+    printf("ERROR: Matrix dimensions must be positive: %s\n", *argv);
+    exit(EXIT_FAILURE);
+  }
+  square = (M == N && N == K);
+
+  env = getenv("PRK_BATCH");
+  if (env != NULL && *env != '\0') {
+    batch = atol(env);
+    if (batch < 1) {
+      printf("ERROR: PRK_BATCH must be positive: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+#if MKL
+    if (batch > 1) {
+      printf("ERROR: the MKL version does not support PRK_BATCH\n");
+      exit(EXIT_FAILURE);
+    }
+#endif
+  }
+
+  env = getenv("PRK_PRECISION");
+  if (env != NULL && *env != '\0') {
+    for (precision=0; precision<PREC_NUM; precision++)
+      if (!strcmp(env, prec_names[precision])) break;
+    if (precision == PREC_NUM) {
+      printf("ERROR: PRK_PRECISION must be double, single, half or complex: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+    if (precision == PREC_HALF && !PRK_HALF) {
+      printf("ERROR: this compiler does not support half precision (_Float16)\n");
+      exit(EXIT_FAILURE);
+    }
+#if MKL
+    if (precision != PREC_DOUBLE) {
+      printf("ERROR: the MKL version is double precision only\n");
+      exit(EXIT_FAILURE);
+    }
+#endif
+  }
+  if (atype_size[precision] == sizeof(float))
+    epsilon = ((double) K+iterations+1)*FLT_EPSILON;
+
+  sweeping = prk_sweep_init(&sweep, nthread_input);
+#if MKL
+  if (sweeping) {
+    printf("ERROR: the MKL version does not support PRK_SWEEP\n");
     exit(EXIT_FAILURE);
   }
-  A = (double *) prk_malloc(order*order*sizeof(double));
-  B = (double *) prk_malloc(order*order*sizeof(double));
-  C = (double *) prk_malloc(order*order*sizeof(double));
+#endif
+  max_shape[0] = M; max_shape[1] = N; max_shape[2] = K; max_shape[3] = batch;
+  if (sweeping) for (i=0; i<sweep.count; i++) {
+    sweep_shape(&sweep, i, M, N, K, batch, shape);
+    for (j=0; j<4; j++) max_shape[j] = MAX(max_shape[j], shape[j]);
+  }
+
+  /* the double pointers are just storage for the other precisions; a batch
+     is stored as matrices with batch times as many columns                   */
+  A = (double *) prk_malloc(max_shape[0]*max_shape[2]*max_shape[3]*dtype_size[precision]);
+  B = (double *) prk_malloc(max_shape[2]*max_shape[1]*max_shape[3]*dtype_size[precision]);
+  C = (double *) prk_malloc(max_shape[0]*max_shape[1]*max_shape[3]*atype_size[precision]);
   if (!A || !B || !C) {
     printf("ERROR: Could not allocate space for global matrices\n");
     exit(EXIT_FAILURE);
   }
 
-  ref_checksum = (0.25*forder*forder*forder*(forder-1.0)*(forder-1.0));
+  DISPATCH(precision, reference, (M, N, K, &ref_checksum, &ref_checksum_im));
+  if (!sweeping)
+    DISPATCH(precision, fill, (M, N, K, batch, (void *) A, (void *) B, (void *) C));
 
-  #pragma omp parallel for private(i,j) 
-  for(j = 0; j < order; j++) for(i = 0; i < order; i++) {
-    A_arr(i,j) = B_arr(i,j) = (double) j; 
-    C_arr(i,j) = 0.0;
+  prk_harness_init(&harness, "DGEMM", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  if (square) prk_harness_param(&harness, "order", "%ld", M);
+  else {
+    prk_harness_param(&harness, "m", "%ld", M);
+    prk_harness_param(&harness, "n", "%ld", N);
+    prk_harness_param(&harness, "k", "%ld", K);
   }
+  if (batch > 1) prk_harness_param(&harness, "batch", "%ld", batch);
+  prk_harness_param(&harness, "precision", "%s", prec_names[precision]);
 
 #if !MKL
   if (argc == 5) {
          block = atoi(*++argv);
   } else block = DEFAULTBLOCK;
 
-  #pragma omp parallel private (i,j,k,ii,jj,kk,ig,jg,kg,iter)
+  env = getenv("PRK_DGEMM");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"packed"))     packed = 1;
+    else if (!strcmp(env,"tallskinny")) tall   = 1;
+    else if (strcmp(env,"tiled")) {
+      printf("ERROR: PRK_DGEMM must be tiled, packed or tallskinny: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (batch > 1 && (packed || tall)) {
+    printf("ERROR: PRK_BATCH needs PRK_DGEMM=tiled\n");
+    exit(EXIT_FAILURE);
+  }
+  if (packed && precision != PREC_DOUBLE) {
+    printf("ERROR: PRK_DGEMM=packed needs PRK_PRECISION=double\n");
+    exit(EXIT_FAILURE);
+  }
+  if (packed) {
+    kernel = prk_dgemm_simd();
+    packed_blocking(kernel, N, nthread_input, blocking);
+  }
+
+  if (sweeping) {
+    if (square) printf("Base matrix order     = %ld\n", M);
+    else        printf("Base matrix shape     = %ldx%ldx%ld\n", M, N, K);
+    if (batch > 1)
+      printf("Base batch size       = %ld\n", batch);
+    printf("Precision             = %s\n", prec_names[precision]);
+    if (packed)
+      printf("Packed micro-kernel   = %s, %d x %d\n", kernel->isa, kernel->mr, kernel->nr);
+    else if (tall)
+      printf("Tall and skinny       = strips of %d rows\n", TALL_ROWS);
+    else if (batch > 1)
+      printf("Batched               = one matrix per thread, untiled\n");
+    else if (block > 0)
+      printf("Blocking factor       = %d\n", block);
+    else
+      printf("No blocking\n");
+    printf("Number of iterations  = %d\n", iterations);
+    for (i=0; i<sweep.count; i++) {
+      sweep_shape(&sweep, i, M, N, K, batch, shape);
+      /* let the new team fault in the pages of the matrices */
+      prk_sweep_discard(A, max_shape[0]*max_shape[2]*max_shape[3]*dtype_size[precision]);
+      prk_sweep_discard(B, max_shape[2]*max_shape[1]*max_shape[3]*dtype_size[precision]);
+      prk_sweep_discard(C, max_shape[0]*max_shape[1]*max_shape[3]*atype_size[precision]);
+      omp_set_num_threads(sweep.threads[i]);
+      dgemm_time = sweep_config(precision, shape, packed, tall, block, boffset,
+                                iterations, A, B, C);
+      DISPATCH(precision, reference, (shape[0], shape[1], shape[2],
+                                      &ref_checksum, &ref_checksum_im));
+      DISPATCH(precision, checksum, (shape[0], shape[1]*shape[3], (void *) C,
+                                     &checksum, &checksum_im));
+      ref_checksum    *= (double) (iterations+1)*shape[3];
+      ref_checksum_im *= (double) (iterations+1)*shape[3];
+      avgtime = dgemm_time/iterations;
+      nflops  = (precision == PREC_COMPLEX ? 8.0 : 2.0)*
+                (double) shape[0]*shape[1]*shape[2]*shape[3];
+      if (atype_size[precision] == sizeof(float))
+        epsilon = ((double) shape[2]+iterations+1)*FLT_EPSILON;
+      prk_sweep_record(&sweep, i, batch > 1 ? shape[3] : shape[0], avgtime,
+                       1.0E-06 * nflops/avgtime,
+                       ABS((checksum - ref_checksum)/ref_checksum) <= epsilon &&
+                       ABS((checksum_im - ref_checksum_im)/ref_checksum) <= epsilon);
+    }
+    prk_sweep_report(&sweep, "DGEMM", batch > 1 ? "batch" : square ? "order" : "M",
+                     "MFlops/s");
+    for (i=0; i<sweep.count; i++) if (!sweep.valid[i]) exit(EXIT_FAILURE);
+    exit(EXIT_SUCCESS);
+  }
+
+  if (argc != 5 && !packed && !tall && batch == 1 && precision == PREC_DOUBLE &&
+      !shortcut && prk_autotune_mode() != PRK_AUTOTUNE_OFF) {
+    autotune_block(M, N, K, nthread_input, A, B, C, &block, &boffset);
+    autotuned = 1;
+  }
+  prk_harness_param(&harness, "block", "%d", block);
+  prk_harness_param(&harness, "boffset", "%d", boffset);
+  prk_harness_param(&harness, "algorithm", "%s", packed ? "packed" : tall ? "tallskinny" :
+                    batch > 1 ? "batch" : "tiled");
+  if (packed) {
+    prk_harness_param(&harness, "simd", "%s", kernel->isa);
+    prk_harness_param(&harness, "mc", "%d", blocking[0]);
+    prk_harness_param(&harness, "kc", "%d", blocking[1]);
+    prk_harness_param(&harness, "nc", "%d", blocking[2]);
+  }
+
+  #pragma omp parallel private (iter)
   {
-  double RESTRICT *AA=NULL, *BB=NULL, *CC=NULL;
+  void    *AA=NULL, *BB=NULL, *CC=NULL;
+  double *work=NULL;
 
-  if (block > 0) {
+  if (packed) {
+    /* packing buffers for micro-panels of A and B                                  */
+    work = (double *) prk_malloc(prk_dgemm_workspace(kernel, blocking)*sizeof(double));
+    if (!work) {
+      num_error = 1;
+      printf("Could not allocate space for packing buffers on thread %d\n", 
+             omp_get_thread_num());
+    }
+    bail_out(num_error);
+  }
+  else if (block > 0 && !tall && batch == 1) {
     /* matrix blocks for local temporary copies                                     */
-    AA = (double *) prk_malloc(block*(block+BOFFSET)*3*sizeof(double));
+    AA = prk_malloc(block*(block+boffset)*
+                    (2*dtype_size[precision]+atype_size[precision]));
     if (!AA) {
       num_error = 1;
       printf("Could not allocate space for matrix tiles on thread %d\n", 
              omp_get_thread_num());
     }
     bail_out(num_error);
-    BB = AA + block*(block+BOFFSET);
-    CC = BB + block*(block+BOFFSET);
+    BB = (char *) AA + block*(block+boffset)*dtype_size[precision];
+    CC = (char *) BB + block*(block+boffset)*dtype_size[precision];
   } 
 
   #pragma omp master 
@@ -186,15 +548,30 @@ int main(int argc, char **argv){
     printf("number of spawned threads %d\n", nthread);
   } 
   else {
-    printf("Matrix order          = %ld\n", order);
+    if (square) printf("Matrix order          = %ld\n", M);
+    else        printf("Matrix shape          = %ldx%ldx%ld\n", M, N, K);
+    if (batch > 1)
+      printf("Batch size            = %ld\n", batch);
     if (shortcut) 
       printf("Only doing initialization\n"); 
     printf("Number of threads     = %d\n", nthread_input);
-    if (block>0)
-      printf("Blocking factor       = %d\n", block);
-    else
-      printf("No blocking\n");
-    printf("Block offset          = %d\n", BOFFSET);
+    printf("Precision             = %s\n", prec_names[precision]);
+    if (packed) {
+      printf("Packed micro-kernel   = %s, %d x %d\n", kernel->isa, kernel->mr, kernel->nr);
+      printf("Cache blocking        = MC %d, KC %d, NC %d\n",
+             blocking[0], blocking[1], blocking[2]);
+    }
+    else if (tall)
+      printf("Tall and skinny       = strips of %d rows\n", TALL_ROWS);
+    else if (batch > 1)
+      printf("Batched               = one matrix per thread, untiled\n");
+    else {
+      if (block>0)
+        printf("Blocking factor       = %d%s\n", block, autotuned ? " (autotuned)" : "");
+      else
+        printf("No blocking\n");
+      printf("Block offset          = %d%s\n", boffset, autotuned ? " (autotuned)" : "");
+    }
     printf("Number of iterations  = %d\n", iterations);
     printf("Using MKL library     = off\n");
   }
@@ -205,93 +582,70 @@ int main(int argc, char **argv){
 
   for (iter=0; iter<=iterations; iter++) {
 
-    if (iter==1) {
+    /* time every iteration after a warmup iteration */
+    if (iter>=1) {
       #pragma omp barrier
       #pragma omp master
       {
-        dgemm_time = wtime();
+        prk_harness_tick(&harness);
       }
     }
 
-
-    if (block > 0) {
-  
-      #pragma omp for 
-      for(jj = 0; jj < order; jj+=block){
-        for(kk = 0; kk < order; kk+=block) {
-  
-          for (jg=jj,j=0; jg<MIN(jj+block,order); j++,jg++) 
-          for (kg=kk,k=0; kg<MIN(kk+block,order); k++,kg++) 
-            BB_arr(j,k) =  B_arr(kg,jg);
-  
-          for(ii = 0; ii < order; ii+=block){
-  
-            for (kg=kk,k=0; kg<MIN(kk+block,order); k++,kg++)
-            for (ig=ii,i=0; ig<MIN(ii+block,order); i++,ig++)
-              AA_arr(i,k) = A_arr(ig,kg);
-  
-            for (jg=jj,j=0; jg<MIN(jj+block,order); j++,jg++) 
-            for (ig=ii,i=0; ig<MIN(ii+block,order); i++,ig++)
-              CC_arr(i,j) = 0.0;
-         
-            for (kg=kk,k=0; kg<MIN(kk+block,order); k++,kg++)
-            for (jg=jj,j=0; jg<MIN(jj+block,order); j++,jg++) 
-            for (ig=ii,i=0; ig<MIN(ii+block,order); i++,ig++)
-              CC_arr(i,j) += AA_arr(i,k)*BB_arr(j,k);
-  
-            for (jg=jj,j=0; jg<MIN(jj+block,order); j++,jg++) 
-            for (ig=ii,i=0; ig<MIN(ii+block,order); i++,ig++)
-              C_arr(ig,jg) += CC_arr(i,j);
-  
-          }
-        }  
-      }
+    if (packed) multiply_packed(M, N, K, kernel, blocking, A, B, C, work);
+    else if (tall) {
+      DISPATCH(precision, multiply_tall, (M, N, K, (void *) A, (void *) B, (void *) C));
     }
-    else {
-      #pragma omp for 
-      for (jg=0; jg<order; jg++) 
-      for (kg=0; kg<order; kg++) 
-      for (ig=0; ig<order; ig++) 
-        C_arr(ig,jg) += A_arr(ig,kg)*B_arr(kg,jg);
+    else if (batch > 1) {
+      DISPATCH(precision, multiply_batch, (M, N, K, batch,
+               (void *) A, (void *) B, (void *) C));
     }
+    else DISPATCH(precision, multiply, (M, N, K, block, boffset,
+                  (void *) A, (void *) B, (void *) C, AA, BB, CC));
 
   } /* end of iterations                                                          */
 
   #pragma omp barrier
   #pragma omp master
   {
-    dgemm_time = wtime() - dgemm_time;
+    prk_harness_tick(&harness);
+    dgemm_time = prk_harness_elapsed(&harness);
   }
 
   } /* end of parallel region                                                     */
 
 #else
 
-  printf("Matrix size           = %ldx%ld\n", order, order);
+  printf("Matrix shape          = %ldx%ldx%ld\n", M, N, K);
   printf("Number of threads     = %d\n", nthread_input);
   printf("Using MKL library     = on\n");
   printf("Number of iterations  = %d\n", iterations);
 
   for (iter=0; iter<=iterations; iter++) {
 
-    if (iter==1) dgemm_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter>=1) prk_harness_tick(&harness);
 
-    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, order, order, 
-                order, 1.0, &(A_arr(0,0)), order, &(B_arr(0,0)), order, 
-                1.0, &(C_arr(0,0)), order);
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, M, N, K,
+                1.0, &(A_arr(0,0)), M, &(B_arr(0,0)), K,
+                1.0, &(C_arr(0,0)), M);
   }
-  dgemm_time = wtime()-dgemm_time;
+  prk_harness_tick(&harness);
+  dgemm_time = prk_harness_elapsed(&harness);
 #endif
 
-  for(checksum=0.0,j = 0; j < order; j++) for(i = 0; i < order; i++)
-    checksum += C_arr(i,j);
+  DISPATCH(precision, checksum, (M, N*batch, (void *) C, &checksum, &checksum_im));
 
   /* verification test                                                            */
-  ref_checksum *= (iterations+1);
+  ref_checksum    *= (double) (iterations+1)*batch;
+  ref_checksum_im *= (double) (iterations+1)*batch;
 
-  if (ABS((checksum - ref_checksum)/ref_checksum) > epsilon) {
+  if (ABS((checksum - ref_checksum)/ref_checksum) > epsilon ||
+      ABS((checksum_im - ref_checksum_im)/ref_checksum) > epsilon) {
     printf("ERROR: Checksum = %lf, Reference checksum = %lf\n",
            checksum, ref_checksum);
+    if (precision == PREC_COMPLEX)
+      printf("ERROR: Imaginary part = %lf, Reference = %lf\n",
+             checksum_im, ref_checksum_im);
     exit(EXIT_FAILURE);
   }
   else {
@@ -302,11 +656,243 @@ int main(int argc, char **argv){
 #endif
   }
 
-  double nflops = 2.0*forder*forder*forder;
+  /* a complex multiply-add takes eight real flops                                */
+  nflops = (precision == PREC_COMPLEX ? 8.0 : 2.0)*(double) M*N*K*batch;
   avgtime = dgemm_time/iterations;
   printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
          1.0E-06 *nflops/avgtime, avgtime);
 
+#if CBLAS && !MKL
+  env = getenv("PRK_BLAS");
+  if (precision == PREC_DOUBLE && batch == 1 && (env == NULL || strcmp(env,"off"))) {
+    double blas_time = blas_multiply(M, N, K, iterations, A, B, C, &checksum);
+    if (ABS((checksum - ref_checksum)/ref_checksum) > epsilon) {
+      printf("ERROR: vendor BLAS checksum = %lf, Reference checksum = %lf\n",
+             checksum, ref_checksum);
+      exit(EXIT_FAILURE);
+    }
+    printf("Vendor BLAS solution validates\n");
+    printf("Vendor BLAS rate (MFlops/s): %lf  Avg time (s): %lf\n",
+           1.0E-06 *nflops/blas_time, blas_time);
+    printf("Rate relative to vendor BLAS = %lf\n", blas_time/avgtime);
+    prk_harness_param(&harness, "blas_mflops", "%lf", 1.0E-06 *nflops/blas_time);
+    prk_harness_param(&harness, "blas_fraction", "%lf", blas_time/avgtime);
+  }
+#endif
+  /* compulsory traffic: A and B read, C read and written once */
+  prk_harness_model(&harness, nflops, (dtype_size[precision]*((double) M*K+(double) K*N)+
+                    2.0*atype_size[precision]*M*N)*batch);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 *nflops);
+  prk_harness_finalize(&harness);
+
   exit(EXIT_SUCCESS);
 
 }
+
+/* M, N, K and batch of configuration k of a sweep, in shape: in weak
+   scaling the work grows with the number of threads, by more matrices in
+   a batch, in all three dimensions for square matrices and in M otherwise */
+void sweep_shape(const prk_sweep_t *sweep, int k, long M, long N, long K, long batch,
+                 long *shape) {
+
+  double scale = prk_sweep_scale(sweep, k);
+
+  shape[0] = M; shape[1] = N; shape[2] = K; shape[3] = batch;
+  if (batch > 1)
+    shape[3] = (long) (batch*scale+0.5);
+  else if (M == N && N == K)
+    shape[0] = shape[1] = shape[2] = (long) (M*cbrt(scale)+0.5);
+  else
+    shape[0] = (long) (M*scale+0.5);
+}
+
+#if !MKL
+
+/* MC, KC and NC of the packed multiplication for nthread threads, with
+   at least one panel of columns of C per thread                          */
+void packed_blocking(const prk_dgemm_kernel_t *kernel, long N, int nthread, int *blocking) {
+
+  long nc = (N+nthread-1)/nthread;
+
+  prk_dgemm_blocking(kernel, blocking);
+  nc = (nc+kernel->nr-1)/kernel->nr*kernel->nr;
+  blocking[2] = (int) MIN(blocking[2], nc);
+}
+
+/* Fills the matrices of the given shape (M, N, K, batch) and multiplies
+   them iterations+1 times with the current number of threads, the first
+   time as warmup, in the same way as the main loop; returns the time of
+   the timed iterations                                                   */
+double sweep_config(int precision, const long *shape, int packed, int tall,
+                    int block, int boffset, int iterations,
+                    double *A, double *B, double *C) {
+
+  long   M = shape[0], N = shape[1], K = shape[2], batch = shape[3];
+  const prk_dgemm_kernel_t *kernel = NULL;
+  int    blocking[3], num_error = 0, iter;
+  double time = 0.0;
+
+  DISPATCH(precision, fill, (M, N, K, batch, (void *) A, (void *) B, (void *) C));
+  if (packed) {
+    kernel = prk_dgemm_simd();
+    packed_blocking(kernel, N, omp_get_max_threads(), blocking);
+  }
+
+  #pragma omp parallel private (iter)
+  {
+  void   *AA=NULL, *BB=NULL, *CC=NULL;
+  double *work=NULL;
+
+  if (packed) {
+    work = (double *) prk_malloc(prk_dgemm_workspace(kernel, blocking)*sizeof(double));
+    if (!work) num_error = 1;
+  }
+  else if (block > 0 && !tall && batch == 1) {
+    AA = prk_malloc(block*(block+boffset)*
+                    (2*dtype_size[precision]+atype_size[precision]));
+    if (!AA) num_error = 1;
+    BB = (char *) AA + block*(block+boffset)*dtype_size[precision];
+    CC = (char *) BB + block*(block+boffset)*dtype_size[precision];
+  }
+  #pragma omp master
+  if (num_error) printf("ERROR: Could not allocate space for tiles or packing buffers\n");
+  bail_out(num_error);
+
+  for (iter=0; iter<=iterations; iter++) {
+    if (iter == 1) {
+      #pragma omp barrier
+      #pragma omp master
+      time = wtime();
+    }
+    if (packed) multiply_packed(M, N, K, kernel, blocking, A, B, C, work);
+    else if (tall) {
+      DISPATCH(precision, multiply_tall, (M, N, K, (void *) A, (void *) B, (void *) C));
+    }
+    else if (batch > 1) {
+      DISPATCH(precision, multiply_batch, (M, N, K, batch,
+               (void *) A, (void *) B, (void *) C));
+    }
+    else DISPATCH(precision, multiply, (M, N, K, block, boffset,
+                  (void *) A, (void *) B, (void *) C, AA, BB, CC));
+  }
+  #pragma omp barrier
+  #pragma omp master
+  time = wtime() - time;
+
+  prk_free(work);
+  prk_free(AA);
+  }
+  return time;
+}
+
+/* C += A*B with the packed micro-kernel of prk_dgemm_simd.h; panels of
+   blocking[2] columns of C are shared out, and work is the calling
+   thread's packing space.  It must be called by all threads of a
+   parallel region                                                        */
+void multiply_packed(long M, long N, long K, const prk_dgemm_kernel_t *kernel,
+                     const int *blocking, double *A, double *B, double *C, double *work) {
+
+  long jj, nc = blocking[2];
+
+  #pragma omp for schedule(dynamic)
+  for (jj = 0; jj < N; jj+=nc)
+    prk_dgemm_packed(kernel, blocking, M, MIN(nc,N-jj), K,
+                     A, M, &B_arr(0,jj), K, &C_arr(0,jj), M, work);
+}
+
+#if CBLAS && !MKL
+
+/* C = A*B, accumulated iterations+1 times by cblas_dgemm from C = 0, with
+   the first multiplication as warmup; returns the average time of the
+   other iterations, and the checksum of C in *checksum                   */
+double blas_multiply(long M, long N, long K, int iterations, double *A, double *B,
+                     double *C, double *checksum) {
+
+  int    iter, i, j;
+  double blas_time = 0.0, sum = 0.0;
+
+  #pragma omp parallel for private(i)
+  for (j=0; j<N; j++) for (i=0; i<M; i++) C_arr(i,j) = 0.0;
+
+  /* the library runs its own threads                                      */
+  for (iter=0; iter<=iterations; iter++) {
+    if (iter == 1) blas_time = wtime();
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, M, N, K,
+                1.0, &(A_arr(0,0)), M, &(B_arr(0,0)), K,
+                1.0, &(C_arr(0,0)), M);
+  }
+  blas_time = (wtime() - blas_time)/iterations;
+
+  #pragma omp parallel for private(i) reduction(+:sum)
+  for (j=0; j<N; j++) for (i=0; i<M; i++) sum += C_arr(i,j);
+  *checksum = sum;
+  return blas_time;
+}
+
+#endif
+
+/* time one multiplication with each of a set of block sizes, then with
+   each of a set of paddings for the fastest block size, and return the
+   best pair in block and boffset (or the cached pair); C is zero on exit */
+void autotune_block(long M, long N, long K, int nthread, double *A, double *B,
+                    double *C, int *block, int *boffset) {
+
+  static const int blocks[]  = {16, 24, 32, 48, 64, 96, 128, 192, 256};
+  static const int offsets[] = {0, 4, 8, 12, 16};
+  int    nblocks  = sizeof(blocks)/sizeof(blocks[0]);
+  int    noffsets = sizeof(offsets)/sizeof(offsets[0]);
+  int    best[2] = {*block, *boffset}, trial[2], c, phase, i, j;
+  double best_time = -1.0, trial_time;
+  char   problem[64];
+
+  if (M == N && N == K)
+    snprintf(problem, sizeof(problem), "order=%ld,threads=%d", M, nthread);
+  else
+    snprintf(problem, sizeof(problem), "shape=%ldx%ldx%ld,threads=%d", M, N, K, nthread);
+  if (prk_autotune_lookup("DGEMM-OpenMP", problem, 2, best)) {
+    printf("Autotuning: using cached block size %d, offset %d\n", best[0], best[1]);
+    *block = best[0]; *boffset = best[1];
+    return;
+  }
+
+  for (phase=0; phase<2; phase++) {
+    for (c=0; c<(phase ? noffsets : nblocks); c++) {
+      trial[0] = phase ? best[0]    : blocks[c];
+      trial[1] = phase ? offsets[c] : best[1];
+      if (trial[0] > MAX(M,N) && c > 0) break;
+
+      #pragma omp parallel
+      {
+      double *AA = (double *) prk_malloc(trial[0]*(trial[0]+trial[1])*3*sizeof(double));
+      double *BB = AA + trial[0]*(trial[0]+trial[1]);
+      double *CC = BB + trial[0]*(trial[0]+trial[1]);
+
+      #pragma omp barrier
+      #pragma omp master
+      trial_time = wtime();
+      multiply_d(M, N, K, trial[0], trial[1], A, B, C, AA, BB, CC);
+      #pragma omp barrier
+      #pragma omp master
+      trial_time = wtime() - trial_time;
+      prk_free(AA);
+      }
+
+      if (best_time < 0.0 || trial_time < best_time) {
+        best_time = trial_time;
+        best[0]   = trial[0];
+        best[1]   = trial[1];
+      }
+    }
+  }
+
+  #pragma omp parallel for private(i)
+  for (j=0; j<N; j++) for (i=0; i<M; i++) C_arr(i,j) = 0.0;
+
+  printf("Autotuning: block size %d, offset %d is fastest, %lf s per multiplication\n",
+         best[0], best[1], best_time);
+  prk_autotune_store("DGEMM-OpenMP", problem, 2, best, best_time);
+  *block   = best[0];
+  *boffset = best[1];
+}
+
+#endif
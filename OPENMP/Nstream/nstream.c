@@ -79,6 +79,33 @@ USAGE:     The program takes as input the number of threads, the number
  
            The output consists of diagnostics to make sure the 
            algorithm worked, and of timing statistics.
+
+           With PRK_SWEEP set, <# threads> is the largest thread count
+           of an in-process scaling sweep (see prk_sweep.h); for weak
+           scaling the vector length grows with the number of threads.
+
+           PRK_STREAM selects the vector operation at run time:
+             nstream  A = A + B + scalar*C  (default)  4 words per element
+             copy     C = A                            2
+             scale    B = scalar*C                     2
+             add      C = A + B                        3
+             triad    A = B + scalar*C                 3
+             sum      s = s + A  (read only)           1
+             fill     A = value  (write only)          1
+             all      each of the above in turn, reported as a table
+           PRK_NT_STORES=1 writes the result vector with non-temporal
+           stores (SSE2), PRK_NT_STORES=auto only when the three vectors
+           exceed the last-level cache. PRK_PREFETCH=<distance> prefetches
+           the operands that many elements ahead of the loop (default 0,
+           no software prefetch). Either one makes every thread work on
+           whole cache lines of the result vector.
+
+           PRK_NUMA_MATRIX=1 (Linux) measures a bandwidth matrix instead:
+           for every pair of NUMA nodes (i,j) the vectors are moved to
+           node i and the threads are bound to the CPUs of node j. It
+           reports the aggregate rate of every pair and the lowest,
+           average and highest rate of the individual threads, each of
+           which times its own block of the vectors.
  
 FUNCTIONS CALLED:
  
@@ -87,12 +114,22 @@ FUNCTIONS CALLED:
  
            wtime()
            bail_out()
-           checkTRIADresults()
+           check_results()
+           run_stream()
+           numa_matrix()
+           stream_range()
+           sum_range()
+           prk_sweep_*()
+           prk_harness_*()
  
 NOTES:     Bandwidth is determined as the number of words read, plus the 
            number of words written, times the size of the words, divided 
            by the execution time. For a vector length of N, the total 
-           number of words read and written is 4*N*sizeof(double).
+           number of words read and written is 4*N*sizeof(double) for
+           nstream, and as listed above for the other operations. As in
+           STREAM, the extra read of a result vector that cached stores
+           cause (write allocate) is not counted; non-temporal stores
+           avoid it.
  
 HISTORY:   This code is loosely based on the Stream benchmark by John
            McCalpin, but does not follow all the Stream rules. Hence,
@@ -109,6 +146,12 @@ REVISION:  Modified by Rob Van der Wijngaart, May 2006, to introduce
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
  
 #define N   MAXLENGTH
  
@@ -123,31 +166,96 @@ static double * RESTRICT b;
 static double * RESTRICT c;
  
 #define SCALAR  3.0
- 
-static int checkTRIADresults(int, long int);
+#define A0      1.0
+#define B0      2.0
+#define C0      2.0
+
+/* doubles per cache line; with non-temporal stores or prefetching the
+   threads work on whole lines of the result vector                    */
+#define LINE    8
+
+#if defined(__GNUC__)
+  #define PREFETCH_R(p) __builtin_prefetch((p), 0, 3)
+  #define PREFETCH_W(p) __builtin_prefetch((p), 1, 3)
+#else
+  #define PREFETCH_R(p)
+  #define PREFETCH_W(p)
+#endif
+
+#define NSTREAM  0
+#define COPY     1
+#define SCALE    2
+#define ADD      3
+#define TRIAD    4
+#define SUM      5
+#define FILL     6
+#define KERNELS  7
+#define ALL      KERNELS
+
+static const char *kernel_name[KERNELS]    = {"nstream", "copy", "scale", "add", "triad",
+                                              "sum", "fill"};
+static const char *kernel_formula[KERNELS] = {"A = A + B + scalar*C", "C = A", "B = scalar*C",
+                                              "C = A + B", "A = B + scalar*C", "s = s + A",
+                                              "A = value"};
+/* words read plus words written per vector element                     */
+static const int   kernel_words[KERNELS]   = {4, 2, 2, 3, 3, 1, 1};
+/* floating point operations per vector element, fused multiply-adds as one */
+static const int   kernel_flops[KERNELS]   = {2, 0, 1, 1, 1, 1, 0};
+
+static int    nt_stores;      /* write result with non-temporal stores   */
+static long   distance;       /* software prefetch distance in elements  */
+static double checksum;       /* sum of all partial sums of kernel sum   */
+static unsigned long *bind_mask; /* CPUs the threads are bound to, if set */
+static double thread_time[MAX_THREADS];  /* timed part of each thread    */
+static long   thread_length[MAX_THREADS];/* vector elements of each thread */
+ 
+static int    check_results(int, int, long int);
+static double run_stream(int, long int, int, prk_harness_t *);
+static double stream_range(int, long, long, double, int, long);
+static int    numa_matrix(int, long int, int, size_t);
  
 int main(int argc, char **argv) 
 {
-  long     j, iter;       /* dummies                                     */
-  double   scalar;        /* constant used in Triad operation            */
   int      iterations;    /* number of times vector loop gets repeated   */
   long int length,        /* total vector length                         */
+           max_length,    /* largest vector length of a sweep            */
            offset;        /* offset between vectors a and b, and b and c */
   double   bytes;         /* memory IO size                              */
   size_t   space;         /* memory used for a single vector             */
   double   nstream_time,  /* timing parameters                           */
            avgtime;
+  prk_harness_t harness;  /* per-iteration timing of a single operation  */
   int      nthread_input; /* thread parameters                           */
   int      nthread; 
   int      num_error=0;     /* flag that signals that requested and 
                               obtained numbers of threads are the same   */
+  prk_sweep_t sweep;      /* thread counts and results of a sweep        */
+  int      sweeping, i;
+  int      kernel=NSTREAM;/* vector operation, or ALL                    */
+  int      k;             /* vector operation of a run                   */
+  int      valid;         /* result of validation                        */
+  long     llc=0;         /* size of last-level cache in bytes           */
+  char     *env;          /* value of PRK_* environment variables        */
+  int      matrix=0;      /* measure the NUMA bandwidth matrix           */
  
 /**********************************************************************************
 * process and test input parameters    
 ***********************************************************************************/
  
+  env = getenv("PRK_STREAM");
+  if (env != NULL && *env != '\0') {
+    for (kernel=0; kernel<KERNELS; kernel++) if (!strcmp(env,kernel_name[kernel])) break;
+    if (kernel == KERNELS && strcmp(env,"all")) {
+      printf("ERROR: PRK_STREAM must be nstream, copy, scale, add, triad, sum, fill or all: %s\n",
+             env);
+      exit(EXIT_FAILURE);
+    }
+  }
+
   printf("Parallel Research Kernels version %s\n", PRKVERSION);
-  printf("OpenMP stream triad: A = B + scalar*C\n");
+  if (kernel == NSTREAM) printf("OpenMP stream triad: A = B + scalar*C\n");
+  else if (kernel == ALL) printf("OpenMP stream: copy, scale, add, triad, sum, fill\n");
+  else printf("OpenMP stream %s: %s\n", kernel_name[kernel], kernel_formula[kernel]);
 
   if (argc != 5){
      printf("Usage:  %s <# threads> <# iterations> <vector length> <offset>\n", *argv);
@@ -179,8 +287,59 @@ int main(int argc, char **argv)
     exit(EXIT_FAILURE);
   }
 
+  env = getenv("PRK_NT_STORES");
+  if (env != NULL && *env != '\0') {
+    if (!strcmp(env,"auto")) {
+#ifdef _SC_LEVEL3_CACHE_SIZE
+      llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+      /* without a known last-level cache size, do not stream             */
+      nt_stores = llc > 0 && 3.0*sizeof(double)*length > (double) llc;
+    }
+    else nt_stores = atoi(env) != 0;
+  }
+#ifndef __SSE2__
+  if (nt_stores) {
+    printf("ERROR: PRK_NT_STORES requires SSE2\n");
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+  env = getenv("PRK_PREFETCH");
+  if (env != NULL && *env != '\0') {
+    distance = atol(env);
+    if (distance < 0) {
+      printf("ERROR: PRK_PREFETCH must be non-negative: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+    /* prefetch whole cache lines                                         */
+    distance = ((distance+LINE-1)/LINE)*LINE;
+  }
+
+  env = getenv("PRK_NUMA_MATRIX");
+  if (env != NULL && *env != '\0') matrix = atoi(env) != 0;
+#if !PRK_HAVE_MEMPOLICY
+  if (matrix) {
+    printf("ERROR: PRK_NUMA_MATRIX requires Linux\n");
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+  sweeping   = prk_sweep_init(&sweep, nthread_input);
+  if ((sweeping || matrix) && kernel == ALL) {
+    printf("ERROR: PRK_SWEEP and PRK_NUMA_MATRIX require a single PRK_STREAM operation\n");
+    exit(EXIT_FAILURE);
+  }
+  if (sweeping && matrix) {
+    printf("ERROR: PRK_SWEEP and PRK_NUMA_MATRIX cannot be combined\n");
+    exit(EXIT_FAILURE);
+  }
+  max_length = length;
+  if (sweeping) for (i=0; i<sweep.count; i++) 
+    max_length = MAX(max_length, (long) (length*prk_sweep_scale(&sweep,i)));
+
 #if STATIC_ALLOCATION 
-  if ((3*length + 2*offset) > N) {
+  if ((3*max_length + 2*offset) > N) {
     printf("ERROR: vector length/offset %ld/%ld too ", length, offset);
     printf("large; increase MAXLENGTH in Makefile or decrease vector length\n");
     exit(EXIT_FAILURE);
@@ -190,18 +349,40 @@ int main(int argc, char **argv)
   omp_set_num_threads(nthread_input);
  
 #if !STATIC_ALLOCATION
-  space = (3*length + 2*offset)*sizeof(double);
+  space = (3*max_length + 2*offset)*sizeof(double);
   a = (double *) prk_malloc(space);
   if (!a) {
     printf("ERROR: Could not allocate %ld words for vectors\n", 
-           3*length+2*offset);
+           3*max_length+2*offset);
     exit(EXIT_FAILURE);
   }
 #endif
   b = a + length + offset;
   c = b + length + offset;
+
+  if (sweeping) {
+    printf("Largest vector length = %ld\n", max_length);
+    printf("Offset                = %ld\n", offset);
+    printf("Number of iterations  = %d\n", iterations);
+    for (i=0; i<sweep.count; i++) {
+      long len = (long) (length*prk_sweep_scale(&sweep,i));
+      b = a + len + offset;
+      c = b + len + offset;
+      /* let the new team fault in the pages of the vectors */
+      prk_sweep_discard(a, (3*max_length + 2*offset)*sizeof(double));
+      omp_set_num_threads(sweep.threads[i]);
+      nstream_time = run_stream(kernel, len, iterations, NULL);
+      avgtime = nstream_time/iterations;
+      bytes   = kernel_words[kernel] * sizeof(double) * (double) len;
+      prk_sweep_record(&sweep, i, len, avgtime, 1.0E-06 * bytes/avgtime, 
+                       check_results(kernel, iterations, len));
+    }
+    prk_sweep_report(&sweep, "Nstream", "length", "MB/s");
+    for (i=0; i<sweep.count; i++) if (!sweep.valid[i]) exit(EXIT_FAILURE);
+    return 0;
+  }
  
-  #pragma omp parallel private(j,iter) 
+  #pragma omp parallel
   {
   #pragma omp master
   {
@@ -222,100 +403,383 @@ int main(int argc, char **argv)
 #else
     printf("Allocation type      = dynamic\n");
 #endif
+    if (nt_stores || distance) {
+    printf("Non-temporal stores  = %s\n", nt_stores ? "on" : "off");
+    if (distance)
+    printf("Prefetch distance    = %ld elements\n", distance);
+    else
+    printf("Prefetch distance    = off\n");
+    }
   }
   }
   bail_out(num_error); 
+  }  /* end of OpenMP parallel region */
+
+  if (matrix) {
+    if (!numa_matrix(kernel, length, iterations, (3*length + 2*offset)*sizeof(double)))
+      exit(EXIT_FAILURE);
+    return 0;
+  }
+
+  if (kernel == ALL) {
+    valid = 1;
+    printf("Operation  %-22s %14s %14s\n", "Formula", "Rate (MB/s)", "Avg time (s)");
+    for (k=0; k<KERNELS; k++) {
+      nstream_time = run_stream(k, length, iterations, NULL);
+      avgtime = nstream_time/iterations;
+      bytes   = kernel_words[k] * sizeof(double) * (double) length;
+      printf("%-10s %-22s %14lf %14lf\n", kernel_name[k], kernel_formula[k],
+             1.0E-06 * bytes/avgtime, avgtime);
+      valid = check_results(k, iterations, length) && valid;
+    }
+    if (!valid) exit(EXIT_FAILURE);
+    return 0;
+  }
+
+  prk_harness_init(&harness, "Nstream", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "length", "%ld", length);
+  prk_harness_param(&harness, "offset", "%ld", offset);
+  prk_harness_param(&harness, "operation", "%s", kernel_name[kernel]);
+  prk_harness_param(&harness, "nt_stores", "%d", nt_stores);
+  prk_harness_param(&harness, "prefetch", "%ld", distance);
+
+  nstream_time = run_stream(kernel, length, iterations, &harness);
+ 
+  /*********************************************************************
+  ** Analyze and output results.
+  *********************************************************************/
+ 
+  bytes   = kernel_words[kernel] * sizeof(double) * (double) length;
+  if (check_results(kernel, iterations, length)) {
+    avgtime = nstream_time/iterations;
+    printf("Rate (MB/s): %lf Avg time (s): %lf\n",
+           1.0E-06 * bytes/avgtime, avgtime);
+    prk_harness_model(&harness, kernel_flops[kernel] * (double) length, bytes);
+    prk_harness_report(&harness, "MB/s", 1.0E-06 * bytes);
+    prk_harness_finalize(&harness);
+   }
+  else exit(EXIT_FAILURE);
+ 
+  return 0;
+}
+ 
+/* writes LINE results to dst, an address on a cache line boundary      */
+static inline void store_line(double * RESTRICT dst, const double *tmp, int stream)
+{
+  int i;
+#ifdef __SSE2__
+  if (stream) {
+    for (i=0; i<LINE; i+=2) _mm_stream_pd(dst+i, _mm_loadu_pd(tmp+i));
+    return;
+  }
+#endif
+  for (i=0; i<LINE; i++) dst[i] = tmp[i];
+}
+
+/* sum of elements lo through hi-1 of A, accumulated in a cache line of
+   partial sums so that the additions need not be done in sequence      */
+static double sum_range(long lo, long hi, long dist)
+{
+  double part[LINE] = {0.0};
+  double sum = 0.0;
+  long   j;
+  int    i;
+
+  for (j=lo; j+LINE<=hi; j+=LINE) {
+    if (dist) PREFETCH_R(a+j+dist);
+    for (i=0; i<LINE; i++) part[i] += a[j+i];
+  }
+  for (; j<hi; j++) sum += a[j];
+  for (i=0; i<LINE; i++) sum += part[i];
+  return sum;
+}
+
+/* applies vector operation kernel to elements lo through hi-1 and, for
+   kernel sum, returns their sum. value is the fill value. Without non-
+   temporal stores and prefetching these are the plain loops; otherwise
+   the loops run over whole cache lines of the result vector            */
+static double stream_range(int kernel, long lo, long hi, double value, int stream,
+                           long dist)
+{
+  double * RESTRICT dst;  /* vector that is written, A for sum          */
+  double   scalar = SCALAR;
+  double   sum = 0.0;
+  double   tmp[LINE];     /* one cache line of results                  */
+  long     j, start, end;
+  int      i;
+
+  if (!stream && !dist) {
+    switch (kernel) {
+    case NSTREAM: for (j=lo; j<hi; j++) a[j] += b[j]+scalar*c[j]; break;
+    case COPY:    for (j=lo; j<hi; j++) c[j] = a[j];              break;
+    case SCALE:   for (j=lo; j<hi; j++) b[j] = scalar*c[j];       break;
+    case ADD:     for (j=lo; j<hi; j++) c[j] = a[j]+b[j];         break;
+    case TRIAD:   for (j=lo; j<hi; j++) a[j] = b[j]+scalar*c[j];  break;
+    case SUM:     sum = sum_range(lo, hi, 0);                     break;
+    case FILL:    for (j=lo; j<hi; j++) a[j] = value;             break;
+    }
+    return sum;
+  }
+
+  switch (kernel) {
+  case COPY: case ADD: dst = c; break;
+  case SCALE:          dst = b; break;
+  default:             dst = a; break;
+  }
+
+  /* plain loops up to the first and from the last cache line boundary   */
+  for (start=lo; start<hi && ((uintptr_t)(dst+start) & (LINE*sizeof(double)-1)); start++);
+  end  = start + ((hi-start)/LINE)*LINE;
+  sum  = stream_range(kernel, lo, start, value, 0, 0);
+  sum += stream_range(kernel, end, hi, value, 0, 0);
+
+#define LINE_LOOP(EXPR, PREFETCH_OPERANDS)                                   \
+  for (j=start; j<end; j+=LINE) {                                            \
+    if (dist) {                                                              \
+      PREFETCH_OPERANDS;                                                     \
+      if (!stream) PREFETCH_W(dst+j+dist);                                   \
+    }                                                                        \
+    for (i=0; i<LINE; i++) tmp[i] = EXPR;                                    \
+    store_line(dst+j, tmp, stream);                                          \
+  }
+
+  switch (kernel) {
+  case NSTREAM:
+    LINE_LOOP(a[j+i] + (b[j+i]+scalar*c[j+i]),
+              (PREFETCH_R(b+j+dist), PREFETCH_R(c+j+dist)));
+    break;
+  case COPY:
+    LINE_LOOP(a[j+i], PREFETCH_R(a+j+dist));
+    break;
+  case SCALE:
+    LINE_LOOP(scalar*c[j+i], PREFETCH_R(c+j+dist));
+    break;
+  case ADD:
+    LINE_LOOP(a[j+i]+b[j+i], (PREFETCH_R(a+j+dist), PREFETCH_R(b+j+dist)));
+    break;
+  case TRIAD:
+    LINE_LOOP(b[j+i]+scalar*c[j+i], (PREFETCH_R(b+j+dist), PREFETCH_R(c+j+dist)));
+    break;
+  case FILL:
+    LINE_LOOP(value, (void) 0);
+    break;
+  case SUM:
+    sum += sum_range(start, end, dist);
+    break;
+  }
+#undef LINE_LOOP
+
+#ifdef __SSE2__
+  /* non-temporal stores are weakly ordered; complete them before the
+     barrier that ends the iteration                                     */
+  if (stream) _mm_sfence();
+#endif
+  return sum;
+}
+ 
+/* initializes the vectors with the current team of threads and returns
+   the time of iterations operations after one warmup operation. Every
+   thread works on the same contiguous block of the vectors throughout.
+   If h is not NULL, every operation is timed with it                   */
+double run_stream(int kernel, long int length, int iterations, prk_harness_t *h) {
+  long     j, iter;       /* dummies                                     */
+  long     lo, hi;        /* block of the vectors owned by the thread    */
+  double   sum;           /* partial sum of kernel sum                   */
+  int      stream;        /* non-temporal stores, if there are stores    */
+  double   nstream_time;  /* timing parameters                           */
+  double   my_time;
+
+  checksum = 0.0;
+  stream   = nt_stores && kernel != SUM;
+
+  #pragma omp parallel private(j,iter,lo,hi,sum,my_time) 
+  {
+  int my_ID = omp_get_thread_num(), nthread = omp_get_num_threads();
+  lo  = (length*my_ID)/nthread;
+  hi  = (length*(my_ID+1))/nthread;
+  sum = 0.0;
+  thread_length[my_ID] = hi-lo;
+#if PRK_HAVE_MEMPOLICY
+  if (bind_mask) prk_bind_cpus(bind_mask);
+#endif
 
-  /* FIXME Use OpenMP 4 via _Pragma */
-  #pragma omp for
 #ifdef __INTEL_COMPILER
   #pragma vector always
 #endif
-  for (j=0; j<length; j++) {
-    a[j] = 0.0;
-    b[j] = 2.0;
-    c[j] = 2.0;
+  for (j=lo; j<hi; j++) {
+    a[j] = A0;
+    b[j] = B0;
+    c[j] = C0;
   }
     
-  /* --- MAIN LOOP --- repeat Triad iterations times --- */
- 
-  scalar = SCALAR;
+  /* --- MAIN LOOP --- repeat the operation iterations times --- */
  
   for (iter=0; iter<=iterations; iter++) {
  
     if (iter==1) {
       #pragma omp barrier
+      my_time = wtime();
+    }
+    /* the barrier ending the previous iteration also protects the tick   */
+    if (iter>=1) {
       #pragma omp master
       {
-        nstream_time = wtime();
+        if (h)            prk_harness_tick(h);
+        else if (iter==1) nstream_time = wtime();
       }
     }
  
-  /* FIXME Use OpenMP 4 via _Pragma */
-    #pragma omp for
-#ifdef __INTEL_COMPILER
-    #pragma vector always
-#endif
-    for (j=0; j<length; j++) a[j] += b[j]+scalar*c[j];
+    sum += stream_range(kernel, lo, hi, (double) iter, stream, distance);
+    if (iter == iterations) thread_time[my_ID] = wtime() - my_time;
+    #pragma omp barrier
  
   } /* end of iterations                                              */
 
-  #pragma omp barrier
   #pragma omp master
   {
-    nstream_time = wtime() - nstream_time;
+    if (h) {
+      prk_harness_tick(h);
+      nstream_time = prk_harness_elapsed(h);
+    }
+    else nstream_time = wtime() - nstream_time;
   }
 
+  #pragma omp atomic
+  checksum += sum;
+
   }  /* end of OpenMP parallel region */
+
+  return nstream_time;
+}
  
-  /*********************************************************************
-  ** Analyze and output results.
-  *********************************************************************/
- 
-  bytes   = 4.0 * sizeof(double) * length;
-  if (checkTRIADresults(iterations, length)) {
-    avgtime = nstream_time/iterations;
-    printf("Rate (MB/s): %lf Avg time (s): %lf\n",
-           1.0E-06 * bytes/avgtime, avgtime);
-   }
-  else exit(EXIT_FAILURE);
- 
+/* measures the bandwidth of kernel with the vectors, space bytes in all,
+   on every NUMA node and the threads on every NUMA node; returns 0 if
+   a measurement fails                                                   */
+int numa_matrix(int kernel, long int length, int iterations, size_t space) {
+#if PRK_HAVE_MEMPOLICY
+  unsigned long nodes[PRK_MAX_NUMA_NODES/(8*sizeof(unsigned long))];
+  unsigned long cpus[PRK_MAX_CPUS/(8*sizeof(unsigned long))];
+  int      node[PRK_MAX_NUMA_NODES]; /* IDs of the online nodes          */
+  int      nnodes = 0;
+  int      mem, cpu, i, t, nthread, valid = 1;
+  double   *rate;         /* aggregate rate of every pair of nodes       */
+  double   *thread_rate;  /* lowest, average and highest thread rate     */
+  double   bytes, r;
+
+  prk_online_nodes(nodes);
+  for (i=0; i<PRK_MAX_NUMA_NODES; i++)
+    if ((nodes[i/(8*sizeof(unsigned long))] >> (i%(8*sizeof(unsigned long)))) & 1) node[nnodes++] = i;
+  rate        = (double *) prk_malloc(nnodes*nnodes*sizeof(double));
+  thread_rate = (double *) prk_malloc(3*nnodes*nnodes*sizeof(double));
+  if (!rate || !thread_rate) {
+    printf("ERROR: Could not allocate space for bandwidth matrix\n");
+    return 0;
+  }
+  nthread = omp_get_max_threads();
+  printf("Number of NUMA nodes = %d\n", nnodes);
+
+  for (mem=0; mem<nnodes; mem++) {
+    if (prk_mempolicy_bind(a, space, node[mem])) {
+      printf("ERROR: Could not move vectors to NUMA node %d\n", node[mem]);
+      return 0;
+    }
+    for (cpu=0; cpu<nnodes; cpu++) {
+      if (!prk_node_cpus(node[cpu], cpus)) {
+        printf("ERROR: Could not find the CPUs of NUMA node %d\n", node[cpu]);
+        return 0;
+      }
+      bind_mask = cpus;
+      r = run_stream(kernel, length, iterations, NULL);
+      bind_mask = NULL;
+      valid = check_results(kernel, iterations, length) && valid;
+      bytes = kernel_words[kernel] * sizeof(double);
+      rate[mem*nnodes+cpu] = 1.0E-06 * bytes * length * iterations/r;
+      thread_rate[3*(mem*nnodes+cpu)]   = 1.0E+30;
+      thread_rate[3*(mem*nnodes+cpu)+1] = 0.0;
+      thread_rate[3*(mem*nnodes+cpu)+2] = 0.0;
+      for (t=0; t<nthread; t++) {
+        r = 1.0E-06 * bytes * thread_length[t] * iterations/thread_time[t];
+#if VERBOSE
+        printf("Memory node %d, CPU node %d, thread %d: %lf MB/s\n", node[mem], node[cpu], t, r);
+#endif
+        thread_rate[3*(mem*nnodes+cpu)]    = MIN(thread_rate[3*(mem*nnodes+cpu)], r);
+        thread_rate[3*(mem*nnodes+cpu)+1] += r/nthread;
+        thread_rate[3*(mem*nnodes+cpu)+2]  = MAX(thread_rate[3*(mem*nnodes+cpu)+2], r);
+      }
+    }
+  }
+
+  printf("Bandwidth matrix (MB/s): rows are memory nodes, columns CPU nodes\n");
+  printf("%8s", "");
+  for (cpu=0; cpu<nnodes; cpu++) printf(" %14d", node[cpu]);
+  printf("\n");
+  for (mem=0; mem<nnodes; mem++) {
+    printf("%8d", node[mem]);
+    for (cpu=0; cpu<nnodes; cpu++) printf(" %14lf", rate[mem*nnodes+cpu]);
+    printf("\n");
+  }
+  printf("Per-thread bandwidth (MB/s):\n");
+  printf("  memory     CPU            min            avg            max\n");
+  for (mem=0; mem<nnodes; mem++) for (cpu=0; cpu<nnodes; cpu++) {
+    printf("%8d %7d %14lf %14lf %14lf\n", node[mem], node[cpu],
+           thread_rate[3*(mem*nnodes+cpu)], thread_rate[3*(mem*nnodes+cpu)+1],
+           thread_rate[3*(mem*nnodes+cpu)+2]);
+  }
+  prk_free(rate);
+  prk_free(thread_rate);
+  return valid;
+#else
   return 0;
+#endif
 }
  
- 
-int checkTRIADresults (int iterations, long int length) {
-  double aj, bj, cj, scalar, asum;
+/* checks the vector written by kernel, or the sum it computed           */
+int check_results (int kernel, int iterations, long int length) {
+  double aj, bj, cj, scalar, expected, observed;
   double epsilon = 1.e-8;
-  int j,iter;
+  double *result;
+  long j;
+  int iter;
  
   /* reproduce initialization */
-  aj = 0.0;
-  bj = 2.0;
-  cj = 2.0;
- 
-  /* now execute timing loop */
+  aj = A0;
+  bj = B0;
+  cj = C0;
   scalar = SCALAR;
-  for (iter=0; iter<=iterations; iter++) {
-    aj += bj+scalar*cj;
+ 
+  /* now execute timing loop; apart from nstream and fill, repeating the
+     operation does not change the result                               */
+  switch (kernel) {
+  case NSTREAM: for (iter=0; iter<=iterations; iter++) aj += bj+scalar*cj;
+                expected = aj;                               result = a; break;
+  case COPY:    expected = aj;                               result = c; break;
+  case SCALE:   expected = scalar*cj;                        result = b; break;
+  case ADD:     expected = aj+bj;                            result = c; break;
+  case TRIAD:   expected = bj+scalar*cj;                     result = a; break;
+  case SUM:     expected = aj*(iterations+1);                result = NULL; break;
+  default:      expected = (double) iterations;              result = a; break;
   }
  
-  aj = aj * (double) (length);
+  expected = expected * (double) (length);
  
-  asum = 0.0;
-  for (j=0; j<length; j++) asum += a[j];
+  if (result) {
+    observed = 0.0;
+    for (j=0; j<length; j++) observed += result[j];
+  }
+  else observed = checksum;
  
 #if VERBOSE
   printf ("Results Comparison: \n");
-  printf ("        Expected checksum: %f\n",aj);
-  printf ("        Observed checksum: %f\n",asum);
+  printf ("        Expected checksum: %f\n",expected);
+  printf ("        Observed checksum: %f\n",observed);
 #endif
  
-  if (ABS(aj-asum)/asum > epsilon) {
-    printf ("Failed Validation on output array\n");
+  if (ABS(expected-observed)/expected > epsilon) {
+    printf ("Failed Validation on output of %s\n", kernel_name[kernel]);
 #if VERBOSE
-    printf ("        Expected checksum: %f \n",aj);
-    printf ("        Observed checksum: %f \n",asum);
+    printf ("        Expected checksum: %f \n",expected);
+    printf ("        Observed checksum: %f \n",observed);
 #endif
     return (0);
   }
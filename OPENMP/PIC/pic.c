@@ -47,6 +47,41 @@ USAGE:   <progname> <#simulation steps> <grid size> <#particles> \
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         By default particles are placed using the serial LCG, so that
+         results match those of earlier versions. Setting PRK_RNG=philox
+         selects the counter-based Philox generator, which lets all threads
+         place particles concurrently.
+
+         By default particles are stored as an array of structures that
+         also holds the initial position and velocity parameters needed
+         only for verification. Setting PRK_LAYOUT=soa moves the fields
+         used in the time steps (position, velocity, charge) into separate
+         arrays, and computes the forces on batches of PIC_BATCH particles
+         with a loop that the compiler can vectorize. PRK_LAYOUT=aos
+         selects the default.
+
+         Particles start out ordered by cell, but lose that order as they
+         move, so that the grid lookups become increasingly scattered.
+         Setting PRK_SORT=<f> sorts the particles by cell again every f
+         time steps, with a parallel counting sort; the time spent sorting
+         is included in the rate and reported separately. Setting
+         PRK_GRID=cell additionally stores the four charges at the corners
+         of each cell next to each other (cell-tiled storage), so that every
+         particle reads its charges from one or two cache lines.
+
+         By default the particle count stays fixed. Setting
+         PRK_INJECT=<f>:<n>:<xleft>,<xright>,<ybottom>,<ytop> injects n
+         particles into every cell of the given patch every f time steps,
+         and PRK_REMOVE=<f>:<xleft>,<xright>,<ybottom>,<ytop> removes all
+         particles in the cells of the patch every f time steps. The
+         particles then live in blocks of PIC_BLOCK particles that come from
+         a pool, which allocates PIC_CHUNK blocks at a time and never frees
+         them; removed particles leave holes in their blocks, which a
+         parallel compaction squeezes out every PRK_COMPACT time steps
+         (10 by default, 0 for never). The allocation and compaction times
+         and the memory held by the pool are reported. Dynamic populations
+         need the AoS layout and no sorting.
+
 FUNCTIONS CALLED:
 
          Other than standard C functions, the following functions are used in 
@@ -54,6 +89,15 @@ FUNCTIONS CALLED:
          wtime()
          bad_patch()
          random_draw()
+         random_draw_vector()
+         prk_harness_*()
+         computeTotalForceBatch()
+         initializeCellGrid()
+         sortByCell()
+         moveParticle()
+         injectParticles()
+         removeParticles()
+         store_compact()
 
 HISTORY: - Written by Evangelos Georganas, August 2015.
          - RvdW: Refactored to make the code PRK conforming, December 2015
@@ -62,6 +106,8 @@ HISTORY: - Written by Evangelos Georganas, August 2015.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
 #include <random_draw.h>
 
 #include <math.h>
@@ -84,6 +130,8 @@ HISTORY: - Written by Evangelos Georganas, August 2015.
 #define SUCCESS 1
 #define FAILURE 0
 
+#define PHILOX_SEED 27182818285
+
 #define REL_X 0.5
 #define REL_Y 0.5
 
@@ -93,6 +141,21 @@ HISTORY: - Written by Evangelos Georganas, August 2015.
 #define PATCH      3
 #define UNDEFINED  4
 
+/* number of particles whose forces are computed together in the SoA layout */
+#ifndef PIC_BATCH
+#define PIC_BATCH 256
+#endif
+
+/* number of particles in a block of the dynamic particle store */
+#ifndef PIC_BLOCK
+#define PIC_BLOCK 1024
+#endif
+
+/* number of blocks the pool obtains from the system at a time */
+#ifndef PIC_CHUNK
+#define PIC_CHUNK 16
+#endif
+
 typedef struct {
   uint64_t left;
   uint64_t right;
@@ -112,8 +175,44 @@ typedef struct particle_t {
   double   y0;
   int64_t  k; //  determines how many cells particles move per time step in the x direction 
   int64_t  m; //  determines how many cells particles move per time step in the y direction 
+  int64_t  t0; // time step at which the particle was placed; negative once removed
 } particle_t;
 
+/* Fields of all particles that are used in the time steps, one array each */
+typedef struct {
+  double   *x;
+  double   *y;
+  double   *v_x;
+  double   *v_y;
+  double   *q;
+} particle_soa_t;
+
+/* Pool of particle blocks. Blocks are carved from chunks of PIC_CHUNK
+   blocks that are allocated when the free list runs dry and are never given
+   back to the system, so that the pool size is the high-water mark         */
+typedef struct {
+  particle_t **free;             // stack of free blocks
+  uint64_t   nfree;
+  uint64_t   maxfree;            // room on the stack
+  uint64_t   nblocks;            // blocks carved from chunks so far
+  uint64_t   chunks;             // chunks allocated
+  double     alloc_time;         // time spent allocating
+} pool_t;
+
+/* Particles of the dynamic population. Slot i is particle i%PIC_BLOCK of
+   block i/PIC_BLOCK; removed particles leave holes, marked by a negative t0,
+   until the store is compacted. Compaction gathers the live particles into
+   dest and uses offset, which both have room for maxblock blocks as well   */
+typedef struct {
+  particle_t **block;
+  particle_t **dest;
+  uint64_t   *offset;
+  uint64_t   nblock;
+  uint64_t   maxblock;
+  uint64_t   nslot;              // slots in use, including holes
+  uint64_t   nlive;              // live particles
+} store_t;
+
 /* Initializes the grid of charges
   We follow a column major format for the grid. Note that this may affect cache performance, depending on access pattern of particles. */
 
@@ -147,30 +246,157 @@ double *initializeGrid(uint64_t L) {
   return Qgrid;
 }
 
+/* Copies the grid of charges into cell-tiled storage: the charges at the
+   four corners of cell (x,y) are stored contiguously at 4*(x*L+y), in the
+   order in which computeTotalForce uses them                              */
+double *initializeCellGrid(uint64_t L, double *Qgrid) {
+  double   *Qcell;
+  uint64_t  x, y;
+
+  Qcell = (double*) prk_malloc(4*L*L*sizeof(double));
+  if (Qcell == NULL) {
+    printf("ERROR: Could not allocate space for cell-tiled grid\n");
+    exit(EXIT_FAILURE);
+  }
+
+  #pragma omp parallel for private(y)
+  for (x=0; x<L; x++) {
+    for (y=0; y<L; y++) {
+      Qcell[4*(x*L+y)  ] = QG(y,  x,  L);
+      Qcell[4*(x*L+y)+1] = QG(y+1,x,  L);
+      Qcell[4*(x*L+y)+2] = QG(y,  x+1,L);
+      Qcell[4*(x*L+y)+3] = QG(y+1,x+1,L);
+    }
+  }
+  return Qcell;
+}
+
+/* Sets velocity, charge and initial position of a particle placed at
+   (x,y) in the first time step                                            */
+void finish_particle(particle_t *p) {
+  double x_coord, y_coord, rel_x, rel_y, cos_theta, cos_phi, r1_sq, r2_sq, base_charge;
+  uint64_t x;
+
+  x_coord = p->x;
+  y_coord = p->y;
+  rel_x = fmod(x_coord,1.0);
+  rel_y = fmod(y_coord,1.0);
+  x = (uint64_t) x_coord;
+  r1_sq = rel_y * rel_y + rel_x * rel_x;
+  r2_sq = rel_y * rel_y + (1.0-rel_x) * (1.0-rel_x);
+  cos_theta = rel_x/sqrt(r1_sq);
+  cos_phi = (1.0-rel_x)/sqrt(r2_sq);
+  base_charge = 1.0 / ((DT*DT) * Q * (cos_theta/r1_sq + cos_phi/r2_sq));
+       
+  p->v_x = 0.0;
+  p->v_y = ((double) p->m) / DT;
+  /* this particle charge assures movement in positive x-direction */
+  p->q = (x%2 == 0) ? (2*p->k+1) * base_charge : -1.0 * (2*p->k+1) * base_charge ;
+  p->x0 = x_coord;
+  p->y0 = y_coord;
+  p->t0 = 0;
+}
+
 /* Completes particle distribution */
 void finish_distribution(uint64_t n, particle_t *p) {
-  double x_coord, y_coord, rel_x, rel_y, cos_theta, cos_phi, r1_sq, r2_sq, base_charge;
-  uint64_t x, pi;
-
-  for (pi=0; pi<n; pi++) {
-    x_coord = p[pi].x;
-    y_coord = p[pi].y;
-    rel_x = fmod(x_coord,1.0);
-    rel_y = fmod(y_coord,1.0);
-    x = (uint64_t) x_coord;
-    r1_sq = rel_y * rel_y + rel_x * rel_x;
-    r2_sq = rel_y * rel_y + (1.0-rel_x) * (1.0-rel_x);
-    cos_theta = rel_x/sqrt(r1_sq);
-    cos_phi = (1.0-rel_x)/sqrt(r2_sq);
-    base_charge = 1.0 / ((DT*DT) * Q * (cos_theta/r1_sq + cos_phi/r2_sq));
-         
-    p[pi].v_x = 0.0;
-    p[pi].v_y = ((double) p[pi].m) / DT;
-    /* this particle charge assures movement in positive x-direction */
-    p[pi].q = (x%2 == 0) ? (2*p[pi].k+1) * base_charge : -1.0 * (2*p[pi].k+1) * base_charge ;
-    p[pi].x0 = x_coord;
-    p[pi].y0 = y_coord;
+  uint64_t pi;
+
+  #pragma omp parallel for
+  for (pi=0; pi<n; pi++) finish_particle(&p[pi]);
+}
+
+/* Draws particles for all cells with the Philox generator and places them.
+   Column x of cells gets mean mu[x] particles per cell (zero outside patch,
+   if given). The draw for cell (x,y) is number x*L+y of the stream, so
+   columns are independent and are processed in parallel, once to count
+   particles and once more to place them.                               */
+particle_t *initializeColumns(uint64_t L, const double *mu, const bbox_t *patch,
+                              double k, double m, uint64_t *n_placed) {
+  particle_t  *particles;
+  uint64_t    *column_start;
+  uint64_t    x;
+
+  column_start = (uint64_t *) prk_malloc((L+1)*sizeof(uint64_t));
+  if (column_start == NULL) {
+    printf("ERROR: Could not allocate space for particle counts\n");
+    exit(EXIT_FAILURE);
+  }
+
+  #pragma omp parallel
+  {
+  philox_t  rng;
+  uint64_t  *draws = (uint64_t *) prk_malloc(L*sizeof(uint64_t));
+  uint64_t  y, p, pi, count;
+
+  if (draws == NULL) {
+    printf("ERROR: Could not allocate space for random draws\n");
+    exit(EXIT_FAILURE);
+  }
+  philox_init(&rng, PHILOX_SEED);
+
+  #pragma omp for schedule(static)
+  for (x=0; x<L; x++) {
+    philox_jump(&rng, 2*x*L);
+    random_draw_vector(&rng, mu[x], L, draws);
+    for (count=0,y=0; y<L; y++) {
+      if (patch && (x<patch->left || x>patch->right || y<patch->bottom || y>patch->top))
+        continue;
+      count += draws[y];
+    }
+    column_start[x+1] = count;
+  }
+
+  #pragma omp single
+  {
+  column_start[0] = 0;
+  for (x=0; x<L; x++) column_start[x+1] += column_start[x];
+  *n_placed = column_start[L];
+  particles = (particle_t*) prk_malloc((*n_placed) * sizeof(particle_t));
+  if (particles == NULL) {
+    printf("ERROR: Could not allocate space for particles\n");
+    exit(EXIT_FAILURE);
+  }
+  }
+
+  /* same schedule as above, so each thread first touches its own particles */
+  #pragma omp for schedule(static)
+  for (x=0; x<L; x++) {
+    philox_jump(&rng, 2*x*L);
+    random_draw_vector(&rng, mu[x], L, draws);
+    for (pi=column_start[x],y=0; y<L; y++) {
+      if (patch && (x<patch->left || x>patch->right || y<patch->bottom || y>patch->top))
+        continue;
+      for (p=0; p<draws[y]; p++,pi++) {
+        particles[pi].x = x + REL_X;
+        particles[pi].y = y + REL_Y;
+        particles[pi].k = k;
+        particles[pi].m = m;
+      }
+    }
+  }
+  prk_free(draws);
   }
+
+  prk_free(column_start);
+  finish_distribution((*n_placed), particles);
+
+  return particles;
+}
+
+/* Returns nonzero if PRK_RNG selects the Philox generator */
+int use_philox(void) {
+  char *rng = getenv("PRK_RNG");
+  return rng != NULL && strcmp(rng, "philox") == 0;
+}
+
+/* Returns an array of L per-column means, to be freed by the caller */
+double *column_means(uint64_t L) {
+  double *mu = (double *) prk_malloc(L*sizeof(double));
+  if (mu == NULL) {
+    printf("ERROR: Could not allocate space for particle densities\n");
+    exit(EXIT_FAILURE);
+  }
+  return mu;
 }
 
 /* Initializes  particles with geometric distribution */
@@ -178,8 +404,17 @@ particle_t *initializeGeometric(uint64_t n_input, uint64_t L, double rho,
                                 double k, double m, uint64_t *n_placed){
   particle_t  *particles;
   uint64_t    x, y, p, pi, actual_particles;
-  double      A;
+  double      A, *mu;
    
+  if (use_philox()) {
+    mu = column_means(L);
+    A = n_input * ((1.0-rho) / (1.0-pow(rho,L))) / (double)L;
+    for (x=0; x<L; x++) mu[x] = A * pow(rho, x);
+    particles = initializeColumns(L, mu, NULL, k, m, n_placed);
+    prk_free(mu);
+    return particles;
+  }
+
   /* initialize random number generator */
   LCG_init();  
 
@@ -223,9 +458,17 @@ particle_t *initializeGeometric(uint64_t n_input, uint64_t L, double rho,
 particle_t *initializeSinusoidal(uint64_t n_input, uint64_t L, 
                                  double k, double m, uint64_t *n_placed){
   particle_t  *particles;
-  double      step = PRK_M_PI/L;
+  double      step = PRK_M_PI/L, *mu;
   uint64_t    x, y, p, pi, actual_particles;
 
+  if (use_philox()) {
+    mu = column_means(L);
+    for (x=0; x<L; x++) mu[x] = 2.0*cos(x*step)*cos(x*step)*n_input/(L*L);
+    particles = initializeColumns(L, mu, NULL, k, m, n_placed);
+    prk_free(mu);
+    return particles;
+  }
+
   /* initialize random number generator */
   LCG_init();  
 
@@ -269,15 +512,26 @@ particle_t *initializeLinear(uint64_t n_input, uint64_t L, double alpha, double
                              double k, double m, uint64_t *n_placed){
   particle_t  *particles;
   uint64_t    x, y, p, pi, actual_particles;
-  double      total_weight, step = 1.0/L, current_weight;
+  double      total_weight, step = 1.0/L, current_weight, *mu;
    
+  /* Find sum of all weights to normalize the number of particles */
+  total_weight = beta*L-alpha*0.5*step*L*(L-1);
+
+  if (use_philox()) {
+    mu = column_means(L);
+    for (x=0; x<L; x++) {
+      current_weight = (beta - alpha * step * ((double) x));
+      mu[x] = n_input * (current_weight/total_weight)/L;
+    }
+    particles = initializeColumns(L, mu, NULL, k, m, n_placed);
+    prk_free(mu);
+    return particles;
+  }
+
   /* initialize random number generator */
   LCG_init();  
 
   /* first determine total number of particles, then allocate and place them   */   
-
-  /* Find sum of all weights to normalize the number of particles */
-  total_weight = beta*L-alpha*0.5*step*L*(L-1);
    
   /* Loop over columns of cells and assign number of particles proportional linear weight */
   for ((*n_placed)=0,x=0; x<L; x++) {
@@ -319,14 +573,23 @@ particle_t *initializePatch(uint64_t n_input, uint64_t L, bbox_t patch,
                             double k, double m, uint64_t *n_placed){
   particle_t  *particles;
   uint64_t    x, y, p, pi, total_cells, actual_particles;
-  double      particles_per_cell;
+  double      particles_per_cell, *mu;
    
+  total_cells  = (patch.right - patch.left+1)*(patch.top - patch.bottom+1);
+  particles_per_cell = (double) n_input/total_cells;
+
+  if (use_philox()) {
+    mu = column_means(L);
+    for (x=0; x<L; x++) mu[x] = particles_per_cell;
+    particles = initializeColumns(L, mu, &patch, k, m, n_placed);
+    prk_free(mu);
+    return particles;
+  }
+
   /* initialize random number generator */
   LCG_init();  
 
   /* first determine total number of particles, then allocate and place them   */   
-  total_cells  = (patch.right - patch.left+1)*(patch.top - patch.bottom+1);
-  particles_per_cell = (double) n_input/total_cells;
 
   /* Iterate over the columns of cells and assign uniform number of particles */
   for ((*n_placed)=0,x=0; x<L; x++) {
@@ -366,23 +629,25 @@ particle_t *initializePatch(uint64_t n_input, uint64_t L, bbox_t patch,
   return particles;
 }
 
-/* Verifies the final position of a particle */
+/* Verifies the final position of a particle, which has moved in all time
+   steps from the one in which it was placed                               */
 int verifyParticle(particle_t p, uint64_t iterations, double *Qgrid, uint64_t L){
   uint64_t x, y;
-  double   x_final, y_final, x_periodic, y_periodic, disp;
+  double   x_final, y_final, x_periodic, y_periodic, disp, steps;
    
   /* Coordinates of the cell containing the particle initially */
   y = (uint64_t) p.y0;
   x = (uint64_t) p.x0;
+  steps = (double)(iterations+1-p.t0);
    
   /* According to initial location and charge determine the direction of displacements */
-  disp = (double)(iterations+1)*(2*p.k+1);
+  disp = steps*(2*p.k+1);
   x_final = ( (p.q * QG(y,x,L)) > 0) ? p.x0+disp : p.x0-disp;
-  y_final = p.y0 + p.m * (double)(iterations+1);
+  y_final = p.y0 + p.m * steps;
    
   /* apply periodicity, making sure we never mod a negative value */
-  x_periodic = fmod(x_final+(double)(iterations+1) *(2*p.k+1)*L, L);
-  y_periodic = fmod(y_final+(double)(iterations+1) *fabs(p.m)*L, L);
+  x_periodic = fmod(x_final+steps *(2*p.k+1)*L, L);
+  y_periodic = fmod(y_final+steps *fabs(p.m)*L, L);
    
   if ( fabs(p.x - x_periodic) > epsilon || fabs(p.y - y_periodic) > epsilon) {
     return FAILURE;
@@ -401,34 +666,50 @@ void computeCoulomb(double x_dist, double y_dist, double q1, double q2, double *
   return;
 }
 
+/* Fetches the charges at the four corners of cell (x,y) */
+static inline void cornerCharges(uint64_t L, const double *Qgrid, const double *Qcell,
+                                 int64_t x, int64_t y, double *q) {
+  if (Qcell) {
+    const double *c = Qcell + 4*(x*(int64_t)L+y);
+    q[0] = c[0]; q[1] = c[1]; q[2] = c[2]; q[3] = c[3];
+  }
+  else {
+    q[0] = QG(y,x,L); q[1] = QG(y+1,x,L); q[2] = QG(y,x+1,L); q[3] = QG(y+1,x+1,L);
+  }
+}
+
 /* Computes the total Coulomb force on a particle exerted from the charges of the corresponding cell */
-void computeTotalForce(particle_t p, uint64_t L, double *Qgrid, double *fx, double *fy){
+/* Uses the cell-tiled copy of the grid if Qcell is not NULL */
+void computeTotalForce(particle_t p, uint64_t L, double *Qgrid, double *Qcell,
+                       double *fx, double *fy){
   uint64_t  y, x;
   double   tmp_fx, tmp_fy, rel_y, rel_x, tmp_res_x = 0.0, tmp_res_y = 0.0;
+  double   q[4];
    
   /* Coordinates of the cell containing the particle */
   y = (uint64_t) floor(p.y);
   x = (uint64_t) floor(p.x);
   rel_x = p.x -  x;
   rel_y = p.y -  y;
+  cornerCharges(L, Qgrid, Qcell, x, y, q);
    
   /* Coulomb force from top-left charge */
-  computeCoulomb(rel_x, rel_y, p.q, QG(y,x,L), &tmp_fx, &tmp_fy);
+  computeCoulomb(rel_x, rel_y, p.q, q[0], &tmp_fx, &tmp_fy);
   tmp_res_x += tmp_fx;
   tmp_res_y += tmp_fy;
    
   /* Coulomb force from bottom-left charge */
-  computeCoulomb(rel_x, 1.0-rel_y, p.q, QG(y+1,x,L), &tmp_fx, &tmp_fy);
+  computeCoulomb(rel_x, 1.0-rel_y, p.q, q[1], &tmp_fx, &tmp_fy);
   tmp_res_x += tmp_fx;
   tmp_res_y -= tmp_fy;
    
   /* Coulomb force from top-right charge */
-  computeCoulomb(1.0-rel_x, rel_y, p.q, QG(y,x+1,L), &tmp_fx, &tmp_fy);
+  computeCoulomb(1.0-rel_x, rel_y, p.q, q[2], &tmp_fx, &tmp_fy);
   tmp_res_x -= tmp_fx;
   tmp_res_y += tmp_fy;
    
   /* Coulomb force from bottom-right charge */
-  computeCoulomb(1.0-rel_x, 1.0-rel_y, p.q, QG(y+1,x+1,L), &tmp_fx, &tmp_fy);
+  computeCoulomb(1.0-rel_x, 1.0-rel_y, p.q, q[3], &tmp_fx, &tmp_fy);
   tmp_res_x -= tmp_fx;
   tmp_res_y -= tmp_fy;
    
@@ -436,6 +717,97 @@ void computeTotalForce(particle_t p, uint64_t L, double *Qgrid, double *fx, doub
   (*fy) = tmp_res_y;
 }
 
+/* Inlinable version of computeCoulomb for the vectorized force kernel */
+static inline void coulomb(double x_dist, double y_dist, double q1, double q2,
+                           double *fx, double *fy) {
+  double   r2 = x_dist * x_dist + y_dist * y_dist;
+  double   r = sqrt(r2);
+  double   f_coulomb = q1 * q2 / r2;
+
+  (*fx) = f_coulomb * x_dist/r;
+  (*fy) = f_coulomb * y_dist/r;
+}
+
+/* Computes the total Coulomb force on n particles stored as arrays; same
+   arithmetic as computeTotalForce, but each iteration is independent, so
+   the loop vectorizes, with gathers for the grid charges                  */
+void computeTotalForceBatch(uint64_t n, const double * RESTRICT px, const double * RESTRICT py,
+                            const double * RESTRICT pq, uint64_t L, const double * RESTRICT Qgrid,
+                            const double * RESTRICT Qcell, double * RESTRICT fx, double * RESTRICT fy) {
+  uint64_t i;
+
+  #pragma omp simd
+  for (i=0; i<n; i++) {
+    double   tmp_fx, tmp_fy, res_x, res_y;
+    double   x_cell = floor(px[i]), y_cell = floor(py[i]);
+    double   rel_x = px[i] - x_cell, rel_y = py[i] - y_cell;
+    int64_t  x = (int64_t) x_cell, y = (int64_t) y_cell;
+    double   q[4];
+
+    cornerCharges(L, Qgrid, Qcell, x, y, q);
+    coulomb(rel_x, rel_y, pq[i], q[0], &tmp_fx, &tmp_fy);
+    res_x  = tmp_fx;
+    res_y  = tmp_fy;
+    coulomb(rel_x, 1.0-rel_y, pq[i], q[1], &tmp_fx, &tmp_fy);
+    res_x += tmp_fx;
+    res_y -= tmp_fy;
+    coulomb(1.0-rel_x, rel_y, pq[i], q[2], &tmp_fx, &tmp_fy);
+    res_x -= tmp_fx;
+    res_y += tmp_fy;
+    coulomb(1.0-rel_x, 1.0-rel_y, pq[i], q[3], &tmp_fx, &tmp_fy);
+    res_x -= tmp_fx;
+    res_y -= tmp_fy;
+
+    fx[i] = res_x;
+    fy[i] = res_y;
+  }
+}
+
+/* Equals fmod(t,L) for non-negative t, but vectorizes; the subtraction of a
+   multiple of the integer L is exact                                       */
+static inline double periodic(double t, double L) {
+  return t - L*floor(t/L);
+}
+
+/* Computes the permutation that orders n particles by cell, in the same
+   column-major order as the grid: order[i] is the old index of the particle
+   that goes to position i. Coordinates are read with the given stride, so
+   that both layouts can be sorted; count needs room for L*L cells. Particles
+   within a cell end up in arbitrary order                                 */
+void sortByCell(uint64_t n, uint64_t L, const double *px, const double *py,
+                uint64_t stride, uint64_t *count, uint64_t *order) {
+  uint64_t i, c, pos, sum, ncell = L*L;
+
+  #pragma omp parallel
+  {
+  #pragma omp for
+  for (c=0; c<ncell; c++) count[c] = 0;
+
+  #pragma omp for private(c)
+  for (i=0; i<n; i++) {
+    c = (uint64_t) floor(px[i*stride])*L + (uint64_t) floor(py[i*stride]);
+    #pragma omp atomic
+    count[c]++;
+  }
+
+  /* turn the counts into the first position of each cell                  */
+  #pragma omp single
+  for (sum=0, c=0; c<ncell; c++) {
+    pos = count[c];
+    count[c] = sum;
+    sum += pos;
+  }
+
+  #pragma omp for private(c, pos)
+  for (i=0; i<n; i++) {
+    c = (uint64_t) floor(px[i*stride])*L + (uint64_t) floor(py[i*stride]);
+    #pragma omp atomic capture
+    pos = count[c]++;
+    order[pos] = i;
+  }
+  }
+}
+
 int bad_patch(bbox_t *patch, bbox_t *patch_contain) {
   if (patch->left>=patch->right || patch->bottom>=patch->top) return(1);
   if (patch_contain) {
@@ -445,6 +817,181 @@ int bad_patch(bbox_t *patch, bbox_t *patch_contain) {
   return(0);
 }
 
+/* Advances one particle by one time step */
+static inline void moveParticle(particle_t *p, uint64_t L, double *Qgrid, double *Qcell) {
+  double fx = 0.0, fy = 0.0, ax, ay;
+
+  computeTotalForce(*p, L, Qgrid, Qcell, &fx, &fy);
+  ax = fx * MASS_INV;
+  ay = fy * MASS_INV;
+
+  /* Update particle positions, taking into account periodic boundaries */
+  p->x = fmod(p->x + p->v_x*DT + 0.5*ax*DT*DT + L, L);
+  p->y = fmod(p->y + p->v_y*DT + 0.5*ay*DT*DT + L, L);
+
+  /* Update velocities */
+  p->v_x += ax * DT;
+  p->v_y += ay * DT;
+}
+
+/* Returns an array of n pointers holding the first used ones of old, which
+   is freed; the time taken is added to time                               */
+static void *grow_table(void *old, uint64_t used, uint64_t n, size_t size, double *time) {
+  double start = wtime();
+  void   *table = prk_malloc(n*size);
+
+  if (table == NULL) {
+    printf("ERROR: Could not allocate space for the particle store\n");
+    exit(EXIT_FAILURE);
+  }
+  if (old != NULL) {
+    memcpy(table, old, used*size);
+    prk_free(old);
+  }
+  *time += wtime() - start;
+  return table;
+}
+
+/* Takes a block from the pool, allocating a new chunk if none is free */
+static particle_t *pool_get(pool_t *pool) {
+  double     start;
+  particle_t *chunk;
+  uint64_t   b;
+
+  if (pool->nfree == 0) {
+    if (pool->nblocks+PIC_CHUNK > pool->maxfree) {
+      pool->maxfree = MAX(2*pool->maxfree, pool->nblocks+PIC_CHUNK);
+      pool->free = (particle_t **) grow_table(pool->free, 0, pool->maxfree,
+                                              sizeof(particle_t *), &pool->alloc_time);
+    }
+    start = wtime();
+    chunk = (particle_t *) prk_malloc(PIC_CHUNK*PIC_BLOCK*sizeof(particle_t));
+    pool->alloc_time += wtime() - start;
+    if (chunk == NULL) {
+      printf("ERROR: Could not allocate space for particle blocks\n");
+      exit(EXIT_FAILURE);
+    }
+    for (b=0; b<PIC_CHUNK; b++) pool->free[pool->nfree++] = chunk + (PIC_CHUNK-1-b)*PIC_BLOCK;
+    pool->nblocks += PIC_CHUNK;
+    pool->chunks++;
+  }
+  return pool->free[--pool->nfree];
+}
+
+/* Returns a block to the pool; the stack has room for all blocks */
+static void pool_put(pool_t *pool, particle_t *block) {
+  pool->free[pool->nfree++] = block;
+}
+
+/* Makes sure the tables of the store have room for nblock blocks */
+static void store_grow(store_t *s, pool_t *pool, uint64_t nblock) {
+  if (nblock <= s->maxblock) return;
+  s->maxblock = MAX(2*s->maxblock, nblock);
+  s->block  = (particle_t **) grow_table(s->block, s->nblock, s->maxblock,
+                                         sizeof(particle_t *), &pool->alloc_time);
+  s->dest   = (particle_t **) grow_table(s->dest, 0, s->maxblock,
+                                         sizeof(particle_t *), &pool->alloc_time);
+  s->offset = (uint64_t *)    grow_table(s->offset, 0, s->maxblock,
+                                         sizeof(uint64_t), &pool->alloc_time);
+}
+
+/* Makes room for nslot slots, taking blocks from the pool as needed */
+static void store_reserve(store_t *s, pool_t *pool, uint64_t nslot) {
+  uint64_t nblock = (nslot+PIC_BLOCK-1)/PIC_BLOCK;
+
+  store_grow(s, pool, nblock);
+  while (s->nblock < nblock) s->block[s->nblock++] = pool_get(pool);
+}
+
+/* Number of used slots in block b of the store */
+static inline uint64_t store_slots(const store_t *s, uint64_t b) {
+  return MIN(PIC_BLOCK, s->nslot-b*PIC_BLOCK);
+}
+
+/* Gathers the live particles at the front of fresh blocks, in parallel, and
+   returns the old blocks to the pool                                      */
+static void store_compact(store_t *s, pool_t *pool) {
+  uint64_t b, i, pos, sum, nblock = (s->nlive+PIC_BLOCK-1)/PIC_BLOCK;
+  particle_t **swap;
+
+  #pragma omp parallel for private(i, sum)
+  for (b=0; b<s->nblock; b++) {
+    for (sum=0, i=0; i<store_slots(s,b); i++) sum += s->block[b][i].t0 >= 0;
+    s->offset[b] = sum;
+  }
+  for (sum=0, b=0; b<s->nblock; b++) {
+    pos = s->offset[b];
+    s->offset[b] = sum;
+    sum += pos;
+  }
+  for (b=0; b<nblock; b++) s->dest[b] = pool_get(pool);
+
+  #pragma omp parallel for private(i, pos)
+  for (b=0; b<s->nblock; b++) {
+    pos = s->offset[b];
+    for (i=0; i<store_slots(s,b); i++) if (s->block[b][i].t0 >= 0) {
+      s->dest[pos/PIC_BLOCK][pos%PIC_BLOCK] = s->block[b][i];
+      pos++;
+    }
+  }
+
+  for (b=0; b<s->nblock; b++) pool_put(pool, s->block[b]);
+  swap      = s->block;
+  s->block  = s->dest;
+  s->dest   = swap;
+  s->nblock = nblock;
+  s->nslot  = s->nlive;
+}
+
+/* Removes all particles in the cells of patch; returns their number */
+static uint64_t removeParticles(store_t *s, bbox_t patch) {
+  uint64_t   b, i, x, y, removed = 0;
+  particle_t *p;
+
+  #pragma omp parallel for private(i, x, y, p) reduction(+:removed)
+  for (b=0; b<s->nblock; b++) {
+    for (i=0; i<store_slots(s,b); i++) {
+      p = &s->block[b][i];
+      if (p->t0 < 0) continue;
+      x = (uint64_t) p->x;
+      y = (uint64_t) p->y;
+      if (x>=patch.left && x<=patch.right && y>=patch.bottom && y<=patch.top) {
+        p->t0 = -1;
+        removed++;
+      }
+    }
+  }
+  s->nlive -= removed;
+  return removed;
+}
+
+/* Appends per_cell particles to every cell of patch, placed and charged
+   like the initial ones, at time step iter; returns their number          */
+static uint64_t injectParticles(store_t *s, pool_t *pool, bbox_t patch, uint64_t per_cell,
+                                int64_t k, int64_t m, uint64_t iter) {
+  uint64_t   rows  = patch.top-patch.bottom+1,
+             total = (patch.right-patch.left+1)*rows*per_cell,
+             first = s->nslot, i, c, slot;
+  particle_t *p;
+
+  store_reserve(s, pool, first+total);
+  #pragma omp parallel for private(c, slot, p)
+  for (i=0; i<total; i++) {
+    c    = i/per_cell;
+    slot = first+i;
+    p    = &s->block[slot/PIC_BLOCK][slot%PIC_BLOCK];
+    p->x = patch.left   + c/rows + REL_X;
+    p->y = patch.bottom + c%rows + REL_Y;
+    p->k = k;
+    p->m = m;
+    finish_particle(p);
+    p->t0 = iter;
+  }
+  s->nslot += total;
+  s->nlive += total;
+  return total;
+}
+
 int main(int argc, char ** argv) {
 
   int         args_used = 1;     // keeps track of # consumed arguments
@@ -458,15 +1005,42 @@ int main(int argc, char ** argv) {
                                  // particles-- (2*k)+1 cells per time step 
   double      alpha, beta;       // slope and offset values for linear particle distribution
   bbox_t      grid_patch,        // whole grid
-              init_patch;        // subset of grid used for localized initialization
-  int         particles_per_cell;// number of particles per cell to be injected
+              init_patch,        // subset of grid used for localized initialization
+              cell_patch,        // all cells of the grid
+              inject_patch,      // cells that particles are injected into
+              remove_patch;      // cells whose particles are removed
+  uint64_t    particles_per_cell;// number of particles per cell to be injected
+  uint64_t    inject_every = 0,  // inject particles every so many steps
+              remove_every = 0,  // remove particles every so many steps
+              compact_every = 10;// compact the particle store every so many steps
+  int         dynamic = 0;       // particles are injected or removed
+  pool_t      pool = {NULL, 0, 0, 0, 0, 0.0};     // blocks of the particle store
+  store_t     store = {NULL, NULL, NULL, 0, 0, 0, 0};// dynamic particle population
+  uint64_t    injected = 0,      // numbers of particles injected and removed
+              removed = 0;
+  uint64_t    moves = 0;         // particle moves in the timed time steps
+  uint64_t    compactions = 0;   // number of compactions
+  uint64_t    pool_chunks;       // chunks allocated before the time steps
+  double      pool_time,         // allocation time before the time steps
+              compact_time = 0.0;// time spent compacting the particle store
   int         correctness = 1;   // determines whether simulation was correct
   double      *Qgrid;            // field of fixed charges
+  double      *Qcell = NULL;     // cell-tiled copy of Qgrid, if requested
+  uint64_t    sort_every = 0;    // sort particles by cell every so many steps
+  uint64_t    *cell_count,       // work space for sorting
+              *order;
+  particle_t  *sorted;           // particles in sorted order
+  double      *soa_sorted;       // hot particle fields in sorted order
+  double      sort_time = 0.0;   // time spent sorting particles
+  uint64_t    sorts = 0;         // number of sorts
   particle_t  *particles, *p;    // the particles array
+  particle_soa_t soa;            // hot particle fields in the SoA layout
+  int         layout_soa = 0;    // store hot particle fields as arrays
+  char        *env;              // value of PRK_LAYOUT, PRK_INJECT, etc.
   uint64_t    iter, i;           // dummies
-  double      fx, fy, ax, ay;    // forces and accelerations
   int         error=0;           // used for graceful exit after error
   double      avg_time, pic_time;// timing parameters
+  prk_harness_t harness;         // per-time-step timing
   int         nthread_input,     // thread parameters                                   
               nthread; 
   int         num_error=0;       // flag that signals that requested and obtained
@@ -499,6 +1073,7 @@ int main(int argc, char ** argv) {
   }
 
   omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("PIC");
 
   iterations = atol(*++argv);  args_used++;   
   if (iterations<1) {
@@ -575,6 +1150,71 @@ int main(int argc, char ** argv) {
     }
   }
 
+  env = getenv("PRK_LAYOUT");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"soa")) layout_soa = 1;
+    else if (strcmp(env,"aos")) {
+      printf("ERROR: PRK_LAYOUT must be aos or soa: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  env = getenv("PRK_SORT");
+  if (env != NULL && *env != '\0') {
+    if (atol(env) < 0) {
+      printf("ERROR: PRK_SORT must be non-negative: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+    sort_every = atol(env);
+  }
+
+  env = getenv("PRK_GRID");
+  if (env != NULL && *env != '\0' && strcmp(env,"column") && strcmp(env,"cell")) {
+    printf("ERROR: PRK_GRID must be column or cell: %s\n", env);
+    exit(EXIT_FAILURE);
+  }
+
+  cell_patch = (bbox_t){0, L-1, 0, L-1};
+  env = getenv("PRK_INJECT");
+  if (env != NULL && *env != '\0') {
+    if (sscanf(env, "%" SCNu64 ":%" SCNu64 ":%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%" SCNu64,
+               &inject_every, &particles_per_cell, &inject_patch.left, &inject_patch.right,
+               &inject_patch.bottom, &inject_patch.top) != 6 ||
+        inject_every < 1 || particles_per_cell < 1 || bad_patch(&inject_patch, &cell_patch)) {
+      printf("ERROR: PRK_INJECT must be <f>:<n>:<xleft>,<xright>,<ybottom>,<ytop>, f,n>0, ");
+      printf("within the grid cells: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+    dynamic = 1;
+  }
+
+  env = getenv("PRK_REMOVE");
+  if (env != NULL && *env != '\0') {
+    if (sscanf(env, "%" SCNu64 ":%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%" SCNu64,
+               &remove_every, &remove_patch.left, &remove_patch.right,
+               &remove_patch.bottom, &remove_patch.top) != 5 ||
+        remove_every < 1 || bad_patch(&remove_patch, &cell_patch)) {
+      printf("ERROR: PRK_REMOVE must be <f>:<xleft>,<xright>,<ybottom>,<ytop>, f>0, ");
+      printf("within the grid cells: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+    dynamic = 1;
+  }
+
+  env = getenv("PRK_COMPACT");
+  if (env != NULL && *env != '\0') {
+    if (atol(env) < 0) {
+      printf("ERROR: PRK_COMPACT must be non-negative: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+    compact_every = atol(env);
+  }
+
+  if (dynamic && (layout_soa || sort_every)) {
+    printf("ERROR: PRK_INJECT and PRK_REMOVE need PRK_LAYOUT=aos and no PRK_SORT\n");
+    exit(EXIT_FAILURE);
+  }
+
   #pragma omp parallel 
   {
 
@@ -608,55 +1248,239 @@ int main(int argc, char ** argv) {
     }
     printf("Particle charge semi-increment = %lu\n", k);
     printf("Vertical velocity              = %lu\n", m);
+    printf("Random number generator        = %s\n", use_philox() ? "Philox" : "LCG");
+    if (layout_soa)
+      printf("Particle layout                = SoA, batch size %d\n", PIC_BATCH);
+    else
+      printf("Particle layout                = AoS\n");
+    if (sort_every)
+      printf("Particle sort by cell          = every %lu steps\n", sort_every);
+    else
+      printf("Particle sort by cell          = none\n");
+    env = getenv("PRK_GRID");
+    printf("Grid storage                   = %s\n",
+           env != NULL && !strcmp(env,"cell") ? "cell-tiled" : "column major");
+    if (inject_every)
+      printf("Particle injection             = %lu per cell every %lu steps into %lu, %lu, %lu, %lu\n",
+             particles_per_cell, inject_every, inject_patch.left, inject_patch.right,
+             inject_patch.bottom, inject_patch.top);
+    if (remove_every)
+      printf("Particle removal               = every %lu steps from %lu, %lu, %lu, %lu\n",
+             remove_every, remove_patch.left, remove_patch.right,
+             remove_patch.bottom, remove_patch.top);
+    if (dynamic) {
+      printf("Particle store                 = blocks of %d particles, pool chunks of %d blocks\n",
+             PIC_BLOCK, PIC_CHUNK);
+      if (compact_every)
+        printf("Particle store compaction      = every %lu steps\n", compact_every);
+      else
+        printf("Particle store compaction      = none\n");
+    }
+  }
+  }
+  bail_out(num_error);
+  }
+
+  /* Initialize grid of charges and particles; this is done outside the
+     parallel region above, so that initializeColumns can use all threads  */
+  Qgrid = initializeGrid(L);
+  env = getenv("PRK_GRID");
+  if (env != NULL && !strcmp(env,"cell")) Qcell = initializeCellGrid(L, Qgrid);
    
-    /* Initialize grid of charges and particles */
-    Qgrid = initializeGrid(L);
-   
-    switch(particle_mode) {
-    case GEOMETRIC:  particles = initializeGeometric(n, L, rho, k, m, &n);      break;
-    case SINUSOIDAL: particles = initializeSinusoidal(n, L, k, m, &n);          break;
-    case LINEAR:     particles = initializeLinear(n, L, alpha, beta, k, m, &n); break;
-    case PATCH:      particles = initializePatch(n, L, init_patch, k, m, &n);   break;
-    default:         printf("ERROR: Unsupported particle distribution\n");  exit(FAILURE);
-    }   
+  switch(particle_mode) {
+  case GEOMETRIC:  particles = initializeGeometric(n, L, rho, k, m, &n);      break;
+  case SINUSOIDAL: particles = initializeSinusoidal(n, L, k, m, &n);          break;
+  case LINEAR:     particles = initializeLinear(n, L, alpha, beta, k, m, &n); break;
+  case PATCH:      particles = initializePatch(n, L, init_patch, k, m, &n);   break;
+  default:         printf("ERROR: Unsupported particle distribution\n");  exit(FAILURE);
+  }   
+
+  printf("Number of particles placed     = %lld\n", n);
+
+  if (layout_soa) {
+    soa.x   = (double *) prk_malloc(5*n*sizeof(double));
+    if (soa.x == NULL) {
+      printf("ERROR: Could not allocate space for particle arrays\n");
+      exit(EXIT_FAILURE);
+    }
+    soa.y   = soa.x   + n;
+    soa.v_x = soa.y   + n;
+    soa.v_y = soa.v_x + n;
+    soa.q   = soa.v_y + n;
 
-    printf("Number of particles placed     = %lld\n", n);
+    #pragma omp parallel for schedule(static)
+    for (i=0; i<n; i++) {
+      soa.x[i]   = particles[i].x;
+      soa.y[i]   = particles[i].y;
+      soa.v_x[i] = particles[i].v_x;
+      soa.v_y[i] = particles[i].v_y;
+      soa.q[i]   = particles[i].q;
+    }
   }
+
+  /* the dynamic population lives in blocks from the pool                   */
+  if (dynamic) {
+    store_reserve(&store, &pool, n);
+    #pragma omp parallel for
+    for (i=0; i<n; i++) store.block[i/PIC_BLOCK][i%PIC_BLOCK] = particles[i];
+    store.nslot = store.nlive = n;
+    prk_free(particles);
+    pool_chunks = pool.chunks;
+    pool_time   = pool.alloc_time;
   }
-  bail_out(num_error);
+
+  if (sort_every) {
+    cell_count = (uint64_t *)   prk_malloc(L*L*sizeof(uint64_t));
+    order      = (uint64_t *)   prk_malloc(n*sizeof(uint64_t));
+    sorted     = (particle_t *) prk_malloc(n*sizeof(particle_t));
+    soa_sorted = layout_soa ? (double *) prk_malloc(5*n*sizeof(double)) : NULL;
+    if (!cell_count || !order || !sorted || (layout_soa && !soa_sorted)) {
+      printf("ERROR: Could not allocate space for sorting particles\n");
+      exit(EXIT_FAILURE);
+    }
   }
 
+  prk_harness_init(&harness, "PIC", "OpenMP", (int) iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "grid_size", "%llu", (unsigned long long) L);
+  prk_harness_param(&harness, "particles", "%llu", (unsigned long long) n);
+  prk_harness_param(&harness, "init_mode", "%s", init_mode);
+  prk_harness_param(&harness, "layout", "%s", layout_soa ? "soa" : "aos");
+  prk_harness_param(&harness, "sort_every", "%llu", (unsigned long long) sort_every);
+
   for (iter=0; iter<=iterations; iter++) {
     
-    /* start the timer after one warm-up time step */
-    if (iter==1) {
-      pic_time = wtime();  
+    /* start the timer after one warm-up time step; every time step ends
+       with a parallel loop, so the master thread sees it complete           */
+    if (iter>=1) prk_harness_tick(&harness);
+
+    /* injection and removal events; the compaction squeezes out the holes
+       left by removed particles                                             */
+    if (dynamic) {
+      uint64_t b;
+      if (remove_every && iter>0 && iter%remove_every==0)
+        removed  += removeParticles(&store, remove_patch);
+      if (inject_every && iter>0 && iter%inject_every==0)
+        injected += injectParticles(&store, &pool, inject_patch, particles_per_cell, k, m, iter);
+      if (compact_every && iter>0 && iter%compact_every==0 && store.nlive<store.nslot) {
+        double compact_start = wtime();
+        store_compact(&store, &pool);
+        compact_time += wtime() - compact_start;
+        compactions++;
+      }
+
+      #pragma omp parallel for private(i, p)
+      for (b=0; b<store.nblock; b++) {
+        for (i=0; i<store_slots(&store,b); i++) {
+          p = &store.block[b][i];
+          if (p->t0 >= 0) moveParticle(p, L, Qgrid, Qcell);
+        }
+      }
+      if (iter>0) moves += store.nlive;
+      continue;
+    }
+
+    /* restore the cell order of the particles; the verification data is
+       permuted along, also in the SoA layout                                  */
+    if (sort_every && iter>0 && iter%sort_every==0) {
+      double sort_start = wtime();
+      particle_t *swap;
+
+      if (layout_soa) {
+        double *swap_soa;
+        sortByCell(n, L, soa.x, soa.y, 1, cell_count, order);
+        #pragma omp parallel for
+        for (i=0; i<n; i++) {
+          soa_sorted[i]     = soa.x[order[i]];
+          soa_sorted[n+i]   = soa.y[order[i]];
+          soa_sorted[2*n+i] = soa.v_x[order[i]];
+          soa_sorted[3*n+i] = soa.v_y[order[i]];
+          soa_sorted[4*n+i] = soa.q[order[i]];
+          sorted[i]         = particles[order[i]];
+        }
+        swap_soa   = soa.x;
+        soa.x      = soa_sorted;
+        soa_sorted = swap_soa;
+        soa.y      = soa.x   + n;
+        soa.v_x    = soa.y   + n;
+        soa.v_y    = soa.v_x + n;
+        soa.q      = soa.v_y + n;
+      }
+      else {
+        sortByCell(n, L, &particles[0].x, &particles[0].y,
+                   sizeof(particle_t)/sizeof(double), cell_count, order);
+        #pragma omp parallel for
+        for (i=0; i<n; i++) sorted[i] = particles[order[i]];
+      }
+      swap      = particles;
+      particles = sorted;
+      sorted    = swap;
+      sort_time += wtime() - sort_start;
+      sorts++;
+    }
+
+    if (layout_soa) {
+      uint64_t b;
+      #pragma omp parallel for schedule(static)
+      for (b=0; b<n; b+=PIC_BATCH) {
+        double   bfx[PIC_BATCH], bfy[PIC_BATCH];
+        uint64_t j, nb = MIN(PIC_BATCH, n-b);
+        double   * RESTRICT x   = soa.x   + b, * RESTRICT y   = soa.y   + b,
+                 * RESTRICT v_x = soa.v_x + b, * RESTRICT v_y = soa.v_y + b;
+
+        computeTotalForceBatch(nb, x, y, soa.q+b, L, Qgrid, Qcell, bfx, bfy);
+
+        #pragma omp simd
+        for (j=0; j<nb; j++) {
+          double bax = bfx[j] * MASS_INV;
+          double bay = bfy[j] * MASS_INV;
+          x[j]    = periodic(x[j] + v_x[j]*DT + 0.5*bax*DT*DT + L, (double) L);
+          y[j]    = periodic(y[j] + v_y[j]*DT + 0.5*bay*DT*DT + L, (double) L);
+          v_x[j] += bax * DT;
+          v_y[j] += bay * DT;
+        }
+      }
+      if (iter>0) moves += n;
+      continue;
     }
  
     /* Calculate forces on particles and update positions */
-    #pragma omp parallel for private(i, p, fx, fy, ax, ay)
-    for (i=0; i<n; i++) {
-      p = particles;
-      fx = 0.0;
-      fy = 0.0;
-      computeTotalForce(p[i], L, Qgrid, &fx, &fy);
-      ax = fx * MASS_INV;
-      ay = fy * MASS_INV;
-
-      /* Update particle positions, taking into account periodic boundaries */
-      p[i].x = fmod(p[i].x + p[i].v_x*DT + 0.5*ax*DT*DT + L, L);
-      p[i].y = fmod(p[i].y + p[i].v_y*DT + 0.5*ay*DT*DT + L, L);
+    #pragma omp parallel for
+    for (i=0; i<n; i++) moveParticle(&particles[i], L, Qgrid, Qcell);
+    if (iter>0) moves += n;
+  }
    
-      /* Update velocities */
-      p[i].v_x += ax * DT;
-      p[i].v_y += ay * DT;
+  prk_harness_tick(&harness);
+  pic_time = prk_harness_elapsed(&harness);
+
+  /* final positions go back to the particles for verification */
+  if (layout_soa) {
+    #pragma omp parallel for schedule(static)
+    for (i=0; i<n; i++) {
+      particles[i].x = soa.x[i];
+      particles[i].y = soa.y[i];
     }
+    prk_free(soa.x);
   }
    
-  pic_time = wtime() - pic_time;
-   
-  /* Run the verification test */
-  for (i=0; i<n; i++) {
+  /* Run the verification test; the live particles in the store must also
+     account for all placed, injected and removed ones                       */
+  if (dynamic) {
+    uint64_t b, live = 0;
+    for (b=0; b<store.nblock; b++) {
+      for (i=0; i<store_slots(&store,b); i++) {
+        p = &store.block[b][i];
+        if (p->t0 < 0) continue;
+        correctness *= verifyParticle(*p, iterations, Qgrid, L);
+        live++;
+      }
+    }
+    if (live != store.nlive || live != n+injected-removed) {
+      printf("ERROR: %lu live particles, expected %lu\n", live, n+injected-removed);
+      correctness = 0;
+    }
+  }
+  else for (i=0; i<n; i++) {
     correctness *= verifyParticle(particles[i], iterations, Qgrid, L);
   }
    
@@ -665,8 +1489,26 @@ int main(int argc, char ** argv) {
 #ifdef VERBOSE
     printf("Simulation time is %lf seconds\n", pic_time);
 #endif
-    avg_time = n*iterations/pic_time;
+    avg_time = moves/pic_time;
     printf("Rate (Mparticles_moved/s): %lf\n", 1.0e-6*avg_time);
+    prk_harness_report(&harness, "Mparticles_moved/s", 1.0e-6*n);
+    prk_harness_finalize(&harness);
+    if (sort_every)
+      printf("Sort time (s): %lf in %lu sorts, %.1lf%% of time steps\n",
+             sort_time, sorts, 100.0*sort_time/pic_time);
+    if (dynamic) {
+      printf("Particles injected/removed: %lu/%lu, %lu live at the end\n",
+             injected, removed, store.nlive);
+      printf("Allocation time (s): %lf in %lu chunk allocations during the time steps, ",
+             pool.alloc_time-pool_time, pool.chunks-pool_chunks);
+      printf("%lf before\n", pool_time);
+      printf("Compaction time (s): %lf in %lu compactions, %.1lf%% of time steps\n",
+             compact_time, compactions, 100.0*compact_time/pic_time);
+      printf("Particle memory (MB): %.3lf in the pool, %.3lf live (%.1lf%%)\n",
+             1.0e-6*pool.nblocks*PIC_BLOCK*sizeof(particle_t),
+             1.0e-6*store.nlive*sizeof(particle_t),
+             pool.nblocks ? 100.0*store.nlive/(pool.nblocks*PIC_BLOCK) : 0.0);
+    }
   } else {
     printf("Solution does not validate\n");
   }
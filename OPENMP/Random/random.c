@@ -89,6 +89,36 @@ USAGE:   The program takes as input the number of threads involved, the 2log
          all pseudo-random indices into the table, but only updates table
          elements that fall inside its chunk. Hence, this version is safe, and
          there is no false sharing. It is also non-scalable.
+         If the BUCKETED variable is set, each thread owns a contiguous chunk
+         of the table as in the chunked version, but computes only its own
+         share of the pseudo-random indices. Each batch of LOOKAHEAD indices
+         is sorted into buckets by owner thread, and every bucket is passed
+         to its owner through a lock-free single-producer, single-consumer
+         queue (one per pair of threads, QUEUE_SIZE entries). Owners apply
+         the updates they receive, so every update is exact without atomic
+         operations. A thread whose queue to another thread is full applies
+         its own incoming updates while it waits. 
+         With PRK_RANDOM=batched (in the shared-table version without
+         atomics or chunks) each thread advances its streams together, a
+         batch of LOOKAHEAD updates at a time, and applies each batch with
+         an update kernel of prk_random_simd.h, which prefetches the table
+         entry PRK_PREFETCH updates ahead (default 16, 0 disables it) and,
+         on CPUs with AVX-512, applies eight updates at a time with gather
+         and scatter. The default is PRK_RANDOM=plain.
+         PRK_TABLESIZE=n replaces the table size 2^<log2 tablesize> with
+         any n up to 2^32, and PRK_DISTRIBUTION=uniform|hotset:<f>,<p>|
+         zipf:<theta> draws the table indices from a skewed distribution
+         instead of a uniform one (see prk_random_index.h). The indices
+         are computed from the same random numbers, so the verification
+         stays exact. Batched updates need the uniform distribution and
+         a power-of-two table.
+
+         With PRK_SWEEP set, <# threads> is the largest thread count of an
+         in-process scaling sweep (see prk_sweep.h).  In weak scaling the
+         table size, and with it the number of updates, grows with the
+         thread count; the table is allocated once, at its largest size.
+         The vector length must be divisible by every thread count of the
+         sweep, and VERBOSE builds do not support sweeps.
 
          <progname>  <# threads> <log2 tablesize> <#update ratio> <vector length>
 
@@ -98,9 +128,15 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_topology_bind()
          bail_out()
+         prk_harness_*()
+         prk_sweep_*()
          PRK_starts()
          poweroftwo()
+         queue_push(), queue_drain()   (bucketed version)
+         prk_random_simd()             (batched updates)
+         prk_index()                   (table index of a random number)
 
 NOTES:   This program is derived from HPC Challenge Random Access. The random 
          number generator computes successive powers of 0x2, modulo the 
@@ -149,6 +185,11 @@ HISTORY: Written by Rob Van der Wijngaart, June 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
+#include <prk_topology.h>
+#include <prk_random_simd.h>
+#include <prk_random_index.h>
 
 /* Define constants                                                                */
 /* PERIOD = (2^63-1)/7 = 7*73*127*337*92737*649657                                 */
@@ -164,20 +205,62 @@ HISTORY: Written by Rob Van der Wijngaart, June 2006.
   #define SEQSEED            834568137686317453LL
 #endif 
 
+#ifndef BUCKETED
+  #define BUCKETED 0
+#endif
+
 #if HPCC
   #undef  ATOMIC
   #undef  CHUNKED
+  #undef  BUCKETED
+  #define BUCKETED 0
   #undef  ERRORPERCENT
   #define ERRORPERCENT 1
 #else
-  #if CHUNKED
+  #if CHUNKED || BUCKETED
     #undef ATOMIC
   #endif
+  #if BUCKETED
+    #undef CHUNKED
+  #endif
 #endif
 
 static u64Int PRK_starts(s64Int);
 static int    poweroftwo(int);
 
+/* updates generated by one thread before they are applied in batched mode
+   or sorted into buckets                                                   */
+#ifndef LOOKAHEAD
+  #define LOOKAHEAD  1024
+#endif
+
+#if defined(ATOMIC) || defined(CHUNKED) || BUCKETED
+  #define BATCHED_UPDATES 0
+#else
+  #define BATCHED_UPDATES 1
+#endif
+
+#if BUCKETED
+/* capacity of each queue between two threads (a power of two)             */
+#ifndef QUEUE_SIZE
+  #define QUEUE_SIZE 1024
+#endif
+
+/* single-producer, single-consumer ring buffer of updates; head is only
+   written by the consumer, tail by the producer, and both only grow        */
+typedef struct {
+  volatile s64Int head;
+  char            pad1[64-sizeof(s64Int)];
+  volatile s64Int tail;
+  char            pad2[64-sizeof(s64Int)];
+} queue_t;
+
+static void   queue_push(queue_t *, u64Int *, u64Int *, s64Int, u64Int *, 
+                         queue_t *, u64Int *, int, const prk_index_t *, u64Int *);
+static s64Int queue_drain(queue_t *, u64Int *, int, const prk_index_t *, u64Int *,
+                          u64Int *);
+#endif
+
 int main(int argc, char **argv) {
 
   int               my_ID;       /* thread ID                                      */
@@ -186,6 +269,7 @@ int main(int argc, char **argv) {
   s64Int            i, j, round, oldsize; /* dummies                               */
   s64Int            error;       /* number of incorrect table elements             */
   s64Int            tablesize;   /* aggregate table size (all threads              */
+  s64Int            base_size;   /* table size of the first sweep configuration    */
   s64Int            nupdate;     /* number of updates per thread                   */
   size_t            tablespace;  /* bytes per thread required for table            */
   u64Int            *ran;        /* vector of random numbers                       */
@@ -196,11 +280,24 @@ int main(int argc, char **argv) {
 #endif
   u64Int * RESTRICT Table;       /* (pseudo-)randomly accessed array               */
   double            random_time;
+  prk_harness_t     harness;     /* timing and counters of the update phase        */
   int               nthread_input;   /* thread parameters                          */
   int               nthread;
   int               log2tablesize; /* log2 of aggregate table size                 */
   int               num_error=0; /* flag that signals that requested and obtained
                                     numbers of threads are the same                */
+  int               batched = 0; /* true if updates are applied in batches        */
+  int               distance = 16; /* prefetch distance of batched updates        */
+  prk_random_update_t update = NULL; /* kernel applying a batch of updates        */
+  char              *env;        /* value of PRK_RANDOM and PRK_PREFETCH           */
+  prk_index_t       ix;          /* mapping of random numbers to table indices     */
+  const char        *msg;        /* error message of prk_index_init                */
+  char              dist[96];    /* description of the index distribution          */
+  prk_sweep_t       sweep;       /* thread counts and results of a sweep           */
+  int               sweeping;    /* nonzero if doing a scaling sweep               */
+  int               nconfig, config; /* number of configurations run, and index    */
+  int               nthread_config; /* number of threads of this configuration    */
+  int               valid;       /* nonzero if this configuration validated        */
 
   printf("Parallel Research Kernels version %s\n", PRKVERSION);
   printf("OpenMP Random Access test\n");
@@ -232,6 +329,7 @@ int main(int argc, char **argv) {
   }
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
 
   log2tablesize  = atoi(*++argv);
   if (log2tablesize < 1){
@@ -280,6 +378,41 @@ int main(int argc, char **argv) {
     }
   }
 
+  env = getenv("PRK_TABLESIZE");
+  if (env != NULL && *env != '\0') {
+    tablesize = atoll(env);
+    if (tablesize < 1) {
+      printf("ERROR: PRK_TABLESIZE must be positive: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  /* in weak scaling sweeps the table grows with the thread count; the 
+     checks below are done for the largest table, which is allocated once  */
+  sweeping  = prk_sweep_init(&sweep, nthread_input);
+  nconfig   = sweeping ? sweep.count : 1;
+  base_size = tablesize;
+  if (sweeping) {
+    if (VERBOSE) {
+      printf("ERROR: PRK_SWEEP is not supported in VERBOSE builds\n");
+      exit(EXIT_FAILURE);
+    }
+    for (config=0; config<sweep.count; config++) {
+      if (nstarts%sweep.threads[config]) {
+        printf("ERROR: vector length %d must be divisible by # threads %d of PRK_SWEEP\n",
+               nstarts, sweep.threads[config]);
+        exit(EXIT_FAILURE);
+      }
+      tablesize = MAX(tablesize, (s64Int) (base_size*prk_sweep_scale(&sweep,config)));
+    }
+  }
+
+  msg = prk_index_init(&ix, tablesize);
+  if (msg) {
+    printf("ERROR: %s\n", msg);
+    exit(EXIT_FAILURE);
+  }
+
   /* even though the table size can be represented, computing the space 
      required for the table may lead to overflow                            */
   tablespace = (size_t) tablesize*sizeof(u64Int);
@@ -305,6 +438,13 @@ int main(int argc, char **argv) {
     printf("reduce log2 tablesize or update ratio\n");
     exit(EXIT_FAILURE);
   }
+  /* every stream does the same number of updates in each of two rounds     */
+  nupdate = nupdate/(2*nstarts)*(2*nstarts);
+  if (nupdate == 0) {
+    printf("ERROR: table size times update ratio must be at least twice ");
+    printf("the vector length\n");
+    exit(EXIT_FAILURE);
+  }
 
   Table = (u64Int *) prk_malloc(tablespace);
   if (!Table) {
@@ -313,6 +453,65 @@ int main(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
+  env = getenv("PRK_RANDOM");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"batched")) batched = 1;
+    else if (strcmp(env,"plain")) {
+      printf("ERROR: PRK_RANDOM must be plain or batched: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  env = getenv("PRK_PREFETCH");
+  if (env != NULL) distance = atoi(env);
+  if (distance < 0) {
+    printf("ERROR: PRK_PREFETCH must be non-negative: %s\n", env);
+    exit(EXIT_FAILURE);
+  }
+  if (batched && (!BATCHED_UPDATES || VERBOSE)) {
+    printf("ERROR: batched updates need the shared table without atomics and VERBOSE=0\n");
+    exit(EXIT_FAILURE);
+  }
+  if (batched && !ix.mask) {
+    printf("ERROR: batched updates need a power-of-two table and uniform indices\n");
+    exit(EXIT_FAILURE);
+  }
+  if (batched) update = prk_random_simd();
+
+  /* the two update rounds are timed as a single iteration                  */
+  if (!sweeping) {
+    prk_harness_init(&harness, "Random", "OpenMP", 1);
+    prk_harness_param(&harness, "threads", "%d", nthread_input);
+    prk_harness_param(&harness, "tablesize", "%lld", (long long) tablesize);
+    prk_harness_param(&harness, "update_ratio", "%d", update_ratio);
+    prk_harness_param(&harness, "vector_length", "%d", nstarts);
+    prk_harness_param(&harness, "update", "%s", batched ? prk_random_simd_isa() : "plain");
+    if (batched) prk_harness_param(&harness, "prefetch", "%d", distance);
+    prk_harness_param(&harness, "distribution", "%s", prk_index_describe(&ix, dist, sizeof(dist)));
+  }
+  else {
+    printf("Update ratio           = "FSTR64U"\n", (u64Int) update_ratio);
+    printf("Vector length          = "FSTR64U"\n", (u64Int) nstarts);
+    printf("Index distribution     = %s\n", prk_index_describe(&ix, dist, sizeof(dist)));
+  }
+
+  for (config=0; config<nconfig; config++) {
+
+  nthread_config = nthread_input;
+  if (sweeping) {
+    nthread_config = sweep.threads[config];
+    tablesize = (s64Int) (base_size*prk_sweep_scale(&sweep,config));
+    msg = prk_index_init(&ix, tablesize);
+    if (!msg && batched && !ix.mask)
+      msg = "batched updates need a power-of-two table and uniform indices";
+    if (msg) {
+      printf("ERROR: %s\n", msg);
+      exit(EXIT_FAILURE);
+    }
+    nupdate = update_ratio*tablesize/(2*nstarts)*(2*nstarts);
+    omp_set_num_threads(nthread_config);
+    /* let the new team fault in the pages of the table                     */
+    prk_sweep_discard(Table, tablespace);
+  }
   error = 0;
 
   #pragma omp parallel private(i, j, ran, round, index, my_ID) reduction(+:error)
@@ -325,19 +524,20 @@ int main(int argc, char **argv) {
   #pragma omp master 
   {  
   nthread = omp_get_num_threads();
-  if (nthread != nthread_input) {
+  if (nthread != nthread_config) {
     num_error = 1;
     printf("ERROR: number of requested threads %d does not equal ",
-           nthread_input);
+           nthread_config);
     printf("number of spawned threads %d\n", nthread);
   } 
-  else {
+  else if (!sweeping) {
     printf("Number of threads      = "FSTR64U"\n", (u64Int) nthread_input);
     printf("Table size (shared)    = "FSTR64U"\n", tablesize);
     printf("Update ratio           = "FSTR64U"\n", (u64Int) update_ratio);
     printf("Number of updates      = "FSTR64U"\n", nupdate);
     printf("Vector length          = "FSTR64U"\n", (u64Int) nstarts);
     printf("Percent errors allowed = "FSTR64U"\n", (u64Int) ERRORPERCENT);
+    printf("Index distribution     = %s\n", dist);
 #if RESTRICT_KEYWORD
     printf("No aliasing            = on\n");
 #else
@@ -347,17 +547,64 @@ int main(int argc, char **argv) {
     printf("Shared table, atomic updates\n");
 #elif defined(CHUNKED)
     printf("Shared, chunked table\n");
+#elif BUCKETED
+    printf("Shared table, updates bucketed by owner thread\n");
+    printf("Lookahead              = "FSTR64U"\n", (u64Int) LOOKAHEAD);
+    printf("Queue size             = "FSTR64U"\n", (u64Int) QUEUE_SIZE);
 #else
     printf("Shared table, non-atomic updates\n");
 #endif
+    if (batched) {
+      printf("Update mode            = batched\n");
+      printf("Lookahead              = "FSTR64U"\n", (u64Int) LOOKAHEAD);
+      printf("Prefetch distance      = "FSTR64U"\n", (u64Int) distance);
+      printf("Update kernel          = %s\n", prk_random_simd_isa());
+    }
+  }
+  }
+  bail_out(num_error);
+
+#if BUCKETED
+  /* queue[src*nthread+dst] carries updates from thread src to thread dst;
+     done[src] is set once thread src has generated all its updates         */
+  static queue_t   *queue;
+  static u64Int    *queue_data;
+  static volatile int *done;
+  u64Int *batch, *sorted, *hist = NULL;
+  int    *count;
+  s64Int chunk = (tablesize+nthread-1)/nthread;
+
+  #pragma omp master
+  {
+  queue      = (queue_t *) prk_malloc(nthread*nthread*sizeof(queue_t));
+  queue_data = (u64Int *)  prk_malloc(nthread*nthread*(size_t)QUEUE_SIZE*sizeof(u64Int));
+  done       = (volatile int *) prk_malloc(nthread*sizeof(int));
+  if (!queue || !queue_data || !done) {
+    printf("ERROR: Could not allocate space for update queues\n");
+    num_error = 1;
+  }
   }
+  bail_out(num_error);
+  for (j=0; j<nthread; j++) queue[my_ID*nthread+j].head = queue[my_ID*nthread+j].tail = 0;
+  done[my_ID] = 0;
+
+  batch  = (u64Int *) prk_malloc(2*LOOKAHEAD*sizeof(u64Int));
+  count  = (int *)    prk_malloc((nthread+1)*sizeof(int));
+  if (!batch || !count) {
+    printf("ERROR: Thread %d could not allocate space for update buckets\n", my_ID);
+    num_error = 1;
   }
   bail_out(num_error);
+  sorted = batch + LOOKAHEAD;
+#if VERBOSE
+  hist = Hist;
+#endif
+#endif
 
 #if CHUNKED
   /* compute upper and lower table bounds for this thread                     */
   u64Int low =  my_ID   *(tablesize/nthread);
-  u64Int up  = (my_ID+1)*(tablesize/nthread);
+  u64Int up  = my_ID == nthread-1 ? tablesize : (my_ID+1)*(tablesize/nthread);
   my_starts = nstarts;
 #else
   my_starts = nstarts/nthread;
@@ -378,7 +625,8 @@ int main(int argc, char **argv) {
   #pragma omp barrier
   #pragma omp master
   {
-  random_time = wtime();
+  if (sweeping) random_time = wtime();
+  else          prk_harness_tick(&harness);
   }
 
   /* ran is privatized. Must make sure for non-chunked version that 
@@ -389,6 +637,67 @@ int main(int argc, char **argv) {
   int offset = my_ID*my_starts;
 #endif
 
+#if BUCKETED
+  /* each batch advances every stream of this thread by steps values         */
+  s64Int steps = MAX(1, LOOKAHEAD/my_starts), nbatch, k, owner;
+  for (round=0; round <2; round++) {
+
+    for (j=0; j<my_starts; j++) {
+      ran[j] = PRK_starts(SEQSEED+(nupdate/nstarts)*(j+offset));
+    }
+    for (i=0; i<nupdate/(nstarts*2); i+=steps) {
+      nbatch = 0;
+      for (k=i; k<MIN(i+steps,nupdate/(nstarts*2)); k++) for (j=0; j<my_starts; j++) {
+        ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
+        batch[nbatch++] = ran[j];
+      }
+      /* counting sort of the batch by owner thread                           */
+      for (owner=0; owner<=nthread; owner++) count[owner] = 0;
+      for (k=0; k<nbatch; k++) count[prk_index(&ix, batch[k])/chunk+1]++;
+      for (owner=0; owner<nthread; owner++) count[owner+1] += count[owner];
+      for (k=0; k<nbatch; k++) sorted[count[prk_index(&ix, batch[k])/chunk]++] = batch[k];
+      /* count[owner] is now the end of the bucket of owner                   */
+      for (owner=0; owner<nthread; owner++) {
+        k = owner ? count[owner-1] : 0;
+        if (owner == my_ID) for (; k<count[owner]; k++) {
+          index = prk_index(&ix, sorted[k]);
+          Table[index] ^= sorted[k];
+#if VERBOSE
+          Hist[index] += 1;
+#endif
+        }
+        else if (count[owner] > k)
+          queue_push(&queue[my_ID*nthread+owner], queue_data+(my_ID*nthread+owner)*(s64Int)QUEUE_SIZE,
+                     sorted+k, count[owner]-k, Table, queue, queue_data, my_ID, 
+                     &ix, hist);
+      }
+    }
+  }
+
+  /* apply incoming updates until every thread is done and the queues are empty */
+  #pragma omp flush
+  done[my_ID] = 1;
+  #pragma omp flush
+  {
+    int all_done;
+    do {
+      all_done = 1;
+      for (j=0; j<nthread; j++) if (!done[j]) all_done = 0;
+      #pragma omp flush
+    } while (queue_drain(queue, queue_data, my_ID, &ix, Table, hist) || !all_done);
+  }
+#else
+  u64Int *batch = NULL;
+  s64Int steps = MAX(1, LOOKAHEAD/my_starts), nbatch, k;
+  if (batched) {
+    batch = (u64Int *) prk_malloc(LOOKAHEAD*sizeof(u64Int));
+    if (!batch) {
+      printf("ERROR: Thread %d could not allocate space for batch of updates\n", my_ID);
+      num_error = 1;
+    }
+  }
+  bail_out(num_error);
+
   /* do two identical rounds of Random Access to make sure we recover 
      the initial condition                                                 */
   for (round=0; round <2; round++) {
@@ -396,11 +705,25 @@ int main(int argc, char **argv) {
     for (j=0; j<my_starts; j++) {
       ran[j] = PRK_starts(SEQSEED+(nupdate/nstarts)*(j+offset));
     }
+#if BATCHED_UPDATES
+    /* advance all streams of this thread by steps values per batch        */
+    if (batched) {
+      for (i=0; i<nupdate/(nstarts*2); i+=steps) {
+        nbatch = 0;
+        for (k=i; k<MIN(i+steps,nupdate/(nstarts*2)); k++) for (j=0; j<my_starts; j++) {
+          ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
+          batch[nbatch++] = ran[j];
+        }
+        update(Table, tablesize, batch, nbatch, distance);
+      }
+      continue;
+    }
+#endif
     for (j=0; j<my_starts; j++) {
       /* because we do two rounds, we divide nupdates in two               */
       for (i=0; i<nupdate/(nstarts*2); i++) {
         ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
-        index = ran[j] & (tablesize-1);
+        index = prk_index(&ix, ran[j]);
 #if defined(ATOMIC) 
         #pragma omp atomic      
 #elif defined(CHUNKED)
@@ -417,12 +740,32 @@ int main(int argc, char **argv) {
       }
     }
   }
+#endif
 
+  #pragma omp barrier
   #pragma omp master 
   { 
-  random_time = wtime() - random_time;
+  if (sweeping) random_time = wtime() - random_time;
+  else {
+    prk_harness_tick(&harness);
+    random_time = prk_harness_elapsed(&harness);
+  }
   }
 
+  /* release this configuration's work space before the next team forms     */
+  prk_free(ran);
+  prk_free(batch);
+#if BUCKETED
+  prk_free(count);
+  #pragma omp barrier
+  #pragma omp master
+  {
+  prk_free(queue);
+  prk_free(queue_data);
+  prk_free((void *) done);
+  }
+#endif
+
   } /* end of OpenMP parallel region                                       */
 
   /* verification test */
@@ -435,8 +778,16 @@ int main(int argc, char **argv) {
     }
   }
 
-  if ((error && (ERRORPERCENT==0)) ||
-      ((double)error/(double)tablesize > ((double) ERRORPERCENT)*0.01)) {
+  valid = !((error && (ERRORPERCENT==0)) ||
+             ((double)error/(double)tablesize > ((double) ERRORPERCENT)*0.01));
+  if (sweeping) {
+    if (!valid) printf("ERROR: number of incorrect table elements = "FSTR64U
+                       " with %d threads\n", error, nthread_config);
+    prk_sweep_record(&sweep, config, tablesize, random_time,
+                     1.e-9*nupdate/random_time, valid);
+    continue;
+  }
+  if (!valid) {
     printf("ERROR: number of incorrect table elements = "FSTR64U"\n", error);
     exit(EXIT_FAILURE);
   }
@@ -444,6 +795,10 @@ int main(int argc, char **argv) {
     printf("Solution validates, number of errors: %ld\n",(long) error);
     printf("Rate (GUPs/s): %lf, time (s) = %lf\n", 
            1.e-9*nupdate/random_time,random_time);
+    /* every update reads and writes back a whole cache line */
+    prk_harness_model(&harness, 0.0, 2.0*64*nupdate);
+    prk_harness_report(&harness, "GUPs/s", 1.e-9*nupdate);
+    prk_harness_finalize(&harness);
   }
 
 #if VERBOSE
@@ -452,9 +807,80 @@ int main(int argc, char **argv) {
 	printf("HistHist[%4.1d]=%9.1d\n",(int)i,HistHist[i]);
 #endif
 
+  } /* end of configurations                                                 */
+
+  if (sweeping) {
+    prk_sweep_report(&sweep, "Random", "table size", "GUPs/s");
+    for (config=0; config<sweep.count; config++) if (!sweep.valid[config]) exit(EXIT_FAILURE);
+  }
   exit(EXIT_SUCCESS);
 }
 
+#if BUCKETED
+
+/* apply to Table all updates waiting in the queues of all threads to thread 
+   me, and return how many there were                                       */
+s64Int queue_drain(queue_t *queue, u64Int *queue_data, int me, const prk_index_t *ix,
+                   u64Int *Table, u64Int *hist) {
+
+  int    src, nthread = omp_get_num_threads();
+  s64Int head, tail, total = 0, index;
+  u64Int *data, ran;
+
+  for (src=0; src<nthread; src++) {
+    if (src == me) continue;
+    head = queue[src*nthread+me].head;
+    #pragma omp flush
+    tail = queue[src*nthread+me].tail;
+    #pragma omp flush
+    if (tail == head) continue;
+    data = queue_data + (src*nthread+me)*(s64Int)QUEUE_SIZE;
+    for (; head<tail; head++) {
+      ran   = data[head&(QUEUE_SIZE-1)];
+      index = prk_index(ix, ran);
+      Table[index] ^= ran;
+#if VERBOSE
+      hist[index] += 1;
+#endif
+    }
+    total += tail - queue[src*nthread+me].head;
+    #pragma omp flush
+    queue[src*nthread+me].head = tail;
+    #pragma omp flush
+  }
+  return total;
+}
+
+/* append the n updates in bucket to queue q (with storage data) of thread me; 
+   while q is full, thread me applies its own incoming updates so that 
+   threads waiting on each other's queues cannot deadlock                   */
+void queue_push(queue_t *q, u64Int *data, u64Int *bucket, s64Int n, u64Int *Table,
+                queue_t *queue, u64Int *queue_data, int me, const prk_index_t *ix,
+                u64Int *hist) {
+
+  s64Int head, tail = q->tail, space, k;
+
+  while (n > 0) {
+    #pragma omp flush
+    head  = q->head;
+    space = QUEUE_SIZE - (tail - head);
+    if (space == 0) {
+      queue_drain(queue, queue_data, me, ix, Table, hist);
+      continue;
+    }
+    if (space > n) space = n;
+    for (k=0; k<space; k++) data[(tail+k)&(QUEUE_SIZE-1)] = bucket[k];
+    bucket += space;
+    n      -= space;
+    tail   += space;
+    #pragma omp flush
+    q->tail = tail;
+    #pragma omp flush
+  }
+}
+
+#endif
+
 /* Utility routine to start random number generator at nth step            */
 u64Int PRK_starts(s64Int n)
 { 
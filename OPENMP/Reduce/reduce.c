@@ -53,6 +53,29 @@ USAGE:   The program takes as input the number of threads, the length
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         Two more algorithms target long vectors, whose reduction is
+         limited by memory bandwidth:
+           hierarchical  the threads of each socket first reduce their
+                         vectors into the vector of the lowest-numbered
+                         thread of the socket, each thread taking a segment;
+                         then every thread sums one segment of these
+                         per-socket results into the master vector, so only
+                         one vector per socket crosses the socket boundary
+           rabenseifner  reduce-scatter followed by a gather: every thread
+                         sums one segment of all vectors and writes it into
+                         the master vector
+         Both start each stage as soon as the vectors it reads are ready, as
+         signaled by padded atomic flags, rather than after a barrier.
+         Segments written to the master vector use non-temporal stores
+         where available (SSE2). The sockets are found with
+         prk_topology_socket(), so bind the threads (see PRK_BIND).
+
+         With PRK_SWEEP set, <# threads> is the largest thread count of an
+         in-process scaling sweep (see prk_sweep.h).  Every thread brings
+         two vectors of the given length, so the work grows with the
+         number of threads and the sweep is a weak scaling sweep,
+         whatever PRK_SWEEP_MODE says.
+
 FUNCTIONS CALLED:
 
          Other than OpenMP or standard C functions, the following 
@@ -60,6 +83,12 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_topology_bind()
+         prk_topology_socket()
+         segment_bounds()
+         sum_segment()
+         prk_sweep_*()
+         prk_harness_*()
 
 NOTES:   The long-optimal algorithm is based on a distributed memory
          algorithm decribed in:
@@ -79,6 +108,14 @@ HISTORY: Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
+#include <prk_sweep.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define LINEAR            11
 #define BINARY_BARRIER    12
@@ -86,19 +123,68 @@ HISTORY: Written by Rob Van der Wijngaart, March 2006.
 #define LONG_OPTIMAL      14
 #define NONE              15
 #define LOCAL             16
-#define VEC0(id,i)        vector[(id        )*(vector_length)+i]
-#define VEC1(id,i)        vector[(id+nthread)*(vector_length)+i]
+#define HIERARCHICAL      17
+#define RABENSEIFNER      18
+#define VEC0(id,i)        vector[(id        )*(vector_stride)+i]
+#define VEC1(id,i)        vector[(id+nthread)*(vector_stride)+i]
 /* define shorthand for flag with cache line padding                             */
 #define LINEWORDS         16
 #define flag(i)           flag[(i)*LINEWORDS]
+/* atomic flags: local part done, and first stage of hierarchical done        */
+#define ready(i)          ready[(i)*LINEWORDS]
+#define done(i)           ready[(nthread+(i))*LINEWORDS]
+/* number of vector elements summed at a time in sum_segment                 */
+#define BLOCK             512
+
+/* bounds of segment k out of parts of a vector of the given length; segments
+   start on cache line boundaries, so that no two threads write the same line,
+   because the vectors do too: they are vector_stride apart, a multiple of a
+   line, in a line-aligned buffer                                             */
+static void segment_bounds(long length, int parts, int k, long *first, long *last) {
+  long size = ((length+parts-1)/parts + LINEWORDS/2-1)/(LINEWORDS/2)*(LINEWORDS/2);
+  *first = MIN(length, k*size);
+  *last  = MIN(length, (k+1)*size);
+}
+
+/* dest[first:last] = sum of vec[id][first:last] over the nids threads in ids;
+   with stream set, dest is written with non-temporal stores                 */
+static void sum_segment(double *vector, long vector_stride, const int *ids, int nids,
+                        double *dest, long first, long last, int stream) {
+  double tmp[BLOCK];
+  long   i, ii, len;
+  int    k;
+
+  for (ii=first; ii<last; ii+=BLOCK) {
+    len = MIN(BLOCK, last-ii);
+    for (i=0; i<len; i++) tmp[i] = vector[ids[0]*vector_stride+ii+i];
+    for (k=1; k<nids; k++) {
+      double * RESTRICT src = vector + ids[k]*vector_stride + ii;
+      for (i=0; i<len; i++) tmp[i] += src[i];
+    }
+    i = 0;
+#ifdef __SSE2__
+    if (stream) {
+      for (; i<len && ((uintptr_t)(dest+ii+i) & 15); i++) dest[ii+i] = tmp[i];
+      for (; i+1<len; i+=2) _mm_stream_pd(dest+ii+i, _mm_loadu_pd(tmp+i));
+    }
+#endif
+    for (; i<len; i++) dest[ii+i] = tmp[i];
+  }
+#ifdef __SSE2__
+  /* non-temporal stores are weakly ordered; complete them before signaling  */
+  if (stream) _mm_sfence();
+#endif
+}
 
 int main(int argc, char ** argv)
 {
   int    my_ID;           /* Thread ID                                       */
   long   vector_length;   /* length of vectors to be aggregated              */
+  long   vector_stride;   /* distance between vectors, whole cache lines     */
   long   total_length;    /* bytes needed to store reduction vectors         */
   double reduce_time,     /* timing parameters                               */
          avgtime;
+  prk_harness_t harness;  /* per-iteration timing, when not sweeping         */
   double epsilon=1.e-8;   /* error tolerance                                 */
   int    group_size,      /* size of aggregating half of thread pool         */
          old_size,        /* group size in previous binary tree iteration    */
@@ -106,6 +192,7 @@ int main(int argc, char ** argv)
   double element_value;   /* reference element value for final vector        */
   char   *algorithm;      /* reduction algorithm selector                    */
   int    intalgorithm;    /* integer encoding of algorithm selector          */
+  int    requested;       /* algorithm selected on the command line          */
   int    iterations;      /* number of times the reduction is carried out    */
   int    flag[MAX_THREADS*LINEWORDS]; /* used for pairwise synchronizations  */
   int    start[MAX_THREADS],
@@ -115,8 +202,23 @@ int main(int argc, char ** argv)
   int    nthread_input,   /* thread parameters                               */
          nthread;   
   double RESTRICT *vector;/* vector pair to be reduced                       */
+  atomic_long *ready;     /* flags of the hierarchical and rabenseifner 
+                             algorithms, set to the iteration number + 1     */
+  int    socket[MAX_THREADS], /* socket of each thread                       */
+         order[MAX_THREADS],  /* threads ordered by socket                   */
+         gstart[MAX_THREADS+1], /* start of each socket's threads in order   */
+         leader[MAX_THREADS], /* lowest-numbered thread of each socket       */
+         ngroup;          /* number of sockets occupied by threads           */
+  int    my_group, my_rank; /* socket of a thread, and its rank on the socket */
+  long   first, last;     /* bounds of a segment                             */
+  long   epoch;           /* flag value of the current iteration             */
   int    num_error=0;     /* flag that signals that requested and obtained
                              numbers of threads are the same                 */
+  prk_sweep_t sweep;      /* thread counts and results of a sweep            */
+  int    sweeping;        /* nonzero if doing a scaling sweep                */
+  int    nconfig, k;      /* number of configurations run, and index         */
+  int    nthread_config;  /* number of threads of a configuration            */
+  int    valid;           /* nonzero if a configuration validated            */
 
 /*****************************************************************************
 ** process and test input parameters    
@@ -128,7 +230,8 @@ int main(int argc, char ** argv)
   if (argc != 4 && argc != 5){
     printf("Usage:     %s <# threads> <# iterations> <vector length> ", *argv);
     printf("[<alghorithm>]\n");
-    printf("Algorithm: linear, binary-barrier, binary-p2p, or long-optimal\n");
+    printf("Algorithm: linear, binary-barrier, binary-p2p, long-optimal, ");
+    printf("hierarchical, or rabenseifner\n");
     return(EXIT_FAILURE);
   }
 
@@ -141,6 +244,7 @@ int main(int argc, char ** argv)
   }
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
 
   iterations = atoi(*++argv);
   if (iterations < 1){
@@ -154,7 +258,8 @@ int main(int argc, char ** argv)
     exit(EXIT_FAILURE);
   }
 
-  total_length = vector_length*2*nthread_input*sizeof(double);
+  vector_stride = (vector_length+LINEWORDS/2-1)/(LINEWORDS/2)*(LINEWORDS/2);
+  total_length  = vector_stride*2*nthread_input*sizeof(double);
   vector = (double *) prk_malloc(total_length);
   if (!vector) {
     printf("ERROR: Could not allocate space for vectors: %ld\n", total_length);
@@ -164,22 +269,53 @@ int main(int argc, char ** argv)
   algorithm = "binary-p2p";
   if (argc == 5) algorithm = *++argv;
 
-  intalgorithm = NONE;
-  if (!strcmp(algorithm,"linear"        )) intalgorithm = LINEAR;
-  if (!strcmp(algorithm,"binary-barrier")) intalgorithm = BINARY_BARRIER;
-  if (!strcmp(algorithm,"binary-p2p"    )) intalgorithm = BINARY_P2P;
-  if (!strcmp(algorithm,"long-optimal"  )) intalgorithm = LONG_OPTIMAL;
-  if (intalgorithm == NONE) {
+  requested = NONE;
+  if (!strcmp(algorithm,"linear"        )) requested = LINEAR;
+  if (!strcmp(algorithm,"binary-barrier")) requested = BINARY_BARRIER;
+  if (!strcmp(algorithm,"binary-p2p"    )) requested = BINARY_P2P;
+  if (!strcmp(algorithm,"long-optimal"  )) requested = LONG_OPTIMAL;
+  if (!strcmp(algorithm,"hierarchical"  )) requested = HIERARCHICAL;
+  if (!strcmp(algorithm,"rabenseifner"  )) requested = RABENSEIFNER;
+  if (requested == NONE) {
     printf("Wrong algorithm: %s; choose linear, binary-barrier, ", algorithm);
-    printf("binary-p2p, or long-optimal\n");
+    printf("binary-p2p, long-optimal, hierarchical, or rabenseifner\n");
     exit(EXIT_FAILURE);
   }
+
+  ready = (atomic_long *) prk_malloc(2*nthread_input*LINEWORDS*sizeof(atomic_long));
+  if (!ready) {
+    printf("ERROR: Could not allocate space for flags\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* the number of vectors grows with the threads, so sweeps are weak scaling */
+  sweeping = prk_sweep_init(&sweep, nthread_input);
+  sweep.weak = 1;
+  nconfig  = sweeping ? sweep.count : 1;
+  if (sweeping) {
+    printf("Vector length                  = %ld\n", vector_length);
+    printf("Reduction algorithm            = %s\n", algorithm);
+    printf("Number of iterations           = %d\n", iterations);
+  }
   else {
-    if (nthread_input == 1) intalgorithm = LOCAL;
+    prk_harness_init(&harness, "Reduce", "OpenMP", iterations);
+    prk_harness_param(&harness, "threads", "%d", nthread_input);
+    prk_harness_param(&harness, "length", "%ld", vector_length);
+    prk_harness_param(&harness, "algorithm", "%s", algorithm);
   }
 
+  for (k=0; k<nconfig; k++) {
+
+  nthread_config = sweeping ? sweep.threads[k] : nthread_input;
+  intalgorithm   = (nthread_config == 1) ? LOCAL : requested;
+  omp_set_num_threads(nthread_config);
+  /* let the new team fault in the pages of the vectors                      */
+  if (sweeping) prk_sweep_discard(vector, total_length);
+  for (i=0; i<2*nthread_config; i++) atomic_init(&ready[i*LINEWORDS], 0);
+
   #pragma omp parallel private(i, old_size, group_size, my_ID, iter, start, end, \
-                               segment_size, stage, id, my_donor, my_segment) 
+                               segment_size, stage, id, my_donor, my_segment, \
+                               my_group, my_rank, first, last, epoch) 
   {
 
   my_ID = omp_get_thread_num();
@@ -187,13 +323,13 @@ int main(int argc, char ** argv)
   #pragma omp master 
   {
   nthread = omp_get_num_threads();
-  if (nthread != nthread_input) {
+  if (nthread != nthread_config) {
     num_error = 1;
     printf("ERROR: number of requested threads %d does not equal ",
-           nthread_input);
+           nthread_config);
     printf("number of spawned threads %d\n", nthread);
   } 
-  else {
+  else if (!sweeping) {
     printf("Number of threads              = %d\n",nthread_input);
     printf("Vector length                  = %ld\n", vector_length);
     printf("Reduction algorithm            = %s\n", algorithm);
@@ -202,21 +338,49 @@ int main(int argc, char ** argv)
   }
   bail_out(num_error);
 
+  /* group the threads by socket, keeping them in order within a socket      */
+  socket[my_ID] = prk_topology_socket();
+  #pragma omp barrier
+  #pragma omp master
+  {
+  ngroup = 0;
+  for (id=0; id<nthread; id++) {
+    for (i=0; i<ngroup; i++) if (socket[leader[i]] == socket[id]) break;
+    if (i == ngroup) leader[ngroup++] = id;
+  }
+  for (gstart[0]=0, i=0; i<ngroup; i++) {
+    gstart[i+1] = gstart[i];
+    for (id=0; id<nthread; id++) if (socket[id] == socket[leader[i]]) order[gstart[i+1]++] = id;
+  }
+  if (intalgorithm == HIERARCHICAL && !sweeping)
+    printf("Number of sockets              = %d\n", ngroup);
+  }
+  #pragma omp barrier
+  for (my_rank=0; order[my_rank]!=my_ID; my_rank++);
+  for (my_group=0; gstart[my_group+1]<=my_rank; my_group++);
+  my_rank -= gstart[my_group];
+
   for (iter=0; iter<=iterations; iter++) {
 
-    /* start timer after a warmup iteration                                        */
+    /* start timer after a warmup iteration; later iterations are not
+       separated by barriers, so they are timed as the master thread, which
+       holds the result, sees them                                           */
     if (iter == 1) { 
       #pragma omp barrier
+    }
+    if (iter >= 1) {
       #pragma omp master
       {
-        reduce_time = wtime();
+        if (sweeping) { if (iter == 1) reduce_time = wtime(); }
+        else          prk_harness_tick(&harness);
       }
     }
 
     /* in case of the long-optimal algorithm we need a barrier before the
        reinitialization to make sure that we don't overwrite parts of the
        vector before other threads are done with those parts                 */
-    if (intalgorithm == LONG_OPTIMAL) {
+    if (intalgorithm == LONG_OPTIMAL || intalgorithm == HIERARCHICAL ||
+        intalgorithm == RABENSEIFNER) {
       #pragma omp barrier
     }
 
@@ -244,6 +408,11 @@ int main(int argc, char ** argv)
       VEC0(my_ID,i) += VEC1(my_ID,i);
     }
 
+    /* tell the threads that read my vector that it is ready                  */
+    epoch = iter+1;
+    if (intalgorithm == HIERARCHICAL || intalgorithm == RABENSEIFNER)
+      atomic_store_explicit(&ready(my_ID), epoch, memory_order_release);
+
     /* now do the "non-local" part                                           */
 
     switch (intalgorithm) {
@@ -348,6 +517,34 @@ int main(int argc, char ** argv)
       }
       break;
 
+    case HIERARCHICAL:
+
+      /* reduce-scatter among the threads of my socket, into its leader      */
+      for (id=gstart[my_group]; id<gstart[my_group+1]; id++)
+        while (atomic_load_explicit(&ready(order[id]), memory_order_acquire) < epoch);
+      segment_bounds(vector_length, gstart[my_group+1]-gstart[my_group], my_rank,
+                     &first, &last);
+      sum_segment(vector, vector_stride, order+gstart[my_group],
+                  gstart[my_group+1]-gstart[my_group],
+                  &VEC0(leader[my_group],0), first, last, 0);
+      atomic_store_explicit(&done(my_ID), epoch, memory_order_release);
+
+      /* sum my segment of the socket results into the master vector         */
+      for (id=0; id<nthread; id++)
+        while (atomic_load_explicit(&done(id), memory_order_acquire) < epoch);
+      segment_bounds(vector_length, nthread, my_ID, &first, &last);
+      sum_segment(vector, vector_stride, leader, ngroup, &VEC0(0,0), first, last, 1);
+      break;
+
+    case RABENSEIFNER:
+
+      /* reduce my segment of all vectors, and gather it in the master vector */
+      for (id=0; id<nthread; id++)
+        while (atomic_load_explicit(&ready(id), memory_order_acquire) < epoch);
+      segment_bounds(vector_length, nthread, my_ID, &first, &last);
+      sum_segment(vector, vector_stride, order, nthread, &VEC0(0,0), first, last, 1);
+      break;
+
     } /* end of algorithm switch statement                                   */
 
   } /* end of iter loop                                                      */
@@ -355,7 +552,11 @@ int main(int argc, char ** argv)
   #pragma omp barrier
   #pragma omp master
   {
-    reduce_time = wtime() - reduce_time;
+    if (sweeping) reduce_time = wtime() - reduce_time;
+    else {
+      prk_harness_tick(&harness);
+      reduce_time = prk_harness_elapsed(&harness);
+    }
   }
 
 
@@ -364,21 +565,35 @@ int main(int argc, char ** argv)
   /* verify correctness */
   element_value = (double)nthread*(2.0*(double)nthread+1.0);
 
-  for (i=0; i<vector_length; i++) {
+  for (valid=1, i=0; i<vector_length && valid; i++) {
     if (ABS(VEC0(0,i) - element_value) >= epsilon) {
        printf("First error at i=%d; value: %lf; reference value: %lf\n",
               i, VEC0(0,i), element_value);
-       exit(EXIT_FAILURE);
+       valid = 0;
     }
   }
+  avgtime = reduce_time/iterations;
+  if (sweeping) {
+    prk_sweep_record(&sweep, k, vector_length, avgtime,
+                     1.0E-06 * (2.0*nthread-1.0)*vector_length/avgtime, valid);
+    continue;
+  }
+  if (!valid) exit(EXIT_FAILURE);
 
   printf("Solution validates\n");
 #if VERBOSE
   printf("Element verification value: %lf\n", element_value);
 #endif
-  avgtime = reduce_time/iterations;
   printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
          1.0E-06 * (2.0*nthread-1.0)*vector_length/avgtime, avgtime);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0*nthread-1.0)*vector_length);
+  prk_harness_finalize(&harness);
 
+  } /* end of configurations                                                 */
+
+  if (sweeping) {
+    prk_sweep_report(&sweep, "Reduce", "length", "MFlops/s");
+    for (k=0; k<sweep.count; k++) if (!sweep.valid[k]) exit(EXIT_FAILURE);
+  }
   exit(EXIT_SUCCESS);
 }
@@ -45,6 +45,23 @@ USAGE:   The program takes as input the total number of times the reference
   
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
+
+         With contended counters (CONTENDED=1), PRK_SYNC selects at run
+         time how the counter pair is updated, instead of LOCK:
+           omp        as selected by LOCK at compile time (default)
+           fetch_add  C11 atomic_fetch_add on each counter (INTEGER=1)
+           cas        compare-and-swap loop on each counter
+           ticket     ticket lock around the pair update
+           mcs        MCS queue lock; every thread spins on its own node
+           clh        CLH queue lock; every thread spins on its
+                      predecessor's node
+           sharded    every thread counts in a shard of its own and adds
+                      the shard to the shared counters after PRK_COMBINE
+                      updates (default 64) and at the end
+         Dependent updates (DEPENDENT=1) need both counters updated at once,
+         so they only allow omp and the three locks. The words the threads
+         synchronize on (lock words, queue nodes, shards) each get a cache
+         line of their own, unless PRK_PADDING=packed.
  
 FUNCTIONS CALLED:
  
@@ -55,6 +72,9 @@ FUNCTIONS CALLED:
          bail_out()
          getpagesize()
          private_stream()
+         sync_update()
+         sync_flush()
+         prk_harness_*()
  
 HISTORY: Written by Rob Van der Wijngaart, January 2006.
          Updated by RvdW to include private work, and a dependence 
@@ -65,6 +85,9 @@ HISTORY: Written by Rob Van der Wijngaart, January 2006.
 #include <par-res-kern_general.h>
 #include <inttypes.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
+#include <stdatomic.h>
  
 /* shouldn't need the prototype below, since it is defined in <unistd.h>. But it
    depends on the existence of symbols __USE_BSD or _USE_XOPEN_EXTENDED, neither
@@ -85,6 +108,168 @@ extern int getpagesize(void);
   #define DTYPE double
 #endif
 
+#define SYNC_OMP       0
+#define SYNC_FETCH_ADD 1
+#define SYNC_CAS       2
+#define SYNC_TICKET    3
+#define SYNC_MCS       4
+#define SYNC_CLH       5
+#define SYNC_SHARDED   6
+#define SYNC_TYPES     7
+
+static const char *sync_name[SYNC_TYPES] = {"omp", "fetch_add", "cas", "ticket", "mcs",
+                                            "clh", "sharded"};
+
+/* bytes per padded synchronization word                                        */
+#define LINESIZE     128
+
+/* node of the MCS and CLH queue locks                                          */
+typedef struct qnode {
+  _Atomic(struct qnode *) next;   /* MCS: successor in the queue                */
+  atomic_int              locked; /* MCS: wait on own node; CLH: on predecessor */
+} qnode_t;
+
+typedef struct {
+  int          type;           /* one of the SYNC_* values                      */
+  long         combine;        /* updates between flushes of a shard            */
+  atomic_long  *next, *serving;/* ticket lock                                   */
+  _Atomic(qnode_t *) *tail;    /* tail of the MCS or CLH queue                  */
+  char         *nodes;         /* queue nodes, nthread+1 of them                */
+  size_t       node_stride;    /* distance between queue nodes in bytes         */
+  DTYPE        *shard;         /* per-thread counter pairs                      */
+  size_t       shard_stride;   /* distance between shards in DTYPEs             */
+} sync_t;
+
+typedef struct {
+  int          id;             /* thread number                                 */
+  qnode_t      *node;          /* queue node currently owned by the thread      */
+  long         pending;        /* updates in the shard since the last flush     */
+} sync_thread_t;
+
+#define NODE(s,i)  ((qnode_t *)((s)->nodes+(i)*(s)->node_stride))
+
+static void atomic_add(DTYPE *counter, DTYPE value) {
+#if INTEGER
+  atomic_fetch_add_explicit((_Atomic DTYPE *) counter, value, memory_order_relaxed);
+#else
+  _Atomic DTYPE *c = (_Atomic DTYPE *) counter;
+  DTYPE old = atomic_load_explicit(c, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(c, &old, old+value, memory_order_relaxed,
+                                                memory_order_relaxed));
+#endif
+}
+
+static void cas_increment(DTYPE *counter) {
+  _Atomic DTYPE *c = (_Atomic DTYPE *) counter;
+  DTYPE old = atomic_load_explicit(c, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(c, &old, old+1, memory_order_relaxed,
+                                                memory_order_relaxed));
+}
+
+static void lock_acquire(sync_t *s, sync_thread_t *my, long *ticket) {
+  qnode_t *pred;
+
+  switch (s->type) {
+  case SYNC_TICKET:
+    *ticket = atomic_fetch_add_explicit(s->next, 1, memory_order_relaxed);
+    while (atomic_load_explicit(s->serving, memory_order_acquire) != *ticket);
+    break;
+  case SYNC_MCS:
+    atomic_store_explicit(&my->node->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&my->node->locked, 1, memory_order_relaxed);
+    pred = atomic_exchange_explicit(s->tail, my->node, memory_order_acq_rel);
+    if (pred) {
+      atomic_store_explicit(&pred->next, my->node, memory_order_release);
+      while (atomic_load_explicit(&my->node->locked, memory_order_acquire));
+    }
+    break;
+  case SYNC_CLH:
+    atomic_store_explicit(&my->node->locked, 1, memory_order_relaxed);
+    pred = atomic_exchange_explicit(s->tail, my->node, memory_order_acq_rel);
+    while (atomic_load_explicit(&pred->locked, memory_order_acquire));
+    /* the predecessor's node is free now; it becomes mine for the next time  */
+    atomic_store_explicit(&my->node->next, pred, memory_order_relaxed);
+    break;
+  }
+}
+
+static void lock_release(sync_t *s, sync_thread_t *my, long ticket) {
+  qnode_t *succ, *expected;
+
+  switch (s->type) {
+  case SYNC_TICKET:
+    atomic_store_explicit(s->serving, ticket+1, memory_order_release);
+    break;
+  case SYNC_MCS:
+    succ = atomic_load_explicit(&my->node->next, memory_order_acquire);
+    if (!succ) {
+      expected = my->node;
+      if (atomic_compare_exchange_strong_explicit(s->tail, &expected, NULL,
+                                                  memory_order_release, memory_order_relaxed))
+        return;
+      /* a successor is enqueueing; wait until it has linked itself in        */
+      while (!(succ = atomic_load_explicit(&my->node->next, memory_order_acquire)));
+    }
+    atomic_store_explicit(&succ->locked, 0, memory_order_release);
+    break;
+  case SYNC_CLH:
+    succ = atomic_load_explicit(&my->node->next, memory_order_relaxed);
+    atomic_store_explicit(&my->node->locked, 0, memory_order_release);
+    my->node = succ;
+    break;
+  }
+}
+
+/* add the shard of the calling thread to the shared counters                  */
+static void sync_flush(sync_t *s, sync_thread_t *my, DTYPE *pcounter1, DTYPE *pcounter2) {
+  DTYPE *shard = s->shard + my->id*s->shard_stride;
+
+  if (!my->pending) return;
+  atomic_add(pcounter1, shard[0]);
+  atomic_add(pcounter2, shard[1]);
+  shard[0] = shard[1] = 0;
+  my->pending = 0;
+}
+
+/* one update of the counter pair with the synchronization selected by PRK_SYNC */
+static void sync_update(sync_t *s, sync_thread_t *my, DTYPE *pcounter1, DTYPE *pcounter2,
+                        double cosa, double sina) {
+  long  ticket;
+  DTYPE *shard;
+#if DEPENDENT
+  double tmp1;
+#endif
+
+  switch (s->type) {
+  case SYNC_FETCH_ADD:
+    atomic_add(pcounter1, 1);
+    atomic_add(pcounter2, 1);
+    break;
+  case SYNC_CAS:
+    cas_increment(pcounter1);
+    cas_increment(pcounter2);
+    break;
+  case SYNC_SHARDED:
+    shard = s->shard + my->id*s->shard_stride;
+    shard[0]++;
+    shard[1]++;
+    if (++my->pending == s->combine) sync_flush(s, my, pcounter1, pcounter2);
+    break;
+  default:
+    lock_acquire(s, my, &ticket);
+#if DEPENDENT
+    tmp1 = COUNTER1;
+    COUNTER1 = cosa*tmp1 - sina*COUNTER2;
+    COUNTER2 = sina*tmp1 + cosa*COUNTER2;
+#else
+    COUNTER1++;
+    COUNTER2++;
+#endif
+    lock_release(s, my, ticket);
+    break;
+  }
+}
+
 /* declare a simple function that does some work                                */
 void private_stream(double *a, double *b, double *c, size_t size) {
   int j;
@@ -108,9 +293,14 @@ int main(int argc, char ** argv)
   double     epsilon=1.e-7;   /* required accuracy                              */
   omp_lock_t *pcounter_lock;  /* pointer to lock that guards access to counters */
   double     refcount_time;   /* timing parameter                               */
+  prk_harness_t harness;      /* timing of all updates as a single iteration    */
   int        nthread_input;   /* number of threads requested                    */
   int        nthread;         /* actual number of threads used                  */
   int        error=0;         /* global errors                                  */
+  sync_t     sync;            /* synchronization selected by PRK_SYNC           */
+  int        padded=1;        /* give synchronization words their own lines     */
+  char       *env;            /* value of PRK_SYNC, PRK_PADDING, PRK_COMBINE    */
+  int        t;               /* dummy                                          */
  
 /*********************************************************************
 ** process and test input parameters    
@@ -147,9 +337,67 @@ int main(int argc, char ** argv)
 #endif
  
   omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("Refcount");
+
+  sync.type    = SYNC_OMP;
+  sync.combine = 64;
+  env = getenv("PRK_SYNC");
+  if (env != NULL && *env != '\0') {
+    for (sync.type=0; sync.type<SYNC_TYPES; sync.type++)
+      if (!strcmp(env,sync_name[sync.type])) break;
+    if (sync.type == SYNC_TYPES) {
+      printf("ERROR: PRK_SYNC must be omp, fetch_add, cas, ticket, mcs, clh, or sharded: %s\n",
+             env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  env = getenv("PRK_PADDING");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"packed")) padded = 0;
+    else if (strcmp(env,"padded")) {
+      printf("ERROR: PRK_PADDING must be padded or packed: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  env = getenv("PRK_COMBINE");
+  if (env != NULL && *env != '\0') {
+    sync.combine = atol(env);
+    if (sync.combine < 1) {
+      printf("ERROR: PRK_COMBINE must be positive: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+#if !CONTENDED
+  if (sync.type != SYNC_OMP) {
+    printf("ERROR: PRK_SYNC=%s requires contended counters (CONTENDED=1)\n",
+           sync_name[sync.type]);
+    exit(EXIT_FAILURE);
+  }
+#endif
+#if DEPENDENT
+  if (sync.type == SYNC_FETCH_ADD || sync.type == SYNC_CAS || sync.type == SYNC_SHARDED) {
+    printf("ERROR: PRK_SYNC=%s cannot do dependent counter updates\n", sync_name[sync.type]);
+    exit(EXIT_FAILURE);
+  }
+#endif
+#if !INTEGER
+  if (sync.type == SYNC_FETCH_ADD) {
+    printf("ERROR: PRK_SYNC=fetch_add requires integer counters (INTEGER=1)\n");
+    exit(EXIT_FAILURE);
+  }
+#endif
 
   cosa = cos(1.0);
   sina = sin(1.0);
+
+  /* single updates are too short to time one by one                   */
+  prk_harness_init(&harness, "Refcount", "OpenMP", 1);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "iterations", "%zu", iterations);
+  prk_harness_param(&harness, "sync", "%s", sync_name[sync.type]);
+  prk_harness_param(&harness, "padding", "%s", padded ? "padded" : "packed");
+  prk_harness_param(&harness, "contended", "%d", CONTENDED);
+  prk_harness_param(&harness, "dependent", "%d", DEPENDENT);
  
 #if !CONTENDED
   #pragma omp parallel private(pcounter1,pcounter2,counter_space,\
@@ -164,6 +412,10 @@ int main(int argc, char ** argv)
   int    num_error=0;/* errors in private stream execution            */
   double aj, bj, cj;
   DTYPE refcounter1, refcounter2;
+  sync_thread_t my_sync;   /* per-thread state of PRK_SYNC                   */
+
+  my_sync.id      = omp_get_thread_num();
+  my_sync.pending = 0;
 
   if (stream_size) {
     a = (double *) prk_malloc(3*sizeof(double)*stream_size);
@@ -213,6 +465,13 @@ int main(int argc, char ** argv)
 #else
     printf("Counter data type              = floating point\n");
 #endif
+    if (sync.type != SYNC_OMP) {
+    printf("Mutex type                     = %s, %s\n", sync_name[sync.type],
+           padded ? "padded" : "packed");
+    if (sync.type == SYNC_SHARDED)
+    printf("Updates between shard flushes  = %ld\n", sync.combine);
+    }
+    else
 #if LOCK==2
     printf("Mutex type                     = lock\n");
 #elif LOCK==1
@@ -267,11 +526,41 @@ int main(int argc, char ** argv)
   omp_init_lock(pcounter_lock);
 #endif
 
+  /* state of the PRK_SYNC modes; without padding it is packed together       */
+  if (sync.type != SYNC_OMP) {
+    sync.node_stride  = padded ? LINESIZE : sizeof(qnode_t);
+    sync.shard_stride = padded ? LINESIZE/sizeof(DTYPE) : 2;
+    sync.next  = (atomic_long *) prk_malloc(2*LINESIZE + sizeof(_Atomic(qnode_t *)) +
+                                            (nthread+1)*sync.node_stride +
+                                            nthread*sync.shard_stride*sizeof(DTYPE));
+    if (!sync.next) {
+      printf("ERROR: could not allocate space for synchronization\n");
+      exit(EXIT_FAILURE);
+    }
+    sync.serving = padded ? (atomic_long *)((char *)sync.next+LINESIZE) : sync.next+1;
+    sync.tail    = (_Atomic(qnode_t *) *)((char *)sync.next+2*LINESIZE);
+    sync.nodes   = padded ? (char *)sync.next+3*LINESIZE : (char *)(sync.tail+1);
+    sync.shard   = (DTYPE *)(sync.nodes+(nthread+1)*sync.node_stride);
+    atomic_init(sync.next, 0);
+    atomic_init(sync.serving, 0);
+    for (t=0; t<=nthread; t++) {
+      atomic_init(&NODE(&sync,t)->next, NULL);
+      atomic_init(&NODE(&sync,t)->locked, 0);
+    }
+    /* the CLH queue starts with a released node, owned by nobody             */
+    atomic_init(sync.tail, sync.type == SYNC_CLH ? NODE(&sync,nthread) : NULL);
+    for (t=0; t<nthread; t++) sync.shard[t*sync.shard_stride] =
+                              sync.shard[t*sync.shard_stride+1] = 0;
+  }
+
 #if CONTENDED
   }
 #endif
+  my_sync.node = sync.type != SYNC_OMP ? NODE(&sync,my_sync.id) : NULL;
 
   /* do one warmup iteration outside main loop to avoid overhead      */
+  if (sync.type != SYNC_OMP) sync_update(&sync, &my_sync, pcounter1, pcounter2, cosa, sina);
+  else {
 #if DEPENDENT
   #if LOCK==2
   omp_set_lock(pcounter_lock);
@@ -298,6 +587,7 @@ int main(int argc, char ** argv)
     COUNTER2++;
   #endif
 #endif
+  }
 
 #if STREAM
   /* give each thread independent work to do                          */
@@ -306,7 +596,7 @@ int main(int argc, char ** argv)
 
   #pragma omp single
   {
-  refcount_time = wtime();
+  prk_harness_tick(&harness);
   }
 
 #if CONTENDED 
@@ -317,6 +607,8 @@ int main(int argc, char ** argv)
   for (iter=1; iter<=iterations; iter++) { 
 #endif
 
+    if (sync.type != SYNC_OMP) sync_update(&sync, &my_sync, pcounter1, pcounter2, cosa, sina);
+    else {
 #if DEPENDENT
   #if LOCK==2
     omp_set_lock(pcounter_lock);
@@ -343,6 +635,7 @@ int main(int argc, char ** argv)
     COUNTER2++;
   #endif
 #endif
+    }
 
 #if STREAM
     /* give each thread some (overlappable) work to do                */
@@ -350,9 +643,16 @@ int main(int argc, char ** argv)
 #endif
   }
 
+  /* the shards still hold the updates made since their last flush     */
+  if (sync.type == SYNC_SHARDED) {
+    sync_flush(&sync, &my_sync, pcounter1, pcounter2);
+    #pragma omp barrier
+  }
+
   #pragma omp single
   { 
-  refcount_time = wtime() - refcount_time;
+  prk_harness_tick(&harness);
+  refcount_time = prk_harness_elapsed(&harness);
   }
 
   /* check whether the private work has been done correctly           */
@@ -419,6 +719,8 @@ int main(int argc, char ** argv)
 #endif
     printf("Rate (MCPUPs/s): %lf time (s): %lf\n", 
            updates/refcount_time*1.e-6, refcount_time);
+    prk_harness_report(&harness, "MCPUPs/s", updates*1.e-6);
+    prk_harness_finalize(&harness);
   }
 
    exit(EXIT_SUCCESS);
@@ -44,6 +44,38 @@ USAGE:   The program takes as input the number of threads, the 2log of the linea
 
          <progname> <# threads> <# iterations> <2log root-of-matrix-order> <radius> 
   
+         The matrix is assembled in Compressed Row Storage (CRS).  With
+         PRK_SPARSE=ell or PRK_SPARSE=sell it is converted before the
+         iterations into a format whose inner loop runs across rows, so
+         that it vectorizes with gathers from the vector:
+
+         ELLPACK   entry k of every row is stored at k*order+row; blocks of
+                   ELL_BLOCK rows are multiplied at a time
+         SELL-C    the rows form chunks of C rows (PRK_SELL_CHUNK=C,
+                   default 8, at most SELL_MAX_CHUNK), each stored like a
+                   small ELLPACK matrix; a final partial chunk is padded
+                   with explicit zeroes
+
+         Every row has the same number of nonzeroes, so the sorting of
+         rows by length of SELL-C-sigma would leave them in place, and it
+         is not done.  The time of the conversion is reported separately
+         and is not part of the SpMV rate.  The default is PRK_SPARSE=crs.
+
+         With PRK_VECTORS=k (k > 1) every iteration multiplies the CRS
+         matrix by a block of k vectors, stored row by row (entry v of
+         row i at i*k+v), as in block Krylov solvers, so that every matrix
+         entry and column index loaded serves k multiply-adds.  Blocks of
+         2, 4 and 8 vectors have kernels with a fixed, unrolled inner loop.
+         Vector v of the block is v+1 times the usual vector.
+
+         With PRK_REORDER=rcm the rows and columns of the matrix are
+         renumbered by Reverse Cuthill-McKee before the conversion, which
+         undoes much of the loss of locality of the vector accesses caused
+         by the scrambling.  The time of the reordering is reported, and
+         the CRS multiplication is timed before and after it to report the
+         speedup that the reordering alone brings.  The default is
+         PRK_REORDER=none.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
@@ -55,6 +87,11 @@ FUNCTIONS CALLED:
          wtime()
          bail_out()
          reverse()
+         sort_indices()
+         multiply_crs(), multiply_block()
+         rcm_order(), permute_matrix()
+         convert_ell(), convert_sell()
+         prk_harness_*()
 
 NOTES:   
 
@@ -68,6 +105,8 @@ HISTORY: Written by Rob Van der Wijngaart, August 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
 
 /* linearize the grid index                                                       */
 #define LIN(i,j) (i+((j)<<lsize))
@@ -82,8 +121,26 @@ HISTORY: Written by Rob Van der Wijngaart, August 2006.
 
 #define BITS_IN_BYTE 8
 
+/* rows multiplied together by the ELLPACK kernel, and largest SELL chunk        */
+#define ELL_BLOCK      64
+#define SELL_MAX_CHUNK 64
+
+/* largest block of vectors multiplied at once                                    */
+#define MAX_VECTORS    64
+
+/* storage formats of the sparse matrix                                           */
+enum { FORMAT_CRS, FORMAT_ELL, FORMAT_SELL };
+static const char * format_names[] = {"CRS", "ELLPACK", "SELL-C"};
+
 static u64Int reverse(register u64Int, int);
-static int compare(const void *el1, const void *el2);
+static void sort_indices(s64Int *, int);
+static void multiply_crs(s64Int, int, double *, s64Int *, double *, double *);
+static void multiply_block(s64Int, int, int, double *, s64Int *, double *, double *);
+static void rcm_order(s64Int, int, s64Int *, s64Int *, s64Int *);
+static void permute_matrix(s64Int, int, s64Int *, s64Int *, double *, s64Int *,
+                           double *, s64Int *);
+static void convert_ell(s64Int, int, double *, s64Int *, double *, s64Int *);
+static void convert_sell(s64Int, int, int, double *, s64Int *, double *, s64Int *);
 
 int main(int argc, char **argv){
 
@@ -102,10 +159,10 @@ int main(int argc, char **argv){
   double            sparsity;   /* fraction of non-zeroes in matrix               */
   double            sparse_time,/* timing parameters                              */
                     avgtime;
+  prk_harness_t     harness;    /* per-iteration timing                           */
   double * RESTRICT matrix;     /* sparse matrix entries                          */
   double * RESTRICT vector;     /* vector multiplying the sparse matrix           */
   double * RESTRICT result;     /* computed matrix-vector product                 */
-  double            temp;       /* temporary scalar storing reduction data        */
   double            vector_sum; /* checksum of result                             */
   double            reference_sum; /* checksum of "rhs"                           */
   double            epsilon = 1.e-8; /* error tolerance                           */
@@ -117,6 +174,23 @@ int main(int argc, char **argv){
   size_t            vector_space, /* variables used to hold prk_malloc sizes          */
                     matrix_space,
                     index_space;
+  int               format = FORMAT_CRS; /* storage format used in the iterations */
+  int               chunk = 8;  /* rows per chunk of SELL-C                       */
+  s64Int            nchunk;     /* number of chunks of SELL-C                     */
+  s64Int            nslot;      /* number of stored entries, including padding    */
+  double * RESTRICT fmt_matrix = NULL; /* matrix entries in ELLPACK or SELL-C     */
+  s64Int * RESTRICT fmt_colIndex = NULL; /* their column indices                  */
+  double            convert_time = 0.0; /* time to convert from CRS               */
+  int               nvec = 1;   /* number of vectors multiplied at once           */
+  int               v;          /* index of vector in block                       */
+  int               reorder = 0; /* true if the matrix is reordered by RCM        */
+  s64Int * RESTRICT permutation = NULL; /* new index of each row and column       */
+  s64Int * RESTRICT inverse = NULL; /* original index of each row and column      */
+  double * RESTRICT new_matrix;  /* reordered matrix entries ...                  */
+  s64Int * RESTRICT new_colIndex; /* ... and their column indices                 */
+  double            reorder_time = 0.0, /* time to reorder the matrix             */
+                    probe_time[2]; /* CRS multiplications before and after it     */
+  char              *env;       /* value of a PRK_* environment variable          */
 
   printf("Parallel Research Kernels version %s\n", PRKVERSION);
   printf("OpenMP Sparse matrix-vector multiplication\n");
@@ -135,6 +209,7 @@ int main(int argc, char **argv){
   }
 
   omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("Sparse");
  
   iterations = atoi(*++argv);
   if (iterations < 1){
@@ -174,6 +249,41 @@ int main(int argc, char **argv){
   /* compute total number of non-zeroes                                           */
   nent = size2*stencil_size;
 
+  env = getenv("PRK_SPARSE");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"ell"))  format = FORMAT_ELL;
+    else if (!strcmp(env,"sell")) format = FORMAT_SELL;
+    else if (strcmp(env,"crs")) {
+      printf("ERROR: PRK_SPARSE must be crs, ell or sell: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  env = getenv("PRK_SELL_CHUNK");
+  if (env != NULL) chunk = atoi(env);
+  if (chunk < 1 || chunk > SELL_MAX_CHUNK) {
+    printf("ERROR: PRK_SELL_CHUNK must be between 1 and %d: %s\n", SELL_MAX_CHUNK, env);
+    exit(EXIT_FAILURE);
+  }
+  nchunk = (size2+chunk-1)/chunk;
+  env = getenv("PRK_VECTORS");
+  if (env != NULL) nvec = atoi(env);
+  if (nvec < 1 || nvec > MAX_VECTORS) {
+    printf("ERROR: PRK_VECTORS must be between 1 and %d: %s\n", MAX_VECTORS, env);
+    exit(EXIT_FAILURE);
+  }
+  if (nvec > 1 && format != FORMAT_CRS) {
+    printf("ERROR: blocks of vectors need PRK_SPARSE=crs\n");
+    exit(EXIT_FAILURE);
+  }
+  env = getenv("PRK_REORDER");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"rcm")) reorder = 1;
+    else if (strcmp(env,"none")) {
+      printf("ERROR: PRK_REORDER must be none or rcm: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+
   matrix_space = nent*sizeof(double);
   if (matrix_space/sizeof(double) != nent) {
     printf("ERROR: Cannot represent space for matrix: %ul\n", matrix_space);
@@ -186,8 +296,8 @@ int main(int argc, char **argv){
     exit(EXIT_FAILURE);
   } 
 
-  vector_space = 2*size2*sizeof(double);
-  if (vector_space/sizeof(double) != 2*size2) {
+  vector_space = 2*size2*nvec*sizeof(double);
+  if (vector_space/sizeof(double) != 2*size2*nvec) {
     printf("ERROR: Cannot represent space for vectors: %ul\n", vector_space);
     exit(EXIT_FAILURE);
   } 
@@ -197,7 +307,7 @@ int main(int argc, char **argv){
     printf("ERROR: Could not allocate space for vectors: %d\n", (int)(2*size2));
     exit(EXIT_FAILURE);
   }
-  result = vector + size2;
+  result = vector + size2*nvec;
 
   index_space = nent*sizeof(s64Int);
   if (index_space/sizeof(s64Int) != nent) {
@@ -211,6 +321,36 @@ int main(int argc, char **argv){
     exit(EXIT_FAILURE);
   } 
 
+  if (reorder) {
+    permutation  = (s64Int *) prk_malloc(2*size2*sizeof(s64Int));
+    new_matrix   = (double *) prk_malloc(matrix_space);
+    new_colIndex = (s64Int *) prk_malloc(index_space);
+    if (!permutation || !new_matrix || !new_colIndex) {
+      printf("ERROR: Could not allocate space for reordering\n");
+      exit(EXIT_FAILURE);
+    }
+    inverse = permutation + size2;
+  }
+
+  if (format != FORMAT_CRS) {
+    nslot = format == FORMAT_SELL ? nchunk*chunk*stencil_size : nent;
+    fmt_matrix   = (double *) prk_malloc(nslot*sizeof(double));
+    fmt_colIndex = (s64Int *) prk_malloc(nslot*sizeof(s64Int));
+    if (!fmt_matrix || !fmt_colIndex) {
+      printf("ERROR: Could not allocate space for %s matrix: "FSTR64U"\n",
+             format_names[format], nslot);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  prk_harness_init(&harness, "Sparse", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "log2_grid_size", "%d", lsize);
+  prk_harness_param(&harness, "radius", "%d", radius);
+  prk_harness_param(&harness, "format", "%s", format_names[format]);
+  prk_harness_param(&harness, "vectors", "%d", nvec);
+  prk_harness_param(&harness, "reorder", "%d", reorder);
+
   #pragma omp parallel private (row, col, elm, first, last, iter)
   {
 
@@ -229,6 +369,11 @@ int main(int argc, char **argv){
     printf("Stencil diameter      = %16d\n", 2*radius+1);
     printf("Sparsity              = %16.10lf\n", sparsity);
     printf("Number of iterations  = %16d\n", iterations);
+    printf("Storage format        = %16s\n", format_names[format]);
+    if (format == FORMAT_SELL)
+      printf("SELL chunk height     = %16d\n", chunk);
+    printf("Number of vectors     = %16d\n", nvec);
+    printf("Reordering            = %16s\n", reorder ? "RCM" : "none");
 #if SCRAMBLE
     printf("Using scrambled indexing\n");
 #else
@@ -239,8 +384,9 @@ int main(int argc, char **argv){
   bail_out(num_error);
 
   /* initialize the input and result vectors                                      */
-  #pragma omp for
-  for (row=0; row<size2; row++) result[row] = vector[row] = 0.0;
+  #pragma omp for private(v)
+  for (row=0; row<size2; row++) for (v=0; v<nvec; v++) 
+    result[row*nvec+v] = vector[row*nvec+v] = 0.0;
 
   /* fill matrix with nonzeroes corresponding to difference stencil. We use the 
      scrambling for reordering the points in the grid.                            */
@@ -258,42 +404,144 @@ int main(int argc, char **argv){
     }
     /* sort colIndex to make sure the compressed row accesses
        vector elements in increasing order                                         */
-    qsort(&(colIndex[row*stencil_size]), stencil_size, sizeof(s64Int), compare);
+    sort_indices(&(colIndex[row*stencil_size]), stencil_size);
     for (elm=row*stencil_size; elm<(row+1)*stencil_size; elm++)
       matrix[elm] = 1.0/(double)(colIndex[elm]+1);
   }
 
+  if (reorder) {
+    /* time the CRS multiplication before reordering; result is reset          */
+    #pragma omp barrier
+    #pragma omp master
+    {
+      probe_time[0] = wtime();
+    }
+    for (iter=0; iter<iterations; iter++) 
+      multiply_crs(size2, stencil_size, matrix, colIndex, vector, result);
+    #pragma omp barrier
+    #pragma omp master
+    {
+      probe_time[0] = wtime() - probe_time[0];
+      reorder_time  = wtime();
+    }
+
+    #pragma omp single
+    rcm_order(size2, stencil_size, colIndex, permutation, inverse);
+    permute_matrix(size2, stencil_size, permutation, inverse, matrix, colIndex,
+                   new_matrix, new_colIndex);
+    #pragma omp barrier
+    #pragma omp master
+    {
+      reorder_time = wtime() - reorder_time;
+      prk_free(matrix);
+      prk_free(colIndex);
+      matrix   = new_matrix;
+      colIndex = new_colIndex;
+    }
+    #pragma omp barrier
+
+    #pragma omp master
+    {
+      probe_time[1] = wtime();
+    }
+    for (iter=0; iter<iterations; iter++) 
+      multiply_crs(size2, stencil_size, matrix, colIndex, vector, result);
+    #pragma omp barrier
+    #pragma omp master
+    {
+      probe_time[1] = wtime() - probe_time[1];
+    }
+    #pragma omp for
+    for (row=0; row<size2; row++) result[row] = 0.0;
+  }
+
+  if (format != FORMAT_CRS) {
+    #pragma omp barrier
+    #pragma omp master
+    {
+      convert_time = wtime();
+    }
+    if (format == FORMAT_ELL) 
+      convert_ell(size2, stencil_size, matrix, colIndex, fmt_matrix, fmt_colIndex);
+    else
+      convert_sell(size2, stencil_size, chunk, matrix, colIndex, fmt_matrix, fmt_colIndex);
+    #pragma omp barrier
+    #pragma omp master
+    {
+      convert_time = wtime() - convert_time;
+    }
+  }
+
   for (iter=0; iter<=iterations; iter++) {
 
-    /* start timer after a warmup iteration                                        */
+    /* start timer after a warmup iteration; the loops of the previous
+       iteration end in barriers, which also protect the later ticks              */
     if (iter == 1) { 
       #pragma omp barrier
+    }
+    if (iter >= 1) {
       #pragma omp master
       {   
-        sparse_time = wtime();
+        prk_harness_tick(&harness);
       }
     }
 
-    /* fill vector                                                                */
-    #pragma omp for 
-    for (row=0; row<size2; row++) vector[row] += (double) (row+1);
+    /* fill vector; after reordering, entry row is that of point inverse[row]    */
+    if (nvec > 1) {
+      #pragma omp for private(v)
+      for (row=0; row<size2; row++) for (v=0; v<nvec; v++) 
+        vector[row*nvec+v] += (double) (v+1)*(double) ((reorder ? inverse[row] : row)+1);
+    }
+    else if (reorder) {
+      #pragma omp for 
+      for (row=0; row<size2; row++) vector[row] += (double) (inverse[row]+1);
+    }
+    else {
+      #pragma omp for 
+      for (row=0; row<size2; row++) vector[row] += (double) (row+1);
+    }
 
     /* do the actual matrix-vector multiplication                                 */
-    #pragma omp for
-    for (row=0; row<size2; row++) {
-      first = stencil_size*row; last = first+stencil_size-1;
-      #pragma simd reduction(+:temp) 
-      for (temp=0.0,col=first; col<=last; col++) {
-        temp += matrix[col]*vector[colIndex[col]];
+    if (format == FORMAT_ELL) {
+      #pragma omp for
+      for (first=0; first<size2; first+=ELL_BLOCK) {
+        double block_sum[ELL_BLOCK];
+        last = MIN(ELL_BLOCK, size2-first);
+        for (row=0; row<last; row++) block_sum[row] = 0.0;
+        for (col=0; col<stencil_size; col++) {
+          elm = col*size2+first;
+          #pragma omp simd
+          for (row=0; row<last; row++)
+            block_sum[row] += fmt_matrix[elm+row]*vector[fmt_colIndex[elm+row]];
+        }
+        for (row=0; row<last; row++) result[first+row] += block_sum[row];
+      }
+    }
+    else if (format == FORMAT_SELL) {
+      #pragma omp for
+      for (first=0; first<nchunk; first++) {
+        double chunk_sum[SELL_MAX_CHUNK];
+        for (row=0; row<chunk; row++) chunk_sum[row] = 0.0;
+        for (col=0; col<stencil_size; col++) {
+          elm = (first*stencil_size+col)*chunk;
+          #pragma omp simd
+          for (row=0; row<chunk; row++)
+            chunk_sum[row] += fmt_matrix[elm+row]*vector[fmt_colIndex[elm+row]];
+        }
+        last = MIN(chunk, size2-first*chunk);
+        for (row=0; row<last; row++) result[first*chunk+row] += chunk_sum[row];
       }
-      result[row] += temp;
     }
+    else if (nvec > 1) 
+      multiply_block(size2, stencil_size, nvec, matrix, colIndex, vector, result);
+    else multiply_crs(size2, stencil_size, matrix, colIndex, vector, result);
   } /* end of iterations                                                          */
 
   #pragma omp barrier
   #pragma omp master
   {
-    sparse_time = wtime() - sparse_time;
+    prk_harness_tick(&harness);
+    sparse_time = prk_harness_elapsed(&harness);
   }
 
   } /* end of parallel region                                                     */
@@ -301,9 +549,11 @@ int main(int argc, char **argv){
   /* verification test                                                            */
   reference_sum = 0.5 * (double) nent * (double) (iterations+1) * 
                         (double) (iterations +2);
+  /* vector v of a block is v+1 times the single vector                         */
+  reference_sum *= 0.5 * (double) nvec * (double) (nvec+1);
 
   vector_sum = 0.0;
-  for (row=0; row<size2; row++) vector_sum += result[row];
+  for (row=0; row<size2*nvec; row++) vector_sum += result[row];
   if (ABS(vector_sum-reference_sum) > epsilon) {
     printf("ERROR: Vector sum = %lf, Reference vector sum = %lf\n",
            vector_sum, reference_sum);
@@ -317,9 +567,20 @@ int main(int argc, char **argv){
 #endif
   }
 
+  /* the padding of SELL-C is not counted in the flops                          */
   avgtime = sparse_time/iterations;
   printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
-         1.0E-06 * (2.0*nent)/avgtime, avgtime);
+         1.0E-06 * (2.0*nent*nvec)/avgtime, avgtime);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0*nent*nvec));
+  prk_harness_finalize(&harness);
+  if (format != FORMAT_CRS)
+    printf("Conversion from CRS to %s (s): %lf\n", format_names[format], convert_time);
+  if (reorder) {
+    printf("RCM reordering time (s): %lf\n", reorder_time);
+    printf("CRS Avg time (s) before reordering: %lf  after: %lf  speedup: %lf\n",
+           probe_time[0]/iterations, probe_time[1]/iterations, 
+           probe_time[0]/probe_time[1]);
+  }
 
   exit(EXIT_SUCCESS);
 }
@@ -345,8 +606,171 @@ u64Int reverse(register u64Int x, int shift_in_bits){
   return (x>>((sizeof(u64Int)*BITS_IN_BYTE-shift_in_bits)));
 }
 
-int compare(const void *el1, const void *el2) {
-  s64Int v1 = *(s64Int *)el1;  
-  s64Int v2 = *(s64Int *)el2;
-  return (v1<v2) ? -1 : (v1>v2) ? 1 : 0;
+/* result += matrix*vector for the CRS matrix (matrix, colIndex) of order rows
+   of row_length entries each.  It must be called by all threads of a
+   parallel region                                                        */
+void multiply_crs(s64Int order, int row_length, double *matrix, s64Int *colIndex,
+                  double *vector, double *result) {
+
+  s64Int row, col, first, last;
+  double temp;
+
+  #pragma omp for
+  for (row=0; row<order; row++) {
+    first = row_length*row; last = first+row_length-1;
+    #pragma simd reduction(+:temp) 
+    for (temp=0.0,col=first; col<=last; col++) {
+      temp += matrix[col]*vector[colIndex[col]];
+    }
+    result[row] += temp;
+  }
+}
+
+/* result += matrix*vector for a block of nvec vectors stored row by row;
+   the constant nvec of the inlined copies below lets the compiler unroll
+   the loops over the block                                              */
+static inline void multiply_rows(s64Int order, int row_length, const int nvec, 
+                                 double *matrix, s64Int *colIndex, 
+                                 double * RESTRICT vector, double * RESTRICT result) {
+
+  s64Int row, col;
+  double temp[MAX_VECTORS], a, *x;
+  int    v;
+
+  #pragma omp for
+  for (row=0; row<order; row++) {
+    for (v=0; v<nvec; v++) temp[v] = 0.0;
+    for (col=row*row_length; col<(row+1)*row_length; col++) {
+      a = matrix[col];
+      x = &vector[colIndex[col]*nvec];
+      #pragma omp simd
+      for (v=0; v<nvec; v++) temp[v] += a*x[v];
+    }
+    for (v=0; v<nvec; v++) result[row*nvec+v] += temp[v];
+  }
+}
+
+/* result += matrix*vector for the CRS matrix (matrix, colIndex) of order rows
+   of row_length entries each and a block of nvec vectors.  It must be
+   called by all threads of a parallel region                            */
+void multiply_block(s64Int order, int row_length, int nvec, double *matrix, 
+                    s64Int *colIndex, double *vector, double *result) {
+
+  switch (nvec) {
+    case 2:  multiply_rows(order, row_length, 2, matrix, colIndex, vector, result); break;
+    case 4:  multiply_rows(order, row_length, 4, matrix, colIndex, vector, result); break;
+    case 8:  multiply_rows(order, row_length, 8, matrix, colIndex, vector, result); break;
+    default: multiply_rows(order, row_length, nvec, matrix, colIndex, vector, result);
+  }
+}
+
+/* Reverse Cuthill-McKee ordering of the graph of the CRS matrix colIndex of
+   order rows of row_length entries each: rows are numbered in breadth-first
+   order and the numbering is reversed.  Every row of the stencil matrix has
+   the same degree and the periodic grid looks the same from every point,
+   so neighbours are visited in column order and row 0 is as good a start
+   as a pseudo-peripheral row.  Returns the new index of every row in
+   permutation and the original index of every new row in inverse        */
+void rcm_order(s64Int order, int row_length, s64Int *colIndex, 
+               s64Int *permutation, s64Int *inverse) {
+
+  s64Int start, head = 0, tail = 0, row, col, elm;
+
+  for (row=0; row<order; row++) permutation[row] = -1;
+
+  /* inverse doubles as the queue of the breadth-first search                  */
+  for (start=0; start<order; start++) if (permutation[start] < 0) {
+    permutation[start] = tail;
+    inverse[tail++]    = start;
+    while (head < tail) {
+      row = inverse[head++];
+      for (elm=row*row_length; elm<(row+1)*row_length; elm++) {
+        col = colIndex[elm];
+        if (permutation[col] < 0) {
+          permutation[col] = tail;
+          inverse[tail++]  = col;
+        }
+      }
+    }
+  }
+
+  for (row=0; row<order/2; row++) {
+    col                  = inverse[row];
+    inverse[row]         = inverse[order-1-row];
+    inverse[order-1-row] = col;
+  }
+  for (row=0; row<order; row++) permutation[inverse[row]] = row;
+}
+
+/* apply the symmetric permutation of rcm_order() to the CRS matrix (matrix,
+   colIndex), storing the result in (new_matrix, new_colIndex) with sorted
+   rows.  It must be called by all threads of a parallel region          */
+void permute_matrix(s64Int order, int row_length, s64Int *permutation, 
+                    s64Int *inverse, double *matrix, s64Int *colIndex,
+                    double *new_matrix, s64Int *new_colIndex) {
+
+  s64Int row, elm, old;
+  int    k;
+
+  #pragma omp for private(elm, old, k)
+  for (row=0; row<order; row++) {
+    old = inverse[row]*row_length;
+    elm = row*row_length;
+    for (k=0; k<row_length; k++) 
+      new_colIndex[elm+k] = permutation[colIndex[old+k]];
+    sort_indices(&(new_colIndex[elm]), row_length);
+    for (k=0; k<row_length; k++) 
+      new_matrix[elm+k] = 1.0/(double)(inverse[new_colIndex[elm+k]]+1);
+  }
+}
+
+/* copy the CRS matrix (matrix, colIndex) of order rows of row_length entries
+   each into ELLPACK storage (ell_matrix, ell_colIndex), where entry k of
+   row row lies at k*order+row.  It must be called by all threads of a
+   parallel region                                                        */
+void convert_ell(s64Int order, int row_length, double *matrix, s64Int *colIndex,
+                 double *ell_matrix, s64Int *ell_colIndex) {
+
+  s64Int row;
+  int    k;
+
+  #pragma omp for
+  for (row=0; row<order; row++) for (k=0; k<row_length; k++) {
+    ell_matrix[k*order+row]   = matrix[row*row_length+k];
+    ell_colIndex[k*order+row] = colIndex[row*row_length+k];
+  }
+}
+
+/* copy the CRS matrix (matrix, colIndex) of order rows of row_length entries
+   each into SELL-C storage (sell_matrix, sell_colIndex) with chunks of
+   chunk rows: entry k of row r of chunk c lies at (c*row_length+k)*chunk+r.
+   Rows past the end of the matrix in the last chunk are zero, with column
+   index zero.  It must be called by all threads of a parallel region     */
+void convert_sell(s64Int order, int row_length, int chunk, double *matrix,
+                  s64Int *colIndex, double *sell_matrix, s64Int *sell_colIndex) {
+
+  s64Int row, nrow = (order+chunk-1)/chunk*chunk, slot;
+  int    k;
+
+  #pragma omp for private(slot)
+  for (row=0; row<nrow; row++) for (k=0; k<row_length; k++) {
+    slot = ((row/chunk)*row_length+k)*chunk + row%chunk;
+    sell_matrix[slot]   = row < order ? matrix[row*row_length+k]   : 0.0;
+    sell_colIndex[slot] = row < order ? colIndex[row*row_length+k] : 0;
+  }
+}
+
+/* Sort the n column indices of one row in increasing order.  A row holds
+   only 4*radius+1 entries, for which an inline insertion sort is several
+   times faster than qsort with its call through a comparison function on
+   every step; matrix assembly is otherwise dominated by the sorting     */
+void sort_indices(s64Int *index, int n) {
+  int    i, j;
+  s64Int v;
+
+  for (i=1; i<n; i++) {
+    v = index[i];
+    for (j=i; j>0 && index[j-1]>v; j--) index[j] = index[j-1];
+    index[j] = v;
+  }
 }
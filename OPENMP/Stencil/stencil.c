@@ -39,9 +39,47 @@ PURPOSE: This program tests the efficiency with which a space-invariant,
          grid or image.
   
 USAGE:   The program takes as input the number of threads, the linear
-         dimension of the grid, and the number of iterations on the grid
-
-               <progname> <# threads> <iterations> <grid size> 
+         dimension of the grid, and the number of iterations on the grid,
+         optionally followed by the radius and shape of the stencil
+
+               <progname> <# threads> <iterations> <grid size> [<radius> [star|compact]]
+
+         Kernels for radii 1 through MAX_RADIUS (and for the build-time
+         RADIUS, if larger) in both shapes are specialized at compile
+         time from stencil_kernel.incl, so that a whole range of
+         stencils can be run with one binary.  The defaults are the
+         build-time RADIUS and STAR.  Where the CPU supports it, the
+         hand-vectorized row kernels of prk_stencil_simd.h are used
+         instead (PRK_SIMD=scalar selects the specialized loops).
+
+         With PRK_TEMPORAL_BLOCK=<steps>[:<rows>] the timed iterations
+         are executed in blocks of <steps> time steps, each applied in a
+         single wavefront pass over the grid in windows of <rows> rows
+         (see temporal_block()).  The results are bitwise identical to
+         those of the untiled iterations.
+
+         With PRK_SYNC=p2p the iterations run on one persistent team of
+         threads (also when built with PARALLELFOR=1) without barriers
+         between them: every thread owns a strip of rows and only waits
+         for the two threads owning the strips next to it, through padded
+         progress counters (see iterate_p2p()).  This helps small grids,
+         where the barriers of the worksharing loops dominate.
+         PRK_SYNC=barrier selects the default.
+
+         With PRK_INCREMENT=offset the constant that every iteration adds
+         to IN is not stored but kept as an implicit offset of the grid
+         (see increment_mode()), which removes the increment pass over
+         the grid; PRK_INCREMENT=sweep (the default) adds it explicitly.
+
+         Built with MIXED=1 (single) or MIXED=2 (half precision, where the
+         compiler provides _Float16) the grid is stored in the reduced
+         precision, which halves (quarters) the memory traffic, while the
+         weights and the stencil sums are kept in double precision.
+
+         With PRK_SWEEP set, <# threads> is the largest thread count of an
+         in-process scaling sweep (see prk_sweep.h); for weak scaling the
+         grid size grows with the square root of the number of threads.
+         Sweeps run barrier-synchronized iterations (see sweep_config()).
   
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
@@ -52,7 +90,14 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_topology_bind()
+         prk_stencil_simd_*()
          bail_out()
+         increment_mode()
+         iterate_p2p()
+         sweep_config()
+         prk_harness_*()
+         prk_sweep_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, November 2006.
          - RvdW: Removed unrolling pragmas for clarity;
@@ -63,38 +108,360 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
-
-#if DOUBLE
+#include <prk_harness.h>
+#include <prk_topology.h>
+#include <prk_sweep.h>
+#include <prk_stencil_simd.h>
+#include <stdatomic.h>
+
+/* progress counters of the threads are LINEWORDS apart, to keep them on
+   separate cache lines                                                     */
+#define LINEWORDS  16
+#define SWEPT(t)   progress[(2*(t))*LINEWORDS]
+#define ADDED(t)   progress[(2*(t)+1)*LINEWORDS]
+
+/* DTYPE is the type in which the grid is stored, ATYPE the type in which
+   the stencil is accumulated; they only differ in the mixed precision modes */
+#if MIXED
+  #if MIXED == 2
+    #ifndef __FLT16_MAX__
+      #error "MIXED=2 requires a compiler that supports _Float16"
+    #endif
+    #define DTYPE   _Float16
+    #define EPSILON 1.e-3
+  #else
+    #define DTYPE   float
+    #define EPSILON 1.e-6
+  #endif
+  #define ATYPE   double
+  #define COEFX   1.0
+  #define COEFY   1.0
+  #define FSTR    "%lf"
+#elif DOUBLE
   #define DTYPE   double
+  #define ATYPE   double
   #define EPSILON 1.e-8
   #define COEFX   1.0
   #define COEFY   1.0
   #define FSTR    "%lf"
 #else
   #define DTYPE   float
+  #define ATYPE   float
   #define EPSILON 0.0001f
   #define COEFX   1.0f
   #define COEFY   1.0f
   #define FSTR    "%f"
 #endif
 
+/* largest radius for which kernels are specialized, besides RADIUS itself    */
+#define MAX_RADIUS 8
+#define WEIGHT_LEN (2*MAX(MAX_RADIUS,RADIUS)+1)*(2*MAX(MAX_RADIUS,RADIUS)+1)
+
 /* define shorthand for indexing a multi-dimensional array                       */
 #define IN(i,j)       in[i+(j)*(n)]
 #define OUT(i,j)      out[i+(j)*(n)]
-#define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
+#define WEIGHT(ii,jj) weight[(ii+radius)*(2*radius+1)+jj+radius]
+
+#if MIXED == 2
+  typedef prk_stencil_row_half_t   stencil_row_t;
+  #define prk_stencil_simd prk_stencil_simd_half
+#elif MIXED
+  typedef prk_stencil_row_mixed_t  stencil_row_t;
+  #define prk_stencil_simd prk_stencil_simd_mixed
+#elif DOUBLE
+  typedef prk_stencil_row_double_t stencil_row_t;
+  #define prk_stencil_simd prk_stencil_simd_double
+#else
+  typedef prk_stencil_row_float_t  stencil_row_t;
+  #define prk_stencil_simd prk_stencil_simd_float
+#endif
+
+#define KERNEL_PASTE(shape,r) shape##_##r
+#define KERNEL_NAME(shape,r)  KERNEL_PASTE(shape,r)
+
+#define KERNEL_RADIUS 1
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#define KERNEL_RADIUS 2
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#define KERNEL_RADIUS 3
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#define KERNEL_RADIUS 4
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#define KERNEL_RADIUS 5
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#define KERNEL_RADIUS 6
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#define KERNEL_RADIUS 7
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#define KERNEL_RADIUS 8
+#include "stencil_kernel.incl"
+#undef  KERNEL_RADIUS
+#if RADIUS > MAX_RADIUS
+  #define KERNEL_RADIUS RADIUS
+  #include "stencil_kernel.incl"
+  #undef  KERNEL_RADIUS
+#endif
+
+#define SELECT(r) return star ? star_row_##r : compact_row_##r
+
+/* returns the row kernel specialized for a radius and shape, or NULL        */
+static stencil_row_t select_kernel(int radius, int star) {
+  switch (radius) {
+    case 1: SELECT(1);
+    case 2: SELECT(2);
+    case 3: SELECT(3);
+    case 4: SELECT(4);
+    case 5: SELECT(5);
+    case 6: SELECT(6);
+    case 7: SELECT(7);
+    case 8: SELECT(8);
+  }
+#if RADIUS > MAX_RADIUS
+  if (radius == RADIUS)
+    return star ? KERNEL_NAME(star_row,RADIUS) : KERNEL_NAME(compact_row,RADIUS);
+#endif
+  return NULL;
+}
+
+/* applies the stencil to the whole grid, one row at a time                  */
+static void sweep(long n, int radius, stencil_row_t row,
+                  const ATYPE * RESTRICT weight, const DTYPE * RESTRICT in,
+                  DTYPE * RESTRICT out) {
+  long j;
+
+#if PARALLELFOR
+  #pragma omp parallel for
+#else
+  #pragma omp for
+#endif
+  for (j=radius; j<n-radius; j++) row(n, j, radius, weight, in, out);
+}
+
+/* Returns 1 if PRK_INCREMENT asks to keep the increment of IN as an
+   implicit offset, 0 if every iteration adds it to the grid.  IN+c feeds
+   the stencil c*(sum of the weights) more than IN does, which is zero for
+   the divergence operator, so OUT and the norm do not depend on the
+   offset and the increment pass can be skipped.                            */
+static int increment_mode(int radius, const ATYPE * RESTRICT weight) {
+  char  *env = getenv("PRK_INCREMENT");
+  ATYPE wsum = (ATYPE) 0.0;
+  int   ii, jj;
+
+  if (env == NULL || *env == '\0' || !strcmp(env, "sweep")) return 0;
+  if (strcmp(env, "offset")) {
+    printf("ERROR: PRK_INCREMENT=%s should be sweep or offset\n", env);
+    exit(EXIT_FAILURE);
+  }
+  for (jj=-radius; jj<=radius; jj++) for (ii=-radius; ii<=radius; ii++)
+    wsum += WEIGHT(ii,jj);
+  if (ABS(wsum) > EPSILON) {
+    printf("ERROR: PRK_INCREMENT=offset needs weights that sum to zero, not "
+           FSTR"\n", wsum);
+    exit(EXIT_FAILURE);
+  }
+  return 1;
+}
+
+/* Advances the solution by steps time steps in one pass over the grid.
+   The grid is swept in windows of rows; in every window time step t
+   trails time step t-1 by lag rows, so that its stencil reads only rows
+   that step t-1 has both updated and incremented, and every row goes
+   through all steps while it is still in cache.  Within a window the
+   stencil updates of all time steps are independent of each other, and
+   so are the increments of IN that follow them, so each is one
+   worksharing loop.  Every point sees the same operations in the same
+   order as in the untiled iterations.  Without increment the increments
+   are left to an implicit offset (see increment_mode()).                   */
+static void temporal_block(long n, int radius, int steps, long rows,
+                           int increment, stencil_row_t row,
+                           const ATYPE * RESTRICT weight,
+                           DTYPE * RESTRICT in, DTYPE * RESTRICT out) {
+  long lag = rows + 2*radius, base, k;
+
+  for (base=0; base<n+(steps-1)*lag+radius; base+=rows) {
+#if PARALLELFOR
+    #pragma omp parallel for
+#else
+    #pragma omp for
+#endif
+    for (k=0; k<steps*rows; k++) {
+      long j = base - (k/rows)*lag + k%rows;
+      if (j >= radius && j < n-radius) row(n, j, radius, weight, in, out);
+    }
+    if (!increment) continue;
+#if PARALLELFOR
+    #pragma omp parallel for
+#else
+    #pragma omp for
+#endif
+    for (k=0; k<steps*rows; k++) {
+      long i, j = base - (k/rows)*lag - radius + k%rows;
+      if (j >= 0 && j < n) for (i=0; i<n; i++) IN(i,j) += 1.0;
+    }
+  }
+}
+
+/* Runs iterations 0 through iterations (0 is the warmup) with point to
+   point synchronization instead of barriers.  IN is cut into strips of
+   whole rows, one for each of the first active threads, with at least
+   radius rows each; a thread updates the rows of OUT in its strip and
+   increments its rows of IN.  Its stencil reads only its own strip and
+   those of its two neighbors, so it only waits for these: before sweep k
+   until they have incremented IN k times, and before increment k until
+   they have completed sweep k; each thread publishes its own counts in
+   SWEPT and ADDED.  Without increment IN does not change, and threads
+   never wait.  Thread 0 ticks the harness, so the iteration times are
+   those it sees, while barriers before the first and after the last
+   iteration make the total exact.  It must be called by all threads of a
+   parallel region                                                          */
+static void iterate_p2p(long n, int radius, int iterations, int increment,
+                        stencil_row_t row, const ATYPE * RESTRICT weight,
+                        DTYPE * RESTRICT in, DTYPE * RESTRICT out,
+                        atomic_long * progress, prk_harness_t * harness) {
+  int  t = omp_get_thread_num(), active = (int) MIN(omp_get_num_threads(), n/radius);
+  long lo = n*t/active, hi = (t < active) ? n*(t+1)/active : lo, i, j, k;
+
+  atomic_store_explicit(&SWEPT(t), 0, memory_order_relaxed);
+  atomic_store_explicit(&ADDED(t), 0, memory_order_relaxed);
+  #pragma omp barrier
+
+  for (k=0; k<=iterations; k++) {
+
+    if (k == 1) {
+      #pragma omp barrier
+    }
+    if (k >= 1 && t == 0) prk_harness_tick(harness);
+    if (t >= active) continue;
+
+    if (increment) {
+      if (t > 0)
+        while (atomic_load_explicit(&ADDED(t-1), memory_order_acquire) < k);
+      if (t < active-1)
+        while (atomic_load_explicit(&ADDED(t+1), memory_order_acquire) < k);
+    }
+    for (j=MAX(lo,radius); j<MIN(hi,n-radius); j++) row(n, j, radius, weight, in, out);
+    if (!increment) continue;
+
+    atomic_store_explicit(&SWEPT(t), k+1, memory_order_release);
+    if (t > 0)
+      while (atomic_load_explicit(&SWEPT(t-1), memory_order_acquire) < k+1);
+    if (t < active-1)
+      while (atomic_load_explicit(&SWEPT(t+1), memory_order_acquire) < k+1);
+    for (j=lo; j<hi; j++) for (i=0; i<n; i++) IN(i,j) += 1.0;
+    atomic_store_explicit(&ADDED(t), k+1, memory_order_release);
+  }
+}
+
+/* Runs iterations 0 through iterations (0 is the warmup) of one
+   configuration of a scaling sweep, on a freshly initialized grid of size n
+   and with the current number of threads, in the same way as the main loop
+   with barriers.  Returns the time of the timed iterations and the L1 norm
+   of OUT in *norm                                                          */
+static double sweep_config(long n, int radius, int iterations, int tblock, long trows,
+                           int increment, stencil_row_t row,
+                           const ATYPE * RESTRICT weight, DTYPE * RESTRICT in,
+                           DTYPE * RESTRICT out, ATYPE * norm) {
+  double time = 0.0;
+  ATYPE  sum  = (ATYPE) 0.0;
+  long   i, j;
+  int    iter, steps;
+
+#if !PARALLELFOR
+  #pragma omp parallel private(i, j, iter, steps)
+  {
+#endif
+
+#if PARALLELFOR
+  #pragma omp parallel for private(i)
+#else
+  #pragma omp for
+#endif
+  for (j=0; j<n; j++) for (i=0; i<n; i++) 
+    IN(i,j) = COEFX*i+COEFY*j;
+#if PARALLELFOR
+  #pragma omp parallel for private(i)
+#else
+  #pragma omp for
+#endif
+  for (j=radius; j<n-radius; j++) for (i=radius; i<n-radius; i++) 
+    OUT(i,j) = (DTYPE)0.0;
+
+  for (iter=0, steps=1; iter<=iterations; iter+=steps) {
+    if (iter == 1) {
+#if !PARALLELFOR
+      #pragma omp barrier
+      #pragma omp master
+#endif
+      time = wtime();
+    }
+    steps = (iter == 0) ? 1 : MIN(tblock, iterations-iter+1);
+    if (steps > 1) {
+      temporal_block(n, radius, steps, trows, increment, row, weight, in, out);
+      continue;
+    }
+    sweep(n, radius, row, weight, in, out);
+    if (!increment) continue;
+#if PARALLELFOR
+    #pragma omp parallel for private(i)
+#else
+    #pragma omp for
+#endif
+    for (j=0; j<n; j++) for (i=0; i<n; i++) IN(i,j)+= 1.0;
+  }
+
+#if !PARALLELFOR
+  #pragma omp barrier
+  #pragma omp master
+#endif
+  time = wtime() - time;
+
+#if PARALLELFOR
+  #pragma omp parallel for reduction(+:sum), private (i)
+#else
+  #pragma omp for reduction(+:sum)
+#endif
+  for (j=radius; j<n-radius; j++) for (i=radius; i<n-radius; i++) {
+    sum += (ATYPE)ABS(OUT(i,j));
+  }
+#if !PARALLELFOR
+  }
+#endif
+
+  *norm = sum/((ATYPE) (n-2*radius)*(ATYPE) (n-2*radius));
+  return time;
+}
 
 int main(int argc, char ** argv) {
 
   long   n;               /* linear grid dimension                               */
   int    i, j, ii, jj, it, jt, iter;  /* dummies                                 */
-  DTYPE  norm,            /* L1 norm of solution                                 */
+  int    steps;           /* number of iterations fused in a block               */
+  int    tblock;          /* time steps per block, 1 without temporal blocking   */
+  long   trows;           /* rows per window of a temporal block                 */
+  char   *env;            /* value of PRK_TEMPORAL_BLOCK                         */
+  int    offset;          /* nonzero if the increment of IN is implicit          */
+  int    p2p = 0;         /* nonzero for point-to-point synchronization          */
+  atomic_long *progress;  /* progress counters of the threads, if p2p            */
+  ATYPE  norm,            /* L1 norm of solution                                 */
          reference_norm;
-  DTYPE  f_active_points; /* interior of grid with respect to stencil            */
-  DTYPE  flops;           /* floating point ops per iteration                    */
+  ATYPE  f_active_points; /* interior of grid with respect to stencil            */
+  ATYPE  flops;           /* floating point ops per iteration                    */
   int    iterations;      /* number of times to run the algorithm                */
+  prk_harness_t harness;  /* per-iteration timing                                */
   double stencil_time,    /* timing parameters                                   */
          avgtime;
   int    stencil_size;    /* number of points in stencil                         */
+  int    radius;          /* radius of stencil                                   */
+  int    star;            /* nonzero for a star shaped stencil                   */
+  stencil_row_t row;      /* row kernel for radius and shape                     */
+  const char *simd;       /* instruction set of the row kernel                   */
   int    nthread_input,   /* thread parameters                                   */
          nthread; 
   DTYPE  * RESTRICT in;   /* input grid values                                   */
@@ -102,7 +469,11 @@ int main(int argc, char ** argv) {
   long   total_length;    /* total required length to store grid values          */
   int    num_error=0;     /* flag that signals that requested and obtained
                              numbers of threads are the same                     */
-  DTYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
+  ATYPE  weight[WEIGHT_LEN];  /* weights of points in the stencil               */
+  prk_sweep_t scaling;    /* thread counts and results of a sweep                */
+  int    sweeping;        /* nonzero if doing a scaling sweep                    */
+  long   max_n;           /* largest grid size of a sweep                        */
+  int    k;               /* sweep configuration index                           */
 
   printf("Parallel Research Kernels version %s\n", PRKVERSION);
   printf("OpenMP stencil execution on 2D grid\n");
@@ -111,9 +482,9 @@ int main(int argc, char ** argv) {
   ** process and test input parameters    
   ********************************************************************************/
 
-  if (argc != 4){
-    printf("Usage: %s <# threads> <# iterations> <array dimension>\n", 
-           *argv);
+  if (argc < 4 || argc > 6){
+    printf("Usage: %s <# threads> <# iterations> <array dimension> "
+           "[<radius> [star|compact]]\n", *argv);
     return(EXIT_FAILURE);
   }
 
@@ -126,6 +497,7 @@ int main(int argc, char ** argv) {
   }
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
 
   iterations  = atoi(*++argv); 
   if (iterations < 1){
@@ -140,18 +512,88 @@ int main(int argc, char ** argv) {
     exit(EXIT_FAILURE);
   }
 
-  if (RADIUS < 1) {
-    printf("ERROR: Stencil radius %d should be positive\n", RADIUS);
+  radius = (argc > 4) ? atoi(*++argv) : RADIUS;
+  star   = STAR;
+  if (argc > 5) {
+    ++argv;
+    if      (!strcmp(*argv,"star"))    star = 1;
+    else if (!strcmp(*argv,"compact")) star = 0;
+    else {
+      printf("ERROR: Stencil shape %s should be star or compact\n", *argv);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (radius < 1) {
+    printf("ERROR: Stencil radius %d should be positive\n", radius);
+    exit(EXIT_FAILURE);
+  }
+
+  row = select_kernel(radius, star);
+  if (row == NULL) {
+    printf("ERROR: Stencil radius %d exceeds largest compiled radius %d\n",
+           radius, MAX(MAX_RADIUS,RADIUS));
     exit(EXIT_FAILURE);
   }
 
-  if (2*RADIUS +1 > n) {
-    printf("ERROR: Stencil radius %d exceeds grid size %d\n", RADIUS, n);
+  if (2*radius +1 > n) {
+    printf("ERROR: Stencil radius %d exceeds grid size %d\n", radius, n);
     exit(EXIT_FAILURE);
   }
 
+  /* prefer a vectorized row kernel, unless LOOPGEN expanded the loop body   */
+  simd = prk_stencil_simd_isa();
+  if (!(LOOPGEN && radius == RADIUS) && prk_stencil_simd(star))
+    row = prk_stencil_simd(star);
+  else
+    simd = "scalar";
+
+  tblock = 1;
+  trows  = 0;
+  env    = getenv("PRK_TEMPORAL_BLOCK");
+  if (env != NULL && *env != '\0') {
+    tblock = atoi(env);
+    if (strchr(env,':')) trows = atol(strchr(env,':')+1);
+    if (tblock < 1 || trows < 0) {
+      printf("ERROR: PRK_TEMPORAL_BLOCK=%s should be <steps>[:<rows>]\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  /* by default windows are narrow, but wide enough to occupy all threads     */
+  if (trows == 0) trows = MAX(8, (nthread_input+tblock-1)/tblock);
+
+  env = getenv("PRK_SYNC");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"p2p")) p2p = 1;
+    else if (strcmp(env,"barrier")) {
+      printf("ERROR: PRK_SYNC must be barrier or p2p: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (p2p && tblock > 1) {
+    printf("ERROR: PRK_SYNC=p2p cannot be combined with PRK_TEMPORAL_BLOCK\n");
+    exit(EXIT_FAILURE);
+  }
+  if (p2p) {
+    progress = (atomic_long *) prk_malloc(sizeof(atomic_long)*2*nthread_input*LINEWORDS);
+    if (!progress) {
+      printf("ERROR: could not allocate space for progress counters\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  /* grid area, not size, grows with the thread count in weak scaling          */
+  sweeping = prk_sweep_init(&scaling, nthread_input);
+  if (sweeping && p2p) {
+    printf("ERROR: PRK_SWEEP cannot be combined with PRK_SYNC=p2p\n");
+    exit(EXIT_FAILURE);
+  }
+  max_n = n;
+  if (sweeping) for (k=0; k<scaling.count; k++)
+    max_n = MAX(max_n, (long) (n*sqrt(prk_sweep_scale(&scaling,k))+0.5));
+
   /*  make sure the vector space can be represented                             */
-  total_length = n*n*sizeof(DTYPE);
+  total_length = max_n*max_n*sizeof(DTYPE);
 
   in  = (DTYPE *) prk_malloc(total_length);
   out = (DTYPE *) prk_malloc(total_length);
@@ -162,32 +604,76 @@ int main(int argc, char ** argv) {
   }
 
   /* fill the stencil weights to reflect a discrete divergence operator         */
-  for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
-    WEIGHT(ii,jj) = (DTYPE) 0.0;
-#if STAR
-  stencil_size = 4*RADIUS+1;
-  for (ii=1; ii<=RADIUS; ii++) {
-    WEIGHT(0, ii) = WEIGHT( ii,0) =  (DTYPE) (1.0/(2.0*ii*RADIUS));
-    WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(DTYPE) (1.0/(2.0*ii*RADIUS));
+  for (jj=-radius; jj<=radius; jj++) for (ii=-radius; ii<=radius; ii++)
+    WEIGHT(ii,jj) = (ATYPE) 0.0;
+  if (star) {
+    stencil_size = 4*radius+1;
+    for (ii=1; ii<=radius; ii++) {
+      WEIGHT(0, ii) = WEIGHT( ii,0) =  (ATYPE) (1.0/(2.0*ii*radius));
+      WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(ATYPE) (1.0/(2.0*ii*radius));
+    }
   }
-#else
-  stencil_size = (2*RADIUS+1)*(2*RADIUS+1);
-  for (jj=1; jj<=RADIUS; jj++) {
-    for (ii=-jj+1; ii<jj; ii++) {
-      WEIGHT(ii,jj)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));
-      WEIGHT(ii,-jj) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));
-      WEIGHT(jj,ii)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));
-      WEIGHT(-jj,ii) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*RADIUS));      
+  else {
+    stencil_size = (2*radius+1)*(2*radius+1);
+    for (jj=1; jj<=radius; jj++) {
+      for (ii=-jj+1; ii<jj; ii++) {
+        WEIGHT(ii,jj)  =  (ATYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(ii,-jj) = -(ATYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(jj,ii)  =  (ATYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(-jj,ii) = -(ATYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+      }
+      WEIGHT(jj,jj)    =  (ATYPE) (1.0/(4.0*jj*radius));
+      WEIGHT(-jj,-jj)  = -(ATYPE) (1.0/(4.0*jj*radius));
     }
-    WEIGHT(jj,jj)    =  (DTYPE) (1.0/(4.0*jj*RADIUS));
-    WEIGHT(-jj,-jj)  = -(DTYPE) (1.0/(4.0*jj*RADIUS));
   }
-#endif  
 
-  norm = (DTYPE) 0.0;
-  f_active_points = (DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS);
+  offset = increment_mode(radius, weight);
 
-  #pragma omp parallel private(i, j, ii, jj, it, jt, iter) 
+  if (sweeping) {
+    printf("Base grid size       = %ld\n", n);
+    printf("Radius of stencil    = %d\n", radius);
+    printf("Number of iterations = %d\n", iterations);
+    printf("Type of stencil      = %s\n", star ? "star" : "compact");
+    printf("SIMD micro-kernel    = %s\n", simd);
+    if (tblock > 1)
+      printf("Temporal blocking    = %d time steps, %ld rows per window\n",
+             tblock, trows);
+    printf("Increment of input   = %s\n", offset ? "implicit offset" : "sweep");
+    reference_norm = (ATYPE) (iterations+1) * (COEFX + COEFY);
+    for (k=0; k<scaling.count; k++) {
+      long m = (long) (n*sqrt(prk_sweep_scale(&scaling,k))+0.5);
+      /* let the new team fault in the pages of the grids */
+      prk_sweep_discard(in,  total_length);
+      prk_sweep_discard(out, total_length);
+      omp_set_num_threads(scaling.threads[k]);
+      stencil_time = sweep_config(m, radius, iterations, tblock, trows, !offset,
+                                  row, weight, in, out, &norm);
+      avgtime = stencil_time/iterations;
+      flops   = (ATYPE) (2*stencil_size+1) * (ATYPE) (m-2*radius)*(ATYPE) (m-2*radius);
+      prk_sweep_record(&scaling, k, m, avgtime, 1.0E-06 * flops/avgtime,
+                       ABS(norm-reference_norm) <= EPSILON);
+    }
+    prk_sweep_report(&scaling, "Stencil", "grid size", "MFlops/s");
+    prk_free(out);
+    prk_free(in);
+    for (k=0; k<scaling.count; k++) if (!scaling.valid[k]) exit(EXIT_FAILURE);
+    exit(EXIT_SUCCESS);
+  }
+
+  prk_harness_init(&harness, "Stencil", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "grid_size", "%ld", n);
+  prk_harness_param(&harness, "radius", "%d", radius);
+  prk_harness_param(&harness, "shape", "%s", star ? "star" : "compact");
+  prk_harness_param(&harness, "time_block", "%d", tblock);
+  prk_harness_param(&harness, "simd", "%s", simd);
+  prk_harness_param(&harness, "increment", "%s", offset ? "offset" : "sweep");
+  prk_harness_param(&harness, "sync", "%s", p2p ? "p2p" : "barrier");
+
+  norm = (ATYPE) 0.0;
+  f_active_points = (ATYPE) (n-2*radius)*(ATYPE) (n-2*radius);
+
+  #pragma omp parallel private(i, j, ii, jj, it, jt, iter, steps) 
   {
 
   #pragma omp master
@@ -203,14 +689,13 @@ int main(int argc, char ** argv) {
   else {
     printf("Number of threads    = %d\n",nthread_input);
     printf("Grid size            = %d\n", n);
-    printf("Radius of stencil    = %d\n", RADIUS);
+    printf("Radius of stencil    = %d\n", radius);
     printf("Number of iterations = %d\n", iterations);
-#if STAR
-    printf("Type of stencil      = star\n");
-#else
-    printf("Type of stencil      = compact\n");
-#endif
-#if DOUBLE
+    printf("Type of stencil      = %s\n", star ? "star" : "compact");
+#if MIXED
+    printf("Data type            = %s precision storage, double precision "
+           "arithmetic\n", MIXED == 2 ? "half" : "single");
+#elif DOUBLE
     printf("Data type            = double precision\n");
 #else
     printf("Data type            = single precision\n");
@@ -221,7 +706,10 @@ int main(int argc, char ** argv) {
     printf("No aliasing          = off\n");
 #endif
 #if LOOPGEN
-    printf("Script used to expand stencil loop body\n");
+    if (radius == RADIUS)
+      printf("Script used to expand stencil loop body\n");
+    else
+      printf("Compact representation of stencil loop body\n");
 #else
     printf("Compact representation of stencil loop body\n");
 #endif
@@ -230,6 +718,16 @@ int main(int argc, char ** argv) {
 #else
     printf("Parallel regions     = split (omp parallel for)\n");
 #endif
+    printf("SIMD micro-kernel    = %s\n", simd);
+    if (tblock > 1)
+      printf("Temporal blocking    = %d time steps, %ld rows per window\n",
+             tblock, trows);
+    printf("Increment of input   = %s\n", offset ? "implicit offset" : "sweep");
+    if (p2p)
+      printf("Synchronization      = point-to-point, persistent team, %ld threads active\n",
+             MIN(nthread, n/radius));
+    else
+      printf("Synchronization      = barriers\n");
   }
   }
   bail_out(num_error);
@@ -251,49 +749,39 @@ int main(int argc, char ** argv) {
 #else
   #pragma omp for
 #endif
-  for (j=RADIUS; j<n-RADIUS; j++) for (i=RADIUS; i<n-RADIUS; i++) 
+  for (j=radius; j<n-radius; j++) for (i=radius; i<n-radius; i++) 
     OUT(i,j) = (DTYPE)0.0;
 
-  for (iter = 0; iter<=iterations; iter++){
+  steps = 1;
+  if (p2p) {
+#if PARALLELFOR
+    #pragma omp parallel
+#endif
+    iterate_p2p(n, radius, iterations, !offset, row, weight, in, out, progress, &harness);
+  }
+  else for (iter = 0; iter<=iterations; iter+=steps){
 
-    /* start timer after a warmup iteration                                        */
-    if (iter == 1) { 
+    /* time every iteration after a warmup iteration; a tick ends the steps
+       iterations fused into the previous block                                  */
+    if (iter >= 1) { 
 #if !PARALLELFOR
       #pragma omp barrier
       #pragma omp master
 #endif
       {   
-        stencil_time = wtime();
+        prk_harness_ticks(&harness, steps);
       }
     }
+    steps = (iter == 0) ? 1 : MIN(tblock, iterations-iter+1);
 
-#if PARALLELFOR
-    #pragma omp parallel for private(i, ii, jj)
-#else
-    #pragma omp for
-#endif
-    for (j=RADIUS; j<n-RADIUS; j++) {
-      for (i=RADIUS; i<n-RADIUS; i++) {
-        #if STAR
-          #if LOOPGEN
-            #include "loop_body_star.incl"
-          #else
-            for (jj=-RADIUS; jj<=RADIUS; jj++)  OUT(i,j) += WEIGHT(0,jj)*IN(i,j+jj);
-            for (ii=-RADIUS; ii<0; ii++)        OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
-            for (ii=1; ii<=RADIUS; ii++)        OUT(i,j) += WEIGHT(ii,0)*IN(i+ii,j);
-          #endif
-        #else 
-          #if LOOPGEN
-            #include "loop_body_compact.incl"
-          #else
-            /* would like to be able to unroll this loop, but compiler will ignore  */
-            for (jj=-RADIUS; jj<=RADIUS; jj++) 
-            for (ii=-RADIUS; ii<=RADIUS; ii++)  OUT(i,j) += WEIGHT(ii,jj)*IN(i+ii,j+jj);
-          #endif
-        #endif
-      }
+    if (steps > 1) {
+      temporal_block(n, radius, steps, trows, !offset, row, weight, in, out);
+      continue;
     }
 
+    sweep(n, radius, row, weight, in, out);
+    if (offset) continue;
+
     /* add constant to solution to force refresh of neighbor data, if any       */
 #if PARALLELFOR
     #pragma omp parallel for private(i)
@@ -308,7 +796,8 @@ int main(int argc, char ** argv) {
   #pragma omp master
 #endif
   {
-    stencil_time = wtime() - stencil_time;
+    prk_harness_ticks(&harness, steps);
+    stencil_time = prk_harness_elapsed(&harness);
   }
 
   /* compute L1 norm in parallel                                                */
@@ -317,8 +806,8 @@ int main(int argc, char ** argv) {
 #else
   #pragma omp for reduction(+:norm)
 #endif
-  for (j=RADIUS; j<n-RADIUS; j++) for (i=RADIUS; i<n-RADIUS; i++) {
-    norm += (DTYPE)ABS(OUT(i,j));
+  for (j=radius; j<n-radius; j++) for (i=radius; i<n-radius; i++) {
+    norm += (ATYPE)ABS(OUT(i,j));
   }
 #if !PARALLELFOR
   } /* end of OPENMP parallel region                                             */
@@ -332,9 +821,10 @@ int main(int argc, char ** argv) {
 
   prk_free(out);
   prk_free(in);
+  if (p2p) prk_free(progress);
 
 /* verify correctness                                                            */
-  reference_norm = (DTYPE) (iterations+1) * (COEFX + COEFY);
+  reference_norm = (ATYPE) (iterations+1) * (COEFX + COEFY);
   if (ABS(norm-reference_norm) > EPSILON) {
     printf("ERROR: L1 norm = "FSTR", Reference L1 norm = "FSTR"\n",
            norm, reference_norm);
@@ -348,10 +838,14 @@ int main(int argc, char ** argv) {
 #endif
   }
 
-  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
+  flops = (ATYPE) (2*stencil_size+1) * f_active_points;
   avgtime = stencil_time/iterations;
   printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
          1.0E-06 * flops/avgtime, avgtime);
+  /* reads of IN and read-modify-writes of OUT and of all of IN */
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
 
   exit(EXIT_SUCCESS);
 }
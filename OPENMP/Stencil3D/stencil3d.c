@@ -0,0 +1,359 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    Stencil3D
+
+PURPOSE: This program tests the efficiency with which a space-invariant,
+         linear, symmetric filter (stencil) can be applied to a cubic
+         grid, the three-dimensional counterpart of Stencil.
+  
+USAGE:   The program takes as input the number of threads, the number of
+         iterations on the grid, the linear dimension of the grid and,
+         optionally, the tile size
+
+               <progname> <# threads> <iterations> <grid size> [<tile size>]
+  
+         Without a tile size each thread updates whole planes of the
+         grid; with one, the grid is cut into columns of tile_size x
+         tile_size points in y and z, so that the planes needed by the
+         stencil stay in cache while a column is swept in x.
+
+         The output consists of diagnostics to make sure the 
+         algorithm worked, and of timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than OpenMP or standard C functions, the following 
+         functions are used in this program:
+
+         wtime()
+         prk_topology_bind()
+         bail_out()
+         prk_harness_*()
+
+HISTORY: - Written in October 2026, following OPENMP/Stencil.
+  
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
+#include <prk_sweep.h>
+
+#if DOUBLE
+  #define DTYPE   double
+  #define EPSILON 1.e-8
+  #define COEFX   1.0
+  #define COEFY   1.0
+  #define COEFZ   1.0
+  #define FSTR    "%lf"
+#else
+  #define DTYPE   float
+  #define EPSILON 0.0001f
+  #define COEFX   1.0f
+  #define COEFY   1.0f
+  #define COEFZ   1.0f
+  #define FSTR    "%f"
+#endif
+
+/* define shorthand for indexing a multi-dimensional array                       */
+#define IN(i,j,k)        in[i+((j)+(long)(k)*n)*n]
+#define OUT(i,j,k)       out[i+((j)+(long)(k)*n)*n]
+#define WEIGHT(ii,jj,kk) weight[ii+RADIUS][jj+RADIUS][kk+RADIUS]
+
+int main(int argc, char ** argv) {
+
+  long   n;               /* linear grid dimension                               */
+  long   i, j, k;         /* grid indices                                        */
+  int    ii, jj, kk, iter;/* dummies                                             */
+  long   t, ntiles;       /* tile index, number of tiles                         */
+  long   tile_size;       /* linear dimension of a tile in y and z               */
+  int    tiling;          /* nonzero if the grid is tiled                        */
+  long   tj, tk, ntj;     /* tile extents in y and z, number of tiles in y       */
+  DTYPE  norm,            /* L1 norm of solution                                 */
+         reference_norm;
+  DTYPE  f_active_points; /* interior of grid with respect to stencil            */
+  DTYPE  flops;           /* floating point ops per iteration                    */
+  int    iterations;      /* number of times to run the algorithm                */
+  prk_harness_t harness;  /* per-iteration timing                                */
+  double stencil_time,    /* timing parameters                                   */
+         avgtime;
+  int    stencil_size;    /* number of points in stencil                         */
+  int    nthread_input,   /* thread parameters                                   */
+         nthread; 
+  DTYPE  * RESTRICT in;   /* input grid values                                   */
+  DTYPE  * RESTRICT out;  /* output grid values                                  */
+  long   total_length;    /* total required length to store grid values          */
+  int    num_error=0;     /* flag that signals that requested and obtained
+                             numbers of threads are the same                     */
+  DTYPE  weight[2*RADIUS+1][2*RADIUS+1][2*RADIUS+1]; /* stencil weights          */
+  double shell;           /* sum of squared offsets in a shell of the stencil    */
+  int    s;               /* shell of the compact stencil                        */
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("OpenMP stencil execution on 3D grid\n");
+
+  /*******************************************************************************
+  ** process and test input parameters    
+  ********************************************************************************/
+
+  if (argc != 4 && argc != 5){
+    printf("Usage: %s <# threads> <# iterations> <array dimension> [tile size]\n", 
+           *argv);
+    return(EXIT_FAILURE);
+  }
+
+  /* Take number of threads to request from command line */
+  nthread_input = atoi(*++argv); 
+
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("Stencil3D");
+  prk_topology_bind();
+
+  iterations  = atoi(*++argv); 
+  if (iterations < 1){
+    printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  n  = atol(*++argv);
+
+  if (n < 1){
+    printf("ERROR: grid dimension must be positive: %ld\n", n);
+    exit(EXIT_FAILURE);
+  }
+
+  if (RADIUS < 1) {
+    printf("ERROR: Stencil radius %d should be positive\n", RADIUS);
+    exit(EXIT_FAILURE);
+  }
+
+  if (2*RADIUS +1 > n) {
+    printf("ERROR: Stencil radius %d exceeds grid size %ld\n", RADIUS, n);
+    exit(EXIT_FAILURE);
+  }
+
+  tile_size = (argc == 5) ? atol(*++argv) : 0;
+  tiling    = (tile_size > 0 && tile_size < n-2*RADIUS);
+  /* untiled, a unit of work is one plane of the grid                            */
+  tj  = tiling ? tile_size : n-2*RADIUS;
+  tk  = tiling ? tile_size : 1;
+  ntj = (n-2*RADIUS+tj-1)/tj;
+  ntiles = ntj*((n-2*RADIUS+tk-1)/tk);
+
+  /*  make sure the vector space can be represented                             */
+  total_length = n*n*n*sizeof(DTYPE);
+  if (total_length/n/n/n != sizeof(DTYPE)) {
+    printf("ERROR: Space for %ld x %ld x %ld grid cannot be represented\n", n, n, n);
+    exit(EXIT_FAILURE);
+  }
+
+  in  = (DTYPE *) prk_malloc(total_length);
+  out = (DTYPE *) prk_malloc(total_length);
+  if (!in || !out) {
+    printf("ERROR: could not allocate space for input or output array: %ld\n",
+           total_length);
+    exit(EXIT_FAILURE);
+  }
+
+  /* fill the stencil weights to reflect a discrete divergence operator; in the
+     compact stencil the weight of a point in the cubic shell s is proportional
+     to the sum of its offsets, scaled so that every shell contributes 1/RADIUS
+     of the divergence                                                           */
+  for (kk=-RADIUS; kk<=RADIUS; kk++) for (jj=-RADIUS; jj<=RADIUS; jj++)
+  for (ii=-RADIUS; ii<=RADIUS; ii++) WEIGHT(ii,jj,kk) = (DTYPE) 0.0;
+#if STAR
+  stencil_size = 6*RADIUS+1;
+  for (ii=1; ii<=RADIUS; ii++) {
+    WEIGHT(ii,0,0) = WEIGHT(0,ii,0) = WEIGHT(0,0,ii) =  (DTYPE) (1.0/(2.0*ii*RADIUS));
+    WEIGHT(-ii,0,0)= WEIGHT(0,-ii,0)= WEIGHT(0,0,-ii)= -(DTYPE) (1.0/(2.0*ii*RADIUS));
+  }
+#else
+  stencil_size = (2*RADIUS+1)*(2*RADIUS+1)*(2*RADIUS+1);
+  for (s=1; s<=RADIUS; s++) {
+    shell = 0.0;
+    for (kk=-s; kk<=s; kk++) for (jj=-s; jj<=s; jj++) for (ii=-s; ii<=s; ii++)
+      if (MAX(ABS(ii),MAX(ABS(jj),ABS(kk))) == s) shell += ii*ii;
+    for (kk=-s; kk<=s; kk++) for (jj=-s; jj<=s; jj++) for (ii=-s; ii<=s; ii++)
+      if (MAX(ABS(ii),MAX(ABS(jj),ABS(kk))) == s)
+        WEIGHT(ii,jj,kk) = (DTYPE) ((ii+jj+kk)/(shell*RADIUS));
+  }
+#endif  
+
+  prk_harness_init(&harness, "Stencil3D", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "grid_size", "%ld", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "shape", "%s", STAR ? "star" : "compact");
+  prk_harness_param(&harness, "tile_size", "%ld", tiling ? tile_size : 0);
+
+  norm = (DTYPE) 0.0;
+  f_active_points = (DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS);
+
+  #pragma omp parallel private(i, j, k, ii, jj, kk, t, iter) 
+  {
+
+  #pragma omp master
+  {
+  nthread = omp_get_num_threads();
+
+  if (nthread != nthread_input) {
+    num_error = 1;
+    printf("ERROR: number of requested threads %d does not equal ",
+           nthread_input);
+    printf("number of spawned threads %d\n", nthread);
+  } 
+  else {
+    printf("Number of threads    = %d\n",nthread_input);
+    printf("Grid size            = %ld\n", n);
+    printf("Radius of stencil    = %d\n", RADIUS);
+    printf("Number of iterations = %d\n", iterations);
+#if STAR
+    printf("Type of stencil      = star\n");
+#else
+    printf("Type of stencil      = compact\n");
+#endif
+#if DOUBLE
+    printf("Data type            = double precision\n");
+#else
+    printf("Data type            = single precision\n");
+#endif
+    if (tiling) printf("Tile size            = %ld\n", tile_size);
+    else        printf("Untiled\n");
+  }
+  }
+  bail_out(num_error);
+
+  /* intialize the input and output arrays                                     */
+  #pragma omp for
+  for (k=0; k<n; k++) for (j=0; j<n; j++) for (i=0; i<n; i++) {
+    IN(i,j,k)  = COEFX*i+COEFY*j+COEFZ*k;
+    OUT(i,j,k) = (DTYPE)0.0;
+  }
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* time every iteration after a warmup iteration                               */
+    if (iter >= 1) { 
+      #pragma omp barrier
+      #pragma omp master
+      {   
+        prk_harness_tick(&harness);
+      }
+    }
+
+    #pragma omp for
+    for (t=0; t<ntiles; t++) {
+      long jt = RADIUS + (t%ntj)*tj, kt = RADIUS + (t/ntj)*tk;
+      for (k=kt; k<MIN(n-RADIUS,kt+tk); k++) {
+        for (j=jt; j<MIN(n-RADIUS,jt+tj); j++) {
+          for (i=RADIUS; i<n-RADIUS; i++) {
+            DTYPE sum = OUT(i,j,k);
+#if STAR
+            for (kk=-RADIUS; kk<=RADIUS; kk++) sum += WEIGHT(0,0,kk)*IN(i,j,k+kk);
+            for (jj=-RADIUS; jj<0; jj++)       sum += WEIGHT(0,jj,0)*IN(i,j+jj,k);
+            for (jj=1; jj<=RADIUS; jj++)       sum += WEIGHT(0,jj,0)*IN(i,j+jj,k);
+            for (ii=-RADIUS; ii<0; ii++)       sum += WEIGHT(ii,0,0)*IN(i+ii,j,k);
+            for (ii=1; ii<=RADIUS; ii++)       sum += WEIGHT(ii,0,0)*IN(i+ii,j,k);
+#else
+            for (kk=-RADIUS; kk<=RADIUS; kk++)
+            for (jj=-RADIUS; jj<=RADIUS; jj++)
+            for (ii=-RADIUS; ii<=RADIUS; ii++) sum += WEIGHT(ii,jj,kk)*IN(i+ii,j+jj,k+kk);
+#endif
+            OUT(i,j,k) = sum;
+          }
+        }
+      }
+    }
+
+    /* add constant to solution to force refresh of neighbor data, if any       */
+    #pragma omp for
+    for (k=0; k<n; k++) for (j=0; j<n; j++) for (i=0; i<n; i++) IN(i,j,k)+= 1.0;
+  } /* end of iterations                                                        */
+
+  #pragma omp barrier
+  #pragma omp master
+  {
+    prk_harness_tick(&harness);
+    stencil_time = prk_harness_elapsed(&harness);
+  }
+
+  /* compute L1 norm in parallel                                                */
+  #pragma omp for reduction(+:norm)
+  for (k=RADIUS; k<n-RADIUS; k++) for (j=RADIUS; j<n-RADIUS; j++)
+  for (i=RADIUS; i<n-RADIUS; i++) {
+    norm += (DTYPE)ABS(OUT(i,j,k));
+  }
+  } /* end of OPENMP parallel region                                             */
+
+  norm /= f_active_points;
+
+  /*******************************************************************************
+  ** Analyze and output results.
+  ********************************************************************************/
+
+  prk_free(out);
+  prk_free(in);
+
+/* verify correctness                                                            */
+  reference_norm = (DTYPE) (iterations+1) * (COEFX + COEFY + COEFZ);
+  if (ABS(norm-reference_norm) > EPSILON) {
+    printf("ERROR: L1 norm = "FSTR", Reference L1 norm = "FSTR"\n",
+           norm, reference_norm);
+    exit(EXIT_FAILURE);
+  }
+  else {
+    printf("Solution validates\n");
+#if VERBOSE
+    printf("Reference L1 norm = "FSTR", L1 norm = "FSTR"\n", 
+           reference_norm, norm);
+#endif
+  }
+
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
+  avgtime = stencil_time/iterations;
+  printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
+         1.0E-06 * flops/avgtime, avgtime);
+  /* reads of IN and read-modify-writes of OUT and of all of IN */
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
+
+  exit(EXIT_SUCCESS);
+}
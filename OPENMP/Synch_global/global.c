@@ -51,6 +51,22 @@ USAGE:   The program takes as input the number of times the test of
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         The barrier is selected at run time with PRK_BARRIER:
+           omp            the barrier of the OpenMP runtime (default)
+           central        centralized sense-reversing barrier: one shared
+                          counter, one shared release flag
+           tree           combining tree of counters with radix TREE_RADIX;
+                          the last arrival at the root flips the release flag
+           dissemination  log2(#threads) rounds in which every thread
+                          signals the thread 2^round further on
+           tournament     pairwise tournament; the champion (thread 0)
+                          wakes up the losers along the same tree
+           hierarchical   centralized barrier among the threads of a socket,
+                          then among the sockets; threads should be bound
+                          (see PRK_BIND) so that the grouping is stable
+         All user-level barriers use C11 atomics, and every counter and flag
+         has a cache line of its own.
+
          Compile with VERBOSE defined if you want lots of output.
 
 FUNCTIONS CALLED:
@@ -60,7 +76,12 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
+         prk_phase_*()
+         prk_topology_bind()
+         prk_topology_socket()
          chartoi()
+         user_barrier()
 
 HISTORY: Written by Rob Van der Wijngaart, December 2005.
   
@@ -68,9 +89,125 @@ HISTORY: Written by Rob Van der Wijngaart, December 2005.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
+#include <prk_sweep.h>
+#include <stdatomic.h>
 
 #define EOS '\0'
 
+/* each counter and flag gets a cache line (or two) of its own               */
+#define LINEWORDS  16
+#define SLOT(a,k)  (a)[(k)*LINEWORDS]
+#define TREE_RADIX 4
+
+enum {BARRIER_OMP, BARRIER_CENTRAL, BARRIER_TREE, BARRIER_DISSEMINATION,
+      BARRIER_TOURNAMENT, BARRIER_HIERARCHICAL, BARRIER_TYPES};
+
+static const char *barrier_name[BARRIER_TYPES] = {"omp", "central", "tree",
+  "dissemination", "tournament", "hierarchical"};
+
+typedef struct {
+  int         type;     /* one of the BARRIER_* values                        */
+  int         nthread;  /* number of participating threads                    */
+  int         nlevel;   /* number of levels of the combining tree             */
+  int         *offset;  /* first counter of each tree level                   */
+  int         *size;    /* number of counters per tree level                  */
+  int         nround;   /* number of dissemination and tournament rounds      */
+  int         ngroup;   /* number of thread groups (sockets)                  */
+  int         *group;   /* group of each thread                               */
+  int         *members; /* number of threads per group                        */
+  atomic_long *count;   /* arrival counters                                   */
+  atomic_long *sense;   /* release flags: global flag, then one per group     */
+  atomic_long *flag;    /* per-thread flags for dissemination and tournament  */
+} barrier_t;
+
+/* count an arrival; the last of the expected arrivals resets the counter    */
+static int arrive(atomic_long *count, long expected) {
+  if (atomic_fetch_add_explicit(count, 1, memory_order_acq_rel) == expected-1) {
+    atomic_store_explicit(count, 0, memory_order_relaxed);
+    return 1;
+  }
+  return 0;
+}
+
+static void await_value(atomic_long *flag, long value) {
+  while (atomic_load_explicit(flag, memory_order_acquire) != value);
+}
+
+static void await_episode(atomic_long *flag, long episode) {
+  while (atomic_load_explicit(flag, memory_order_acquire) < episode);
+}
+
+static void user_barrier(barrier_t *b, int tid, long *my_sense, long *episode) {
+  int  l, r, s, node, idx;
+
+  if (b->type == BARRIER_OMP) {
+    #pragma omp barrier
+    return;
+  }
+
+  /* release flags carry the sense of the episode, the others its number     */
+  *my_sense = !*my_sense;
+  (*episode)++;
+
+  switch (b->type) {
+  case BARRIER_CENTRAL:
+    if (arrive(&SLOT(b->count,0), b->nthread))
+      atomic_store_explicit(&SLOT(b->sense,0), *my_sense, memory_order_release);
+    else await_value(&SLOT(b->sense,0), *my_sense);
+    break;
+
+  case BARRIER_TREE:
+    /* the last arrival at a node goes on to its parent                      */
+    for (idx=tid, l=0; l<b->nlevel; idx=node, l++) {
+      node = idx/TREE_RADIX;
+      if (!arrive(&SLOT(b->count,b->offset[l]+node),
+                  MIN(TREE_RADIX, (l ? b->size[l-1] : b->nthread) - node*TREE_RADIX))) {
+        await_value(&SLOT(b->sense,0), *my_sense);
+        return;
+      }
+    }
+    atomic_store_explicit(&SLOT(b->sense,0), *my_sense, memory_order_release);
+    break;
+
+  case BARRIER_DISSEMINATION:
+    for (r=0, s=1; s<b->nthread; r++, s<<=1) {
+      atomic_store_explicit(&SLOT(b->flag,((tid+s)%b->nthread)*b->nround+r), *episode,
+                            memory_order_release);
+      await_episode(&SLOT(b->flag,tid*b->nround+r), *episode);
+    }
+    break;
+
+  case BARRIER_TOURNAMENT:
+    /* a thread wins the rounds below its lowest set bit, and loses there    */
+    for (s=1; s<b->nthread; s<<=1) {
+      if (tid & s) {
+        atomic_store_explicit(&SLOT(b->flag,2*tid), *episode, memory_order_release);
+        await_episode(&SLOT(b->flag,2*tid+1), *episode);
+        break;
+      }
+      if (tid+s < b->nthread) await_episode(&SLOT(b->flag,2*(tid+s)), *episode);
+    }
+    /* wake up the threads beaten on the way up, last round first            */
+    for (s>>=1; s>0; s>>=1) if (tid+s < b->nthread)
+      atomic_store_explicit(&SLOT(b->flag,2*(tid+s)+1), *episode, memory_order_release);
+    break;
+
+  case BARRIER_HIERARCHICAL:
+    /* the last arrival of each group represents it among the groups        */
+    l = b->group[tid];
+    if (arrive(&SLOT(b->count,1+l), b->members[l])) {
+      if (arrive(&SLOT(b->count,0), b->ngroup))
+        atomic_store_explicit(&SLOT(b->sense,0), *my_sense, memory_order_release);
+      else await_value(&SLOT(b->sense,0), *my_sense);
+      atomic_store_explicit(&SLOT(b->sense,1+l), *my_sense, memory_order_release);
+    }
+    else await_value(&SLOT(b->sense,1+l), *my_sense);
+    break;
+  }
+}
+
 static int chartoi(char c) {
   /* define short string; second character contains string terminator       */
   char letter[2]="0";
@@ -93,10 +230,18 @@ int main(int argc, char ** argv)
   long   thread_length; /* string length per thread                         */
   int    basesum;       /* checksum of base string                          */
   double stopngo_time;  /* timing parameter                                 */
+  prk_phase_t barrier;  /* timing of a single barrier, seen by thread 0     */
+  prk_harness_t harness;/* per-iteration timing, seen by thread 0           */
   int    nthread_input, /* thread parameters                                */
          nthread; 
   int    num_error=0;   /* flag that signals that requested and obtained
                              numbers of threads are the same                */
+  barrier_t bar;        /* barrier under test                               */
+  long   my_sense,      /* sense of the current barrier episode             */
+         episode;       /* number of the current barrier episode            */
+  int    *socket;       /* socket of each thread                            */
+  int    l, n, t;       /* dummies                                          */
+  char   *env;          /* value of PRK_BARRIER                             */
 
   /**************************************************************************
   ** process, and test input parameter
@@ -119,6 +264,8 @@ int main(int argc, char ** argv)
   }
 
   omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("Synch_global");
+  prk_topology_bind();
 
   iterations = atoi(*++argv);
   if(iterations < 1){
@@ -134,6 +281,49 @@ int main(int argc, char ** argv)
   }
   thread_length = length/nthread_input;
 
+  bar.type = BARRIER_OMP;
+  env = getenv("PRK_BARRIER");
+  if (env != NULL && *env != '\0') {
+    for (bar.type=0; bar.type<BARRIER_TYPES; bar.type++)
+      if (!strcmp(env,barrier_name[bar.type])) break;
+    if (bar.type == BARRIER_TYPES) {
+      printf("ERROR: PRK_BARRIER must be omp, central, tree, dissemination, ");
+      printf("tournament, or hierarchical: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  /* combining tree levels, from the leaves up                              */
+  bar.nthread = nthread_input;
+  bar.nlevel  = 0;
+  for (n=nthread_input; n>1 || !bar.nlevel; bar.nlevel++) n = (n+TREE_RADIX-1)/TREE_RADIX;
+  for (bar.nround=0, n=1; n<nthread_input; bar.nround++) n <<= 1;
+  bar.offset  = (int *) prk_malloc(2*bar.nlevel*sizeof(int));
+  bar.size    = bar.offset + bar.nlevel;
+  bar.group   = (int *) prk_malloc(3*nthread_input*sizeof(int));
+  bar.members = bar.group + nthread_input;
+  socket      = bar.members + nthread_input;
+  /* counters: tree nodes (at most nthread), or the groups plus one         */
+  bar.count   = (atomic_long *) prk_malloc((nthread_input+1)*LINEWORDS*sizeof(atomic_long));
+  bar.sense   = (atomic_long *) prk_malloc((nthread_input+1)*LINEWORDS*sizeof(atomic_long));
+  bar.flag    = (atomic_long *) prk_malloc(nthread_input*MAX(bar.nround,2)*LINEWORDS*
+                                           sizeof(atomic_long));
+  if (!bar.offset || !bar.group || !bar.count || !bar.sense || !bar.flag) {
+    printf("ERROR: Could not allocate space for barrier\n");
+    exit(EXIT_FAILURE);
+  }
+  for (n=nthread_input, t=0, l=0; l<bar.nlevel; l++) {
+    n = (n+TREE_RADIX-1)/TREE_RADIX;
+    bar.offset[l] = t;
+    bar.size[l]   = n;
+    t += n;
+  }
+  for (i=0; i<=nthread_input; i++) {
+    atomic_init(&SLOT(bar.count,i), 0);
+    atomic_init(&SLOT(bar.sense,i), 0);
+  }
+  for (i=0; i<nthread_input*MAX(bar.nround,2); i++) atomic_init(&SLOT(bar.flag,i), 0);
+
   basestring = prk_malloc((thread_length+1)*sizeof(char));
   if (basestring==NULL) {
     printf("ERROR: Could not allocate space for scramble string\n");
@@ -156,10 +346,12 @@ int main(int argc, char ** argv)
   for (i=0; i<length; i++) catstring[i]='9';
   catstring[length]=EOS;
 
-  #pragma omp parallel private(iterstring, my_ID, i, iter)
+  #pragma omp parallel private(iterstring, my_ID, i, iter, my_sense, episode)
   {
 
   my_ID = omp_get_thread_num();
+  my_sense = 0;
+  episode  = 0;
 
   /* everybody receives a private copy of the base string                   */
   iterstring = (char *) prk_malloc((thread_length+1)*sizeof(char));
@@ -189,20 +381,47 @@ int main(int argc, char ** argv)
   }
   bail_out(num_error);
 
+  /* threads on the same socket form a group of the hierarchical barrier    */
+  socket[my_ID] = prk_topology_socket();
+  #pragma omp barrier
+  #pragma omp master
+  {
+  bar.ngroup = 0;
+  for (t=0; t<nthread; t++) {
+    for (l=0; l<bar.ngroup; l++) if (socket[t] == socket[bar.members[l]]) break;
+    /* members first holds a representative thread of each new group       */
+    if (l == bar.ngroup) bar.members[bar.ngroup++] = t;
+    bar.group[t] = l;
+  }
+  for (l=0; l<bar.ngroup; l++) bar.members[l] = 0;
+  for (t=0; t<nthread; t++) bar.members[bar.group[t]]++;
+  printf("Barrier                   = %s", barrier_name[bar.type]);
+  if (bar.type == BARRIER_HIERARCHICAL) printf(" (%d groups)", bar.ngroup);
+  printf("\n");
+  }
+  #pragma omp barrier
+
   #pragma omp master 
   {
-  stopngo_time = wtime();
+  prk_harness_init(&harness, "Synch_global", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread);
+  prk_harness_param(&harness, "length", "%ld", length);
+  prk_harness_param(&harness, "barrier", "%s", barrier_name[bar.type]);
+  prk_phase_init(&barrier, "barrier");
+  prk_harness_tick(&harness);
   }
 
   for (iter=0; iter<iterations; iter++) { 
 
     /* we need a barrier to avoid reading catstring before it is complete   */
-    #pragma omp barrier
+    user_barrier(&bar, my_ID, &my_sense, &episode);
     /* glue all private strings together                                    */
     strncpy(catstring+my_ID*thread_length,iterstring,(size_t) thread_length);
 
     /* synchronize so we can read the consistent concatenated string        */
-    #pragma omp barrier
+    if (my_ID == 0) prk_phase_begin(&barrier);
+    user_barrier(&bar, my_ID, &my_sense, &episode);
+    if (my_ID == 0) prk_phase_end(&barrier);
     /* now all threads select different, nonoverlapping substring           */
     for (i=0; i<thread_length; i++) iterstring[i]=catstring[my_ID+i*nthread];
 
@@ -215,11 +434,13 @@ int main(int argc, char ** argv)
             iter, catstring, checksum);
     }
 #endif
+    /* iterations end without a barrier, so thread 0 times its own           */
+    if (my_ID == 0) prk_harness_tick(&harness);
   }
 
   #pragma omp master
   {
-  stopngo_time = wtime() - stopngo_time;
+  stopngo_time = prk_harness_elapsed(&harness);
   }
   } /* end of parallel region                                               */
 
@@ -241,6 +462,9 @@ int main(int argc, char ** argv)
   }
   printf("Rate (synch/s): %e, time (s): %lf\n", 
          (((double)iterations)/stopngo_time), stopngo_time);
+  prk_harness_report(&harness, "synch/s", 1.0);
+  prk_harness_finalize(&harness);
+  prk_phase_report(&barrier);
 
   exit(EXIT_SUCCESS);
 }  /* end of main */
@@ -47,6 +47,25 @@ USAGE:   The program takes as input the number of threads, the
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         By default threads signal each other through cache-line padded
+         flags, one per grid line, that are spun on with "omp flush", which
+         implies a full memory fence. With PRK_SYNC=atomic every block of
+         columns instead has one padded C11 atomic counter of the line groups
+         it has completed, which only grows; the producer publishes it with a
+         release store and the consumer spins on it with acquire loads.
+         PRK_TILE=<width> (requires PRK_SYNC=atomic or tasks) also cuts the first
+         dimension into blocks of that many columns, dealt to the threads
+         round-robin, so that the wavefront runs over 2D tiles of width
+         columns by group factor lines, and a thread can work on several
+         tiles along the same anti-diagonal.
+
+         PRK_SYNC=tasks leaves the synchronization to the OpenMP runtime: the
+         master thread creates one task per tile, with depend clauses on the
+         tiles to its left and below it, and the other threads execute them.
+         The tiles are the same as for PRK_SYNC=atomic, so that the overhead
+         of the task runtime can be compared with that of the flags on the
+         same input.
+
 FUNCTIONS CALLED:
 
          Other than OpenMP or standard C functions, the following 
@@ -54,6 +73,7 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, March 2006.
          - modified by Rob Van der Wijngaart, August 2006:
@@ -66,12 +86,18 @@ HISTORY: - Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_sweep.h>
+#include <stdatomic.h>
 
 /* define shorthand for indexing a multi-dimensional array                       */
 #define ARRAY(i,j) vector[i+(j)*(m)]
 /* define shorthand for flag with cache line padding                             */
 #define LINEWORDS  16
 #define flag(TID,j)    flag[((TID)+(j)*nthread)*LINEWORDS]
+/* define shorthand for padded progress counter of a block; the one behind the 
+   last block counts completed iterations                                        */
+#define PROGRESS(b)    progress[(b)*LINEWORDS]
 
 int main(int argc, char ** argv) {
 
@@ -80,10 +106,23 @@ int main(int argc, char ** argv) {
   int    i, j, jj, iter, ID; /* dummies                                          */
   int    iterations;      /* number of times to run the pipeline algorithm       */
   int    *flag;           /* used for pairwise synchronizations                  */
-  int    *start, *end;    /* starts and ends of grid slices                      */
+  int    *start, *end;    /* starts and ends of grid slices (blocks)             */
+  int    nblock;          /* number of blocks of columns                         */
+  int    b;               /* block index                                         */
+  long   target;          /* progress value a block waits for or publishes       */
+  long   ngroup;          /* number of line groups per iteration                 */
+  atomic_long *progress;  /* progress counters used with PRK_SYNC=atomic         */
+  int    atomic_sync=0;   /* use atomic progress counters                        */
+  int    task_sync=0;     /* use tasks with dependencies                         */
+  char   *dep;            /* dependence objects of tiles, plus one for corner    */
+  char   unused;          /* dependence object that no task writes               */
+  char   *left, *below;   /* dependence objects of the neighbors of a tile       */
+  long   tile_width=0;    /* width of blocks of columns, 0 means one per thread  */
+  char   *env;            /* value of PRK_SYNC or PRK_TILE                       */
   int    segment_size;
   double pipeline_time,   /* timing parameters                                   */
          avgtime; 
+  prk_harness_t harness;  /* timing of the pipelined iterations                  */
   double epsilon = 1.e-8; /* error tolerance                                     */
   double corner_val;      /* verification value at top right corner of grid      */
   int    nthread_input,   /* thread parameters                                   */
@@ -118,6 +157,7 @@ int main(int argc, char ** argv) {
   }
 
   omp_set_num_threads(nthread_input);
+  prk_sweep_unsupported("Synch_p2p");
 
   iterations  = atoi(*++argv); 
   if (iterations < 1){
@@ -140,6 +180,35 @@ int main(int argc, char ** argv) {
   }
   else grp = 1;
 
+  env = getenv("PRK_SYNC");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"atomic")) atomic_sync = 1;
+    else if (!strcmp(env,"tasks"))  task_sync   = 1;
+    else if (strcmp(env,"flush")) {
+      printf("ERROR: PRK_SYNC must be flush, atomic or tasks: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+#if _OPENMP < 201307
+  if (task_sync) {
+    printf("ERROR: PRK_SYNC=tasks requires OpenMP 4.0\n");
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+  env = getenv("PRK_TILE");
+  if (env != NULL && *env != '\0') {
+    tile_width = atol(env);
+    if (tile_width < 0) {
+      printf("ERROR: PRK_TILE must be non-negative: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+    if (tile_width > 0 && !atomic_sync && !task_sync) {
+      printf("ERROR: PRK_TILE requires PRK_SYNC=atomic or tasks\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
   total_length = sizeof(double)*m*n;
   vector = (double *) prk_malloc(total_length);
   if (!vector) {
@@ -153,27 +222,59 @@ int main(int argc, char ** argv) {
     exit(EXIT_FAILURE);
   }
 
-  start = (int *) prk_malloc(2*nthread_input*sizeof(int));
+  /* block b of columns is owned by thread b%nthread                             */
+  nblock = tile_width ? (m+tile_width-1)/tile_width : nthread_input;
+  start = (int *) prk_malloc(2*nblock*sizeof(int));
   if (!start) {
     printf("ERROR: Could not allocate space for array of slice boundaries\n");
     exit(EXIT_FAILURE);
   }
-  end = start + nthread_input;
+  end = start + nblock;
   start[0] = 0;
-  for (ID=0; ID<nthread_input; ID++) {
-    segment_size = m/nthread_input;
-    if (ID < (m%nthread_input)) segment_size++;
+  for (ID=0; ID<nblock; ID++) {
+    if (tile_width) segment_size = MIN(tile_width, m-ID*tile_width);
+    else {
+      segment_size = m/nthread_input;
+      if (ID < (m%nthread_input)) segment_size++;
+    }
     if (ID>0) start[ID] = end[ID-1]+1;
     end[ID] = start[ID]+segment_size-1;
   }
 
-  flag = (int *) prk_malloc(sizeof(int)*nthread_input*LINEWORDS*n);
-  if (!flag) {
-    printf("ERROR: COuld not allocate space for synchronization flags\n");
-    exit(EXIT_FAILURE);
+  ngroup = (n-1+grp-1)/grp;
+  if (task_sync) {
+    dep = (char *) prk_malloc(nblock*ngroup+1);
+    if (!dep) {
+      printf("ERROR: Could not allocate space for task dependence objects\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  else if (atomic_sync) {
+    progress = (atomic_long *) prk_malloc(sizeof(atomic_long)*(nblock+1)*LINEWORDS);
+    if (!progress) {
+      printf("ERROR: Could not allocate space for progress counters\n");
+      exit(EXIT_FAILURE);
+    }
+    for (b=0; b<=nblock; b++) atomic_init(&PROGRESS(b), 0);
   }
+  else {
+    flag = (int *) prk_malloc(sizeof(int)*nthread_input*LINEWORDS*n);
+    if (!flag) {
+      printf("ERROR: COuld not allocate space for synchronization flags\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  prk_harness_init(&harness, "Synch_p2p", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
+  prk_harness_param(&harness, "group", "%d", grp);
+  prk_harness_param(&harness, "sync", "%s",
+                    task_sync ? "tasks" : atomic_sync ? "atomic" : "flush");
+  if (tile_width) prk_harness_param(&harness, "tile_width", "%ld", tile_width);
 
-#pragma omp parallel private(i, j, jj, jjsize, TID, iter, true, false) 
+#pragma omp parallel private(i, j, jj, jjsize, TID, iter, true, false, b, target) 
   {
 
   #pragma omp master
@@ -191,11 +292,22 @@ int main(int argc, char ** argv) {
     printf("Number of iterations      = %d\n", iterations);
     if (grp > 1)
     printf("Group factor              = %d (cheating!)\n", grp);
+    if (atomic_sync || task_sync) {
+    if (atomic_sync)
+    printf("Synchronization           = acquire/release atomic counters\n");
+    else
+    printf("Synchronization           = task dependencies\n");
+    if (tile_width)
+    printf("Tile width                = %ld (%d blocks)\n", tile_width, nblock);
+    }
+    else {
+    printf("Synchronization           = flags with flush\n");
 #if SYNCHRONOUS
     printf("Neighbor thread handshake = on\n");
 #else
     printf("Neighbor thread handshake = off\n");
 #endif
+    }
   }
   }
   bail_out(num_error);
@@ -203,10 +315,103 @@ int main(int argc, char ** argv) {
   TID = omp_get_thread_num();
 
   /* clear the array, assuming first-touch memory placement                      */
-  for (j=0; j<n; j++) for (i=start[TID]; i<=end[TID]; i++) ARRAY(i,j) = 0.0;
-  /* set boundary values (bottom and left side of grid                           */
-  if (TID==0) for (j=0; j<n; j++) ARRAY(start[TID],j) = (double) j;
-  for (i=start[TID]; i<=end[TID]; i++) ARRAY(i,0) = (double) i;
+  for (b=TID; b<nblock; b+=nthread) {
+    for (j=0; j<n; j++) for (i=start[b]; i<=end[b]; i++) ARRAY(i,j) = 0.0;
+    /* set boundary values (bottom and left side of grid                         */
+    if (b==0) for (j=0; j<n; j++) ARRAY(start[b],j) = (double) j;
+    for (i=start[b]; i<=end[b]; i++) ARRAY(i,0) = (double) i;
+  }
+
+  if (task_sync) {
+
+  #pragma omp barrier
+  #pragma omp master
+  {
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* start timer after a warmup iteration                                      */
+    if (iter == 1) { 
+      #pragma omp taskwait
+      prk_harness_tick(&harness);
+    }
+
+    /* tile (b,g) needs tiles (b-1,g) and (b,g-1); tile (0,0) needs the corner
+       value, which is produced by the last tile of the previous iteration;
+       tiles of successive iterations are ordered through the same objects  */
+    for (b=0; b<nblock; b++) for (target=0, j=1; j<n; j+=grp, target++) {
+      left  = b>0      ? &dep[(b-1)*ngroup+target] : &unused;
+      below = target>0 ? &dep[b*ngroup+target-1]   : (b>0 ? &unused : &dep[nblock*ngroup]);
+      #pragma omp task firstprivate(b, j) private(i, jj, jjsize) \
+              depend(in: left[0], below[0]) depend(out: dep[b*ngroup+target])
+      {
+        jjsize = MIN(grp, n-j);
+        for (jj=j; jj<j+jjsize; jj++)
+        for (i=MAX(start[b],1); i<= end[b]; i++) {
+          ARRAY(i,jj) = ARRAY(i-1,jj) + ARRAY(i,jj-1) - ARRAY(i-1,jj-1);
+        }
+      }
+    }
+
+    /* copy top right corner value to bottom left corner to create dependency  */
+    #pragma omp task depend(in:  dep[nblock*ngroup-1]) depend(out: dep[nblock*ngroup])
+    ARRAY(0,0) = -ARRAY(m-1,n-1);
+
+  } /* end of iterations */
+
+  #pragma omp taskwait
+  }
+
+  }
+  else if (atomic_sync) {
+
+  #pragma omp barrier
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* start timer after a warmup iteration                                      */
+    if (iter == 1) { 
+      #pragma omp barrier
+      #pragma omp master
+      {
+        prk_harness_tick(&harness);
+      }
+    }
+
+    for (b=TID; b<nblock; b+=nthread) {
+
+      /* first block waits for corner value of the previous iteration            */
+      if (b==0) 
+        while (atomic_load_explicit(&PROGRESS(nblock), memory_order_acquire) < iter);
+
+      for (target=(long)iter*ngroup+1, j=1; j<n; j+=grp, target++) {
+
+        jjsize = MIN(grp, n-j);
+
+        /* if not on left boundary, wait for left neighbor to produce data       */
+        if (b > 0)
+          while (atomic_load_explicit(&PROGRESS(b-1), memory_order_acquire) < target);
+
+        for (jj=j; jj<j+jjsize; jj++)
+        for (i=MAX(start[b],1); i<= end[b]; i++) {
+          ARRAY(i,jj) = ARRAY(i-1,jj) + ARRAY(i,jj-1) - ARRAY(i-1,jj-1);
+        }
+
+        /* publish the new data to the right neighbor                            */
+        atomic_store_explicit(&PROGRESS(b), target, memory_order_release);
+      }
+
+      if (b==nblock-1) { /* if on right boundary, copy top right corner value 
+                  to bottom left corner to create dependency and signal completion */
+        ARRAY(0,0) = -ARRAY(m-1,n-1);
+        atomic_store_explicit(&PROGRESS(nblock), iter+1, memory_order_release);
+      }
+    }
+
+  } /* end of iterations */
+
+  }
+  else {
 
   /* set flags to zero to indicate no data is available yet                      */
   true = 1; false = !true;
@@ -228,7 +433,7 @@ int main(int argc, char ** argv) {
       #pragma omp barrier
       #pragma omp master
       {
-        pipeline_time = wtime();
+        prk_harness_tick(&harness);
       }
     }
 
@@ -291,10 +496,15 @@ int main(int argc, char ** argv) {
 
   } /* end of iterations */
 
+  }
+
+  /* successive iterations overlap in the pipeline, so they are recorded
+     as iterations of equal length                                               */
   #pragma omp barrier
   #pragma omp master
   {
-    pipeline_time = wtime() - pipeline_time;
+    prk_harness_ticks(&harness, iterations);
+    pipeline_time = prk_harness_elapsed(&harness);
   }
 
   } /* end of OPENMP parallel region                                             */
@@ -323,6 +533,8 @@ int main(int argc, char ** argv) {
   if (grp>1) avgtime *= -1.0;
   printf("Rate (MFlops/s): %lf Avg time (s): %lf\n",
          1.0E-06 * 2 * ((double)((m-1)*(n-1)))/avgtime, avgtime);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * ((double)((m-1)*(n-1))));
+  prk_harness_finalize(&harness);
 
   exit(EXIT_SUCCESS);
 }
@@ -46,6 +46,47 @@ USAGE:   Program input is three command line arguments that give the
 
          An optional parameter specifies the tile size used to divide the
          individual matrix blocks for improved cache and TLB performance. 
+         If it is omitted and PRK_AUTOTUNE is set, the tile size is chosen
+         by timing short trial runs (see prk_autotune.h).
+
+         With PRK_TRANSPOSE=recursive the matrix is instead transposed
+         cache-obliviously: the longer side of the matrix is halved
+         recursively until blocks of at most RECURSION_LEAF x
+         RECURSION_LEAF elements are left, so that some level of the
+         recursion fits each level of the memory hierarchy without a
+         tuned tile size.  The top levels of the recursion are OpenMP
+         tasks.  The default is PRK_TRANSPOSE=tiled.
+
+         With PRK_TRANSPOSE=inplace no second matrix is allocated: every
+         iteration replaces A by A^T + 1 by swapping symmetric pairs of
+         tiles (or of rows, if untiled), so that matrices of an order
+         sqrt(2) larger fit in the same memory.
+
+         With PRK_BATCH=n (n > 1) every iteration transposes a batch of n
+         matrices of the given order, as in FFT-style workloads.  The tiles
+         of all matrices of the batch are shared out in one loop, so that
+         threads move on to the next matrix without waiting for the others;
+         the reported rate is that of the whole batch.
+
+         Where the CPU supports it, tiles and leaf blocks are transposed
+         in registers by the vectorized kernels of prk_transpose_simd.h
+         (PRK_SIMD=scalar selects the plain loops).  PRK_NT_STORES=1 makes
+         them write B with non-temporal stores, PRK_NT_STORES=auto only
+         when the matrices exceed the last-level cache; the default is 0.
+
+         With PRK_SYNC=p2p the threads do not wait for each other between
+         iterations, only before the first and after the last: the static
+         schedule gives every thread the same tiles in every iteration,
+         so that it reads and writes only elements it wrote itself and
+         there is nothing to wait for.  This helps small matrices, where
+         the barrier is a large part of an iteration; the iteration
+         times are then those seen by the master thread.  PRK_SYNC=barrier
+         selects the default, which needs no other transpose than tiled.
+
+         With PRK_SWEEP set, <# threads> is the largest thread count of an
+         in-process scaling sweep (see prk_sweep.h); for weak scaling the
+         matrix order grows with the square root of the number of threads.
+         Sweeps run barrier-synchronized iterations.
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -57,29 +98,78 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()          portable wall-timer interface.
+         prk_topology_bind() optional pinning of threads and ranks.
+         prk_harness_*()  per-iteration timing and results record.
          bail_out()
          test_results()   Verify that the transpose worked
+         transpose()      transpose the matrix once
+         transpose_recursive() transpose the matrix once, cache-obliviously
+         transpose_inplace() transpose the matrix once, in place
+         transpose_batch() transpose a batch of matrices once
+         test_results_inplace() Verify that the in-place transpose worked
+         prk_transpose_simd*() vectorized tile kernels
+         fill()           initialize the matrices
+         prk_sweep_*()    in-process scaling sweeps
+         autotune_tile()  choose the fastest tile size
 
 HISTORY: Written by Tim Mattson, April 1999.  
          Updated by Rob Van der Wijngaart, December 2005.
+         Added the recursive, cache-oblivious transpose.
+         Added vectorized tile kernels and non-temporal stores.
+         Added the in-place transpose.
+         Added batches of matrices.
+         Added barrier-free iterations.
   
 *******************************************************************/
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_omp.h>
+#include <prk_harness.h>
+#include <prk_topology.h>
+#include <prk_autotune.h>
+#include <prk_sweep.h>
+#include <prk_transpose_simd.h>
 
 #define A(i,j)    A[i+order*(j)]
 #define B(i,j)    B[i+order*(j)]
 static double test_results (size_t , double*, int);
+static double test_results_inplace (size_t , double*, int);
+static void   transpose (size_t, int, int, prk_transpose_tile_t,
+                         double * RESTRICT, double * RESTRICT);
+static void   transpose_recursive (size_t, prk_transpose_tile_t,
+                                   double * RESTRICT, double * RESTRICT);
+static void   transpose_inplace (size_t, int, int, double * RESTRICT);
+static void   transpose_batch (size_t, int, int, prk_transpose_tile_t, int,
+                               double *, double *);
+static int    autotune_tile (size_t, int, prk_transpose_tile_t, double *, double *);
+static void   fill (size_t, int, int, double * RESTRICT, double * RESTRICT);
+
+#define AUTOTUNE_TRIALS 3
+
+/* largest block of the recursive transpose that is not split further    */
+#ifndef RECURSION_LEAF
+  #define RECURSION_LEAF 16
+#endif
 
 int main(int argc, char ** argv) {
 
   size_t order;         /* order of a the matrix                           */
-  size_t i, j, it, jt;  /* matrix/tile indices                             */
+  size_t it;            /* sweep iteration index                           */
   int    Tile_order=32; /* default tile size for tiling of local transpose */
   int    iterations;    /* number of times to do the transpose             */
+  prk_harness_t harness;/* per-iteration timing                            */
   int    iter;          /* dummy                                           */
   int    tiling;        /* boolean: true if tiling is used                 */
+  int    autotuned=0;   /* boolean: true if tile size was autotuned        */
+  int    recursive=0;   /* boolean: true if transposing cache-obliviously  */
+  int    inplace=0;     /* boolean: true if transposing A into itself      */
+  int    nbatch=1;      /* number of matrices transposed per iteration     */
+  int    p2p=0;         /* boolean: true if iterations are not separated
+                           by barriers                                     */
+  int    k;             /* matrix index within batch                       */
+  char   *env;          /* value of PRK_TRANSPOSE                          */
+  int    streaming;     /* boolean: true if B is written non-temporally    */
+  prk_transpose_tile_t kernel; /* vectorized tile kernel, or NULL          */
   double bytes;         /* combined size of matrices                       */
   double * RESTRICT A;  /* buffer to hold original matrix                  */
   double * RESTRICT B;  /* buffer to hold transposed matrix                */
@@ -91,6 +181,9 @@ int main(int argc, char ** argv) {
          nthread;
   int    num_error=0;     /* flag that signals that requested and 
                              obtained numbers of threads are the same      */
+  prk_sweep_t sweep;    /* thread counts and results of a sweep            */
+  int    sweeping;      /* boolean: true if doing a scaling sweep          */
+  size_t max_order;     /* largest matrix order of a sweep                 */
 
   /*********************************************************************
   ** read and test input parameters
@@ -114,6 +207,7 @@ int main(int argc, char ** argv) {
   }
 
   omp_set_num_threads(nthread_input);
+  prk_topology_bind();
 
   iterations  = atoi(*++argv); 
   if (iterations < 1){
@@ -128,30 +222,151 @@ int main(int argc, char ** argv) {
   }
 
   if (argc == 5) Tile_order = atoi(*++argv);
-  /* a non-positive tile size means no tiling of the local transpose */
-  tiling = (Tile_order > 0) && (Tile_order < order);
-  if (!tiling) Tile_order = order;
+
+  env = getenv("PRK_TRANSPOSE");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"recursive")) recursive = 1;
+    else if (!strcmp(env,"inplace"))   inplace   = 1;
+    else if (strcmp(env,"tiled")) {
+      printf("ERROR: PRK_TRANSPOSE must be tiled, recursive or inplace: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  env = getenv("PRK_BATCH");
+  if (env != NULL) nbatch = atoi(env);
+  if (nbatch < 1) {
+    printf("ERROR: PRK_BATCH must be positive: %s\n", env);
+    exit(EXIT_FAILURE);
+  }
+  if (nbatch > 1 && (recursive || inplace)) {
+    printf("ERROR: batches of matrices need PRK_TRANSPOSE=tiled\n");
+    exit(EXIT_FAILURE);
+  }
+
+  env = getenv("PRK_SYNC");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"p2p")) p2p = 1;
+    else if (strcmp(env,"barrier")) {
+      printf("ERROR: PRK_SYNC must be barrier or p2p: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (p2p && (recursive || inplace)) {
+    printf("ERROR: PRK_SYNC=p2p needs PRK_TRANSPOSE=tiled\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* matrix area, not order, grows with the thread count in weak scaling */
+  sweeping  = prk_sweep_init(&sweep, nthread_input);
+  if (sweeping && nbatch > 1) {
+    printf("ERROR: batches of matrices cannot be swept\n");
+    exit(EXIT_FAILURE);
+  }
+  if (sweeping && p2p) {
+    printf("ERROR: PRK_SWEEP cannot be combined with PRK_SYNC=p2p\n");
+    exit(EXIT_FAILURE);
+  }
+  max_order = order;
+  if (sweeping) for (iter=0; iter<sweep.count; iter++)
+    max_order = MAX(max_order, (size_t) (order*sqrt(prk_sweep_scale(&sweep,iter))+0.5));
 
   /*********************************************************************
   ** Allocate space for the input and transpose matrix
   *********************************************************************/
 
-  A   = (double *)prk_malloc(order*order*sizeof(double));
+  A   = (double *)prk_malloc(nbatch*max_order*max_order*sizeof(double));
   if (A == NULL){
     printf(" ERROR: cannot allocate space for input matrix: %ld\n", 
-           order*order*sizeof(double));
+           nbatch*max_order*max_order*sizeof(double));
     exit(EXIT_FAILURE);
   }
-  B  = (double *)prk_malloc(order*order*sizeof(double));
-  if (B == NULL){
+  /* the in-place transpose needs no output matrix                      */
+  B  = inplace ? NULL : (double *)prk_malloc(nbatch*max_order*max_order*sizeof(double));
+  if (B == NULL && !inplace){
     printf(" ERROR: cannot allocate space for output matrix: %ld\n", 
-           order*order*sizeof(double));
+           nbatch*max_order*max_order*sizeof(double));
     exit(EXIT_FAILURE);
   }
 
-  bytes = 2.0 * sizeof(double) * order * order;
+  streaming = prk_transpose_streaming(2.0 * sizeof(double) * order * order);
+  kernel    = inplace ? NULL : prk_transpose_simd(streaming);
+  streaming = streaming && kernel;
+
+  if (argc != 5 && !recursive && !inplace && prk_autotune_mode() != PRK_AUTOTUNE_OFF) {
+    Tile_order = autotune_tile(order, nthread_input, kernel, A, B);
+    autotuned  = 1;
+  }
+  /* a non-positive tile size means no tiling of the local transpose; the
+     recursive transpose needs no tile size                              */
+  tiling = (Tile_order > 0) && (Tile_order < order) && !recursive;
+  if (!tiling) Tile_order = order;
+
+  if (sweeping) {
+    int tile = tiling ? Tile_order : 0;
+    printf("Base matrix order     = %zu\n", order);
+    printf("Number of iterations  = %d\n", iterations);
+    if (recursive)
+      printf("Recursive transpose   = leaf blocks of %d x %d\n",
+             RECURSION_LEAF, RECURSION_LEAF);
+    else
+      printf("Tile size             = %d%s\n", tile, autotuned ? " (autotuned)" : "");
+    if (inplace)
+      printf("In-place transpose    = on\n");
+    else
+      printf("SIMD micro-kernel     = %s\n", kernel ? prk_transpose_simd_isa() : "scalar");
+    for (iter=0; iter<sweep.count; iter++) {
+      size_t n = (size_t) (order*sqrt(prk_sweep_scale(&sweep,iter))+0.5);
+      prk_transpose_tile_t k = inplace ? NULL :
+        prk_transpose_simd(prk_transpose_streaming(2.0 * sizeof(double) * n * n));
+      int    t = (tile > 0 && tile < n) ? tile : (int) n;
+      if (recursive) t = (int) n;
+      /* let the new team fault in the pages of the matrices */
+      prk_sweep_discard(A, max_order*max_order*sizeof(double));
+      if (B) prk_sweep_discard(B, max_order*max_order*sizeof(double));
+      omp_set_num_threads(sweep.threads[iter]);
+      #pragma omp parallel private(it)
+      {
+        fill(n, t, t < n, A, B);
+        for (it=0; it<=iterations; it++) {
+          if (it == 1) {
+            #pragma omp barrier
+            #pragma omp master
+            transpose_time = wtime();
+          }
+          if      (recursive) transpose_recursive(n, k, A, B);
+          else if (inplace)   transpose_inplace(n, t, t < n, A);
+          else                transpose(n, t, t < n, k, A, B);
+        }
+        #pragma omp barrier
+        #pragma omp master
+        transpose_time = wtime() - transpose_time;
+      }
+      avgtime = transpose_time/iterations;
+      bytes   = 2.0 * sizeof(double) * n * n;
+      abserr  = inplace ? test_results_inplace(n, A, iterations)
+                        : test_results(n, B, iterations);
+      prk_sweep_record(&sweep, iter, n, avgtime, 1.0E-06 * bytes/avgtime, abserr < epsilon);
+    }
+    prk_sweep_report(&sweep, "Transpose", "order", "MB/s");
+    for (iter=0; iter<sweep.count; iter++) if (!sweep.valid[iter]) exit(EXIT_FAILURE);
+    exit(EXIT_SUCCESS);
+  }
+
+  bytes = 2.0 * sizeof(double) * order * order * nbatch;
+
+  prk_harness_init(&harness, "Transpose", "OpenMP", iterations);
+  prk_harness_param(&harness, "threads", "%d", nthread_input);
+  prk_harness_param(&harness, "order", "%zu", order);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? Tile_order : 0);
+  prk_harness_param(&harness, "algorithm", "%s",
+                    recursive ? "recursive" : inplace ? "inplace" : "tiled");
+  prk_harness_param(&harness, "simd", "%s", kernel ? prk_transpose_simd_isa() : "scalar");
+  prk_harness_param(&harness, "nt_stores", "%d", streaming);
+  prk_harness_param(&harness, "batch", "%d", nbatch);
+  prk_harness_param(&harness, "sync", "%s", p2p ? "p2p" : "barrier");
 
-#pragma omp parallel private (i, j, it, jt, iter)
+#pragma omp parallel private (iter, k)
   {  
 
   #pragma omp master
@@ -167,8 +382,13 @@ int main(int argc, char ** argv) {
     printf("Number of threads     = %i;\n",nthread_input);
     printf("Matrix order          = %ld\n", order);
     printf("Number of iterations  = %d\n", iterations);
-    if (tiling) {
-      printf("Tile size             = %d\n", Tile_order);
+    if (nbatch > 1)
+      printf("Matrices per batch    = %d\n", nbatch);
+    if (recursive)
+      printf("Recursive transpose   = leaf blocks of %d x %d\n",
+             RECURSION_LEAF, RECURSION_LEAF);
+    else if (tiling) {
+      printf("Tile size             = %d%s\n", Tile_order, autotuned ? " (autotuned)" : "");
 #if COLLAPSE
       printf("Loop collapse         = on\n");
 #else
@@ -177,81 +397,56 @@ int main(int argc, char ** argv) {
     }
     else                   
       printf("Untiled\n");
+    if (inplace)
+      printf("In-place transpose    = on\n");
+    else if (tiling || recursive) {
+      printf("SIMD micro-kernel     = %s\n", kernel ? prk_transpose_simd_isa() : "scalar");
+      printf("Non-temporal stores   = %s\n", streaming ? "on" : "off");
+    }
+    printf("Synchronization       = %s\n",
+           p2p ? "none between iterations" : "barrier per iteration");
   }
   }
   bail_out(num_error);
 
-  /*  Fill the original matrix, set transpose to known garbage value. */
-
-  if (tiling) {
-#if COLLAPSE
-    #pragma omp for collapse(2)
-#else
-    #pragma omp for
-#endif
-    for (j=0; j<order; j+=Tile_order) 
-      for (i=0; i<order; i+=Tile_order) 
-        for (jt=j; jt<MIN(order,j+Tile_order);jt++)
-          for (it=i; it<MIN(order,i+Tile_order); it++){
-            A(it,jt) = (double) (order*jt + it);
-            B(it,jt) = 0.0;
-          }
-  }
-  else {
-    #pragma omp for
-    for (j=0;j<order;j++) 
-      for (i=0;i<order; i++) {
-        A(i,j) = (double) (order*j + i);
-        B(i,j) = 0.0;
-      }
-  }
+  for (k=0; k<nbatch; k++)
+    fill(order, Tile_order, tiling, A+k*order*order, B ? B+k*order*order : NULL);
 
   for (iter = 0; iter<=iterations; iter++){
 
-    /* start timer after a warmup iteration                                        */
-    if (iter == 1) { 
-      #pragma omp barrier
+    /* time every iteration after a warmup iteration; without barriers the
+       master thread times its own share of the iterations                      */
+    if (iter >= 1) { 
+      if (iter == 1 || !p2p) {
+        #pragma omp barrier
+      }
       #pragma omp master
       {
-        transpose_time = wtime();
+        prk_harness_tick(&harness);
       }
     }
 
     /* Transpose the  matrix                                                       */
-    if (!tiling) {
-      #pragma omp for 
-      for (i=0;i<order; i++) 
-        for (j=0;j<order;j++) { 
-          B(j,i) += A(i,j);
-          A(i,j) += 1.0;
-        }
-    }
-    else {
-#if COLLAPSE
-      #pragma omp for collapse(2)
-#else
-      #pragma omp for
-#endif
-      for (i=0; i<order; i+=Tile_order) 
-        for (j=0; j<order; j+=Tile_order) 
-          for (it=i; it<MIN(order,i+Tile_order); it++) 
-            for (jt=j; jt<MIN(order,j+Tile_order);jt++) {
-              B(jt,it) += A(it,jt);
-              A(it,jt) += 1.0;
-            } 
-    }	
+    if      (recursive) transpose_recursive(order, kernel, A, B);
+    else if (inplace)   transpose_inplace(order, Tile_order, tiling, A);
+    else if (nbatch > 1) transpose_batch(order, Tile_order, tiling, kernel, nbatch, A, B);
+    else                transpose(order, Tile_order, tiling, kernel, A, B);
 
   }  /* end of iter loop  */
 
   #pragma omp barrier
   #pragma omp master
   {
-    transpose_time = wtime() - transpose_time;
+    prk_harness_tick(&harness);
+    transpose_time = prk_harness_elapsed(&harness);
   }
 
   } /* end of OpenMP parallel region */
 
-  abserr =  test_results (order, B, iterations);
+  abserr = inplace ? test_results_inplace (order, A, iterations)
+                   : test_results (order, B, iterations);
+  for (k=1; k<nbatch; k++)
+    abserr += test_results (order, B+k*order*order, iterations);
 
   prk_free(B);
   prk_free(A);
@@ -265,6 +460,12 @@ int main(int argc, char ** argv) {
     avgtime = transpose_time/iterations;
     printf("Rate (MB/s): %lf Avg time (s): %lf\n",
            1.0E-06 * bytes/avgtime, avgtime);
+    /* B += A^T and A += 1: two reads and two writes per element;
+       A = A^T + 1: one read and one write per element            */
+    if (inplace) prk_harness_model(&harness, 1.0*order*order, bytes);
+    else         prk_harness_model(&harness, 2.0*order*order, 2.0*bytes);
+    prk_harness_report(&harness, "MB/s", 1.0E-06 * bytes);
+    prk_harness_finalize(&harness);
 #if VERBOSE
     printf("Squared errors: %f \n", abserr);
 #endif
@@ -280,6 +481,272 @@ int main(int argc, char ** argv) {
 
 
 
+/* function that fills the original matrix and sets the transpose to a 
+   known garbage value, in the same order in which the transpose visits 
+   them; B is NULL for the in-place transpose; it must be called by all
+   threads of a parallel region                                         */
+
+void fill(size_t order, int Tile_order, int tiling, 
+          double * RESTRICT A, double * RESTRICT B) {
+
+  size_t i, j, it, jt;
+
+  if (tiling) {
+#if COLLAPSE
+    #pragma omp for collapse(2)
+#else
+    #pragma omp for
+#endif
+    for (j=0; j<order; j+=Tile_order) 
+      for (i=0; i<order; i+=Tile_order) 
+        for (jt=j; jt<MIN(order,j+Tile_order);jt++)
+          for (it=i; it<MIN(order,i+Tile_order); it++){
+            A(it,jt) = (double) (order*jt + it);
+            if (B) B(it,jt) = 0.0;
+          }
+  }
+  else {
+    #pragma omp for
+    for (j=0;j<order;j++) 
+      for (i=0;i<order; i++) {
+        A(i,j) = (double) (order*j + i);
+        if (B) B(i,j) = 0.0;
+      }
+  }
+}
+
+/* function that transposes A into B once (B += A^T, A += 1), with the
+   vectorized kernel for every tile, if there is one; the static schedule
+   gives every thread the same tiles every time, so that the caller only
+   needs a barrier before others read what it wrote; it must be called
+   by all threads of a parallel region                                  */
+
+void transpose(size_t order, int Tile_order, int tiling, prk_transpose_tile_t kernel,
+               double * RESTRICT A, double * RESTRICT B) {
+
+  size_t i, j, it, jt;
+
+  if (!tiling) {
+    #pragma omp for schedule(static) nowait
+    for (i=0;i<order; i++) 
+      for (j=0;j<order;j++) { 
+        B(j,i) += A(i,j);
+        A(i,j) += 1.0;
+      }
+  }
+  else {
+#if COLLAPSE
+    #pragma omp for collapse(2) schedule(static) nowait
+#else
+    #pragma omp for schedule(static) nowait
+#endif
+    for (i=0; i<order; i+=Tile_order) 
+      for (j=0; j<order; j+=Tile_order) {
+        if (kernel) 
+          kernel(order, i, MIN(order,i+Tile_order), j, MIN(order,j+Tile_order), A, B);
+        else 
+          for (it=i; it<MIN(order,i+Tile_order); it++) 
+            for (jt=j; jt<MIN(order,j+Tile_order);jt++) {
+              B(jt,it) += A(it,jt);
+              A(it,jt) += 1.0;
+            } 
+      }
+  }	
+}
+
+/* function that transposes each of a batch of nbatch consecutive matrices
+   like transpose(); the tiles (rows, if untiled) of all matrices form
+   a single work-sharing loop, shared out like those of transpose(), so
+   that there is at most one barrier per batch; it must be called by all
+   threads of a parallel region                                         */
+
+void transpose_batch(size_t order, int Tile_order, int tiling, prk_transpose_tile_t kernel,
+                     int nbatch, double *A_batch, double *B_batch) {
+
+  size_t i, j, it, jt;
+  size_t rows = tiling ? Tile_order : 1;
+  size_t cols = tiling ? Tile_order : order;
+  int    k;
+
+#if COLLAPSE
+  #pragma omp for collapse(3) schedule(static) nowait
+#else
+  #pragma omp for collapse(2) schedule(static) nowait
+#endif
+  for (k=0; k<nbatch; k++) 
+    for (i=0; i<order; i+=rows) 
+      for (j=0; j<order; j+=cols) {
+        double * RESTRICT A = A_batch + k*order*order;
+        double * RESTRICT B = B_batch + k*order*order;
+        if (kernel && tiling) 
+          kernel(order, i, MIN(order,i+rows), j, MIN(order,j+cols), A, B);
+        else 
+          for (it=i; it<MIN(order,i+rows); it++) 
+            for (jt=j; jt<MIN(order,j+cols);jt++) {
+              B(jt,it) += A(it,jt);
+              A(it,jt) += 1.0;
+            } 
+      }
+}
+
+/* function that replaces A by A^T + 1 once, without a second matrix:
+   each tile on or above the diagonal (each row, if untiled) is swapped
+   with its mirror image by the thread that owns it; diagonals vary in
+   length, hence the dynamic schedule; it must be called by all threads
+   of a parallel region                                                 */
+
+void transpose_inplace(size_t order, int Tile_order, int tiling,
+                       double * RESTRICT A) {
+
+  size_t i, j, it, jt;
+  double t;
+
+  if (!tiling) {
+    #pragma omp for schedule(dynamic)
+    for (i=0;i<order; i++) {
+      A(i,i) += 1.0;
+      for (j=i+1;j<order;j++) {
+        t      = A(i,j);
+        A(i,j) = A(j,i) + 1.0;
+        A(j,i) = t + 1.0;
+      }
+    }
+  }
+  else {
+    #pragma omp for schedule(dynamic)
+    for (i=0; i<order; i+=Tile_order) 
+      for (j=i; j<order; j+=Tile_order) 
+        for (it=i; it<MIN(order,i+Tile_order); it++) {
+          /* a diagonal tile is its own mirror image */
+          jt = j;
+          if (i == j) {
+            A(it,it) += 1.0;
+            jt = it+1;
+          }
+          for (; jt<MIN(order,j+Tile_order);jt++) {
+            t        = A(it,jt);
+            A(it,jt) = A(jt,it) + 1.0;
+            A(jt,it) = t + 1.0;
+          } 
+        }
+  }
+}
+
+/* function that transposes the block i0..i1-1 x j0..j1-1 of A into B,
+   halving its longer side until it is at most RECURSION_LEAF square; the
+   first half of a split is a task for depth more levels                */
+
+
+static void transpose_block(size_t order, size_t i0, size_t i1, size_t j0,
+                            size_t j1, int depth, prk_transpose_tile_t kernel,
+                            double * RESTRICT A, double * RESTRICT B) {
+
+  size_t i, j, mid;
+
+  if (i1-i0 <= RECURSION_LEAF && j1-j0 <= RECURSION_LEAF) {
+    if (kernel) {
+      kernel(order, i0, i1, j0, j1, A, B);
+      return;
+    }
+    for (i=i0; i<i1; i++) 
+      for (j=j0; j<j1; j++) {
+        B(j,i) += A(i,j);
+        A(i,j) += 1.0;
+      }
+    return;
+  }
+  if (i1-i0 >= j1-j0) {
+    mid = i0 + (i1-i0)/2;
+    if (depth > 0) {
+      #pragma omp task
+      transpose_block(order, i0, mid, j0, j1, depth-1, kernel, A, B);
+    }
+    else transpose_block(order, i0, mid, j0, j1, depth-1, kernel, A, B);
+    transpose_block(order, mid, i1, j0, j1, depth-1, kernel, A, B);
+  }
+  else {
+    mid = j0 + (j1-j0)/2;
+    if (depth > 0) {
+      #pragma omp task
+      transpose_block(order, i0, i1, j0, mid, depth-1, kernel, A, B);
+    }
+    else transpose_block(order, i0, i1, j0, mid, depth-1, kernel, A, B);
+    transpose_block(order, i0, i1, mid, j1, depth-1, kernel, A, B);
+  }
+}
+
+/* function that transposes A into B once like transpose(), but
+   cache-obliviously; one thread starts the recursion and the tasks of
+   its top levels, about eight per thread, are shared by all threads of
+   the parallel region, which must all call it                          */
+
+void transpose_recursive(size_t order, prk_transpose_tile_t kernel,
+                         double * RESTRICT A, double * RESTRICT B) {
+
+  int depth = 0;
+
+  while ((1 << depth) < 8*omp_get_num_threads()) depth++;
+  /* the barrier at the end of the single construct completes all tasks */
+  #pragma omp single
+  transpose_block(order, 0, order, 0, order, depth, kernel, A, B);
+}
+
+/* function that returns the tile size (0 for untiled) with the shortest
+   time of a few trial transposes, or the cached one; A and B are used
+   as scratch space                                                      */
+
+int autotune_tile(size_t order, int nthread, prk_transpose_tile_t kernel,
+                  double *A, double *B) {
+
+  static const int candidates[] = {0, 8, 16, 24, 32, 48, 64, 96, 128, 256};
+  int    ncandidates = sizeof(candidates)/sizeof(candidates[0]);
+  int    c, best = 0, tile, trial;
+  size_t i, j;
+  double best_time = -1.0, trial_time;
+  char   problem[64];
+
+  snprintf(problem, sizeof(problem), "order=%zu,threads=%d,simd=%s", order, nthread,
+           kernel ? prk_transpose_simd_isa() : "scalar");
+  if (prk_autotune_lookup("Transpose-OpenMP", problem, 1, &best)) {
+    printf("Autotuning: using cached tile size %d\n", best);
+    return best;
+  }
+
+  #pragma omp parallel for private(i)
+  for (j=0; j<order; j++) for (i=0; i<order; i++) A(i,j) = B(i,j) = 0.0;
+
+  for (c=0; c<ncandidates; c++) {
+    tile = candidates[c];
+    /* tiles as large as the matrix are the same as no tiling */
+    if (tile >= order) break;
+
+    #pragma omp parallel private(trial)
+    {
+    for (trial=0; trial<=AUTOTUNE_TRIALS; trial++) {
+      if (trial == 1) {
+        #pragma omp barrier
+        #pragma omp master
+        trial_time = wtime();
+      }
+      transpose(order, tile > 0 ? tile : (int) order, tile > 0, kernel, A, B);
+    }
+    #pragma omp barrier
+    #pragma omp master
+    trial_time = wtime() - trial_time;
+    }
+
+    if (best_time < 0.0 || trial_time < best_time) {
+      best_time = trial_time;
+      best      = tile;
+    }
+  }
+
+  printf("Autotuning: tile size %d is fastest, %lf s per transpose\n",
+         best, best_time/AUTOTUNE_TRIALS);
+  prk_autotune_store("Transpose-OpenMP", problem, 1, &best, best_time/AUTOTUNE_TRIALS);
+  return best;
+}
+
 /* function that computes the error committed during the transposition */
 
 double test_results (size_t order, double *B, int iterations) {
@@ -288,7 +755,7 @@ double test_results (size_t order, double *B, int iterations) {
   size_t i, j;
 
   double addit = ((double)(iterations+1) * (double) (iterations))/2.0;
-  #pragma omp parallel for reduction(+:abserr)
+  #pragma omp parallel for private(i) reduction(+:abserr)
   for (j=0;j<order;j++) {
     for (i=0;i<order; i++) {
       abserr += ABS(B(i,j) - ((i*order + j)*(iterations+1L)+addit));
@@ -303,3 +770,28 @@ double test_results (size_t order, double *B, int iterations) {
 #endif   
   return abserr;
 }
+
+/* function that computes the error committed during the in-place
+   transposition: after an odd number of transposes A holds the
+   transpose of its initial value, after an even number the initial
+   value itself, plus one per transpose                                 */
+
+double test_results_inplace (size_t order, double *A, int iterations) {
+
+  double abserr=0.0;
+  size_t i, j;
+  long   k = iterations+1L;
+
+  #pragma omp parallel for private(i) reduction(+:abserr)
+  for (j=0;j<order;j++) {
+    for (i=0;i<order; i++) {
+      double ref = (k%2) ? (double) (order*i + j) : (double) (order*j + i);
+      abserr += ABS(A(i,j) - (ref + k));
+    }
+  }
+
+#if VERBOSE
+  printf(" Squared sum of differences: %f\n",abserr);
+#endif   
+  return abserr;
+}
@@ -0,0 +1,247 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/* Copyright 1991-2013: John D. McCalpin                                 */
+/*-----------------------------------------------------------------------*/
+/* License:                                                              */
+/*  1. You are free to use this program and/or to redistribute           */
+/*     this program.                                                     */
+/*  2. You are free to modify this program for your own use,             */
+/*     including commercial use, subject to the publication              */
+/*     restrictions in item 3.                                           */
+/*  3. You are free to publish results obtained from running this        */
+/*     program, or from works that you derive from this program,         */
+/*     with the following limitations:                                   */
+/*     3a. In order to be referred to as "STREAM benchmark results",     */
+/*         published results must be in conformance to the STREAM        */
+/*         Run Rules, (briefly reviewed below) published at              */
+/*         http://www.cs.virginia.edu/stream/ref.html                    */
+/*         and incorporated herein by reference.                         */
+/*         As the copyright holder, John McCalpin retains the            */
+/*         right to determine conformity with the Run Rules.             */
+/*     3b. Results based on modified source code or on runs not in       */
+/*         accordance with the STREAM Run Rules must be clearly          */
+/*         labelled whenever they are published.  Examples of            */
+/*         proper labelling include:                                     */
+/*           "tuned STREAM benchmark results"                            */
+/*           "based on a variant of the STREAM benchmark code"           */
+/*         Other comparable, clear, and reasonable labelling is          */
+/*         acceptable.                                                   */
+/*     3c. Submission of results to the STREAM benchmark web site        */
+/*         is encouraged, but not required.                              */
+/*  4. Use of this program or creation of derived works based on this    */
+/*     program constitutes acceptance of these licensing restrictions.   */
+/*  5. Absolutely no warranty is expressed or implied.                   */
+/*-----------------------------------------------------------------------*/
+
+/**********************************************************************
+ 
+NAME:      nstream
+ 
+PURPOSE:   To compute memory bandwidth of a target device (GPU) when
+           adding a vector of a given number of double precision values
+           to the scalar multiple of another vector of the same length,
+           and storing the result in a third vector.
+ 
+USAGE:     The program takes as input the number of iterations to loop
+           over the triad vectors, the length of the vectors, and the
+           offset between vectors
+ 
+           <progname> <# iterations> <vector length> <offset>
+ 
+           The output consists of diagnostics to make sure the 
+           algorithm worked, and of timing statistics.
+
+           The vectors are copied to the device once, with target enter
+           data, stay there for all iterations, and only the result is
+           copied back. Every iteration is a target teams distribute
+           parallel for loop, and only those loops are timed; the time
+           of the transfers between host and device is reported
+           separately. Without a device the target regions run on the
+           host.
+ 
+FUNCTIONS CALLED:
+ 
+           Other than OpenMP or standard C functions, the following 
+           external functions are used in this program:
+ 
+           wtime()
+ 
+NOTES:     Bandwidth is determined as the number of words read, plus the 
+           number of words written, times the size of the words, divided 
+           by the execution time. For a vector length of N, the total 
+           number of words read and written is 4*N*sizeof(double).
+ 
+HISTORY:   Derived from OPENMP/Nstream, October 2026, which is loosely
+           based on the Stream benchmark by John McCalpin, but does not
+           follow all the Stream rules. Hence, reported results should
+           not be associated with Stream in external publications
+**********************************************************************/
+ 
+#include <par-res-kern_general.h>
+#include <par-res-kern_omp.h>
+ 
+#define SCALAR  3.0
+ 
+int main(int argc, char **argv) 
+{
+  int      iterations;    /* number of times vector loop gets repeated   */
+  long int length,        /* total vector length                         */
+           offset;        /* offset between vectors a and b, and b and c */
+  long int j, iter;       /* dummies                                     */
+  double   bytes;         /* memory IO size                              */
+  size_t   space;         /* memory used for the vectors                 */
+  double   nstream_time,  /* timing parameters                           */
+           avgtime,
+           to_time,       /* time of transfers to the device             */
+           from_time;     /* time of transfers from the device           */
+  double   scalar;        /* constant used in Triad operation            */
+  double   aj, bj, cj, asum; /* verification values                      */
+  double   epsilon = 1.e-8;
+  double   * RESTRICT a, * RESTRICT b, * RESTRICT c; /* the vectors      */
+ 
+/**********************************************************************************
+* process and test input parameters    
+***********************************************************************************/
+ 
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("OpenMP target stream triad: A = B + scalar*C\n");
+
+  if (argc != 4){
+     printf("Usage:  %s <# iterations> <vector length> <offset>\n", *argv);
+     exit(EXIT_FAILURE);
+  }
+ 
+  iterations    = atoi(*++argv);
+  length        = atol(*++argv);
+  offset        = atol(*++argv);
+
+  if ((iterations < 1)) {
+    printf("ERROR: Invalid number of iterations: %d\n", iterations);
+    exit(EXIT_FAILURE);
+  }
+ 
+  if (length < 0) {
+    printf("ERROR: Invalid vector length: %ld\n", length);
+    exit(EXIT_FAILURE);
+  }
+
+  if (offset < 0) {
+    printf("ERROR: Invalid array offset: %ld\n", offset);
+    exit(EXIT_FAILURE);
+  }
+
+  space = (3*length + 2*offset)*sizeof(double);
+  a = (double *) prk_malloc(space);
+  if (!a) {
+    printf("ERROR: Could not allocate %ld words for vectors\n", 
+           3*length+2*offset);
+    exit(EXIT_FAILURE);
+  }
+  b = a + length + offset;
+  c = b + length + offset;
+
+  printf("Number of devices    = %d\n", omp_get_num_devices());
+  if (omp_get_num_devices() == 0)
+  printf("No target device; target regions run on the host\n");
+  printf("Vector length        = %ld\n", length);
+  printf("Offset               = %ld\n", offset);
+  printf("Number of iterations = %d\n", iterations);
+
+  for (j=0; j<length; j++) {
+    a[j] = 0.0;
+    b[j] = 2.0;
+    c[j] = 2.0;
+  }
+
+  to_time = wtime();
+  #pragma omp target enter data map(to: a[0:length], b[0:length], c[0:length])
+  to_time = wtime() - to_time;
+    
+  /* --- MAIN LOOP --- repeat Triad iterations times --- */
+ 
+  scalar = SCALAR;
+ 
+  for (iter=0; iter<=iterations; iter++) {
+ 
+    /* start timer after a warmup iteration; target regions without nowait
+       complete before the host continues                                 */
+    if (iter==1) nstream_time = wtime();
+ 
+    #pragma omp target teams distribute parallel for
+    for (j=0; j<length; j++) a[j] += b[j]+scalar*c[j];
+ 
+  } /* end of iterations                                              */
+
+  nstream_time = wtime() - nstream_time;
+
+  from_time = wtime();
+  #pragma omp target exit data map(from: a[0:length]) map(release: b[0:length], c[0:length])
+  from_time = wtime() - from_time;
+ 
+  /*********************************************************************
+  ** Analyze and output results.
+  *********************************************************************/
+ 
+  /* reproduce initialization and timing loop */
+  aj = 0.0;
+  bj = 2.0;
+  cj = 2.0;
+  for (iter=0; iter<=iterations; iter++) aj += bj+scalar*cj;
+  aj = aj * (double) (length);
+ 
+  asum = 0.0;
+  for (j=0; j<length; j++) asum += a[j];
+ 
+#if VERBOSE
+  printf ("Results Comparison: \n");
+  printf ("        Expected checksum: %f\n",aj);
+  printf ("        Observed checksum: %f\n",asum);
+#endif
+ 
+  if (ABS(aj-asum)/asum > epsilon) {
+    printf ("Failed Validation on output array\n");
+    exit(EXIT_FAILURE);
+  }
+  printf ("Solution validates\n");
+
+  printf("Host to device (s)   = %lf, %lf MB/s\n", to_time,
+         1.0E-06 * 3.0 * sizeof(double) * length/to_time);
+  printf("Device to host (s)   = %lf, %lf MB/s\n", from_time,
+         1.0E-06 * sizeof(double) * length/from_time);
+  bytes   = 4.0 * sizeof(double) * length;
+  avgtime = nstream_time/iterations;
+  printf("Rate (MB/s): %lf Avg time (s): %lf\n",
+         1.0E-06 * bytes/avgtime, avgtime);
+ 
+  return 0;
+}
@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    transpose
+
+PURPOSE: This program measures the time for the transpose of a 
+         column-major stored matrix into a row-major stored matrix
+         on a target device (GPU).
+  
+USAGE:   Program input is the number of times to repeat the operation
+         and the matrix order:
+
+         transpose <# iterations> <matrix order>
+
+         Both matrices are copied to the device once, with target enter
+         data, stay there for all iterations, and only the transposed
+         matrix is copied back. Each iteration is a single target teams
+         distribute parallel for loop over both matrix dimensions, and
+         only those loops are timed; the time of the transfers between
+         host and device is reported separately. Without a device the
+         target regions run on the host.
+  
+         The output consists of diagnostics to make sure the 
+         transpose worked and timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than OpenMP or standard C functions, the following 
+         functions are used in this program:
+
+         wtime()          portable wall-timer interface.
+
+HISTORY: Derived from SERIAL/Transpose, October 2026.
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_omp.h>
+
+#define A(i,j)    A[i+order*(j)]
+#define B(i,j)    B[i+order*(j)]
+
+int main(int argc, char ** argv) {
+
+  long    order;           /* order of a the matrix                           */
+  long    i, j;            /* indices                                         */
+  int     iterations;      /* number of times to do the transpose             */
+  int     iter;            /* dummy                                           */
+  size_t  bytes;           /* combined size of matrices                       */
+  double  * RESTRICT A;    /* buffer to hold original matrix                  */
+  double  * RESTRICT B;    /* buffer to hold transposed matrix                */
+  double  abserr;          /* absolute error                                  */
+  double  epsilon=1.e-8;   /* error tolerance                                 */
+  double  trans_time,      /* timing parameters                               */
+          avgtime,
+          to_time,         /* time of transfers to the device                 */
+          from_time;       /* time of transfers from the device               */
+  double  addit;           /* offset of entries of B after the iterations     */
+
+  /*********************************************************************
+  ** read and test input parameters
+  *********************************************************************/
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("OpenMP target Matrix transpose: B = A^T\n");
+
+  if (argc != 3){
+    printf("Usage: %s <# iterations> <matrix order>\n",*argv);
+    exit(EXIT_FAILURE);
+  }
+
+  iterations  = atoi(*++argv); 
+  if (iterations < 1){
+    printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  order = atol(*++argv); 
+  if (order <= 0){
+    printf("ERROR: Matrix Order must be greater than 0 : %ld \n", order);
+    exit(EXIT_FAILURE);
+  }
+
+  /*********************************************************************
+  ** Allocate space for the input and transpose matrix
+  *********************************************************************/
+
+  bytes = (size_t)order * (size_t)order * sizeof(double);
+  A   = (double *)prk_malloc(bytes);
+  B   = (double *)prk_malloc(bytes);
+  if (!A || !B) {
+    printf("ERROR: could not allocate space for the matrices\n");
+    exit(EXIT_FAILURE);
+  }
+
+  printf("Number of devices    = %d\n", omp_get_num_devices());
+  if (omp_get_num_devices() == 0)
+  printf("No target device; target regions run on the host\n");
+  printf("Matrix order         = %ld\n", order);
+  printf("Number of iterations = %d\n", iterations);
+
+  /* Fill the original matrix, set transpose to known garbage value. */
+  for (j=0;j<order;j++) for (i=0;i<order; i++) {
+    A(i,j) = (double) (order*j + i);
+    B(i,j) = 0.0;
+  }
+
+  to_time = wtime();
+  #pragma omp target enter data map(to: A[0:order*order], B[0:order*order])
+  to_time = wtime() - to_time;
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* start timer after a warmup iteration; target regions without nowait
+       complete before the host continues                                   */
+    if (iter == 1) trans_time = wtime();
+
+    #pragma omp target teams distribute parallel for collapse(2)
+    for (j=0;j<order;j++) for (i=0;i<order; i++) {
+      B(i,j) += A(j,i);
+      A(j,i) += 1.0;
+    }
+
+  }  /* end of iterations                                                     */
+
+  trans_time = wtime() - trans_time;
+
+  from_time = wtime();
+  #pragma omp target exit data map(from: B[0:order*order]) map(release: A[0:order*order])
+  from_time = wtime() - from_time;
+
+  /*********************************************************************
+  ** Analyze and output results.
+  *********************************************************************/
+
+  abserr = 0.0;
+  addit = ((double)(iterations+1) * (double) (iterations))/2.0;
+  for (j=0;j<order;j++) for (i=0;i<order; i++) {
+    abserr += ABS(B(i,j) - ((double)(order*i + j)*(iterations+1)+addit));
+  }
+
+#if VERBOSE
+  printf("Sum of absolute differences: %f\n",abserr);
+#endif
+
+  if (abserr < epsilon) {
+    printf("Solution validates\n");
+    printf("Host to device (s)   = %lf, %lf MB/s\n", to_time,
+           1.0E-06 * 2.0 * bytes/to_time);
+    printf("Device to host (s)   = %lf, %lf MB/s\n", from_time,
+           1.0E-06 * bytes/from_time);
+    avgtime = trans_time/iterations;
+    printf("Rate (MB/s): %lf Avg time (s): %lf\n",
+           1.0E-06 * (2.0 * bytes)/avgtime, avgtime);
+    exit(EXIT_SUCCESS);
+  }
+  else {
+    printf("ERROR: Aggregate squared error %e exceeds threshold %e\n",
+           abserr, epsilon);
+    exit(EXIT_FAILURE);
+  }
+
+}  /* end of main */
@@ -111,12 +111,14 @@ FUNCTIONS CALLED:
          wtime()
          fill_vec()
          func*()
+         prk_harness_*()
 
 HISTORY: Written by Rob Van der Wijngaart, February 2009.
   
 **********************************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
 
 /* the following values are only used as labels                                  */
 #define VECTOR_STOP       66
@@ -136,6 +138,7 @@ int main(int argc, char ** argv)
   int      rank;            /* matrix rank used in INS_HEAVY option              */
   double   branch_time,     /* timing parameters                                 */
            no_branch_time;
+  prk_harness_t harness;    /* timing of the run with branches                   */
   double   ops;             /* double precision representation of integer ops    */
   int      iterations;      /* number of times the branch loop is carried out    */
   int      i, iter, aux;    /* dummies                                           */
@@ -205,7 +208,10 @@ int main(int argc, char ** argv)
     index[i]   = i;
   }
 
-  branch_time = wtime();
+  prk_harness_init(&harness, "Branch", "Serial", iterations);
+  prk_harness_param(&harness, "length", "%ld", vector_length);
+  prk_harness_param(&harness, "branch_type", "%s", branch_type);
+  prk_harness_tick(&harness);
 
   /* do actual branching */
 
@@ -281,7 +287,10 @@ int main(int argc, char ** argv)
       fill_vec(vector, vector_length, iterations, WITH_BRANCHES, &nfunc, &rank);
     }
 
-    branch_time = wtime() - branch_time;
+    /* the loops run two iterations per pass, so all iterations are
+       recorded with equal length                                            */
+    prk_harness_ticks(&harness, iterations);
+    branch_time = prk_harness_elapsed(&harness);
     if (btype == INS_HEAVY) {
       printf("Number of matrix functions = %d\n", nfunc);
       printf("Matrix order               = %d\n", rank);
@@ -351,6 +360,8 @@ int main(int argc, char ** argv)
            ops/(branch_time*1.e6), branch_time);
     printf("Rate (Mops/s) without branches: %lf time (s): %lf\n", 
            ops/(no_branch_time*1.e6), no_branch_time);
+    prk_harness_report(&harness, "Mops/s", ops/iterations*1.e-6);
+    prk_harness_finalize(&harness);
 #if VERBOSE
     printf("Array sum = %d, reference value = %d\n", total, total_ref);
 #endif     
@@ -44,6 +44,14 @@ USAGE:   The program takes as input the matrix
 
          <progname> <# iterations> <matrix order> [<tile size>]
   
+         With PRK_DGEMM=packed the tiles are replaced by the packed,
+         register-blocked multiplication of prk_dgemm_simd.h: blocks of
+         A and B are copied into contiguous micro-panels that a
+         vectorized micro-kernel (AVX-512 or AVX2 with FMA, selected
+         from the CPU and PRK_SIMD) multiplies in registers, with cache
+         blocking set by PRK_DGEMM_BLOCKING=mc,kc,nc.  The tile size is
+         then ignored.  The default is PRK_DGEMM=tiled.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
@@ -53,12 +61,16 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_harness_*()
+         prk_dgemm_*()    packed multiplication
 
 HISTORY: Written by Rob Van der Wijngaart, February 2009.
   
 ***********************************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
+#include <prk_dgemm_simd.h>
 
 #if MKL
   #include <mkl_cblas.h>
@@ -77,6 +89,7 @@ int main(int argc, char **argv)
 {
   int     iter, i,ii,j,jj,k,kk,ig,jg,kg; /* dummies                               */
   int     iterations;           /* number of times the multiplication is done     */
+  prk_harness_t harness;        /* per-iteration timing                           */
   double  dgemm_time,           /* timing parameters                              */
           avgtime; 
   double  checksum = 0.0,       /* checksum of result                             */
@@ -87,6 +100,11 @@ int main(int argc, char **argv)
   long    order;                /* number of rows and columns of matrices         */
   long    block;                /* tile size of matrices                          */
   int     shortcut;             /* true if only doing initialization              */
+  int     packed = 0;           /* true if using the packed micro-kernel          */
+  const prk_dgemm_kernel_t *kernel = NULL; /* packed micro-kernel                 */
+  int     blocking[3];          /* MC, KC and NC of the packed multiplication     */
+  double  *work = NULL;         /* packing buffers of the micro-kernel            */
+  char    *env;                 /* value of PRK_DGEMM                             */
 
   printf("Parallel Research Kernels version %s\n", PRKVERSION);
   printf("Serial Dense matrix-matrix multiplication: C = A x B\n");
@@ -111,7 +129,7 @@ int main(int argc, char **argv)
   if (order < 0) {
     shortcut = 1;
     order    = -order;
-  }
+  } else shortcut = 0;
   if (order < 1) {
     printf("ERROR: Matrix order must be positive: %ld\n", order);
     exit(EXIT_FAILURE);
@@ -121,16 +139,36 @@ int main(int argc, char **argv)
   if (argc == 4) {
          block = atoi(*++argv);
   } else block = DEFAULTBLOCK;
+
+  env = getenv("PRK_DGEMM");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"packed")) packed = 1;
+    else if (strcmp(env,"tiled")) {
+      printf("ERROR: PRK_DGEMM must be tiled or packed: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (packed) {
+    kernel = prk_dgemm_simd();
+    prk_dgemm_blocking(kernel, blocking);
+  }
 #endif
 
   printf("Matrix order          = %ld\n", order);
   if (shortcut) 
     printf("Only doing initialization\n"); 
-  if (block>0)
-    printf("Blocking factor       = %ld\n", block);
-  else
-    printf("No blocking\n");
-  printf("Block offset          = %d\n", BOFFSET);
+  if (packed) {
+    printf("Packed micro-kernel   = %s, %d x %d\n", kernel->isa, kernel->mr, kernel->nr);
+    printf("Cache blocking        = MC %d, KC %d, NC %d\n",
+           blocking[0], blocking[1], blocking[2]);
+  }
+  else {
+    if (block>0)
+      printf("Blocking factor       = %ld\n", block);
+    else
+      printf("No blocking\n");
+    printf("Block offset          = %d\n", BOFFSET);
+  }
   printf("Number of iterations  = %d\n", iterations);
   printf("Using MKL library     = off\n");
 
@@ -147,10 +185,21 @@ int main(int argc, char **argv)
     C_arr(i,j) = 0.0;
   }
 
+  prk_harness_init(&harness, "DGEMM", "Serial", iterations);
+  prk_harness_param(&harness, "order", "%ld", order);
+
 #if !MKL
   double RESTRICT *AA, *BB, *CC;
 
-  if (block > 0) {
+  if (packed) {
+    /* packing buffers for micro-panels of A and B                                  */
+    work = (double *) prk_malloc(prk_dgemm_workspace(kernel, blocking)*sizeof(double));
+    if (!work) {
+      printf("Could not allocate space for packing buffers\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  else if (block > 0) {
     /* matrix blocks for local temporary copies                                     */
     AA = (double *) prk_malloc(block*(block+BOFFSET)*3*sizeof(double));
     if (!AA) {
@@ -163,12 +212,25 @@ int main(int argc, char **argv)
 
   if (shortcut) exit(EXIT_SUCCESS);
 
-  for (iter=0; iter<iterations; iter++) {
+  prk_harness_param(&harness, "block", "%ld", block);
+  prk_harness_param(&harness, "algorithm", "%s", packed ? "packed" : "tiled");
+  if (packed) {
+    prk_harness_param(&harness, "simd", "%s", kernel->isa);
+    prk_harness_param(&harness, "mc", "%d", blocking[0]);
+    prk_harness_param(&harness, "kc", "%d", blocking[1]);
+    prk_harness_param(&harness, "nc", "%d", blocking[2]);
+  }
+
+  for (iter=0; iter<=iterations; iter++) {
 
-    /* start timer after a warmup iteration */
-    if (iter == 1)  dgemm_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter >= 1)  prk_harness_tick(&harness);
 
-    if (block > 0) {
+    if (packed) {
+      prk_dgemm_packed(kernel, blocking, order, order, order,
+                       A, order, B, order, C, order, work);
+    }
+    else if (block > 0) {
 
       for(jj = 0; jj < order; jj+=block){
         for(kk = 0; kk < order; kk+=block) {
@@ -215,8 +277,8 @@ int main(int argc, char **argv)
 
   for (iter=0; iter<=iterations; iter++) {
 
-    /* start timer after a warmup iteration */
-    if (iter == 1)  dgemm_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter >= 1)  prk_harness_tick(&harness);
 
     cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, order, order, 
                 order, 1.0, &(A_arr(0,0)), order, &(B_arr(0,0)), order, 
@@ -224,14 +286,15 @@ int main(int argc, char **argv)
   } /* end of iterations                                                          */
 #endif
 
-  dgemm_time = wtime() - dgemm_time;
+  prk_harness_tick(&harness);
+  dgemm_time = prk_harness_elapsed(&harness);
 
   for(checksum=0.0,j = 0; j < order; j++) for(i = 0; i < order; i++)
     checksum += C_arr(i,j);
 
   /* verification test                                                            */
   ref_checksum = (0.25*forder*forder*forder*(forder-1.0)*(forder-1.0));
-  ref_checksum *= iterations;
+  ref_checksum *= (iterations+1);
 
   if (ABS((checksum - ref_checksum)/ref_checksum) > epsilon) {
     printf("ERROR: Checksum = %lf, Reference checksum = %lf\n",
@@ -250,6 +313,10 @@ int main(int argc, char **argv)
   avgtime = dgemm_time/iterations;
   printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
          1.0E-06 *nflops/avgtime, avgtime);
+  /* compulsory traffic: A and B read, C read and written once */
+  prk_harness_model(&harness, nflops, 4.0*sizeof(double)*forder*forder);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 *nflops);
+  prk_harness_finalize(&harness);
 
   exit(EXIT_SUCCESS);
 
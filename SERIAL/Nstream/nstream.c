@@ -100,6 +100,7 @@ FUNCTIONS CALLED:
  
            wtime()
            checkTRIADresults()
+           prk_harness_*()
  
 NOTES:     Bandwidth is determined as the number of words read, plus the 
            number of words written, times the size of the words, divided 
@@ -113,6 +114,7 @@ HISTORY:   This code is loosely based on the Stream benchmark by John
 **********************************************************************/
  
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
  
 #define N   MAXLENGTH
  
@@ -141,6 +143,7 @@ int main(int argc, char **argv)
   size_t   space;         /* memory used for a single vector             */
   double   nstream_time,  /* timing parameters                           */
            avgtime;
+  prk_harness_t harness;  /* per-iteration timing                        */
  
 /**********************************************************************************
 * process and test input parameters    
@@ -210,12 +213,14 @@ int main(int argc, char **argv)
  
   scalar = SCALAR;
  
-  nstream_time = 0.0; /* silence compiler warning */
+  prk_harness_init(&harness, "Nstream", "Serial", iterations);
+  prk_harness_param(&harness, "length", "%ld", length);
+  prk_harness_param(&harness, "offset", "%ld", offset);
 
   for (iter=0; iter<=iterations; iter++) {
  
-    /* start timer after a warmup iteration */
-    if (iter == 1) nstream_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter >= 1) prk_harness_tick(&harness);
  
 #ifdef __INTEL_COMPILER
     #pragma vector always
@@ -228,13 +233,16 @@ int main(int argc, char **argv)
   ** Analyze and output results.
   *********************************************************************/
  
-  nstream_time = wtime() - nstream_time;
+  prk_harness_tick(&harness);
+  nstream_time = prk_harness_elapsed(&harness);
   
   bytes   = 4.0 * sizeof(double) * length;
   if (checkTRIADresults(iterations, length)) {
     avgtime = nstream_time/(double)iterations;
     printf("Rate (MB/s): %lf Avg time (s): %lf\n",
            1.0E-06 * bytes/avgtime, avgtime);
+    prk_harness_report(&harness, "MB/s", 1.0E-06 * bytes);
+    prk_harness_finalize(&harness);
    }
   else exit(EXIT_FAILURE);
  
@@ -54,6 +54,7 @@ FUNCTIONS CALLED:
          wtime()
          bad_patch()
          random_draw()
+         prk_harness_*()
 
 HISTORY: - Written by Evangelos Georganas, August 2015.
          - RvdW: Refactored to make the code PRK conforming, December 2015
@@ -61,6 +62,7 @@ HISTORY: - Written by Evangelos Georganas, August 2015.
 **********************************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
 #include <random_draw.h>
 
 #include <math.h>
@@ -466,6 +468,7 @@ int main(int argc, char ** argv) {
   double      fx, fy, ax, ay;    // forces and accelerations
   int         error=0;           // used for graceful exit after error
   double      avg_time, pic_time;// timing parameters
+  prk_harness_t harness;         // per-time-step timing
 
   printf("Parallel Research Kernels Version %s\n", PRKVERSION);
   printf("Serial Particle-in-Cell execution on 2D grid\n");
@@ -591,10 +594,15 @@ int main(int argc, char ** argv) {
 
   printf("Number of particles placed     = %lld\n", n);
 
+  prk_harness_init(&harness, "PIC", "Serial", (int) iterations);
+  prk_harness_param(&harness, "grid_size", "%llu", (unsigned long long) L);
+  prk_harness_param(&harness, "particles", "%llu", (unsigned long long) n);
+  prk_harness_param(&harness, "init_mode", "%s", init_mode);
+
   for (iter=0; iter<=iterations; iter++) {
     
-    /* start the timer after one warm-up time step */
-    if (iter==1) pic_time = wtime();  
+    /* time every time step after one warm-up time step */
+    if (iter>=1) prk_harness_tick(&harness);
  
     /* Calculate forces on particles and update positions */
     for (i=0; i<n; i++) {
@@ -615,7 +623,8 @@ int main(int argc, char ** argv) {
     }
   }
    
-  pic_time = wtime() - pic_time;
+  prk_harness_tick(&harness);
+  pic_time = prk_harness_elapsed(&harness);
    
   /* Run the verification test */
   for (i=0; i<n; i++) {
@@ -629,6 +638,8 @@ int main(int argc, char ** argv) {
 #endif
     avg_time = n*iterations/pic_time;
     printf("Rate (Mparticles_moved/s): %lf\n", 1.0e-6*avg_time);
+    prk_harness_report(&harness, "Mparticles_moved/s", 1.0e-6*n);
+    prk_harness_finalize(&harness);
   } else {
     printf("Solution does not validate\n");
   }
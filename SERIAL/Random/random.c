@@ -87,6 +87,7 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_harness_*()
          PRK_starts()
          poweroftwo()
 
@@ -129,12 +130,21 @@ NOTES:   This program is derived from HPC Challenge Random Access. The random
             non-commutative, the vector and scalar version would have yielded 
             different results.
 
+         With PRK_RANDOM=batched the streams are advanced together, a
+         batch of LOOKAHEAD updates at a time, and each batch is applied
+         by an update kernel of prk_random_simd.h, which prefetches the
+         table entry PRK_PREFETCH updates ahead (default 16, 0 disables
+         it) and, on CPUs with AVX-512, applies eight updates at a time
+         with gather and scatter.  The default is PRK_RANDOM=plain.
+
 HISTORY: Written by Rob Van der Wijngaart, February 2009.
          Histogram code (verbose mode) courtesy Roger Golliver
   
 ************************************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
+#include <prk_random_simd.h>
 
 /* Define constants                                                                */
 /* PERIOD = (2^63-1)/7 = 7*73*127*337*92737*649657                                 */
@@ -155,6 +165,11 @@ HISTORY: Written by Rob Van der Wijngaart, February 2009.
   #define ERRORPERCENT 1
 #endif
 
+/* number of updates generated before they are applied in batched mode          */
+#ifndef LOOKAHEAD
+  #define LOOKAHEAD 1024
+#endif
+
 static u64Int PRK_starts(s64Int);
 static int    poweroftwo(int);
 
@@ -175,9 +190,16 @@ int main(int argc, char **argv) {
 #endif
   u64Int * RESTRICT Table;       /* (pseudo-)randomly accessed array               */
   double            random_time;
+  prk_harness_t     harness;     /* timing of the update phase                     */
   int               log2nstarts; /* log2 of vector length                          */
   int               log2tablesize; /* log2 of aggregate table size                 */
   int               log2update_ratio; /* log2 of update ratio                      */
+  int               batched = 0; /* true if updates are applied in batches        */
+  int               distance = 16; /* prefetch distance of batched updates        */
+  prk_random_update_t update = NULL; /* kernel applying a batch of updates        */
+  u64Int            *batch = NULL; /* batch of updates                            */
+  s64Int            k, steps, nbatch; /* updates per stream per batch, and in it  */
+  char              *env;        /* value of PRK_RANDOM and PRK_PREFETCH           */
 
 #if LONG_IS_64BITS
   if (sizeof(long) != 8) {
@@ -276,6 +298,35 @@ int main(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
+  env = getenv("PRK_RANDOM");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"batched")) batched = 1;
+    else if (strcmp(env,"plain")) {
+      printf("ERROR: PRK_RANDOM must be plain or batched: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  env = getenv("PRK_PREFETCH");
+  if (env != NULL) distance = atoi(env);
+  if (distance < 0) {
+    printf("ERROR: PRK_PREFETCH must be non-negative: %s\n", env);
+    exit(EXIT_FAILURE);
+  }
+#if VERBOSE
+  if (batched) {
+    printf("ERROR: batched updates do not keep a histogram; use VERBOSE=0\n");
+    exit(EXIT_FAILURE);
+  }
+#endif
+  if (batched) {
+    update = prk_random_simd();
+    batch  = (u64Int *) prk_malloc(LOOKAHEAD*sizeof(u64Int));
+    if (!batch) {
+      printf("ERROR: Could not allocate space for batch of updates\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
   error = 0;
 
   printf("Table size (shared)    = "FSTR64U"\n", tablesize);
@@ -283,6 +334,14 @@ int main(int argc, char **argv) {
   printf("Number of updates      = "FSTR64U"\n", nupdate);
   printf("Vector length          = "FSTR64U"\n", (u64Int) nstarts);
   printf("Percent errors allowed = "FSTR64U"\n", (u64Int) ERRORPERCENT);
+  if (batched) {
+    printf("Update mode            = batched\n");
+    printf("Lookahead              = "FSTR64U"\n", (u64Int) LOOKAHEAD);
+    printf("Prefetch distance      = "FSTR64U"\n", (u64Int) distance);
+    printf("Update kernel          = %s\n", prk_random_simd_isa());
+  }
+  else 
+    printf("Update mode            = plain\n");
 
   ran = (u64Int *) prk_malloc(nstarts*sizeof(u64Int));
   if (!ran) {
@@ -294,7 +353,14 @@ int main(int argc, char **argv) {
   /* initialize the table */
   for(i=0;i<tablesize;i++) Table[i] = (u64Int) i;
 
-  random_time = wtime();
+  /* the two update rounds are timed as a single iteration                  */
+  prk_harness_init(&harness, "Random", "Serial", 1);
+  prk_harness_param(&harness, "tablesize", "%lld", (long long) tablesize);
+  prk_harness_param(&harness, "update_ratio", "%d", update_ratio);
+  prk_harness_param(&harness, "vector_length", "%d", nstarts);
+  prk_harness_param(&harness, "update", "%s", batched ? prk_random_simd_isa() : "plain");
+  if (batched) prk_harness_param(&harness, "prefetch", "%d", distance);
+  prk_harness_tick(&harness);
 
   /* do two identical rounds of Random Access to make sure we recover 
      the initial condition                                                 */
@@ -303,7 +369,19 @@ int main(int argc, char **argv) {
     for (j=0; j<nstarts; j++) {
       ran[j] = PRK_starts(SEQSEED+(nupdate/nstarts)*j);
     }
-    for (j=0; j<nstarts; j++) {
+    /* advance all streams by steps values per batch                       */
+    if (batched) {
+      steps = MAX(1, LOOKAHEAD/nstarts);
+      for (i=0; i<nupdate/(nstarts*2); i+=steps) {
+        nbatch = 0;
+        for (k=i; k<MIN(i+steps,nupdate/(nstarts*2)); k++) for (j=0; j<nstarts; j++) {
+          ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
+          batch[nbatch++] = ran[j];
+        }
+        update(Table, tablesize, batch, nbatch, distance);
+      }
+    }
+    else for (j=0; j<nstarts; j++) {
       /* because we do two rounds, we divide nupdates in two               */
       for (i=0; i<nupdate/(nstarts*2); i++) {
         ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
@@ -316,7 +394,8 @@ int main(int argc, char **argv) {
     }
   }
 
-  random_time = wtime() - random_time;
+  prk_harness_tick(&harness);
+  random_time = prk_harness_elapsed(&harness);
 
   /* verification test */
   for(i=0;i<tablesize;i++) {
@@ -337,6 +416,8 @@ int main(int argc, char **argv) {
     printf("Solution validates, number of errors: %ld\n",(long) error);
     printf("Rate (GUPs/s): %lf time (s) = %lf\n", 
            1.e-9*nupdate/random_time,random_time);
+    prk_harness_report(&harness, "GUPs/s", 1.e-9*nupdate);
+    prk_harness_finalize(&harness);
   }
 
 #if VERBOSE
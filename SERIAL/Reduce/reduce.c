@@ -51,18 +51,21 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_harness_*()
 
 HISTORY: Written by Rob Van der Wijngaart, February 2009.
   
 *******************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
 
 int main(int argc, char ** argv)
 {
   long   vector_length;    /* length of vectors to be aggregated             */
   double reduce_time,      /* timing parameters                              */
          avgtime;
+  prk_harness_t harness;   /* per-iteration timing                           */
   double epsilon=1.e-8;    /* error tolerance                                */
   int    i, iter;          /* dummies                                        */
   double element_value;    /* reference element value for final vector       */
@@ -112,14 +115,13 @@ int main(int argc, char ** argv)
     ones[i]    = (double)1;
   }
 
-  reduce_time = 0.0; /* silence compiler warning */
+  prk_harness_init(&harness, "Reduce", "Serial", iterations);
+  prk_harness_param(&harness, "length", "%ld", vector_length);
 
   for (iter=0; iter<=iterations; iter++) {
 
-    /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      reduce_time = wtime();
-    }
+    /* time every iteration after a warmup iteration */
+    if (iter >= 1) prk_harness_tick(&harness);
 
     /* do the reduction                                                      */
     for (i=0; i<vector_length; i++) {
@@ -128,7 +130,8 @@ int main(int argc, char ** argv)
 
   } /* end of iter loop                                                      */
 
-    reduce_time = wtime() - reduce_time;
+  prk_harness_tick(&harness);
+  reduce_time = prk_harness_elapsed(&harness);
 
   /* verify correctness */
   element_value = (double)(iterations + 2.0);
@@ -148,6 +151,8 @@ int main(int argc, char ** argv)
   avgtime = reduce_time/(double)iterations;
   printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
          1.0E-06 * (2.0-1.0)*vector_length/avgtime, avgtime);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0-1.0)*vector_length);
+  prk_harness_finalize(&harness);
 
   exit(EXIT_SUCCESS);
 }
@@ -53,6 +53,7 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_harness_*()
          reverse()
          qsort()
          compare
@@ -67,6 +68,7 @@ HISTORY: Written by Rob Van der Wijngaart, August 2009.
 ***********************************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
 
 /* linearize the grid index                                                       */
 #define LIN(i,j) (i+((j)<<lsize))
@@ -101,6 +103,7 @@ int main(int argc, char **argv){
   double            sparsity;   /* fraction of non-zeroes in matrix               */
   double            sparse_time,/* timing parameters                              */
                     avgtime; 
+  prk_harness_t     harness;    /* per-iteration timing                           */
   double * RESTRICT matrix;     /* sparse matrix entries                          */
   double * RESTRICT vector;     /* vector multiplying the sparse matrix           */
   double * RESTRICT result;     /* computed matrix-vector product                 */
@@ -224,11 +227,14 @@ int main(int argc, char **argv){
       matrix[elm] = 1.0/(double)(colIndex[elm]+1);
   }
 
-  sparse_time = 0.0; /* silence compiler warning */
+  prk_harness_init(&harness, "Sparse", "Serial", iterations);
+  prk_harness_param(&harness, "log2_grid_size", "%lld", (long long) lsize);
+  prk_harness_param(&harness, "radius", "%lld", (long long) radius);
 
   for (iter=0; iter<=iterations; iter++) {
 
-    if (iter==1) sparse_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter>=1) prk_harness_tick(&harness);
 
     /* fill vector                                                                */
     for (row=0; row<size2; row++) vector[row] += (double) (row+1);
@@ -246,7 +252,8 @@ int main(int argc, char **argv){
     }
   } /* end of iterations                                                          */
 
-  sparse_time = wtime()-sparse_time;
+  prk_harness_tick(&harness);
+  sparse_time = prk_harness_elapsed(&harness);
 
   /* verification test                                                            */
   reference_sum = 0.5 * (double) nent * (double) (iterations+1) * 
@@ -270,6 +277,8 @@ int main(int argc, char **argv){
   avgtime = sparse_time/iterations;
   printf("Rate (MFlops/s): %lf  Avg time (s): %lf\n",
          1.0E-06 * (2.0*nent)/avgtime, avgtime);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * (2.0*nent));
+  prk_harness_finalize(&harness);
 
   exit(EXIT_SUCCESS);
 }
@@ -46,11 +46,24 @@ USAGE:   The program takes as input the linear
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         Untiled runs use the hand-vectorized row kernels of
+         prk_stencil_simd.h if the CPU supports one of their instruction
+         sets, unless PRK_SIMD=scalar is set or LOOPGEN expands the loop
+         body.
+
+         With PRK_INCREMENT=offset the constant that every iteration adds
+         to IN is kept as an implicit offset of the grid instead of being
+         added by a pass over the grid.  The weights sum to zero, so the
+         stencil of IN plus a constant equals that of IN and the norm is
+         unchanged.  PRK_INCREMENT=sweep (the default) adds it explicitly.
+
 FUNCTIONS CALLED:
 
          Other than standard C functions, the following functions are used in 
          this program:
          wtime()
+         prk_harness_*()
+         prk_stencil_simd_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, February 2009.
          - RvdW: Removed unrolling pragmas for clarity;
@@ -60,6 +73,8 @@ HISTORY: - Written by Rob Van der Wijngaart, February 2009.
 **********************************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
+#include <prk_stencil_simd.h>
 
 #if DOUBLE
   #define DTYPE   double
@@ -80,6 +95,14 @@ HISTORY: - Written by Rob Van der Wijngaart, February 2009.
 #define OUT(i,j)      out[i+(j)*(n)]
 #define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
 
+#if DOUBLE
+  typedef prk_stencil_row_double_t stencil_row_t;
+  #define prk_stencil_simd prk_stencil_simd_double
+#else
+  typedef prk_stencil_row_float_t  stencil_row_t;
+  #define prk_stencil_simd prk_stencil_simd_float
+#endif
+
 int main(int argc, char ** argv) {
 
   long   n;               /* linear grid dimension                               */
@@ -91,6 +114,7 @@ int main(int argc, char ** argv) {
   DTYPE  f_active_points; /* interior of grid with respect to stencil            */
   DTYPE  flops;           /* floating point ops per iteration                    */
   int    iterations;      /* number of times to run the algorithm                */
+  prk_harness_t harness;  /* per-iteration timing                                */
   double stencil_time,    /* timing parameters                                   */
          avgtime;
   int    stencil_size;    /* number of points in stencil                         */
@@ -98,6 +122,11 @@ int main(int argc, char ** argv) {
   DTYPE  * RESTRICT out;  /* output grid values                                  */
   long   total_length;    /* total required length to store grid values          */
   DTYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
+  stencil_row_t row = NULL; /* vectorized row kernel, if any                     */
+  const char *simd = "scalar"; /* instruction set of the untiled kernel          */
+  char   *env;            /* value of PRK_INCREMENT                              */
+  int    offset = 0;      /* nonzero if the increment of IN is implicit          */
+  DTYPE  wsum;            /* sum of the stencil weights                          */
 
   printf("Parallel Research Kernels Version %s\n", PRKVERSION);
   printf("Serial stencil execution on 2D grid\n");
@@ -181,6 +210,30 @@ int main(int argc, char ** argv) {
   }
 #endif
 
+  /* IN+c feeds the stencil c*wsum more than IN does, so with weights that
+     sum to zero the increment can be left to an implicit offset            */
+  env = getenv("PRK_INCREMENT");
+  if (env != NULL && *env != '\0' && strcmp(env, "sweep")) {
+    if (strcmp(env, "offset")) {
+      printf("ERROR: PRK_INCREMENT=%s should be sweep or offset\n", env);
+      exit(EXIT_FAILURE);
+    }
+    wsum = (DTYPE) 0.0;
+    for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
+      wsum += WEIGHT(ii,jj);
+    if (ABS(wsum) > EPSILON) {
+      printf("ERROR: PRK_INCREMENT=offset needs weights that sum to zero, not "
+             FSTR"\n", wsum);
+      exit(EXIT_FAILURE);
+    }
+    offset = 1;
+  }
+
+  if (!tiling && !LOOPGEN) {
+    row = prk_stencil_simd(STAR);
+    if (row) simd = prk_stencil_simd_isa();
+  }
+
   norm = (DTYPE) 0.0;
   f_active_points = (DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS);
 
@@ -203,6 +256,8 @@ int main(int argc, char ** argv) {
 #endif
   if (tiling) printf("Tile size            = %d\n", tile_size);
   else        printf("Untiled\n");
+  printf("SIMD micro-kernel    = %s\n", simd);
+  printf("Increment of input   = %s\n", offset ? "implicit offset" : "sweep");
   printf("Number of iterations = %d\n", iterations);
 
   /* intialize the input and output arrays                                     */
@@ -211,16 +266,24 @@ int main(int argc, char ** argv) {
   for (j=RADIUS; j<n-RADIUS; j++) for (i=RADIUS; i<n-RADIUS; i++) 
     OUT(i,j) = (DTYPE)0.0;
 
-  stencil_time = 0.0; /* silence compiler warning */
+  prk_harness_init(&harness, "Stencil", "Serial", iterations);
+  prk_harness_param(&harness, "grid_size", "%ld", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? tile_size : 0);
+  prk_harness_param(&harness, "simd", "%s", simd);
+  prk_harness_param(&harness, "increment", "%s", offset ? "offset" : "sweep");
 
   for (iter = 0; iter<=iterations; iter++){
 
-    /* start timer after a warmup iteration */
-    if (iter == 1)  stencil_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter >= 1)  prk_harness_tick(&harness);
 
     /* Apply the stencil operator                                              */
 
-    if (!tiling) {
+    if (row) {
+      for (j=RADIUS; j<n-RADIUS; j++) row(n, j, RADIUS, &WEIGHT(-RADIUS,-RADIUS), in, out);
+    }
+    else if (!tiling) {
       for (j=RADIUS; j<n-RADIUS; j++) {
         for (i=RADIUS; i<n-RADIUS; i++) {
           #if STAR
@@ -272,11 +335,12 @@ int main(int argc, char ** argv) {
     }
 
     /* add constant to solution to force refresh of neighbor data, if any       */
-    for (j=0; j<n; j++) for (i=0; i<n; i++) IN(i,j)+= 1.0;
+    if (!offset) for (j=0; j<n; j++) for (i=0; i<n; i++) IN(i,j)+= 1.0;
 
   } /* end of iterations                                                        */
 
-  stencil_time = wtime() - stencil_time;
+  prk_harness_tick(&harness);
+  stencil_time = prk_harness_elapsed(&harness);
 
   /* compute L1 norm in parallel                                                */
   for (j=RADIUS; j<n-RADIUS; j++) for (i=RADIUS; i<n-RADIUS; i++) {
@@ -308,6 +372,10 @@ int main(int argc, char ** argv) {
   avgtime = stencil_time/iterations;
   printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
          1.0E-06 * flops/avgtime, avgtime);
+  /* reads of IN and read-modify-writes of OUT and of all of IN */
+  prk_harness_model(&harness, flops, sizeof(DTYPE)*(3.0*n*n+2.0*f_active_points));
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
 
   exit(EXIT_SUCCESS);
 }
@@ -53,11 +53,13 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()
+         prk_harness_*()
 
 HISTORY: - Written by Rob Van der Wijngaart, February 2009.
 *******************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
 
 /* define shorthand for indexing a multi-dimensional array                       */
 #define ARRAY(i,j) vector[i+(j)*(m)]
@@ -69,6 +71,7 @@ int main(int argc, char ** argv) {
   int    iterations;      /* number of times to run the pipeline algorithm       */
   double pipeline_time,   /* timing parameters                                   */
          avgtime; 
+  prk_harness_t harness;  /* per-iteration timing                                */
   double epsilon = 1.e-8; /* error tolerance                                     */
   double corner_val;      /* verification value at top right corner of grid      */
   double *RESTRICT vector;/* array holding grid values                           */
@@ -117,12 +120,14 @@ int main(int argc, char ** argv) {
   for (j=0; j<n; j++) ARRAY(0,j) = (double) j;
   for (i=0; i<m; i++) ARRAY(i,0) = (double) i;
 
-  pipeline_time = 0.0; /* silence compiler warning */
+  prk_harness_init(&harness, "Synch_p2p", "Serial", iterations);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
 
   for (iter = 0; iter<=iterations; iter++){
 
-    /* start timer after a warmup iteration */
-    if (iter == 1) pipeline_time = wtime();
+    /* time every iteration after a warmup iteration */
+    if (iter >= 1) prk_harness_tick(&harness);
 
     for (j=1; j<n; j++) for (i=1; i<m; i++) {
         ARRAY(i,j) = ARRAY(i-1,j) + ARRAY(i,j-1) - ARRAY(i-1,j-1);
@@ -134,7 +139,8 @@ int main(int argc, char ** argv) {
     ARRAY(0,0) = -ARRAY(m-1,n-1);
   }
 
-  pipeline_time = wtime() - pipeline_time;
+  prk_harness_tick(&harness);
+  pipeline_time = prk_harness_elapsed(&harness);
 
   /*******************************************************************************
   ** Analyze and output results.
@@ -156,6 +162,8 @@ int main(int argc, char ** argv) {
   avgtime = pipeline_time/iterations;
   printf("Rate (MFlops/s): %lf Avg time (s): %lf\n",
          1.0E-06 * 2 * ((double)((m-1)*(n-1)))/avgtime, avgtime);
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * ((double)((m-1)*(n-1))));
+  prk_harness_finalize(&harness);
 
   exit(EXIT_SUCCESS);
 }
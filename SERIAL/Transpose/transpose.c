@@ -44,6 +44,18 @@ USAGE:   Program input is the matrix order and the number of times to
 
          An optional parameter specifies the tile size used to divide the
          individual matrix blocks for improved cache and TLB performance. 
+
+         With PRK_TRANSPOSE=recursive the matrix is instead transposed
+         cache-obliviously: the longer side of the matrix is halved
+         recursively until blocks of at most RECURSION_LEAF x
+         RECURSION_LEAF elements are left, so that some level of the
+         recursion fits each level of the memory hierarchy without a
+         tuned tile size.  The default is PRK_TRANSPOSE=tiled.
+
+         With PRK_TRANSPOSE=inplace no second matrix is allocated: every
+         iteration replaces A by A^T + 1 by swapping symmetric pairs of
+         tiles, so that matrices of an order sqrt(2) larger fit in the
+         same memory.
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -55,15 +67,80 @@ FUNCTIONS CALLED:
          functions are used in this program:
 
          wtime()          portable wall-timer interface.
+         prk_harness_*()  per-iteration timing and results record.
+         transpose_block() recursive, cache-oblivious transpose
+         transpose_inplace() in-place transpose
 
 HISTORY: Written by  Rob Van der Wijngaart, February 2009.
+         Added the recursive, cache-oblivious transpose.
+         Added the in-place transpose.
 *******************************************************************/
 
 #include <par-res-kern_general.h>
+#include <prk_harness.h>
 
 #define A(i,j)        A_p[(i)+order*(j)]
 #define B(i,j)        B_p[(i)+order*(j)]
 
+/* largest block of the recursive transpose that is not split further    */
+#ifndef RECURSION_LEAF
+  #define RECURSION_LEAF 16
+#endif
+
+/* function that transposes the block i0..i1-1 x j0..j1-1 of A into B
+   (B += A^T, A += 1), halving its longer side until it is at most
+   RECURSION_LEAF square                                                 */
+
+static void transpose_block(long order, long i0, long i1, long j0, long j1,
+                            double * RESTRICT A_p, double * RESTRICT B_p) {
+
+  long i, j, mid;
+
+  if (i1-i0 <= RECURSION_LEAF && j1-j0 <= RECURSION_LEAF) {
+    for (i=i0; i<i1; i++) 
+      for (j=j0; j<j1; j++) {
+        B(j,i) += A(i,j);
+        A(i,j) += 1.0;
+      }
+  }
+  else if (i1-i0 >= j1-j0) {
+    mid = i0 + (i1-i0)/2;
+    transpose_block(order, i0, mid, j0, j1, A_p, B_p);
+    transpose_block(order, mid, i1, j0, j1, A_p, B_p);
+  }
+  else {
+    mid = j0 + (j1-j0)/2;
+    transpose_block(order, i0, i1, j0, mid, A_p, B_p);
+    transpose_block(order, i0, i1, mid, j1, A_p, B_p);
+  }
+}
+
+/* function that replaces A by A^T + 1, swapping each tile on or above
+   the diagonal with its mirror image; a tile size of order or more
+   means no tiling                                                       */
+
+static void transpose_inplace(long order, long tile_size, double * RESTRICT A_p) {
+
+  long   i, j, it, jt;
+  double t;
+
+  for (i=0; i<order; i+=tile_size) 
+    for (j=i; j<order; j+=tile_size) 
+      for (it=i; it<MIN(order,i+tile_size); it++) {
+        /* a diagonal tile is its own mirror image */
+        jt = j;
+        if (i == j) {
+          A(it,it) += 1.0;
+          jt = it+1;
+        }
+        for (; jt<MIN(order,j+tile_size); jt++) {
+          t        = A(it,jt);
+          A(it,jt) = A(jt,it) + 1.0;
+          A(jt,it) = t + 1.0;
+        }
+      }
+}
+
 /* Never used...
  * static double test_results (int , double*); */
 
@@ -72,6 +149,7 @@ int main(int argc, char ** argv) {
   long   order;         /* order of a the matrix                           */
   long   tile_size=32;  /* default tile size for tiling of local transpose */
   int    iterations;    /* number of times to do the transpose             */
+  prk_harness_t harness;/* per-iteration timing                            */
   int    i, j, it, jt, iter;  /* dummies                                   */
   double bytes;         /* combined size of matrices                       */
   double * RESTRICT A_p;/* buffer to hold original matrix                  */
@@ -80,6 +158,9 @@ int main(int argc, char ** argv) {
   double epsilon=1.e-8; /* error tolerance                                 */
   double trans_time,    /* timing parameters                               */
          avgtime; 
+  int    recursive=0;   /* boolean: true if transposing cache-obliviously  */
+  int    inplace=0;     /* boolean: true if transposing A into itself      */
+  char   *env;          /* value of PRK_TRANSPOSE                          */
 
   /*********************************************************************
   ** read and test input parameters
@@ -110,6 +191,18 @@ int main(int argc, char ** argv) {
   /* a non-positive tile size means no tiling of the local transpose */
   if (tile_size <=0) tile_size = order;
 
+  env = getenv("PRK_TRANSPOSE");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"recursive")) recursive = 1;
+    else if (!strcmp(env,"inplace"))   inplace   = 1;
+    else if (strcmp(env,"tiled")) {
+      printf("ERROR: PRK_TRANSPOSE must be tiled, recursive or inplace: %s\n", env);
+      exit(EXIT_FAILURE);
+    }
+  }
+  /* the recursive transpose needs no tile size                          */
+  if (recursive) tile_size = order;
+
   /*********************************************************************
   ** Allocate space for the input and transpose matrix
   *********************************************************************/
@@ -119,8 +212,9 @@ int main(int argc, char ** argv) {
     printf(" Error allocating space for input matrix\n");
     exit(EXIT_FAILURE);
   }
-  B_p  = (double *)prk_malloc(order*order*sizeof(double));
-  if (B_p == NULL){
+  /* the in-place transpose needs no output matrix                      */
+  B_p  = inplace ? NULL : (double *)prk_malloc(order*order*sizeof(double));
+  if (B_p == NULL && !inplace){
     printf(" Error allocating space for transposed matrix\n");
     exit(EXIT_FAILURE);
   }
@@ -128,8 +222,15 @@ int main(int argc, char ** argv) {
   bytes = 2.0 * sizeof(double) * order * order;
 
   printf("Matrix order          = %ld\n", order);
-  if (tile_size < order) printf("Tile size             = %ld\n", tile_size);
-  else                   printf("Untiled\n");
+  if (recursive)
+    printf("Recursive transpose   = leaf blocks of %d x %d\n",
+           RECURSION_LEAF, RECURSION_LEAF);
+  else if (tile_size < order)
+    printf("Tile size             = %ld\n", tile_size);
+  else
+    printf("Untiled\n");
+  if (inplace)
+    printf("In-place transpose    = on\n");
   printf("Number of iterations  = %d\n", iterations);
 
   /*  Fill the original matrix, set transpose to known garbage value. */
@@ -140,20 +241,26 @@ int main(int argc, char ** argv) {
   }
 
   /*  Set the transpose matrix to a known garbage value.                            */
-  for (j=0;j<order;j++) for (i=0;i<order; i++)  {
+  if (!inplace) for (j=0;j<order;j++) for (i=0;i<order; i++)  {
     B(i,j) = 0.0;
   }
 
-  trans_time = 0.0; /* silence compiler warning */
+  prk_harness_init(&harness, "Transpose", "Serial", iterations);
+  prk_harness_param(&harness, "order", "%ld", order);
+  prk_harness_param(&harness, "tile_size", "%ld", tile_size < order ? tile_size : 0);
+  prk_harness_param(&harness, "algorithm", "%s", 
+                    recursive ? "recursive" : inplace ? "inplace" : "tiled");
 
   for (iter = 0; iter<=iterations; iter++){
 
-    /* start timer after a warmup iteration                                        */
-    if (iter==1) trans_time = wtime();
+    /* time every iteration after a warmup iteration                               */
+    if (iter>=1) prk_harness_tick(&harness);
 
     /* Transpose the  matrix; only use tiling if the tile size is smaller 
        than the matrix */
-    if (tile_size < order) {
+    if (recursive) transpose_block(order, 0, order, 0, order, A_p, B_p);
+    else if (inplace) transpose_inplace(order, tile_size, A_p);
+    else if (tile_size < order) {
       for (i=0; i<order; i+=tile_size) 
         for (j=0; j<order; j+=tile_size) 
           for (it=i; it<MIN(order,i+tile_size); it++)
@@ -176,11 +283,22 @@ int main(int argc, char ** argv) {
   ** Analyze and output results.
   *********************************************************************/
 
-  trans_time = wtime() - trans_time;
+  prk_harness_tick(&harness);
+  trans_time = prk_harness_elapsed(&harness);
 
   abserr = 0.0;
   double addit = ((double)(iterations+1) * (double) (iterations))/2.0;
-  for (j=0;j<order;j++) for (i=0;i<order; i++) {
+  if (inplace) {
+    /* after an odd number of transposes A holds the transpose of its
+       initial value, after an even number the initial value itself,
+       plus one per transpose                                          */
+    long k = iterations+1L;
+    for (j=0;j<order;j++) for (i=0;i<order; i++) {
+      double ref = (k%2) ? (double)(order*i + j) : (double)(order*j + i);
+      abserr += ABS(A(i,j) - (ref + k));
+    }
+  }
+  else for (j=0;j<order;j++) for (i=0;i<order; i++) {
       abserr += ABS(B(i,j) - ((double)(order*i + j)*(iterations+1)+addit));
   }
 
@@ -193,6 +311,12 @@ int main(int argc, char ** argv) {
     avgtime = trans_time/iterations;
     printf("Rate (MB/s): %lf Avg time (s): %lf\n",
            1.0E-06 * bytes/avgtime, avgtime);
+    /* B += A^T and A += 1: two reads and two writes per element;
+       A = A^T + 1: one read and one write per element            */
+    if (inplace) prk_harness_model(&harness, 1.0*order*order, bytes);
+    else         prk_harness_model(&harness, 2.0*order*order, 2.0*bytes);
+    prk_harness_report(&harness, "MB/s", 1.0E-06 * bytes);
+    prk_harness_finalize(&harness);
 #if VERBOSE
     printf("Squared errors: %f \n", abserr);
 #endif
@@ -0,0 +1,460 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/*************************************************************
+Copyright (c)  2013 The University of Tennessee. All rights reserved.
+Redistribution and use in source and binary forms, with or 
+without modification, are permitted provided that the following
+conditions are met:
+
+- Redistributions of source code must retain the 
+  above copyright notice, this list of conditions and 
+  the following disclaimer.
+
+- Redistributions in binary form must reproduce the 
+  above copyright notice, this list of conditions and 
+  the following disclaimer listed in this license in the 
+  documentation and/or other materials provided with the 
+  distribution.
+
+- Neither the name of the copyright holders nor the names 
+  of its contributors may be used to endorse or promote 
+  products derived from this software without specific 
+  prior written permission.
+
+This software is provided by the copyright holders and 
+contributors "as is" and any express or implied warranties, 
+including, but not limited to, the implied warranties of
+merchantability and fitness for a particular purpose are 
+disclaimed. in no event shall the copyright owner or 
+contributors be liable for any direct, indirect, incidental, 
+special, exemplary, or consequential damages (including, but 
+not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) 
+however caused and on any theory of liability, whether in 
+contract, strict liability, or tort (including negligence or 
+otherwise) arising in any way out of the use of this software, 
+even if advised of the possibility of such damage.
+
+*************************************************************/
+/*******************************************************************
+
+NAME:    RandomAccess
+
+PURPOSE: This program tests the efficiency of the memory subsystem and
+         network to update elements of a distributed array with irregular
+         stride, using one-sided atomic operations.
+
+USAGE:   The program takes as input the ratio of number of updates over
+         table size, and the 2log of the size of the table that gets
+         updated. The table is distributed evenly over all participating
+         PEs and allocated on the symmetric heap.
+
+         <progname> <#update ratio> <log2 tablesize>
+
+         Each PE generates the same streams of random numbers as MPI1
+         Random and applies every update directly to the owning PE's part
+         of the table with an atomic XOR (shmem_atomic_xor, or a
+         compare-and-swap loop before OpenSHMEM 1.4).  Updates to a PE's
+         own part of the table also use the atomic, so they cannot collide
+         with remote ones.  The atomics do not return a value, so they are
+         issued back to back, and every LOOKAHEAD updates are completed
+         with a single shmem_quiet.
+
+FUNCTIONS CALLED:
+
+         Other than SHMEM or standard C functions, the following
+         functions are used in this program:
+
+         wtime
+         bail_out()
+         prk_harness_*()
+         PRK_starts
+         poweroftwo
+
+NOTES:   This program is derived from MPI1 Random, which is in turn derived
+         from HPC Challenge Random Access; see there for the choice of
+         random number streams and the verification test.  Because the
+         streams are the same, the rates of both versions are comparable.
+
+HISTORY: Written by Rob Van der Wijngaart, December 2007.
+         One-sided version derived from the MPI1 version, October 2026.
+
+************************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_shmem.h>
+#include <prk_harness.h>
+
+/* Define 64-bit types and corresponding format strings for printf() and constants */
+/* PERIOD = (2^63-1)/7 = 7*73*127*337*92737*649657                                 */
+#if LONG_IS_64BITS
+  #define POLY               0x0000000000000007UL
+  #define PERIOD             1317624576693539401L
+  /* sequence number in series of random numbers to be used as initial value       */
+  #define SEQSEED            834568137686317453L
+#else
+  #define POLY               0x0000000000000007ULL
+  #define PERIOD             1317624576693539401LL
+  /* sequence number in series of random numbers to be used as initial value       */
+  #define SEQSEED            834568137686317453LL
+#endif
+
+static u64Int PRK_starts(s64Int);
+static int    poweroftwo(int);
+
+int main(int argc, char **argv) {
+
+  int               update_ratio;/* multiplier of tablesize for # updates          */
+  int               nstarts;     /* vector length                                  */
+  s64Int            i, j, round, oldsize, global_index; /* dummies                */
+  int               dest;        /* dummy                                          */
+  s64Int            tablesize;   /* aggregate table size (all PEs)                 */
+  s64Int            loctablesize;/* local table size (each PE)                     */
+  s64Int            nupdate;     /* number of updates per PE                       */
+  s64Int            tablespace;  /* bytes per PE required for table                */
+  u64Int            *ran;        /* vector of random numbers                       */
+  u64Int            *Table;      /* (pseudo-)randomly accessed array               */
+  s64Int            *arguments;  /* input parameters broadcast by the root         */
+  long long         *errors;     /* local and global error counts                  */
+  long              *pSync_bcast;/* work space for collectives                     */
+  long              *pSync_reduce;
+  long long         *pWrk;
+  double            random_time; /* timing parameter                               */
+  prk_harness_t     harness;     /* timing and counters of the update phase        */
+  int               Num_procs,   /* PE parameters                                  */
+                    my_ID,       /* ID of calling PE                               */
+                    root=0;      /* ID of master PE                                */
+  s64Int            error=0;     /* error flag for individual PE                   */
+  int               log2nproc;   /* log2 of # PEs                                  */
+  int               log2nstarts; /* log2 of vector length                          */
+  int               log2tablesize; /* log2 of aggregate table size                 */
+  int               log2update_ratio; /* log2 of update ratio                      */
+
+#if LONG_IS_64BITS
+  if (sizeof(long) != 8) {
+    printf("ERROR: Makefile says \"long\" is 8 bytes, but it is %d bytes\n",
+           sizeof(long));
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+/***********************************************************************************
+** PE and test input parameters
+************************************************************************************/
+
+  prk_shmem_init();
+  my_ID=prk_shmem_my_pe();
+  Num_procs=prk_shmem_n_pes();
+
+  pSync_bcast  = (long *)      prk_shmem_align(prk_get_alignment(),PRK_SHMEM_BCAST_SYNC_SIZE*sizeof(long));
+  pSync_reduce = (long *)      prk_shmem_align(prk_get_alignment(),PRK_SHMEM_REDUCE_SYNC_SIZE*sizeof(long));
+  pWrk         = (long long *) prk_shmem_align(prk_get_alignment(),PRK_SHMEM_REDUCE_MIN_WRKDATA_SIZE*sizeof(long long));
+  arguments    = (s64Int *)    prk_shmem_align(prk_get_alignment(),8*sizeof(s64Int));
+  errors       = (long long *) prk_shmem_align(prk_get_alignment(),2*sizeof(long long));
+  if (!pSync_bcast || !pSync_reduce || !pWrk || !arguments || !errors) {
+    printf("PE %d could not allocate scalar work space on symm heap\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+
+  for(i=0;i<PRK_SHMEM_BCAST_SYNC_SIZE;i++)
+    pSync_bcast[i]=PRK_SHMEM_SYNC_VALUE;
+
+  for(i=0;i<PRK_SHMEM_REDUCE_SYNC_SIZE;i++)
+    pSync_reduce[i]=PRK_SHMEM_SYNC_VALUE;
+
+  if (my_ID == root) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("SHMEM Random Access\n");
+
+    if (argc != 3){
+      printf("Usage: %s <#update ratio> <log2 tablesize>\n", *argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    update_ratio  = atoi(*++argv);
+    /* test whether update ratio is a power of two                                 */
+    log2update_ratio = poweroftwo(update_ratio);
+    if (log2update_ratio <0) {
+      printf("ERROR: Invalid update ratio: %d, must be a power of 2\n",
+             update_ratio);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* test whether number of PEs is a power of two                                */
+    log2nproc = poweroftwo(Num_procs);
+    if (log2nproc <0) {
+      printf("ERROR: Invalid number of PEs: %d, must be a power of 2\n",
+             Num_procs);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    log2tablesize  = atoi(*++argv);
+    if (log2tablesize < 1){
+      printf("ERROR: Log2 tablesize is %d; must be >= 1\n",log2tablesize);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* for simplicity we set the vector length equal to the LOOKAHEAD size         */
+    nstarts = LOOKAHEAD;
+
+    /* test whether vector length is a power of two                                */
+    log2nstarts = poweroftwo(nstarts);
+    if (log2nstarts <0) {
+      printf("ERROR: Invalid vector length: %d, must be a power of 2\n",
+             nstarts);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* compute (local) table size carefully to make sure it can be represented     */
+    loctablesize = 1;
+    for (i=0; i<log2tablesize-log2nproc; i++) {
+      oldsize =  loctablesize;
+      loctablesize <<=1;
+      if (loctablesize/2 != oldsize) {
+        printf("ERROR: Requested table size too large; reduce log2 tablesize = %d\n",
+                log2tablesize);
+        error = 1;
+        goto ENDOFTESTS;
+      }
+    }
+    tablesize = loctablesize * Num_procs;
+    if (tablesize/Num_procs != loctablesize) {
+      printf("ERROR: Requested table size too large; reduce log2 tablesize = %d\n",
+              log2tablesize);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    if ((log2tablesize + log2update_ratio) < (log2nproc+log2nstarts)) {
+      printf("ERROR: Table size ("FSTR64U") times update ratio (%d) must be at ",
+             ((s64Int)1<<log2tablesize), update_ratio);
+      printf("least equal to number of PEs (%d) times vector length (%d)\n",
+             Num_procs, nstarts);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* even though the table size can be represented, computing the space
+       required for the table may lead to overflow                                 */
+    tablespace = (size_t) loctablesize*sizeof(u64Int);
+    if ((tablespace/sizeof(u64Int)) != loctablesize || tablespace <=0) {
+      printf("ERROR: Cannot represent space for table on this system; ");
+      printf("reduce log2 tablesize\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    /* compute number of updates carefully to make sure it can be represented      */
+    nupdate = update_ratio * loctablesize;
+    if (nupdate/loctablesize != update_ratio) {
+      printf("Requested number of updates too large; ");
+      printf("reduce log2 tablesize or update ratio\n");
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    printf("Number of PEs                 = "FSTR64U"\n", (u64Int) Num_procs);
+    printf("Table size (aggregate)        = "FSTR64U"\n", tablesize);
+    printf("Update ratio                  = "FSTR64U"\n", (u64Int) update_ratio);
+    printf("Number of updates (aggregate) = "FSTR64U"\n", nupdate*Num_procs);
+    printf("Vector (LOOKAHEAD) length     = "FSTR64U"\n", (u64Int) nstarts);
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+    printf("Remote update                 = shmem_atomic_xor\n");
+#else
+    printf("Remote update                 = shmem_cswap loop\n");
+#endif
+
+    arguments[0] = log2nproc;        arguments[1] = log2tablesize;
+    arguments[2] = update_ratio;     arguments[3] = nstarts;
+    arguments[4] = tablesize;        arguments[5] = loctablesize;
+    arguments[6] = tablespace;       arguments[7] = nupdate;
+
+    ENDOFTESTS:;
+  }
+  bail_out(error);
+
+  /* broadcast initialization data                                                 */
+  shmem_barrier_all();
+  shmem_broadcast64(&arguments[0], &arguments[0], 8, root, 0, 0, Num_procs, pSync_bcast);
+  if (my_ID != root) {
+    log2nproc    = arguments[0];   log2tablesize = arguments[1];
+    update_ratio = arguments[2];   nstarts       = arguments[3];
+    tablesize    = arguments[4];   loctablesize  = arguments[5];
+    tablespace   = arguments[6];   nupdate       = arguments[7];
+  }
+  shmem_barrier_all();
+  prk_shmem_free(arguments);
+
+  ran = (u64Int *) prk_malloc(nstarts*sizeof(u64Int));
+  if (!ran) {
+    printf("ERROR: PE %d could not allocate %zu bytes for random numbers\n",
+           my_ID, nstarts*sizeof(u64Int));
+    error = 1;
+  }
+  bail_out(error);
+
+  Table = (u64Int *) prk_shmem_align(prk_get_alignment(),tablespace);
+  if (!Table) {
+    printf("ERROR: PE %d could not allocate space of "FSTR64U"  bytes for table\n",
+           my_ID, (u64Int) tablespace);
+    error = 1;
+  }
+  bail_out(error);
+
+  /* initialize the table */
+  for(i=0;i<loctablesize;i++) Table[i] = (u64Int) (i+ loctablesize*my_ID);
+
+  prk_harness_init(&harness, "Random", "SHMEM", 1);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "tablesize", "%lld", (long long) tablesize);
+  prk_harness_param(&harness, "update_ratio", "%d", update_ratio);
+  prk_harness_param(&harness, "vector_length", "%d", nstarts);
+
+  shmem_barrier_all();
+  prk_harness_tick(&harness);
+
+  /* do two identical rounds of Random Access to ensure we recover initial table   */
+  for (round=0; round <2; round++) {
+    /* compute seeds for independent streams, using jump-ahead feature             */
+    for (j=0; j<nstarts; j++) {
+      ran[j] = PRK_starts(SEQSEED+(nupdate/nstarts)*j+loctablesize*my_ID);
+    }
+
+    /* because we do two rounds, we divide nupdate in two                          */
+    for (i=0; i<nupdate/(nstarts*2); i++) {
+
+      for (j=0; j<nstarts; j++) {
+        ran[j] = (ran[j] << 1) ^ ((s64Int)ran[j] < 0? POLY: 0);
+        global_index = (ran[j] & (tablesize-1));
+        /* determine destination PE (high order bits of global table index)        */
+        dest = global_index>>(log2tablesize-log2nproc);
+        prk_shmem_xor((unsigned long long *) &Table[ran[j] & (loctablesize-1)],
+                      ran[j], dest);
+      }
+
+      /* complete this batch of updates before starting the next                   */
+      shmem_quiet();
+    }
+  }
+
+  shmem_barrier_all();
+  prk_harness_tick(&harness);
+  random_time = prk_harness_elapsed(&harness);
+
+  /* verification test */
+  for(i=0;i<loctablesize;i++) {
+    if(Table[i] != (u64Int) (i + loctablesize*my_ID)) {
+#if VERBOSE
+      printf("ERROR: Table["FSTR64U"]="FSTR64U" on PE %d\n",i,Table[i],my_ID);
+#endif
+      error++;
+    }
+  }
+
+  if (error != 0) {
+    printf("ERROR: number of incorrect table elements on PE %d = "FSTR64U"\n",
+           my_ID, error);
+  }
+
+  errors[0] = error;
+  shmem_barrier_all();
+  shmem_longlong_sum_to_all(&errors[1], &errors[0], 1, 0, 0, Num_procs, pWrk, pSync_reduce);
+  if (my_ID==root) {
+    if (!errors[1]) {
+      printf("Solution validates\n");
+      printf("Rate (GUPS/s): %lf, Time (s): %lf\n",
+             1.e-9*(nupdate*Num_procs)/random_time, random_time);
+    }
+    else {
+      printf("Total number of incorrect table elements: "FSTR64U"\n", (u64Int) errors[1]);
+    }
+  }
+
+  prk_harness_model(&harness, 0.0, 2.0*64*nupdate*Num_procs);
+  prk_harness_report(&harness, "GUPS/s", 1.e-9*(nupdate*Num_procs));
+  prk_harness_finalize(&harness);
+
+  prk_shmem_finalize();
+}
+
+/* Utility routine to start random number generator at nth step                    */
+u64Int PRK_starts(s64Int n)
+{
+  int i, j;
+  u64Int m2[64];
+  u64Int temp, ran;
+
+  while (n < 0) n += PERIOD;
+  while (n > PERIOD) n -= PERIOD;
+  if (n == 0) return 0x1;
+
+  temp = 0x1;
+  for (i=0; i<64; i++) {
+    m2[i] = temp;
+    temp = (temp << 1) ^ ((s64Int) temp < 0 ? POLY : 0);
+    temp = (temp << 1) ^ ((s64Int) temp < 0 ? POLY : 0);
+  }
+
+  for (i=62; i>=0; i--)
+    if ((n >> i) & 1)
+      break;
+
+  ran = 0x2;
+  while (i > 0) {
+    temp = 0;
+    for (j=0; j<64; j++)
+      if ((unsigned int)((ran >> j) & 1))
+        temp ^= m2[j];
+    ran = temp;
+    i -= 1;
+    if ((n >> i) & 1)
+      ran = (ran << 1) ^ ((s64Int) ran < 0 ? POLY : 0);
+  }
+
+  return ran;
+}
+
+/* utility routine that tests whether an integer is a power of two                 */
+int poweroftwo(int n) {
+  int log2n = 0;
+
+  while ((1<<log2n)<n) log2n++;
+  if (1<<log2n != n) return (-1);
+  else               return (log2n);
+}
@@ -0,0 +1,291 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    RefCount
+
+PURPOSE: This program tests the efficiency of remote atomic updates of
+         a pair of non-adjacent reference counters that all PEs access
+         at the same time (a hot spot)
+
+USAGE:   The program takes as input the number of times each PE
+         updates the reference counter pair
+
+               <progname> <# iterations>
+
+         The output consists of diagnostics to make sure the
+         algorithm worked, of timing statistics, and of a histogram of
+         the latencies of the individual atomic operations.
+
+         The counters are symmetric objects. PRK_ATOMIC selects how a
+         counter is incremented:
+           fetch_inc     shmem_atomic_fetch_inc (default)
+           cas           shmem_atomic_compare_swap loop, starting from the
+                         last value the PE saw; failed attempts are counted
+         PRK_HOST selects where the counter pair lives:
+           single        on PE 0, so all PEs hit the same target (default)
+           spread        on every PE; update i of PE p goes to the pair
+                         on PE (p+i) mod #PEs
+         Timing every operation adds two wtime() calls to each of them;
+         use a low-overhead timer (PRK_TIMER) for short latencies.
+
+FUNCTIONS CALLED:
+
+         Other than SHMEM or standard C functions, the following
+         functions are used in this program:
+
+         wtime()
+         bail_out()
+         prk_harness_*()
+         prk_shmem_fetch_inc()
+         prk_shmem_cswap()
+         prk_histogram_add()
+         prk_histogram_print()
+
+HISTORY: Derived from OPENMP/Refcount, October 2026; the counter pair is
+         a symmetric object updated with remote atomics.
+
+*******************************************************************/
+
+#include <par-res-kern_general.h>
+#include <par-res-kern_shmem.h>
+#include <prk_harness.h>
+#include <prk_histogram.h>
+
+#define ATOMIC_FETCH_INC 0
+#define ATOMIC_CAS       1
+
+/* offsets of the two counters in the symmetric array; they are kept on
+   different cache lines so they are not adjacent                        */
+#define COUNTER_STRIDE  16
+#define COUNTER_LENGTH  (2*COUNTER_STRIDE)
+
+/* the two counter sums, the failed compare-and-swaps and the histogram
+   are reduced over all PEs in one go                                     */
+#define TALLY_FAILURES  2
+#define TALLY_HISTOGRAM 3
+#define TALLY_LENGTH    (TALLY_HISTOGRAM+PRK_HISTOGRAM_BINS)
+
+int main(int argc, char ** argv)
+{
+  int       my_ID;          /* PE                                                */
+  int       root=0;         /* ID of root PE                                     */
+  int       Num_procs;      /* number of PEs                                     */
+  long      iterations;     /* number of counter pair updates per PE             */
+  long      iter;           /* dummy                                             */
+  int       c, b;           /* counter and histogram bin indices                 */
+  int       atomic=ATOMIC_FETCH_INC; /* type of atomic update                    */
+  int       spread=0;       /* counter pairs on all PEs instead of on root       */
+  int       target;         /* PE hosting the counter pair being updated         */
+  char      *env;           /* value of an environment variable                  */
+  int       error=0;        /* error flag                                        */
+  long long *counters;      /* symmetric counter pair                            */
+  long long *guess;         /* last counter values seen, per target PE           */
+  long long prev;           /* value returned by compare-and-swap                */
+  long long refcount;       /* verification value of each counter                */
+  long long failures=0;     /* failed compare-and-swap attempts                  */
+  long long *tally,         /* local and global sums of counters and statistics  */
+            *total_tally;
+  long      *pSync;         /* work space for SHMEM collectives                  */
+  long long *pWrk;          /* work space for SHMEM collectives                  */
+  int       nwrk;           /* length of pWrk                                    */
+  double    op_time;        /* start time of an atomic operation                 */
+  double    refcount_time;  /* timing parameter                                  */
+  prk_histogram_t hist;     /* latencies of the atomic operations                */
+  prk_harness_t harness;    /* timing of all updates as a single iteration       */
+
+/*********************************************************************
+** Initialize the SHMEM environment
+*********************************************************************/
+
+  prk_shmem_init();
+  my_ID =  prk_shmem_my_pe();
+  Num_procs =  prk_shmem_n_pes();
+
+/*********************************************************************
+** process and test input parameters
+*********************************************************************/
+
+  if (my_ID == root) {
+    printf("Parallel Research Kernels version %s\n", PRKVERSION);
+    printf("SHMEM reference counter update\n");
+  }
+
+  if (argc != 2) {
+    if (my_ID == root)
+      printf("Usage: %s <# iterations>\n", *argv);
+    error = 1;
+    goto ENDOFTESTS;
+  }
+
+  iterations = atol(*++argv);
+  if (iterations < 1) {
+    if (my_ID == root)
+      printf("ERROR: iterations must be >= 1 : %ld \n", iterations);
+    error = 1;
+    goto ENDOFTESTS;
+  }
+
+  env = getenv("PRK_ATOMIC");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"cas"))       atomic = ATOMIC_CAS;
+    else if (strcmp(env,"fetch_inc")) {
+      if (my_ID == root)
+        printf("ERROR: PRK_ATOMIC must be fetch_inc or cas: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+  }
+
+  env = getenv("PRK_HOST");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"spread")) spread = 1;
+    else if (strcmp(env,"single")) {
+      if (my_ID == root)
+        printf("ERROR: PRK_HOST must be single or spread: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+  }
+
+  nwrk        = MAX(TALLY_LENGTH/2+1, PRK_SHMEM_REDUCE_MIN_WRKDATA_SIZE);
+  pSync       = (long *)      prk_shmem_align(prk_get_alignment(), sizeof(long) * PRK_SHMEM_REDUCE_SYNC_SIZE);
+  pWrk        = (long long *) prk_shmem_align(prk_get_alignment(), sizeof(long long) * nwrk);
+  counters    = (long long *) prk_shmem_align(prk_get_alignment(), sizeof(long long) * COUNTER_LENGTH);
+  tally       = (long long *) prk_shmem_align(prk_get_alignment(), sizeof(long long) * TALLY_LENGTH);
+  total_tally = (long long *) prk_shmem_align(prk_get_alignment(), sizeof(long long) * TALLY_LENGTH);
+  guess       = (long long *) prk_malloc(2*Num_procs*sizeof(long long));
+  if (!pSync || !pWrk || !counters || !tally || !total_tally || !guess) {
+    printf("Rank %d could not allocate space for counters and collectives\n", my_ID);
+    error = 1;
+    goto ENDOFTESTS;
+  }
+  for (c=0; c<PRK_SHMEM_REDUCE_SYNC_SIZE; c++) pSync[c] = PRK_SHMEM_SYNC_VALUE;
+
+  ENDOFTESTS:;
+  bail_out(error);
+
+  if (my_ID == root) {
+    printf("Number of ranks                = %d\n", Num_procs);
+    printf("Number of counter pair updates = %ld per rank\n", iterations);
+    printf("Atomic operation               = %s\n",
+           atomic==ATOMIC_CAS ? "compare_swap" : "fetch_inc");
+    printf("Counter pair location          = %s\n",
+           spread ? "spread over all ranks" : "rank 0");
+  }
+
+  for (c=0; c<COUNTER_LENGTH; c++) counters[c] = 0;
+  for (c=0; c<2*Num_procs; c++) guess[c] = 0;
+  prk_histogram_init(&hist);
+  prk_harness_init(&harness, "Refcount", "SHMEM", 1);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "iterations", "%ld", iterations);
+  prk_harness_param(&harness, "atomic", "%s", atomic==ATOMIC_CAS ? "cas" : "fetch_inc");
+  prk_harness_param(&harness, "host", "%s", spread ? "spread" : "single");
+  shmem_barrier_all();
+
+  for (iter=0; iter<=iterations; iter++) {
+
+    /* start timer after a warmup iteration                                      */
+    if (iter == 1) {
+      shmem_barrier_all();
+      prk_harness_tick(&harness);
+    }
+
+    target = spread ? (int) ((my_ID+iter)%Num_procs) : root;
+    for (c=0; c<2; c++) {
+      op_time = wtime();
+      if (atomic == ATOMIC_CAS) {
+        while ((prev = prk_shmem_cswap(&counters[c*COUNTER_STRIDE], guess[2*target+c],
+                                       guess[2*target+c]+1, target)) != guess[2*target+c]) {
+          guess[2*target+c] = prev;
+          failures++;
+        }
+        guess[2*target+c]++;
+      }
+      else (void) prk_shmem_fetch_inc(&counters[c*COUNTER_STRIDE], target);
+      if (iter > 0) prk_histogram_add(&hist, wtime()-op_time);
+    }
+  }
+
+  /* the barrier completes the updates of all PEs                                */
+  shmem_barrier_all();
+  prk_harness_tick(&harness);
+  refcount_time = prk_harness_elapsed(&harness);
+
+  /*******************************************************************************
+  ** Analyze and output results.
+  ********************************************************************************/
+
+  tally[0] = counters[0];
+  tally[1] = counters[COUNTER_STRIDE];
+  tally[TALLY_FAILURES] = failures;
+  for (b=0; b<PRK_HISTOGRAM_BINS; b++) tally[TALLY_HISTOGRAM+b] = hist.count[b];
+  shmem_longlong_sum_to_all(total_tally, tally, TALLY_LENGTH, 0, 0, Num_procs, pWrk, pSync);
+
+  if (my_ID == root) {
+    refcount = (long long) Num_procs*(iterations+1);
+    if (total_tally[0] != refcount || total_tally[1] != refcount) {
+      printf("ERROR: Incorrect counter values %lld %lld; ", total_tally[0], total_tally[1]);
+      printf("should be %lld, %lld\n", refcount, refcount);
+      error = 1;
+    }
+  }
+  bail_out(error);
+
+  if (my_ID == root) {
+#ifdef VERBOSE
+    printf("Solution validates; Correct counter values %lld %lld\n",
+           total_tally[0], total_tally[1]);
+#else
+    printf("Solution validates\n");
+#endif
+    if (atomic == ATOMIC_CAS)
+      printf("Failed compare-and-swaps       = %lld (%lf per update)\n", total_tally[TALLY_FAILURES],
+             (double) total_tally[TALLY_FAILURES]/(2.0*Num_procs*iterations));
+    for (b=0; b<PRK_HISTOGRAM_BINS; b++) hist.count[b] = total_tally[TALLY_HISTOGRAM+b];
+    prk_histogram_print(&hist, atomic==ATOMIC_CAS ? "compare_swap" : "fetch_inc");
+    printf("Rate (MCPUPs/s): %lf time (s): %lf\n",
+           1.0E-06*Num_procs*iterations/refcount_time, refcount_time);
+  }
+
+  prk_harness_report(&harness, "MCPUPs/s", 1.0E-06*Num_procs*iterations);
+  prk_harness_finalize(&harness);
+
+  prk_free(guess);
+  prk_shmem_finalize();
+
+  exit(EXIT_SUCCESS);
+
+}  /* end of main */
@@ -43,6 +43,27 @@ USAGE:   The program takes as input the linear dimension of the grid,
  
                <progname> <# iterations> <grid size>
   
+         Halos are put into double-buffered receive buffers of the
+         neighbors.  By default each put is followed by a fence and an
+         atomic increment of a single counter at the target, which waits
+         until all its neighbors have delivered.  When built with SIGNAL=1
+         every neighbor signals its own flag instead, using
+         shmem_putmem_signal with OpenSHMEM 1.5 and a put, fence and
+         put of the flag otherwise, so each halo is unpacked as soon as
+         it has arrived.
+
+         With PRK_HALO_DEPTH=k the ghost zone is k*RADIUS points deep and is
+         exchanged only every k iterations; in between, the ghost points that
+         are still read before the next exchange are updated redundantly,
+         trading the extra work and larger messages for fewer of them.
+
+         With PRK_INCREMENT=offset the constant that every iteration adds
+         to IN is kept as an implicit offset of the grid instead of being
+         added by a pass over the tile and its ghost zone.  The weights
+         sum to zero, so the stencil of IN plus a constant equals that of
+         IN and the norm is unchanged; the halos are still exchanged as
+         usual.  PRK_INCREMENT=sweep (the default) adds it explicitly.
+
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
  
@@ -53,14 +74,18 @@ FUNCTIONS CALLED:
  
          wtime()
          bail_out()
+         prk_harness_*()
  
 HISTORY: - Written by Tom St. John, July 2015.
          - Adapted by Rob Van der Wijngaart to introduce double buffering, December 2015
+         - Added per-neighbor signal flags (SIGNAL=1)
+         - Added deep (communication-avoiding) halos
   
 *********************************************************************************/
  
 #include <par-res-kern_general.h>
 #include <par-res-kern_shmem.h>
+#include <prk_harness.h>
 
 #if DOUBLE
   #define DTYPE     double
@@ -77,13 +102,36 @@ HISTORY: - Written by Tom St. John, July 2015.
 #endif
  
 /* define shorthand for indexing multi-dimensional arrays with offsets           */
-#define INDEXIN(i,j)  (i+RADIUS+(j+RADIUS)*(width[0]+2*RADIUS))
-/* need to add offset of RADIUS to j to account for ghost points                 */
+#define INDEXIN(i,j)  (i+ghost+(j+ghost)*(width[0]+2*ghost))
+/* need to add offset of ghost to j to account for ghost points                  */
 #define IN(i,j)       in[INDEXIN(i-istart,j-jstart)]
 #define INDEXOUT(i,j) (i+(j)*(width[0]))
 #define OUT(i,j)      out[INDEXOUT(i-istart,j-jstart)]
 #define WEIGHT(ii,jj) weight[ii+RADIUS][jj+RADIUS]
 
+#if SIGNAL
+/* deliver a halo together with the value of its signal flag at the target   */
+#if defined(SHMEM_MAJOR_VERSION) && SHMEM_MAJOR_VERSION*100+SHMEM_MINOR_VERSION >= 105
+  typedef uint64_t signal_t;
+  #define PUT_SIGNAL(dest,src,bytes,sig,val,pe) \
+    shmem_putmem_signal(dest, src, bytes, sig, val, SHMEM_SIGNAL_SET, pe)
+  #define WAIT_SIGNAL(sig,val) shmem_signal_wait_until(sig, SHMEM_CMP_GE, val)
+#else
+  typedef long signal_t;
+  #define PUT_SIGNAL(dest,src,bytes,sig,val,pe)                   \
+    do { shmem_putmem(dest, src, bytes, pe); shmem_fence();       \
+         shmem_long_p(sig, val, pe); } while (0)
+  #define WAIT_SIGNAL(sig,val) shmem_long_wait_until(sig, SHMEM_CMP_GE, val)
+#endif
+/* flags of the halos from the top, bottom, right and left neighbors, for
+   either receive buffer                                                     */
+#define SIG(sw,dir)   (&(signals[4*(sw)+(dir)]))
+#define FROM_TOP    0
+#define FROM_BOTTOM 1
+#define FROM_RIGHT  2
+#define FROM_LEFT   3
+#endif
+
 int main(int argc, char ** argv) {
  
   int    Num_procs;       /* number of ranks                                     */
@@ -106,6 +154,7 @@ int main(int argc, char ** argv) {
   int    *width, *height, /* linear global and local grid dimension              */
          *maxwidth, *maxheight;
   int    n;
+  prk_harness_t harness;  /* per-iteration timing                                */
   int    i, j, ii, jj, kk, it, jt, iter, leftover;  /* dummies                   */
   int    istart, iend;    /* bounds of grid tile assigned to calling rank        */
   int    jstart, jend;    /* bounds of grid tile assigned to calling rank        */
@@ -124,6 +173,13 @@ int main(int argc, char ** argv) {
   DTYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
   int    *arguments;      /* command line parameters                             */
   int    count_case=4;    /* number of neighbors of a rank                       */
+  int    depth;           /* halo depth in multiples of RADIUS                   */
+  int    ghost;           /* depth of the ghost zone: depth*RADIUS               */
+  int    exch;            /* number of the current halo exchange                 */
+  int    ext;             /* depth of ghost zone still read before next exchange */
+  char   *env;            /* value of PRK_HALO_DEPTH or PRK_INCREMENT            */
+  int    offset;          /* nonzero if the increment of IN is implicit          */
+  DTYPE  wsum;            /* sum of the stencil weights                          */
   long   *pSync_bcast;    /* work space for collectives                          */
   long   *pSync_reduce;   /* work space for collectives                          */
   double *pWrk_time;      /* work space for collectives                          */
@@ -131,6 +187,9 @@ int main(int argc, char ** argv) {
   int    *pWrk_dim;       /* work space for collectives                          */
   int    *iterflag;       /* synchronization flags                               */
   int    sw;              /* double buffering switch                             */
+#if SIGNAL
+  signal_t *signals;      /* per-neighbor synchronization flags                  */
+#endif
   DTYPE  *local_norm, *norm; /* local and global error norms                     */
 
   /*******************************************************************************
@@ -170,7 +229,7 @@ int main(int argc, char ** argv) {
   for(i=0;i<PRK_SHMEM_REDUCE_SYNC_SIZE;i++)
     pSync_reduce[i]=PRK_SHMEM_SYNC_VALUE;
 
-  arguments=(int*)prk_shmem_align(prk_get_alignment(),2*sizeof(int));
+  arguments=(int*)prk_shmem_align(prk_get_alignment(),4*sizeof(int));
  
   /*******************************************************************************
   ** process, test, and broadcast input parameters    
@@ -220,6 +279,24 @@ int main(int argc, char ** argv) {
       error = 1;
       goto ENDOFTESTS;  
     }
+
+    env   = getenv("PRK_HALO_DEPTH");
+    depth = env ? atoi(env) : 1;
+    arguments[2]=depth;
+    if (depth < 1) {
+      printf("ERROR: PRK_HALO_DEPTH must be positive: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
+
+    env    = getenv("PRK_INCREMENT");
+    offset = env && !strcmp(env, "offset");
+    arguments[3]=offset;
+    if (env && !offset && strcmp(env, "sweep")) {
+      printf("ERROR: PRK_INCREMENT must be sweep or offset: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;  
+    }
  
     ENDOFTESTS:;  
   }
@@ -267,20 +344,28 @@ int main(int argc, char ** argv) {
 #else
     printf("Compact representation of stencil loop body\n");
 #endif
-#if SPLITFENCE
+#if SIGNAL
+    printf("Synchronization        = per-neighbor signals\n");
+#elif SPLITFENCE
     printf("Split fence            = ON\n");
 #else
     printf("Split fence            = OFF\n");
 #endif
     printf("Number of iterations   = %d\n", iterations);
+    printf("Halo depth             = %d x radius, exchanged every %d iteration%s\n",
+           depth, depth, depth > 1 ? "s" : "");
+    printf("Increment of input     = %s\n", offset ? "implicit offset" : "sweep");
   }
 
   shmem_barrier_all();
  
-  shmem_broadcast32(&arguments[0], &arguments[0], 2, root, 0, 0, Num_procs, pSync_bcast);
+  shmem_broadcast32(&arguments[0], &arguments[0], 4, root, 0, 0, Num_procs, pSync_bcast);
 
   iterations=arguments[0];
   n=arguments[1];
+  depth=arguments[2];
+  offset=arguments[3];
+  ghost=depth*RADIUS;
 
   shmem_barrier_all();
   prk_shmem_free(arguments);
@@ -323,15 +408,15 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
-  if (width[0] < RADIUS || height[0] < RADIUS) {
-    printf("ERROR: rank %d has work tile smaller then stencil radius\n",
+  if (width[0] < ghost || height[0] < ghost) {
+    printf("ERROR: rank %d has work tile smaller then halo depth\n",
            my_ID);
     error = 1;
   }
   bail_out(error);
 
-  total_length_in = (width[0]+2*RADIUS);
-  total_length_in *= (height[0]+2*RADIUS);
+  total_length_in = (width[0]+2*ghost);
+  total_length_in *= (height[0]+2*ghost);
   total_length_in *= sizeof(DTYPE);
 
   total_length_out = width[0];
@@ -365,6 +450,21 @@ int main(int argc, char ** argv) {
     WEIGHT(0, ii) = WEIGHT( ii,0) =  (DTYPE) (1.0/(2.0*ii*RADIUS));
     WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(DTYPE) (1.0/(2.0*ii*RADIUS));
   }
+
+  /* IN+c feeds the stencil c*wsum more than IN does, so with weights that
+     sum to zero the increment can be left to an implicit offset            */
+  if (offset) {
+    wsum = (DTYPE) 0.0;
+    for (jj=-RADIUS; jj<=RADIUS; jj++) for (ii=-RADIUS; ii<=RADIUS; ii++)
+      wsum += WEIGHT(ii,jj);
+    if (ABS(wsum) > EPSILON) {
+      if (my_ID == root)
+        printf("ERROR: PRK_INCREMENT=offset needs weights that sum to zero, not "
+               FSTR"\n", wsum);
+      error = 1;
+    }
+  }
+  bail_out(error);
  
   norm[0] = (DTYPE) 0.0;
   f_active_points = (DTYPE) (n-2*RADIUS)*(DTYPE) (n-2*RADIUS);
@@ -376,15 +476,15 @@ int main(int argc, char ** argv) {
   }
 
   /* allocate communication buffers for halo values                            */
-  top_buf_out=(DTYPE*)prk_shmem_malloc(2*sizeof(DTYPE)*RADIUS*maxwidth[0]);
+  top_buf_out=(DTYPE*)prk_shmem_malloc(2*sizeof(DTYPE)*ghost*maxwidth[0]);
   if (!top_buf_out) {
     printf("ERROR: Rank %d could not allocate output comm buffers for y-direction\n", my_ID);
     error = 1;
   }
   bail_out(error);
-  bottom_buf_out = top_buf_out+RADIUS*maxwidth[0];
+  bottom_buf_out = top_buf_out+ghost*maxwidth[0];
 
-  top_buf_in[0]=(DTYPE*)prk_shmem_align(prk_get_alignment(),4*sizeof(DTYPE)*RADIUS*maxwidth[0]);
+  top_buf_in[0]=(DTYPE*)prk_shmem_align(prk_get_alignment(),4*sizeof(DTYPE)*ghost*maxwidth[0]);
   if(!top_buf_in)
   {
     printf("ERROR: Rank %d could not allocate input comm buffers for y-direction\n", my_ID);
@@ -392,28 +492,44 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
 
-  top_buf_in[1]    = top_buf_in[0]    + RADIUS*maxwidth[0];
-  bottom_buf_in[0] = top_buf_in[1]    + RADIUS*maxwidth[0];
-  bottom_buf_in[1] = bottom_buf_in[0] + RADIUS*maxwidth[0];
+  top_buf_in[1]    = top_buf_in[0]    + ghost*maxwidth[0];
+  bottom_buf_in[0] = top_buf_in[1]    + ghost*maxwidth[0];
+  bottom_buf_in[1] = bottom_buf_in[0] + ghost*maxwidth[0];
  
-  right_buf_out=(DTYPE*)prk_shmem_malloc(2*sizeof(DTYPE)*RADIUS*maxheight[0]);
+  right_buf_out=(DTYPE*)prk_shmem_malloc(2*sizeof(DTYPE)*ghost*maxheight[0]);
   if (!right_buf_out) {
     printf("ERROR: Rank %d could not allocate output comm buffers for x-direction\n", my_ID);
     error = 1;
   }
   bail_out(error);
-  left_buf_out=right_buf_out+RADIUS*maxheight[0];
+  left_buf_out=right_buf_out+ghost*maxheight[0];
 
-  right_buf_in[0]=(DTYPE*)prk_shmem_align(prk_get_alignment(),4*sizeof(DTYPE)*RADIUS*maxheight[0]);
+  right_buf_in[0]=(DTYPE*)prk_shmem_align(prk_get_alignment(),4*sizeof(DTYPE)*ghost*maxheight[0]);
   if(!right_buf_in)
   {
     printf("ERROR: Rank %d could not allocate input comm buffers for x-dimension\n", my_ID);
     error=1;
   }
   bail_out(error);
-  right_buf_in[1] = right_buf_in[0] + RADIUS*maxheight[0];
-  left_buf_in[0]  = right_buf_in[1] + RADIUS*maxheight[0];
-  left_buf_in[1]  = left_buf_in[0]  + RADIUS*maxheight[0];
+  right_buf_in[1] = right_buf_in[0] + ghost*maxheight[0];
+  left_buf_in[0]  = right_buf_in[1] + ghost*maxheight[0];
+  left_buf_in[1]  = left_buf_in[0]  + ghost*maxheight[0];
+
+#if SIGNAL
+  signals = (signal_t *) prk_shmem_align(prk_get_alignment(),8*sizeof(signal_t));
+  if (!signals) {
+    printf("ERROR: Rank %d could not allocate signal flags\n", my_ID);
+    error = 1;
+  }
+  bail_out(error);
+  for (kk=0; kk<8; kk++) signals[kk] = 0;
+#endif
+
+  prk_harness_init(&harness, "Stencil", "SHMEM", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "grid_size", "%d", n);
+  prk_harness_param(&harness, "radius", "%d", RADIUS);
+  prk_harness_param(&harness, "halo_depth", "%d", depth);
 
   /* make sure all symmetric heaps are allocated before being used  */
   shmem_barrier_all();
@@ -421,88 +537,122 @@ int main(int argc, char ** argv) {
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration */
-    if (iter == 1) { 
-      shmem_barrier_all();
-      local_stencil_time[0] = wtime();
-    }
-    /* sw determines which incoming buffer to select */
-    sw = iter%2;
-
-    /* need to fetch ghost point data from neighbors */
-
-    if (my_IDy < Num_procsy-1) {
-      for (kk=0,j=jend-RADIUS; j<=jend-1; j++) for (i=istart; i<=iend; i++) {
-          top_buf_out[kk++]= IN(i,j);
-      }
-      shmem_putmem(bottom_buf_in[sw], top_buf_out, RADIUS*width[0]*sizeof(DTYPE), top_nbr);
+    if (iter == 1) shmem_barrier_all();
+    if (iter >= 1) prk_harness_tick(&harness);
+    /* the ghost zone is refreshed every depth iterations; it is depth*RADIUS
+       points deep, so it still holds the RADIUS points read by the stencil
+       after the redundant updates of the iterations in between              */
+    if (!(iter%depth)) {
+      exch = iter/depth;
+      /* sw determines which incoming buffer to select */
+      sw = exch%2;
+
+      /* need to fetch ghost point data from neighbors */
+
+      if (my_IDy < Num_procsy-1) {
+        for (kk=0,j=jend-ghost; j<=jend-1; j++) for (i=istart; i<=iend; i++) {
+            top_buf_out[kk++]= IN(i,j);
+        }
+#if SIGNAL
+        PUT_SIGNAL(bottom_buf_in[sw], top_buf_out, ghost*width[0]*sizeof(DTYPE), SIG(sw,FROM_BOTTOM), exch+1, top_nbr);
+#else
+        shmem_putmem(bottom_buf_in[sw], top_buf_out, ghost*width[0]*sizeof(DTYPE), top_nbr);
 #if SPLITFENCE
-      shmem_fence();
-      shmem_int_inc(&iterflag[sw], top_nbr);
+        shmem_fence();
+        shmem_int_inc(&iterflag[sw], top_nbr);
+#endif
 #endif
-    }
-    if (my_IDy > 0) {
-      for (kk=0,j=jstart; j<=jstart+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
-          bottom_buf_out[kk++]= IN(i,j);
       }
-      shmem_putmem(top_buf_in[sw], bottom_buf_out, RADIUS*width[0]*sizeof(DTYPE), bottom_nbr);
+      if (my_IDy > 0) {
+        for (kk=0,j=jstart; j<=jstart+ghost-1; j++) for (i=istart; i<=iend; i++) {
+            bottom_buf_out[kk++]= IN(i,j);
+        }
+#if SIGNAL
+        PUT_SIGNAL(top_buf_in[sw], bottom_buf_out, ghost*width[0]*sizeof(DTYPE), SIG(sw,FROM_TOP), exch+1, bottom_nbr);
+#else
+        shmem_putmem(top_buf_in[sw], bottom_buf_out, ghost*width[0]*sizeof(DTYPE), bottom_nbr);
 #if SPLITFENCE
-      shmem_fence();
-      shmem_int_inc(&iterflag[sw], bottom_nbr);
+        shmem_fence();
+        shmem_int_inc(&iterflag[sw], bottom_nbr);
+#endif
 #endif
-    }
-
-    if(my_IDx < Num_procsx-1) {
-      for(kk=0,j=jstart;j<=jend;j++) for(i=iend-RADIUS;i<=iend-1;i++) {
-	right_buf_out[kk++]=IN(i,j);
       }
-      shmem_putmem(left_buf_in[sw], right_buf_out, RADIUS*height[0]*sizeof(DTYPE), right_nbr);
+
+      if(my_IDx < Num_procsx-1) {
+        for(kk=0,j=jstart;j<=jend;j++) for(i=iend-ghost;i<=iend-1;i++) {
+	  right_buf_out[kk++]=IN(i,j);
+        }
+#if SIGNAL
+        PUT_SIGNAL(left_buf_in[sw], right_buf_out, ghost*height[0]*sizeof(DTYPE), SIG(sw,FROM_LEFT), exch+1, right_nbr);
+#else
+        shmem_putmem(left_buf_in[sw], right_buf_out, ghost*height[0]*sizeof(DTYPE), right_nbr);
 #if SPLITFENCE
-      shmem_fence();
-      shmem_int_inc(&iterflag[sw], right_nbr);
+        shmem_fence();
+        shmem_int_inc(&iterflag[sw], right_nbr);
+#endif
 #endif
-    }
-
-    if(my_IDx>0) {
-      for(kk=0,j=jstart;j<=jend;j++) for(i=istart;i<=istart+RADIUS-1;i++) {
-	left_buf_out[kk++]=IN(i,j);
       }
-      shmem_putmem(right_buf_in[sw], left_buf_out, RADIUS*height[0]*sizeof(DTYPE), left_nbr);
+
+      if(my_IDx>0) {
+        for(kk=0,j=jstart;j<=jend;j++) for(i=istart;i<=istart+ghost-1;i++) {
+	  left_buf_out[kk++]=IN(i,j);
+        }
+#if SIGNAL
+        PUT_SIGNAL(right_buf_in[sw], left_buf_out, ghost*height[0]*sizeof(DTYPE), SIG(sw,FROM_RIGHT), exch+1, left_nbr);
+#else
+        shmem_putmem(right_buf_in[sw], left_buf_out, ghost*height[0]*sizeof(DTYPE), left_nbr);
 #if SPLITFENCE
-      shmem_fence();
-      shmem_int_inc(&iterflag[sw], left_nbr);
+        shmem_fence();
+        shmem_int_inc(&iterflag[sw], left_nbr);
 #endif
-    }
+#endif
+      }
 
-#if SPLITFENCE == 0
-    shmem_fence();
-    if(my_IDy<Num_procsy-1) shmem_int_inc(&iterflag[sw], top_nbr);
-    if(my_IDy>0)            shmem_int_inc(&iterflag[sw], bottom_nbr);
-    if(my_IDx<Num_procsx-1) shmem_int_inc(&iterflag[sw], right_nbr);
-    if(my_IDx>0)            shmem_int_inc(&iterflag[sw], left_nbr);
+#if SPLITFENCE == 0 && !SIGNAL
+      shmem_fence();
+      if(my_IDy<Num_procsy-1) shmem_int_inc(&iterflag[sw], top_nbr);
+      if(my_IDy>0)            shmem_int_inc(&iterflag[sw], bottom_nbr);
+      if(my_IDx<Num_procsx-1) shmem_int_inc(&iterflag[sw], right_nbr);
+      if(my_IDx>0)            shmem_int_inc(&iterflag[sw], left_nbr);
 #endif
 
-    shmem_int_wait_until(&iterflag[sw], SHMEM_CMP_EQ, count_case*(iter/2+1));
+#if !SIGNAL
+      shmem_int_wait_until(&iterflag[sw], SHMEM_CMP_EQ, count_case*(exch/2+1));
+#endif
 
-    if (my_IDy < Num_procsy-1) {
-      for (kk=0,j=jend; j<=jend+RADIUS-1; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = top_buf_in[sw][kk++];
-      }      
-    }
-    if (my_IDy > 0) {
-      for (kk=0,j=jstart-RADIUS; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
-          IN(i,j) = bottom_buf_in[sw][kk++];
-      }      
-    }
+      if (my_IDy < Num_procsy-1) {
+#if SIGNAL
+        WAIT_SIGNAL(SIG(sw,FROM_TOP), exch+1);
+#endif
+        for (kk=0,j=jend; j<=jend+ghost-1; j++) for (i=istart; i<=iend; i++) {
+            IN(i,j) = top_buf_in[sw][kk++];
+        }      
+      }
+      if (my_IDy > 0) {
+#if SIGNAL
+        WAIT_SIGNAL(SIG(sw,FROM_BOTTOM), exch+1);
+#endif
+        for (kk=0,j=jstart-ghost; j<=jstart-1; j++) for (i=istart; i<=iend; i++) {
+            IN(i,j) = bottom_buf_in[sw][kk++];
+        }      
+      }
 
-    if (my_IDx < Num_procsx-1) {
-      for (kk=0,j=jstart; j<=jend; j++) for (i=iend; i<=iend+RADIUS-1; i++) {
-          IN(i,j) = right_buf_in[sw][kk++];
-      }      
-    }
-    if (my_IDx > 0) {
-      for (kk=0,j=jstart; j<=jend; j++) for (i=istart-RADIUS; i<=istart-1; i++) {
-          IN(i,j) = left_buf_in[sw][kk++];
-      }      
+      if (my_IDx < Num_procsx-1) {
+#if SIGNAL
+        WAIT_SIGNAL(SIG(sw,FROM_RIGHT), exch+1);
+#endif
+        for (kk=0,j=jstart; j<=jend; j++) for (i=iend; i<=iend+ghost-1; i++) {
+            IN(i,j) = right_buf_in[sw][kk++];
+        }      
+      }
+      if (my_IDx > 0) {
+#if SIGNAL
+        WAIT_SIGNAL(SIG(sw,FROM_LEFT), exch+1);
+#endif
+        for (kk=0,j=jstart; j<=jend; j++) for (i=istart-ghost; i<=istart-1; i++) {
+            IN(i,j) = left_buf_in[sw][kk++];
+        }      
+      }
     }
  
     /* Apply the stencil operator */
@@ -518,12 +668,22 @@ int main(int argc, char ** argv) {
       }
     }
  
-    /* add constant to solution to force refresh of neighbor data, if any */
-    for (j=jstart; j<jend; j++) for (i=istart; i<iend; i++) IN(i,j)+= 1.0;
+    /* add constant to solution to force refresh of neighbor data, if any; 
+       the ghost points that are read again before the next exchange receive
+       the same update redundantly                                            */
+    if (offset) continue;
+    ext = (depth-1-iter%depth)*RADIUS;
+    for (j=jstart-(my_IDy>0 ? ext : 0); j<jend+(my_IDy<Num_procsy-1 ? ext : 0); j++) 
+      for (i=istart; i<iend; i++) IN(i,j)+= 1.0;
+    if (ext > 0) for (j=jstart; j<jend; j++) {
+      if (my_IDx > 0)            for (i=istart-ext; i<istart; i++) IN(i,j)+= 1.0;
+      if (my_IDx < Num_procsx-1) for (i=iend; i<iend+ext; i++)     IN(i,j)+= 1.0;
+    }
  
   }
  
-  local_stencil_time[0] = wtime() - local_stencil_time[0];
+  prk_harness_tick(&harness);
+  local_stencil_time[0] = prk_harness_elapsed(&harness);
 
   shmem_barrier_all();
 
@@ -574,19 +734,25 @@ int main(int argc, char ** argv) {
   }
   bail_out(error);
  
+  /* flops/stencil: 2 flops (fma) for each point in the stencil, 
+     plus one flop for the update of the input of the array        */
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
   if (my_ID == root) {
-    /* flops/stencil: 2 flops (fma) for each point in the stencil, 
-       plus one flop for the update of the input of the array        */
-    flops = (DTYPE) (2*stencil_size+1) * f_active_points;
     avgtime = stencil_time[0]/iterations;
     printf("Rate (MFlops/s): "FSTR"  Avg time (s): %lf\n",
            1.0E-06 * flops/avgtime, avgtime);
   }
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * flops);
+  prk_harness_finalize(&harness);
+
   prk_shmem_free(top_buf_in[0]);
   prk_shmem_free(right_buf_in[0]);
   prk_shmem_free(top_buf_out);
   prk_shmem_free(right_buf_out);
+#if SIGNAL
+  prk_shmem_free(signals);
+#endif
   
   prk_shmem_free(pSync_bcast);
   prk_shmem_free(pSync_reduce);
@@ -42,11 +42,23 @@ PURPOSE: This program tests the efficiency with which point-to-point
 USAGE:   The program takes as input the dimensions of the grid, and the
          number of times we loop over the grid
 
-               <progname> <# iterations> <m> <n>
+               <progname> <# iterations> <m> <n> [group factor]
   
          The output consists of diagnostics to make sure the 
          algorithm worked, and of timing statistics.
 
+         By default a boundary value is sent with shmem_double_p, followed by
+         shmem_fence and shmem_int_p of a flag that the receiver waits for.
+         With PRK_SYNC=signal (requires OpenSHMEM 1.4) the boundary values of
+         a line group go out with one put-with-signal: shmem_put_signal in
+         OpenSHMEM 1.5, or a put fenced off from an atomic set before that.
+         The signal is the number of line groups sent so far, so it only
+         grows and the receiver waits for it with SHMEM_CMP_GE. The group
+         factor sets how many lines go into one transfer. With
+         PRK_SHMEM_CTX=private these transfers use a private communication
+         context of the (single) thread of the PE, so that their fences
+         only order the pipeline traffic.
+
 FUNCTIONS CALLED:
 
          Other than SHMEM or standard C functions, the following 
@@ -54,6 +66,9 @@ FUNCTIONS CALLED:
 
          wtime()
          bail_out()
+         prk_harness_*()
+         prk_shmem_double_put_signal()
+         prk_shmem_signal_wait_ge()
 
 HISTORY: - Written by Rob Van der Wijngaart, March 2006.
          - modified by Rob Van der Wijngaart, August 2006:
@@ -68,6 +83,7 @@ HISTORY: - Written by Rob Van der Wijngaart, March 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_shmem.h>
+#include <prk_harness.h>
 
 #define ARRAY(i,j) vector[i+1+(j)*(segment_size+1)]
 
@@ -95,7 +111,20 @@ int main(int argc, char ** argv)
   double *dst;            /* target address of communication                     */
   double *src;            /* source address of communication                     */
   long   *pSync;          /* work space for SHMEM collectives                    */
+  int    grp;             /* grid line aggregation factor                        */
+  int    jj, jjsize;      /* line in group, actual line group size               */
+  int    g;               /* line group index                                    */
+  int    put_signal=0;    /* use put-with-signal                                 */
+  int    private_ctx=0;   /* use a private communication context                 */
+  char   *env;            /* value of PRK_SYNC or PRK_SHMEM_CTX                  */
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+  shmem_ctx_t ctx;        /* communication context for put-with-signal           */
+  prk_shmem_signal_t *signal, /* signal word, on the heap                        */
+         count;           /* signal value                                        */
+  long   ngroup;          /* number of line groups per iteration                 */
+#endif
   double *pWrk;           /* work space for SHMEM collectives                    */
+  prk_harness_t harness;  /* timing of the pipelined iterations                  */
   
 /*********************************************************************************
 ** Initialize the SHMEM environment
@@ -116,9 +145,9 @@ int main(int argc, char ** argv)
     printf("SHMEM pipeline execution on 2D grid\n");
   }
 
-  if (argc != 4){
+  if (argc != 4 && argc != 5){
     if (my_ID == root)
-      printf("Usage: %s  <#iterations> <1st array dimension> <2nd array dimension>\n", 
+      printf("Usage: %s  <#iterations> <1st array dimension> <2nd array dimension> [group factor]\n", 
            *argv);
     error = 1;
     goto ENDOFTESTS;
@@ -141,6 +170,56 @@ int main(int argc, char ** argv)
     goto ENDOFTESTS;
   }
 
+  if (argc==5) {
+    grp = atoi(*++argv);
+    if (grp < 1) grp = 1;
+    else if (grp >= n) grp = n-1;
+  }
+  else grp = 1;
+
+  env = getenv("PRK_SYNC");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"signal")) put_signal = 1;
+    else if (strcmp(env,"flag")) {
+      if (my_ID == root)
+        printf("ERROR: PRK_SYNC must be flag or signal: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+  }
+
+  env = getenv("PRK_SHMEM_CTX");
+  if (env != NULL && *env != '\0') {
+    if      (!strcmp(env,"private")) private_ctx = 1;
+    else if (strcmp(env,"default")) {
+      if (my_ID == root)
+        printf("ERROR: PRK_SHMEM_CTX must be default or private: %s\n", env);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+  }
+
+#ifndef PRK_HAVE_OPENSHMEM_1_4
+  if (put_signal) {
+    if (my_ID == root)
+      printf("ERROR: PRK_SYNC=signal requires OpenSHMEM 1.4\n");
+    error = 1;
+    goto ENDOFTESTS;
+  }
+#endif
+  if (private_ctx && !put_signal) {
+    if (my_ID == root)
+      printf("ERROR: PRK_SHMEM_CTX=private requires PRK_SYNC=signal\n");
+    error = 1;
+    goto ENDOFTESTS;
+  }
+  if (grp > 1 && !put_signal) {
+    if (my_ID == root)
+      printf("ERROR: group factor requires PRK_SYNC=signal\n");
+    error = 1;
+    goto ENDOFTESTS;
+  }
+
 // initialize sync variables for error checks
   pSync = (long *)   prk_shmem_align(prk_get_alignment(), sizeof(long) * PRK_SHMEM_REDUCE_SYNC_SIZE );
   pWrk  = (double *) prk_shmem_align(prk_get_alignment(), sizeof(double) * PRK_SHMEM_REDUCE_MIN_WRKDATA_SIZE );
@@ -166,6 +245,17 @@ int main(int argc, char ** argv)
     printf("Number of ranks            = %d\n",Num_procs);
     printf("Grid sizes                 = %ld, %ld\n", m, n);
     printf("Number of iterations       = %d\n", iterations);
+    if (grp > 1)
+    printf("Group factor               = %d (cheating!)\n", grp);
+    if (put_signal) {
+#ifdef PRK_HAVE_OPENSHMEM_1_5
+    printf("Synchronization            = put-with-signal\n");
+#else
+    printf("Synchronization            = put-with-signal (put, fence, atomic set)\n");
+#endif
+    printf("Communication context      = %s\n", private_ctx ? "private" : "default");
+    }
+    else
 #ifdef SYNCHRONOUS
     printf("Handshake between neighbor threads\n");
 #else
@@ -243,6 +333,32 @@ int main(int argc, char ** argv)
 #endif
   }  
 
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+  if (put_signal) {
+    ngroup = (n-1+grp-1)/grp;
+    signal = (prk_shmem_signal_t *) prk_shmem_align(prk_get_alignment(),
+                                                    sizeof(prk_shmem_signal_t));
+    if (!signal) {
+      printf("ERROR: could not allocate signal on rank %d\n", my_ID);
+      error = 1;
+    }
+    else signal[0] = 0;
+    ctx = SHMEM_CTX_DEFAULT;
+    if (private_ctx && shmem_ctx_create(SHMEM_CTX_PRIVATE, &ctx)) {
+      printf("ERROR: could not create communication context on rank %d\n", my_ID);
+      error = 1;
+    }
+    bail_out(error);
+  }
+#endif
+
+  prk_harness_init(&harness, "Synch_p2p", "SHMEM", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "m", "%ld", m);
+  prk_harness_param(&harness, "n", "%ld", n);
+  prk_harness_param(&harness, "group", "%d", grp);
+  prk_harness_param(&harness, "sync", "%s", put_signal ? "signal" : "flag");
+
   shmem_barrier_all ();
 
   for (iter=0; iter<=iterations; iter++) {
@@ -252,11 +368,53 @@ int main(int argc, char ** argv)
     true = (iter+1)%2; false = !true;
 #endif
 
+    /* iterations overlap in the pipeline, so only their total is timed          */
     if (iter == 1) {
       shmem_barrier_all ();
-      local_pipeline_time[0] = wtime();
+      prk_harness_tick(&harness);
     }
 
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+    if (put_signal) {
+      if (my_ID==0 && Num_procs>1) {
+        /* first PE waits for the corner value of the previous iteration         */
+        prk_shmem_signal_wait_ge(signal, iter);
+        if (iter>0) ARRAY(start[my_ID]-1,0) = dst[0];
+      }
+
+      for (g=0, j=1; j<n; g++, j+=grp) {
+        jjsize = MIN(grp, n-j);
+        /* the signal counts the line groups received so far                     */
+        count = (prk_shmem_signal_t)(iter*ngroup+g+1);
+
+        if (my_ID > 0) {
+          prk_shmem_signal_wait_ge(signal, count);
+          for (jj=0; jj<jjsize; jj++) ARRAY(start[my_ID]-1,j+jj) = dst[j+jj];
+        }
+
+        for (jj=0; jj<jjsize; jj++) for (i=start[my_ID]; i<= end[my_ID]; i++) {
+          ARRAY(i,j+jj) = ARRAY(i-1,j+jj) + ARRAY(i,j+jj-1) - ARRAY(i-1,j+jj-1);
+        }
+
+        if (my_ID != Num_procs-1) {
+          for (jj=0; jj<jjsize; jj++) src[j+jj] = ARRAY(end[my_ID],j+jj);
+          prk_shmem_double_put_signal(ctx, &dst[j], &src[j], jjsize, signal, count, my_ID+1);
+        }
+      }
+
+      /* copy top right corner value to bottom left corner to create dependency  */
+      if (Num_procs >1) {
+        if (my_ID==root) {
+          src[0] = -ARRAY(end[my_ID],n-1);
+          prk_shmem_double_put_signal(ctx, &dst[0], &src[0], 1, signal,
+                                      (prk_shmem_signal_t)(iter+1), 0);
+        }
+      }
+      else ARRAY(0,0)= -ARRAY(end[my_ID],n-1);
+      continue;
+    }
+#endif
+
     if (my_ID==0 && Num_procs>1) { 
       /* first thread waits for corner value to be copied                        */
       shmem_int_wait_until(&flag_left[0], SHMEM_CMP_EQ, false);
@@ -320,7 +478,15 @@ int main(int argc, char ** argv)
     else ARRAY(0,0)= -ARRAY(end[my_ID],n-1);
   }
 
-  local_pipeline_time [0] = wtime() - local_pipeline_time [0];
+  prk_harness_ticks(&harness, iterations);
+  local_pipeline_time [0] = prk_harness_elapsed(&harness);
+
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+  if (put_signal) {
+    shmem_ctx_quiet(ctx);
+    if (private_ctx) shmem_ctx_destroy(ctx);
+  }
+#endif
   shmem_double_max_to_all(pipeline_time, local_pipeline_time, 1, 0, 0, Num_procs, 
                           pWrk, pSync);
 
@@ -337,6 +503,8 @@ int main(int argc, char ** argv)
 
   if (my_ID == root) {
     avgtime = pipeline_time [0]/iterations;
+    /* flip the sign of the execution time to indicate cheating                    */
+    if (grp>1) avgtime *= -1.0;
 #ifdef VERBOSE   
     printf("Solution validates; verification value = %lf\n", corner_val);
     printf("Point-to-point synchronizations/s: %lf\n",
@@ -348,6 +516,9 @@ int main(int argc, char ** argv)
            1.0E-06 * 2 * ((double)((m-1)*(n-1)))/avgtime, avgtime);
   }
 
+  prk_harness_report(&harness, "MFlops/s", 1.0E-06 * 2 * ((double)((m-1)*(n-1))));
+  prk_harness_finalize(&harness);
+
   prk_shmem_finalize();
 
   exit(EXIT_SUCCESS);
@@ -45,6 +45,12 @@ USAGE:   Program inputs are the matrix order, the number of times to
 
          An optional parameter specifies the tile size used to divide the 
          individual matrix blocks for improved cache and TLB performance. 
+
+         With PRK_DISTRIBUTION=2d the matrices are instead distributed
+         by square blocks over a square grid of ranks, so that each rank
+         exchanges its block with just the rank owning the mirror image
+         block (see the layout nomenclature below).  The number of ranks
+         must be a perfect square.  The default is PRK_DISTRIBUTION=column.
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -56,9 +62,11 @@ FUNCTIONS CALLED:
 
           wtime()           Portable wall-timer interface.
           bail_out()        Determine global error and exit if nonzero.
+          prk_harness_*()   Per-iteration timing and results record.
 
 HISTORY: Written by Tom St. John, July 2015.  
          Rob vdW: Fixed race condition on synchronization flags, August 2015
+         Added the 2D block distribution.
            
 *******************************************************************/
 
@@ -81,6 +89,12 @@ o Colblock is logically composed of #ranks Blocks, but a Block is
 o When tiling is applied to reduce TLB misses, each block gets 
   accessed by tiles. 
 o The original and transposed matrices are called A and B
+o With the 2D distribution a rank with grid coordinates (r,c) owns
+  only Block (r,c) of both matrices, stored contiguously; it puts
+  the transpose of its Block of A into a work buffer of rank (c,r),
+  alternating between two buffers in successive iterations, and adds
+  the Block put by that rank to its Block of B.  Ranks on the diagonal
+  of the grid transpose their Block locally
 
  -----------------------------------------------------------------
 |           |           |           |                             |
@@ -110,11 +124,15 @@ o The original and transposed matrices are called A and B
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_shmem.h>
+#include <prk_harness.h>
 
 #define A(i,j)        A_p[(i+istart)+order*(j)]
 #define B(i,j)        B_p[(i+istart)+order*(j)]
 #define Work_in(phase, i,j)  Work_in_p[phase-1][i+Block_order*(j)]
 #define Work_out(i,j) Work_out_p[i+Block_order*(j)]
+/* square blocks of the 2D distribution                                  */
+#define A2(i,j)       A_p[i+Block_order*(j)]
+#define B2(i,j)       B_p[i+Block_order*(j)]
 
 int main(int argc, char ** argv)
 {
@@ -123,6 +141,7 @@ int main(int argc, char ** argv)
   int Colblock_size;       /* size of column block                  */
   int Tile_order=32;       /* default Tile order                    */
   int tiling;              /* boolean: true if tiling is used       */
+  prk_harness_t harness;   /* per-iteration timing                  */
   int Num_procs;           /* number of ranks                       */
   int order;               /* order of overall matrix               */
   int send_to, recv_from;  /* ranks with which to communicate       */
@@ -150,6 +169,14 @@ int main(int argc, char ** argv)
          *abserr_tot;      /* local and aggregate error             */
   int    *recv_flag;       /* synchronization flags                 */
   int    *arguments;       /* command line arguments                */
+  int    layout2d=0;       /* boolean: true if distributed 2D       */
+  int    grid_order=1;     /* ranks per side of the 2D rank grid    */
+  int    my_row, my_col;   /* grid coordinates of rank, if 2D       */
+  int    rowstart=0;       /* starting row for owning rank          */
+  int    partner;          /* rank owning the mirror image block    */
+  int    nwork;            /* number of receive work buffers        */
+  int    par;              /* work buffer of an iteration, if 2D    */
+  char   *env;             /* value of PRK_DISTRIBUTION             */
 
 /*********************************************************************
 ** Initialize the SHMEM environment
@@ -170,7 +197,7 @@ int main(int argc, char ** argv)
   pWrk             = (double *) prk_shmem_align(prk_get_alignment(),sizeof(double) * PRK_SHMEM_REDUCE_MIN_WRKDATA_SIZE);
   local_trans_time = (double *) prk_shmem_align(prk_get_alignment(),sizeof(double));
   trans_time       = (double *) prk_shmem_align(prk_get_alignment(),sizeof(double));
-  arguments        = (int *)    prk_shmem_align(prk_get_alignment(),3*sizeof(int));
+  arguments        = (int *)    prk_shmem_align(prk_get_alignment(),4*sizeof(int));
   abserr           = (double *) prk_shmem_align(prk_get_alignment(),2*sizeof(double));
   abserr_tot       = abserr + 1;
   if (!pSync_bcast || !pSync_reduce || !pWrk || !local_trans_time ||
@@ -204,14 +231,39 @@ int main(int argc, char ** argv)
       error = 1; goto ENDOFTESTS;
     }
 
+    env = getenv("PRK_DISTRIBUTION");
+    if (env != NULL && *env != '\0') {
+      if      (!strcmp(env,"2d")) layout2d = 1;
+      else if (strcmp(env,"column")) {
+        printf("ERROR: PRK_DISTRIBUTION must be column or 2d: %s\n", env);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+    arguments[3]=layout2d;
+    if (layout2d) {
+      grid_order = (int) (sqrt((double) Num_procs)+0.5);
+      if (grid_order*grid_order != Num_procs) {
+        printf("ERROR: # procs %d should be a perfect square for the 2D distribution\n",
+               Num_procs);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+
     order = atoi(*++argv);
     arguments[1]=order;
-    if (order < Num_procs) {
+    if (order < Num_procs && !layout2d) {
       printf("ERROR: matrix order %d should at least # procs %d\n", 
              order, Num_procs);
       error = 1; goto ENDOFTESTS;
     }
-    if (order%Num_procs) {
+    if (layout2d) {
+      if (order%grid_order) {
+        printf("ERROR: matrix order %d should be divisible by # procs per side %d\n",
+               order, grid_order);
+        error = 1; goto ENDOFTESTS;
+      }
+    }
+    else if (order%Num_procs) {
       printf("ERROR: matrix order %d should be divisible by # procs %d\n",
              order, Num_procs);
       error = 1; goto ENDOFTESTS;
@@ -231,16 +283,19 @@ int main(int argc, char ** argv)
     if ((Tile_order > 0) && (Tile_order < order))
           printf("Tile size            = %d\n", Tile_order);
     else  printf("Untiled\n");
+    if (layout2d)
+          printf("Distribution         = 2D, %d x %d ranks\n", grid_order, grid_order);
   }
   
   shmem_barrier_all();
 
   /*  Broadcast input data to all ranks */
-  shmem_broadcast32(&arguments[0], &arguments[0], 3, root, 0, 0, Num_procs, pSync_bcast);
+  shmem_broadcast32(&arguments[0], &arguments[0], 4, root, 0, 0, Num_procs, pSync_bcast);
 
   iterations=arguments[0];
   order=arguments[1];
   Tile_order=arguments[2];
+  layout2d=arguments[3];
 
   shmem_barrier_all();
   prk_shmem_free(arguments);
@@ -259,6 +314,25 @@ int main(int argc, char ** argv)
   colstart       = Block_order * my_ID;
   Colblock_size  = order * Block_order;
   Block_size     = Block_order * Block_order;
+  /* one work buffer per phase                                           */
+  nwork          = Num_procs-1;
+
+  /* with the 2D distribution a rank owns a single block, and its
+     partner owns the mirror image block; two work buffers, used in
+     alternate iterations, keep a put from overwriting a block that
+     the partner is still reading                                        */
+  if (layout2d) {
+    grid_order     = (int) (sqrt((double) Num_procs)+0.5);
+    my_row         = my_ID%grid_order;
+    my_col         = my_ID/grid_order;
+    Block_order    = order/grid_order;
+    rowstart       = Block_order * my_row;
+    colstart       = Block_order * my_col;
+    Block_size     = Block_order * Block_order;
+    Colblock_size  = Block_size;
+    partner        = my_col + grid_order*my_row;
+    nwork          = 2;
+  }
 
 /*********************************************************************
 ** Create the column block of the test matrix, the row block of the 
@@ -279,16 +353,16 @@ int main(int argc, char ** argv)
   bail_out(error);
 
   if (Num_procs>1) {
-    Work_in_p   = (double**)prk_malloc((Num_procs-1)*sizeof(double));
+    Work_in_p   = (double**)prk_malloc(nwork*sizeof(double));
 
     Work_out_p = (double *) prk_shmem_align(prk_get_alignment(),Block_size*sizeof(double));
-    recv_flag  = (int*)     prk_shmem_align(prk_get_alignment(),(Num_procs-1)*sizeof(int));
+    recv_flag  = (int*)     prk_shmem_align(prk_get_alignment(),nwork*sizeof(int));
     if ((Work_in_p == NULL)||(Work_out_p==NULL) || (recv_flag == NULL)){
       printf(" Error allocating space for work or flags on node %d\n",my_ID);
       error = 1;
     }
     bail_out(error);
-    for(i=0;i<(Num_procs-1);i++) {
+    for(i=0;i<nwork;i++) {
       Work_in_p[i]=(double *) prk_shmem_align(prk_get_alignment(),Block_size*sizeof(double));
       if (Work_in_p[i] == NULL) {
         printf(" Error allocating space for work on node %d\n",my_ID);
@@ -297,26 +371,87 @@ int main(int argc, char ** argv)
       bail_out(error);
     }
 
-    for(i=0;i<Num_procs-1;i++)
+    for(i=0;i<nwork;i++)
       recv_flag[i]=0;
   }
   
   /* Fill the original column matrices                                              */
   istart = 0;  
-  for (j=0;j<Block_order;j++) 
+  if (layout2d) for (j=0;j<Block_order;j++) 
+    for (i=0;i<Block_order; i++)  {
+      A2(i,j) = (double) (order*(j+colstart) + i+rowstart);
+      B2(i,j) = 0.0;
+  }
+  else for (j=0;j<Block_order;j++) 
     for (i=0;i<order; i++)  {
       A(i,j) = (double) (order*(j+colstart) + i);
       B(i,j) = 0.0;
   }
 
+  prk_harness_init(&harness, "Transpose", "SHMEM", iterations);
+  prk_harness_param(&harness, "ranks", "%d", Num_procs);
+  prk_harness_param(&harness, "order", "%d", order);
+  prk_harness_param(&harness, "tile_size", "%d", tiling ? Tile_order : 0);
+
   shmem_barrier_all();
 
   for (iter = 0; iter<=iterations; iter++){
 
     /* start timer after a warmup iteration                                        */
-    if (iter == 1) { 
-      shmem_barrier_all();
-      local_trans_time[0] = wtime();
+    if (iter == 1) shmem_barrier_all();
+    if (iter >= 1) prk_harness_tick(&harness);
+
+    if (layout2d) {
+      if (partner == my_ID) {
+        /* the block on the diagonal of the rank grid is its own partner */
+        if (!tiling) {
+          for (i=0; i<Block_order; i++) 
+            for (j=0; j<Block_order; j++) {
+              B2(j,i) += A2(i,j);
+              A2(i,j) += 1.0;
+            }
+        }
+        else {
+          for (i=0; i<Block_order; i+=Tile_order) 
+            for (j=0; j<Block_order; j+=Tile_order) 
+              for (it=i; it<MIN(Block_order,i+Tile_order); it++)
+                for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
+                  B2(jt,it) += A2(it,jt); 
+                  A2(it,jt) += 1.0;
+                }
+        }
+        continue;
+      }
+
+      if (!tiling) {
+        for (i=0; i<Block_order; i++) 
+          for (j=0; j<Block_order; j++){
+            Work_out(j,i) = A2(i,j);
+            A2(i,j) += 1.0;
+          }
+      }
+      else {
+        for (i=0; i<Block_order; i+=Tile_order) 
+          for (j=0; j<Block_order; j+=Tile_order) 
+            for (it=i; it<MIN(Block_order,i+Tile_order); it++)
+              for (jt=j; jt<MIN(Block_order,j+Tile_order);jt++) {
+                Work_out(jt,it) = A2(it,jt); 
+                A2(it,jt) += 1.0;
+              }
+      }
+
+      par = iter%2;
+      shmem_double_put(&Work_in_p[par][0], &Work_out_p[0], Block_size, partner);
+      shmem_fence();
+      shmem_int_inc(&recv_flag[par], partner);
+
+      /* each buffer receives one block every other iteration            */
+      shmem_int_wait_until(&recv_flag[par], SHMEM_CMP_EQ, iter/2+1);
+
+      for (j=0; j<Block_order; j++)
+        for (i=0; i<Block_order; i++) 
+          B2(i,j) += Work_in(par+1, i,j);
+      continue;
     }
 
     /* do the local transpose                                                     */
@@ -374,7 +509,8 @@ int main(int argc, char ** argv)
     }  /* end of phase loop  */
   } /* end of iterations */
 
-  local_trans_time[0] = wtime() - local_trans_time[0];
+  prk_harness_tick(&harness);
+  local_trans_time[0] = prk_harness_elapsed(&harness);
 
   shmem_barrier_all();
   shmem_double_max_to_all(trans_time, local_trans_time, 1, 0, 0, Num_procs, pWrk, pSync_reduce);
@@ -382,7 +518,10 @@ int main(int argc, char ** argv)
   abserr[0] = 0.0;
   istart = 0;
   double addit = ((double)(iterations+1) * (double) (iterations))/2.0;
-  for (j=0;j<Block_order;j++) for (i=0;i<order; i++) {
+  if (layout2d) for (j=0;j<Block_order;j++) for (i=0;i<Block_order; i++) {
+      abserr[0] += ABS(B2(i,j) - (double)((order*(i+rowstart) + j+colstart)*(iterations+1)+addit));
+  }
+  else for (j=0;j<Block_order;j++) for (i=0;i<order; i++) {
       abserr[0] += ABS(B(i,j) - (double)((order*i + j+colstart)*(iterations+1)+addit));
   }
 
@@ -406,11 +545,14 @@ int main(int argc, char ** argv)
 
   bail_out(error);
 
+  prk_harness_report(&harness, "MB/s", 1.0E-06*bytes);
+  prk_harness_finalize(&harness);
+
   if (Num_procs>1) 
     {
       prk_shmem_free(recv_flag);
 
-      for(i=0;i<Num_procs-1;i++)
+      for(i=0;i<nwork;i++)
 	prk_shmem_free(Work_in_p[i]);
 
       prk_free(Work_in_p);
@@ -0,0 +1,363 @@
+/*
+Copyright (c) 2013, Intel Corporation
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    Stencil
+
+PURPOSE: This program tests the efficiency with which a space-invariant,
+         linear, symmetric filter (stencil) can be applied to a square
+         grid or image with the task-based, work-stealing scheduler of
+         oneTBB.
+  
+USAGE:   The program takes as input the number of threads, the linear
+         dimension of the grid, and the number of iterations on the grid,
+         optionally followed by the radius and shape of the stencil
+
+               <progname> <# threads> <iterations> <grid size> [<radius> [star|compact]]
+
+         The arguments and the verification are those of OPENMP/Stencil,
+         so that the rates can be compared directly. The stencil is one
+         tbb::parallel_for over a blocked_range2d of the interior of the
+         grid, split by the partitioner chosen with PRK_PARTITIONER (see
+         prk_tbb.h); the update of the input grid is another over the
+         rows. PRK_TILE=<tile size> sets the grain size of the blocks in
+         both dimensions; the default, 0, keeps rows whole, so that they
+         are done by the same vectorized row kernels as in OpenMP, if
+         the CPU has them (see prk_stencil_simd.h), while smaller blocks
+         use the loops of this file. PRK_PARTITIONER=static reproduces
+         the static schedule of OpenMP, so comparing it with the other
+         partitioners shows what work stealing costs on a quiet node and
+         what it gains on a noisy or oversubscribed one.
+  
+         The output consists of diagnostics to make sure the 
+         algorithm worked, and of timing statistics.
+
+FUNCTIONS CALLED:
+
+         Other than standard C and C++ functions, the following 
+         functions are used in this program:
+
+         wtime()
+         prk_stencil_simd*() vectorized row kernels
+         star_part()
+         compact_part()
+
+HISTORY: Derived from CXX/Stencil, October 2026.
+  
+**********************************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_tbb.h>
+#include <prk_stencil_simd.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_reduce.h>
+
+#if DOUBLE
+  #define DTYPE   double
+  #define EPSILON 1.e-8
+  #define COEFX   1.0
+  #define COEFY   1.0
+  #define FSTR    "%lf"
+  #define prk_stencil_simd_dtype prk_stencil_simd_double
+#else
+  #define DTYPE   float
+  #define EPSILON 0.0001f
+  #define COEFX   1.0f
+  #define COEFY   1.0f
+  #define FSTR    "%f"
+  #define prk_stencil_simd_dtype prk_stencil_simd_float
+#endif
+
+/* define shorthand for indexing a multi-dimensional array                       */
+#define IN(i,j)       in[i+(j)*(n)]
+#define OUT(i,j)      out[i+(j)*(n)]
+#define WEIGHT(ii,jj) weight[(ii+radius)*(2*radius+1)+jj+radius]
+
+/* a row kernel applies the stencil to the interior points of row j           */
+typedef void (*stencil_row_t)(long, long, int, const DTYPE *, const DTYPE *, DTYPE *);
+
+/* apply the stencil to points i0 <= i < i1 of row j                          */
+static void star_part(long n, long j, long i0, long i1, int radius,
+                      const DTYPE * weight, const DTYPE * in, DTYPE * out) {
+  for (long i=i0; i<i1; i++) {
+    DTYPE sum = OUT(i,j);
+    for (int jj=-radius; jj<=radius; jj++) sum += WEIGHT(0,jj)*IN(i,j+jj);
+    for (int ii=-radius; ii<0; ii++)       sum += WEIGHT(ii,0)*IN(i+ii,j);
+    for (int ii=1; ii<=radius; ii++)       sum += WEIGHT(ii,0)*IN(i+ii,j);
+    OUT(i,j) = sum;
+  }
+}
+
+static void compact_part(long n, long j, long i0, long i1, int radius,
+                         const DTYPE * weight, const DTYPE * in, DTYPE * out) {
+  for (long i=i0; i<i1; i++) {
+    DTYPE sum = OUT(i,j);
+    for (int jj=-radius; jj<=radius; jj++)
+    for (int ii=-radius; ii<=radius; ii++) sum += WEIGHT(ii,jj)*IN(i+ii,j+jj);
+    OUT(i,j) = sum;
+  }
+}
+
+int main(int argc, char ** argv) {
+
+  long   n;               /* linear grid dimension                               */
+  int    radius;          /* radius of the stencil                               */
+  int    star;            /* boolean: star or compact stencil                    */
+  int    ii, jj, iter;    /* dummies                                             */
+  DTYPE  norm,            /* L1 norm of solution                                 */
+         reference_norm;
+  DTYPE  f_active_points; /* interior of grid with respect to stencil            */
+  DTYPE  flops;           /* floating point ops per iteration                    */
+  int    nthread_input;   /* thread parameters                                   */
+  int    iterations;      /* number of times to run the algorithm                */
+  double stencil_time,    /* timing parameters                                   */
+         avgtime;
+  int    stencil_size;    /* number of points in stencil                         */
+  DTYPE  * in;            /* input grid values                                   */
+  DTYPE  * out;           /* output grid values                                  */
+  long   total_length;    /* total required length to store grid values          */
+  DTYPE  * weight;        /* weights of points in the stencil                    */
+  long   tile;            /* grain size of the blocks, 0 for whole rows          */
+  char   * tile_env;      /* value of PRK_TILE                                   */
+  stencil_row_t row;      /* vectorized row kernel, or NULL                      */
+  prk_tbb_partitioner_kind partitioner; /* how parallel_for splits the range     */
+
+  printf("Parallel Research Kernels version %s\n", PRKVERSION);
+  printf("TBB stencil execution on 2D grid\n");
+
+  /*******************************************************************************
+  ** process and test input parameters    
+  ********************************************************************************/
+
+  if (argc < 4 || argc > 6){
+    printf("Usage: %s <# threads> <# iterations> <array dimension> "
+           "[<radius> [star|compact]]\n", *argv);
+    return(EXIT_FAILURE);
+  }
+
+  nthread_input = atoi(*++argv); 
+  if ((nthread_input < 1) || (nthread_input > MAX_THREADS)) {
+    printf("ERROR: Invalid number of threads: %d\n", nthread_input);
+    exit(EXIT_FAILURE);
+  }
+
+  iterations  = atoi(*++argv); 
+  if (iterations < 1){
+    printf("ERROR: iterations must be >= 1 : %d \n",iterations);
+    exit(EXIT_FAILURE);
+  }
+
+  n  = atol(*++argv);
+  if (n < 1){
+    printf("ERROR: grid dimension must be positive: %ld\n", n);
+    exit(EXIT_FAILURE);
+  }
+
+  radius = (argc > 4) ? atoi(*++argv) : RADIUS;
+  star   = STAR;
+  if (argc > 5) {
+    ++argv;
+    if      (!strcmp(*argv,"star"))    star = 1;
+    else if (!strcmp(*argv,"compact")) star = 0;
+    else {
+      printf("ERROR: Stencil shape %s should be star or compact\n", *argv);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (radius < 1) {
+    printf("ERROR: Stencil radius %d should be positive\n", radius);
+    exit(EXIT_FAILURE);
+  }
+
+  if (2*radius +1 > n) {
+    printf("ERROR: Stencil radius %d exceeds grid size %ld\n", radius, n);
+    exit(EXIT_FAILURE);
+  }
+
+  tile_env = getenv("PRK_TILE");
+  tile = tile_env ? atol(tile_env) : 0;
+  if (tile < 0) {
+    printf("ERROR: PRK_TILE must be non-negative: %ld\n", tile);
+    exit(EXIT_FAILURE);
+  }
+  /* blocks that span the interior rows are kept whole                          */
+  if (tile >= n-2*radius) tile = 0;
+
+  partitioner = prk_tbb_partitioner_from_env();
+  if (partitioner == PRK_TBB_UNKNOWN) {
+    printf("ERROR: PRK_PARTITIONER must be auto, simple, static or affinity\n");
+    exit(EXIT_FAILURE);
+  }
+
+  prk_tbb_arena arena(nthread_input);
+  prk_tbb_partitioner stencil_part(partitioner), update_part(partitioner);
+
+  /* a vectorized row kernel only applies to whole rows                         */
+  row = tile ? NULL : prk_stencil_simd_dtype(star);
+
+  total_length = n*n*sizeof(DTYPE);
+  in     = (DTYPE *) prk_malloc(total_length);
+  out    = (DTYPE *) prk_malloc(total_length);
+  weight = (DTYPE *) prk_malloc((2*radius+1)*(2*radius+1)*sizeof(DTYPE));
+  if (!in || !out || !weight) {
+    printf("ERROR: could not allocate space for input or output array: %ld\n",
+           total_length);
+    exit(EXIT_FAILURE);
+  }
+
+  /* fill the stencil weights to reflect a discrete divergence operator         */
+  for (jj=-radius; jj<=radius; jj++) for (ii=-radius; ii<=radius; ii++)
+    WEIGHT(ii,jj) = (DTYPE) 0.0;
+  if (star) {
+    stencil_size = 4*radius+1;
+    for (ii=1; ii<=radius; ii++) {
+      WEIGHT(0, ii) = WEIGHT( ii,0) =  (DTYPE) (1.0/(2.0*ii*radius));
+      WEIGHT(0,-ii) = WEIGHT(-ii,0) = -(DTYPE) (1.0/(2.0*ii*radius));
+    }
+  }
+  else {
+    stencil_size = (2*radius+1)*(2*radius+1);
+    for (jj=1; jj<=radius; jj++) {
+      for (ii=-jj+1; ii<jj; ii++) {
+        WEIGHT(ii,jj)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(ii,-jj) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(jj,ii)  =  (DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+        WEIGHT(-jj,ii) = -(DTYPE) (1.0/(4.0*jj*(2.0*jj-1)*radius));
+      }
+      WEIGHT(jj,jj)    =  (DTYPE) (1.0/(4.0*jj*radius));
+      WEIGHT(-jj,-jj)  = -(DTYPE) (1.0/(4.0*jj*radius));
+    }
+  }
+
+  f_active_points = (DTYPE) (n-2*radius)*(DTYPE) (n-2*radius);
+
+  printf("Number of threads     = %d\n", arena.concurrency());
+  printf("Grid size             = %ld\n", n);
+  printf("Radius of stencil     = %d\n", radius);
+  printf("Type of stencil       = %s\n", star ? "star" : "compact");
+#if DOUBLE
+  printf("Data type             = double precision\n");
+#else
+  printf("Data type             = single precision\n");
+#endif
+  if (tile)
+  printf("Tile size             = %ld\n", tile);
+  else
+  printf("Untiled\n");
+  printf("Partitioner           = %s\n", stencil_part.name());
+  printf("SIMD micro-kernel     = %s\n", row ? prk_stencil_simd_isa() : "scalar");
+  printf("Number of iterations  = %d\n", iterations);
+
+  /* the rows of the grid, and the blocks of its interior (j outer, i inner)   */
+  tbb::blocked_range<long>   rows(0, n), interior(radius, n-radius);
+  tbb::blocked_range2d<long> blocks(radius, n-radius, tile ? tile : 1,
+                                    radius, n-radius, tile ? tile : n-2*radius);
+
+  arena.execute([&]{
+
+  /* intialize the input and output arrays                                     */
+  tbb::parallel_for(rows, [=](const tbb::blocked_range<long> & r) {
+    for (long j=r.begin(); j<r.end(); j++)
+      for (long i=0; i<n; i++) {
+        IN(i,j)  = COEFX*i+COEFY*j;
+        OUT(i,j) = (DTYPE)0.0;
+      }
+  }, tbb::static_partitioner());
+
+  for (iter = 0; iter<=iterations; iter++){
+
+    /* start timer after a warmup iteration                                    */
+    if (iter == 1) stencil_time = wtime();
+
+    /* Apply the stencil operator                                              */
+    stencil_part.parallel_for(blocks, [=](const tbb::blocked_range2d<long> & r) {
+      for (long j=r.rows().begin(); j<r.rows().end(); j++)
+        if (row)       row(n, j, radius, weight, in, out);
+        else if (star) star_part(n, j, r.cols().begin(), r.cols().end(),
+                                 radius, weight, in, out);
+        else           compact_part(n, j, r.cols().begin(), r.cols().end(),
+                                    radius, weight, in, out);
+    });
+
+    /* add constant to solution to force refresh of neighbor data, if any       */
+    update_part.parallel_for(rows, [=](const tbb::blocked_range<long> & r) {
+      for (long j=r.begin(); j<r.end(); j++)
+        for (long i=0; i<n; i++) IN(i,j) += 1.0;
+    });
+
+  } /* end of iterations                                                        */
+
+  stencil_time = wtime() - stencil_time;
+
+  });
+
+  /* compute L1 norm                                                            */
+  norm = tbb::parallel_reduce(interior, (DTYPE) 0.0,
+                              [=](const tbb::blocked_range<long> & r, DTYPE sum) {
+    for (long j=r.begin(); j<r.end(); j++)
+      for (long i=radius; i<n-radius; i++) sum += (DTYPE)ABS(OUT(i,j));
+    return sum;
+  }, std::plus<DTYPE>());
+
+  norm /= f_active_points;
+
+  /*******************************************************************************
+  ** Analyze and output results.
+  ********************************************************************************/
+
+/* verify correctness                                                            */
+  reference_norm = (DTYPE) (iterations+1) * (COEFX + COEFY);
+  if (ABS(norm-reference_norm) > EPSILON) {
+    printf("ERROR: L1 norm = " FSTR ", Reference L1 norm = " FSTR "\n",
+           norm, reference_norm);
+    exit(EXIT_FAILURE);
+  }
+  else {
+    printf("Solution validates\n");
+#if VERBOSE
+    printf("Reference L1 norm = " FSTR ", L1 norm = " FSTR "\n", 
+           reference_norm, norm);
+#endif
+  }
+
+  flops = (DTYPE) (2*stencil_size+1) * f_active_points;
+  avgtime = stencil_time/iterations;
+  printf("Rate (MFlops/s): " FSTR "  Avg time (s): %lf\n",
+         1.0E-06 * flops/avgtime, avgtime);
+
+  exit(EXIT_SUCCESS);
+}
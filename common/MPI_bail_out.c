@@ -41,7 +41,8 @@ Arguments: error code (zero for no error).
 Returns:   nothing, but the program terminates with a nonzero exit status
 
 Notes:     This function must be called by all MPI processes in
-           MPI_COMM_WORLD
+           MPI_COMM_WORLD; a progress thread (prk_progress.h) is
+           stopped before MPI_Finalize
  
 History:   Written by Rob Van der Wijngaart, January 2006
 
@@ -49,12 +50,18 @@ History:   Written by Rob Van der Wijngaart, January 2006
 
 #include <mpi.h>
 #include <par-res-kern_general.h>
+#if defined(MPI)
+  #include <prk_progress.h>
+#endif
 
 void bail_out(int error) {
 
   int error_tot;
   MPI_Allreduce(&error, &error_tot, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
   if (error_tot != 0) {
+#if defined(MPI)
+    prk_progress_stop();
+#endif
     MPI_Finalize();
     exit(EXIT_FAILURE);
   }
@@ -0,0 +1,298 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      dgemm_simd
+
+Purpose:   Packed, register-blocked matrix multiplication for the DGEMM
+           kernels, and the selection of its micro-kernel at startup.
+           See include/prk_dgemm_simd.h for usage.
+
+Functions: prk_dgemm_simd:       micro-kernel for the selected
+                                 instruction set
+           prk_dgemm_blocking:   cache blocking, from the defaults of the
+                                 micro-kernel and PRK_DGEMM_BLOCKING
+           prk_dgemm_workspace:  size of the packing buffers
+           prk_dgemm_packed:     C += A x B with packed operands
+           pack_A, pack_B:       copy blocks of A and B into micro-panels
+           select_isa:           pick the best instruction set that the
+                                 CPU supports and PRK_SIMD allows
+
+Notes:     The vector micro-kernels are in dgemm_simd.incl, which is
+           included once per instruction set.  As in transpose_simd.c,
+           they are compiled with target attributes, so that no special
+           compiler flags are needed and the binary runs on CPUs without
+           these extensions.  Elsewhere only the plain C micro-kernel is
+           available.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_dgemm_simd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define PRK_SIMD_X86 1
+  #include <immintrin.h>
+#endif
+
+enum { ISA_UNSET, ISA_SCALAR, ISA_AVX2, ISA_AVX512 };
+
+static int isa = ISA_UNSET;
+
+/* plain C micro-kernel; the 16 accumulators are scalars                  */
+static void ukernel_scalar(long kc, const double * RESTRICT Ap,
+                           const double * RESTRICT Bp,
+                           double * RESTRICT C, long ldc) {
+  double c[4][4];
+  long   p;
+  int    i, j;
+
+  for (j=0; j<4; j++) for (i=0; i<4; i++) c[j][i] = C[i+ldc*j];
+  for (p=0; p<kc; p++) {
+    for (j=0; j<4; j++) for (i=0; i<4; i++) c[j][i] += Ap[i]*Bp[j];
+    Ap += 4;
+    Bp += 4;
+  }
+  for (j=0; j<4; j++) for (i=0; i<4; i++) C[i+ldc*j] = c[j][i];
+}
+
+#if PRK_SIMD_X86
+
+#define TARGET       __attribute__((target("avx2,fma")))
+#define VEC          __m256d
+#define VLEN         4
+#define NR           6
+#define LOADU(p)     _mm256_loadu_pd(p)
+#define STOREU(p,v)  _mm256_storeu_pd(p,v)
+#define SET1(x)      _mm256_set1_pd(x)
+#define FMA(a,b,c)   _mm256_fmadd_pd(a,b,c)
+#define NAME         ukernel_avx2
+#include "dgemm_simd.incl"
+#undef TARGET
+#undef VEC
+#undef VLEN
+#undef NR
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+
+#define TARGET       __attribute__((target("avx512f")))
+#define VEC          __m512d
+#define VLEN         8
+#define NR           8
+#define LOADU(p)     _mm512_loadu_pd(p)
+#define STOREU(p,v)  _mm512_storeu_pd(p,v)
+#define SET1(x)      _mm512_set1_pd(x)
+#define FMA(a,b,c)   _mm512_fmadd_pd(a,b,c)
+#define NAME         ukernel_avx512
+#include "dgemm_simd.incl"
+#undef TARGET
+#undef VEC
+#undef VLEN
+#undef NR
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+
+#endif /* PRK_SIMD_X86 */
+
+/* KC x NR doubles of B fill half of a 32 KB L1, MC x KC doubles of A
+   about 200 KB of L2, and KC x NC doubles of B 8 MB of L3               */
+static const prk_dgemm_kernel_t kernels[] = {
+  {"",       0,  0,   0,   0,    0, NULL},
+  {"scalar", 4,  4,  64, 256, 4096, ukernel_scalar},
+#if PRK_SIMD_X86
+  {"avx2",   8,  6,  96, 256, 4080, ukernel_avx2},
+  {"avx512", 16, 8, 144, 256, 4080, ukernel_avx512}
+#endif
+};
+
+static int supported(int which)
+{
+    switch (which) {
+      case ISA_SCALAR: return 1;
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return __builtin_cpu_supports("avx2") &&
+                              __builtin_cpu_supports("fma");
+      case ISA_AVX512: return __builtin_cpu_supports("avx512f");
+#endif
+      default:         return 0;
+    }
+}
+
+static void select_isa(void)
+{
+    char * env = getenv("PRK_SIMD");
+    int    which;
+
+    if (isa != ISA_UNSET) return;
+    if (env != NULL && *env != '\0') {
+        for (which=ISA_SCALAR; which<=ISA_AVX512; which++)
+            if (supported(which) && !strcmp(env, kernels[which].isa)) break;
+        if (which <= ISA_AVX512) {
+            isa = which;
+            return;
+        }
+        printf("WARNING: PRK_SIMD=%s is not available, selecting automatically\n", env);
+    }
+    for (which=ISA_AVX512; which>ISA_SCALAR; which--) if (supported(which)) break;
+    isa = which;
+}
+
+const prk_dgemm_kernel_t * prk_dgemm_simd(void)
+{
+    select_isa();
+    return &kernels[isa];
+}
+
+void prk_dgemm_blocking(const prk_dgemm_kernel_t * kernel, int * blocking)
+{
+    char * env = getenv("PRK_DGEMM_BLOCKING");
+    int    mc = 0, kc = 0, nc = 0;
+
+#ifdef DGEMM_MC
+    mc = DGEMM_MC;
+#endif
+#ifdef DGEMM_KC
+    kc = DGEMM_KC;
+#endif
+#ifdef DGEMM_NC
+    nc = DGEMM_NC;
+#endif
+    if (env != NULL && *env != '\0') {
+        int emc = 0, ekc = 0, enc = 0;
+        if (sscanf(env, "%d,%d,%d", &emc, &ekc, &enc) < 1 ||
+            emc < 0 || ekc < 0 || enc < 0) {
+            printf("WARNING: ignoring PRK_DGEMM_BLOCKING=%s\n", env);
+        }
+        else {
+            if (emc > 0) mc = emc;
+            if (ekc > 0) kc = ekc;
+            if (enc > 0) nc = enc;
+        }
+    }
+    if (mc <= 0) mc = kernel->mc;
+    if (kc <= 0) kc = kernel->kc;
+    if (nc <= 0) nc = kernel->nc;
+    /* whole micro-panels only                                            */
+    blocking[0] = (mc+kernel->mr-1)/kernel->mr*kernel->mr;
+    blocking[1] = kc;
+    blocking[2] = (nc+kernel->nr-1)/kernel->nr*kernel->nr;
+}
+
+size_t prk_dgemm_workspace(const prk_dgemm_kernel_t * kernel,
+                           const int * blocking)
+{
+    return (size_t) blocking[0]*blocking[1] +
+           (size_t) blocking[1]*blocking[2] +
+           (size_t) kernel->mr*kernel->nr;
+}
+
+/* copy the mb x kb block of A into micro-panels of mr rows; the element
+   (i,p) of panel ir goes to Ap[ir*kb+p*mr+i], and missing rows are 0    */
+static void pack_A(long mb, long kb, int mr, const double * RESTRICT A,
+                   long lda, double * RESTRICT Ap)
+{
+    long ir, i, p, m;
+
+    for (ir=0; ir<mb; ir+=mr) {
+        m = MIN(mr, mb-ir);
+        for (p=0; p<kb; p++) {
+            const double * RESTRICT a = &A[ir+lda*p];
+            for (i=0; i<m;  i++) Ap[i] = a[i];
+            for (   ; i<mr; i++) Ap[i] = 0.0;
+            Ap += mr;
+        }
+    }
+}
+
+/* copy the kb x nb panel of B into micro-panels of nr columns; the
+   element (p,j) of panel jr goes to Bp[jr*kb+p*nr+j]                    */
+static void pack_B(long kb, long nb, int nr, const double * RESTRICT B,
+                   long ldb, double * RESTRICT Bp)
+{
+    long jr, j, p, n;
+
+    for (jr=0; jr<nb; jr+=nr) {
+        n = MIN(nr, nb-jr);
+        for (p=0; p<kb; p++) {
+            for (j=0; j<n;  j++) Bp[j] = B[p+ldb*(jr+j)];
+            for (   ; j<nr; j++) Bp[j] = 0.0;
+            Bp += nr;
+        }
+    }
+}
+
+void prk_dgemm_packed(const prk_dgemm_kernel_t * kernel, const int * blocking,
+                      long m, long n, long k,
+                      const double * A, long lda, const double * B, long ldb,
+                      double * C, long ldc, double * work)
+{
+    int      mr = kernel->mr, nr = kernel->nr;
+    long     mc = blocking[0], kc = blocking[1], nc = blocking[2];
+    long     jc, pc, ic, jr, ir, mb, nb, kb, i, j;
+    double * Ap = work;
+    double * Bp = Ap + mc*kc;
+    double * Ct = Bp + kc*nc;
+
+    for (jc=0; jc<n; jc+=nc) {
+        nb = MIN(nc, n-jc);
+        for (pc=0; pc<k; pc+=kc) {
+            kb = MIN(kc, k-pc);
+            pack_B(kb, nb, nr, &B[pc+ldb*jc], ldb, Bp);
+            for (ic=0; ic<m; ic+=mc) {
+                mb = MIN(mc, m-ic);
+                pack_A(mb, kb, mr, &A[ic+lda*pc], lda, Ap);
+                for (jr=0; jr<nb; jr+=nr) for (ir=0; ir<mb; ir+=mr) {
+                    double * c = &C[ic+ir+ldc*(jc+jr)];
+                    if (ir+mr <= mb && jr+nr <= nb) {
+                        kernel->ukernel(kb, Ap+ir*kb, Bp+jr*kb, c, ldc);
+                    }
+                    else {
+                        /* edge tile: compute in scratch, add what is in C */
+                        long mt = MIN(mr, mb-ir), nt = MIN(nr, nb-jr);
+                        for (i=0; i<mr*nr; i++) Ct[i] = 0.0;
+                        kernel->ukernel(kb, Ap+ir*kb, Bp+jr*kb, Ct, mr);
+                        for (j=0; j<nt; j++) for (i=0; i<mt; i++)
+                            c[i+ldc*j] += Ct[i+mr*j];
+                    }
+                }
+            }
+        }
+    }
+}
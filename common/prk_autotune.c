@@ -0,0 +1,131 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_autotune
+
+Purpose:   Cache of tuned kernel parameters.  See include/prk_autotune.h
+           for usage.
+
+Functions: prk_autotune_mode:   tuning mode requested in PRK_AUTOTUNE
+           prk_autotune_lookup: cached configuration for a problem
+           prk_autotune_store:  append a configuration to the cache
+
+Notes:     Lines of the cache file have the form
+             <host> <kernel> <problem> <n> <value_1> ... <value_n> <seconds>
+           where <seconds> is the trial time of the stored configuration,
+           kept for information only.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE
+#endif
+
+#include <par-res-kern_general.h>
+#include <prk_autotune.h>
+
+static void cache_path(char * path, size_t size)
+{
+    char * file = getenv("PRK_AUTOTUNE_CACHE");
+    char * home = getenv("HOME");
+
+    if (file != NULL && *file != '\0') snprintf(path, size, "%s", file);
+    else if (home != NULL)             snprintf(path, size, "%s/.prk_autotune", home);
+    else                               snprintf(path, size, ".prk_autotune");
+}
+
+static void host_name(char * host, size_t size)
+{
+    if (gethostname(host, size) != 0) snprintf(host, size, "unknown");
+    host[size-1] = '\0';
+}
+
+int prk_autotune_mode(void)
+{
+    char * temp = getenv("PRK_AUTOTUNE");
+
+    if (temp == NULL || *temp == '\0' || !strcmp(temp,"0")) return PRK_AUTOTUNE_OFF;
+    if (!strcmp(temp,"refresh"))                           return PRK_AUTOTUNE_REFRESH;
+    return PRK_AUTOTUNE_CACHED;
+}
+
+int prk_autotune_lookup(const char * kernel, const char * problem, int n, int * values)
+{
+    char   path[1024], host[256], line[1024];
+    char   h[256], k[64], p[512];
+    int    found = 0, count, i, offset, used, v[PRK_AUTOTUNE_MAXVALUES];
+    FILE * f;
+
+    if (prk_autotune_mode() != PRK_AUTOTUNE_CACHED) return 0;
+    cache_path(path, sizeof(path));
+    host_name(host, sizeof(host));
+    f = fopen(path, "r");
+    if (f == NULL) return 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "%255s %63s %511s %d%n", h, k, p, &count, &offset) != 4) continue;
+        if (strcmp(h,host) || strcmp(k,kernel) || strcmp(p,problem) || count != n) continue;
+        if (n > PRK_AUTOTUNE_MAXVALUES) continue;
+        for (i=0; i<n; i++) {
+            if (sscanf(line+offset, "%d%n", &v[i], &used) != 1) break;
+            offset += used;
+        }
+        if (i < n) continue;
+        for (i=0; i<n; i++) values[i] = v[i];
+        found = 1;
+    }
+    fclose(f);
+    return found;
+}
+
+void prk_autotune_store(const char * kernel, const char * problem, int n, 
+                        const int * values, double seconds)
+{
+    char   path[1024], host[256];
+    int    i;
+    FILE * f;
+
+    cache_path(path, sizeof(path));
+    host_name(host, sizeof(host));
+    f = fopen(path, "a");
+    if (f == NULL) {
+        printf("WARNING: could not write autotuning cache %s\n", path);
+        return;
+    }
+    fprintf(f, "%s %s %s %d", host, kernel, problem, n);
+    for (i=0; i<n; i++) fprintf(f, " %d", values[i]);
+    fprintf(f, " %e\n", seconds);
+    fclose(f);
+}
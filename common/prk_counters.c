@@ -0,0 +1,269 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_counters
+
+Purpose:   Count hardware events in the timed region of a kernel.  See
+           include/prk_counters.h for the events and calling sequence.
+
+Functions: prk_counters_init:     open the counters requested in PRK_COUNTERS
+           prk_counters_num:      number of counters that could be opened
+           prk_counters_name:     name of a counter
+           prk_counters_start:    reset and enable all counters
+           prk_counters_stop:     disable all counters
+           prk_counters_read:     values, summed over threads and scaled
+                                  for multiplexing
+           prk_counters_finalize: close all counters
+
+Notes:     Only Linux is supported; elsewhere no counter is ever opened.
+           Opening fails if /proc/sys/kernel/perf_event_paranoid forbids
+           user-space measurement; a warning is printed in that case.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#if defined(__linux__)
+  #ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+  #endif
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <linux/perf_event.h>
+#endif
+
+#include <par-res-kern_general.h>
+#include <prk_counters.h>
+#if defined(_OPENMP)
+  #include <omp.h>
+#endif
+
+static int num_events  = 0;   /* number of counters opened per thread        */
+static int num_threads = 0;   /* number of threads with their own counters  */
+static int initialized = 0;
+static int * fds       = NULL;/* fds[thread*PRK_COUNTERS_MAX+event]          */
+static const char * names[PRK_COUNTERS_MAX];
+
+#if defined(__linux__)
+
+#define HW_CACHE(cache,op,result) \
+  ((PERF_COUNT_HW_CACHE_##cache) | (PERF_COUNT_HW_CACHE_OP_##op << 8) | \
+   (PERF_COUNT_HW_CACHE_RESULT_##result << 16))
+
+typedef struct {
+  const char * name;
+  uint32_t     type;
+  uint64_t     config;
+} event_t;
+
+static const event_t known_events[] = {
+  {"cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {"instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {"llc-loads",     PERF_TYPE_HW_CACHE, HW_CACHE(LL,READ,ACCESS)},
+  {"llc-misses",    PERF_TYPE_HW_CACHE, HW_CACHE(LL,READ,MISS)},
+  {"dtlb-misses",   PERF_TYPE_HW_CACHE, HW_CACHE(DTLB,READ,MISS)},
+  {"itlb-misses",   PERF_TYPE_HW_CACHE, HW_CACHE(ITLB,READ,MISS)},
+  {"node-loads",    PERF_TYPE_HW_CACHE, HW_CACHE(NODE,READ,ACCESS)},
+  {"node-misses",   PERF_TYPE_HW_CACHE, HW_CACHE(NODE,READ,MISS)},
+  {"page-faults",   PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+  {"task-clock",    PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}
+};
+#define NUM_KNOWN_EVENTS (int)(sizeof(known_events)/sizeof(known_events[0]))
+
+static const char * default_events = "cycles,instructions,llc-misses,dtlb-misses,node-misses";
+
+static const event_t * selected[PRK_COUNTERS_MAX];
+
+/* counts the calling thread and, through inheritance, threads it creates */
+static int open_event(const event_t * e) {
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size           = sizeof(attr);
+  attr.type           = e->type;
+  attr.config         = e->config;
+  attr.disabled       = 1;
+  attr.inherit        = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void open_thread_events(int thread) {
+  int e;
+  for (e=0; e<num_events; e++) {
+    fds[thread*PRK_COUNTERS_MAX+e] = open_event(selected[e]);
+  }
+}
+
+int prk_counters_init(void) {
+
+  char * request, * list, * token;
+  int    e, t, k, ok;
+
+  if (initialized) return num_events;
+  initialized = 1;
+
+  request = getenv("PRK_COUNTERS");
+  if (request == NULL || *request == '\0' || !strcmp(request,"0")) return 0;
+  if (!strcmp(request,"1") || !strcmp(request,"default")) request = (char *) default_events;
+
+  list = (char *) malloc(strlen(request)+1);
+  if (list == NULL) return 0;
+  strcpy(list, request);
+  for (token=strtok(list,","); token!=NULL; token=strtok(NULL,",")) {
+    for (k=0; k<NUM_KNOWN_EVENTS; k++) if (!strcmp(token,known_events[k].name)) break;
+    if (k == NUM_KNOWN_EVENTS) {
+      printf("WARNING: unknown hardware counter %s ignored\n", token);
+    }
+    else if (num_events == PRK_COUNTERS_MAX) {
+      printf("WARNING: at most %d hardware counters; %s ignored\n", PRK_COUNTERS_MAX, token);
+    }
+    else selected[num_events++] = &known_events[k];
+  }
+  free(list);
+  if (num_events == 0) return 0;
+
+#if defined(_OPENMP)
+  num_threads = omp_get_max_threads();
+#else
+  num_threads = 1;
+#endif
+  fds = (int *) malloc(num_threads*PRK_COUNTERS_MAX*sizeof(int));
+  if (fds == NULL) {
+    num_events = 0;
+    return 0;
+  }
+  for (k=0; k<num_threads*PRK_COUNTERS_MAX; k++) fds[k] = -1;
+
+#if defined(_OPENMP)
+  #pragma omp parallel num_threads(num_threads)
+  {
+    open_thread_events(omp_get_thread_num());
+  }
+#else
+  open_thread_events(0);
+#endif
+
+  /* keep only events that could be opened on every thread                */
+  for (k=0, e=0; e<num_events; e++) {
+    for (ok=1, t=0; t<num_threads; t++) ok = ok && fds[t*PRK_COUNTERS_MAX+e] >= 0;
+    if (!ok) {
+      printf("WARNING: hardware counter %s not available (check perf_event_paranoid)\n",
+             selected[e]->name);
+      for (t=0; t<num_threads; t++) {
+        if (fds[t*PRK_COUNTERS_MAX+e] >= 0) close(fds[t*PRK_COUNTERS_MAX+e]);
+      }
+      continue;
+    }
+    for (t=0; t<num_threads; t++) fds[t*PRK_COUNTERS_MAX+k] = fds[t*PRK_COUNTERS_MAX+e];
+    selected[k] = selected[e];
+    names[k]    = selected[e]->name;
+    k++;
+  }
+  for (t=0; t<num_threads; t++) for (e=k; e<PRK_COUNTERS_MAX; e++) {
+    fds[t*PRK_COUNTERS_MAX+e] = -1;
+  }
+  num_events = k;
+  return num_events;
+}
+
+static void control(unsigned long request) {
+  int t, e;
+  for (t=0; t<num_threads; t++) for (e=0; e<num_events; e++) {
+    ioctl(fds[t*PRK_COUNTERS_MAX+e], request, 0);
+  }
+}
+
+void prk_counters_start(void) {
+  if (num_events == 0) return;
+  control(PERF_EVENT_IOC_RESET);
+  control(PERF_EVENT_IOC_ENABLE);
+}
+
+void prk_counters_stop(void) {
+  if (num_events == 0) return;
+  control(PERF_EVENT_IOC_DISABLE);
+}
+
+void prk_counters_read(uint64_t * values) {
+  int      t, e;
+  uint64_t buf[3];  /* value, time enabled, time running                  */
+
+  for (e=0; e<num_events; e++) {
+    values[e] = 0;
+    for (t=0; t<num_threads; t++) {
+      if (read(fds[t*PRK_COUNTERS_MAX+e], buf, sizeof(buf)) != sizeof(buf)) continue;
+      /* scale up if the kernel had to multiplex counters                 */
+      if (buf[2] > 0 && buf[2] < buf[1])
+        buf[0] = (uint64_t) ((double) buf[0] * (double) buf[1] / (double) buf[2]);
+      values[e] += buf[0];
+    }
+  }
+}
+
+void prk_counters_finalize(void) {
+  int k;
+  for (k=0; fds!=NULL && k<num_threads*PRK_COUNTERS_MAX; k++) {
+    if (fds[k] >= 0) close(fds[k]);
+  }
+  free(fds);
+  fds        = NULL;
+  num_events = 0;
+}
+
+#else /* !__linux__ */
+
+int  prk_counters_init(void) {
+  char * request = getenv("PRK_COUNTERS");
+  if (!initialized && request != NULL && *request != '\0' && strcmp(request,"0"))
+    printf("WARNING: hardware counters are only supported on Linux\n");
+  initialized = 1;
+  return 0;
+}
+void prk_counters_start(void)         { }
+void prk_counters_stop(void)          { }
+void prk_counters_read(uint64_t * v)  { (void) v; }
+void prk_counters_finalize(void)      { }
+
+#endif
+
+int prk_counters_num(void) {
+  return num_events;
+}
+
+const char * prk_counters_name(int e) {
+  return (e>=0 && e<num_events) ? names[e] : "";
+}
@@ -0,0 +1,289 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_energy
+
+Purpose:   Measure the energy used in the timed region of a kernel.  See
+           include/prk_energy.h for the sources and calling sequence.
+
+Functions: prk_energy_init:     open the sources requested in PRK_ENERGY
+           prk_energy_enabled:  nonzero if any rank measures energy
+           prk_energy_readers:  1 if this process reads its node, else 0
+           prk_energy_sources:  description of the sources read
+           prk_energy_start:    take the first sample
+           prk_energy_sample:   accumulate, if a second has passed
+           prk_energy_stop:     take the last sample
+           prk_energy_joules:   energy between start and stop
+           prk_energy_finalize: close all sources
+
+Notes:     RAPL is read only on Linux; GPUs only with -DPRK_NVML.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_energy.h>
+
+#if defined(MPI) || defined(FG_MPI) || defined(ADAPTIVE_MPI)
+  #include <mpi.h>
+  #define PRK_ENERGY_MPI 1
+#endif
+
+#ifdef PRK_NVML
+  #include <nvml.h>
+  #define PRK_ENERGY_MAX_GPUS 16
+#endif
+
+#define PRK_ENERGY_MAX_DOMAINS 32
+#define PRK_ENERGY_PATH_LEN    96
+#define POWERCAP "/sys/class/powercap/intel-rapl"
+
+static int    enabled      = 0;   /* nonzero if any rank measures energy      */
+static int    reader       = 0;   /* nonzero if this process reads its node   */
+static int    running      = 0;   /* nonzero between start and stop           */
+static double joules       = 0.0; /* energy accumulated since start           */
+static double last_sample  = 0.0; /* time of the most recent sample           */
+static char   sources[128] = "";
+
+/* RAPL domains: energy_uj file, range of the counter and last value (J)  */
+static int    num_domains  = 0;
+static char   domain_path[PRK_ENERGY_MAX_DOMAINS][PRK_ENERGY_PATH_LEN];
+static double domain_range[PRK_ENERGY_MAX_DOMAINS];
+static double domain_last[PRK_ENERGY_MAX_DOMAINS];
+
+#ifdef PRK_NVML
+static unsigned int       num_gpus = 0;
+static nvmlDevice_t       gpus[PRK_ENERGY_MAX_GPUS];
+static unsigned long long gpu_last[PRK_ENERGY_MAX_GPUS];  /* mJ          */
+#endif
+
+/* value of a file of microjoules in joules, or -1 if it cannot be read  */
+static double read_joules(const char * path) {
+  FILE * fp = fopen(path, "r");
+  unsigned long long uj;
+  int    ok;
+  if (!fp) return -1.0;
+  ok = fscanf(fp, "%llu", &uj) == 1;
+  fclose(fp);
+  return ok ? 1.0E-06*uj : -1.0;
+}
+
+static int read_name(const char * zone, char * name, int len) {
+  char   path[PRK_ENERGY_PATH_LEN];
+  FILE * fp;
+  int    ok;
+  snprintf(path, sizeof(path), "%s/name", zone);
+  fp = fopen(path, "r");
+  if (!fp) return 0;
+  ok = fgets(name, len, fp) != NULL;
+  fclose(fp);
+  if (ok) name[strcspn(name, "\n")] = '\0';
+  return ok;
+}
+
+static void add_domain(const char * zone) {
+  char path[PRK_ENERGY_PATH_LEN];
+  double range;
+  if (num_domains == PRK_ENERGY_MAX_DOMAINS) return;
+  snprintf(path, sizeof(path), "%s/max_energy_range_uj", zone);
+  range = read_joules(path);
+  snprintf(domain_path[num_domains], PRK_ENERGY_PATH_LEN, "%s/energy_uj", zone);
+  if (range <= 0.0 || read_joules(domain_path[num_domains]) < 0.0) return;
+  domain_range[num_domains++] = range;
+}
+
+/* packages and their DRAM domains; core and uncore are part of a package
+   and psys covers the packages, so neither is counted                    */
+static int open_rapl(void) {
+  char zone[PRK_ENERGY_PATH_LEN], sub[PRK_ENERGY_PATH_LEN], name[32];
+  int  p, d, found = 0;
+
+#if defined(__linux__)
+  for (p=0; p<64; p++) {
+    snprintf(zone, sizeof(zone), POWERCAP ":%d", p);
+    if (!read_name(zone, name, sizeof(name))) continue;
+    found = 1;
+    if (!strcmp(name, "psys")) continue;
+    add_domain(zone);
+    for (d=0; d<16; d++) {
+      snprintf(sub, sizeof(sub), POWERCAP ":%d:%d", p, d);
+      if (read_name(sub, name, sizeof(name)) && !strncmp(name, "dram", 4))
+        add_domain(sub);
+    }
+  }
+#endif
+  if (found && num_domains == 0)
+    printf("WARNING: RAPL energy counters in " POWERCAP "* are not readable\n");
+  return num_domains > 0;
+}
+
+#ifdef PRK_NVML
+static int open_nvml(void) {
+  unsigned int       i, count;
+  unsigned long long mj;
+  if (nvmlInit_v2() != NVML_SUCCESS) return 0;
+  if (nvmlDeviceGetCount_v2(&count) != NVML_SUCCESS) count = 0;
+  for (i=0; i<count && num_gpus<PRK_ENERGY_MAX_GPUS; i++) {
+    /* the energy counter exists on Volta and later GPUs only             */
+    if (nvmlDeviceGetHandleByIndex_v2(i, &gpus[num_gpus]) == NVML_SUCCESS &&
+        nvmlDeviceGetTotalEnergyConsumption(gpus[num_gpus], &mj) == NVML_SUCCESS)
+      num_gpus++;
+  }
+  if (num_gpus == 0) nvmlShutdown();
+  return num_gpus > 0;
+}
+#endif
+
+void prk_energy_init(void) {
+
+  char * env = getenv("PRK_ENERGY");
+  int    all, local = 0, len;
+
+  if (env == NULL || *env == '\0' || !strcmp(env, "0")) return;
+  all = !strcmp(env, "1");
+
+  /* one process per node reads the node                                  */
+  reader = 1;
+#if PRK_ENERGY_MPI && (MPI_VERSION >= 3)
+  {
+    MPI_Comm node;
+    int      node_rank;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+    MPI_Comm_rank(node, &node_rank);
+    MPI_Comm_free(&node);
+    reader = node_rank == 0;
+  }
+#endif
+
+  if (reader) {
+    if ((all || strstr(env, "rapl")) && open_rapl()) {
+      len = strlen(sources);
+      snprintf(sources+len, sizeof(sources)-len, "%sRAPL %d domains",
+               len ? ", " : "", num_domains);
+    }
+#ifdef PRK_NVML
+    if ((all || strstr(env, "nvml")) && open_nvml()) {
+      len = strlen(sources);
+      snprintf(sources+len, sizeof(sources)-len, "%sNVML %u GPUs",
+               len ? ", " : "", num_gpus);
+    }
+#else
+    if (!all && strstr(env, "nvml"))
+      printf("WARNING: PRK_ENERGY=nvml needs a build with NVMLTOP set\n");
+#endif
+    local = num_domains > 0;
+#ifdef PRK_NVML
+    local = local || num_gpus > 0;
+#endif
+    if (!local) reader = 0;
+  }
+
+  enabled = local;
+#if PRK_ENERGY_MPI
+  MPI_Allreduce(&local, &enabled, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+}
+
+int prk_energy_enabled(void) {
+  return enabled;
+}
+
+int prk_energy_readers(void) {
+  return reader;
+}
+
+const char * prk_energy_sources(void) {
+  return sources;
+}
+
+/* accumulate the energy used since the last sample                       */
+static void sample(int first) {
+  double value, delta;
+  int    i;
+
+  for (i=0; i<num_domains; i++) {
+    value = read_joules(domain_path[i]);
+    if (value < 0.0) continue;
+    delta = value - domain_last[i];
+    if (delta < 0.0) delta += domain_range[i];
+    if (!first) joules += delta;
+    domain_last[i] = value;
+  }
+#ifdef PRK_NVML
+  {
+    unsigned int       g;
+    unsigned long long mj;
+    for (g=0; g<num_gpus; g++) {
+      if (nvmlDeviceGetTotalEnergyConsumption(gpus[g], &mj) != NVML_SUCCESS) continue;
+      if (!first) joules += 1.0E-03*(double) (mj - gpu_last[g]);
+      gpu_last[g] = mj;
+    }
+  }
+#endif
+  last_sample = wtime();
+}
+
+void prk_energy_start(void) {
+  if (!reader) return;
+  joules  = 0.0;
+  running = 1;
+  sample(1);
+}
+
+/* RAPL counters wrap after about a minute at full power, so they are
+   sampled at least once a second while the measurement runs              */
+void prk_energy_sample(double now) {
+  if (!running || now - last_sample < 1.0) return;
+  sample(0);
+}
+
+void prk_energy_stop(void) {
+  if (!running) return;
+  sample(0);
+  running = 0;
+}
+
+double prk_energy_joules(void) {
+  return reader ? joules : 0.0;
+}
+
+void prk_energy_finalize(void) {
+#ifdef PRK_NVML
+  if (num_gpus > 0) nvmlShutdown();
+  num_gpus = 0;
+#endif
+  num_domains = 0;
+  running = reader = enabled = 0;
+  sources[0] = '\0';
+}
@@ -0,0 +1,672 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_harness
+
+Purpose:   Record per-iteration times of a kernel, summarize them and
+           write a machine-readable record of the run.  See
+           include/prk_harness.h for the calling sequence.
+
+Functions: prk_harness_init:     set up a harness for a number of iterations
+           prk_harness_param:    record a kernel parameter (key, value)
+           prk_harness_tick:     mark an iteration boundary
+           prk_harness_ticks:    mark the end of several fused iterations
+           prk_harness_elapsed:  time between the first and the last tick
+           prk_harness_stats:    summary statistics of an array of times
+           prk_harness_rate:     work per unit of time per iteration
+           prk_harness_report:   print statistics and write results record
+           prk_harness_finalize: release the harness
+           prk_phase_init:       set up a phase timer
+           prk_phase_report:     print the statistics of a phase timer
+
+Notes:     In MPI builds prk_harness_report must be called by all ranks
+           in MPI_COMM_WORLD; only rank 0 prints and writes the record.
+           In SHMEM builds it is collective over all PEs in the same way,
+           with reductions over symmetric buffers; energy is that of PE
+           0's node.
+           The per-rank report of MPI builds (PRK_STRAGGLERS,
+           PRK_RANK_TIMES) gathers the times of all ranks to rank 0, which
+           needs memory for ranks x iterations doubles there.
+
+History:   Written in October 2026 to replace the timing code duplicated in
+           every kernel.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <prk_harness.h>
+#include <prk_counters.h>
+#include <prk_roofline.h>
+#include <prk_energy.h>
+#include <prk_log.h>
+
+#if defined(MPI) || defined(FG_MPI) || defined(ADAPTIVE_MPI)
+  #include <mpi.h>
+  #include <prk_topology.h>
+  #define PRK_HARNESS_MPI 1
+#endif
+
+#if defined(SHMEM)
+  #include <shmem.h>
+  #include <par-res-kern_shmem.h>
+  #define PRK_HARNESS_SHMEM 1
+#endif
+
+/* length of the host names in the per-rank report                        */
+#define PRK_HARNESS_HOST_LEN 64
+
+void prk_harness_init(prk_harness_t * h, const char * kernel,
+                      const char * model, int iterations) {
+
+  h->kernel   = kernel;
+  h->model    = model;
+  h->capacity = MAX(iterations,1);
+  h->count    = 0;
+  h->ticking  = 0;
+  h->last     = 0.0;
+  h->first    = 0.0;
+  h->nparams  = 0;
+  h->modeled  = 0;
+  h->flops    = h->bytes = h->peak = h->bandwidth = 0.0;
+  h->times    = (double *) malloc(h->capacity*sizeof(double));
+  if (!h->times) {
+    printf("ERROR: could not allocate space for %d iteration times\n",
+           h->capacity);
+    exit(EXIT_FAILURE);
+  }
+  prk_counters_init();
+  prk_energy_init();
+}
+
+void prk_harness_param(prk_harness_t * h, const char * key,
+                       const char * format, ...) {
+
+  va_list args;
+
+  if (h->nparams == PRK_HARNESS_MAX_PARAMS) return;
+  snprintf(h->key[h->nparams], PRK_HARNESS_KEY_LEN, "%s", key);
+  va_start(args, format);
+  vsnprintf(h->value[h->nparams], PRK_HARNESS_VALUE_LEN, format, args);
+  va_end(args);
+  h->nparams++;
+}
+
+void prk_harness_model(prk_harness_t * h, double flops, double bytes) {
+  h->modeled = 1;
+  h->flops   = flops;
+  h->bytes   = bytes;
+}
+
+void prk_harness_tick(prk_harness_t * h) {
+
+  double now;
+
+  if (!h->ticking) prk_log_begin(h);
+  now = wtime();
+  if (!h->ticking) {
+    h->ticking = 1;
+    h->first   = now;
+    prk_counters_start();
+    prk_energy_start();
+  }
+  else if (h->count < h->capacity) {
+    h->times[h->count++] = now - h->last;
+    prk_log_time(h->count-1, now - h->last);
+    if (h->count == h->capacity) {
+      prk_counters_stop();
+      prk_energy_stop();
+    }
+    else prk_energy_sample(now);
+  }
+  h->last = now;
+}
+
+void prk_harness_ticks(prk_harness_t * h, int k) {
+
+  double now = wtime(), t;
+  int    i;
+
+  if (!h->ticking || k <= 1) {
+    prk_harness_tick(h);
+    return;
+  }
+  t = (now - h->last)/k;
+  for (i=0; i<k && h->count < h->capacity; i++) {
+    h->times[h->count++] = t;
+    prk_log_time(h->count-1, t);
+    if (h->count == h->capacity) {
+      prk_counters_stop();
+      prk_energy_stop();
+    }
+  }
+  prk_energy_sample(now);
+  h->last = now;
+}
+
+double prk_harness_elapsed(const prk_harness_t * h) {
+  return h->last - h->first;
+}
+
+static int compare_doubles(const void * a, const void * b) {
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+void prk_harness_stats(const double * times, int count, prk_stats_t * s) {
+
+  int     i;
+  double  * sorted, var;
+
+  s->count = count;
+  s->total = s->avg = s->min = s->median = s->p95 = s->max = s->stddev = 0.0;
+  s->elapsed = 0.0;
+  if (count < 1) return;
+
+  sorted = (double *) malloc(count*sizeof(double));
+  if (!sorted) {
+    printf("ERROR: could not allocate space for iteration statistics\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i=0; i<count; i++) {
+    sorted[i] = times[i];
+    s->total += times[i];
+  }
+  qsort(sorted, count, sizeof(double), compare_doubles);
+
+  s->avg    = s->total/count;
+  s->elapsed = s->total;
+  s->min    = sorted[0];
+  s->max    = sorted[count-1];
+  s->median = (count%2) ? sorted[count/2]
+                        : 0.5*(sorted[count/2-1]+sorted[count/2]);
+  /* nearest-rank percentile                                              */
+  s->p95    = sorted[(95*count+99)/100-1];
+
+  for (var=0.0, i=0; i<count; i++) var += (times[i]-s->avg)*(times[i]-s->avg);
+  s->stddev = sqrt(var/count);
+
+  free(sorted);
+}
+
+/* work per iteration over the elapsed time per iteration                */
+double prk_harness_rate(const prk_stats_t * s, double work) {
+  return s->elapsed > 0.0 ? work*s->count/s->elapsed : 0.0;
+}
+
+/* parameter values that are JSON numbers are written unquoted; strtod()
+   would also accept nan, inf and hexadecimal values, which JSON does not */
+static int is_number(const char * str) {
+  if (*str == '-') str++;
+  if (*str == '0') str++;
+  else if (isdigit((unsigned char) *str)) while (isdigit((unsigned char) *str)) str++;
+  else return 0;
+  if (*str == '.') {
+    str++;
+    if (!isdigit((unsigned char) *str)) return 0;
+    while (isdigit((unsigned char) *str)) str++;
+  }
+  if (*str == 'e' || *str == 'E') {
+    str++;
+    if (*str == '+' || *str == '-') str++;
+    if (!isdigit((unsigned char) *str)) return 0;
+    while (isdigit((unsigned char) *str)) str++;
+  }
+  return *str == '\0';
+}
+
+/* write str as a JSON string, escaping quotes, backslashes and control
+   characters                                                             */
+static void json_string(FILE * fp, const char * str) {
+  fputc('"', fp);
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\')   fprintf(fp, "\\%c", *str);
+    else if ((unsigned char) *str < 0x20) fprintf(fp, "\\u%04x", (unsigned char) *str);
+    else                                 fputc(*str, fp);
+  }
+  fputc('"', fp);
+}
+
+/* fraction of the roofline reached: the time an iteration would take at
+   the bandwidth or peak rate, whichever limits it, over the elapsed time
+   per iteration                                                          */
+static double roofline_fraction(const prk_harness_t * h, const prk_stats_t * s) {
+  double bound = 0.0;
+  if (h->peak <= 0.0 || h->bandwidth <= 0.0 || s->elapsed <= 0.0) return 0.0;
+  bound = MAX(h->flops/h->peak, h->bytes/h->bandwidth);
+  return bound*s->count/s->elapsed;
+}
+
+static void write_json(FILE * fp, const prk_harness_t * h, const double * times,
+                       const prk_stats_t * s, const char * units, double work,
+                       const unsigned long long * counters, double joules) {
+  int i;
+
+  fprintf(fp, "{\"kernel\":");       json_string(fp, h->kernel);
+  fprintf(fp, ",\"model\":");        json_string(fp, h->model);
+  fprintf(fp, ",\"version\":");      json_string(fp, PRKVERSION);
+  fprintf(fp, ",\"timer\":");        json_string(fp, wtime_backend());
+  fprintf(fp, ",\"params\":{");
+  for (i=0; i<h->nparams; i++) {
+    if (i) fprintf(fp, ",");
+    json_string(fp, h->key[i]);
+    fprintf(fp, ":");
+    if (is_number(h->value[i])) fprintf(fp, "%s", h->value[i]);
+    else                        json_string(fp, h->value[i]);
+  }
+  fprintf(fp, "},\"iterations\":%d", s->count);
+  fprintf(fp, ",\"avg\":%.9e,\"min\":%.9e,\"median\":%.9e,\"p95\":%.9e"
+              ",\"max\":%.9e,\"stddev\":%.9e",
+          s->avg, s->min, s->median, s->p95, s->max, s->stddev);
+  fprintf(fp, ",\"elapsed\":%.9e,\"rate\":%.9e,\"rate_units\":",
+          s->elapsed, prk_harness_rate(s, work));
+  json_string(fp, units);
+  fprintf(fp, ",\"times\":[");
+  for (i=0; i<s->count; i++) fprintf(fp, "%s%.9e", i ? "," : "", times[i]);
+  fprintf(fp, "]");
+  if (prk_counters_num() > 0) {
+    fprintf(fp, ",\"counters\":{");
+    for (i=0; i<prk_counters_num(); i++) {
+      fprintf(fp, "%s\"%s\":%llu", i ? "," : "", prk_counters_name(i), counters[i]);
+    }
+    fprintf(fp, "}");
+  }
+  if (h->modeled) {
+    fprintf(fp, ",\"flops\":%.9e,\"bytes\":%.9e,\"intensity\":%.9e",
+            h->flops, h->bytes, h->bytes > 0.0 ? h->flops/h->bytes : 0.0);
+    if (h->peak > 0.0) {
+      fprintf(fp, ",\"peak_flops\":%.9e,\"bandwidth\":%.9e"
+                  ",\"roofline_fraction\":%.9e",
+              h->peak, h->bandwidth, roofline_fraction(h, s));
+    }
+  }
+  if (prk_energy_enabled()) {
+    fprintf(fp, ",\"energy\":%.9e,\"power\":%.9e",
+            joules, s->total > 0.0 ? joules/s->total : 0.0);
+  }
+  fprintf(fp, "}\n");
+}
+
+static void write_csv(FILE * fp, const prk_harness_t * h, const double * times,
+                      const prk_stats_t * s, const char * units, double work,
+                      const unsigned long long * counters, double joules) {
+  int i;
+
+  /* write a header only when starting a new file                        */
+  fseek(fp, 0, SEEK_END);
+  if (ftell(fp) == 0) {
+    fprintf(fp, "kernel,model,version,timer,params,iterations,avg,min,median,p95,"
+                "max,stddev,elapsed,rate,rate_units,times,counters,flops,bytes,intensity,"
+                "peak_flops,bandwidth,roofline_fraction,energy,power\n");
+  }
+  fprintf(fp, "%s,%s,%s,%s,", h->kernel, h->model, PRKVERSION, wtime_backend());
+  for (i=0; i<h->nparams; i++) {
+    fprintf(fp, "%s%s=%s", i ? ";" : "", h->key[i], h->value[i]);
+  }
+  fprintf(fp, ",%d,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e,%s,", s->count,
+          s->avg, s->min, s->median, s->p95, s->max, s->stddev,
+          s->elapsed, prk_harness_rate(s, work), units);
+  for (i=0; i<s->count; i++) fprintf(fp, "%s%.9e", i ? ";" : "", times[i]);
+  fprintf(fp, ",");
+  for (i=0; i<prk_counters_num(); i++) {
+    fprintf(fp, "%s%s=%llu", i ? ";" : "", prk_counters_name(i), counters[i]);
+  }
+  if (h->modeled) {
+    fprintf(fp, ",%.9e,%.9e,%.9e", h->flops, h->bytes,
+            h->bytes > 0.0 ? h->flops/h->bytes : 0.0);
+  }
+  else fprintf(fp, ",,,");
+  if (h->modeled && h->peak > 0.0) {
+    fprintf(fp, ",%.9e,%.9e,%.9e", h->peak, h->bandwidth, roofline_fraction(h, s));
+  }
+  else fprintf(fp, ",,,");
+  if (prk_energy_enabled()) {
+    fprintf(fp, ",%.9e,%.9e", joules, s->total > 0.0 ? joules/s->total : 0.0);
+  }
+  else fprintf(fp, ",,");
+  fprintf(fp, "\n");
+}
+
+#if PRK_HARNESS_SHMEM
+/* out[i] = max (or sum) over all PEs of in[i], for i<n; every PE must pass
+   the same n.  Collective over all PEs                                   */
+static void shmem_reduce(double * out, const double * in, int n, int max) {
+
+  int    nwrk = MAX(n/2+1, PRK_SHMEM_REDUCE_MIN_WRKDATA_SIZE), i;
+  double * buf  = (double *) prk_shmem_align(prk_get_alignment(), (2*n+nwrk)*sizeof(double));
+  long   * sync = (long *)   prk_shmem_align(prk_get_alignment(),
+                                             PRK_SHMEM_REDUCE_SYNC_SIZE*sizeof(long));
+
+  if (!buf || !sync) {
+    printf("ERROR: PE %d could not allocate symmetric space for the report\n",
+           prk_shmem_my_pe());
+    exit(EXIT_FAILURE);
+  }
+  for (i=0; i<PRK_SHMEM_REDUCE_SYNC_SIZE; i++) sync[i] = PRK_SHMEM_SYNC_VALUE;
+  for (i=0; i<n; i++) buf[i] = in[i];
+  shmem_barrier_all();
+  if (max) shmem_double_max_to_all(buf+n, buf, n, 0, 0, prk_shmem_n_pes(), buf+2*n, sync);
+  else     shmem_double_sum_to_all(buf+n, buf, n, 0, 0, prk_shmem_n_pes(), buf+2*n, sync);
+  for (i=0; i<n; i++) out[i] = buf[n+i];
+  shmem_barrier_all();
+  prk_shmem_free(sync);
+  prk_shmem_free(buf);
+}
+#endif
+
+#if PRK_HARNESS_MPI
+/* Gathers the iteration times of all ranks to rank 0.  With PRK_STRAGGLERS
+   set, prints min, median and max over ranks of every iteration, and flags
+   the ranks that are slower than the factor times the median in more than
+   half of the iterations, with their hosts.  With PRK_RANK_TIMES set,
+   writes the matrix of times, one row per rank, to that file as CSV.
+   Collective over MPI_COMM_WORLD                                         */
+static void rank_report(const prk_harness_t * h) {
+
+  char        * factor_env = getenv("PRK_STRAGGLERS"),
+              * path       = getenv("PRK_RANK_TIMES"),
+              host[PRK_HARNESS_HOST_LEN], * hosts = NULL;
+  double      factor = 0.0, * all = NULL, * column, ratio;
+  int         my_ID, nranks, count = h->count, r, i, slow, flagged = 0;
+  prk_stats_t s;
+  FILE        * fp;
+
+  if (factor_env != NULL && *factor_env != '\0') factor = atof(factor_env);
+  if (path != NULL && *path == '\0') path = NULL;
+  if (factor <= 0.0 && path == NULL) return;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+  prk_topology_host(host, PRK_HARNESS_HOST_LEN);
+  if (my_ID == 0) {
+    all    = (double *) malloc((size_t) nranks*MAX(count,1)*sizeof(double));
+    hosts  = (char *)   malloc((size_t) nranks*PRK_HARNESS_HOST_LEN);
+    if (!all || !hosts) {
+      printf("ERROR: could not allocate space for the iteration times of all ranks\n");
+      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+  }
+  MPI_Gather(h->times, count, MPI_DOUBLE, all, count, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  MPI_Gather(host, PRK_HARNESS_HOST_LEN, MPI_CHAR,
+             hosts, PRK_HARNESS_HOST_LEN, MPI_CHAR, 0, MPI_COMM_WORLD);
+  if (my_ID != 0) return;
+
+  if (factor > 0.0) {
+    double * median = (double *) malloc(MAX(count,1)*sizeof(double));
+    column = (double *) malloc(nranks*sizeof(double));
+    if (!median || !column) {
+      printf("ERROR: could not allocate space for per-iteration statistics\n");
+      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    printf("Iteration time over %d ranks (s):\n", nranks);
+    for (i=0; i<count; i++) {
+      int slowest = 0;
+      for (r=0; r<nranks; r++) {
+        column[r] = all[(size_t) r*count+i];
+        if (column[r] > column[slowest]) slowest = r;
+      }
+      prk_harness_stats(column, nranks, &s);
+      median[i] = s.median;
+      printf("  iteration %6d: min %e  median %e  max %e (rank %d)\n",
+             i+1, s.min, s.median, s.max, slowest);
+    }
+    for (r=0; r<nranks; r++) {
+      for (slow=0, ratio=0.0, i=0; i<count; i++) {
+        double t = all[(size_t) r*count+i];
+        if (t > factor*median[i]) slow++;
+        if (median[i] > 0.0) ratio += t/median[i];
+      }
+      if (2*slow > count) {
+        printf("Straggler: rank %d on %s is slower than %g x median in %d of %d "
+               "iterations, %.2lf x median on average\n", r, hosts+(size_t) r*PRK_HARNESS_HOST_LEN,
+               factor, slow, count, ratio/count);
+        flagged++;
+      }
+    }
+    if (!flagged) printf("Stragglers: none above %g x median\n", factor);
+    free(median);
+    free(column);
+  }
+
+  if (path != NULL) {
+    fp = fopen(path, "w");
+    if (fp == NULL) printf("WARNING: could not open rank times file %s\n", path);
+    else {
+      fprintf(fp, "rank,host");
+      for (i=0; i<count; i++) fprintf(fp, ",%d", i+1);
+      fprintf(fp, "\n");
+      for (r=0; r<nranks; r++) {
+        fprintf(fp, "%d,%s", r, hosts+(size_t) r*PRK_HARNESS_HOST_LEN);
+        for (i=0; i<count; i++) fprintf(fp, ",%.9e", all[(size_t) r*count+i]);
+        fprintf(fp, "\n");
+      }
+      fclose(fp);
+    }
+  }
+  free(all);
+  free(hosts);
+}
+#endif
+
+void prk_harness_report(prk_harness_t * h, const char * units, double work) {
+
+  prk_stats_t s;
+  double      * times = h->times;
+  char        * path, * format;
+  FILE        * fp;
+  int         csv, i;
+  double      elapsed = prk_harness_elapsed(h), per_iter;
+  uint64_t    local_counters[PRK_COUNTERS_MAX];
+  unsigned long long counters[PRK_COUNTERS_MAX];
+  double      joules = prk_energy_joules(), power;
+  int         nodes  = prk_energy_readers();
+
+  prk_counters_read(local_counters);
+  for (i=0; i<prk_counters_num(); i++) counters[i] = local_counters[i];
+
+  /* the probe runs on all ranks at once, so that they share the memory
+     system the way the kernel does, and the rates are summed             */
+  if (h->modeled && prk_roofline_enabled()) {
+    prk_roofline_probe(&h->bandwidth, &h->peak);
+#if PRK_HARNESS_MPI
+    double local[2] = {h->bandwidth, h->peak}, sum[2];
+    MPI_Allreduce(local, sum, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    h->bandwidth = sum[0];
+    h->peak      = sum[1];
+#elif PRK_HARNESS_SHMEM
+    double local[2] = {h->bandwidth, h->peak}, sum[2];
+    shmem_reduce(sum, local, 2, 0);
+    h->bandwidth = sum[0];
+    h->peak      = sum[1];
+#endif
+  }
+
+#if PRK_HARNESS_MPI
+  int my_ID;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  times = (double *) malloc(h->capacity*sizeof(double));
+  if (!times) {
+    printf("ERROR: rank %d could not allocate space for iteration times\n", my_ID);
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+  /* an iteration takes as long as the slowest rank needs to complete it   */
+  MPI_Reduce(h->times, times, h->count, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  /* the rate is based on the longest total, as in the kernels             */
+  {
+    double local = elapsed;
+    MPI_Reduce(&local, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  }
+  rank_report(h);
+  /* event counts are summed over ranks                                    */
+  if (prk_counters_num() > 0) {
+    unsigned long long sum[PRK_COUNTERS_MAX];
+    MPI_Reduce(counters, sum, prk_counters_num(), MPI_UNSIGNED_LONG_LONG,
+               MPI_SUM, 0, MPI_COMM_WORLD);
+    for (i=0; i<prk_counters_num(); i++) counters[i] = sum[i];
+  }
+  /* energy is summed over the nodes, each read by one rank                */
+  if (prk_energy_enabled()) {
+    double energy = joules;
+    int    readers = nodes;
+    MPI_Reduce(&energy,  &joules, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&readers, &nodes,  1, MPI_INT,    MPI_SUM, 0, MPI_COMM_WORLD);
+  }
+  if (my_ID != 0) {
+    free(times);
+    return;
+  }
+#elif PRK_HARNESS_SHMEM
+  times = (double *) malloc((h->count+1)*sizeof(double));
+  if (!times) {
+    printf("ERROR: PE %d could not allocate space for iteration times\n", prk_shmem_my_pe());
+    exit(EXIT_FAILURE);
+  }
+  /* the slowest PE sets the time of every iteration and the total, as in
+     MPI builds; elapsed rides along with the iteration times              */
+  for (i=0; i<h->count; i++) times[i] = h->times[i];
+  times[h->count] = elapsed;
+  shmem_reduce(times, times, h->count+1, 1);
+  elapsed = times[h->count];
+  /* event counts are summed over PEs                                      */
+  if (prk_counters_num() > 0) {
+    double sum[PRK_COUNTERS_MAX];
+    for (i=0; i<prk_counters_num(); i++) sum[i] = (double) counters[i];
+    shmem_reduce(sum, sum, prk_counters_num(), 0);
+    for (i=0; i<prk_counters_num(); i++) counters[i] = (unsigned long long) sum[i];
+  }
+  if (prk_shmem_my_pe() != 0) {
+    free(times);
+    return;
+  }
+#endif
+
+  prk_harness_stats(times, h->count, &s);
+  s.elapsed = elapsed;
+  per_iter = s.count > 0 ? s.elapsed/s.count : 0.0;
+
+  printf("Iteration time (s): min %lf  median %lf  p95 %lf  max %lf\n",
+         s.min, s.median, s.p95, s.max);
+  for (i=0; i<prk_counters_num(); i++) {
+    printf("Counter %-14s: %20llu  per iteration: %e\n", prk_counters_name(i),
+           counters[i], s.count > 0 ? (double) counters[i]/s.count : 0.0);
+  }
+  if (h->modeled) {
+    printf("Model per iteration: %e flops  %e bytes  intensity %lf flops/byte\n",
+           h->flops, h->bytes, h->bytes > 0.0 ? h->flops/h->bytes : 0.0);
+    if (per_iter > 0.0) {
+      printf("Achieved: %lf GFlop/s  %lf GB/s\n",
+             1.0E-9*h->flops/per_iter, 1.0E-9*h->bytes/per_iter);
+    }
+    if (h->peak > 0.0 && h->bandwidth > 0.0) {
+      printf("Roofline: peak %lf GFlop/s  bandwidth %lf GB/s  %s bound, "
+             "achieved %.1lf%% of bound\n", 1.0E-9*h->peak, 1.0E-9*h->bandwidth,
+             h->flops/h->peak >= h->bytes/h->bandwidth ? "compute" : "memory",
+             100.0*roofline_fraction(h, &s));
+    }
+  }
+  if (prk_energy_enabled() && s.total > 0.0 && s.count > 0) {
+    power = joules/s.total;
+    printf("Energy (J): %lf  per iteration %lf  power %lf W  [%s, %d node%s]\n",
+           joules, joules/s.count, power, prk_energy_sources(), nodes,
+           nodes == 1 ? "" : "s");
+    if (power > 0.0) {
+      printf("Energy efficiency: %lf %s per W", prk_harness_rate(&s, work)/power, units);
+      if (h->modeled) printf("  %lf GFlop/s/W  %lf GB/s/W",
+                             1.0E-9*h->flops/per_iter/power, 1.0E-9*h->bytes/per_iter/power);
+      printf("\n");
+    }
+  }
+
+  path = getenv("PRK_RESULTS");
+  if (path != NULL && *path != '\0') {
+    format = getenv("PRK_RESULTS_FORMAT");
+    if (format != NULL) csv = !strcmp(format, "csv");
+    else                csv = strlen(path) > 4 && !strcmp(path+strlen(path)-4, ".csv");
+    fp = fopen(path, "a");
+    if (fp == NULL) {
+      printf("WARNING: could not open results file %s\n", path);
+    }
+    else {
+      if (csv) write_csv (fp, h, times, &s, units, work, counters, joules);
+      else     write_json(fp, h, times, &s, units, work, counters, joules);
+      fclose(fp);
+    }
+  }
+  prk_log_end(h, times, &s, units, work, counters, joules);
+
+#if PRK_HARNESS_MPI || PRK_HARNESS_SHMEM
+  free(times);
+#endif
+}
+
+void prk_harness_finalize(prk_harness_t * h) {
+  prk_counters_finalize();
+  prk_energy_finalize();
+  prk_log_close();
+  free(h->times);
+  h->times    = NULL;
+  h->capacity = h->count = 0;
+}
+
+void prk_phase_init(prk_phase_t * p, const char * name) {
+  p->name  = name;
+  p->start = 0.0;
+  prk_phase_reset(p);
+}
+
+void prk_phase_report(const prk_phase_t * p) {
+
+  double total = p->total, min = p->min, max = p->max;
+
+#if PRK_HARNESS_MPI
+  int my_ID;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  MPI_Reduce(&p->total, &total, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&p->min,   &min,   1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&p->max,   &max,   1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  if (my_ID != 0) return;
+#elif PRK_HARNESS_SHMEM
+  double local[3] = {p->total, -p->min, p->max}, all[3];
+  shmem_reduce(all, local, 3, 1);
+  total = all[0];
+  min   = -all[1];
+  max   = all[2];
+  if (prk_shmem_my_pe() != 0) return;
+#endif
+
+  if (p->count == 0) return;
+  printf("Phase %s (s): count %ld  avg %e  min %e  max %e  [%s, resolution %e]\n",
+         p->name, p->count, total/p->count, min, max,
+         wtime_backend(), wtime_resolution());
+}
@@ -0,0 +1,247 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_log
+
+Purpose:   Append a fixed-size record of every run to a memory-mapped
+           log file and fill it in while the kernel runs.  See
+           include/prk_log.h for the record layout.
+
+Functions: prk_log_begin: reserve and map the record of a run
+           prk_log_time:  store the time of one iteration
+           prk_log_end:   store the statistics and mark the record done
+           prk_log_close: unmap the record
+
+Notes:     Uses POSIX mmap and fcntl locking.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+#include <par-res-kern_general.h>
+#include <stdarg.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <prk_harness.h>
+#include <prk_counters.h>
+#include <prk_energy.h>
+#include <prk_log.h>
+
+#if defined(MPI) || defined(FG_MPI) || defined(ADAPTIVE_MPI)
+  #include <mpi.h>
+  #define PRK_LOG_MPI 1
+#endif
+
+#if defined(SHMEM)
+  #include <shmem.h>
+  #include <par-res-kern_shmem.h>
+  #define PRK_LOG_SHMEM 1
+#endif
+
+#define PRK_LOG_NUM      15   /* width of a number, "%.8e" plus a blank     */
+#define PRK_LOG_COUNT    10   /* width of the iteration count               */
+#define PRK_LOG_PARAMS  512   /* width of the parameter list                */
+#define PRK_LOG_UNITS    16   /* width of the rate units                    */
+#define PRK_LOG_NSTATS    7   /* avg, min, median, p95, max, stddev, rate   */
+
+#define PRK_LOG_HEADER "status,kernel,model,version,timer,start,params,iterations," \
+                       "count,avg,min,median,p95,max,stddev,rate,rate_units," \
+                       "counters,energy,times\n"
+
+static void * map      = NULL;  /* mapping that contains the record          */
+static size_t map_len  = 0;
+static int    capacity = 0;     /* number of time slots in the record        */
+static int    counters_len = 0; /* width of the counter list                 */
+static char * status, * params, * count, * stats, * units, * counters, * energy, * slots;
+
+/* format into a field of fixed width, padded with blanks and truncated if
+   too long; the field is not terminated                                  */
+static void put(char * field, int width, const char * format, ...) {
+  char    buf[PRK_LOG_PARAMS+1];
+  va_list args;
+  int     len;
+
+  va_start(args, format);
+  len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  len = MIN(MAX(len,0), MIN(width, (int) sizeof(buf)-1));
+  memcpy(field, buf, len);
+  memset(field+len, ' ', width-len);
+}
+
+static void put_params(const prk_harness_t * h) {
+  char buf[PRK_LOG_PARAMS+1] = "";
+  int  i, len = 0;
+  for (i=0; i<h->nparams && len<PRK_LOG_PARAMS; i++) {
+    len += snprintf(buf+len, sizeof(buf)-len, "%s%s=%s", i ? ";" : "",
+                    h->key[i], h->value[i]);
+  }
+  put(params, PRK_LOG_PARAMS, "%s", buf);
+}
+
+void prk_log_begin(const prk_harness_t * h) {
+
+  char        * path = getenv("PRK_LOG"), * record, * iters, * p, head[256];
+  int           fd, i, len_head;
+  struct flock  lock;
+  struct stat   st;
+  off_t         size, base;
+  size_t        len;
+  long          page;
+
+  if (path == NULL || *path == '\0' || map != NULL) return;
+#if PRK_LOG_MPI
+  {
+    int my_ID;
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+    if (my_ID != 0) return;
+  }
+#elif PRK_LOG_SHMEM
+  if (prk_shmem_my_pe() != 0) return;
+#endif
+
+  capacity = h->capacity;
+  counters_len = 0;
+  for (i=0; i<prk_counters_num(); i++)
+    counters_len += strlen(prk_counters_name(i)) + 22;  /* name=<20 digits>; */
+  len_head = snprintf(head, sizeof(head), "%s,%s,%s,%s,%ld,", h->kernel, h->model,
+                      PRKVERSION, wtime_backend(), (long) time(NULL));
+  len_head = MIN(len_head, (int) sizeof(head)-1);
+  len = 8 + len_head + PRK_LOG_PARAMS+1 + 11 + PRK_LOG_COUNT+1
+      + PRK_LOG_NSTATS*(PRK_LOG_NUM+1) + PRK_LOG_UNITS+1 + counters_len+1
+      + PRK_LOG_NUM+1 + (size_t) capacity*(PRK_LOG_NUM+1);
+
+  fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    printf("WARNING: could not open log file %s\n", path);
+    return;
+  }
+
+  /* reserve the record at the end of the file                            */
+  memset(&lock, 0, sizeof(lock));
+  lock.l_type   = F_WRLCK;
+  lock.l_whence = SEEK_SET;
+  fcntl(fd, F_SETLKW, &lock);
+  size = -1;
+  if (fstat(fd, &st) == 0) {
+    size = st.st_size;
+    if (size == 0 && pwrite(fd, PRK_LOG_HEADER, strlen(PRK_LOG_HEADER), 0) > 0)
+      size = strlen(PRK_LOG_HEADER);
+    if (ftruncate(fd, size + len) != 0) size = -1;
+  }
+  lock.l_type = F_UNLCK;
+  fcntl(fd, F_SETLK, &lock);
+
+  if (size >= 0) {
+    page    = sysconf(_SC_PAGESIZE);
+    base    = size - size%page;
+    map_len = size - base + len;
+    map     = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, base);
+    if (map == MAP_FAILED) map = NULL;
+  }
+  close(fd);
+  if (map == NULL) {
+    printf("WARNING: could not append to log file %s\n", path);
+    return;
+  }
+
+  record = p = (char *) map + (size - base);
+  memset(record, ' ', len);
+  status   = p;                               p += 8;
+  memcpy(p, head, len_head);                  p += len_head;
+  params   = p;                               p += PRK_LOG_PARAMS+1;
+  iters    = p;                               p += 11;
+  count    = p;                               p += PRK_LOG_COUNT+1;
+  stats    = p;                               p += PRK_LOG_NSTATS*(PRK_LOG_NUM+1);
+  units    = p;                               p += PRK_LOG_UNITS+1;
+  counters = p;                               p += counters_len+1;
+  energy   = p;                               p += PRK_LOG_NUM+1;
+  slots    = p;
+  put(status, 7, "running");
+  put_params(h);
+  put(iters, 10, "%d", h->capacity);
+  put(count, PRK_LOG_COUNT, "%d", 0);
+  /* field separators                                                     */
+  status[7] = params[PRK_LOG_PARAMS] = ',';
+  iters[10] = count[PRK_LOG_COUNT] = ',';
+  for (i=0; i<PRK_LOG_NSTATS; i++) stats[i*(PRK_LOG_NUM+1)+PRK_LOG_NUM] = ',';
+  units[PRK_LOG_UNITS] = counters[counters_len] = energy[PRK_LOG_NUM] = ',';
+  for (i=0; i<capacity; i++) slots[i*(PRK_LOG_NUM+1)+PRK_LOG_NUM] = ';';
+  record[len-1] = '\n';
+}
+
+void prk_log_time(int i, double t) {
+  if (map == NULL || i >= capacity) return;
+  put(slots+i*(PRK_LOG_NUM+1), PRK_LOG_NUM, "%.8e", t);
+  put(count, PRK_LOG_COUNT, "%d", i+1);
+}
+
+void prk_log_end(const prk_harness_t * h, const double * times, const prk_stats_t * s,
+                 const char * rate_units, double work,
+                 const unsigned long long * values, double joules) {
+
+  double v[PRK_LOG_NSTATS];
+  int    i, len;
+
+  if (map == NULL) return;
+
+  put_params(h);
+  for (i=0; i<s->count && i<capacity; i++) prk_log_time(i, times[i]);
+  put(count, PRK_LOG_COUNT, "%d", s->count);
+  v[0] = s->avg; v[1] = s->min; v[2] = s->median; v[3] = s->p95;
+  v[4] = s->max; v[5] = s->stddev; v[6] = s->avg > 0.0 ? work/s->avg : 0.0;
+  for (i=0; i<PRK_LOG_NSTATS; i++) put(stats+i*(PRK_LOG_NUM+1), PRK_LOG_NUM, "%.8e", v[i]);
+  put(units, PRK_LOG_UNITS, "%s", rate_units);
+  for (i=0, len=0; i<prk_counters_num(); i++) {
+    char buf[64];
+    int  n = snprintf(buf, sizeof(buf), "%s%s=%llu", i ? ";" : "",
+                      prk_counters_name(i), values[i]);
+    n = MIN(n, counters_len-len);
+    memcpy(counters+len, buf, n);
+    len += n;
+  }
+  if (prk_energy_enabled()) put(energy, PRK_LOG_NUM, "%.8e", joules);
+  put(status, 7, "done");
+  msync(map, map_len, MS_SYNC);
+}
+
+void prk_log_close(void) {
+  if (map != NULL) munmap(map, map_len);
+  map = NULL;
+  map_len = 0;
+  capacity = 0;
+}
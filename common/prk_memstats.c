@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_memstats
+
+Purpose:   Counters of the memory allocated with prk_malloc().  See
+           include/prk_memstats.h for usage.
+
+Functions: prk_memstats_add:    account for a new block
+           prk_memstats_remove: account for a released block
+           prk_memstats_get:    copy of the counters
+           prk_peak_rss:        peak resident set size of the process
+           prk_memstats_report: print the counters, registered with
+                                atexit() when PRK_MEMSTATS is set
+
+Notes:     The counters are updated in a named OpenMP critical section,
+           so per-thread blocks allocated inside parallel regions are
+           counted correctly.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/resource.h>
+  #define PRK_HAVE_RUSAGE 1
+#endif
+
+static prk_memstats_t stats = {0, 0, 0};
+static int            registered = 0;
+
+void prk_memstats_add(size_t bytes)
+{
+#ifdef _OPENMP
+    #pragma omp critical (prk_memstats)
+#endif
+    {
+        stats.live += bytes;
+        stats.count++;
+        if (stats.live > stats.peak) stats.peak = stats.live;
+        if (!registered) {
+            char * temp = getenv("PRK_MEMSTATS");
+            registered = 1;
+            if (temp != NULL && *temp != '\0' && strcmp(temp,"0")) atexit(prk_memstats_report);
+        }
+    }
+}
+
+void prk_memstats_remove(size_t bytes)
+{
+#ifdef _OPENMP
+    #pragma omp critical (prk_memstats)
+#endif
+    stats.live -= bytes;
+}
+
+void prk_memstats_get(prk_memstats_t * s)
+{
+#ifdef _OPENMP
+    #pragma omp critical (prk_memstats)
+#endif
+    *s = stats;
+}
+
+/* peak resident set size in bytes, or 0 if unknown                       */
+double prk_peak_rss(void)
+{
+#if PRK_HAVE_RUSAGE
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+  #ifdef __APPLE__
+    return (double) usage.ru_maxrss;
+  #else
+    return 1024.0 * (double) usage.ru_maxrss;
+  #endif
+#else
+    return 0.0;
+#endif
+}
+
+void prk_memstats_report(void)
+{
+    static const char * rank_vars[] = {"OMPI_COMM_WORLD_RANK", "PMI_RANK", "PMIX_RANK",
+                                       "SLURM_PROCID", NULL};
+    const char     * rank = NULL;
+    prk_memstats_t   s;
+    int              i;
+
+    prk_memstats_get(&s);
+    for (i=0; rank_vars[i] != NULL && rank == NULL; i++) rank = getenv(rank_vars[i]);
+    printf("Memory footprint%s%s%s: prk_malloc peak %.4g MB in %lu allocations, "
+           "live at exit %.4g MB, peak RSS %.4g MB\n",
+           rank ? " (rank " : "", rank ? rank : "", rank ? ")" : "",
+           1.0e-6 * s.peak, s.count, 1.0e-6 * s.live, 1.0e-6 * prk_peak_rss());
+    fflush(stdout);
+}
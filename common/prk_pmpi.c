@@ -0,0 +1,655 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_pmpi
+
+Purpose:   Communication profile of an MPI kernel through the PMPI
+           profiling interface.  Linking this file into a kernel (make
+           <kernel> PMPI_PROFILE=1) replaces the MPI calls the kernels
+           use by wrappers that count the calls, the bytes they send or
+           move and the time spent in them, and that build a matrix of
+           the messages and bytes every rank sends to every other rank,
+           including one-sided puts, gets and accumulates.  At
+           MPI_Finalize rank 0 writes two CSV files:
+
+             <prefix>.calls.csv    rank,call,count,bytes,seconds
+             <prefix>.traffic.csv  source,destination,messages,bytes
+
+           with one line per call a rank made and per pair of ranks that
+           communicated, and prints the time spent in MPI.
+
+           The profile is controlled at run time:
+             PRK_PMPI_PREFIX=<prefix>  prefix of the files, prk_pmpi
+             PRK_PMPI=0                record nothing; the wrappers only
+                                       test a flag and call PMPI
+
+Notes:     Bytes are those of the send buffer (the receive buffer for
+           receives), computed from count and datatype size.  Traffic
+           of collectives is not in the matrix, since it depends on the
+           algorithm of the MPI library.  Receives that complete in
+           MPI_Wait and friends are timed there.  The counters are not
+           protected against concurrent updates, so with
+           MPI_THREAD_MULTIPLE they are only approximate.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#include <mpi.h>
+#include <par-res-kern_general.h>
+
+/* MPI-3 made the input buffers of the C bindings const                        */
+#if MPI_VERSION >= 3
+  #define CONST const
+#else
+  #define CONST
+#endif
+
+#define PRK_PMPI_MAX_MAPS       64   /* communicators and windows remembered   */
+#define PRK_PMPI_MAX_PERSISTENT 1024 /* persistent send requests remembered    */
+
+enum {
+  C_SEND, C_RECV, C_ISEND, C_IRECV, C_SENDRECV, C_SEND_INIT, C_RECV_INIT,
+  C_START, C_STARTALL, C_WAIT, C_WAITALL, C_WAITANY, C_TEST, C_TESTALL,
+  C_BARRIER, C_BCAST, C_REDUCE, C_ALLREDUCE, C_SCAN, C_GATHER, C_ALLGATHER,
+  C_ALLTOALL, C_ALLTOALLV, C_NEIGHBOR_ALLTOALL, C_NEIGHBOR_ALLTOALLW,
+  C_PUT, C_GET, C_ACCUMULATE, C_FETCH_AND_OP, C_COMPARE_AND_SWAP,
+  C_WIN_FENCE, C_WIN_POST, C_WIN_START, C_WIN_COMPLETE, C_WIN_WAIT,
+  C_WIN_LOCK, C_WIN_UNLOCK, C_WIN_LOCK_ALL, C_WIN_UNLOCK_ALL, C_WIN_FLUSH,
+  C_WIN_FLUSH_ALL, C_WIN_FLUSH_LOCAL, C_WIN_FLUSH_LOCAL_ALL, C_WIN_SYNC,
+  NCALLS
+};
+
+static const char * call_names[NCALLS] = {
+  "MPI_Send", "MPI_Recv", "MPI_Isend", "MPI_Irecv", "MPI_Sendrecv", "MPI_Send_init",
+  "MPI_Recv_init", "MPI_Start", "MPI_Startall", "MPI_Wait", "MPI_Waitall",
+  "MPI_Waitany", "MPI_Test", "MPI_Testall",
+  "MPI_Barrier", "MPI_Bcast", "MPI_Reduce", "MPI_Allreduce", "MPI_Scan", "MPI_Gather",
+  "MPI_Allgather", "MPI_Alltoall", "MPI_Alltoallv", "MPI_Neighbor_alltoall",
+  "MPI_Neighbor_alltoallw",
+  "MPI_Put", "MPI_Get", "MPI_Accumulate", "MPI_Fetch_and_op", "MPI_Compare_and_swap",
+  "MPI_Win_fence", "MPI_Win_post", "MPI_Win_start", "MPI_Win_complete", "MPI_Win_wait",
+  "MPI_Win_lock", "MPI_Win_unlock", "MPI_Win_lock_all", "MPI_Win_unlock_all",
+  "MPI_Win_flush", "MPI_Win_flush_all", "MPI_Win_flush_local",
+  "MPI_Win_flush_local_all", "MPI_Win_sync"
+};
+
+static int      enabled = 0;         /* nonzero between MPI_Init and MPI_Finalize */
+static int      my_ID, Num_procs;
+static double   stats[NCALLS][3];    /* count, bytes and seconds of every call    */
+static double * traffic = NULL;      /* messages and bytes sent to every rank     */
+
+/* world ranks of the members of a communicator or window                       */
+typedef struct { MPI_Comm comm; MPI_Win win; int size; int * world; } map_t;
+static map_t maps[PRK_PMPI_MAX_MAPS];
+static int   num_maps = 0;
+
+/* destination and size of a persistent send, used by MPI_Start(all)           */
+typedef struct { MPI_Request request; int dest; double bytes; } persistent_t;
+static persistent_t persistent[PRK_PMPI_MAX_PERSISTENT];
+static int          num_persistent = 0;
+
+/* time one call to PMPI and record it with its bytes                           */
+#define PROFILE(call, nbytes, expr)                                     \
+  double t0;                                                            \
+  int    rc;                                                            \
+  if (!enabled) return expr;                                            \
+  t0 = PMPI_Wtime();                                                    \
+  rc = expr;                                                            \
+  stats[call][0] += 1.0;                                                \
+  stats[call][1] += (nbytes);                                           \
+  stats[call][2] += PMPI_Wtime() - t0;                                  \
+  return rc
+
+static double type_bytes(int count, MPI_Datatype type) {
+  int size;
+  if (!enabled || count <= 0) return 0.0;
+  PMPI_Type_size(type, &size);
+  return (double) count * size;
+}
+
+static void add_map(MPI_Comm comm, MPI_Win win, MPI_Group group) {
+  MPI_Group world_group;
+  int       * local, i;
+  map_t     * m;
+
+  if (num_maps == PRK_PMPI_MAX_MAPS) return;
+  m = &maps[num_maps];
+  PMPI_Group_size(group, &m->size);
+  m->world = (int *) malloc(2*m->size*sizeof(int));
+  if (!m->world) return;
+  local = m->world + m->size;
+  for (i=0; i<m->size; i++) local[i] = i;
+  PMPI_Comm_group(MPI_COMM_WORLD, &world_group);
+  PMPI_Group_translate_ranks(group, m->size, local, world_group, m->world);
+  PMPI_Group_free(&world_group);
+  m->comm = comm;
+  m->win  = win;
+  num_maps++;
+}
+
+static void remove_map(MPI_Comm comm, MPI_Win win) {
+  int i;
+  for (i=0; i<num_maps; i++) {
+    if (maps[i].comm == comm && maps[i].win == win) {
+      free(maps[i].world);
+      maps[i] = maps[--num_maps];
+      return;
+    }
+  }
+}
+
+/* world rank of rank peer of a communicator, or -1                             */
+static int comm_world_rank(MPI_Comm comm, int peer) {
+  MPI_Group group;
+  int       i, inter;
+
+  if (peer < 0) return -1;   /* MPI_PROC_NULL, MPI_ANY_SOURCE                  */
+  if (comm == MPI_COMM_WORLD) return peer;
+  for (i=0; i<num_maps; i++)
+    if (maps[i].comm == comm && maps[i].win == MPI_WIN_NULL)
+      return peer < maps[i].size ? maps[i].world[peer] : -1;
+  PMPI_Comm_test_inter(comm, &inter);
+  if (inter) return -1;
+  PMPI_Comm_group(comm, &group);
+  add_map(comm, MPI_WIN_NULL, group);
+  PMPI_Group_free(&group);
+  return (i < num_maps && peer < maps[i].size) ? maps[i].world[peer] : -1;
+}
+
+/* world rank of rank peer of a window, or -1                                   */
+static int win_world_rank(MPI_Win win, int peer) {
+  int i;
+  for (i=0; i<num_maps; i++)
+    if (maps[i].win == win) return peer < maps[i].size ? maps[i].world[peer] : -1;
+  return -1;
+}
+
+static void record_traffic(int source, int dest, double bytes) {
+  if (!enabled || source < 0 || dest < 0) return;
+  if (source == my_ID) {
+    traffic[2*dest]   += 1.0;
+    traffic[2*dest+1] += bytes;
+  }
+  /* a get is traffic from the target, recorded at the origin                */
+  else {
+    traffic[2*(Num_procs+source)]   += 1.0;
+    traffic[2*(Num_procs+source)+1] += bytes;
+  }
+}
+
+static void profile_init(void) {
+  char * env = getenv("PRK_PMPI");
+
+  if (env && !strcmp(env, "0")) return;
+  PMPI_Comm_rank(MPI_COMM_WORLD, &my_ID);
+  PMPI_Comm_size(MPI_COMM_WORLD, &Num_procs);
+  /* messages and bytes sent to every rank, then received by gets from them  */
+  traffic = (double *) calloc(4*Num_procs, sizeof(double));
+  if (!traffic) {
+    printf("WARNING: rank %d could not allocate the PMPI traffic matrix\n", my_ID);
+    return;
+  }
+  enabled = 1;
+}
+
+static void profile_write(void) {
+  char   * prefix = getenv("PRK_PMPI_PREFIX");
+  char     path[1024];
+  double * all_stats = NULL, * row = NULL, total[2] = {0.0, 0.0};
+  double   my_time = 0.0, sum_time, max_time;
+  FILE   * calls = NULL, * matrix = NULL;
+  int      rank, i;
+
+  if (!prefix || !*prefix) prefix = "prk_pmpi";
+  enabled = 0;
+
+  for (i=0; i<NCALLS; i++) my_time += stats[i][2];
+  PMPI_Reduce(&my_time, &sum_time, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  PMPI_Reduce(&my_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+  if (my_ID == 0) {
+    all_stats = (double *) malloc(Num_procs*NCALLS*3*sizeof(double));
+    row       = (double *) malloc(4*Num_procs*sizeof(double));
+    snprintf(path, sizeof(path), "%s.calls.csv", prefix);
+    calls  = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.traffic.csv", prefix);
+    matrix = fopen(path, "w");
+    if (!all_stats || !row || !calls || !matrix)
+      printf("WARNING: could not write the PMPI profile to %s.*.csv\n", prefix);
+  }
+  PMPI_Gather(stats, NCALLS*3, MPI_DOUBLE, all_stats, NCALLS*3, MPI_DOUBLE, 0,
+              MPI_COMM_WORLD);
+
+  /* the matrix is collected one row at a time to keep rank 0 memory linear */
+  if (my_ID != 0) {
+    PMPI_Send(traffic, 4*Num_procs, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+  }
+  else {
+    if (calls && all_stats) {
+      fprintf(calls, "rank,call,count,bytes,seconds\n");
+      for (rank=0; rank<Num_procs; rank++) for (i=0; i<NCALLS; i++) {
+        double * s = all_stats + (rank*NCALLS+i)*3;
+        if (s[0] > 0.0) fprintf(calls, "%d,%s,%.0lf,%.0lf,%e\n",
+                                rank, call_names[i], s[0], s[1], s[2]);
+      }
+    }
+    if (matrix) fprintf(matrix, "source,destination,messages,bytes\n");
+    for (rank=0; rank<Num_procs; rank++) {
+      if (rank == 0) memcpy(row, traffic, 4*Num_procs*sizeof(double));
+      else PMPI_Recv(row, 4*Num_procs, MPI_DOUBLE, rank, 0, MPI_COMM_WORLD,
+                     MPI_STATUS_IGNORE);
+      for (i=0; i<Num_procs; i++) {
+        /* sends and puts from rank to i, gets by rank from i                */
+        if (matrix && row[2*i] > 0.0)
+          fprintf(matrix, "%d,%d,%.0lf,%.0lf\n", rank, i, row[2*i], row[2*i+1]);
+        if (matrix && row[2*(Num_procs+i)] > 0.0)
+          fprintf(matrix, "%d,%d,%.0lf,%.0lf\n", i, rank,
+                  row[2*(Num_procs+i)], row[2*(Num_procs+i)+1]);
+        total[0] += row[2*i] + row[2*(Num_procs+i)];
+        total[1] += row[2*i+1] + row[2*(Num_procs+i)+1];
+      }
+    }
+    if (calls)  fclose(calls);
+    if (matrix) fclose(matrix);
+    printf("PMPI profile: time in MPI (s) avg %lf  max %lf  "
+           "point-to-point and RMA %.0lf messages %.0lf bytes  -> %s.*.csv\n",
+           sum_time/Num_procs, max_time, total[0], total[1], prefix);
+    free(all_stats);
+    free(row);
+  }
+  free(traffic);
+  while (num_maps > 0) remove_map(maps[0].comm, maps[0].win);
+}
+
+/* initialization and finalization                                              */
+
+int MPI_Init(int * argc, char *** argv) {
+  int rc = PMPI_Init(argc, argv);
+  profile_init();
+  return rc;
+}
+
+int MPI_Init_thread(int * argc, char *** argv, int required, int * provided) {
+  int rc = PMPI_Init_thread(argc, argv, required, provided);
+  profile_init();
+  return rc;
+}
+
+int MPI_Finalize(void) {
+  if (enabled) profile_write();
+  return PMPI_Finalize();
+}
+
+int MPI_Comm_free(MPI_Comm * comm) {
+  if (enabled) remove_map(*comm, MPI_WIN_NULL);
+  return PMPI_Comm_free(comm);
+}
+
+/* point-to-point                                                               */
+
+int MPI_Send(CONST void * buf, int count, MPI_Datatype type, int dest, int tag,
+             MPI_Comm comm) {
+  double bytes = type_bytes(count, type);
+  if (enabled) record_traffic(my_ID, comm_world_rank(comm, dest), bytes);
+  PROFILE(C_SEND, bytes, PMPI_Send(buf, count, type, dest, tag, comm));
+}
+
+int MPI_Recv(void * buf, int count, MPI_Datatype type, int source, int tag,
+             MPI_Comm comm, MPI_Status * status) {
+  PROFILE(C_RECV, type_bytes(count, type),
+          PMPI_Recv(buf, count, type, source, tag, comm, status));
+}
+
+int MPI_Isend(CONST void * buf, int count, MPI_Datatype type, int dest, int tag,
+              MPI_Comm comm, MPI_Request * request) {
+  double bytes = type_bytes(count, type);
+  if (enabled) record_traffic(my_ID, comm_world_rank(comm, dest), bytes);
+  PROFILE(C_ISEND, bytes, PMPI_Isend(buf, count, type, dest, tag, comm, request));
+}
+
+int MPI_Irecv(void * buf, int count, MPI_Datatype type, int source, int tag,
+              MPI_Comm comm, MPI_Request * request) {
+  PROFILE(C_IRECV, type_bytes(count, type),
+          PMPI_Irecv(buf, count, type, source, tag, comm, request));
+}
+
+int MPI_Sendrecv(CONST void * sendbuf, int sendcount, MPI_Datatype sendtype, int dest,
+                 int sendtag, void * recvbuf, int recvcount, MPI_Datatype recvtype,
+                 int source, int recvtag, MPI_Comm comm, MPI_Status * status) {
+  double bytes = type_bytes(sendcount, sendtype);
+  if (enabled) record_traffic(my_ID, comm_world_rank(comm, dest), bytes);
+  PROFILE(C_SENDRECV, bytes,
+          PMPI_Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag, recvbuf, recvcount,
+                        recvtype, source, recvtag, comm, status));
+}
+
+int MPI_Send_init(CONST void * buf, int count, MPI_Datatype type, int dest, int tag,
+                  MPI_Comm comm, MPI_Request * request) {
+  double t0;
+  int    rc;
+  if (!enabled) return PMPI_Send_init(buf, count, type, dest, tag, comm, request);
+  t0 = PMPI_Wtime();
+  rc = PMPI_Send_init(buf, count, type, dest, tag, comm, request);
+  if (num_persistent < PRK_PMPI_MAX_PERSISTENT) {
+    persistent[num_persistent].request = *request;
+    persistent[num_persistent].dest    = comm_world_rank(comm, dest);
+    persistent[num_persistent].bytes   = type_bytes(count, type);
+    num_persistent++;
+  }
+  stats[C_SEND_INIT][0] += 1.0;
+  stats[C_SEND_INIT][2] += PMPI_Wtime() - t0;
+  return rc;
+}
+
+int MPI_Recv_init(void * buf, int count, MPI_Datatype type, int source, int tag,
+                  MPI_Comm comm, MPI_Request * request) {
+  PROFILE(C_RECV_INIT, 0.0, PMPI_Recv_init(buf, count, type, source, tag, comm, request));
+}
+
+/* bytes of the persistent sends among requests, recorded in the matrix         */
+static double start_bytes(int count, MPI_Request * requests) {
+  double bytes = 0.0;
+  int    i, j;
+  if (!enabled) return 0.0;
+  for (i=0; i<count; i++) for (j=0; j<num_persistent; j++) {
+    if (persistent[j].request == requests[i]) {
+      record_traffic(my_ID, persistent[j].dest, persistent[j].bytes);
+      bytes += persistent[j].bytes;
+      break;
+    }
+  }
+  return bytes;
+}
+
+int MPI_Start(MPI_Request * request) {
+  PROFILE(C_START, start_bytes(1, request), PMPI_Start(request));
+}
+
+int MPI_Startall(int count, MPI_Request * requests) {
+  PROFILE(C_STARTALL, start_bytes(count, requests), PMPI_Startall(count, requests));
+}
+
+int MPI_Request_free(MPI_Request * request) {
+  int j;
+  if (enabled) for (j=0; j<num_persistent; j++) {
+    if (persistent[j].request == *request) {
+      persistent[j] = persistent[--num_persistent];
+      break;
+    }
+  }
+  return PMPI_Request_free(request);
+}
+
+int MPI_Wait(MPI_Request * request, MPI_Status * status) {
+  PROFILE(C_WAIT, 0.0, PMPI_Wait(request, status));
+}
+
+int MPI_Waitall(int count, MPI_Request * requests, MPI_Status * statuses) {
+  PROFILE(C_WAITALL, 0.0, PMPI_Waitall(count, requests, statuses));
+}
+
+int MPI_Waitany(int count, MPI_Request * requests, int * index, MPI_Status * status) {
+  PROFILE(C_WAITANY, 0.0, PMPI_Waitany(count, requests, index, status));
+}
+
+int MPI_Test(MPI_Request * request, int * flag, MPI_Status * status) {
+  PROFILE(C_TEST, 0.0, PMPI_Test(request, flag, status));
+}
+
+int MPI_Testall(int count, MPI_Request * requests, int * flag, MPI_Status * statuses) {
+  PROFILE(C_TESTALL, 0.0, PMPI_Testall(count, requests, flag, statuses));
+}
+
+/* collectives; bytes are those of the local contribution                      */
+
+int MPI_Barrier(MPI_Comm comm) {
+  PROFILE(C_BARRIER, 0.0, PMPI_Barrier(comm));
+}
+
+int MPI_Bcast(void * buf, int count, MPI_Datatype type, int root, MPI_Comm comm) {
+  PROFILE(C_BCAST, type_bytes(count, type), PMPI_Bcast(buf, count, type, root, comm));
+}
+
+int MPI_Reduce(CONST void * sendbuf, void * recvbuf, int count, MPI_Datatype type,
+               MPI_Op op, int root, MPI_Comm comm) {
+  PROFILE(C_REDUCE, type_bytes(count, type),
+          PMPI_Reduce(sendbuf, recvbuf, count, type, op, root, comm));
+}
+
+int MPI_Allreduce(CONST void * sendbuf, void * recvbuf, int count, MPI_Datatype type,
+                  MPI_Op op, MPI_Comm comm) {
+  PROFILE(C_ALLREDUCE, type_bytes(count, type),
+          PMPI_Allreduce(sendbuf, recvbuf, count, type, op, comm));
+}
+
+int MPI_Scan(CONST void * sendbuf, void * recvbuf, int count, MPI_Datatype type,
+             MPI_Op op, MPI_Comm comm) {
+  PROFILE(C_SCAN, type_bytes(count, type),
+          PMPI_Scan(sendbuf, recvbuf, count, type, op, comm));
+}
+
+int MPI_Gather(CONST void * sendbuf, int sendcount, MPI_Datatype sendtype,
+               void * recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+               MPI_Comm comm) {
+  PROFILE(C_GATHER, type_bytes(sendcount, sendtype),
+          PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype,
+                      root, comm));
+}
+
+int MPI_Allgather(CONST void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                  void * recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+  PROFILE(C_ALLGATHER, type_bytes(sendcount, sendtype),
+          PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype,
+                         comm));
+}
+
+int MPI_Alltoall(CONST void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                 void * recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+  int size = 0;
+  if (enabled) PMPI_Comm_size(comm, &size);
+  PROFILE(C_ALLTOALL, size*type_bytes(sendcount, sendtype),
+          PMPI_Alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype,
+                        comm));
+}
+
+int MPI_Alltoallv(CONST void * sendbuf, CONST int * sendcounts, CONST int * sdispls,
+                  MPI_Datatype sendtype, void * recvbuf, CONST int * recvcounts,
+                  CONST int * rdispls, MPI_Datatype recvtype, MPI_Comm comm) {
+  int    size = 0, i;
+  double bytes = 0.0;
+  if (enabled) {
+    PMPI_Comm_size(comm, &size);
+    for (i=0; i<size; i++) bytes += type_bytes(sendcounts[i], sendtype);
+  }
+  PROFILE(C_ALLTOALLV, bytes,
+          PMPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts,
+                         rdispls, recvtype, comm));
+}
+
+#if MPI_VERSION >= 3
+int MPI_Neighbor_alltoall(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                          void * recvbuf, int recvcount, MPI_Datatype recvtype,
+                          MPI_Comm comm) {
+  PROFILE(C_NEIGHBOR_ALLTOALL, 0.0,
+          PMPI_Neighbor_alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+                                 recvtype, comm));
+}
+
+int MPI_Neighbor_alltoallw(const void * sendbuf, const int sendcounts[],
+                           const MPI_Aint sdispls[], const MPI_Datatype sendtypes[],
+                           void * recvbuf, const int recvcounts[], const MPI_Aint rdispls[],
+                           const MPI_Datatype recvtypes[], MPI_Comm comm) {
+  PROFILE(C_NEIGHBOR_ALLTOALLW, 0.0,
+          PMPI_Neighbor_alltoallw(sendbuf, sendcounts, sdispls, sendtypes, recvbuf,
+                                  recvcounts, rdispls, recvtypes, comm));
+}
+#endif
+
+/* one-sided communication; windows remember the world ranks of their group     */
+
+int MPI_Win_create(void * base, MPI_Aint size, int disp_unit, MPI_Info info,
+                   MPI_Comm comm, MPI_Win * win) {
+  int rc = PMPI_Win_create(base, size, disp_unit, info, comm, win);
+  MPI_Group group;
+  if (enabled && rc == MPI_SUCCESS) {
+    PMPI_Win_get_group(*win, &group);
+    add_map(MPI_COMM_NULL, *win, group);
+    PMPI_Group_free(&group);
+  }
+  return rc;
+}
+
+#if MPI_VERSION >= 3
+int MPI_Win_allocate(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm,
+                     void * baseptr, MPI_Win * win) {
+  int rc = PMPI_Win_allocate(size, disp_unit, info, comm, baseptr, win);
+  MPI_Group group;
+  if (enabled && rc == MPI_SUCCESS) {
+    PMPI_Win_get_group(*win, &group);
+    add_map(MPI_COMM_NULL, *win, group);
+    PMPI_Group_free(&group);
+  }
+  return rc;
+}
+#endif
+
+int MPI_Win_free(MPI_Win * win) {
+  if (enabled) remove_map(MPI_COMM_NULL, *win);
+  return PMPI_Win_free(win);
+}
+
+int MPI_Put(CONST void * origin, int origin_count, MPI_Datatype origin_type,
+            int target, MPI_Aint disp, int target_count, MPI_Datatype target_type,
+            MPI_Win win) {
+  double bytes = type_bytes(origin_count, origin_type);
+  if (enabled) record_traffic(my_ID, win_world_rank(win, target), bytes);
+  PROFILE(C_PUT, bytes, PMPI_Put(origin, origin_count, origin_type, target, disp,
+                                 target_count, target_type, win));
+}
+
+int MPI_Get(void * origin, int origin_count, MPI_Datatype origin_type,
+            int target, MPI_Aint disp, int target_count, MPI_Datatype target_type,
+            MPI_Win win) {
+  double bytes = type_bytes(origin_count, origin_type);
+  if (enabled) record_traffic(win_world_rank(win, target), my_ID, bytes);
+  PROFILE(C_GET, bytes, PMPI_Get(origin, origin_count, origin_type, target, disp,
+                                 target_count, target_type, win));
+}
+
+int MPI_Accumulate(CONST void * origin, int origin_count, MPI_Datatype origin_type,
+                   int target, MPI_Aint disp, int target_count, MPI_Datatype target_type,
+                   MPI_Op op, MPI_Win win) {
+  double bytes = type_bytes(origin_count, origin_type);
+  if (enabled) record_traffic(my_ID, win_world_rank(win, target), bytes);
+  PROFILE(C_ACCUMULATE, bytes, PMPI_Accumulate(origin, origin_count, origin_type, target,
+                                               disp, target_count, target_type, op, win));
+}
+
+#if MPI_VERSION >= 3
+int MPI_Fetch_and_op(const void * origin, void * result, MPI_Datatype type, int target,
+                     MPI_Aint disp, MPI_Op op, MPI_Win win) {
+  double bytes = type_bytes(1, type);
+  if (enabled) record_traffic(my_ID, win_world_rank(win, target), bytes);
+  PROFILE(C_FETCH_AND_OP, bytes,
+          PMPI_Fetch_and_op(origin, result, type, target, disp, op, win));
+}
+
+int MPI_Compare_and_swap(const void * origin, const void * compare, void * result,
+                         MPI_Datatype type, int target, MPI_Aint disp, MPI_Win win) {
+  double bytes = type_bytes(1, type);
+  if (enabled) record_traffic(my_ID, win_world_rank(win, target), bytes);
+  PROFILE(C_COMPARE_AND_SWAP, bytes,
+          PMPI_Compare_and_swap(origin, compare, result, type, target, disp, win));
+}
+#endif
+
+/* one-sided synchronization                                                    */
+
+int MPI_Win_fence(int assert, MPI_Win win) {
+  PROFILE(C_WIN_FENCE, 0.0, PMPI_Win_fence(assert, win));
+}
+
+int MPI_Win_post(MPI_Group group, int assert, MPI_Win win) {
+  PROFILE(C_WIN_POST, 0.0, PMPI_Win_post(group, assert, win));
+}
+
+int MPI_Win_start(MPI_Group group, int assert, MPI_Win win) {
+  PROFILE(C_WIN_START, 0.0, PMPI_Win_start(group, assert, win));
+}
+
+int MPI_Win_complete(MPI_Win win) {
+  PROFILE(C_WIN_COMPLETE, 0.0, PMPI_Win_complete(win));
+}
+
+int MPI_Win_wait(MPI_Win win) {
+  PROFILE(C_WIN_WAIT, 0.0, PMPI_Win_wait(win));
+}
+
+int MPI_Win_lock(int lock_type, int rank, int assert, MPI_Win win) {
+  PROFILE(C_WIN_LOCK, 0.0, PMPI_Win_lock(lock_type, rank, assert, win));
+}
+
+int MPI_Win_unlock(int rank, MPI_Win win) {
+  PROFILE(C_WIN_UNLOCK, 0.0, PMPI_Win_unlock(rank, win));
+}
+
+#if MPI_VERSION >= 3
+int MPI_Win_lock_all(int assert, MPI_Win win) {
+  PROFILE(C_WIN_LOCK_ALL, 0.0, PMPI_Win_lock_all(assert, win));
+}
+
+int MPI_Win_unlock_all(MPI_Win win) {
+  PROFILE(C_WIN_UNLOCK_ALL, 0.0, PMPI_Win_unlock_all(win));
+}
+
+int MPI_Win_flush(int rank, MPI_Win win) {
+  PROFILE(C_WIN_FLUSH, 0.0, PMPI_Win_flush(rank, win));
+}
+
+int MPI_Win_flush_all(MPI_Win win) {
+  PROFILE(C_WIN_FLUSH_ALL, 0.0, PMPI_Win_flush_all(win));
+}
+
+int MPI_Win_flush_local(int rank, MPI_Win win) {
+  PROFILE(C_WIN_FLUSH_LOCAL, 0.0, PMPI_Win_flush_local(rank, win));
+}
+
+int MPI_Win_flush_local_all(MPI_Win win) {
+  PROFILE(C_WIN_FLUSH_LOCAL_ALL, 0.0, PMPI_Win_flush_local_all(win));
+}
+
+int MPI_Win_sync(MPI_Win win) {
+  PROFILE(C_WIN_SYNC, 0.0, PMPI_Win_sync(win));
+}
+#endif
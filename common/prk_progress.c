@@ -0,0 +1,191 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_progress
+
+Purpose:   Helper thread that polls the MPI library so that it makes
+           progress on outstanding communication while the rank
+           computes.  See include/prk_progress.h for the controls.
+
+Functions: prk_progress_init:     MPI_Init, plus the thread if requested
+           prk_progress_mode:     description of the thread, for output
+           prk_progress_stop:     stop the thread (called by bail_out)
+           prk_progress_finalize: stop the thread and call MPI_Finalize
+
+Notes:     Pinning uses pthread_setaffinity_np and is only available
+           on Linux.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#define _GNU_SOURCE
+#include <par-res-kern_general.h>
+#include <mpi.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+  #include <sched.h>
+#endif
+#include <prk_progress.h>
+
+enum { PRK_PROGRESS_NONE, PRK_PROGRESS_THREAD, PRK_PROGRESS_SPARE, PRK_PROGRESS_CPU };
+
+static int          running = 0;     /* nonzero while the thread polls         */
+static volatile int stop    = 0;     /* tells the thread to return             */
+static pthread_t    thread;
+static MPI_Comm     comm;            /* private duplicate of MPI_COMM_WORLD    */
+static int          cpu     = -1;    /* CPU the thread is pinned to, if any    */
+static long         pause_ns = 0;    /* pause between polls                    */
+static char         mode[64] = "none";
+
+static void * poll_loop(void * arg) {
+  struct timespec ts;
+  int             flag;
+
+  (void) arg;
+#if defined(__linux__)
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+      printf("WARNING: progress thread could not be pinned to CPU %d\n", cpu);
+  }
+#endif
+  ts.tv_sec  = pause_ns/1000000000L;
+  ts.tv_nsec = pause_ns%1000000000L;
+  while (!stop) {
+    /* nothing is ever sent on comm; the probe only drives the progress engine */
+    PMPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &flag, MPI_STATUS_IGNORE);
+    if (pause_ns > 0) nanosleep(&ts, NULL);
+  }
+  return NULL;
+}
+
+/* rank of the caller among the ranks on its node                         */
+static int local_rank(void) {
+  int rank = 0;
+#if MPI_VERSION >= 3
+  MPI_Comm node;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+  MPI_Comm_rank(node, &rank);
+  MPI_Comm_free(&node);
+#endif
+  return rank;
+}
+
+int prk_progress_init(int * argc, char *** argv) {
+
+  char * env = getenv("PRK_PROGRESS");
+  int    kind = PRK_PROGRESS_NONE, provided, rank, first = 0, ncpus, rc;
+
+  if (env != NULL && *env != '\0' && strcmp(env, "0")) {
+    if      (!strcmp(env, "1"))          kind = PRK_PROGRESS_THREAD;
+    else if (!strcmp(env, "spare"))      kind = PRK_PROGRESS_SPARE;
+    else if (!strncmp(env, "cpu:", 4)) { kind = PRK_PROGRESS_CPU; first = atoi(env+4); }
+  }
+  if (kind == PRK_PROGRESS_NONE) {
+    rc = MPI_Init(argc, argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (env != NULL && *env != '\0' && strcmp(env, "0") && rank == 0)
+      printf("WARNING: unknown PRK_PROGRESS=%s ignored\n", env);
+    return rc;
+  }
+
+  rc = MPI_Init_thread(argc, argv, MPI_THREAD_MULTIPLE, &provided);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (provided < MPI_THREAD_MULTIPLE) {
+    if (rank == 0)
+      printf("WARNING: PRK_PROGRESS needs MPI_THREAD_MULTIPLE, which MPI does not "
+             "provide; no progress thread started\n");
+    snprintf(mode, sizeof(mode), "none (no MPI_THREAD_MULTIPLE)");
+    return rc;
+  }
+
+  env = getenv("PRK_PROGRESS_SLEEP");
+  if (env != NULL) pause_ns = 1000L*MAX(0, atol(env));
+
+  ncpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (ncpus < 1) ncpus = 1;
+  switch (kind) {
+  case PRK_PROGRESS_SPARE:
+    cpu = ncpus-1 - local_rank()%ncpus;
+    snprintf(mode, sizeof(mode), "pinned to a spare core");
+    break;
+  case PRK_PROGRESS_CPU:
+    cpu = (first + local_rank())%ncpus;
+    snprintf(mode, sizeof(mode), "pinned to CPU %d + local rank", first);
+    break;
+  default:
+    local_rank();         /* collective, so every rank calls it           */
+    snprintf(mode, sizeof(mode), "unpinned");
+  }
+#if !defined(__linux__)
+  if (cpu >= 0 && rank == 0)
+    printf("WARNING: progress thread pinning is only supported on Linux\n");
+  cpu = -1;
+#endif
+  if (pause_ns > 0) {
+    int len = strlen(mode);
+    snprintf(mode+len, sizeof(mode)-len, ", %ld us between polls", pause_ns/1000);
+  }
+
+  MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+  stop = 0;
+  if (pthread_create(&thread, NULL, poll_loop, NULL)) {
+    printf("WARNING: rank %d could not start a progress thread\n", rank);
+    MPI_Comm_free(&comm);
+    return rc;
+  }
+  running = 1;
+  return rc;
+}
+
+const char * prk_progress_mode(void) {
+  return mode;
+}
+
+void prk_progress_stop(void) {
+  if (!running) return;
+  stop = 1;
+  pthread_join(thread, NULL);
+  MPI_Comm_free(&comm);
+  running = 0;
+}
+
+int prk_progress_finalize(void) {
+  prk_progress_stop();
+  return MPI_Finalize();
+}
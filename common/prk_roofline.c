@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_roofline
+
+Purpose:   Measure the memory bandwidth and peak floating point rate of
+           the calling process.  See include/prk_roofline.h for usage.
+
+Functions: prk_roofline_enabled: check PRK_ROOFLINE
+           prk_roofline_probe:   bandwidth (bytes/s) and peak rate
+                                 (flop/s), measured once and cached
+           triad:                Nstream triad, as in OPENMP/Nstream
+           microkernel:          MR x NR block of C updated with rank-1
+                                 updates from packed, cache-resident
+                                 panels of A and B
+
+Notes:     The triad counts 4 words per element, like Nstream.  Both
+           probes report the best of PROBE_TRIALS runs with all threads
+           working concurrently.  The microkernel is written so that the
+           compiler can keep the block of C in vector registers; rates
+           close to the vendor peak need -O3 and the proper -march.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_roofline.h>
+
+#if defined(_OPENMP)
+  #include <omp.h>
+#endif
+
+#define PROBE_TRIALS  5
+#define PROBE_LENGTH  (1L<<22)
+#define MR            4
+#define NR            8
+#define KC            256
+
+/* keeps the compiler from discarding the microkernel                   */
+static volatile double roofline_sink;
+
+int prk_roofline_enabled(void)
+{
+    char * env = getenv("PRK_ROOFLINE");
+    return env != NULL && *env != '\0' && strcmp(env,"0");
+}
+
+static double env_rate(const char * name)
+{
+    char * env = getenv(name);
+    return (env != NULL) ? 1.0E9*atof(env) : 0.0;
+}
+
+static double triad(long length)
+{
+    double * RESTRICT a = (double *) malloc(3*length*sizeof(double));
+    double * RESTRICT b, * RESTRICT c;
+    double   best = 0.0, t, scalar = 3.0;
+    long     j;
+    int      trial;
+
+    if (a == NULL) {
+        printf("WARNING: no memory for the roofline bandwidth probe\n");
+        return 0.0;
+    }
+    b = a + length;
+    c = b + length;
+    #pragma omp parallel for private(j)
+    for (j=0; j<length; j++) {
+        a[j] = 0.0;
+        b[j] = 2.0;
+        c[j] = 2.0;
+    }
+    /* the first trial faults in the pages and warms up the threads       */
+    for (trial=0; trial<=PROBE_TRIALS; trial++) {
+        t = wtime();
+        #pragma omp parallel for private(j)
+        for (j=0; j<length; j++) a[j] += b[j]+scalar*c[j];
+        t = wtime() - t;
+        if (trial > 0 && t > 0.0 && 4.0*sizeof(double)*length/t > best)
+            best = 4.0*sizeof(double)*length/t;
+    }
+    free(a);
+    return best;
+}
+
+static double microkernel(const double * RESTRICT a, const double * RESTRICT b,
+                          long reps)
+{
+    double c[MR][NR], sum = 0.0;
+    long   r;
+    int    i, j, k;
+
+    for (i=0; i<MR; i++) for (j=0; j<NR; j++) c[i][j] = 0.0;
+    for (r=0; r<reps; r++) {
+        for (k=0; k<KC; k++) {
+            for (i=0; i<MR; i++) {
+                for (j=0; j<NR; j++) c[i][j] += a[k*MR+i]*b[k*NR+j];
+            }
+        }
+    }
+    for (i=0; i<MR; i++) for (j=0; j<NR; j++) sum += c[i][j];
+    return sum;
+}
+
+static double peak_flops(void)
+{
+    double best = 0.0, t, sink = 0.0;
+    long   reps = 64;
+    int    trial, nthreads = 1;
+
+    /* calibrate on one thread so that a trial takes about 20 ms          */
+    {
+        double a[KC*MR], b[KC*NR];
+        int    k;
+        for (k=0; k<KC*MR; k++) a[k] = 1.0E-9*k;
+        for (k=0; k<KC*NR; k++) b[k] = 1.0E-9*k;
+        do {
+            reps *= 2;
+            t = wtime();
+            sink += microkernel(a, b, reps);
+            t = wtime() - t;
+        } while (t < 0.02 && reps < (1L<<30));
+    }
+
+    for (trial=0; trial<PROBE_TRIALS; trial++) {
+        t = wtime();
+        #pragma omp parallel reduction(+:sink)
+        {
+            double a[KC*MR], b[KC*NR];
+            int    k;
+            for (k=0; k<KC*MR; k++) a[k] = 1.0E-9*k;
+            for (k=0; k<KC*NR; k++) b[k] = 1.0E-9*k;
+            sink += microkernel(a, b, reps);
+#if defined(_OPENMP)
+            #pragma omp master
+            nthreads = omp_get_num_threads();
+#endif
+        }
+        t = wtime() - t;
+        if (t > 0.0 && 2.0*MR*NR*KC*reps*nthreads/t > best)
+            best = 2.0*MR*NR*KC*reps*nthreads/t;
+    }
+    roofline_sink = sink;
+    return best;
+}
+
+void prk_roofline_probe(double * bandwidth, double * flops)
+{
+    static double bw = -1.0, peak = -1.0;
+    char   *env;
+    long   length;
+
+    if (bw < 0.0) {
+        bw = env_rate("PRK_ROOFLINE_BANDWIDTH");
+        if (bw <= 0.0) {
+            env    = getenv("PRK_ROOFLINE_LENGTH");
+            length = (env != NULL && atol(env) > 0) ? atol(env) : PROBE_LENGTH;
+            bw     = triad(length);
+        }
+        peak = env_rate("PRK_ROOFLINE_PEAK");
+        if (peak <= 0.0) peak = peak_flops();
+    }
+    *bandwidth = bw;
+    *flops     = peak;
+}
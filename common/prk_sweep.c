@@ -0,0 +1,153 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      prk_sweep
+
+Purpose:   In-process scaling sweeps over thread counts.  See
+           include/prk_sweep.h for usage.
+
+Functions: prk_sweep_init:    parse PRK_SWEEP and PRK_SWEEP_MODE
+           prk_sweep_scale:   work factor of a configuration
+           prk_sweep_discard: release the pages of an array, so that the
+                              next touch places them anew
+           prk_sweep_record:  store the results of a configuration
+           prk_sweep_report:  print the scaling table
+           prk_sweep_unsupported: stop kernels without sweeps when
+                              PRK_SWEEP is set
+
+Notes:     Pages are released with madvise(MADV_DONTNEED), which keeps
+           the address range valid and makes the next access fault in
+           zero-filled pages; elsewhere prk_sweep_discard does nothing
+           and pages stay where the first configuration put them.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#if defined(__linux__)
+  #ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+  #endif
+  #include <sys/mman.h>
+#endif
+
+#include <par-res-kern_general.h>
+#include <stdint.h>
+#include <prk_sweep.h>
+
+/* returns 1 and fills the list of configurations if a sweep is requested */
+int prk_sweep_init(prk_sweep_t * s, int max_threads)
+{
+    char * list = getenv("PRK_SWEEP");
+    char * mode = getenv("PRK_SWEEP_MODE");
+    char * c;
+    int    t;
+
+    s->count = 0;
+    s->weak  = (mode != NULL && !strcmp(mode,"weak"));
+    if (mode != NULL && !s->weak && strcmp(mode,"strong"))
+        printf("WARNING: unknown PRK_SWEEP_MODE=%s, using strong scaling\n", mode);
+    if (list == NULL || *list == '\0' || !strcmp(list,"0")) return 0;
+
+    if (!strcmp(list,"pow2")) {
+        for (t=1; t<max_threads && s->count<PRK_SWEEP_MAX-1; t*=2) s->threads[s->count++] = t;
+        s->threads[s->count++] = max_threads;
+    }
+    else {
+        for (c=list; *c != '\0' && s->count<PRK_SWEEP_MAX; ) {
+            t = atoi(c);
+            if (t < 1 || t > max_threads) {
+                printf("WARNING: thread count %d in PRK_SWEEP outside 1..%d ignored\n", t, max_threads);
+            }
+            else s->threads[s->count++] = t;
+            while (*c != ',' && *c != '\0') c++;
+            if (*c == ',') c++;
+        }
+    }
+    for (t=0; t<s->count; t++) s->valid[t] = 0;
+    return s->count > 0;
+}
+
+/* factor by which the work of configuration i exceeds that of the first */
+double prk_sweep_scale(const prk_sweep_t * s, int i)
+{
+    return s->weak ? (double) s->threads[i] / (double) s->threads[0] : 1.0;
+}
+
+void prk_sweep_discard(void * p, size_t bytes)
+{
+#if defined(__linux__) && defined(MADV_DONTNEED)
+    size_t    page  = (size_t) sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t) p + page - 1) & ~(uintptr_t) (page-1);
+    uintptr_t end   = ((uintptr_t) p + bytes) & ~(uintptr_t) (page-1);
+
+    /* only whole pages inside the array can be released */
+    if (end > start) madvise((void *) start, end-start, MADV_DONTNEED);
+#endif
+}
+
+void prk_sweep_record(prk_sweep_t * s, int i, double size, double time, double rate, int valid)
+{
+    s->size[i]  = size;
+    s->time[i]  = time;
+    s->rate[i]  = rate;
+    s->valid[i] = valid;
+}
+
+void prk_sweep_report(const prk_sweep_t * s, const char * kernel, const char * size_name,
+                      const char * units)
+{
+    int    i;
+    double speedup;
+
+    printf("%s scaling sweep for %s\n", s->weak ? "Weak" : "Strong", kernel);
+    printf("%8s %14s %14s %14s %9s %11s\n", "threads", size_name, "avg time (s)", units,
+           "speedup", "efficiency");
+    for (i=0; i<s->count; i++) {
+        speedup = s->rate[i]/s->rate[0];
+        printf("%8d %14.0lf %14lf %14lf %9.3lf %11.3lf%s\n", s->threads[i], s->size[i], s->time[i],
+               s->rate[i], speedup, speedup*s->threads[0]/s->threads[i],
+               s->valid[i] ? "" : "  (did not validate)");
+    }
+}
+
+/* kernels without sweeps stop here, rather than quietly run a single
+   configuration that looks like a scaling study                          */
+void prk_sweep_unsupported(const char * kernel)
+{
+    char * list = getenv("PRK_SWEEP");
+
+    if (list == NULL || *list == '\0' || !strcmp(list,"0")) return;
+    printf("ERROR: %s does not support scaling sweeps (PRK_SWEEP=%s)\n", kernel, list);
+    exit(EXIT_FAILURE);
+}
@@ -32,20 +32,34 @@ POSSIBILITY OF SUCH DAMAGE.
 
 /**********************************************************************
 
-Name:      LCG
+Name:      LCG, Philox
 
 Purpose:   Provide a mixed Linear Congruential Generator of pseudo-random
            numbers with a period of 2^64, plus tools to jump ahead in a sequence
            of such generated numbers. For details, see individual functions.
+           Also provide the counter-based Philox4x32-10 generator (Salmon et
+           al., SC'11), whose n-th number is a pure function of n and the
+           seed, so that jumps take constant time and batches of numbers can
+           be generated with SIMD instructions.
 
 Functions: LCG_next:      a new pseudo-randon number
            LCG_get_chunk: return subset of an interval of natural numbers
            LCG_init:      initialize the generator
            LCG_jump:      jump ahead into a sequence of pseudo-random numbers
-           random_draw:
+           random_draw:   draw a number of particles with mean mu (LCG)
+           philox_init:   initialize a Philox generator from a seed
+           philox_jump:   jump to the m-th 64-bit number of the stream
+           philox_next:   a new pseudo-random number
+           philox_fill:   a batch of consecutive pseudo-random numbers
+           random_draw_philox: as random_draw, using a Philox generator
+           random_draw_vector: a batch of draws with the same mean
 
 Notes:     LCG_init must be called by each thread or rank before any jump 
-           into a sequence of pseudo-random numbers is made
+           into a sequence of pseudo-random numbers is made. The LCG is kept
+           unchanged so that old results can be reproduced. Philox state is
+           passed explicitly, so each thread can own a generator; a draw
+           consumes two 64-bit numbers with either generator, so the draw
+           with index i starts at jump 2*i.
 
 History:   Written by Rob Van der Wijngaart, December 2015
 
@@ -191,3 +205,112 @@ uint64_t random_draw(double mu)
   }
 
 }
+
+/* Philox4x32 multipliers and Weyl key increments                           */
+#define PHILOX_M0 UINT64_C(0xD2511F53)
+#define PHILOX_M1 UINT64_C(0xCD9E8D57)
+#define PHILOX_W0 UINT32_C(0x9E3779B9)
+#define PHILOX_W1 UINT32_C(0xBB67AE85)
+#define PHILOX_ROUNDS 10
+
+/* encrypt counters first..first+n-1 and store two 64-bit words per counter;
+   the loop body has no dependences between counters, so the compiler can
+   map it onto vector lanes (32x32->64 bit multiplies)                     */
+static void philox_blocks(const uint32_t key[2], uint64_t first, uint64_t n,
+                          uint64_t * restrict out)
+{
+  uint64_t i;
+  const uint32_t k0 = key[0], k1 = key[1];
+
+  for (i=0; i<n; i++) {
+    uint64_t ctr = first+i, p0, p1;
+    uint32_t c0 = (uint32_t) ctr, c1 = (uint32_t) (ctr>>32), c2 = 0, c3 = 0;
+    uint32_t key0 = k0, key1 = k1;
+    int      r;
+    for (r=0; r<PHILOX_ROUNDS; r++) {
+      p0 = PHILOX_M0 * c0;
+      p1 = PHILOX_M1 * c2;
+      c0 = (uint32_t) (p1>>32) ^ c1 ^ key0;
+      c1 = (uint32_t) p1;
+      c2 = (uint32_t) (p0>>32) ^ c3 ^ key1;
+      c3 = (uint32_t) p0;
+      key0 += PHILOX_W0;
+      key1 += PHILOX_W1;
+    }
+    out[2*i]   = ((uint64_t) c1 << 32) | c0;
+    out[2*i+1] = ((uint64_t) c3 << 32) | c2;
+  }
+}
+
+void philox_init(philox_t *s, uint64_t seed) {
+  s->key[0] = (uint32_t) seed;
+  s->key[1] = (uint32_t) (seed>>32);
+  s->word   = 0;
+}
+
+void philox_jump(philox_t *s, uint64_t m) {
+  s->word = m;
+}
+
+uint64_t philox_next(philox_t *s, uint64_t bound) {
+  uint64_t block[2];
+  philox_blocks(s->key, s->word>>1, 1, block);
+  return block[(s->word++)&1]%bound;
+}
+
+/* store the next n 64-bit numbers of the stream in draws                  */
+void philox_fill(philox_t *s, uint64_t n, uint64_t *draws) {
+  uint64_t block[2];
+
+  if (n==0) return;
+  /* peel off a leading odd word, so that the bulk starts on a counter     */
+  if (s->word&1) {
+    draws[0] = philox_next(s, UINT64_MAX);
+    draws++; n--;
+  }
+  philox_blocks(s->key, s->word>>1, n>>1, draws);
+  s->word += n & ~(uint64_t)1;
+  if (n&1) draws[n-1] = philox_next(s, UINT64_MAX);
+}
+
+/* map a 64-bit number to the open interval (0,1)                           */
+static inline double philox_uniform(uint64_t w) {
+  return ((double) (w>>11) + 0.5) * (1.0/9007199254740992.0);
+}
+
+static inline uint64_t philox_transform(double mu, uint64_t w0, uint64_t w1) {
+  const double   two_pi      = 2.0*3.14159265358979323846;
+  const uint64_t denominator = UINT_MAX;
+  double         u0, u1, z0;
+
+  if (mu>=1.0) {
+    u0 = philox_uniform(w0);
+    u1 = philox_uniform(w1);
+    z0 = sqrt(-2.0 * log(u0)) * cos(two_pi * u1);
+    return (uint64_t) (z0 * mu*0.15 + mu+0.5);
+  }
+  else {
+    uint64_t numerator = (uint32_t) (mu*(double)denominator);
+    return ((uint64_t)(w1%denominator<=numerator));
+  }
+}
+
+uint64_t random_draw_philox(philox_t *s, double mu) {
+  uint64_t w[2];
+  philox_fill(s, 2, w);
+  return philox_transform(mu, w[0], w[1]);
+}
+
+/* n draws with mean mu; random numbers are generated in chunks on the stack
+   so that both the generator and the transformation run over arrays       */
+#define PHILOX_CHUNK 256
+void random_draw_vector(philox_t *s, double mu, uint64_t n, uint64_t *draws) {
+  uint64_t w[2*PHILOX_CHUNK];
+  uint64_t i, j, len;
+
+  for (i=0; i<n; i+=len) {
+    len = MIN(n-i, PHILOX_CHUNK);
+    philox_fill(s, 2*len, w);
+    for (j=0; j<len; j++) draws[i+j] = philox_transform(mu, w[2*j], w[2*j+1]);
+  }
+}
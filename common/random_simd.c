@@ -0,0 +1,153 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      random_simd
+
+Purpose:   Batched update kernels for the Random Access kernels, and
+           their selection at startup.  See include/prk_random_simd.h
+           for usage.
+
+Functions: prk_random_simd_isa:  name of the selected instruction set
+           prk_random_simd:      update kernel
+           select_isa:           pick the best instruction set that the
+                                 CPU supports and PRK_SIMD allows
+
+Notes:     As in transpose_simd.c, the vector kernel is compiled with a
+           target attribute, so that no special compiler flags are needed
+           and the binary runs on CPUs without AVX-512.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_random_simd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define PRK_SIMD_X86 1
+  #include <immintrin.h>
+#endif
+
+#if defined(__GNUC__)
+  #define PREFETCH(p) __builtin_prefetch((p), 1, 0)
+#else
+  #define PREFETCH(p)
+#endif
+
+enum { ISA_UNSET, ISA_SCALAR, ISA_AVX512 };
+
+static int isa = ISA_UNSET;
+
+static void update_scalar(u64Int *Table, s64Int tablesize, const u64Int *ran,
+                          s64Int n, int distance) {
+  s64Int k, mask = tablesize-1;
+
+  for (k=0; k<n-distance; k++) {
+    PREFETCH(&Table[ran[k+distance]&mask]);
+    Table[ran[k]&mask] ^= ran[k];
+  }
+  for (k=MAX(n-distance,0); k<n; k++) Table[ran[k]&mask] ^= ran[k];
+}
+
+#if PRK_SIMD_X86
+
+__attribute__((target("avx512f,avx512cd")))
+static void update_avx512(u64Int *Table, s64Int tablesize, const u64Int *ran,
+                          s64Int n, int distance) {
+  s64Int  k, l, mask = tablesize-1;
+  __m512i r, index, conflict, t;
+  const __m512i vmask = _mm512_set1_epi64(mask);
+
+  for (k=0; k+8<=n; k+=8) {
+    for (l=k+distance; l<MIN(k+distance+8,n); l++) PREFETCH(&Table[ran[l]&mask]);
+    r        = _mm512_loadu_si512((const void *) (ran+k));
+    index    = _mm512_and_si512(r, vmask);
+    conflict = _mm512_conflict_epi64(index);
+    if (_mm512_test_epi64_mask(conflict, conflict) == 0) {
+      t = _mm512_i64gather_epi64(index, (const void *) Table, 8);
+      _mm512_i64scatter_epi64((void *) Table, index, _mm512_xor_si512(t, r), 8);
+    }
+    else for (l=k; l<k+8; l++) Table[ran[l]&mask] ^= ran[l];
+  }
+  for (; k<n; k++) Table[ran[k]&mask] ^= ran[k];
+}
+
+#endif /* PRK_SIMD_X86 */
+
+static const char * isa_names[] = {"", "scalar", "avx512"};
+
+static int supported(int which)
+{
+    switch (which) {
+      case ISA_SCALAR: return 1;
+#if PRK_SIMD_X86
+      case ISA_AVX512: return __builtin_cpu_supports("avx512f") &&
+                              __builtin_cpu_supports("avx512cd");
+#endif
+      default:         return 0;
+    }
+}
+
+static void select_isa(void)
+{
+    char * env = getenv("PRK_SIMD");
+    int    which;
+
+    if (isa != ISA_UNSET) return;
+    if (env != NULL && *env != '\0') {
+        for (which=ISA_SCALAR; which<=ISA_AVX512; which++)
+            if (!strcmp(env, isa_names[which])) break;
+        if (which <= ISA_AVX512 && supported(which)) {
+            isa = which;
+            return;
+        }
+        printf("WARNING: PRK_SIMD=%s is not available, selecting automatically\n", env);
+    }
+    for (which=ISA_AVX512; which>ISA_SCALAR; which--) if (supported(which)) break;
+    isa = which;
+}
+
+const char * prk_random_simd_isa(void)
+{
+    select_isa();
+    return isa_names[isa];
+}
+
+prk_random_update_t prk_random_simd(void)
+{
+    select_isa();
+    switch (isa) {
+#if PRK_SIMD_X86
+      case ISA_AVX512: return update_avx512;
+#endif
+      default:         return update_scalar;
+    }
+}
@@ -0,0 +1,383 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      stencil_simd
+
+Purpose:   Vectorized row kernels for the Stencil kernels, and their
+           selection at startup.  See include/prk_stencil_simd.h for
+           usage.
+
+Functions: prk_stencil_simd_isa:    name of the selected instruction set
+           prk_stencil_simd_double: row kernel for double precision
+           prk_stencil_simd_float:  row kernel for single precision
+           prk_stencil_simd_mixed:  row kernel for single precision
+                                    storage, double precision sums
+           prk_stencil_simd_half:   row kernel for half precision
+                                    storage, double precision sums
+           select_isa:              pick the best instruction set that the
+                                    CPU supports and PRK_SIMD allows
+
+Notes:     The kernels themselves are in stencil_simd.incl, which is
+           included once per instruction set and data type.  On x86 the
+           AVX2 and AVX-512 kernels are compiled with target attributes,
+           so no special compiler flags are needed and the binary runs
+           on CPUs without these extensions; the CPU is queried with
+           __builtin_cpu_supports.  The SVE kernels are vector length
+           agnostic and are only compiled when the compiler targets SVE
+           (e.g. -march=armv8-a+sve), in which case the CPU supports it.
+           The mixed precision kernels convert every vector of the grid
+           to double precision on load and back on store; they exist for
+           AVX2 and AVX-512 only, the half precision ones need F16C.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_stencil_simd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define PRK_SIMD_X86 1
+  #include <immintrin.h>
+#endif
+#if defined(__ARM_FEATURE_SVE)
+  #define PRK_SIMD_SVE 1
+  #include <arm_sve.h>
+#endif
+
+enum { ISA_UNSET, ISA_SCALAR, ISA_AVX2, ISA_AVX512, ISA_SVE };
+
+static int isa = ISA_UNSET;
+
+#if PRK_SIMD_X86
+
+#define TARGET       __attribute__((target("avx2,fma")))
+#define VDECL
+#define T            double
+#define VEC          __m256d
+#define VLEN         4
+#define LOADU(p)     _mm256_loadu_pd(p)
+#define STOREU(p,v)  _mm256_storeu_pd(p,v)
+#define SET1(x)      _mm256_set1_pd(x)
+#define FMA(a,b,c)   _mm256_fmadd_pd(a,b,c)
+#define NAME(shape)  row_avx2_double_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef VEC
+#undef VLEN
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+
+#define T            float
+#define VEC          __m256
+#define VLEN         8
+#define LOADU(p)     _mm256_loadu_ps(p)
+#define STOREU(p,v)  _mm256_storeu_ps(p,v)
+#define SET1(x)      _mm256_set1_ps(x)
+#define FMA(a,b,c)   _mm256_fmadd_ps(a,b,c)
+#define NAME(shape)  row_avx2_float_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef VEC
+#undef VLEN
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+#undef TARGET
+
+#define TARGET       __attribute__((target("avx512f")))
+#define T            double
+#define VEC          __m512d
+#define VLEN         8
+#define LOADU(p)     _mm512_loadu_pd(p)
+#define STOREU(p,v)  _mm512_storeu_pd(p,v)
+#define SET1(x)      _mm512_set1_pd(x)
+#define FMA(a,b,c)   _mm512_fmadd_pd(a,b,c)
+#define NAME(shape)  row_avx512_double_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef VEC
+#undef VLEN
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+
+#define T            float
+#define VEC          __m512
+#define VLEN         16
+#define LOADU(p)     _mm512_loadu_ps(p)
+#define STOREU(p,v)  _mm512_storeu_ps(p,v)
+#define SET1(x)      _mm512_set1_ps(x)
+#define FMA(a,b,c)   _mm512_fmadd_ps(a,b,c)
+#define NAME(shape)  row_avx512_float_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef VEC
+#undef VLEN
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+#undef TARGET
+
+#define ACC          double
+
+#define TARGET       __attribute__((target("avx2,fma")))
+#define T            float
+#define VEC          __m256d
+#define VLEN         4
+#define LOADU(p)     _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define STOREU(p,v)  _mm_storeu_ps(p,_mm256_cvtpd_ps(v))
+#define SET1(x)      _mm256_set1_pd(x)
+#define FMA(a,b,c)   _mm256_fmadd_pd(a,b,c)
+#define NAME(shape)  row_avx2_mixed_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef LOADU
+#undef STOREU
+#undef NAME
+#undef TARGET
+
+#ifdef __FLT16_MAX__
+#define TARGET       __attribute__((target("avx2,fma,f16c")))
+#define T            _Float16
+#define LOADU(p)     _mm256_cvtps_pd(_mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)(p))))
+#define STOREU(p,v)  _mm_storel_epi64((__m128i *)(p),_mm_cvtps_ph(_mm256_cvtpd_ps(v), \
+                     _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC))
+#define NAME(shape)  row_avx2_half_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef LOADU
+#undef STOREU
+#undef NAME
+#undef TARGET
+#endif
+#undef VEC
+#undef VLEN
+#undef SET1
+#undef FMA
+
+#define TARGET       __attribute__((target("avx512f")))
+#define T            float
+#define VEC          __m512d
+#define VLEN         8
+#define LOADU(p)     _mm512_cvtps_pd(_mm256_loadu_ps(p))
+#define STOREU(p,v)  _mm256_storeu_ps(p,_mm512_cvtpd_ps(v))
+#define SET1(x)      _mm512_set1_pd(x)
+#define FMA(a,b,c)   _mm512_fmadd_pd(a,b,c)
+#define NAME(shape)  row_avx512_mixed_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef LOADU
+#undef STOREU
+#undef NAME
+#undef TARGET
+
+#ifdef __FLT16_MAX__
+#define TARGET       __attribute__((target("avx512f,f16c")))
+#define T            _Float16
+#define LOADU(p)     _mm512_cvtps_pd(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(p))))
+#define STOREU(p,v)  _mm_storeu_si128((__m128i *)(p),_mm256_cvtps_ph(_mm512_cvtpd_ps(v), \
+                     _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC))
+#define NAME(shape)  row_avx512_half_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef LOADU
+#undef STOREU
+#undef NAME
+#undef TARGET
+#endif
+#undef VEC
+#undef VLEN
+#undef SET1
+#undef FMA
+#undef ACC
+#undef VDECL
+
+#endif /* PRK_SIMD_X86 */
+
+#if PRK_SIMD_SVE
+
+#define TARGET
+#define T            double
+#define VEC          svfloat64_t
+#define VLEN         vlen
+#define VDECL        const long vlen = (long) svcntd(); \
+                     const svbool_t pg = svptrue_b64();
+#define LOADU(p)     svld1_f64(pg,p)
+#define STOREU(p,v)  svst1_f64(pg,p,v)
+#define SET1(x)      svdup_f64(x)
+#define FMA(a,b,c)   svmla_f64_x(pg,c,a,b)
+#define NAME(shape)  row_sve_double_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef VEC
+#undef VDECL
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+
+#define T            float
+#define VEC          svfloat32_t
+#define VDECL        const long vlen = (long) svcntw(); \
+                     const svbool_t pg = svptrue_b32();
+#define LOADU(p)     svld1_f32(pg,p)
+#define STOREU(p,v)  svst1_f32(pg,p,v)
+#define SET1(x)      svdup_f32(x)
+#define FMA(a,b,c)   svmla_f32_x(pg,c,a,b)
+#define NAME(shape)  row_sve_float_##shape
+#include "stencil_simd.incl"
+#undef T
+#undef VEC
+#undef VDECL
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef FMA
+#undef NAME
+#undef VLEN
+#undef TARGET
+
+#endif /* PRK_SIMD_SVE */
+
+static const char * isa_names[] = {"", "scalar", "avx2", "avx512", "sve"};
+
+static int supported(int which)
+{
+    switch (which) {
+      case ISA_SCALAR: return 1;
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return __builtin_cpu_supports("avx2") &&
+                              __builtin_cpu_supports("fma");
+      case ISA_AVX512: return __builtin_cpu_supports("avx512f");
+#endif
+#if PRK_SIMD_SVE
+      case ISA_SVE:    return 1;
+#endif
+      default:         return 0;
+    }
+}
+
+static void select_isa(void)
+{
+    char * env = getenv("PRK_SIMD");
+    int    which;
+
+    if (isa != ISA_UNSET) return;
+    if (env != NULL && *env != '\0') {
+        for (which=ISA_SCALAR; which<=ISA_SVE; which++)
+            if (!strcmp(env, isa_names[which])) break;
+        if (which <= ISA_SVE && supported(which)) {
+            isa = which;
+            return;
+        }
+        printf("WARNING: PRK_SIMD=%s is not available, selecting automatically\n", env);
+    }
+    for (which=ISA_SVE; which>ISA_SCALAR; which--) if (supported(which)) break;
+    isa = which;
+}
+
+const char * prk_stencil_simd_isa(void)
+{
+    select_isa();
+    return isa_names[isa];
+}
+
+prk_stencil_row_double_t prk_stencil_simd_double(int star)
+{
+    select_isa();
+    switch (isa) {
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return star ? row_avx2_double_star   : row_avx2_double_compact;
+      case ISA_AVX512: return star ? row_avx512_double_star : row_avx512_double_compact;
+#endif
+#if PRK_SIMD_SVE
+      case ISA_SVE:    return star ? row_sve_double_star    : row_sve_double_compact;
+#endif
+      default:         return NULL;
+    }
+}
+
+prk_stencil_row_float_t prk_stencil_simd_float(int star)
+{
+    select_isa();
+    switch (isa) {
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return star ? row_avx2_float_star   : row_avx2_float_compact;
+      case ISA_AVX512: return star ? row_avx512_float_star : row_avx512_float_compact;
+#endif
+#if PRK_SIMD_SVE
+      case ISA_SVE:    return star ? row_sve_float_star    : row_sve_float_compact;
+#endif
+      default:         return NULL;
+    }
+}
+
+prk_stencil_row_mixed_t prk_stencil_simd_mixed(int star)
+{
+    select_isa();
+    switch (isa) {
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return star ? row_avx2_mixed_star   : row_avx2_mixed_compact;
+      case ISA_AVX512: return star ? row_avx512_mixed_star : row_avx512_mixed_compact;
+#endif
+      default:         return NULL;
+    }
+}
+
+#ifdef __FLT16_MAX__
+prk_stencil_row_half_t prk_stencil_simd_half(int star)
+{
+    select_isa();
+#if PRK_SIMD_X86
+    if (!__builtin_cpu_supports("f16c")) return NULL;
+#endif
+    switch (isa) {
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return star ? row_avx2_half_star   : row_avx2_half_compact;
+      case ISA_AVX512: return star ? row_avx512_half_star : row_avx512_half_compact;
+#endif
+      default:         return NULL;
+    }
+}
+#endif
@@ -41,6 +41,13 @@ Arguments: File to which the information is to be written
 
 Returns:   None.
 
+Functions: print_topology:      machine coordinates or host name
+           prk_topology_host:   name of the node, for labeling output
+           prk_topology_bind:   pin ranks and threads, see prk_topology.h
+           prk_topology_report: core, socket, NUMA node and GPU affinity
+                                of every rank and thread
+           prk_topology_socket: socket on which the calling thread runs
+
 Notes:     Currently, physics topology information is only available
            for Cray XC systems.  It's not easy to get this info
            on InfiniBand clusters (requires admin rights) and we
@@ -50,19 +57,36 @@ Notes:     Currently, physics topology information is only available
            should work with MPI, UPC, SHMEM, etc.
            Otherwise, MPI is required.
 
+           Pinning uses hwloc (-DPRK_HWLOC, see HWLOCTOP in make.defs);
+           the report falls back on Linux sysfs without it.
+
 History:   Written by Jeff Hammond, August 2015.
 
 ****************************************************************/
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
-#if defined(__CRAYXC)
-#elif defined(MPI)
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sched.h>
+#include <dirent.h>
+#if defined(MPI)
   #include "mpi.h"
-#else
-  #include <unistd.h>
+#endif
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+#ifdef PRK_HWLOC
+  #include <hwloc.h>
+#endif
+#ifndef HOST_NAME_MAX
+  #define HOST_NAME_MAX 255
 #endif
 
+#include <prk_topology.h>
+
 
 void print_topology(FILE * output, int label)
 {
@@ -89,16 +113,347 @@ void print_topology(FILE * output, int label)
         /* see http://www.mpich.org/static/docs/v3.1/www3/MPI_Get_processor_name.html */
         int len;
         char procname[MPI_MAX_PROCESSOR_NAME];
-        MPI_Get_processor_name(&procname,&len);
+        MPI_Get_processor_name(procname,&len);
         fprintf(output,"%d: MPI proc name =  %s\n", label, procname);
     }
 #else
     {
         /* see http://linux.die.net/man/2/gethostname */
         char procname[HOST_NAME_MAX];
-        gethostname(&procname,HOST_NAME_MAX);
+        gethostname(procname,HOST_NAME_MAX);
         fprintf(output,"%d: POSIX host name =  %s\n", label, procname);
     }
 #endif
     return;
 }
+
+/* the same name print_topology() prints, as a string                   */
+void prk_topology_host(char * name, int size)
+{
+#if defined(__CRAYXC)
+    FILE * procfile = fopen("/proc/cray_xt/cname","r");
+    name[0] = '\0';
+    if (procfile != NULL) {
+        if (fgets(name, size, procfile) == NULL) name[0] = '\0';
+        name[strcspn(name, " \n")] = '\0';
+        fclose(procfile);
+    }
+    if (name[0] == '\0') snprintf(name, size, "unknown");
+#elif defined(MPI_VERSION)
+    int  len;
+    char procname[MPI_MAX_PROCESSOR_NAME];
+    MPI_Get_processor_name(procname,&len);
+    snprintf(name, size, "%s", procname);
+#else
+    char procname[HOST_NAME_MAX+1];
+    gethostname(procname,HOST_NAME_MAX);
+    procname[HOST_NAME_MAX] = '\0';
+    snprintf(name, size, "%s", procname);
+#endif
+}
+
+#define PRK_TOPOLOGY_LINE 256
+
+enum { PRK_BIND_NONE, PRK_BIND_COMPACT, PRK_BIND_SCATTER, PRK_BIND_SOCKET };
+
+static int prk_world_rank(void)
+{
+    int rank = 0;
+#if defined(MPI)
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+    return rank;
+}
+
+static int prk_max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static int prk_thread_num(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/* rank of the caller among the ranks on its node, and their number */
+static void prk_local_rank(int * rank, int * size)
+{
+    *rank = 0;
+    *size = 1;
+#if defined(MPI) && defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    {
+        MPI_Comm node;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+        MPI_Comm_rank(node, rank);
+        MPI_Comm_size(node, size);
+        MPI_Comm_free(&node);
+    }
+#endif
+}
+
+static int prk_bind_policy(void)
+{
+    char * temp = getenv("PRK_BIND");
+    if (temp == NULL || *temp == '\0' || !strcmp(temp,"none")) return PRK_BIND_NONE;
+    if (!strcmp(temp,"compact")) return PRK_BIND_COMPACT;
+    if (!strcmp(temp,"scatter")) return PRK_BIND_SCATTER;
+    if (!strcmp(temp,"socket"))  return PRK_BIND_SOCKET;
+    if (prk_world_rank() == 0) printf("WARNING: unknown PRK_BIND=%s ignored\n", temp);
+    return PRK_BIND_NONE;
+}
+
+/* machine-wide core number (in socket-major order) for thread tid out of
+   nthreads of the rank with local number lrank, out of lsize ranks on a
+   node with ncores cores in nsockets sockets; cores are reused once they
+   are exhausted                                                          */
+static int prk_core_for(int policy, int lrank, int lsize, int tid, int nthreads,
+                        int ncores, int nsockets)
+{
+    int per_socket = ncores/nsockets, start, size, k, socket, nranks;
+
+    if (per_socket < 1) { per_socket = ncores; nsockets = 1; }
+    switch (policy) {
+    case PRK_BIND_COMPACT:
+        if (lsize > ncores) return (lrank+tid) % ncores;
+        start = (int) ((long) lrank*ncores/lsize);
+        size  = (int) ((long) (lrank+1)*ncores/lsize) - start;
+        return start + tid % size;
+    case PRK_BIND_SCATTER:
+        /* consecutive threads go round-robin over the sockets */
+        k = (lrank*nthreads + tid) % (per_socket*nsockets);
+        return (k % nsockets)*per_socket + k / nsockets;
+    case PRK_BIND_SOCKET:
+        socket = lrank % nsockets;
+        nranks = (lsize - socket + nsockets - 1)/nsockets;
+        k      = lrank / nsockets;
+        if (nranks > per_socket) return socket*per_socket + (k+tid) % per_socket;
+        start  = k*per_socket/nranks;
+        size   = (k+1)*per_socket/nranks - start;
+        return socket*per_socket + start + tid % size;
+    }
+    return 0;
+}
+
+#ifdef PRK_HWLOC
+
+static hwloc_topology_t prk_topo;
+static int              prk_topo_loaded = 0;
+
+static void prk_load_topology(void)
+{
+    if (prk_topo_loaded) return;
+    hwloc_topology_init(&prk_topo);
+#if HWLOC_API_VERSION >= 0x00020000
+    hwloc_topology_set_io_types_filter(prk_topo, HWLOC_TYPE_FILTER_KEEP_IMPORTANT);
+#else
+    hwloc_topology_set_flags(prk_topo, HWLOC_TOPOLOGY_FLAG_IO_DEVICES);
+#endif
+    hwloc_topology_load(prk_topo);
+    prk_topo_loaded = 1;
+}
+
+void prk_topology_bind(void)
+{
+    int policy = prk_bind_policy(), lrank, lsize, nthreads, ncores, nsockets, t, error = 0;
+    hwloc_bitmap_t set;
+
+    /* the node communicator is created by all ranks, even without binding */
+    prk_local_rank(&lrank, &lsize);
+
+    if (policy != PRK_BIND_NONE) {
+        prk_load_topology();
+        ncores   = hwloc_get_nbobjs_by_type(prk_topo, HWLOC_OBJ_CORE);
+        nsockets = hwloc_get_nbobjs_by_type(prk_topo, HWLOC_OBJ_PACKAGE);
+        if (ncores < 1)   ncores   = hwloc_get_nbobjs_by_type(prk_topo, HWLOC_OBJ_PU);
+        if (nsockets < 1) nsockets = 1;
+        nthreads = prk_max_threads();
+
+        /* the process gets the union of the cores of its threads */
+        set = hwloc_bitmap_alloc();
+        for (t=0; t<nthreads; t++) {
+            hwloc_obj_t core = hwloc_get_obj_by_type(prk_topo, HWLOC_OBJ_CORE,
+                                 prk_core_for(policy, lrank, lsize, t, nthreads, ncores, nsockets));
+            if (core) hwloc_bitmap_or(set, set, core->cpuset);
+        }
+        if (hwloc_set_cpubind(prk_topo, set, HWLOC_CPUBIND_PROCESS)) error = 1;
+        hwloc_bitmap_free(set);
+
+#ifdef _OPENMP
+        #pragma omp parallel num_threads(nthreads) reduction(+:error)
+#endif
+        {
+            hwloc_obj_t core = hwloc_get_obj_by_type(prk_topo, HWLOC_OBJ_CORE,
+                                 prk_core_for(policy, lrank, lsize, prk_thread_num(), nthreads,
+                                              ncores, nsockets));
+            if (core == NULL || hwloc_set_cpubind(prk_topo, core->cpuset, HWLOC_CPUBIND_THREAD)) error++;
+        }
+        if (error) printf("WARNING: rank %d could not be bound as requested by PRK_BIND\n",
+                          prk_world_rank());
+    }
+
+    if (getenv("PRK_TOPOLOGY") != NULL && strcmp(getenv("PRK_TOPOLOGY"),"0")) 
+        prk_topology_report(stdout);
+}
+
+/* describe the placement of the calling thread */
+static void prk_describe_thread(char * line, int size)
+{
+    hwloc_bitmap_t set = hwloc_bitmap_alloc();
+    hwloc_obj_t    pu = NULL, core, socket, numa, dev;
+    int            cpu, n = 0;
+
+    if (hwloc_get_last_cpu_location(prk_topo, set, HWLOC_CPUBIND_THREAD) == 0)
+        pu = hwloc_get_pu_obj_by_os_index(prk_topo, hwloc_bitmap_first(set));
+    hwloc_bitmap_free(set);
+    if (pu == NULL) {
+        snprintf(line, size, "location unknown");
+        return;
+    }
+    cpu    = (int) pu->os_index;
+    core   = hwloc_get_ancestor_obj_by_type(prk_topo, HWLOC_OBJ_CORE, pu);
+    socket = hwloc_get_ancestor_obj_by_type(prk_topo, HWLOC_OBJ_PACKAGE, pu);
+    for (numa = hwloc_get_next_obj_by_type(prk_topo, HWLOC_OBJ_NUMANODE, NULL); numa;
+         numa = hwloc_get_next_obj_by_type(prk_topo, HWLOC_OBJ_NUMANODE, numa))
+        if (hwloc_bitmap_isset(numa->cpuset, cpu)) break;
+    n += snprintf(line+n, size-n, "cpu %d, core %d, socket %d, NUMA node %d, GPUs:", cpu,
+                  core ? (int) core->logical_index : -1, socket ? (int) socket->logical_index : -1,
+                  numa ? (int) numa->logical_index : -1);
+    for (dev = hwloc_get_next_osdev(prk_topo, NULL); dev; dev = hwloc_get_next_osdev(prk_topo, dev)) {
+        hwloc_obj_t parent;
+        if (dev->attr->osdev.type != HWLOC_OBJ_OSDEV_GPU && dev->attr->osdev.type != HWLOC_OBJ_OSDEV_COPROC)
+            continue;
+        parent = hwloc_get_non_io_ancestor_obj(prk_topo, dev);
+        if (parent && parent->cpuset && hwloc_bitmap_isset(parent->cpuset, cpu) && n < size)
+            n += snprintf(line+n, size-n, " %s", dev->name);
+    }
+    if (n < size && line[n-1] == ':') snprintf(line+n, size-n, " none");
+}
+
+int prk_topology_socket(void)
+{
+    hwloc_bitmap_t set = hwloc_bitmap_alloc();
+    hwloc_obj_t    pu = NULL, socket = NULL;
+
+#ifdef _OPENMP
+    #pragma omp critical (prk_topology)
+#endif
+    prk_load_topology();
+    if (hwloc_get_last_cpu_location(prk_topo, set, HWLOC_CPUBIND_THREAD) == 0)
+        pu = hwloc_get_pu_obj_by_os_index(prk_topo, hwloc_bitmap_first(set));
+    hwloc_bitmap_free(set);
+    if (pu) socket = hwloc_get_ancestor_obj_by_type(prk_topo, HWLOC_OBJ_PACKAGE, pu);
+    return socket ? (int) socket->logical_index : -1;
+}
+
+#else /* !PRK_HWLOC */
+
+void prk_topology_bind(void)
+{
+    int lrank, lsize;
+
+    prk_local_rank(&lrank, &lsize);
+    if (prk_bind_policy() != PRK_BIND_NONE && prk_world_rank() == 0)
+        printf("WARNING: PRK_BIND requires hwloc (set HWLOCTOP in make.defs); threads not bound\n");
+    if (getenv("PRK_TOPOLOGY") != NULL && strcmp(getenv("PRK_TOPOLOGY"),"0")) 
+        prk_topology_report(stdout);
+}
+
+static int prk_sysfs_int(const char * format, int cpu)
+{
+    char  name[128];
+    int   value = -1;
+    FILE * f;
+
+    snprintf(name, sizeof(name), format, cpu);
+    f = fopen(name, "r");
+    if (f == NULL) return -1;
+    if (fscanf(f, "%d", &value) != 1) value = -1;
+    fclose(f);
+    return value;
+}
+
+static void prk_describe_thread(char * line, int size)
+{
+    int    cpu = sched_getcpu(), numa = -1;
+    char   name[128];
+    DIR  * dir;
+    struct dirent * entry;
+
+    if (cpu < 0) {
+        snprintf(line, size, "location unknown");
+        return;
+    }
+    snprintf(name, sizeof(name), "/sys/devices/system/cpu/cpu%d", cpu);
+    if ((dir = opendir(name)) != NULL) {
+        while ((entry = readdir(dir)) != NULL)
+            if (sscanf(entry->d_name, "node%d", &numa) == 1) break;
+        closedir(dir);
+    }
+    snprintf(line, size, "cpu %d, core %d, socket %d, NUMA node %d, GPUs: unknown", cpu,
+             prk_sysfs_int("/sys/devices/system/cpu/cpu%d/topology/core_id", cpu),
+             prk_sysfs_int("/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu),
+             numa);
+}
+
+int prk_topology_socket(void)
+{
+    int cpu = sched_getcpu();
+
+    if (cpu < 0) return -1;
+    return prk_sysfs_int("/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+}
+
+#endif /* PRK_HWLOC */
+
+/* one line per rank and thread, gathered to and printed by rank 0 */
+void prk_topology_report(FILE * output)
+{
+    int    nthreads = prk_max_threads(), rank = prk_world_rank(), nranks = 1, r, t;
+    char   host[HOST_NAME_MAX+1], * lines, * all;
+
+#ifdef PRK_HWLOC
+    prk_load_topology();
+#endif
+#if defined(MPI)
+    MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+    MPI_Allreduce(MPI_IN_PLACE, &nthreads, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+    gethostname(host, HOST_NAME_MAX);
+    host[HOST_NAME_MAX] = '\0';
+
+    lines = (char *) calloc((size_t) nthreads*PRK_TOPOLOGY_LINE, 1);
+    if (lines == NULL) return;
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(nthreads)
+#endif
+    {
+        char * line = lines + (size_t) prk_thread_num()*PRK_TOPOLOGY_LINE;
+        int    n = snprintf(line, PRK_TOPOLOGY_LINE, "rank %d thread %d: host %s, ",
+                            rank, prk_thread_num(), host);
+        prk_describe_thread(line+n, PRK_TOPOLOGY_LINE-n);
+    }
+
+    all = lines;
+#if defined(MPI)
+    if (rank == 0) all = (char *) calloc((size_t) nranks*nthreads*PRK_TOPOLOGY_LINE, 1);
+    MPI_Gather(lines, nthreads*PRK_TOPOLOGY_LINE, MPI_CHAR,
+               all,   nthreads*PRK_TOPOLOGY_LINE, MPI_CHAR, 0, MPI_COMM_WORLD);
+#endif
+    if (rank == 0 && all != NULL) {
+        for (r=0; r<nranks; r++) for (t=0; t<nthreads; t++) {
+            char * line = all + ((size_t) r*nthreads+t)*PRK_TOPOLOGY_LINE;
+            if (*line) fprintf(output, "%s\n", line);
+        }
+        fflush(output);
+    }
+    if (all != lines) free(all);
+    free(lines);
+}
@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/**********************************************************************
+
+Name:      transpose_simd
+
+Purpose:   Vectorized tile kernels for the Transpose kernels, and their
+           selection at startup.  See include/prk_transpose_simd.h for
+           usage.
+
+Functions: prk_transpose_simd_isa:   name of the selected instruction set
+           prk_transpose_simd:       tile kernel, with or without
+                                     non-temporal stores
+           prk_transpose_streaming:  whether to use non-temporal stores
+           select_isa:               pick the best instruction set that
+                                     the CPU supports and PRK_SIMD allows
+
+Notes:     The kernels themselves are in transpose_simd.incl, which is
+           included once per instruction set and kind of store.  As in
+           stencil_simd.c, they are compiled with target attributes, so
+           that no special compiler flags are needed and the binary runs
+           on CPUs without these extensions.  There are only x86 kernels;
+           elsewhere the selector returns NULL.
+
+History:   Written in October 2026.
+
+**********************************************************************/
+
+#include <par-res-kern_general.h>
+#include <prk_transpose_simd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define PRK_SIMD_X86 1
+  #include <immintrin.h>
+#endif
+
+#define A(i,j)    A[(i)+order*(j)]
+#define B(i,j)    B[(i)+order*(j)]
+
+enum { ISA_UNSET, ISA_SCALAR, ISA_AVX2, ISA_AVX512 };
+
+static int isa = ISA_UNSET;
+
+#if PRK_SIMD_X86
+
+#define TARGET       __attribute__((target("avx2")))
+#define VEC          __m256d
+#define VLEN         4
+#define LOADU(p)     _mm256_loadu_pd(p)
+#define STOREU(p,v)  _mm256_storeu_pd(p,v)
+#define STREAM(p,v)  _mm256_stream_pd(p,v)
+#define ADD(a,b)     _mm256_add_pd(a,b)
+#define SET1(x)      _mm256_set1_pd(x)
+#define TRANSPOSE(c,r) do {                                             \
+    VEC t0 = _mm256_unpacklo_pd(c[0],c[1]), t1 = _mm256_unpackhi_pd(c[0],c[1]), \
+        t2 = _mm256_unpacklo_pd(c[2],c[3]), t3 = _mm256_unpackhi_pd(c[2],c[3]); \
+    r[0] = _mm256_permute2f128_pd(t0,t2,0x20);                          \
+    r[1] = _mm256_permute2f128_pd(t1,t3,0x20);                          \
+    r[2] = _mm256_permute2f128_pd(t0,t2,0x31);                          \
+    r[3] = _mm256_permute2f128_pd(t1,t3,0x31);                          \
+  } while (0)
+#define NAME(s)      tile_avx2_##s
+#define STREAMING    0
+#include "transpose_simd.incl"
+#undef  STREAMING
+#define STREAMING    1
+#include "transpose_simd.incl"
+#undef  STREAMING
+#undef TARGET
+#undef VEC
+#undef VLEN
+#undef LOADU
+#undef STOREU
+#undef STREAM
+#undef ADD
+#undef SET1
+#undef TRANSPOSE
+#undef NAME
+
+/* the 8 x 8 transpose interleaves pairs of columns, then swaps 128-bit
+   lanes twice, each time between vectors twice as far apart            */
+#define TARGET       __attribute__((target("avx512f")))
+#define VEC          __m512d
+#define VLEN         8
+#define LOADU(p)     _mm512_loadu_pd(p)
+#define STOREU(p,v)  _mm512_storeu_pd(p,v)
+#define STREAM(p,v)  _mm512_stream_pd(p,v)
+#define ADD(a,b)     _mm512_add_pd(a,b)
+#define SET1(x)      _mm512_set1_pd(x)
+#define TRANSPOSE(c,r) do {                                             \
+    VEC t[8], u[8];                                                     \
+    int l;                                                              \
+    for (l=0; l<8; l+=2) {                                              \
+      t[l]   = _mm512_unpacklo_pd(c[l],c[l+1]);                         \
+      t[l+1] = _mm512_unpackhi_pd(c[l],c[l+1]);                         \
+    }                                                                   \
+    for (l=0; l<8; l+=4) {                                              \
+      u[l]   = _mm512_shuffle_f64x2(t[l],  t[l+2],0x88);                \
+      u[l+1] = _mm512_shuffle_f64x2(t[l],  t[l+2],0xDD);                \
+      u[l+2] = _mm512_shuffle_f64x2(t[l+1],t[l+3],0x88);                \
+      u[l+3] = _mm512_shuffle_f64x2(t[l+1],t[l+3],0xDD);                \
+    }                                                                   \
+    r[0] = _mm512_shuffle_f64x2(u[0],u[4],0x88);                        \
+    r[4] = _mm512_shuffle_f64x2(u[0],u[4],0xDD);                        \
+    r[2] = _mm512_shuffle_f64x2(u[1],u[5],0x88);                        \
+    r[6] = _mm512_shuffle_f64x2(u[1],u[5],0xDD);                        \
+    r[1] = _mm512_shuffle_f64x2(u[2],u[6],0x88);                        \
+    r[5] = _mm512_shuffle_f64x2(u[2],u[6],0xDD);                        \
+    r[3] = _mm512_shuffle_f64x2(u[3],u[7],0x88);                        \
+    r[7] = _mm512_shuffle_f64x2(u[3],u[7],0xDD);                        \
+  } while (0)
+#define NAME(s)      tile_avx512_##s
+#define STREAMING    0
+#include "transpose_simd.incl"
+#undef  STREAMING
+#define STREAMING    1
+#include "transpose_simd.incl"
+#undef  STREAMING
+#undef TARGET
+#undef VEC
+#undef VLEN
+#undef LOADU
+#undef STOREU
+#undef STREAM
+#undef ADD
+#undef SET1
+#undef TRANSPOSE
+#undef NAME
+
+#endif /* PRK_SIMD_X86 */
+
+static const char * isa_names[] = {"", "scalar", "avx2", "avx512"};
+
+static int supported(int which)
+{
+    switch (which) {
+      case ISA_SCALAR: return 1;
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return __builtin_cpu_supports("avx2");
+      case ISA_AVX512: return __builtin_cpu_supports("avx512f");
+#endif
+      default:         return 0;
+    }
+}
+
+static void select_isa(void)
+{
+    char * env = getenv("PRK_SIMD");
+    int    which;
+
+    if (isa != ISA_UNSET) return;
+    if (env != NULL && *env != '\0') {
+        for (which=ISA_SCALAR; which<=ISA_AVX512; which++)
+            if (!strcmp(env, isa_names[which])) break;
+        if (which <= ISA_AVX512 && supported(which)) {
+            isa = which;
+            return;
+        }
+        printf("WARNING: PRK_SIMD=%s is not available, selecting automatically\n", env);
+    }
+    for (which=ISA_AVX512; which>ISA_SCALAR; which--) if (supported(which)) break;
+    isa = which;
+}
+
+const char * prk_transpose_simd_isa(void)
+{
+    select_isa();
+    return isa_names[isa];
+}
+
+prk_transpose_tile_t prk_transpose_simd(int streaming)
+{
+    select_isa();
+    switch (isa) {
+#if PRK_SIMD_X86
+      case ISA_AVX2:   return streaming ? tile_avx2_1   : tile_avx2_0;
+      case ISA_AVX512: return streaming ? tile_avx512_1 : tile_avx512_0;
+#endif
+      default:         return NULL;
+    }
+}
+
+int prk_transpose_streaming(double bytes)
+{
+    char * env = getenv("PRK_NT_STORES");
+    long   llc = 0;
+
+    if (env == NULL || *env == '\0') return 0;
+    if (strcmp(env, "auto")) return atoi(env) != 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    /* without a known last-level cache size, do not stream               */
+    return llc > 0 && bytes > (double) llc;
+}
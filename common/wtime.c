@@ -51,6 +51,22 @@ Notes:     This function uses two structures defined in the UNIX
 
            where timeval.tv_sec is the seconds and timeval.tv_usec
            is the microseconds.  
+
+           The default clock is omp_get_wtime() for OpenMP builds,
+           MPI_Wtime() for MPI builds and gettimeofday() otherwise.
+           A high-resolution backend can be selected at run time 
+           through the environment variable PRK_TIMER:
+
+             PRK_TIMER=monotonic  clock_gettime(CLOCK_MONOTONIC_RAW)
+             PRK_TIMER=tsc        invariant time stamp counter (x86),
+                                  calibrated against the monotonic
+                                  clock at first use; falls back to
+                                  the monotonic clock if the TSC is
+                                  not invariant
+
+           The backend is chosen once, by the first call of wtime(),
+           wtime_backend() or wtime_resolution(); in OpenMP builds
+           that first call may come from any thread.
  
 History:   Written by Tim Mattson, Dec 1, 1988
            Modified by Rob van der Wijngaart, May 2006, to change
@@ -58,18 +74,44 @@ History:   Written by Tim Mattson, Dec 1, 1988
 
 ****************************************************************/
 
+/* needed for clock_gettime and CLOCK_MONOTONIC_RAW with -std=c99     */
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
 #if defined(_OPENMP)
   #include <omp.h>
 #elif defined(MPI)
   #include "mpi.h"
-#else
-  #include <sys/time.h>
-  #define  USEC_TO_SEC   1.0e-6    /* to convert microsecs to secs */
 #endif
+#define  USEC_TO_SEC   1.0e-6    /* to convert microsecs to secs */
+#define  NSEC_TO_SEC   1.0e-9    /* to convert nanosecs to secs  */
 
+#if defined(__x86_64__) || defined(__i386__)
+  #define PRK_HAVE_TSC 1
+#endif
 
-double wtime() {
+#if defined(CLOCK_MONOTONIC_RAW)
+  #define PRK_MONOTONIC_CLOCK CLOCK_MONOTONIC_RAW
+#elif defined(CLOCK_MONOTONIC)
+  #define PRK_MONOTONIC_CLOCK CLOCK_MONOTONIC
+#endif
+
+#define TSC_CALIBRATION_TIME 0.02 /* seconds spent calibrating the TSC */
+
+enum { TIMER_UNSET, TIMER_DEFAULT, TIMER_MONOTONIC, TIMER_TSC };
+
+static int      timer_backend = TIMER_UNSET;
+static double   tsc_seconds_per_tick;
+static uint64_t tsc_base;
+
+static double default_wtime(void) {
   double time_seconds;
 
 #if defined(_OPENMP)
@@ -89,3 +131,159 @@ double wtime() {
 
   return time_seconds;
 }
+
+static double monotonic_wtime(void) {
+#if defined(PRK_MONOTONIC_CLOCK)
+  struct timespec time_data;
+
+  clock_gettime(PRK_MONOTONIC_CLOCK, &time_data);
+  return (double) time_data.tv_sec + (double) time_data.tv_nsec * NSEC_TO_SEC;
+#else
+  return default_wtime();
+#endif
+}
+
+#if PRK_HAVE_TSC
+static inline uint64_t read_tsc(void) {
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* CPUID leaf 0x80000007, EDX bit 8: the TSC ticks at a constant rate
+   in all P-, C- and T-states                                         */
+static int tsc_is_invariant(void) {
+  uint32_t eax, ebx, ecx, edx;
+
+  __asm__ __volatile__ ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+                                : "a" (0x80000000));
+  if (eax < 0x80000007) return 0;
+  __asm__ __volatile__ ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+                                : "a" (0x80000007));
+  return (edx >> 8) & 1;
+}
+
+static int tsc_calibrate(void) {
+  double   t0, t1;
+  uint64_t c0, c1;
+
+  if (!tsc_is_invariant()) return 0;
+  t0 = monotonic_wtime();
+  c0 = read_tsc();
+  do t1 = monotonic_wtime(); while (t1-t0 < TSC_CALIBRATION_TIME);
+  c1 = read_tsc();
+  if (c1 <= c0) return 0;
+  tsc_seconds_per_tick = (t1-t0)/(double)(c1-c0);
+  tsc_base             = c0;
+  return 1;
+}
+#endif
+
+static int select_backend(void) {
+  char * choice = getenv("PRK_TIMER");
+  int    backend = TIMER_DEFAULT;
+
+  if (choice != NULL && !strcmp(choice,"monotonic")) {
+#if defined(PRK_MONOTONIC_CLOCK)
+    backend = TIMER_MONOTONIC;
+#else
+    printf("WARNING: PRK_TIMER=monotonic not supported; using default timer\n");
+#endif
+  }
+  else if (choice != NULL && !strcmp(choice,"tsc")) {
+#if PRK_HAVE_TSC
+    if (tsc_calibrate()) backend = TIMER_TSC;
+    else {
+      printf("WARNING: TSC is not invariant; using monotonic timer\n");
+      backend = TIMER_MONOTONIC;
+    }
+#else
+    printf("WARNING: PRK_TIMER=tsc not supported; using monotonic timer\n");
+    backend = TIMER_MONOTONIC;
+#endif
+  }
+  else if (choice != NULL && strcmp(choice,"default") && *choice != '\0') {
+    printf("WARNING: unknown PRK_TIMER=%s; using default timer\n", choice);
+  }
+  return backend;
+}
+
+/* choose the backend exactly once; the choice (and the TSC calibration)
+   is published with a sequentially consistent write, so a thread that
+   reads a backend other than TIMER_UNSET also sees its calibration     */
+static int wtime_init(void) {
+  int backend;
+
+#if defined(_OPENMP)
+  #pragma omp critical (prk_wtime_init)
+#endif
+  {
+#if defined(_OPENMP)
+    #pragma omp atomic read seq_cst
+#endif
+    backend = timer_backend;
+    if (backend == TIMER_UNSET) {
+      backend = select_backend();
+#if defined(_OPENMP)
+      #pragma omp atomic write seq_cst
+#endif
+      timer_backend = backend;
+    }
+  }
+  return backend;
+}
+
+static int wtime_get_backend(void) {
+  int backend;
+
+#if defined(_OPENMP)
+  #pragma omp atomic read seq_cst
+#endif
+  backend = timer_backend;
+  return backend == TIMER_UNSET ? wtime_init() : backend;
+}
+
+double wtime() {
+
+  switch (wtime_get_backend()) {
+#if PRK_HAVE_TSC
+    case TIMER_TSC:       return (double) (read_tsc()-tsc_base) * tsc_seconds_per_tick;
+#endif
+    case TIMER_MONOTONIC: return monotonic_wtime();
+    default:              return default_wtime();
+  }
+}
+
+const char * wtime_backend(void) {
+  switch (wtime_get_backend()) {
+    case TIMER_TSC:       return "tsc";
+    case TIMER_MONOTONIC: return "monotonic";
+#if defined(_OPENMP)
+    default:              return "omp_get_wtime";
+#elif defined(MPI)
+    default:              return "MPI_Wtime";
+#else
+    default:              return "gettimeofday";
+#endif
+  }
+}
+
+double wtime_resolution(void) {
+  switch (wtime_get_backend()) {
+    case TIMER_TSC:       return tsc_seconds_per_tick;
+#if defined(PRK_MONOTONIC_CLOCK)
+    case TIMER_MONOTONIC: {
+      struct timespec res;
+      clock_getres(PRK_MONOTONIC_CLOCK, &res);
+      return (double) res.tv_sec + (double) res.tv_nsec * NSEC_TO_SEC;
+    }
+#endif
+#if defined(_OPENMP)
+    default:              return omp_get_wtick();
+#elif defined(MPI)
+    default:              return MPI_Wtick();
+#else
+    default:              return USEC_TO_SEC;
+#endif
+  }
+}
@@ -73,6 +73,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #endif
 
 extern double wtime(void);
+extern const char * wtime_backend(void);
+extern double wtime_resolution(void);
 
 /*  We cannot use C11 aligned_alloc because of this GCC 5.3.0 bug:
  *  https://gcc.gnu.org/bugzilla/show_bug.cgi?id=69680 */
@@ -101,12 +103,12 @@ static inline int prk_get_alignment(void)
 int posix_memalign(void **memptr, size_t alignment, size_t size);
 #endif
 
-static inline void* prk_malloc(size_t bytes)
-{
-#ifndef PRK_USE_MALLOC
-    int alignment = prk_get_alignment();
-#endif
+#include <prk_mempolicy.h>
+#include <prk_memstats.h>
 
+/* Heap allocation without accounting; use prk_malloc() instead. */
+static inline void* prk_malloc_aligned(size_t bytes, int alignment)
+{
 /* Berkeley UPC throws warnings related to this function for no obvious reason... */
 #if !defined(__UPC__) && defined(__INTEL_COMPILER) && !defined(PRK_USE_POSIX_MEMALIGN)
     return (void*)_mm_malloc(bytes,alignment);
@@ -129,7 +131,7 @@ static inline void* prk_malloc(size_t bytes)
     return aligned_alloc(alignment,padded);
 #elif defined(PRK_USE_MALLOC)
 #warning PRK_USE_MALLOC prevents the use of alignmed memory.
-    return prk_malloc(bytes);
+    return malloc(bytes);
 #else /* if defined(PRK_USE_POSIX_MEMALIGN) */
     void * ptr = NULL;
     posix_memalign(&ptr,alignment,bytes);
@@ -137,7 +139,7 @@ static inline void* prk_malloc(size_t bytes)
 #endif
 }
 
-static inline void prk_free(void* p)
+static inline void prk_free_aligned(void* p)
 {
 #if defined(__INTEL_COMPILER) && !defined(PRK_USE_POSIX_MEMALIGN)
     _mm_free(p);
@@ -145,3 +147,50 @@ static inline void prk_free(void* p)
     free(p);
 #endif
 }
+
+/* Aligned allocation, accounted for in prk_memstats.h.  Blocks must be
+   released with prk_free(), which finds the accounting header in front
+   of them.  With PRK_USE_MALLOC there is neither alignment to keep nor
+   accounting, and the two are plain malloc() and free(). */
+static inline void* prk_malloc(size_t bytes)
+{
+#ifdef PRK_USE_MALLOC
+    return malloc(bytes);
+#else
+    int    alignment = prk_get_alignment();
+    size_t offset = alignment;
+    int    mapped = prk_mempolicy_active();
+    char * base;
+    prk_memstats_header_t * h;
+
+    /* room for the accounting header in front of the block, keeping alignment */
+    while (offset < sizeof(prk_memstats_header_t)) offset += alignment;
+    /* huge page and NUMA placement policies selected at run time */
+    if (mapped) base = (char *) prk_mempolicy_malloc(bytes+offset, alignment);
+    else        base = (char *) prk_malloc_aligned(bytes+offset, alignment);
+    if (base == NULL) return NULL;
+    h = (prk_memstats_header_t *) (base + offset - sizeof(prk_memstats_header_t));
+    h->bytes  = bytes;
+    h->offset = offset;
+    h->mapped = mapped;
+    prk_memstats_add(bytes);
+    return base + offset;
+#endif
+}
+
+static inline void prk_free(void* p)
+{
+#ifdef PRK_USE_MALLOC
+    free(p);
+#else
+    prk_memstats_header_t * h;
+    char * base;
+
+    if (p == NULL) return;
+    h = (prk_memstats_header_t *) ((char *) p - sizeof(prk_memstats_header_t));
+    base = (char *) p - h->offset;
+    prk_memstats_remove(h->bytes);
+    if (h->mapped) prk_mempolicy_free(base);
+    else           prk_free_aligned(base);
+#endif
+}
@@ -31,6 +31,7 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <mpi.h>
+#include <prk_progress.h>
 
 /* This code appears in MADNESS, which is GPL, but it was
  * written by Jeff Hammond and contributed to multiple projects
@@ -127,4 +128,53 @@ int PRK_Win_free(MPI_Win * win)
 #endif
 }
 
+/* Persistent collectives were added in MPI-4; Open MPI 4 provides them
+ * as an extension, with an MPIX_ prefix. */
+#if MPI_VERSION >= 4
+#define PRK_HAVE_PERSISTENT_COLLECTIVES
+#define PRK_Allgather_init MPI_Allgather_init
+#define PRK_Reduce_init    MPI_Reduce_init
+#elif defined(OPEN_MPI) && (MPI_VERSION >= 3)
+#include <mpi-ext.h>
+#if defined(OMPI_HAVE_MPI_EXT_PCOLLREQ) && OMPI_HAVE_MPI_EXT_PCOLLREQ
+#define PRK_HAVE_PERSISTENT_COLLECTIVES
+#define PRK_Allgather_init MPIX_Allgather_init
+#define PRK_Reduce_init    MPIX_Reduce_init
+#endif
+#endif
+
+/* Local work that nonblocking collectives are overlapped with: reps
+ * passes over a private array of n doubles. */
+static void prk_overlap_work(double * work, long n, long reps)
+{
+    long r, i;
+    for (r=0; r<reps; r++) for (i=0; i<n; i++) work[i] = 0.5*work[i] + 1.0;
+}
+
+/* number of passes of prk_overlap_work that take about target seconds */
+static long prk_overlap_reps(double * work, long n, double target)
+{
+    long   reps = 1;
+    double t;
+    for (;;) {
+        t = wtime();
+        prk_overlap_work(work, n, reps);
+        t = wtime() - t;
+        if (t >= 1.e-3 || t >= target) break;
+        reps *= 2;
+    }
+    return MAX(1, (long) (reps*target/t));
+}
+
+/* Fraction of the shorter of collective and local work that was hidden
+ * behind the other, given their separate times and the combined time;
+ * 0 means they were serialized, 1 means perfect overlap. */
+static double prk_overlap_fraction(double coll_time, double work_time, double total_time)
+{
+    double fraction;
+    if (MIN(coll_time, work_time) <= 0.0) return 0.0;
+    fraction = (coll_time + work_time - total_time)/MIN(coll_time, work_time);
+    return MAX(0.0, MIN(1.0, fraction));
+}
+
 extern void bail_out(int);
@@ -38,6 +38,12 @@ extern void bail_out(int);
 #if ((SHMEM_MAJOR_VERSION>1) || ((SHMEM_MAJOR_VERSION == 1) && (SHMEM_MINOR_VERSION >= 2)))
 #define PRK_HAVE_OPENSHMEM_1_2
 #endif
+#if ((SHMEM_MAJOR_VERSION>1) || ((SHMEM_MAJOR_VERSION == 1) && (SHMEM_MINOR_VERSION >= 4)))
+#define PRK_HAVE_OPENSHMEM_1_4
+#endif
+#if ((SHMEM_MAJOR_VERSION>1) || ((SHMEM_MAJOR_VERSION == 1) && (SHMEM_MINOR_VERSION >= 5)))
+#define PRK_HAVE_OPENSHMEM_1_5
+#endif
 /* Cray SHMEM provides some but not all of the changes in OpenSHMEM 1.2. */
 #elif defined(CRAY_SHMEM_NUMVERSION)
 #define PRK_HAVE_CRAY_SHMEM
@@ -115,6 +121,67 @@ static void prk_shmem_free(void * ptr) {
 #endif
 }
 
+/* Bitwise atomics were added in OpenSHMEM 1.4; before that, XOR is emulated
+ * with a compare-and-swap loop, which takes at least two round trips. */
+static void prk_shmem_xor(unsigned long long * dest, unsigned long long value, int pe) {
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+    shmem_ulonglong_atomic_xor(dest, value, pe);
+#else
+    long long old = shmem_longlong_g((long long *)dest, pe), prev;
+    while ((prev = shmem_longlong_cswap((long long *)dest, old,
+                                        (long long)((unsigned long long)old ^ value), pe)) != old)
+        old = prev;
+#endif
+}
+
+/* The typed atomic_* names were added in OpenSHMEM 1.4 and the old ones deprecated. */
+static long long prk_shmem_fetch_inc(long long * dest, int pe) {
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+    return shmem_longlong_atomic_fetch_inc(dest, pe);
+#else
+    return shmem_longlong_finc(dest, pe);
+#endif
+}
+
+static long long prk_shmem_cswap(long long * dest, long long cond, long long value, int pe) {
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+    return shmem_longlong_atomic_compare_swap(dest, cond, value, pe);
+#else
+    return shmem_longlong_cswap(dest, cond, value, pe);
+#endif
+}
+
+#ifdef PRK_HAVE_OPENSHMEM_1_4
+/* Put-with-signal was added in OpenSHMEM 1.5; before that, it is emulated with
+ * a put and an atomic set of the signal, ordered by a fence on the context.
+ * Either way the target sees the data once it sees the signal. */
+#ifdef PRK_HAVE_OPENSHMEM_1_5
+typedef uint64_t prk_shmem_signal_t;
+#else
+typedef long long prk_shmem_signal_t;
+#endif
+
+static void prk_shmem_double_put_signal(shmem_ctx_t ctx, double * dest, const double * source,
+                                        size_t nelems, prk_shmem_signal_t * sig_addr,
+                                        prk_shmem_signal_t signal, int pe) {
+#ifdef PRK_HAVE_OPENSHMEM_1_5
+    shmem_ctx_double_put_signal(ctx, dest, source, nelems, sig_addr, signal, SHMEM_SIGNAL_SET, pe);
+#else
+    shmem_ctx_double_put(ctx, dest, source, nelems, pe);
+    shmem_ctx_fence(ctx);
+    shmem_ctx_longlong_atomic_set(ctx, sig_addr, signal, pe);
+#endif
+}
+
+static void prk_shmem_signal_wait_ge(prk_shmem_signal_t * sig_addr, prk_shmem_signal_t value) {
+#ifdef PRK_HAVE_OPENSHMEM_1_5
+    shmem_signal_wait_until(sig_addr, SHMEM_CMP_GE, value);
+#else
+    shmem_longlong_wait_until(sig_addr, SHMEM_CMP_GE, value);
+#endif
+}
+#endif
+
 /* The SHMEM_* constants were added in OpenSHMEM 1.2
  * and the _SHMEM* constants were deprecated in OpenSHMEM 1.3. */
 #ifdef PRK_HAVE_OPENSHMEM_1_2
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+      * Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Dynamic load balancing for the Adaptive MPI (AMPI) kernels.  AMPI runs
+ * many virtual ranks (+vp) on few processing elements (PEs, +p); at an
+ * AMPI_Migrate call the load balancer selected with +balancer may move
+ * ranks between PEs, based on the time they computed since the last call.
+ * Heap and stack of a rank move with it when the program is linked with
+ * -memory isomalloc, so pointers stay valid; globals do not move, so the
+ * kernels only keep read-only data in them (the LCG of random_draw.c is
+ * used during initialization only, without intervening MPI calls, so
+ * ranks sharing a PE cannot interleave their draws).
+ *
+ * PRK_MIGRATE=<k> makes the kernels call AMPI_Migrate every k iterations;
+ * the default, 0, never does. */
+
+/* PE of the calling rank, or -1 if AMPI does not tell */
+static int prk_ampi_my_pe(void)
+{
+    int *value, flag = 0;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, AMPI_MY_PE, &value, &flag);
+    return flag ? *value : -1;
+}
+
+/* number of PEs the virtual ranks share, or -1 if AMPI does not tell */
+static int prk_ampi_num_pes(void)
+{
+    int *value, flag = 0;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, AMPI_NUM_PES, &value, &flag);
+    return flag ? *value : -1;
+}
+
+/* iteration period of AMPI_Migrate from PRK_MIGRATE, -1 if it is not valid */
+static int prk_ampi_migrate_period(void)
+{
+    char *env = getenv("PRK_MIGRATE");
+    int   period;
+    if (env == NULL || *env == '\0') return 0;
+    period = atoi(env);
+    return (period < 0) ? -1 : period;
+}
+
+/* Collective load balancing step; counts in *moved whether the calling
+ * rank changed PE, and adds the time spent to *time. */
+static void prk_ampi_migrate(int *moved, double *time)
+{
+    int    pe = prk_ampi_my_pe();
+    double t  = MPI_Wtime();
+    AMPI_Migrate(AMPI_INFO_LB_SYNC);
+    *time  += MPI_Wtime() - t;
+    *moved += (prk_ampi_my_pe() != pe);
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_autotune
+
+PURPOSE: In-process tuning of kernel parameters such as tile and block
+         sizes, with a cache of the best configuration found for each
+         machine and problem size.
+
+USAGE:   The kernel decides whether to tune with prk_autotune_mode():
+
+           PRK_AUTOTUNE=1          reuse a cached configuration if there
+                                   is one, otherwise search and cache it
+           PRK_AUTOTUNE=refresh    always search, and replace the cached
+                                   configuration
+           PRK_AUTOTUNE_CACHE=<file>  cache file, $HOME/.prk_autotune by
+                                   default
+
+         A configuration is a short list of integers.  It is identified
+         by the kernel name, a problem string without blanks (e.g.
+         "order=4096,threads=16") and the host name.  The search itself
+         is done by the kernel, which times short trial runs with
+         wtime() and calls prk_autotune_store() with the winner.
+
+         The cache is a text file with one configuration per line; when
+         the same key appears more than once the last line wins.
+
+*******************************************************************/
+
+#ifndef PRK_AUTOTUNE_H
+#define PRK_AUTOTUNE_H
+
+#define PRK_AUTOTUNE_OFF     0
+#define PRK_AUTOTUNE_CACHED  1
+#define PRK_AUTOTUNE_REFRESH 2
+
+#define PRK_AUTOTUNE_MAXVALUES 8
+
+extern int  prk_autotune_mode(void);
+extern int  prk_autotune_lookup(const char *, const char *, int, int *);
+extern void prk_autotune_store(const char *, const char *, int, const int *, double);
+
+#endif
@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_counters
+
+PURPOSE: Optional hardware performance counter instrumentation of the
+         timed region of a kernel, based on Linux perf_event_open(2).
+         The timing harness (prk_harness.h) starts the counters at
+         its first tick and stops them when the last timed iteration
+         completes, so kernels using the harness need no changes.
+
+USAGE:   The counters are selected at run time:
+
+           PRK_COUNTERS=default    cycles, instructions, llc-misses,
+                                   dtlb-misses and node-misses
+           PRK_COUNTERS=<list>     comma-separated list of event names:
+                                   cycles, instructions, llc-loads,
+                                   llc-misses, dtlb-misses, itlb-misses,
+                                   node-loads, node-misses (accesses to
+                                   remote NUMA memory), branch-misses,
+                                   page-faults, task-clock (ns)
+
+         Without PRK_COUNTERS no counter is opened and the start and
+         stop calls are no-ops.
+
+         prk_counters_init() must be called outside of any parallel
+         region.  In OpenMP builds it opens a set of counters for every
+         thread of a team of omp_get_max_threads() threads, and counts
+         threads created later through inheritance; values returned by
+         prk_counters_read() are summed over all threads.  Summation
+         over MPI ranks is done by prk_harness_report().
+
+*******************************************************************/
+
+#ifndef PRK_COUNTERS_H
+#define PRK_COUNTERS_H
+
+#include <stdint.h>
+
+#define PRK_COUNTERS_MAX 11
+
+extern int          prk_counters_init(void);
+extern int          prk_counters_num(void);
+extern const char * prk_counters_name(int);
+extern void         prk_counters_start(void);
+extern void         prk_counters_stop(void);
+extern void         prk_counters_read(uint64_t *);
+extern void         prk_counters_finalize(void);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_dgemm_simd
+
+PURPOSE: Packed, register-blocked matrix multiplication for the DGEMM
+         kernels, in the style of BLIS and GotoBLAS, with a micro-kernel
+         selected at startup from the features of the CPU.
+
+USAGE:   const prk_dgemm_kernel_t * kernel = prk_dgemm_simd();
+         int    blocking[3];
+         prk_dgemm_blocking(kernel, blocking);
+         double * work = prk_malloc(prk_dgemm_workspace(kernel, blocking)
+                                    *sizeof(double));
+         prk_dgemm_packed(kernel, blocking, m, n, k,
+                          A, lda, B, ldb, C, ldc, work);
+
+         prk_dgemm_packed performs C += A x B for the column-major
+         m x k matrix A, k x n matrix B and m x n matrix C.  It loops
+         over NC columns of C, KC columns of A (rows of B) and MC rows
+         of C, in that order.  For each KC x NC panel of B and MC x KC
+         block of A it copies the operands into contiguous micro-panels
+         of NR columns and MR rows, respectively, padded with zeros, so
+         that the micro-kernel reads both with unit stride.  The
+         micro-kernel computes an MR x NR tile of C, kept in registers
+         for the whole length KC, with one fused multiply-add of a
+         column of A by a broadcast element of B per vector of the tile:
+         8 x 6 for AVX2, 16 x 8 for AVX-512, and 4 x 4 in plain C.
+         Tiles at the bottom and right edges of C are computed into a
+         scratch tile and added to C.
+
+         The default blocks below are sized so that a KC x NR
+         micro-panel of B stays in L1, an MC x KC block of A in L2, and
+         a KC x NC panel of B in L3; they round up to multiples of MR and
+         NR.  PRK_DGEMM_BLOCKING=mc,kc,nc overrides them (a zero keeps
+         the default), as does -DDGEMM_MC=, -DDGEMM_KC= or -DDGEMM_NC=
+         in USERFLAGS at compile time.  prk_dgemm_workspace returns the number of doubles of
+         packing space that one caller of prk_dgemm_packed needs; callers
+         that run concurrently need one workspace each.
+
+         PRK_SIMD=avx512|avx2|scalar restricts the choice of micro-kernel
+         to the named path, if the CPU supports it.
+
+*******************************************************************/
+
+#ifndef PRK_DGEMM_SIMD_H
+#define PRK_DGEMM_SIMD_H
+
+#include <stddef.h>
+
+typedef void (*prk_dgemm_ukernel_t)(long, const double *, const double *,
+                                    double *, long);
+
+typedef struct {
+  const char *        isa;      /* name of the instruction set            */
+  int                 mr, nr;   /* rows and columns of a register tile    */
+  int                 mc, kc, nc; /* default cache blocking               */
+  prk_dgemm_ukernel_t ukernel;  /* C(0:mr,0:nr) += Ap x Bp                */
+} prk_dgemm_kernel_t;
+
+extern const prk_dgemm_kernel_t * prk_dgemm_simd(void);
+extern void   prk_dgemm_blocking(const prk_dgemm_kernel_t *, int *);
+extern size_t prk_dgemm_workspace(const prk_dgemm_kernel_t *, const int *);
+extern void   prk_dgemm_packed(const prk_dgemm_kernel_t *, const int *,
+                               long, long, long,
+                               const double *, long, const double *, long,
+                               double *, long, double *);
+
+#endif
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_energy
+
+PURPOSE: Optional energy measurement of the timed region of a kernel.
+         The timing harness (prk_harness.h) starts the measurement at
+         its first tick and stops it when the last timed iteration
+         completes, and prk_harness_report() prints the energy per
+         iteration, the average power and the rate per watt.
+
+USAGE:   The energy sources are selected at run time:
+
+           PRK_ENERGY=1            all sources that can be read
+           PRK_ENERGY=<list>       comma-separated list of rapl, nvml
+
+         rapl reads the package and DRAM domains of the Linux powercap
+         interface (/sys/class/powercap/intel-rapl:*, also provided
+         for AMD processors); the files are readable only by root on
+         recent kernels.  nvml reads the energy counter of every GPU
+         through the NVIDIA Management Library and is available if
+         the kernel is built with NVMLTOP set in make.defs.
+
+         Without PRK_ENERGY nothing is read and the start, sample and
+         stop calls are no-ops.
+
+         In MPI builds prk_energy_init() is collective over
+         MPI_COMM_WORLD: the ranks of every node (as seen by
+         MPI_COMM_TYPE_SHARED) elect one rank that reads the node, and
+         the other ranks report no energy, so that the energy summed
+         over ranks is that of all nodes used.  The counters are
+         sampled by prk_energy_sample() at least once a second while
+         the measurement runs, so wraparound of the RAPL counters is
+         accounted for.
+
+HISTORY: - Written in October 2026.
+
+*******************************************************************/
+
+#ifndef PRK_ENERGY_H
+#define PRK_ENERGY_H
+
+extern void         prk_energy_init(void);
+extern int          prk_energy_enabled(void);
+extern int          prk_energy_readers(void);
+extern const char * prk_energy_sources(void);
+extern void         prk_energy_start(void);
+extern void         prk_energy_sample(double);
+extern void         prk_energy_stop(void);
+extern double       prk_energy_joules(void);
+extern void         prk_energy_finalize(void);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_harness
+
+PURPOSE: Common timing harness for the kernels.  It records the wall
+         clock time of every timed iteration, reports min, median, p95
+         and max iteration times next to the traditional average, and
+         optionally appends a machine-readable record of the run to a
+         results file.
+
+USAGE:   prk_harness_t h;
+         prk_harness_init(&h, "Stencil", "OpenMP", iterations);
+         prk_harness_param(&h, "grid_size", "%ld", n);
+         for (iter=0; iter<=iterations; iter++) {
+           if (iter>0) prk_harness_tick(&h);  <- start of timed iteration
+           ...
+         }
+         prk_harness_tick(&h);                <- end of last iteration
+         time = prk_harness_elapsed(&h);
+         ...
+         prk_harness_model(&h, flops, bytes);  <- optional, see below
+         prk_harness_report(&h, "MB/s", 1.0E-06*bytes);
+         prk_harness_finalize(&h);
+
+         The rate in the report and the results record is the work per
+         iteration divided by the elapsed time per iteration, which in
+         MPI builds is the longest elapsed time of any rank, the same
+         figure as the "Rate" line that the kernels print.  Reducing
+         every iteration with MPI_MAX instead, as the statistics do,
+         gives a longer average whenever different ranks are slowest in
+         different iterations.
+
+         Successive calls to prk_harness_tick() delimit iterations, so
+         the first tick replaces the "if (iter==1) time = wtime()" idiom
+         and the last one replaces "time = wtime() - time".  In OpenMP
+         kernels ticks must be called by a single thread, behind the same
+         barrier that protected the original wtime() calls.  In MPI
+         kernels every rank ticks locally and prk_harness_report() is
+         collective over MPI_COMM_WORLD: iteration times are reduced with
+         MPI_MAX, matching the reduction the kernels apply to the total.
+         That hides which ranks are slow; in MPI kernels two settings
+         report per rank:
+           PRK_STRAGGLERS=<factor>      print min, median and max over the
+                                        ranks of every iteration, and flag
+                                        the ranks slower than factor times
+                                        the median in most iterations,
+                                        with their hosts (e.g. 1.2)
+           PRK_RANK_TIMES=<path>        write the time of every iteration
+                                        on every rank to <path>, as CSV
+                                        with one row per rank
+         SHMEM kernels reduce over all PEs in the same way, without the
+         per-rank settings.
+         Kernels that fuse k iterations into one step, for instance by
+         pipelining, end the step with prk_harness_ticks(&h, k), which
+         records k iterations of equal length.
+
+         Phases inside an iteration, e.g. a halo exchange or a single
+         barrier, are timed with a phase timer:
+
+           prk_phase_t halo;
+           prk_phase_init(&halo, "halo exchange");
+           ...
+           prk_phase_begin(&halo); exchange(); prk_phase_end(&halo);
+           or, equivalently,
+           PRK_PHASE(&halo) { exchange(); }
+           ...
+           prk_phase_report(&halo);
+
+         Initialize phase timers before a warmup iteration that already
+         runs the phases, and discard the warmup with prk_phase_reset().
+
+         Phase timers read wtime() directly, so for sub-microsecond
+         phases select a high-resolution clock with PRK_TIMER=monotonic
+         or PRK_TIMER=tsc (see common/wtime.c).  prk_phase_report() is
+         collective in MPI and SHMEM builds, like prk_harness_report().
+
+         The results file is selected at run time:
+           PRK_RESULTS=<path>           append one record per run to <path>
+           PRK_RESULTS_FORMAT=json|csv  record format; the default is csv
+                                        if <path> ends in ".csv" and JSON
+                                        (one object per line) otherwise
+           PRK_LOG=<path>               stream a fixed-size record of the
+                                        run into <path> while it runs
+                                        (see prk_log.h)
+
+         Hardware counters (PRK_COUNTERS, see prk_counters.h) are
+         started at the first tick, stopped when the last iteration is
+         recorded and printed and recorded by prk_harness_report(),
+         summed over threads and MPI ranks or SHMEM PEs.
+
+         prk_harness_model() gives the modeled number of floating point
+         operations and bytes moved to and from memory per timed
+         iteration, summed over all threads and ranks (every rank passes
+         the same values).  The report then prints the arithmetic
+         intensity and the achieved flop and byte rates; with
+         PRK_ROOFLINE=1 it also measures the machine bandwidth and peak
+         flop rate (see prk_roofline.h) and prints the fraction of the
+         roofline bound min(peak, intensity*bandwidth) that was reached.
+
+HISTORY: - Written in October 2026 to replace the timing code duplicated in
+           every kernel.
+
+*******************************************************************/
+
+#ifndef PRK_HARNESS_H
+#define PRK_HARNESS_H
+
+#define PRK_HARNESS_MAX_PARAMS 16
+#define PRK_HARNESS_KEY_LEN    32
+#define PRK_HARNESS_VALUE_LEN  64
+
+typedef struct {
+  const char * kernel;        /* name of the kernel, e.g. "Transpose"        */
+  const char * model;         /* programming model, e.g. "MPI1"              */
+  int          capacity;      /* number of iterations that can be recorded   */
+  int          count;         /* number of iterations recorded so far        */
+  int          ticking;       /* nonzero after the first tick                */
+  double       last;          /* time stamp of the most recent tick          */
+  double       first;         /* time stamp of the first tick               */
+  double     * times;         /* duration of every recorded iteration        */
+  int          nparams;       /* number of kernel parameters recorded        */
+  char         key[PRK_HARNESS_MAX_PARAMS][PRK_HARNESS_KEY_LEN];
+  char         value[PRK_HARNESS_MAX_PARAMS][PRK_HARNESS_VALUE_LEN];
+  int          modeled;       /* nonzero after prk_harness_model()           */
+  double       flops;         /* modeled flops per iteration                 */
+  double       bytes;         /* modeled bytes moved per iteration           */
+  double       peak;          /* measured peak flop/s, 0 if not probed       */
+  double       bandwidth;     /* measured bytes/s, 0 if not probed           */
+} prk_harness_t;
+
+typedef struct {
+  int    count;               /* number of iterations summarized            */
+  double total;               /* sum of the iteration times                 */
+  double avg, min, median, p95, max, stddev;
+  double elapsed;             /* time from the first to the last tick, of
+                                 the slowest rank in MPI builds; the rate
+                                 is based on it, like the kernels' own    */
+} prk_stats_t;
+
+typedef struct {
+  const char * name;          /* name of the phase, e.g. "halo exchange"     */
+  long         count;         /* number of completed begin/end pairs         */
+  int          active;        /* nonzero between begin and end               */
+  double       start;         /* time stamp of the most recent begin         */
+  double       total, min, max;
+} prk_phase_t;
+
+/* time the statement following the macro as one instance of a phase     */
+#define PRK_PHASE(p) \
+  for (prk_phase_begin(p); (p)->active; prk_phase_end(p))
+
+static inline void prk_phase_begin(prk_phase_t * p) {
+  p->active = 1;
+  p->start  = wtime();
+}
+
+static inline void prk_phase_end(prk_phase_t * p) {
+  double t = wtime() - p->start;
+  p->active = 0;
+  p->total += t;
+  if (p->count == 0 || t < p->min) p->min = t;
+  if (p->count == 0 || t > p->max) p->max = t;
+  p->count++;
+}
+
+/* discard the instances timed so far, e.g. those of a warmup iteration   */
+static inline void prk_phase_reset(prk_phase_t * p) {
+  p->count  = 0;
+  p->active = 0;
+  p->total  = p->min = p->max = 0.0;
+}
+
+extern void   prk_phase_init(prk_phase_t *, const char *);
+extern void   prk_phase_report(const prk_phase_t *);
+
+extern void   prk_harness_init(prk_harness_t *, const char *, const char *, int);
+extern void   prk_harness_param(prk_harness_t *, const char *, const char *, ...);
+extern void   prk_harness_tick(prk_harness_t *);
+extern void   prk_harness_ticks(prk_harness_t *, int);
+extern double prk_harness_elapsed(const prk_harness_t *);
+extern void   prk_harness_stats(const double *, int, prk_stats_t *);
+extern double prk_harness_rate(const prk_stats_t *, double);
+extern void   prk_harness_model(prk_harness_t *, double, double);
+extern void   prk_harness_report(prk_harness_t *, const char *, double);
+extern void   prk_harness_finalize(prk_harness_t *);
+
+#endif
@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+
+/*******************************************************************
+
+NAME:    prk_histogram
+
+PURPOSE: Latency histogram with power-of-two bins, for kernels that
+         time individual operations rather than whole iterations.  Bin
+         b counts latencies in [2^b, 2^(b+1)) nanoseconds.  Latencies
+         below the resolution of wtime() cannot be told apart, so the
+         first bin used is the one holding that resolution, and it takes
+         everything below it; the last bin takes everything above.
+
+USAGE:   prk_histogram_t h;
+         prk_histogram_init(&h);
+         t = wtime(); <operation>; prk_histogram_add(&h, wtime()-t);
+         ...
+         prk_histogram_print(&h, "fetch_and_op");
+
+NOTES:   The counts are a plain array of long long, so histograms of
+         several processes are combined with a single sum reduction,
+         e.g. MPI_Reduce(h.count, total.count, PRK_HISTOGRAM_BINS,
+         MPI_LONG_LONG, MPI_SUM, root, comm).  Percentiles are reported
+         as the upper edge of the bin they fall in, so they are accurate
+         to within a factor of two, and never below the first bin; the
+         resolution of wtime() is printed beside them.
+
+*******************************************************************/
+
+#ifndef PRK_HISTOGRAM_H
+#define PRK_HISTOGRAM_H
+
+#define PRK_HISTOGRAM_BINS 40
+
+typedef struct {
+  long long count[PRK_HISTOGRAM_BINS];  /* number of samples per bin          */
+  double    resolution;                 /* resolution of wtime() in seconds   */
+  int       first;                      /* bin holding the resolution         */
+} prk_histogram_t;
+
+static inline void prk_histogram_init(prk_histogram_t * h)
+{
+    double ns = 1.0e9 * wtime_resolution();
+    int    b;
+    for (b=0; b<PRK_HISTOGRAM_BINS; b++) h->count[b] = 0;
+    h->resolution = 1.0e-9 * ns;
+    h->first      = 0;
+    while (ns >= 2.0 && h->first < PRK_HISTOGRAM_BINS-1) {
+        ns *= 0.5;
+        h->first++;
+    }
+}
+
+/* records one latency, given in seconds                                  */
+static inline void prk_histogram_add(prk_histogram_t * h, double seconds)
+{
+    double ns = 1.0e9 * seconds;
+    int    b  = 0;
+    while (ns >= 2.0 && b < PRK_HISTOGRAM_BINS-1) {
+        ns *= 0.5;
+        b++;
+    }
+    h->count[MAX(b, h->first)]++;
+}
+
+static inline long long prk_histogram_total(const prk_histogram_t * h)
+{
+    long long total = 0;
+    int       b;
+    for (b=0; b<PRK_HISTOGRAM_BINS; b++) total += h->count[b];
+    return total;
+}
+
+/* upper edge in seconds of the bin holding the given fraction of samples */
+static inline double prk_histogram_percentile(const prk_histogram_t * h, double fraction)
+{
+    long long total = prk_histogram_total(h), sum = 0;
+    int       b;
+    for (b=0; b<PRK_HISTOGRAM_BINS; b++) {
+        sum += h->count[b];
+        if (sum > 0 && sum >= fraction * total) break;
+    }
+    return 1.0e-9 * (double) (2LL << MIN(b, PRK_HISTOGRAM_BINS-1));
+}
+
+/* prints the nonempty bins with their share of the samples, followed by
+   the median, p99 and p99.9 and the timer resolution                    */
+static inline void prk_histogram_print(const prk_histogram_t * h, const char * label)
+{
+    long long total = prk_histogram_total(h), sum = 0;
+    int       b;
+
+    printf("Latency histogram for %s (%lld operations):\n", label, total);
+    if (total == 0) return;
+    printf("        latency (us)          count      %%     cum %%\n");
+    for (b=0; b<PRK_HISTOGRAM_BINS; b++) {
+        if (h->count[b] == 0) continue;
+        sum += h->count[b];
+        printf("  %10.3f - %10.3f %12lld %6.2f %8.2f\n",
+               b > h->first ? 1.0e-3 * (double) (1LL << b) : 0.0, 1.0e-3 * (double) (2LL << b),
+               h->count[b], 100.0 * h->count[b] / total, 100.0 * sum / total);
+    }
+    printf("  median <= %.3f us, p99 <= %.3f us, p99.9 <= %.3f us (timer resolution %.3f us)\n",
+           1.0e6 * prk_histogram_percentile(h, 0.5),
+           1.0e6 * prk_histogram_percentile(h, 0.99),
+           1.0e6 * prk_histogram_percentile(h, 0.999), 1.0e6 * h->resolution);
+}
+
+#endif /* PRK_HISTOGRAM_H */
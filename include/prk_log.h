@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_log
+
+PURPOSE: Crash-safe streaming log of results.  The timing harness
+         (prk_harness.h) reserves a record in a log file at its first
+         tick and fills it in place while the kernel runs, so that the
+         runs of a long sweep that completed, and the iterations of a
+         run that did not, survive if the job is killed.
+
+USAGE:   The log is selected at run time:
+
+           PRK_LOG=<path>          append one record per run to <path>
+
+         The log is a CSV file with a header line and one line per run.
+         Every field except the kernel name, model, version and timer
+         has a fixed width, so the length of a record is known when it
+         is reserved and all later updates are stores into a mapping of
+         the record (mmap, MAP_SHARED):
+
+           status      "running" until prk_harness_report(), then "done"
+           start       time the record was reserved, seconds since 1970
+           params      kernel parameters, key=value;...  (at most 512
+                       characters, padded with blanks)
+           iterations  number of timed iterations requested
+           count       number of iterations recorded so far
+           avg ... p95 statistics and rate, blank until "done"
+           counters    name=value;... of PRK_COUNTERS, blank until "done"
+           energy      joules, if PRK_ENERGY is set
+           times       one 15-character slot per iteration, separated by
+                       ';', filled as iterations complete
+
+         Trailing blanks of a field are padding.  A record left
+         "running" by a job that died holds the times of all iterations
+         it completed.  Processes that share a log reserve records under
+         an fcntl lock on the file, so runs of a sweep may run
+         concurrently.  Records that are completed are flushed with
+         msync; the others reach the file when the operating system
+         writes back the page cache, which survives the death of the
+         process but not of the node.
+
+         In MPI and SHMEM builds only rank (PE) 0 writes: during the
+         run the record holds the times of rank 0 and
+         prk_harness_report() replaces them by the times reduced over
+         ranks.
+
+HISTORY: - Written in October 2026.
+
+*******************************************************************/
+
+#ifndef PRK_LOG_H
+#define PRK_LOG_H
+
+extern void prk_log_begin(const prk_harness_t *);
+extern void prk_log_time(int, double);
+extern void prk_log_end(const prk_harness_t *, const double *, const prk_stats_t *,
+                        const char *, double, const unsigned long long *, double);
+extern void prk_log_close(void);
+
+#endif
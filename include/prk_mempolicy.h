@@ -0,0 +1,366 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_mempolicy
+
+PURPOSE: Page size and NUMA placement policies for prk_malloc().  By
+         default prk_malloc() only controls alignment (PRK_ALIGNMENT);
+         the following environment variables switch it to mmap-based
+         allocation with an explicit policy:
+
+           PRK_HUGEPAGES=thp      transparent 2MB huge pages (madvise)
+           PRK_HUGEPAGES=2M       explicit 2MB huge pages (MAP_HUGETLB)
+           PRK_HUGEPAGES=1G       explicit 1GB huge pages (MAP_HUGETLB)
+           PRK_NUMA=interleave    interleave pages over all online nodes
+           PRK_NUMA=bind:<node>   place all pages on node <node>
+           PRK_NUMA=firsttouch    fault pages in with a static OpenMP
+                                  schedule, so each thread's share of the
+                                  array lands on its own node
+
+         Explicit huge pages fall back to transparent huge pages if the
+         system has no free pages of the requested size.  The page size
+         actually granted for the first large allocation is printed once.
+
+         prk_node_cpus(), prk_bind_cpus() and prk_mempolicy_bind() let a
+         kernel run threads on one node and place memory on another.
+
+NOTES:   prk_malloc() records in front of every block whether it was
+         mapped or allocated from the heap, so prk_free() must only be
+         given blocks returned by prk_malloc().  The policies are
+         not available with PRK_USE_MALLOC.  Only Linux is supported;
+         elsewhere the variables are ignored.  No libnuma is needed,
+         mbind(2) is called directly.
+
+*******************************************************************/
+
+#ifndef PRK_MEMPOLICY_H
+#define PRK_MEMPOLICY_H
+
+#if defined(__linux__) && !defined(__UPC__)
+  #define PRK_HAVE_MEMPOLICY 1
+#endif
+
+#if PRK_HAVE_MEMPOLICY
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+/* strict ISO C modes (-std=c99) hide these Linux extensions             */
+#ifndef MAP_ANONYMOUS
+  #define MAP_ANONYMOUS 0x20
+#endif
+#ifndef MADV_HUGEPAGE
+  #define MADV_HUGEPAGE 14
+#endif
+extern long syscall(long number, ...);
+extern int  madvise(void * addr, size_t length, int advice);
+#ifndef MAP_HUGETLB
+  #define MAP_HUGETLB 0x40000
+#endif
+#ifndef MAP_HUGE_SHIFT
+  #define MAP_HUGE_SHIFT 26
+#endif
+/* from <numaif.h>, which is not always installed                       */
+#define PRK_MPOL_BIND       2
+#define PRK_MPOL_INTERLEAVE 3
+#define PRK_MPOL_MF_MOVE    (1<<1)
+#define PRK_MAX_NUMA_NODES  1024
+#define PRK_MAX_CPUS        4096
+
+enum { PRK_PAGES_DEFAULT, PRK_PAGES_THP, PRK_PAGES_2M, PRK_PAGES_1G };
+enum { PRK_NUMA_DEFAULT, PRK_NUMA_INTERLEAVE, PRK_NUMA_BIND, PRK_NUMA_FIRSTTOUCH };
+
+typedef struct {
+  int pages;             /* one of PRK_PAGES_*                             */
+  int numa;              /* one of PRK_NUMA_*                              */
+  int node;              /* target node of PRK_NUMA_BIND                   */
+  int reported;          /* nonzero once the granted page size is printed  */
+  int warned;            /* nonzero once a fallback warning is printed     */
+} prk_mempolicy_t;
+
+/* stored in front of every mapped block                                 */
+typedef struct {
+  void     * base;       /* start of the mapping                           */
+  size_t     length;     /* length of the mapping                          */
+} prk_map_header_t;
+
+static inline prk_mempolicy_t * prk_get_mempolicy(void)
+{
+    static prk_mempolicy_t policy;
+    static int             initialized = 0;
+    char * temp;
+
+    if (initialized) return &policy;
+    policy.pages = PRK_PAGES_DEFAULT;
+    policy.numa  = PRK_NUMA_DEFAULT;
+    policy.node  = 0;
+    policy.reported = 0;
+    policy.warned   = 0;
+
+    temp = getenv("PRK_HUGEPAGES");
+    if (temp != NULL && *temp != '\0') {
+        if      (!strcmp(temp,"thp")) policy.pages = PRK_PAGES_THP;
+        else if (!strcmp(temp,"2M"))  policy.pages = PRK_PAGES_2M;
+        else if (!strcmp(temp,"1G"))  policy.pages = PRK_PAGES_1G;
+        else if (strcmp(temp,"none")) printf("WARNING: unknown PRK_HUGEPAGES=%s ignored\n", temp);
+    }
+    temp = getenv("PRK_NUMA");
+    if (temp != NULL && *temp != '\0') {
+        if      (!strcmp(temp,"interleave"))  policy.numa = PRK_NUMA_INTERLEAVE;
+        else if (!strcmp(temp,"firsttouch"))  policy.numa = PRK_NUMA_FIRSTTOUCH;
+        else if (!strncmp(temp,"bind:",5)) {
+            policy.numa = PRK_NUMA_BIND;
+            policy.node = atoi(temp+5);
+            if (policy.node < 0 || policy.node >= PRK_MAX_NUMA_NODES) {
+                printf("WARNING: invalid NUMA node in PRK_NUMA=%s ignored\n", temp);
+                policy.numa = PRK_NUMA_DEFAULT;
+            }
+        }
+        else if (strcmp(temp,"none")) printf("WARNING: unknown PRK_NUMA=%s ignored\n", temp);
+    }
+    initialized = 1;
+    return &policy;
+}
+
+static inline int prk_mempolicy_active(void)
+{
+    prk_mempolicy_t * p = prk_get_mempolicy();
+    return p->pages != PRK_PAGES_DEFAULT || p->numa != PRK_NUMA_DEFAULT;
+}
+
+/* sets the bits of a list such as "0-3,8" in mask, which holds max bits */
+static inline void prk_parse_list(const char * list, unsigned long * mask, int max)
+{
+    int i, lo, hi, n;
+    const char * c;
+
+    for (c = list; *c != '\0' && *c != '\n'; ) {
+        n = sscanf(c, "%d-%d", &lo, &hi);
+        if (n < 1) break;
+        if (n == 1) hi = lo;
+        for (i=lo; i<=hi && i<max; i++) {
+          mask[i/(8*sizeof(unsigned long))] |= 1UL << (i%(8*sizeof(unsigned long)));
+        }
+        while (*c != ',' && *c != '\0' && *c != '\n') c++;
+        if (*c == ',') c++;
+    }
+}
+
+/* set bits for all online nodes, from a list such as "0-3,8"             */
+static inline void prk_online_nodes(unsigned long * mask)
+{
+    char list[256];
+    FILE * f;
+
+    memset(mask, 0, PRK_MAX_NUMA_NODES/8);
+    f = fopen("/sys/devices/system/node/online","r");
+    if (f == NULL || fgets(list, sizeof(list), f) == NULL) {
+        mask[0] = 1;
+        if (f) fclose(f);
+        return;
+    }
+    fclose(f);
+    prk_parse_list(list, mask, PRK_MAX_NUMA_NODES);
+}
+
+/* sets the bits of the CPUs of a NUMA node in mask (PRK_MAX_CPUS bits);
+   returns the number of CPUs, 0 if they are unknown                     */
+static inline int prk_node_cpus(int node, unsigned long * mask)
+{
+    char   name[64], list[4096];
+    int    i, count = 0;
+    FILE * f;
+
+    memset(mask, 0, PRK_MAX_CPUS/8);
+    sprintf(name, "/sys/devices/system/node/node%d/cpulist", node);
+    f = fopen(name,"r");
+    if (f == NULL) return 0;
+    if (fgets(list, sizeof(list), f) != NULL) prk_parse_list(list, mask, PRK_MAX_CPUS);
+    fclose(f);
+    for (i=0; i<PRK_MAX_CPUS; i++) count += (mask[i/(8*sizeof(unsigned long))] >> (i%(8*sizeof(unsigned long)))) & 1;
+    return count;
+}
+
+/* restricts the calling thread to the CPUs in mask; returns 0 on success */
+static inline int prk_bind_cpus(const unsigned long * mask)
+{
+    return (int) syscall(SYS_sched_setaffinity, 0, (size_t) PRK_MAX_CPUS/8, mask);
+}
+
+/* places the pages overlapping [addr,addr+bytes) on node, moving those
+   that are already placed elsewhere; returns 0 on success                */
+static inline int prk_mempolicy_bind(void * addr, size_t bytes, int node)
+{
+    unsigned long mask[PRK_MAX_NUMA_NODES/(8*sizeof(unsigned long))];
+    size_t        page  = (size_t) sysconf(_SC_PAGESIZE);
+    uintptr_t     start = (uintptr_t) addr & ~(uintptr_t)(page-1);
+    uintptr_t     end   = ((uintptr_t) addr + bytes + page-1) & ~(uintptr_t)(page-1);
+
+    memset(mask, 0, sizeof(mask));
+    mask[node/(8*sizeof(unsigned long))] = 1UL << (node%(8*sizeof(unsigned long)));
+    return (int) syscall(SYS_mbind, (void *) start, (size_t) (end-start), PRK_MPOL_BIND, mask,
+                         PRK_MAX_NUMA_NODES, PRK_MPOL_MF_MOVE);
+}
+
+/* page size the kernel used for the mapping containing addr, in bytes   */
+static inline size_t prk_granted_page_size(void * addr)
+{
+    FILE * f = fopen("/proc/self/smaps","r");
+    char   line[256];
+    unsigned long start, end, kb, page = 0, huge = 0;
+    int    inside = 0;
+
+    if (f == NULL) return 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "%lx-%lx", &start, &end) == 2 && strchr(line,'-') < strchr(line,' ')) {
+            if (inside) break;
+            inside = (uintptr_t) addr >= start && (uintptr_t) addr < end;
+        }
+        else if (inside && sscanf(line, "KernelPageSize: %lu kB", &kb) == 1) page = kb;
+        else if (inside && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)  huge = kb;
+    }
+    fclose(f);
+    /* transparent huge pages show up in AnonHugePages only               */
+    if (huge > 0 && page < 2048) page = 2048;
+    return (size_t) page*1024;
+}
+
+static inline void * prk_mempolicy_malloc(size_t bytes, size_t alignment)
+{
+    prk_mempolicy_t  * p = prk_get_mempolicy();
+    size_t             page = (size_t) sysconf(_SC_PAGESIZE), offset, length, slack = 0;
+    int                flags = MAP_PRIVATE | MAP_ANONYMOUS, pages = p->pages;
+    char             * base = (char *) MAP_FAILED, * aligned;
+    prk_map_header_t * h;
+
+    /* room for the header in front of the user's block, keeping alignment */
+    offset = alignment;
+    while (offset < sizeof(prk_map_header_t)) offset += alignment;
+
+    if (pages == PRK_PAGES_2M || pages == PRK_PAGES_1G) {
+        size_t huge = (pages == PRK_PAGES_2M) ? (size_t)1<<21 : (size_t)1<<30;
+        int    log2 = (pages == PRK_PAGES_2M) ? 21 : 30;
+        length = ((offset+bytes+huge-1)/huge)*huge;
+        base   = (char *) mmap(NULL, length, PROT_READ | PROT_WRITE,
+                               flags | MAP_HUGETLB | (log2 << MAP_HUGE_SHIFT), -1, 0);
+        if (base == MAP_FAILED) {
+            if (!p->warned++) printf("WARNING: no %s huge pages available; using transparent huge pages\n",
+                                     pages == PRK_PAGES_2M ? "2MB" : "1GB");
+            pages = PRK_PAGES_THP;
+        }
+    }
+    if (base == MAP_FAILED) {
+        /* over-allocate so the block can start on a 2MB boundary, which
+           transparent huge pages require                                 */
+        if (pages == PRK_PAGES_THP) slack = (size_t)1<<21;
+        length = ((offset+bytes+page-1)/page)*page + slack;
+        base   = (char *) mmap(NULL, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (base == MAP_FAILED) return NULL;
+        if (slack) {
+            char * start = (char *) (((uintptr_t) base + slack - 1) & ~(uintptr_t)(slack-1));
+            if (start > base) munmap(base, start-base);
+            length -= start-base;
+            if (length > ((offset+bytes+page-1)/page)*page) {
+                size_t keep = ((offset+bytes+page-1)/page)*page;
+                munmap(start+keep, length-keep);
+                length = keep;
+            }
+            base = start;
+            madvise(base, length, MADV_HUGEPAGE);
+        }
+    }
+
+    if (p->numa == PRK_NUMA_INTERLEAVE || p->numa == PRK_NUMA_BIND) {
+        unsigned long mask[PRK_MAX_NUMA_NODES/(8*sizeof(unsigned long))];
+        int mode = PRK_MPOL_INTERLEAVE;
+        if (p->numa == PRK_NUMA_BIND) {
+            memset(mask, 0, sizeof(mask));
+            mask[p->node/(8*sizeof(unsigned long))] = 1UL << (p->node%(8*sizeof(unsigned long)));
+            mode = PRK_MPOL_BIND;
+        }
+        else prk_online_nodes(mask);
+        if (syscall(SYS_mbind, base, length, mode, mask, PRK_MAX_NUMA_NODES, 0) != 0 && !p->warned++) {
+            printf("WARNING: mbind failed; NUMA policy %s not applied\n",
+                   p->numa == PRK_NUMA_BIND ? "bind" : "interleave");
+        }
+    }
+
+#ifdef _OPENMP
+    if (p->numa == PRK_NUMA_FIRSTTOUCH && !omp_in_parallel()) {
+        long i, npages = (long) (length/page);
+        #pragma omp parallel for schedule(static)
+        for (i=0; i<npages; i++) ((volatile char *) base)[i*page] = 0;
+    }
+#endif
+
+    aligned   = base + offset;
+    h         = (prk_map_header_t *) (aligned - sizeof(prk_map_header_t));
+    h->base   = base;
+    h->length = length;
+
+    if (!p->reported && bytes >= ((size_t)1<<21)) {
+        p->reported = 1;
+        printf("prk_malloc: huge pages = %s, NUMA = %s, granted page size = %zu bytes\n",
+               pages == PRK_PAGES_DEFAULT ? "none" : pages == PRK_PAGES_THP ? "thp" :
+               pages == PRK_PAGES_2M ? "2M" : "1G",
+               p->numa == PRK_NUMA_DEFAULT ? "default" : p->numa == PRK_NUMA_INTERLEAVE ? "interleave" :
+               p->numa == PRK_NUMA_BIND ? "bind" : "firsttouch",
+               prk_granted_page_size(aligned));
+    }
+    return aligned;
+}
+
+/* while a policy is active every block from prk_malloc() is mapped     */
+static inline int prk_mempolicy_free(void * ptr)
+{
+    prk_map_header_t * h;
+
+    if (ptr == NULL || !prk_mempolicy_active()) return 0;
+    h = (prk_map_header_t *) ((char *) ptr - sizeof(prk_map_header_t));
+    munmap(h->base, h->length);
+    return 1;
+}
+
+#else /* !PRK_HAVE_MEMPOLICY */
+
+static inline int    prk_mempolicy_active(void) { return 0; }
+static inline void * prk_mempolicy_malloc(size_t bytes, size_t alignment) { return NULL; }
+static inline int    prk_mempolicy_free(void * ptr) { return 0; }
+
+#endif
+
+#endif /* PRK_MEMPOLICY_H */
@@ -0,0 +1,77 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_memstats
+
+PURPOSE: Accounting of the memory allocated with prk_malloc(): bytes
+         live, peak bytes live and number of allocations, plus the peak
+         resident set size of the process.  With PRK_MEMSTATS=1 each
+         process prints one line at exit, tagged with its MPI rank if
+         the launcher exports it, e.g.
+
+           Memory footprint (rank 3): prk_malloc peak 1.2e+03 MB in 12
+           allocations, live at exit 0 MB, peak RSS 1.3e+03 MB
+
+NOTES:   The counters live in common/prk_memstats.c, so blocks may be
+         allocated and released in different translation units.
+         prk_malloc() stores the size of every block in a small header
+         in front of it, so prk_free() needs no size argument.  There is
+         no accounting with PRK_USE_MALLOC.
+
+*******************************************************************/
+
+#ifndef PRK_MEMSTATS_H
+#define PRK_MEMSTATS_H
+
+#include <stddef.h>
+
+typedef struct {
+  size_t         live;       /* bytes currently allocated                  */
+  size_t         peak;       /* largest value of live                      */
+  unsigned long  count;      /* number of allocations                      */
+} prk_memstats_t;
+
+/* stored in front of every block returned by prk_malloc()               */
+typedef struct {
+  size_t         bytes;      /* size requested by the caller               */
+  size_t         offset;     /* distance to the start of the allocation    */
+  int            mapped;     /* nonzero if mapped by prk_mempolicy.h       */
+} prk_memstats_header_t;
+
+extern void   prk_memstats_add(size_t);
+extern void   prk_memstats_remove(size_t);
+extern void   prk_memstats_get(prk_memstats_t *);
+extern double prk_peak_rss(void);
+extern void   prk_memstats_report(void);
+
+#endif /* PRK_MEMSTATS_H */
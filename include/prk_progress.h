@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_progress
+
+PURPOSE: Optional helper thread that drives the progress engine of the
+         MPI library while the rank computes, so that the benefit of
+         overlapping communication with computation can be measured
+         with and without asynchronous progress.
+
+USAGE:   Kernels call prk_progress_init() instead of MPI_Init and
+         prk_progress_finalize() instead of MPI_Finalize; bail_out()
+         stops the thread as well.  The thread is selected at run time:
+
+           PRK_PROGRESS=1          start an unpinned progress thread
+           PRK_PROGRESS=spare      pin it to a spare core: the ranks of a
+                                   node take the highest-numbered CPUs,
+                                   one each, counting down
+           PRK_PROGRESS=cpu:<k>    pin it to CPU k plus the rank's number
+                                   on its node
+           PRK_PROGRESS_SLEEP=<us> pause between polls (default 0, i.e.
+                                   poll continuously)
+
+         With a thread MPI is initialized with MPI_THREAD_MULTIPLE; if
+         the library does not provide it, a warning is printed and no
+         thread is started.  The thread calls MPI_Iprobe on a private
+         duplicate of MPI_COMM_WORLD, on which no message is ever sent,
+         so it never matches or completes the kernel's requests; each
+         call only lets the library advance the transfers in flight.
+         The PMPI entry point is used, so a profiled build (PMPI_PROFILE)
+         does not count the polls.
+
+         Without PRK_PROGRESS the calls reduce to MPI_Init and
+         MPI_Finalize.  Only the MPI1 kernels Stencil, Transpose,
+         Random and CG start the thread.
+
+HISTORY: - Written in October 2026.
+
+*******************************************************************/
+
+#ifndef PRK_PROGRESS_H
+#define PRK_PROGRESS_H
+
+extern int          prk_progress_init(int *, char ***);
+extern const char * prk_progress_mode(void);
+extern void         prk_progress_stop(void);
+extern int          prk_progress_finalize(void);
+
+#endif
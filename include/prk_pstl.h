@@ -0,0 +1,146 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+
+/*******************************************************************
+
+NAME:    prk_pstl
+
+PURPOSE: Support for the C++17 parallel algorithm (CXX) kernels: an
+         integer range whose iterators can be handed to the algorithms
+         of <algorithm> and <numeric> with an execution policy, and a
+         cap on the number of threads of the parallel backend.
+
+USAGE:   prk_pstl_threads threads(nthread_input);
+         prk_range rows(0, n);
+         std::for_each(std::execution::par_unseq, rows.begin(), rows.end(),
+                       [&](long i) { ... });
+
+NOTES:   The standard has no way to set the number of threads used by an
+         execution policy.  When libstdc++ runs the algorithms on TBB,
+         prk_pstl_threads caps the TBB arena for as long as the object
+         lives; with other backends it only records the request, and
+         prk_pstl_threads::honored() is false.
+
+*******************************************************************/
+
+#ifndef PRK_PSTL_H
+#define PRK_PSTL_H
+
+#include <algorithm>
+#include <execution>
+#include <iterator>
+#include <numeric>
+
+#if defined(_PSTL_PAR_BACKEND_TBB) && defined(__has_include)
+#if __has_include(<tbb/global_control.h>)
+#include <tbb/global_control.h>
+#define PRK_PSTL_HAVE_TBB_CONTROL
+#endif
+#endif
+
+/* largest number of threads accepted on the command line, as for OpenMP */
+#ifndef MAXTHREADS
+  #define MAX_THREADS 512
+#else
+  #define MAX_THREADS MAXTHREADS
+#endif
+
+/* half-open range [first, last) of long integers with random access
+   iterators, so that the parallel algorithms can split it            */
+class prk_range {
+public:
+  class iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef long                            value_type;
+    typedef long                            difference_type;
+    typedef const long *                    pointer;
+    typedef long                            reference;
+
+    iterator() : i(0) {}
+    explicit iterator(long i) : i(i) {}
+
+    long       operator*() const               { return i; }
+    long       operator[](long n) const        { return i+n; }
+    iterator & operator++()                    { ++i; return *this; }
+    iterator   operator++(int)                 { return iterator(i++); }
+    iterator & operator--()                    { --i; return *this; }
+    iterator   operator--(int)                 { return iterator(i--); }
+    iterator & operator+=(long n)              { i += n; return *this; }
+    iterator & operator-=(long n)              { i -= n; return *this; }
+    iterator   operator+(long n) const         { return iterator(i+n); }
+    iterator   operator-(long n) const         { return iterator(i-n); }
+    long       operator-(const iterator & o) const { return i-o.i; }
+    friend iterator operator+(long n, const iterator & it) { return iterator(it.i+n); }
+
+    bool operator==(const iterator & o) const { return i == o.i; }
+    bool operator!=(const iterator & o) const { return i != o.i; }
+    bool operator< (const iterator & o) const { return i <  o.i; }
+    bool operator> (const iterator & o) const { return i >  o.i; }
+    bool operator<=(const iterator & o) const { return i <= o.i; }
+    bool operator>=(const iterator & o) const { return i >= o.i; }
+
+  private:
+    long i;
+  };
+
+  prk_range(long first, long last) : first(first), last(last) {}
+  iterator begin() const { return iterator(first); }
+  iterator end()   const { return iterator(last); }
+
+private:
+  long first, last;
+};
+
+/* caps the threads of the parallel backend while the object lives     */
+class prk_pstl_threads {
+public:
+#ifdef PRK_PSTL_HAVE_TBB_CONTROL
+  explicit prk_pstl_threads(int n)
+    : control(tbb::global_control::max_allowed_parallelism, n) {}
+  bool honored() const { return true; }
+private:
+  tbb::global_control control;
+#else
+  explicit prk_pstl_threads(int) {}
+  bool honored() const { return false; }
+#endif
+};
+
+/* printed by the kernels next to the requested number of threads      */
+#ifdef PRK_PSTL_HAVE_TBB_CONTROL
+#define PRK_PSTL_BACKEND "TBB"
+#else
+#define PRK_PSTL_BACKEND "compiler default"
+#endif
+
+#endif /* PRK_PSTL_H */
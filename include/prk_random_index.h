@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its
+      contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*******************************************************************
+
+NAME:    prk_random_index
+
+PURPOSE: Mapping of the random numbers of the Random Access kernels to
+         table indices, for tables whose size is not a power of two and
+         for skewed access patterns.
+
+USAGE:   prk_index_t ix;
+         const char *msg = prk_index_init(&ix, tablesize);
+         if (msg) printf("ERROR: %s\n", msg);
+         ...
+         Table[prk_index(&ix, ran)] ^= ran;
+         ...
+         printf("Index distribution     = %s\n", prk_index_describe(&ix, buf, len));
+
+         PRK_TABLESIZE=n, read by the kernels, replaces the power-of-two
+         table size.  The index of a uniform update into a table of
+         power-of-two size is ran&(size-1) as before; for other sizes
+         it is the multiply-shift reduction ((ran mod 2^32)*size)>>32,
+         which needs no division and is uniform to within one part in
+         2^32/size, so sizes are limited to 2^32.
+
+         PRK_DISTRIBUTION selects the distribution of the indices:
+
+           uniform            every entry equally likely (the default)
+           hotset:<f>,<p>     a fraction p of the updates go to the first
+                              f*size entries, the others are uniform over
+                              the whole table
+           zipf:<theta>       entry i (from 0) is drawn with probability
+                              proportional to 1/(i+1)^theta, 0<theta<1,
+                              with the generator of Gray et al. that
+                              YCSB uses; 0.99 is YCSB's default
+
+         The hot entries are the lowest indices, so they share cache
+         lines and, in the distributed kernels, live on the first rank.
+         The hot set decision takes the upper 32 bits of ran and the
+         Zipf draw its upper 53 bits.  Every index is a function of ran
+         only, so applying the same updates twice still restores the
+         table exactly, whatever the distribution.
+
+NOTES:   The Zipf normalization zeta(size,theta) is summed exactly for
+         the first 2^20 terms and with the midpoint rule beyond, which
+         only shifts the probabilities by a negligible amount.  The
+         header must be included after par-res-kern_general.h, which
+         defines u64Int and s64Int.
+
+HISTORY: - Written in October 2026.
+
+*******************************************************************/
+
+#ifndef PRK_RANDOM_INDEX_H
+#define PRK_RANDOM_INDEX_H
+
+enum { PRK_INDEX_UNIFORM, PRK_INDEX_HOTSET, PRK_INDEX_ZIPF };
+
+/* terms of the Zipf normalization that are summed exactly                */
+#define PRK_ZETA_TERMS (1<<20)
+
+typedef struct {
+  int    dist;      /* PRK_INDEX_UNIFORM, _HOTSET or _ZIPF                 */
+  s64Int size;      /* number of table entries                            */
+  u64Int mask;      /* size-1 for uniform power-of-two tables, else 0     */
+  s64Int hotsize;   /* entries in the hot set                             */
+  u64Int hotcut;    /* upper 32 bits of ran below which the update is hot */
+  double frac,prob; /* hot set fraction of the table and of the updates   */
+  double theta;     /* Zipf exponent, and the constants of the generator  */
+  double alpha, zetan, eta, half;
+} prk_index_t;
+
+/* (x mod 2^32)*n/2^32, a uniform index in [0,n) for n <= 2^32           */
+static inline s64Int prk_index_reduce(u64Int x, s64Int n)
+{
+    return (s64Int) (((x & 0xFFFFFFFFULL) * (u64Int) n) >> 32);
+}
+
+static inline s64Int prk_index_zipf(const prk_index_t * ix, u64Int ran)
+{
+    double u  = (double) (ran >> 11) * (1.0/9007199254740992.0);
+    double uz = u * ix->zetan;
+    s64Int i;
+
+    if (uz < 1.0)               return 0;
+    if (uz < 1.0 + ix->half)    return MIN(1, ix->size-1);
+    i = (s64Int) ((double) ix->size * pow(ix->eta*u - ix->eta + 1.0, ix->alpha));
+    return MIN(i, ix->size-1);
+}
+
+/* table index of random number ran                                       */
+static inline s64Int prk_index(const prk_index_t * ix, u64Int ran)
+{
+    if (ix->mask) return (s64Int) (ran & ix->mask);
+    switch (ix->dist) {
+      case PRK_INDEX_HOTSET:
+        return prk_index_reduce(ran, (ran >> 32) < ix->hotcut ? ix->hotsize : ix->size);
+      case PRK_INDEX_ZIPF:
+        return prk_index_zipf(ix, ran);
+      default:
+        return prk_index_reduce(ran, ix->size);
+    }
+}
+
+/* sets up ix for a table of size entries and the distribution given by
+   PRK_DISTRIBUTION; returns NULL, or a message if either is invalid      */
+static inline const char * prk_index_init(prk_index_t * ix, s64Int size)
+{
+    char   *env = getenv("PRK_DISTRIBUTION");
+    s64Int i;
+
+    ix->dist  = PRK_INDEX_UNIFORM;
+    ix->size  = size;
+    ix->mask  = 0;
+    ix->frac  = ix->prob  = 0.0;
+    ix->theta = ix->alpha = ix->zetan = ix->eta = ix->half = 0.0;
+    ix->hotsize = size;
+    ix->hotcut  = 0;
+
+    if (env != NULL && *env != '\0' && strcmp(env, "uniform")) {
+      if (sscanf(env, "hotset:%lf,%lf", &ix->frac, &ix->prob) == 2) {
+        if (ix->frac <= 0.0 || ix->frac > 1.0 || ix->prob < 0.0 || ix->prob > 1.0)
+          return "PRK_DISTRIBUTION=hotset:<f>,<p> needs 0<f<=1 and 0<=p<=1";
+        ix->dist    = PRK_INDEX_HOTSET;
+        ix->hotsize = MAX(1, (s64Int) (ix->frac*size));
+        ix->hotcut  = (u64Int) (ix->prob*4294967296.0);
+      }
+      else if (sscanf(env, "zipf:%lf", &ix->theta) == 1) {
+        if (ix->theta <= 0.0 || ix->theta >= 1.0)
+          return "PRK_DISTRIBUTION=zipf:<theta> needs 0<theta<1";
+        ix->dist = PRK_INDEX_ZIPF;
+      }
+      else return "PRK_DISTRIBUTION must be uniform, hotset:<f>,<p> or zipf:<theta>";
+    }
+
+    if (size < 1) return "the table size must be positive";
+    if (ix->dist == PRK_INDEX_UNIFORM && !(size & (size-1))) {
+      ix->mask = (u64Int) (size-1);
+      return NULL;
+    }
+    if (size > 4294967296LL)
+      return "tables of more than 2^32 entries need a power-of-two size and uniform indices";
+
+    if (ix->dist == PRK_INDEX_ZIPF) {
+      for (i=1; i<=MIN(size, PRK_ZETA_TERMS); i++) ix->zetan += pow((double) i, -ix->theta);
+      if (size > PRK_ZETA_TERMS)
+        ix->zetan += (pow(size+0.5, 1.0-ix->theta) - pow(PRK_ZETA_TERMS+0.5, 1.0-ix->theta))/
+                     (1.0-ix->theta);
+      ix->alpha = 1.0/(1.0-ix->theta);
+      ix->half  = pow(0.5, ix->theta);
+      ix->eta   = size < 2 ? 0.0 : (1.0 - pow(2.0/size, 1.0-ix->theta))/
+                                   (1.0 - (1.0+ix->half)/ix->zetan);
+    }
+    return NULL;
+}
+
+/* short description of the distribution, for the output                  */
+static inline const char * prk_index_describe(const prk_index_t * ix, char * buf, size_t len)
+{
+    switch (ix->dist) {
+      case PRK_INDEX_HOTSET:
+        snprintf(buf, len, "hot set, %g of the updates to %g of the table", ix->prob, ix->frac);
+        break;
+      case PRK_INDEX_ZIPF:
+        snprintf(buf, len, "Zipf, theta %g", ix->theta);
+        break;
+      default:
+        snprintf(buf, len, "uniform%s", ix->mask ? "" : ", multiply-shift reduction");
+    }
+    return buf;
+}
+
+#endif /* PRK_RANDOM_INDEX_H */
@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_random_simd
+
+PURPOSE: Batched table updates for the Random Access kernels, with
+         software prefetching and, where the CPU supports it, AVX-512
+         gather and scatter with conflict detection, selected at startup
+         from the features of the CPU.
+
+USAGE:   prk_random_update_t update = prk_random_simd();
+         update(Table, tablesize, ran, n, distance);
+         printf("Update kernel          = %s\n", prk_random_simd_isa());
+
+         An update kernel performs Table[ran[k]&(tablesize-1)] ^= ran[k]
+         for 0 <= k < n, where tablesize is a power of two.  While it
+         updates entry k it prefetches the table entry of update
+         k+distance for writing, so that up to distance misses are in
+         flight instead of one; distance 0 disables the prefetches.
+
+         The AVX-512 kernel (which needs AVX512F and AVX512CD) loads eight
+         updates at a time, gathers the table entries, applies the XORs
+         and scatters them back.  If two of the eight updates hit the
+         same entry (vpconflictq) the eight are done one at a time, so
+         that no update is lost.  The plain C kernel is used otherwise,
+         or when PRK_SIMD=scalar is set.
+
+         PRK_SIMD=avx512|scalar restricts the choice to the named path,
+         if the CPU supports it.  The header must be included after
+         par-res-kern_general.h, which defines u64Int and s64Int.
+
+*******************************************************************/
+
+#ifndef PRK_RANDOM_SIMD_H
+#define PRK_RANDOM_SIMD_H
+
+typedef void (*prk_random_update_t)(u64Int *, s64Int, const u64Int *, s64Int, int);
+
+extern const char *        prk_random_simd_isa(void);
+extern prk_random_update_t prk_random_simd(void);
+
+#endif
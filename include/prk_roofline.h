@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_roofline
+
+PURPOSE: Machine balance probe used to place kernel results on a
+         roofline.  prk_roofline_probe() measures the sustainable memory
+         bandwidth with the Nstream triad and the peak floating point
+         rate with a register-blocked DGEMM microkernel, using all
+         OpenMP threads of the calling process.
+
+USAGE:   Kernels describe their work per timed iteration with
+         prk_harness_model() (see prk_harness.h); the harness calls the
+         probe when the run is started with
+
+           PRK_ROOFLINE=1               measure bandwidth and peak rate
+           PRK_ROOFLINE_BANDWIDTH=<GB/s> use this bandwidth instead
+           PRK_ROOFLINE_PEAK=<GFlop/s>  use this peak rate instead
+           PRK_ROOFLINE_LENGTH=<n>      vector length of the bandwidth
+                                        probe (default 4194304, i.e.
+                                        96 MB in three arrays)
+
+         The overrides are per process; in MPI and SHMEM builds the
+         probe runs on all ranks or PEs at the same time and the harness
+         sums the results.
+
+*******************************************************************/
+
+#ifndef PRK_ROOFLINE_H
+#define PRK_ROOFLINE_H
+
+extern int  prk_roofline_enabled(void);
+extern void prk_roofline_probe(double *, double *);
+
+#endif
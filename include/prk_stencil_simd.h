@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_stencil_simd
+
+PURPOSE: Hand-vectorized row kernels for the Stencil kernels, one per
+         instruction set, selected at startup from the features of the
+         CPU.
+
+USAGE:   prk_stencil_row_double_t row = prk_stencil_simd_double(star);
+         if (row) for (j=radius; j<n-radius; j++)
+                    row(n, j, radius, weight, in, out);
+         printf("SIMD micro-kernel    = %s\n", prk_stencil_simd_isa());
+
+         A row kernel applies the star (star != 0) or compact stencil of
+         the given radius to the interior points of row j of an n x n
+         grid, adding the result to out; weight holds the (2*radius+1)^2
+         weights with WEIGHT(ii,jj) = weight[(ii+radius)*(2*radius+1)+
+         jj+radius], as in the Stencil kernels.  The selectors return
+         NULL when no vector path is available or PRK_SIMD=scalar is
+         set, in which case the kernels use their own loops.
+
+         prk_stencil_simd_mixed and prk_stencil_simd_half return kernels
+         for grids stored in single and (where the compiler provides
+         _Float16) half precision, whose weights and sums are in double
+         precision; they are only available on x86.
+
+         PRK_SIMD=avx512|avx2|sve|scalar restricts the choice to the
+         named path, if the CPU and the compiler support it.
+
+         The kernels keep four output vectors in registers for the whole
+         stencil footprint and read the neighbors with unaligned loads,
+         which the compiler-generated code for the compact shape does
+         not.  Points are summed in the same order as in the scalar
+         loops, but with fused multiply-adds, so results agree to
+         rounding.
+
+*******************************************************************/
+
+#ifndef PRK_STENCIL_SIMD_H
+#define PRK_STENCIL_SIMD_H
+
+typedef void (*prk_stencil_row_double_t)(long, long, int, const double *,
+                                         const double *, double *);
+typedef void (*prk_stencil_row_float_t)(long, long, int, const float *,
+                                        const float *, float *);
+
+extern const char *             prk_stencil_simd_isa(void);
+extern prk_stencil_row_double_t prk_stencil_simd_double(int);
+extern prk_stencil_row_float_t  prk_stencil_simd_float(int);
+
+typedef void (*prk_stencil_row_mixed_t)(long, long, int, const double *,
+                                        const float *, float *);
+extern prk_stencil_row_mixed_t  prk_stencil_simd_mixed(int);
+#ifdef __FLT16_MAX__
+typedef void (*prk_stencil_row_half_t)(long, long, int, const double *,
+                                       const _Float16 *, _Float16 *);
+extern prk_stencil_row_half_t   prk_stencil_simd_half(int);
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_sweep
+
+PURPOSE: Strong and weak scaling sweeps over thread counts inside one
+         process, so that a scaling study does not need one launch per
+         configuration and arrays are allocated only once.
+
+USAGE:   Kernels supporting sweeps treat their "# threads" argument as
+         the largest thread count when PRK_SWEEP is set:
+
+           PRK_SWEEP=1,2,4,8       explicit list of thread counts
+           PRK_SWEEP=pow2          1, 2, 4, ... up to "# threads", plus
+                                   "# threads" itself
+           PRK_SWEEP_MODE=strong   fixed problem size (default)
+           PRK_SWEEP_MODE=weak     work grows in proportion to the number
+                                   of threads (prk_sweep_scale())
+
+         For every configuration the kernel calls prk_sweep_discard() on
+         its arrays, initializes them with the new team (so that pages
+         are first touched by the threads that use them), runs the timed
+         iterations and calls prk_sweep_record().  prk_sweep_report()
+         prints one table with speedup and parallel efficiency, both
+         relative to the first configuration and based on rates, so that
+         they are meaningful for weak scaling as well.
+
+         Kernels without sweeps call prk_sweep_unsupported() with their
+         name, which stops the run with an error if PRK_SWEEP is set.
+
+*******************************************************************/
+
+#ifndef PRK_SWEEP_H
+#define PRK_SWEEP_H
+
+#include <stddef.h>
+
+#define PRK_SWEEP_MAX 64
+
+typedef struct {
+  int    count;                   /* number of configurations              */
+  int    weak;                    /* nonzero for weak scaling              */
+  int    threads[PRK_SWEEP_MAX];  /* thread count of each configuration    */
+  double size[PRK_SWEEP_MAX];     /* problem size of each configuration    */
+  double time[PRK_SWEEP_MAX];     /* average time per iteration            */
+  double rate[PRK_SWEEP_MAX];     /* rate, in units given to the report    */
+  int    valid[PRK_SWEEP_MAX];    /* nonzero if the configuration validated*/
+} prk_sweep_t;
+
+extern int    prk_sweep_init(prk_sweep_t *, int);
+extern double prk_sweep_scale(const prk_sweep_t *, int);
+extern void   prk_sweep_discard(void *, size_t);
+extern void   prk_sweep_record(prk_sweep_t *, int, double, double, double, int);
+extern void   prk_sweep_report(const prk_sweep_t *, const char *, const char *, const char *);
+extern void   prk_sweep_unsupported(const char *);
+
+#endif
@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+
+/*******************************************************************
+
+NAME:    prk_tbb
+
+PURPOSE: Support for the oneTBB (TBB) kernels: a task arena with the
+         requested number of threads, and the choice of the partitioner
+         that splits the iteration space of tbb::parallel_for.
+
+USAGE:   prk_tbb_arena arena(nthread_input);
+         prk_tbb_partitioner part(prk_tbb_partitioner_from_env());
+         arena.execute([&]{
+           part.parallel_for(tbb::blocked_range2d<long>(0,n,bs,0,n,bs),
+                             [&](const tbb::blocked_range2d<long> & r) { ... });
+         });
+
+         PRK_PARTITIONER=auto|simple|static|affinity selects the
+         partitioner; the default is affinity.  static splits the range
+         evenly among the threads ahead of time, like schedule(static)
+         in OpenMP, and leaves nothing to steal; auto and simple split
+         on demand, simple down to the grain size and auto only as far
+         as stealing requires; affinity splits like auto but replays
+         the assignment of the previous call, so a thread touches the
+         same blocks every iteration.  The partitioner object lives as
+         long as the kernel, which affinity needs to remember the
+         assignment; use one per loop.
+
+NOTES:   The arena may have more threads than the node has cores, so
+         that the effect of oversubscription can be measured; the
+         global limit on the number of TBB threads is raised to match.
+
+*******************************************************************/
+
+#ifndef PRK_TBB_H
+#define PRK_TBB_H
+
+#include <cstdlib>
+#include <cstring>
+
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+
+/* largest number of threads accepted on the command line, as for OpenMP */
+#ifndef MAXTHREADS
+  #define MAX_THREADS 512
+#else
+  #define MAX_THREADS MAXTHREADS
+#endif
+
+enum prk_tbb_partitioner_kind {
+  PRK_TBB_AUTO, PRK_TBB_SIMPLE, PRK_TBB_STATIC, PRK_TBB_AFFINITY, PRK_TBB_UNKNOWN
+};
+
+static const char * prk_tbb_partitioner_name[] = {
+  "auto", "simple", "static", "affinity", "unknown"
+};
+
+/* the partitioner named by PRK_PARTITIONER, PRK_TBB_UNKNOWN if it is not valid */
+static prk_tbb_partitioner_kind prk_tbb_partitioner_from_env(void) {
+  const char * s = getenv("PRK_PARTITIONER");
+  if (!s || !*s || !strcmp(s,"affinity")) return PRK_TBB_AFFINITY;
+  if (!strcmp(s,"auto"))                  return PRK_TBB_AUTO;
+  if (!strcmp(s,"simple"))                return PRK_TBB_SIMPLE;
+  if (!strcmp(s,"static"))                return PRK_TBB_STATIC;
+  return PRK_TBB_UNKNOWN;
+}
+
+/* a parallel loop with the chosen partitioner                         */
+class prk_tbb_partitioner {
+public:
+  explicit prk_tbb_partitioner(prk_tbb_partitioner_kind kind) : kind(kind) {}
+  const char * name() const { return prk_tbb_partitioner_name[kind]; }
+
+  template <typename Range, typename Body>
+  void parallel_for(const Range & range, const Body & body) {
+    switch (kind) {
+      case PRK_TBB_SIMPLE: tbb::parallel_for(range, body, tbb::simple_partitioner()); break;
+      case PRK_TBB_STATIC: tbb::parallel_for(range, body, tbb::static_partitioner()); break;
+      case PRK_TBB_AFFINITY: tbb::parallel_for(range, body, affinity); break;
+      default:             tbb::parallel_for(range, body, tbb::auto_partitioner()); break;
+    }
+  }
+
+private:
+  prk_tbb_partitioner_kind kind;
+  tbb::affinity_partitioner affinity;
+};
+
+/* task arena of exactly nthread threads, the calling thread included  */
+class prk_tbb_arena {
+public:
+  explicit prk_tbb_arena(int nthread)
+    : limit(tbb::global_control::max_allowed_parallelism, nthread),
+      arena(nthread) {}
+
+  template <typename F> void execute(const F & f) { arena.execute(f); }
+  int concurrency() { return arena.max_concurrency(); }
+
+private:
+  tbb::global_control limit;
+  tbb::task_arena     arena;
+};
+
+#endif /* PRK_TBB_H */
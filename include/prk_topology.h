@@ -0,0 +1,78 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_topology
+
+PURPOSE: Optional pinning of MPI ranks and OpenMP threads to cores, and
+         a report of where each of them ended up, so that scaling runs
+         do not depend on the placement chosen by the launcher.
+
+USAGE:   Kernels call prk_topology_bind() once, after MPI_Init and
+         omp_set_num_threads, and before allocating their arrays (so
+         that first-touch placement follows the binding).  In MPI
+         builds the call is collective.  The behavior is selected at
+         run time:
+
+           PRK_BIND=compact    ranks of a node get consecutive blocks of
+                               cores, threads consecutive cores within
+           PRK_BIND=scatter    ranks and threads are spread round-robin
+                               over the sockets of the node
+           PRK_BIND=socket     ranks are assigned round-robin to sockets,
+                               threads are packed onto the cores of the
+                               rank's socket
+           PRK_TOPOLOGY=1      print host, core, socket, NUMA node and
+                               nearby GPUs for every rank and thread
+
+         prk_topology_socket() returns the socket on which the calling
+         thread runs (-1 if unknown); it is only stable for bound threads.
+         prk_topology_host() returns the name of the node the caller
+         runs on, as printed by print_topology(), e.g. to label ranks.
+
+         Pinning requires hwloc; build with HWLOCTOP set in make.defs.
+         Without hwloc only the report is available, and it shows the
+         logical CPU on which each thread is running.
+
+*******************************************************************/
+
+#ifndef PRK_TOPOLOGY_H
+#define PRK_TOPOLOGY_H
+
+#include <stdio.h>
+
+extern void print_topology(FILE *, int);
+extern void prk_topology_bind(void);
+extern void prk_topology_report(FILE *);
+extern int  prk_topology_socket(void);
+extern void prk_topology_host(char *, int);
+
+#endif
@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2026, Parallel Research Kernels contributors
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+
+/*******************************************************************
+
+NAME:    prk_transpose_simd
+
+PURPOSE: Hand-vectorized tile kernels for the Transpose kernels, which
+         transpose square blocks of vectors in registers, selected at
+         startup from the features of the CPU.
+
+USAGE:   prk_transpose_tile_t tile =
+           prk_transpose_simd(prk_transpose_streaming(bytes));
+         if (tile) tile(order, i0, i1, j0, j1, A, B);
+         printf("SIMD micro-kernel     = %s\n", prk_transpose_simd_isa());
+
+         A tile kernel performs B(j,i) += A(i,j) and A(i,j) += 1.0 for
+         i0 <= i < i1 and j0 <= j < j1 of the column-major order x order
+         matrices A and B, as the Transpose kernels do.  It loads
+         VLEN x VLEN blocks of A (4 x 4 for AVX2, 8 x 8 for AVX-512) as
+         VLEN columns, transposes them with unpack and shuffle
+         instructions, and adds the resulting rows to VLEN columns of B;
+         points at the edges of the block are done one at a time.  The
+         selector returns NULL when no vector path is available or
+         PRK_SIMD=scalar is set, in which case the kernels use their own
+         loops.
+
+         With streaming != 0 the kernel writes B with non-temporal
+         stores wherever they are aligned, so that B does not displace A
+         from the cache; it ends with a store fence.
+         prk_transpose_streaming(bytes) implements the PRK_NT_STORES
+         policy: 1 streams, 0 (the default) does not, auto streams when
+         the matrices, together bytes long, exceed the last-level cache.
+         Since B is also read, its lines are in the cache when they are
+         written, and whether streaming pays off depends on the CPU.
+
+         PRK_SIMD=avx512|avx2|scalar restricts the choice to the named
+         path, if the CPU supports it.
+
+*******************************************************************/
+
+#ifndef PRK_TRANSPOSE_SIMD_H
+#define PRK_TRANSPOSE_SIMD_H
+
+#include <stddef.h>
+
+typedef void (*prk_transpose_tile_t)(size_t, size_t, size_t, size_t, size_t,
+                                     double *, double *);
+
+extern const char *         prk_transpose_simd_isa(void);
+extern prk_transpose_tile_t prk_transpose_simd(int);
+extern int                  prk_transpose_streaming(double);
+
+#endif
@@ -43,4 +43,18 @@ extern void     LCG_get_chunk(uint64_t *, uint64_t *, int, int, uint64_t);
 extern void     LCG_jump(uint64_t, uint64_t);
 extern uint64_t random_draw(double);
 
+/* counter-based generator (Philox4x32-10); unlike the LCG it keeps its
+   state in an explicit object, and jumps ahead in constant time            */
+typedef struct {
+  uint32_t key[2];       /* derived from the seed                          */
+  uint64_t word;         /* index of the next 64-bit word of the stream    */
+} philox_t;
+
+extern void     philox_init(philox_t *, uint64_t);
+extern void     philox_jump(philox_t *, uint64_t);
+extern uint64_t philox_next(philox_t *, uint64_t);
+extern void     philox_fill(philox_t *, uint64_t, uint64_t *);
+extern uint64_t random_draw_philox(philox_t *, double);
+extern void     random_draw_vector(philox_t *, double, uint64_t, uint64_t *);
+
 #endif